@@ -13,31 +13,380 @@
   limitations under the License.
 
 ******************************************************************************/
+#include <avogadro/io/fileformat.h>
 #include <avogadro/io/fileformatmanager.h>
 #include <avogadro/core/molecule.h>
 #include <avogadro/core/version.h>
 
+#include <avogadro/stl/memory_p.h>
+#include <avogadro/stl/mutex_p.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
 #include <iostream>
+#include <map>
 #include <sstream>
 #include <string>
+#include <vector>
 
+using Avogadro::Io::FileFormat;
 using Avogadro::Io::FileFormatManager;
 using Avogadro::Core::Molecule;
+using std::cerr;
 using std::cin;
 using std::cout;
 using std::endl;
 using std::string;
 using std::ostringstream;
+using std::vector;
 
 void printHelp();
+int runBatch(const vector<string> &files, const string &inFormat,
+             string outFormat, size_t threads);
+
+namespace {
+using Avogadro::Stl::condition_variable;
+using Avogadro::Stl::mutex;
+using Avogadro::Stl::unique_lock;
+
+typedef Avogadro::Stl::chrono::steady_clock Clock;
+
+// Upper bound on the worker threads requested with -j.
+const long maxThreads = 256;
+
+double seconds(Clock::time_point start, Clock::time_point end)
+{
+  return Avogadro::Stl::chrono::duration<double>(end - start).count();
+}
+
+// Throughput counters for one stage of the batch conversion, busy is the time
+// spent working rather than waiting on the other stages.
+struct StageCounters
+{
+  StageCounters() : records(0), failed(0), bytes(0), busy(0.0) {}
+
+  void add(const StageCounters &other)
+  {
+    records += other.records;
+    failed += other.failed;
+    bytes += other.bytes;
+    busy += other.busy;
+  }
+
+  size_t records;
+  size_t failed;
+  size_t bytes;
+  double busy;
+};
+
+// A record on its way through the pipeline, holding the text read from the
+// input and then the converted text to be written.
+struct Record
+{
+  Record() : index(0), sourceRecord(0), ok(false) {}
+
+  size_t index;
+  string format;
+  string source;
+  size_t sourceRecord;
+  string text;
+  bool ok;
+  string error;
+};
+
+/**
+ * Converts the records of several input files into one output file. A reader
+ * thread splits the input files into records without parsing them, a number of
+ * worker threads parse and write the records with their own format instances,
+ * and the calling thread writes them out in the order they were read. The
+ * number of records in flight is bounded, so memory use does not depend on
+ * the size of the input.
+ */
+class BatchConverter
+{
+public:
+  BatchConverter(const vector<string> &inFiles, const string &inFormat,
+                 const string &outFormat, size_t threads)
+    : m_inFiles(inFiles), m_inFormat(inFormat), m_outFormat(outFormat),
+      m_threads(threads), m_capacity(16 * threads), m_readCount(0),
+      m_inFlight(0), m_readingDone(false), m_wallTime(0.0)
+  {
+  }
+
+  /**
+   * Convert all of the input files, writing the records to @p out.
+   * @return True if every record was converted, false otherwise.
+   */
+  bool run(std::ostream &out);
+
+  /** Print the throughput of each stage to @p out. */
+  void printCounters(std::ostream &out) const;
+
+private:
+  struct ReaderTask
+  {
+    explicit ReaderTask(BatchConverter *c) : converter(c) {}
+    void operator()() { converter->read(); }
+    BatchConverter *converter;
+  };
+
+  struct WorkerTask
+  {
+    explicit WorkerTask(BatchConverter *c) : converter(c) {}
+    void operator()() { converter->work(); }
+    BatchConverter *converter;
+  };
+
+  void read();
+  void work();
+  void queue(Record *record);
+  FileFormat * openInput(const string &fileName, string &contents) const;
+
+  vector<string> m_inFiles;
+  string m_inFormat;
+  string m_outFormat;
+  size_t m_threads;
+  size_t m_capacity;
+
+  // Shared between the stages, guarded by m_mutex.
+  mutex m_mutex;
+  condition_variable m_taskReady;
+  condition_variable m_resultReady;
+  condition_variable m_slotFree;
+  std::deque<Record *> m_tasks;
+  std::map<size_t, Record *> m_results;
+  size_t m_readCount;
+  size_t m_inFlight;
+  bool m_readingDone;
+
+  StageCounters m_read;
+  StageCounters m_converted;
+  StageCounters m_written;
+  double m_wallTime;
+};
+
+bool BatchConverter::run(std::ostream &out)
+{
+  Clock::time_point start = Clock::now();
+
+  vector<Avogadro::Stl::thread *> threads;
+  threads.push_back(new Avogadro::Stl::thread(ReaderTask(this)));
+  for (size_t i = 0; i < m_threads; ++i)
+    threads.push_back(new Avogadro::Stl::thread(WorkerTask(this)));
+
+  // Write the records out in order as they are converted.
+  bool ok = true;
+  for (size_t next = 0; ; ++next) {
+    Record *record = NULL;
+    {
+      unique_lock guard(m_mutex);
+      std::map<size_t, Record *>::iterator it;
+      while ((it = m_results.find(next)) == m_results.end()
+             && !(m_readingDone && next == m_readCount)) {
+        m_resultReady.wait(guard);
+      }
+      if (it == m_results.end())
+        break;
+      record = it->second;
+      m_results.erase(it);
+    }
+
+    Clock::time_point writeStart = Clock::now();
+    if (record->ok) {
+      out << record->text;
+      ++m_written.records;
+      m_written.bytes += record->text.size();
+    }
+    else {
+      cerr << "Failed to convert record " << record->sourceRecord + 1
+           << " of " << record->source << ": " << record->error << endl;
+      ++m_written.failed;
+      ok = false;
+    }
+    delete record;
+    m_written.busy += seconds(writeStart, Clock::now());
+
+    unique_lock guard(m_mutex);
+    --m_inFlight;
+    m_slotFree.notify_one();
+  }
+
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i]->join();
+    delete threads[i];
+  }
+  out.flush();
+  m_wallTime = seconds(start, Clock::now());
+  return ok && m_read.failed == 0 && out.good();
+}
+
+void BatchConverter::printCounters(std::ostream &out) const
+{
+  out << "Read      " << m_read.records << " records, " << m_read.bytes
+      << " bytes in " << m_read.busy << " s ("
+      << m_read.records / std::max(m_read.busy, 1e-9) << " records/s)\n"
+      << "Converted " << m_converted.records << " records in "
+      << m_converted.busy << " s on " << m_threads << " threads ("
+      << m_converted.records / std::max(m_converted.busy, 1e-9)
+      << " records/s per thread)\n"
+      << "Wrote     " << m_written.records << " records, " << m_written.bytes
+      << " bytes in " << m_written.busy << " s ("
+      << m_written.records / std::max(m_written.busy, 1e-9)
+      << " records/s)\n"
+      << "Total     " << m_written.records << " records in " << m_wallTime
+      << " s (" << m_written.records / std::max(m_wallTime, 1e-9)
+      << " records/s)" << endl;
+}
+
+FileFormat * BatchConverter::openInput(const string &fileName,
+                                       string &contents) const
+{
+  FileFormatManager &mgr = FileFormatManager::instance();
+  FileFormat *format = mgr.openFile(fileName, FileFormat::Read
+                                    | FileFormat::MultiMolecule, m_inFormat);
+  if (format)
+    return format;
+
+  // Formats without multiple records are read as a single record.
+  string extension(m_inFormat);
+  if (extension.empty())
+    extension = fileName.substr(fileName.find_last_of('.') + 1);
+  format = mgr.newFormatFromFileExtension(extension, FileFormat::Read
+                                          | FileFormat::String);
+  std::ifstream file(fileName.c_str(), std::ifstream::binary);
+  if (!format || !file.is_open()) {
+    delete format;
+    return NULL;
+  }
+  ostringstream stream;
+  stream << file.rdbuf();
+  contents = stream.str();
+  return format;
+}
+
+void BatchConverter::read()
+{
+  for (size_t i = 0; i < m_inFiles.size(); ++i) {
+    Clock::time_point start = Clock::now();
+    string contents;
+    AVO_UNIQUE_PTR<FileFormat> format(openInput(m_inFiles[i], contents));
+    if (!format) {
+      cerr << "Failed to open " << m_inFiles[i] << " (" << m_inFormat << ")"
+           << endl;
+      ++m_read.failed;
+      continue;
+    }
+    bool streaming = format->isMode(FileFormat::Read);
+    for (size_t sourceRecord = 0; ; ++sourceRecord) {
+      Record *record = new Record;
+      if (streaming && !format->readRecord(record->text)) {
+        delete record;
+        break;
+      }
+      else if (!streaming) {
+        if (sourceRecord > 0) {
+          delete record;
+          break;
+        }
+        record->text.swap(contents);
+      }
+      record->format = format->identifier();
+      record->source = m_inFiles[i];
+      record->sourceRecord = sourceRecord;
+      ++m_read.records;
+      m_read.bytes += record->text.size();
+      m_read.busy += seconds(start, Clock::now());
+      queue(record);
+      start = Clock::now();
+    }
+    if (!format->error().empty()) {
+      cerr << "Failed to read " << m_inFiles[i] << ": " << format->error()
+           << endl;
+      ++m_read.failed;
+    }
+    m_read.busy += seconds(start, Clock::now());
+  }
+
+  unique_lock guard(m_mutex);
+  m_readingDone = true;
+  m_taskReady.notify_all();
+  m_resultReady.notify_all();
+}
+
+void BatchConverter::queue(Record *record)
+{
+  unique_lock guard(m_mutex);
+  while (m_inFlight >= m_capacity)
+    m_slotFree.wait(guard);
+  record->index = m_readCount++;
+  ++m_inFlight;
+  m_tasks.push_back(record);
+  m_taskReady.notify_one();
+}
+
+void BatchConverter::work()
+{
+  // Each thread works with its own format instances.
+  FileFormatManager &mgr = FileFormatManager::instance();
+  AVO_UNIQUE_PTR<FileFormat> writer(
+        mgr.newFormatFromIdentifier(m_outFormat));
+  writer->setMode(FileFormat::Write | FileFormat::MultiMolecule);
+  std::map<string, FileFormat *> readers;
+  StageCounters counters;
+
+  for (;;) {
+    Record *record = NULL;
+    {
+      unique_lock guard(m_mutex);
+      while (m_tasks.empty() && !m_readingDone)
+        m_taskReady.wait(guard);
+      if (m_tasks.empty())
+        break;
+      record = m_tasks.front();
+      m_tasks.pop_front();
+    }
+
+    Clock::time_point start = Clock::now();
+    FileFormat *&reader = readers[record->format];
+    if (!reader)
+      reader = mgr.newFormatFromIdentifier(record->format);
+    Molecule molecule;
+    string input;
+    input.swap(record->text);
+    record->ok = reader->readString(input, molecule)
+        && writer->writeString(record->text, molecule);
+    if (!record->ok) {
+      record->error = reader->error() + writer->error();
+      reader->clear();
+      writer->clear();
+    }
+    ++counters.records;
+    counters.busy += seconds(start, Clock::now());
+
+    unique_lock guard(m_mutex);
+    m_results[record->index] = record;
+    m_resultReady.notify_one();
+  }
+
+  for (std::map<string, FileFormat *>::iterator it = readers.begin();
+       it != readers.end(); ++it) {
+    delete it->second;
+  }
+  unique_lock guard(m_mutex);
+  m_converted.add(counters);
+}
+}
 
 int main(int argc, char *argv[])
 {
   // Process the command line arguments, see what has been requested.
   string inFormat;
   string outFormat;
-  string inFile;
-  string outFile;
+  vector<string> files;
+  bool batch = false;
+  size_t threads = 0;
   for (int i = 1; i < argc; ++i) {
     string current(argv[i]);
     if (current == "--help" || current == "-h") {
@@ -50,20 +399,39 @@ int main(int argc, char *argv[])
     }
     else if (current == "-i" && i + 1 < argc) {
       inFormat = argv[++i];
-      cout << "input format " << inFormat << endl;
     }
     else if (current == "-o" && i + 1 < argc) {
       outFormat = argv[++i];
-      cout << "output format " << outFormat << endl;
     }
-    else if (inFile.empty()) {
-      inFile = argv[i];
+    else if (current == "--batch") {
+      batch = true;
+    }
+    else if (current == "-j" && i + 1 < argc) {
+      const char *value = argv[++i];
+      char *end = NULL;
+      long count = std::strtol(value, &end, 10);
+      if (end == value || *end != '\0' || count < 1) {
+        cerr << "Invalid thread count " << value
+             << ", expected a positive number." << endl;
+        return 1;
+      }
+      threads = static_cast<size_t>(std::min(count, maxThreads));
     }
-    else if (outFile.empty()) {
-      outFile = argv[i];
+    else {
+      files.push_back(current);
     }
   }
 
+  if (batch)
+    return runBatch(files, inFormat, outFormat, threads);
+
+  if (!inFormat.empty())
+    cout << "input format " << inFormat << endl;
+  if (!outFormat.empty())
+    cout << "output format " << outFormat << endl;
+  string inFile(files.size() > 0 ? files[0] : string());
+  string outFile(files.size() > 1 ? files[1] : string());
+
   // Now read/write the molecule, if possible. Otherwise output errors.
   FileFormatManager &mgr = FileFormatManager::instance();
   Molecule mol;
@@ -106,8 +474,65 @@ int main(int argc, char *argv[])
   return 0;
 }
 
+int runBatch(const vector<string> &files, const string &inFormat,
+             string outFormat, size_t threads)
+{
+  // The last file is the output when there is more than one, otherwise the
+  // records are written to the standard output.
+  vector<string> inFiles(files);
+  string outFile;
+  if (inFiles.size() > 1) {
+    outFile = inFiles.back();
+    inFiles.pop_back();
+  }
+  if (inFiles.empty()) {
+    cerr << "Error, no input files supplied for the batch conversion." << endl;
+    return 1;
+  }
+
+  if (outFormat.empty() && !outFile.empty())
+    outFormat = outFile.substr(outFile.find_last_of('.') + 1);
+  else if (outFormat.empty())
+    outFormat = "cjson";
+  AVO_UNIQUE_PTR<FileFormat> format(
+        FileFormatManager::instance().newFormatFromFileExtension(
+          outFormat, FileFormat::Write | FileFormat::String
+          | FileFormat::MultiMolecule));
+  if (!format) {
+    cerr << "Output format " << outFormat
+         << " does not support writing multiple molecules." << endl;
+    return 1;
+  }
+
+  if (threads == 0)
+    threads = std::max(1u, Avogadro::Stl::thread::hardware_concurrency());
+  BatchConverter converter(inFiles, inFormat, format->identifier(), threads);
+
+  bool ok;
+  if (!outFile.empty()) {
+    std::ofstream out(outFile.c_str(), std::ofstream::binary);
+    if (!out.is_open()) {
+      cerr << "Failed to open " << outFile << " for writing." << endl;
+      return 1;
+    }
+    ok = converter.run(out);
+  }
+  else {
+    ok = converter.run(cout);
+  }
+  converter.printCounters(cerr);
+
+  return ok ? 0 : 1;
+}
+
 void printHelp()
 {
   cout << "Usage: avobabel [-i <input-type>] <infilename> [-o <output-type>] <outfilename>\n"
+       << "       avobabel --batch [-j <threads>] [-i <input-type>] "
+          "[-o <output-type>] <infilename>... [<outfilename>]\n\n"
+       << "In batch mode every record of the input files is converted, using\n"
+       << "one worker thread per core unless -j is given, and written to a\n"
+       << "single output file in order. With only one file name the records\n"
+       << "are written to the standard output.\n"
        << endl;
 }
@@ -27,6 +27,7 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <vector>
 
 using Avogadro::Io::FileFormatManager;
 using Avogadro::Core::Cube;
@@ -154,17 +155,26 @@ int main(int argc, char *argv[])
 
   GaussianSetTools *m_tools = new GaussianSetTools(&mol);
 
+  //calculate the whole qube in one batch, matching the header above
+  bool calculated = orbitalNumber > 0
+      ? m_tools->calculateMolecularOrbital(*m_qube, orbitalNumber)
+      : m_tools->calculateElectronDensity(*m_qube);
+  if (!calculated) {
+    cout << "Error, could not calculate the requested values." << endl;
+    return 1;
+  }
+  const std::vector<double> &values = *m_qube->data();
+
   //print the qube values
   int linecount=0;
-  for(int i=0;i<m_qube->data()->size();i++)
+  for(int i=0;i<static_cast<int>(values.size());i++)
   {
     if(i%points.z()==0 && i>0)
     {
       linecount=0;
       printf("\n");
     }
-    double value = m_tools->calculateMolecularOrbital(
-        m_qube->position(i),orbitalNumber);
+    double value = values[i];
     printf("%13.5E",value);
     //line wrapping
     linecount++;
@@ -22,6 +22,10 @@
 #include <algorithm>
 #include <vector>
 
+#if defined(_MSC_VER)
+# include <intrin.h>
+#endif
+
 namespace Avogadro {
 namespace Core {
 
@@ -29,6 +33,52 @@ using std::size_t;
 
 namespace internal {
 
+/**
+ * Atomic operations on a reference count, so that containers sharing data can
+ * be copied and destroyed in different threads. Incrementing needs no
+ * ordering, as a new reference can only be taken from an existing one.
+ * Decrementing releases any changes made through the reference, and acquires
+ * those made through others, before the last owner destroys the data.
+ * @{
+ */
+#if defined(_MSC_VER)
+typedef long RefCount;
+
+inline void refCountIncrement(volatile RefCount &ref)
+{
+  _InterlockedIncrement(&ref);
+}
+
+inline RefCount refCountDecrement(volatile RefCount &ref)
+{
+  return _InterlockedDecrement(&ref);
+}
+
+inline RefCount refCountLoad(const volatile RefCount &ref)
+{
+  // Volatile reads have acquire semantics with MSVC.
+  return ref;
+}
+#else
+typedef int RefCount;
+
+inline void refCountIncrement(RefCount &ref)
+{
+  __atomic_add_fetch(&ref, 1, __ATOMIC_RELAXED);
+}
+
+inline RefCount refCountDecrement(RefCount &ref)
+{
+  return __atomic_sub_fetch(&ref, 1, __ATOMIC_ACQ_REL);
+}
+
+inline RefCount refCountLoad(const RefCount &ref)
+{
+  return __atomic_load_n(&ref, __ATOMIC_ACQUIRE);
+}
+#endif
+/** @} */
+
 template<typename T>
 class ArrayRefContainer
 {
@@ -73,25 +123,29 @@ public:
   // Increment the reference count.
   void reref()
   {
-    ++m_ref;
+    refCountIncrement(m_ref);
   }
 
   // Decrement the reference count, return true unless the reference count has
   // dropped to zero. When it returns false, this object should be deleted.
   bool deref()
   {
-    if (m_ref)
-      --m_ref;
-    return m_ref > 0;
+    return refCountDecrement(m_ref) > 0;
   }
 
-  unsigned int ref() const
+  // The reference count, only a count of one is stable as no other container
+  // can take a reference then.
+  RefCount ref() const
   {
-    return m_ref;
+    return refCountLoad(m_ref);
   }
 
   // Reference count
-  unsigned int m_ref;
+#if defined(_MSC_VER)
+  volatile RefCount m_ref;
+#else
+  RefCount m_ref;
+#endif
   // Container for our data
   std::vector<T> data;
 };
@@ -110,6 +164,11 @@ public:
  * non-const function will trigger a detach call. This is a no-op when the
  * reference count is 1, and will perform a deep copy when the reference count
  * is greater than 1.
+ *
+ * The reference count is atomic, so arrays sharing data may be copied, read and
+ * destroyed in different threads, and modifying one of them only detaches it
+ * from the others. As with the standard containers, a single Array object
+ * must not be modified in one thread while it is used in another.
  */
 template<typename T>
 class Array
@@ -167,6 +226,54 @@ public:
    */
   void detach();
 
+  /**
+   * @class Span array.h <avogadro/core/array.h>
+   * @brief A mutable view of the contiguous storage of an Array.
+   *
+   * The non-const accessors of Array detach on every call, which costs a
+   * branch per element in tight loops and prevents the compiler from
+   * vectorizing them. A span is created by Array::span(), which detaches once,
+   * and gives plain pointer access to the elements after that.
+   *
+   * The span is only valid as long as the array is neither resized nor
+   * copied, copying the array would share the data being modified through the
+   * span.
+   */
+  class Span
+  {
+  public:
+    typedef T value_type;
+    typedef T* iterator;
+    typedef T* pointer;
+    typedef T& reference;
+
+    Span() : m_data(NULL), m_size(0) {}
+    Span(T *data_, size_t size_) : m_data(data_), m_size(size_) {}
+
+    T* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    iterator begin() const { return m_data; }
+    iterator end() const { return m_data + m_size; }
+
+    reference operator[](size_t idx) const { return m_data[idx]; }
+
+  private:
+    T *m_data;
+    size_t m_size;
+  };
+
+  /**
+   * @brief Detach once and return a mutable view of the elements.
+   * @return A span over the elements, see Span for the rules of its use.
+   */
+  Span span()
+  {
+    detach();
+    return d->data.empty() ? Span() : Span(&d->data[0], d->data.size());
+  }
+
   /** Retrieve a pointer to the underlying data. */
   T* data()
   {
@@ -405,7 +512,9 @@ inline void Array<T>::detach()
 {
   if (d && d->ref() != 1) {
     Container *o = new Container(*d);
-    d->deref();
+    // The other references may have been released since the check.
+    if (!d->deref())
+      delete d;
     d = o;
   }
 }
@@ -192,13 +192,13 @@ Index BondTemplate<Molecule_T>::index() const
 template <class Molecule_T>
 typename BondTemplate<Molecule_T>::AtomType BondTemplate<Molecule_T>::atom1() const
 {
-  return AtomType(m_molecule, m_molecule->bondPairs()[m_index].first);
+  return AtomType(m_molecule, m_molecule->bondPair(m_index).first);
 }
 
 template <class Molecule_T>
 typename BondTemplate<Molecule_T>::AtomType BondTemplate<Molecule_T>::atom2() const
 {
-  return AtomType(m_molecule, m_molecule->bondPairs()[m_index].second);
+  return AtomType(m_molecule, m_molecule->bondPair(m_index).second);
 }
 
 template <class Molecule_T>
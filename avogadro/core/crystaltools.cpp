@@ -47,8 +47,8 @@ bool CrystalTools::wrapAtomsToUnitCell(Molecule &molecule)
   if (!molecule.unitCell())
     return false;
 
-  std::for_each(molecule.atomPositions3d().begin(),
-                molecule.atomPositions3d().end(),
+  Array<Vector3>::Span positions(molecule.atomPositions3d().span());
+  std::for_each(positions.begin(), positions.end(),
                 WrapAtomsToCellFunctor(molecule));
   return true;
 }
@@ -498,10 +498,9 @@ bool CrystalTools::niggliReduce(Molecule &molecule, Options opts)
 
     // fix coordinates with COB matrix:
     const Matrix3 invCob(cob.inverse());
-    for (Array<Vector3>::iterator it = fcoords.begin(),
-         itEnd = fcoords.end(); it != itEnd; ++it) {
+    Array<Vector3>::Span fspan(fcoords.span());
+    for (Vector3 *it = fspan.begin(), *itEnd = fspan.end(); it != itEnd; ++it)
       *it = invCob * (*it);
-    }
 
     // Update cell
     cell.setCellMatrix(cell.cellMatrix() * cob);
@@ -625,8 +624,8 @@ bool CrystalTools::setCellMatrix(Molecule &molecule,
     const Matrix3 xform((newCellColMatrix
                          * molecule.unitCell()->cellMatrix().inverse())
                         .transpose());
-    std::for_each(molecule.atomPositions3d().begin(),
-                  molecule.atomPositions3d().end(),
+    Array<Vector3>::Span positions(molecule.atomPositions3d().span());
+    std::for_each(positions.begin(), positions.end(),
                   TransformAtomsFunctor(xform));
   }
 
@@ -662,7 +661,8 @@ bool CrystalTools::fractionalCoordinates(const UnitCell &unitCell,
   if (&frac != &cart) // avoid self-copy...
     frac = cart;
 
-  std::for_each(frac.begin(), frac.end(),
+  Array<Vector3>::Span fspan(frac.span());
+  std::for_each(fspan.begin(), fspan.end(),
                 FractionalCoordinatesFunctor(unitCell));
 
   return true;
@@ -709,7 +709,7 @@ bool CrystalTools::setFractionalCoordinates(Molecule &molecule,
   Array<Vector3> &output = molecule.atomPositions3d();
   output.resize(coords.size());
 
-  std::transform(coords.begin(), coords.end(), output.begin(),
+  std::transform(coords.begin(), coords.end(), output.span().begin(),
                  SetFractionalCoordinatesFunctor(molecule));
 
   return true;
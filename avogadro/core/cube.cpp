@@ -18,7 +18,7 @@
 #include "cube.h"
 
 #include "molecule.h"
-#include "mutex.h"
+#include "readwritelock.h"
 
 namespace Avogadro {
 namespace Core {
@@ -26,7 +26,7 @@ namespace Core {
 Cube::Cube() : m_data(0),
   m_min(0.0, 0.0, 0.0), m_max(0.0, 0.0, 0.0), m_spacing(0.0, 0.0, 0.0),
   m_points(0, 0, 0), m_minValue(0.0), m_maxValue(0.0),
-  m_lock(new Mutex)
+  m_lock(new ReadWriteLock)
 {
 }
 
@@ -127,6 +127,11 @@ std::vector<double> * Cube::data()
   return &m_data;
 }
 
+const std::vector<double> * Cube::data() const
+{
+  return &m_data;
+}
+
 bool Cube::setData(const std::vector<double> &values)
 {
   if (!values.size())
@@ -134,15 +139,7 @@ bool Cube::setData(const std::vector<double> &values)
 
   if (static_cast<int>(values.size()) == m_points.x() * m_points.y() * m_points.z()) {
     m_data = values;
-    // Now to update the minimum and maximum values
-    m_minValue = m_maxValue = m_data[0];
-    for (std::vector<double>::const_iterator it = values.begin();
-         it != values.end(); ++it) {
-      if (*it < m_minValue)
-        m_minValue = *it;
-      else if (*it > m_maxValue)
-        m_maxValue = *it;
-    }
+    updateMinMax();
     return true;
   }
   else {
@@ -167,6 +164,22 @@ bool Cube::addData(const std::vector<double> &values)
   return true;
 }
 
+void Cube::updateMinMax()
+{
+  if (m_data.empty()) {
+    m_minValue = m_maxValue = 0.0;
+    return;
+  }
+  m_minValue = m_maxValue = m_data[0];
+  for (std::vector<double>::const_iterator it = m_data.begin();
+       it != m_data.end(); ++it) {
+    if (*it < m_minValue)
+      m_minValue = *it;
+    else if (*it > m_maxValue)
+      m_maxValue = *it;
+  }
+}
+
 unsigned int Cube::closestIndex(const Vector3 &pos) const
 {
   int i, j, k;
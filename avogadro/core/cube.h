@@ -28,7 +28,7 @@ namespace Avogadro {
 namespace Core {
 
 class Molecule;
-class Mutex;
+class ReadWriteLock;
 
 /**
  * @class Cube cube.h <avogadro/core/cube.h>
@@ -128,6 +128,7 @@ public:
    * @return Vector containing all the data in a one-dimensional array.
    */
   std::vector<double> * data();
+  const std::vector<double> * data() const;
 
   /**
    * Set the values in the cube to those passed in the vector.
@@ -202,6 +203,13 @@ public:
    */
   bool setValue(unsigned int i, double value);
 
+  /**
+   * Recalculate the minimum and maximum values from the data. This must be
+   * called after the values have been written through data() directly, e.g.
+   * by several threads filling separate parts of the cube.
+   */
+  void updateMinMax();
+
   /**
    * @return The minimum  value at any point in the Cube.
    */
@@ -219,9 +227,10 @@ public:
   Type cubeType() const { return m_cubeType; }
 
   /**
-   * Provides locking.
+   * Provides locking. Take a read lock while using the data, and a write lock
+   * while modifying it, so that several readers can share the Cube.
    */
-  Mutex * lock() const { return m_lock; }
+  ReadWriteLock * lock() const { return m_lock; }
 
 protected:
   std::vector<double> m_data;
@@ -230,7 +239,7 @@ protected:
   double m_minValue, m_maxValue;
   std::string m_name;
   Type    m_cubeType;
-  Mutex *m_lock;
+  ReadWriteLock *m_lock;
 };
 
 inline bool Cube::setValue(unsigned int i, double value_)
@@ -158,6 +158,16 @@ public:
   MatrixX& densityMatrix() { return m_density; }
   MatrixX& spinDensityMatrix() { return m_spinDensity; }
 
+  /** @overload */
+  const std::vector<int>& symmetry() const { return m_symmetry; }
+  const std::vector<unsigned int>& atomIndices() const { return m_atomIndices; }
+  const std::vector<unsigned int>& gtoIndices() const { return m_gtoIndices; }
+  const std::vector<double>& gtoA() const { return m_gtoA; }
+  const std::vector<double>& gtoC() const { return m_gtoC; }
+  const MatrixX& moMatrix() const { return m_moMatrix[0]; }
+  const MatrixX& densityMatrix() const { return m_density; }
+  const MatrixX& spinDensityMatrix() const { return m_spinDensity; }
+
 private:
   /**
    * @brief This group is used once, and refers to the entire molecule.
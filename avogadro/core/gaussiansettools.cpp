@@ -18,9 +18,12 @@
 
 #include "gaussiansettools.h"
 
+#include "cube.h"
 #include "gaussianset.h"
 #include "molecule.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 using std::cout;
@@ -31,10 +34,21 @@ using std::vector;
 namespace Avogadro {
 namespace Core {
 
-GaussianSetTools::GaussianSetTools(Molecule *mol) : m_molecule(mol)
+namespace {
+// The number of points evaluated together by the batch calculations, chosen
+// so that the scratch block of basis function values stays in cache.
+const Index blockSize = 128;
+// Primitive contributions smaller than this are skipped in batch calculations.
+const double cutoffThreshold = 1.0e-12;
+}
+
+GaussianSetTools::GaussianSetTools(Molecule *mol)
+  : m_molecule(mol), m_basis(NULL)
 {
   if (m_molecule)
     m_basis = dynamic_cast<GaussianSet *>(m_molecule->basisSet());
+  if (m_basis)
+    initializeCutoffDistances();
 }
 
 GaussianSetTools::~GaussianSetTools()
@@ -107,6 +121,39 @@ double GaussianSetTools::calculateSpinDensity(const Vector3 &position) const
   return rho;
 }
 
+bool GaussianSetTools::calculateMolecularOrbital(
+    const vector<Vector3> &positions, int mo, vector<double> &values) const
+{
+  return calculateBatch(positions, MolecularOrbitalValue, mo, values);
+}
+
+bool GaussianSetTools::calculateElectronDensity(
+    const vector<Vector3> &positions, vector<double> &values) const
+{
+  return calculateBatch(positions, ElectronDensityValue, 0, values);
+}
+
+bool GaussianSetTools::calculateSpinDensity(const vector<Vector3> &positions,
+                                            vector<double> &values) const
+{
+  return calculateBatch(positions, SpinDensityValue, 0, values);
+}
+
+bool GaussianSetTools::calculateMolecularOrbital(Cube &cube, int mo) const
+{
+  return calculateCube(cube, MolecularOrbitalValue, mo);
+}
+
+bool GaussianSetTools::calculateElectronDensity(Cube &cube) const
+{
+  return calculateCube(cube, ElectronDensityValue, 0);
+}
+
+bool GaussianSetTools::calculateSpinDensity(Cube &cube) const
+{
+  return calculateCube(cube, SpinDensityValue, 0);
+}
+
 bool GaussianSetTools::isValid() const
 {
   if (m_molecule && dynamic_cast<GaussianSet *>(m_molecule->basisSet()))
@@ -123,64 +170,243 @@ inline bool GaussianSetTools::isSmall(double val) const
     return false;
 }
 
-inline vector<double> GaussianSetTools::calculateValues(const Vector3 &position) const
+void GaussianSetTools::initializeCutoffDistances()
 {
   m_basis->initCalculation();
+  const vector<int> &basis = m_basis->symmetry();
+  const vector<unsigned int> &gtoIndices = m_basis->gtoIndices();
+  const vector<unsigned int> &cIndices = m_basis->cIndices();
+  const vector<double> &gtoA = m_basis->gtoA();
+  const vector<double> &gtoCN = m_basis->gtoCN();
+
+  m_cutoffDistances.assign(basis.size(), 0.0);
+  for (size_t i = 0; i < basis.size(); ++i) {
+    int l(0);
+    unsigned int components(1);
+    switch (basis[i]) {
+    case GaussianSet::S:
+      break;
+    case GaussianSet::P:
+      l = 1;
+      components = 3;
+      break;
+    case GaussianSet::D:
+      l = 2;
+      components = 6;
+      break;
+    case GaussianSet::D5:
+      l = 2;
+      components = 5;
+      break;
+    case GaussianSet::F:
+      l = 3;
+      components = 10;
+      break;
+    case GaussianSet::F7:
+      l = 3;
+      components = 7;
+      break;
+    default:
+      // Not handled, these shells never contribute.
+      continue;
+    }
+
+    // Bound the shell by C * r^l * exp(-a * r^2), where a is the most diffuse
+    // exponent and C covers the sum over the primitives and the angular part.
+    // A negative cutoff means the shell is never skipped.
+    unsigned int primitives = gtoIndices[i + 1] - gtoIndices[i];
+    if (i >= cIndices.size()
+        || cIndices[i] + primitives * components > gtoCN.size()) {
+      m_cutoffDistances[i] = -1.0;
+      continue;
+    }
+    if (primitives == 0)
+      continue;
+    double minA = gtoA[gtoIndices[i]];
+    for (unsigned int j = gtoIndices[i]; j < gtoIndices[i + 1]; ++j)
+      minA = std::min(minA, gtoA[j]);
+    double maxCoefficient = 0.0;
+    unsigned int cEnd = cIndices[i] + primitives * components;
+    for (unsigned int j = cIndices[i]; j < cEnd; ++j)
+      maxCoefficient = std::max(maxCoefficient, std::fabs(gtoCN[j]));
+    double prefactor = 4.0 * primitives * maxCoefficient;
+    if (minA <= 0.0) {
+      m_cutoffDistances[i] = -1.0;
+      continue;
+    }
+    if (prefactor <= cutoffThreshold)
+      continue;
+
+    // Fixed point iteration for r^2, then make sure the bound holds there.
+    double logRatio = std::log(prefactor / cutoffThreshold);
+    double r2 = std::max(logRatio / minA, 0.5 * l / minA);
+    for (int iteration = 0; iteration < 4; ++iteration)
+      r2 = std::max(r2, (logRatio + 0.5 * l * std::log(std::max(r2, 1.0)))
+                         / minA);
+    while (prefactor * std::pow(r2, 0.5 * l) * std::exp(-minA * r2)
+           >= cutoffThreshold) {
+      r2 *= 1.2;
+    }
+    m_cutoffDistances[i] = r2;
+  }
+}
+
+bool GaussianSetTools::calculateBatch(const vector<Vector3> &positions,
+                                      ValueType type, int mo,
+                                      vector<double> &values) const
+{
+  values.assign(positions.size(), 0.0);
+  if (!m_basis)
+    return false;
+
+  m_basis->initCalculation();
+  const MatrixX &moMatrix = m_basis->moMatrix();
+  const Index matrixSize = static_cast<Index>(moMatrix.rows());
+  const MatrixX *matrix = NULL;
+  switch (type) {
+  case MolecularOrbitalValue:
+    if (mo < 1 || mo > static_cast<int>(m_basis->molecularOrbitalCount())
+        || mo > static_cast<int>(moMatrix.cols())) {
+      return false;
+    }
+    break;
+  case ElectronDensityValue:
+    matrix = &m_basis->densityMatrix();
+    break;
+  case SpinDensityValue:
+    matrix = &m_basis->spinDensityMatrix();
+    break;
+  }
+  if (matrix && (static_cast<Index>(matrix->rows()) != matrixSize
+                 || static_cast<Index>(matrix->cols()) != matrixSize)) {
+    return false;
+  }
+  if (positions.empty() || matrixSize == 0)
+    return true;
+
+  // The atom positions are converted once for the whole batch.
   Index atomsSize = m_molecule->atomCount();
-  size_t basisSize = m_basis->symmetry().size();
-  const std::vector<int> &basis = m_basis->symmetry();
-  const std::vector<unsigned int> &atomIndices = m_basis->atomIndices();
-  vector<Vector3> deltas;
-  vector<double> dr2;
-  deltas.reserve(atomsSize);
-  dr2.reserve(atomsSize);
-
-  // Calculate our position
-  Vector3 pos(position * ANGSTROM_TO_BOHR);
-
-  // Calculate the deltas for the position
-  for (Index i = 0; i < atomsSize; ++i) {
-    deltas.push_back(pos - (m_molecule->atom(i).position3d() * ANGSTROM_TO_BOHR));
-    dr2.push_back(deltas[i].squaredNorm());
+  vector<Vector3> atomPositions(atomsSize);
+  for (Index i = 0; i < atomsSize; ++i)
+    atomPositions[i] = m_molecule->atomPosition3d(i) * ANGSTROM_TO_BOHR;
+
+  // The basis function values for a block of points, one column per point.
+  // This is local to the call so that batches can run on several threads.
+  MatrixX block(matrixSize, std::min(blockSize, positions.size()));
+  MatrixX product;
+  for (Index start = 0; start < positions.size(); start += blockSize) {
+    Index count = std::min(blockSize, positions.size() - start);
+    block.leftCols(count).setZero();
+    for (Index p = 0; p < count; ++p) {
+      calculateValues(positions[start + p] * ANGSTROM_TO_BOHR, atomPositions,
+                      true, block.col(p).data());
+    }
+
+    Eigen::Map<Eigen::Matrix<double, Eigen::Dynamic, 1> > result(&values[start],
+                                                               count);
+    if (type == MolecularOrbitalValue) {
+      result.noalias() = block.leftCols(count).transpose()
+          * moMatrix.col(mo - 1);
+    }
+    else {
+      product.noalias() = (*matrix) * block.leftCols(count);
+      result = block.leftCols(count).cwiseProduct(product).colwise().sum()
+          .transpose();
+    }
   }
 
+  return true;
+}
+
+bool GaussianSetTools::calculateCube(Cube &cube, ValueType type, int mo) const
+{
+  const Vector3i dim = cube.dimensions();
+  const size_t slabSize = static_cast<size_t>(dim.y()) * dim.z();
+  const size_t cubeSize = slabSize * dim.x();
+  if (cubeSize == 0)
+    return false;
+
+  // Work through the cube one slab of constant x at a time, the values are set
+  // all at once so that the minimum and maximum are only computed once.
+  vector<double> data(cubeSize);
+  vector<Vector3> positions(slabSize);
+  vector<double> values;
+  for (int i = 0; i < dim.x(); ++i) {
+    size_t offset = i * slabSize;
+    for (size_t j = 0; j < slabSize; ++j)
+      positions[j] = cube.position(static_cast<unsigned int>(offset + j));
+    if (!calculateBatch(positions, type, mo, values))
+      return false;
+    std::copy(values.begin(), values.end(), data.begin() + offset);
+  }
+
+  return cube.setData(data);
+}
+
+inline vector<double> GaussianSetTools::calculateValues(const Vector3 &position) const
+{
+  m_basis->initCalculation();
+  Index atomsSize = m_molecule->atomCount();
+  vector<Vector3> atomPositions(atomsSize);
+  for (Index i = 0; i < atomsSize; ++i)
+    atomPositions[i] = m_molecule->atom(i).position3d() * ANGSTROM_TO_BOHR;
+
   // Allocate space for the values to be calculated.
   size_t matrixSize = m_basis->moMatrix().rows();
   vector<double> values;
   values.resize(matrixSize, 0.0);
+  if (matrixSize > 0) {
+    calculateValues(position * ANGSTROM_TO_BOHR, atomPositions, false,
+                    &values[0]);
+  }
+
+  return values;
+}
+
+void GaussianSetTools::calculateValues(const Vector3 &pos,
+                                       const vector<Vector3> &atomPositions,
+                                       bool useCutoff, double *values) const
+{
+  size_t basisSize = m_basis->symmetry().size();
+  const std::vector<int> &basis = m_basis->symmetry();
+  const std::vector<unsigned int> &atomIndices = m_basis->atomIndices();
 
   // Now calculate the values at this point in space
   for (unsigned int i = 0; i < basisSize; ++i) {
+    Vector3 delta(pos - atomPositions[atomIndices[i]]);
+    double dr2(delta.squaredNorm());
+    if (useCutoff && i < m_cutoffDistances.size()
+        && m_cutoffDistances[i] >= 0.0 && dr2 > m_cutoffDistances[i]) {
+      continue;
+    }
     switch (basis[i]) {
     case GaussianSet::S:
-      pointS(i, dr2[atomIndices[i]], values);
+      pointS(i, dr2, values);
       break;
     case GaussianSet::P:
-      pointP(i, deltas[atomIndices[i]], dr2[atomIndices[i]], values);
+      pointP(i, delta, dr2, values);
       break;
     case GaussianSet::D:
-      pointD(i, deltas[atomIndices[i]], dr2[atomIndices[i]], values);
+      pointD(i, delta, dr2, values);
       break;
     case GaussianSet::D5:
-      pointD5(i, deltas[atomIndices[i]], dr2[atomIndices[i]], values);
+      pointD5(i, delta, dr2, values);
       break;
     case GaussianSet::F:
-      pointF(i, deltas[atomIndices[i]], dr2[atomIndices[i]], values);
+      pointF(i, delta, dr2, values);
       break;
     case GaussianSet::F7:
-      pointF7(i, deltas[atomIndices[i]], dr2[atomIndices[i]], values);
+      pointF7(i, delta, dr2, values);
       break;
     default:
       // Not handled - return a zero contribution
       ;
     }
   }
-
-  return values;
 }
 
 inline void GaussianSetTools::pointS(unsigned int moIndex, double dr2,
-                                     vector<double> &values) const
+                                     double *values) const
 {
   // S type orbitals - the simplest of the calculations with one component
   double tmp = 0.0;
@@ -194,7 +420,7 @@ inline void GaussianSetTools::pointS(unsigned int moIndex, double dr2,
 }
 
 inline void GaussianSetTools::pointP(unsigned int moIndex, const Vector3 &delta,
-                                     double dr2, vector<double> &values) const
+                                     double dr2, double *values) const
 {
   // P type orbitals have three components and each component has a different
   // independent MO weighting. Many things can be cached to save time though.
@@ -216,7 +442,7 @@ inline void GaussianSetTools::pointP(unsigned int moIndex, const Vector3 &delta,
 }
 
 inline void GaussianSetTools::pointD(unsigned int moIndex, const Vector3 &delta,
-                                     double dr2, vector<double> &values) const
+                                     double dr2, double *values) const
 {
   // D type orbitals have six components and each component has a different
   // independent MO weighting. Many things can be cached to save time though.
@@ -251,7 +477,7 @@ inline void GaussianSetTools::pointD(unsigned int moIndex, const Vector3 &delta,
 
 inline void GaussianSetTools::pointD5(unsigned int moIndex,
                                       const Vector3 &delta,
-                                      double dr2, vector<double> &values) const
+                                      double dr2, double *values) const
 {
   // D type orbitals have five components and each component has a different
   // MO weighting. Many things can be cached to save time.
@@ -290,7 +516,7 @@ inline void GaussianSetTools::pointD5(unsigned int moIndex,
     values[baseIndex + i] += componentsD[i] * components[i];
 }
 inline void GaussianSetTools::pointF(unsigned int moIndex, const Vector3 &delta,
-                                     double dr2, vector<double> &values) const
+                                     double dr2, double *values) const
 {
   // F type orbitals have 10 components and each component has a different
   // independent MO weighting. Many things can be cached to save time though.
@@ -328,7 +554,7 @@ inline void GaussianSetTools::pointF(unsigned int moIndex, const Vector3 &delta,
 }
 
 inline void GaussianSetTools::pointF7(unsigned int moIndex, const Vector3 &delta,
-                                     double dr2, vector<double> &values) const
+                                     double dr2, double *values) const
 {
   // F type orbitals have 7 components and each component has a different
   // independent MO weighting. Many things can be cached to save time though.
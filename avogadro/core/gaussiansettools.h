@@ -21,6 +21,7 @@
 
 #include "avogadrocore.h"
 
+#include "matrix.h"
 #include "vector.h"
 
 #include <vector>
@@ -28,6 +29,7 @@
 namespace Avogadro {
 namespace Core {
 
+class Cube;
 class GaussianSet;
 class Molecule;
 
@@ -70,6 +72,63 @@ public:
    */
   double calculateSpinDensity(const Vector3 &position) const;
 
+  /**
+   * @brief Calculate the value of the specified molecular orbital at a batch
+   * of positions. The points are evaluated in blocks, skipping shells that are
+   * too far away to contribute, which is much faster than calling the single
+   * point version for each position.
+   * @param positions The positions in space to calculate the values at.
+   * @param molecularOrbitalNumber The molecular orbital number.
+   * @param values Resized to hold the value at each of the @p positions.
+   * @return False if the molecular orbital number is invalid.
+   */
+  bool calculateMolecularOrbital(const std::vector<Vector3> &positions,
+                                 int molecularOrbitalNumber,
+                                 std::vector<double> &values) const;
+
+  /**
+   * @brief Calculate the value of the electron density at a batch of
+   * positions. The density contraction for each block of points is done as a
+   * single matrix product.
+   * @param positions The positions in space to calculate the values at.
+   * @param values Resized to hold the value at each of the @p positions.
+   * @return False if there is no density matrix for the basis set.
+   */
+  bool calculateElectronDensity(const std::vector<Vector3> &positions,
+                                std::vector<double> &values) const;
+
+  /**
+   * @brief Calculate the value of the electron spin density at a batch of
+   * positions.
+   * @param positions The positions in space to calculate the values at.
+   * @param values Resized to hold the value at each of the @p positions.
+   * @return False if there is no spin density matrix for the basis set.
+   */
+  bool calculateSpinDensity(const std::vector<Vector3> &positions,
+                            std::vector<double> &values) const;
+
+  /**
+   * @brief Populate the cube with values for the specified molecular orbital.
+   * @param cube The cube to fill, its limits must already be set.
+   * @param molecularOrbitalNumber The molecular orbital number.
+   * @return True on success, false on failure.
+   */
+  bool calculateMolecularOrbital(Cube &cube, int molecularOrbitalNumber) const;
+
+  /**
+   * @brief Populate the cube with values for the electron density.
+   * @param cube The cube to fill, its limits must already be set.
+   * @return True on success, false on failure.
+   */
+  bool calculateElectronDensity(Cube &cube) const;
+
+  /**
+   * @brief Populate the cube with values for the electron spin density.
+   * @param cube The cube to fill, its limits must already be set.
+   * @return True on success, false on failure.
+   */
+  bool calculateSpinDensity(Cube &cube) const;
+
   /**
    * @brief Check that the basis set is valid and can be used.
    * @return True if valid, false otherwise.
@@ -80,8 +139,46 @@ private:
   Molecule *m_molecule;
   GaussianSet *m_basis;
 
+  /**
+   * The squared distance (Bohr^2) from its atom beyond which each shell's
+   * contribution is negligible, used to skip shells in the batch calculations.
+   */
+  std::vector<double> m_cutoffDistances;
+
+  enum ValueType {
+    MolecularOrbitalValue,
+    ElectronDensityValue,
+    SpinDensityValue
+  };
+
   bool isSmall(double value) const;
 
+  /** Compute the per-shell cutoff distances from the basis set. */
+  void initializeCutoffDistances();
+
+  /**
+   * @brief Calculate the values for a batch of positions, in blocks of points
+   * that share scratch storage.
+   */
+  bool calculateBatch(const std::vector<Vector3> &positions, ValueType type,
+                      int molecularOrbitalNumber,
+                      std::vector<double> &values) const;
+
+  /** Fill the cube using calculateBatch() for each slab of the cube. */
+  bool calculateCube(Cube &cube, ValueType type,
+                     int molecularOrbitalNumber) const;
+
+  /**
+   * @brief Calculate the basis function values at one position into
+   * @p values, which must hold a zero initialized value for each basis
+   * function.
+   * @param atomPositions The atom positions in Bohr.
+   * @param useCutoff Skip shells beyond their cutoff distance if true.
+   */
+  void calculateValues(const Vector3 &position,
+                       const std::vector<Vector3> &atomPositions,
+                       bool useCutoff, double *values) const;
+
   /**
    * @brief Calculate the values at this position in space. The public calculate
    * functions call this function to prepare values before multiplying by the
@@ -90,18 +187,17 @@ private:
    */
   std::vector<double> calculateValues(const Vector3 &position) const;
 
-  void pointS(unsigned int index, double dr2,
-              std::vector<double> &values) const;
+  void pointS(unsigned int index, double dr2, double *values) const;
   void pointP(unsigned int index, const Vector3 &delta, double dr2,
-              std::vector<double> &values) const;
+              double *values) const;
   void pointD(unsigned int index, const Vector3 &delta, double dr2,
-              std::vector<double> &values) const;
+              double *values) const;
   void pointD5(unsigned int index, const Vector3 &delta, double dr2,
-               std::vector<double> &values) const;
+               double *values) const;
   void pointF(unsigned int index, const Vector3 &delta, double dr2,
-               std::vector<double> &values) const;
+              double *values) const;
   void pointF7(unsigned int index, const Vector3 &delta, double dr2,
-               std::vector<double> &values) const;
+               double *values) const;
 };
 
 } // End Core namespace
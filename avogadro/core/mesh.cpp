@@ -33,7 +33,7 @@ Mesh::Mesh() : m_stable(true), m_other(0), m_cube(0), m_lock(new Mutex)
 
 Mesh::Mesh(const Mesh &other)
  : m_vertices(other.m_vertices), m_normals(other.m_normals),
-   m_colors(other.m_colors), m_name(other.m_name), m_stable(true),
+   m_indices(other.m_indices), m_colors(other.m_colors), m_name(other.m_name), m_stable(true),
    m_isoValue(other.m_isoValue), m_other(other.m_other), m_cube(other.m_cube),
    m_lock(new Mutex)
 {
@@ -60,7 +60,7 @@ void Mesh::setStable(bool isStable)
   m_stable = isStable;
 }
 
-bool Mesh::stable()
+bool Mesh::stable() const
 {
   return m_stable;
 }
@@ -127,6 +127,20 @@ bool Mesh::addNormals(const Core::Array<Vector3f> &values)
   }
 }
 
+const Core::Array<unsigned int> &Mesh::indices() const
+{
+  return m_indices;
+}
+
+bool Mesh::setIndices(const Core::Array<unsigned int> &values)
+{
+  if (values.size() % 3 != 0)
+    return false;
+  m_indices.clear();
+  m_indices = values;
+  return true;
+}
+
 const Core::Array<Color3f> &Mesh::colors() const
 {
   return m_colors;
@@ -164,6 +178,11 @@ bool Mesh::addColors(const Core::Array<Color3f> &values)
 
 bool Mesh::valid() const
 {
+  if (m_indices.size() % 3 != 0)
+    return false;
+  for (size_t i = 0; i < m_indices.size(); ++i)
+    if (m_indices[i] >= m_vertices.size())
+      return false;
   if (m_vertices.size() == m_normals.size()) {
     if (m_colors.size() == 1 || m_colors.size() == m_vertices.size())
       return true;
@@ -179,6 +198,7 @@ bool Mesh::clear()
 {
   m_vertices.clear();
   m_normals.clear();
+  m_indices.clear();
   m_colors.clear();
   return true;
 }
@@ -186,7 +206,8 @@ bool Mesh::clear()
 Mesh& Mesh::operator=(const Mesh& other)
 {
   m_vertices = other.m_vertices;
-  m_normals = other.m_vertices;
+  m_normals = other.m_normals;
+  m_indices = other.m_indices;
   m_colors = other.m_colors;
   m_name = other.m_name;
   m_isoValue = other.m_isoValue;
@@ -82,7 +82,7 @@ public:
    * general using Mesh values from an unstable Mesh is not advisable.
    * @return True if the Mesh is complete, false if it is being modified.
    */
-  bool stable();
+  bool stable() const;
 
   /**
    * Set the iso value that was used to generate the Mesh.
@@ -172,6 +172,37 @@ public:
    */
   bool addNormals(const Core::Array<Vector3f> &values);
 
+  /**
+   * @return Array containing the vertex indices of the triangles, three
+   * consecutive indices per triangle. If this is empty the vertices are
+   * explicit triangles, i.e. every three consecutive vertices make up one
+   * triangle.
+   */
+  const Core::Array<unsigned int> & indices() const;
+
+  /**
+   * @return The number of indices.
+   */
+  unsigned int numIndices() const
+  {
+    return static_cast<unsigned int>(m_indices.size());
+  }
+
+  /**
+   * @return The number of triangles, taking the index array into account if
+   * the Mesh has one.
+   */
+  unsigned int numTriangles() const
+  {
+    return m_indices.empty() ? numVertices() / 3 : numIndices() / 3;
+  }
+
+  /**
+   * Clear the index array and assign new values. The array is expected to be
+   * of length 3 x n where n is the number of triangles.
+   */
+  bool setIndices(const Core::Array<unsigned int> &values);
+
   /**
    * @return Array containing all of the colors in a one-dimensional array.
    */
@@ -196,7 +227,7 @@ public:
   /**
    * Sanity checking function - is the mesh sane?
    * @return True if the Mesh object is sane and composed of the right number
-   * of elements.
+   * of elements, and all indices refer to existing vertices.
    */
   bool valid() const;
 
@@ -231,6 +262,7 @@ public:
 private:
   Core::Array<Vector3f> m_vertices;
   Core::Array<Vector3f> m_normals;
+  Core::Array<unsigned int> m_indices;
   Core::Array<Color3f> m_colors;
   std::string m_name;
   bool m_stable;
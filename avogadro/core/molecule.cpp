@@ -21,6 +21,8 @@
 #include "cube.h"
 #include "elements.h"
 #include "mesh.h"
+#include "neighborperceiver.h"
+#include "trajectorysource.h"
 #include "unitcell.h"
 
 #include <cassert>
@@ -29,7 +31,18 @@
 namespace Avogadro {
 namespace Core {
 
-Molecule::Molecule() : m_graphDirty(false), m_basisSet(NULL), m_unitCell(NULL)
+namespace {
+// Make an std::pair where the lower index is always first in the pair. This
+// offers us the guarantee that any given pair of atoms will always result in
+// a pair that is the same no matter what the order of the atoms given.
+std::pair<Index, Index> makeBondPair(const Index &a, const Index &b)
+{
+  return a < b ? std::make_pair(a, b) : std::make_pair(b, a);
+}
+}
+
+Molecule::Molecule() : m_graphDirty(false), m_basisSet(NULL), m_unitCell(NULL),
+  m_trajectorySource(NULL)
 {
 }
 
@@ -40,12 +53,15 @@ Molecule::Molecule(const Molecule &other)
     m_atomicNumbers(other.atomicNumbers()),
     m_positions2d(other.m_positions2d),
     m_positions3d(other.m_positions3d),
+    m_coordinates3d(other.m_coordinates3d),
     m_hybridizations(other.m_hybridizations),
     m_formalCharges(other.m_formalCharges),
     m_bondPairs(other.m_bondPairs),
     m_bondOrders(other.m_bondOrders),
     m_basisSet(NULL),
-    m_unitCell(other.m_unitCell ? new UnitCell(*other.m_unitCell) : NULL)
+    m_unitCell(other.m_unitCell ? new UnitCell(*other.m_unitCell) : NULL),
+    m_trajectorySource(other.m_trajectorySource
+                       ? other.m_trajectorySource->clone() : NULL)
 {
   // Copy over any meshes
   for(Index i = 0; i < other.meshCount(); ++i) {
@@ -65,6 +81,9 @@ Molecule& Molecule::operator=(const Molecule& other)
     m_atomicNumbers = other.m_atomicNumbers;
     m_positions2d = other.m_positions2d;
     m_positions3d = other.m_positions3d;
+    m_coordinates3d = other.m_coordinates3d;
+    setTrajectorySource(other.m_trajectorySource
+                        ? other.m_trajectorySource->clone() : NULL);
     m_hybridizations = other.m_hybridizations;
     m_formalCharges = other.m_formalCharges;
     m_bondPairs = other.m_bondPairs;
@@ -86,6 +105,7 @@ Molecule::~Molecule()
 {
   delete m_basisSet;
   delete m_unitCell;
+  delete m_trajectorySource;
   clearMeshes();
 }
 
@@ -224,25 +244,30 @@ bool Molecule::hasCustomElements() const
 
 Molecule::AtomType Molecule::addAtom(unsigned char number)
 {
-  // Mark the graph as dirty.
-  m_graphDirty = true;
-
-  // Add the atomic number.
+  // Add the atomic number, the graph is resized as needed by updateGraph().
   m_atomicNumbers.push_back(number);
 
   return AtomType(this, static_cast<Index>(m_atomicNumbers.size() - 1));
 }
 
+void Molecule::addAtoms(const Array<unsigned char> &atomicNumbers)
+{
+  m_atomicNumbers.reserve(m_atomicNumbers.size() + atomicNumbers.size());
+  for (Index i = 0; i < atomicNumbers.size(); ++i)
+    m_atomicNumbers.push_back(atomicNumbers[i]);
+}
+
 bool Molecule::removeAtom(Index index)
 {
   if (index >= atomCount())
     return false;
 
-  // Before removing the atom we must first remove any bonds to it.
-  Array<BondType> atomBonds = bonds(atom(index));
-  while (atomBonds.size()) {
+  // Before removing the atom we must first remove any bonds to it. Removing
+  // the highest index first ensures the remaining indices stay valid.
+  std::vector<Index> atomBonds = bondIndices(index);
+  while (!atomBonds.empty()) {
     removeBond(atomBonds.back());
-    atomBonds = bonds(atom(index));
+    atomBonds.pop_back();
   }
 
   Index newSize = static_cast<Index>(m_atomicNumbers.size() - 1);
@@ -259,15 +284,17 @@ bool Molecule::removeAtom(Index index)
       m_formalCharges[index] = m_formalCharges.back();
 
     // Find any bonds to the moved atom and update their index.
-    atomBonds = bonds(atom(newSize));
-    for (Array<BondType>::const_iterator it = atomBonds.begin(),
+    atomBonds = bondIndices(newSize);
+    for (std::vector<Index>::const_iterator it = atomBonds.begin(),
          itEnd = atomBonds.end(); it != itEnd; ++it) {
-      std::pair<Index, Index> pair = m_bondPairs[it->index()];
+      std::pair<Index, Index> pair = m_bondPairs[*it];
       if (pair.first == newSize)
         pair.first = index;
       else if (pair.second == newSize)
         pair.second = index;
-      m_bondPairs[it->index()] = pair;
+      unindexBond(*it);
+      m_bondPairs[*it] = makeBondPair(pair.first, pair.second);
+      indexBond(*it);
     }
   }
   // Resize the arrays for the smaller molecule.
@@ -317,25 +344,15 @@ Index Molecule::atomCount(unsigned char number) const
   return count;
 }
 
-namespace {
-// Make an std::pair where the lower index is always first in the pair. This
-// offers us the guarantee that any given pair of atoms will always result in
-// a pair that is the same no matter what the order of the atoms given.
-std::pair<Index, Index> makeBondPair(const Index &a, const Index &b)
-{
-  return a < b ? std::make_pair(a, b) : std::make_pair(b, a);
-}
-}
-
 Molecule::BondType Molecule::addBond(Index atom1, Index atom2,
                                      unsigned char order)
 {
   assert(atom1 < atomCount());
   assert(atom2 < atomCount());
 
-  m_graphDirty = true;
   m_bondPairs.push_back(makeBondPair(atom1, atom2));
   m_bondOrders.push_back(order);
+  indexBond(bondCount() - 1);
 
   return BondType(this, bondCount() - 1);
 }
@@ -346,22 +363,48 @@ Molecule::BondType Molecule::addBond(const AtomType &a, const AtomType &b,
   assert(a.isValid() && a.molecule() == this);
   assert(b.isValid() && b.molecule() == this);
 
-  m_graphDirty = true;
   m_bondPairs.push_back(makeBondPair(a.index(), b.index()));
   m_bondOrders.push_back(order);
+  indexBond(bondCount() - 1);
 
   return BondType(this, static_cast<Index>(m_bondPairs.size() - 1));
 }
 
+bool Molecule::addBonds(const Array<std::pair<Index, Index> > &pairs,
+                        const Array<unsigned char> &orders)
+{
+  if (!orders.empty() && orders.size() != pairs.size())
+    return false;
+  Index count = atomCount();
+  for (Array<std::pair<Index, Index> >::const_iterator it = pairs.begin(),
+       itEnd = pairs.end(); it != itEnd; ++it) {
+    if (it->first >= count || it->second >= count)
+      return false;
+  }
+
+  m_bondPairs.reserve(m_bondPairs.size() + pairs.size());
+  m_bondOrders.reserve(m_bondOrders.size() + pairs.size());
+  for (Index i = 0; i < pairs.size(); ++i) {
+    m_bondPairs.push_back(makeBondPair(pairs[i].first, pairs[i].second));
+    m_bondOrders.push_back(orders.empty() ? 1 : orders[i]);
+  }
+  m_graphDirty = true;
+  return true;
+}
+
 bool Molecule::removeBond(Index index)
 {
   if (index >= bondCount())
     return false;
 
   Index newSize = static_cast<Index>(m_bondOrders.size() - 1);
+  unindexBond(index);
   if (index != newSize) {
+    // Move the last bond to this position.
+    unindexBond(newSize);
     m_bondOrders[index] = m_bondOrders.back();
     m_bondPairs[index] = m_bondPairs.back();
+    indexBond(index);
   }
   m_bondOrders.pop_back();
   m_bondPairs.pop_back();
@@ -401,17 +444,7 @@ Molecule::BondType Molecule::bond(const AtomType &a, const AtomType &b) const
   assert(a.isValid() && a.molecule() == this);
   assert(b.isValid() && b.molecule() == this);
 
-  std::pair<Index, Index> pair = makeBondPair(a.index(), b.index());
-
-  Array<std::pair<Index, Index> >::const_iterator iter =
-    std::find(m_bondPairs.begin(), m_bondPairs.end(), pair);
-
-  if (iter == m_bondPairs.end())
-    return BondType();
-
-  Index index = static_cast<Index>(std::distance(m_bondPairs.begin(), iter));
-
-  return BondType(const_cast<Molecule *>(this), index);
+  return bond(a.index(), b.index());
 }
 
 Molecule::BondType Molecule::bond(Index atomId1, Index atomId2) const
@@ -419,16 +452,23 @@ Molecule::BondType Molecule::bond(Index atomId1, Index atomId2) const
   assert(atomId1 < atomCount());
   assert(atomId2 < atomCount());
 
+  updateGraph();
   std::pair<Index, Index> pair = makeBondPair(atomId1, atomId2);
 
-  Array<std::pair<Index, Index> >::const_iterator iter =
-      std::find(m_bondPairs.begin(), m_bondPairs.end(), pair);
+  // Return the lowest index if the atoms are bonded more than once.
+  Index index = MaxIndex;
+  const std::vector<Index> &atomBonds = m_atomBonds[atomId1];
+  for (std::vector<Index>::const_iterator it = atomBonds.begin(),
+       itEnd = atomBonds.end(); it != itEnd; ++it) {
+    if (*it < index && makeBondPair(m_bondPairs[*it].first,
+                                    m_bondPairs[*it].second) == pair) {
+      index = *it;
+    }
+  }
 
-  if (iter == m_bondPairs.end())
+  if (index == MaxIndex)
     return BondType();
 
-  Index index = static_cast<Index>(std::distance(m_bondPairs.begin(), iter));
-
   return BondType(const_cast<Molecule *>(this), index);
 }
 
@@ -436,25 +476,31 @@ Array<Molecule::BondType> Molecule::bonds(const AtomType &a)
 {
   if (!a.isValid())
     return Array<BondType>();
-  Array<BondType> atomBonds;
-  Index atomIndex = a.index();
-  for (Index i = 0; i < m_bondPairs.size(); ++i)
-    if (m_bondPairs[i].first == atomIndex || m_bondPairs[i].second == atomIndex)
-      atomBonds.push_back(BondType(this, i));
-  return atomBonds;
+  return bonds(a.index());
 }
 
 Array<Molecule::BondType> Molecule::bonds(Index a)
 {
   Array<BondType> atomBonds;
-  if (a < atomCount()) {
-    for (Index i = 0; i < m_bondPairs.size(); ++i)
-      if (m_bondPairs[i].first == a || m_bondPairs[i].second == a)
-        atomBonds.push_back(BondType(this, i));
+  std::vector<Index> indices = bondIndices(a);
+  atomBonds.reserve(indices.size());
+  for (std::vector<Index>::const_iterator it = indices.begin(),
+       itEnd = indices.end(); it != itEnd; ++it) {
+    atomBonds.push_back(BondType(this, *it));
   }
   return atomBonds;
 }
 
+std::vector<Index> Molecule::bondIndices(Index a) const
+{
+  if (a >= atomCount())
+    return std::vector<Index>();
+  updateGraph();
+  std::vector<Index> indices(m_atomBonds[a]);
+  std::sort(indices.begin(), indices.end());
+  return indices;
+}
+
 Index Molecule::bondCount() const
 {
   return m_bondPairs.size();
@@ -591,16 +637,30 @@ void Molecule::perceiveBondsSimple()
 
   // cache atomic radii
   std::vector<double> radii(atomCount());
+  double maxRadius = 0.0;
   for (size_t i = 0; i < radii.size(); i++) {
     radii[i] = Elements::radiusCovalent(m_atomicNumbers[i]);
     if (radii[i] <= 0.0)
       radii[i] = 2.0;
+    maxRadius = std::max(maxRadius, radii[i]);
   }
 
+  // Bin the atoms so that only nearby pairs are considered, no bond can be
+  // longer than twice the largest radius plus the tolerance.
+  NeighborPerceiver perceiver(m_positions3d, 2.0 * maxRadius + tolerance);
+  std::vector<Index> neighbors;
+
   // check for bonds
   for (Index i = 0; i < atomCount(); i++) {
     Vector3 ipos = m_positions3d[i];
-    for (Index j = i + 1; j < atomCount(); j++) {
+    neighbors.clear();
+    perceiver.neighbors(ipos, neighbors);
+    // Keep the bonds in the same order as the exhaustive all-pairs search.
+    std::sort(neighbors.begin(), neighbors.end());
+    std::vector<Index>::const_iterator it =
+        std::upper_bound(neighbors.begin(), neighbors.end(), i);
+    for (; it != neighbors.end(); ++it) {
+      Index j = *it;
       double cutoff = radii[i] + radii[j] + tolerance;
       Vector3 jpos = m_positions3d[j];
       Vector3 diff = jpos - ipos;
@@ -620,17 +680,39 @@ void Molecule::perceiveBondsSimple()
   }
 }
 
-int Molecule::coordinate3dCount()
+int Molecule::coordinate3dCount() const
 {
-  return static_cast<int>(m_coordinates3d.size());
+  size_t count = m_coordinates3d.size();
+  if (m_trajectorySource)
+    count = std::max(count, m_trajectorySource->frameCount());
+  return static_cast<int>(count);
 }
 
 bool Molecule::setCoordinate3d(int coord)
 {
-  if (coord >= 0 && coord < static_cast<int>(m_coordinates3d.size())) {
-    m_positions3d = m_coordinates3d[coord];
+  Array<Vector3> positions;
+  if (!coordinate3d(coord, positions))
+    return false;
+  m_positions3d.swap(positions);
+  return true;
+}
+
+bool Molecule::coordinate3d(int index, Array<Vector3> &coords) const
+{
+  if (index < 0)
+    return false;
+  if (index < static_cast<int>(m_coordinates3d.size())
+      && (!m_coordinates3d[index].empty() || !m_trajectorySource)) {
+    coords = m_coordinates3d[index];
     return true;
   }
+  if (m_trajectorySource
+      && static_cast<size_t>(index) < m_trajectorySource->frameCount()) {
+    if (m_trajectorySource->readFrame(static_cast<size_t>(index), coords)
+        && coords.size() == atomCount()) {
+      return true;
+    }
+  }
   return false;
 }
 
@@ -640,6 +722,34 @@ int Molecule::coordinate3d() const
   return 0;
 }
 
+Molecule::Snapshot::Snapshot()
+{
+}
+
+Molecule::Snapshot::Snapshot(const Molecule &molecule)
+  : m_atomicNumbers(molecule.m_atomicNumbers),
+    m_positions2d(molecule.m_positions2d),
+    m_positions3d(molecule.m_positions3d),
+    m_hybridizations(molecule.m_hybridizations),
+    m_formalCharges(molecule.m_formalCharges),
+    m_bondPairs(molecule.m_bondPairs),
+    m_bondOrders(molecule.m_bondOrders)
+{
+}
+
+Molecule::Snapshot Molecule::snapshot() const
+{
+  return Snapshot(*this);
+}
+
+void Molecule::setTrajectorySource(TrajectorySource *source)
+{
+  if (source != m_trajectorySource) {
+    delete m_trajectorySource;
+    m_trajectorySource = source;
+  }
+}
+
 bool Molecule::setCoordinate3d(const Array<Vector3> &coords, int index)
 {
   if (static_cast<int>(m_coordinates3d.size()) <= index)
@@ -650,15 +760,60 @@ bool Molecule::setCoordinate3d(const Array<Vector3> &coords, int index)
 
 void Molecule::updateGraph() const
 {
-  if (!m_graphDirty)
+  if (!m_graphDirty) {
+    // The bond index is updated as bonds are added and removed, atoms may have
+    // been added or removed since but bonds can only refer to existing atoms.
+    if (m_atomBonds.size() != atomCount()) {
+      m_atomBonds.resize(atomCount());
+      m_graph.setSize(atomCount());
+    }
     return;
+  }
   m_graphDirty = false;
   m_graph.clear();
   m_graph.setSize(atomCount());
-  typedef Array<std::pair<Index, Index> >::const_iterator IterType;
-  for (IterType it = m_bondPairs.begin(); it != m_bondPairs.end(); ++it) {
-    m_graph.addEdge(it->first, it->second);
+  m_atomBonds.clear();
+  m_atomBonds.resize(atomCount());
+  for (Index i = 0; i < m_bondPairs.size(); ++i)
+    indexBond(i);
+}
+
+void Molecule::indexBond(Index bondId) const
+{
+  // A dirty index will be rebuilt from scratch on the next lookup.
+  if (m_graphDirty)
+    return;
+
+  const std::pair<Index, Index> &pair = m_bondPairs[bondId];
+  Index size = std::max(pair.first, pair.second) + 1;
+  if (m_atomBonds.size() < size) {
+    m_atomBonds.resize(size);
+    m_graph.setSize(size);
+  }
+  m_atomBonds[pair.first].push_back(bondId);
+  m_atomBonds[pair.second].push_back(bondId);
+  m_graph.addEdge(pair.first, pair.second);
+}
+
+void Molecule::unindexBond(Index bondId) const
+{
+  if (m_graphDirty)
+    return;
+
+  const std::pair<Index, Index> &pair = m_bondPairs[bondId];
+  std::vector<Index> &first = m_atomBonds[pair.first];
+  std::vector<Index> &second = m_atomBonds[pair.second];
+  first.erase(std::find(first.begin(), first.end(), bondId));
+  second.erase(std::find(second.begin(), second.end(), bondId));
+
+  // Only remove the graph edge if this was the last bond between the atoms.
+  std::pair<Index, Index> key = makeBondPair(pair.first, pair.second);
+  for (std::vector<Index>::const_iterator it = first.begin(),
+       itEnd = first.end(); it != itEnd; ++it) {
+    if (makeBondPair(m_bondPairs[*it].first, m_bondPairs[*it].second) == key)
+      return;
   }
+  m_graph.removeEdge(pair.first, pair.second);
 }
 
 } // end Core namespace
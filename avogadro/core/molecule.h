@@ -21,6 +21,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include "array.h"
 #include "atom.h"
@@ -34,6 +35,7 @@ namespace Core {
 class BasisSet;
 class Cube;
 class Mesh;
+class TrajectorySource;
 class UnitCell;
 
 /** Concrete atom/bond proxy classes for Core::Molecule. @{ */
@@ -44,6 +46,13 @@ class Bond;
 /**
  * @class Molecule molecule.h <avogadro/core/molecule.h>
  * @brief The Molecule class represents a chemical molecule.
+ *
+ * The bonds to each atom are indexed for bond(), bondIndices() and graph().
+ * The index is kept up to date by the functions that modify bonds, and rebuilt
+ * by the next lookup after bulk changes such as addBonds(). As that rebuild
+ * happens in a const lookup, const functions of a molecule must not be called
+ * from several threads at once. Use snapshot() to read a molecule from other
+ * threads.
  */
 class AVOGADROCORE_EXPORT Molecule
 {
@@ -234,7 +243,12 @@ public:
    */
   bool setAtomPosition3d(Index atomId, const Vector3& pos);
 
-  /** Returns a vector of pairs of atom indices of the bonds in the molecule. */
+  /**
+   * Returns a vector of pairs of atom indices of the bonds in the molecule.
+   * @note The non-const array must not be used to modify the bonds, as that
+   * bypasses the bond index. Use addBond(), addBonds(), removeBond(),
+   * setBondPair() or setBondPairs() instead.
+   */
   Array<std::pair<Index, Index> >& bondPairs();
 
   /** \overload */
@@ -324,6 +338,13 @@ public:
   /**  Adds an atom to the molecule. */
   virtual AtomType addAtom(unsigned char atomicNumber);
 
+  /**
+   * Add many atoms at once, which is cheaper than adding them one by one when
+   * reading a file.
+   * @param atomicNumbers The atomic number of each new atom.
+   */
+  virtual void addAtoms(const Array<unsigned char> &atomicNumbers);
+
   /**
    * @brief Remove the specified atom from the molecule.
    * @param index The index of the atom to be removed.
@@ -375,6 +396,18 @@ public:
                            unsigned char order = 1);
   /** @} */
 
+  /**
+   * Create many new bonds at once. The bond index is rebuilt once by the next
+   * lookup rather than updated for each bond, which is much cheaper when
+   * reading a file.
+   * @param pairs The atoms of each bond, which must exist.
+   * @param orders The order of each bond, or empty for single bonds.
+   * @return True on success. False if an atom does not exist or the sizes of
+   * @a pairs and @a orders differ, in which case no bonds are added.
+   */
+  virtual bool addBonds(const Array<std::pair<Index, Index> > &pairs,
+                        const Array<unsigned char> &orders);
+
   /**
    * @brief Remove the specified bond.
    * @param index The index of the bond to be removed.
@@ -425,6 +458,13 @@ public:
   Array<BondType> bonds(Index a);
   /** @} */
 
+  /**
+   * @brief Get the indices of all bonds to the atom at index @p a.
+   * @return The bond indices in ascending order, empty if @p a is invalid.
+   * This is an O(degree) lookup in the per-atom bond index.
+   */
+  std::vector<Index> bondIndices(Index a) const;
+
   /** Returns the number of bonds in the molecule. */
   Index bondCount() const;
 
@@ -493,14 +533,119 @@ public:
    */
   void perceiveBondsSimple();
 
-  int coordinate3dCount();
+  int coordinate3dCount() const;
   bool setCoordinate3d(int coord);
   int coordinate3d() const;
   bool setCoordinate3d(const Array<Vector3> &coords, int index);
 
+  /**
+   * Get the atom positions of a coordinate set without making it the current
+   * one, reading it from the trajectory source if needed.
+   * @param index The index of the coordinate set.
+   * @param coords Set to the positions of the atoms in the coordinate set.
+   * @return True on success, false if there is no such coordinate set.
+   */
+  bool coordinate3d(int index, Array<Vector3> &coords) const;
+
+  /**
+   * Set a source for coordinate sets that are read on demand, such as the
+   * frames of a long trajectory. The molecule takes ownership of the object.
+   * Coordinate sets stored with setCoordinate3d(coords, index) take precedence
+   * over the frames of the source.
+   */
+  void setTrajectorySource(TrajectorySource *source);
+
+  /**
+   * Get the source of on demand coordinate sets, NULL if there is none.
+   */
+  TrajectorySource * trajectorySource() { return m_trajectorySource; }
+  const TrajectorySource * trajectorySource() const
+  {
+    return m_trajectorySource;
+  }
+
+  /**
+   * @class Snapshot molecule.h <avogadro/core/molecule.h>
+   * @brief The Snapshot class holds the atoms and bonds of a molecule as they
+   * were when it was taken.
+   *
+   * Taking a snapshot shares the arrays of the molecule rather than copying
+   * them, so it is cheap whatever the size of the molecule. The molecule copies
+   * an array the first time it is modified after the snapshot was taken. The
+   * snapshot must be taken in the thread editing the molecule, it can then be
+   * passed to and read from any other thread while the molecule continues to
+   * be edited, for example to generate meshes or export files in the
+   * background. Snapshots can be copied freely, but a single snapshot must not
+   * be assigned to in one thread while it is read in another.
+   */
+  class AVOGADROCORE_EXPORT Snapshot
+  {
+  public:
+    /** Create an empty snapshot. */
+    Snapshot();
+
+    /** Create a snapshot of @p molecule. */
+    explicit Snapshot(const Molecule &molecule);
+
+    /** The number of atoms and bonds in the snapshot. @{ */
+    Index atomCount() const
+    {
+      return static_cast<Index>(m_atomicNumbers.size());
+    }
+    Index bondCount() const
+    {
+      return static_cast<Index>(m_bondPairs.size());
+    }
+    /** @} */
+
+    /** The per atom arrays, see the Molecule functions of the same name. @{ */
+    const Array<unsigned char>& atomicNumbers() const
+    {
+      return m_atomicNumbers;
+    }
+    const Array<Vector2>& atomPositions2d() const { return m_positions2d; }
+    const Array<Vector3>& atomPositions3d() const { return m_positions3d; }
+    const Array<AtomHybridization>& hybridizations() const
+    {
+      return m_hybridizations;
+    }
+    const Array<signed char>& formalCharges() const
+    {
+      return m_formalCharges;
+    }
+    /** @} */
+
+    /** The per bond arrays, see the Molecule functions of the same name. @{ */
+    const Array<std::pair<Index, Index> >& bondPairs() const
+    {
+      return m_bondPairs;
+    }
+    const Array<unsigned char>& bondOrders() const { return m_bondOrders; }
+    /** @} */
+
+  private:
+    Array<unsigned char> m_atomicNumbers;
+    Array<Vector2> m_positions2d;
+    Array<Vector3> m_positions3d;
+    Array<AtomHybridization> m_hybridizations;
+    Array<signed char> m_formalCharges;
+    Array<std::pair<Index, Index> > m_bondPairs;
+    Array<unsigned char> m_bondOrders;
+  };
+
+  /**
+   * Take a snapshot of the atoms and bonds of the molecule, which is safe to
+   * read from another thread while this molecule is modified.
+   * @sa Snapshot
+   */
+  Snapshot snapshot() const;
+
 protected:
   mutable Graph m_graph; // A transformation of the molecule to a graph.
   mutable bool m_graphDirty; // Should the graph be rebuilt before returning it?
+  // The indices of the bonds to each atom. Kept in step with m_bondPairs along
+  // with m_graph, and rebuilt with it when m_graphDirty is set.
+  mutable std::vector<std::vector<Index> > m_atomBonds;
   VariantMap m_data;
   CustomElementMap m_customElementMap;
   Array<unsigned char> m_atomicNumbers;
@@ -518,9 +663,22 @@ protected:
 
   BasisSet *m_basisSet;
   UnitCell *m_unitCell;
+  TrajectorySource *m_trajectorySource;
 
   /** Update the graph to correspond to the current molecule. */
   void updateGraph() const;
+
+  /**
+   * Add the bond at @p bondId in m_bondPairs to the graph and bond index. This
+   * is needed by code that appends to or modifies m_bondPairs directly.
+   */
+  void indexBond(Index bondId) const;
+
+  /**
+   * Remove the bond at @p bondId in m_bondPairs from the graph and bond index.
+   * This must be called before the bond's pair is modified or removed.
+   */
+  void unindexBond(Index bondId) const;
 };
 
 class AVOGADROCORE_EXPORT Atom : public AtomTemplate<Molecule>
@@ -675,6 +833,7 @@ inline std::pair<Index, Index> Molecule::bondPair(Index bondId) const
 inline bool Molecule::setBondPairs(const Array<std::pair<Index, Index> > &pairs)
 {
   if (pairs.size() == bondCount()) {
+    m_graphDirty = true;
     m_bondPairs = pairs;
     return true;
   }
@@ -685,7 +844,9 @@ inline bool Molecule::setBondPair(Index bondId,
                                   const std::pair<Index, Index> &pair)
 {
   if (bondId < bondCount()) {
+    unindexBond(bondId);
     m_bondPairs[bondId] = pair;
+    indexBond(bondId);
     return true;
   }
   return false;
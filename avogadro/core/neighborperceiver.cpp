@@ -0,0 +1,132 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2014 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "neighborperceiver.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Avogadro {
+namespace Core {
+
+NeighborPerceiver::NeighborPerceiver(const Array<Vector3> &points,
+                                     Real maxDistance)
+  : m_maxDistance(maxDistance), m_cellSize(maxDistance),
+    m_min(Vector3::Zero())
+{
+  m_cellCount[0] = m_cellCount[1] = m_cellCount[2] = 1;
+
+  const Index n = points.size();
+  if (n == 0) {
+    m_cellStart.resize(2, 0);
+    return;
+  }
+
+  // Find the bounding box of the points.
+  Vector3 max(points[0]);
+  m_min = points[0];
+  for (Index i = 1; i < n; ++i) {
+    m_min = m_min.cwiseMin(points[i]);
+    max = max.cwiseMax(points[i]);
+  }
+  Vector3 extent(max - m_min);
+
+  if (m_cellSize <= 0.0)
+    m_cellSize = 1.0;
+
+  // Sparse systems spread over a large volume would need far more cells than
+  // points, grow the cells so that we never allocate more than a few cells
+  // per point.
+  double cells[3];
+  for (int axis = 0; axis < 3; ++axis)
+    cells[axis] = std::floor(extent[axis] / m_cellSize) + 1.0;
+  const double maxCells = 4.0 * static_cast<double>(n) + 27.0;
+  double totalCells = cells[0] * cells[1] * cells[2];
+  while (totalCells > maxCells) {
+    m_cellSize *= std::max(1.1, std::pow(totalCells / maxCells, 1.0 / 3.0));
+    for (int axis = 0; axis < 3; ++axis)
+      cells[axis] = std::floor(extent[axis] / m_cellSize) + 1.0;
+    totalCells = cells[0] * cells[1] * cells[2];
+  }
+  for (int axis = 0; axis < 3; ++axis)
+    m_cellCount[axis] = static_cast<int>(cells[axis]);
+
+  // Counting sort of the points into the cells.
+  const Index cellTotal = static_cast<Index>(m_cellCount[0]) * m_cellCount[1]
+      * m_cellCount[2];
+  std::vector<Index> pointCell(n);
+  m_cellStart.assign(cellTotal + 1, 0);
+  for (Index i = 0; i < n; ++i) {
+    const Vector3 &p = points[i];
+    Index cell = (static_cast<Index>(cellCoordinate(p, 2)) * m_cellCount[1]
+        + cellCoordinate(p, 1)) * m_cellCount[0] + cellCoordinate(p, 0);
+    pointCell[i] = cell;
+    ++m_cellStart[cell + 1];
+  }
+  for (Index c = 0; c < cellTotal; ++c)
+    m_cellStart[c + 1] += m_cellStart[c];
+
+  m_cellPoints.resize(n);
+  std::vector<Index> fill(m_cellStart.begin(), m_cellStart.end() - 1);
+  for (Index i = 0; i < n; ++i)
+    m_cellPoints[fill[pointCell[i]]++] = i;
+}
+
+NeighborPerceiver::~NeighborPerceiver()
+{
+}
+
+void NeighborPerceiver::neighbors(const Vector3 &point,
+                                  std::vector<Index> &result) const
+{
+  if (m_cellPoints.empty())
+    return;
+
+  int lo[3];
+  int hi[3];
+  for (int axis = 0; axis < 3; ++axis) {
+    int c = cellCoordinate(point, axis);
+    lo[axis] = std::max(c - 1, 0);
+    hi[axis] = std::min(c + 1, m_cellCount[axis] - 1);
+  }
+
+  for (int z = lo[2]; z <= hi[2]; ++z) {
+    for (int y = lo[1]; y <= hi[1]; ++y) {
+      Index row = (static_cast<Index>(z) * m_cellCount[1] + y) * m_cellCount[0];
+      // The cells along x are contiguous, and so are their points.
+      std::vector<Index>::const_iterator begin =
+          m_cellPoints.begin() + m_cellStart[row + lo[0]];
+      std::vector<Index>::const_iterator end =
+          m_cellPoints.begin() + m_cellStart[row + hi[0] + 1];
+      result.insert(result.end(), begin, end);
+    }
+  }
+}
+
+int NeighborPerceiver::cellCoordinate(const Vector3 &point, int axis) const
+{
+  // Points outside of the bounding box are clamped to the outermost cells,
+  // which is still correct for the inclusive neighbor search.
+  double c = std::floor((point[axis] - m_min[axis]) / m_cellSize);
+  if (!(c > 0.0))
+    return 0;
+  if (c >= static_cast<double>(m_cellCount[axis] - 1))
+    return m_cellCount[axis] - 1;
+  return static_cast<int>(c);
+}
+
+} // end Core namespace
+} // end Avogadro namespace
@@ -0,0 +1,89 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2014 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_NEIGHBORPERCEIVER_H
+#define AVOGADRO_CORE_NEIGHBORPERCEIVER_H
+
+#include "avogadrocore.h"
+
+#include "array.h"
+#include "vector.h"
+
+#include <vector>
+
+namespace Avogadro {
+namespace Core {
+
+/**
+ * @class NeighborPerceiver neighborperceiver.h
+ * <avogadro/core/neighborperceiver.h>
+ * @brief The NeighborPerceiver class provides a uniform grid (cell list) for
+ * finding points that lie close to each other.
+ *
+ * The points are binned into cubic cells with an edge length of at least
+ * @a maxDistance when the perceiver is constructed. Any point closer than
+ * @a maxDistance to a query position is then guaranteed to lie in one of the
+ * 27 cells surrounding that position, so a query only visits a handful of
+ * candidates rather than every point. The neighbors returned are inclusive:
+ * the caller is expected to perform the exact distance test.
+ */
+class AVOGADROCORE_EXPORT NeighborPerceiver
+{
+public:
+  /**
+   * Bin @a points into cells suitable for queries up to @a maxDistance.
+   * @note No reference to @a points is kept, only the index of each point in
+   * the cell it fell into. Points moved later are still found in their old
+   * cells, so build a new perceiver after moving them.
+   */
+  NeighborPerceiver(const Array<Vector3> &points, Real maxDistance);
+  ~NeighborPerceiver();
+
+  /**
+   * Append the indices of all points in the cells surrounding @a point to
+   * @a neighbors. The result contains every point within maxDistance() of
+   * @a point, as well as some points that are further away. The indices are
+   * not sorted.
+   */
+  void neighbors(const Vector3 &point, std::vector<Index> &neighbors) const;
+
+  /** @return The distance the perceiver was built for. */
+  Real maxDistance() const { return m_maxDistance; }
+
+  /** @return The edge length of a cell, never less than maxDistance(). */
+  Real cellSize() const { return m_cellSize; }
+
+  /** @return The number of points binned by the perceiver. */
+  Index pointCount() const { return m_cellPoints.size(); }
+
+private:
+  /** Compute the (clamped) cell coordinate of @a point along @a axis. */
+  int cellCoordinate(const Vector3 &point, int axis) const;
+
+  Real m_maxDistance;
+  Real m_cellSize;
+  Vector3 m_min;
+  int m_cellCount[3];
+  // The points in cell c are m_cellPoints[m_cellStart[c]] up to (but not
+  // including) m_cellPoints[m_cellStart[c + 1]].
+  std::vector<Index> m_cellStart;
+  std::vector<Index> m_cellPoints;
+};
+
+} // end Core namespace
+} // end Avogadro namespace
+
+#endif // AVOGADRO_CORE_NEIGHBORPERCEIVER_H
@@ -0,0 +1,109 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2014 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "readwritelock.h"
+
+#include <avogadro/stl/mutex_p.h>
+
+namespace Avogadro {
+namespace Core {
+
+using Stl::condition_variable;
+using Stl::mutex;
+using Stl::unique_lock;
+
+class ReadWriteLock::PIMPL
+{
+public:
+  PIMPL() : readers(0), writer(false), waitingWriters(0)
+  {
+  }
+
+  mutex lock;
+  condition_variable readersDone;
+  condition_variable writerDone;
+  int readers;
+  bool writer;
+  int waitingWriters;
+};
+
+ReadWriteLock::ReadWriteLock() : d(new PIMPL)
+{
+}
+
+ReadWriteLock::~ReadWriteLock()
+{
+  delete d;
+}
+
+void ReadWriteLock::lockForRead()
+{
+  unique_lock guard(d->lock);
+  while (d->writer || d->waitingWriters > 0)
+    d->writerDone.wait(guard);
+  ++d->readers;
+}
+
+bool ReadWriteLock::tryLockForRead()
+{
+  unique_lock guard(d->lock);
+  if (d->writer || d->waitingWriters > 0)
+    return false;
+  ++d->readers;
+  return true;
+}
+
+void ReadWriteLock::lockForWrite()
+{
+  unique_lock guard(d->lock);
+  ++d->waitingWriters;
+  while (d->writer || d->readers > 0)
+    d->readersDone.wait(guard);
+  --d->waitingWriters;
+  d->writer = true;
+}
+
+bool ReadWriteLock::tryLockForWrite()
+{
+  unique_lock guard(d->lock);
+  if (d->writer || d->readers > 0)
+    return false;
+  d->writer = true;
+  return true;
+}
+
+void ReadWriteLock::unlock()
+{
+  unique_lock guard(d->lock);
+  if (d->writer) {
+    d->writer = false;
+  }
+  else if (d->readers > 0) {
+    if (--d->readers > 0)
+      return;
+  }
+  else {
+    return;
+  }
+  // Waiting writers take precedence, the readers are woken up too as they
+  // may be admitted once no writer is waiting any more.
+  if (d->waitingWriters > 0)
+    d->readersDone.notify_one();
+  d->writerDone.notify_all();
+}
+
+}
+}
@@ -0,0 +1,82 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2014 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_READWRITELOCK_H
+#define AVOGADRO_CORE_READWRITELOCK_H
+
+#include "avogadrocore.h"
+
+namespace Avogadro {
+namespace Core {
+
+/**
+ * @class ReadWriteLock readwritelock.h <avogadro/core/readwritelock.h>
+ * @brief The ReadWriteLock class provides a lock that can be shared by any
+ * number of readers, or held exclusively by a single writer.
+ *
+ * It is built on the same C++11 (or Boost fallback) mutex as the Mutex class.
+ * Readers are not admitted while a writer is waiting, so a steady stream of
+ * readers cannot starve the writers. The lock is not recursive.
+ */
+
+class AVOGADROCORE_EXPORT ReadWriteLock
+{
+public:
+  ReadWriteLock();
+  ~ReadWriteLock();
+
+  /**
+   * @brief Obtain a shared lock for reading, blocking while a writer holds or
+   * is waiting for the lock.
+   */
+  void lockForRead();
+
+  /**
+   * @brief Attempt to obtain a shared lock for reading.
+   * @return True on success, false on failure.
+   */
+  bool tryLockForRead();
+
+  /**
+   * @brief Obtain an exclusive lock for writing, blocking until all readers
+   * and writers have released the lock.
+   */
+  void lockForWrite();
+
+  /**
+   * @brief Attempt to obtain an exclusive lock for writing.
+   * @return True on success, false on failure.
+   */
+  bool tryLockForWrite();
+
+  /**
+   * @brief Releases the lock, whether it was obtained for reading or writing.
+   */
+  void unlock();
+
+private:
+  // Not copyable.
+  ReadWriteLock(const ReadWriteLock &);
+  ReadWriteLock & operator=(const ReadWriteLock &);
+
+  class PIMPL;
+  PIMPL *d;
+};
+
+}
+}
+
+#endif // AVOGADRO_CORE_READWRITELOCK_H
@@ -21,7 +21,7 @@
 #include <set>
 #include <limits>
 #include <vector>
-#include <cstring>
+#include <utility>
 #include <iterator>
 #include <algorithm>
 
@@ -30,173 +30,206 @@ namespace Core {
 
 namespace {
 
-// === DistanceMatrix ====================================================== //
-class DistanceMatrix
+// === RingSystem ========================================================== //
+// A biconnected component of the molecular graph with more than one edge, all
+// of the rings in a molecule lie within one of these. The vertices are indexed
+// locally, atoms maps them back to the molecular graph.
+class RingSystem
 {
 public:
   // construction and destruction
-  DistanceMatrix(size_t size);
-  ~DistanceMatrix();
+  RingSystem(const Graph &graph, std::vector<size_t> &atoms);
 
-  // operators
-  size_t operator()(size_t i, size_t j) const;
-  size_t& operator()(size_t i, size_t j);
-
-private:
-  size_t m_size;
-  size_t *m_values;
-};
-
-DistanceMatrix::DistanceMatrix(size_t size)
-{
-  m_size = size;
-  m_values = new size_t[size*size];
-  memset(m_values, 0, size*size*sizeof(size_t));
-}
-
-DistanceMatrix::~DistanceMatrix()
-{
-  delete [] m_values;
-}
-
-size_t DistanceMatrix::operator()(size_t i, size_t j) const
-{
-  return m_values[i * m_size + j];
-}
-
-size_t& DistanceMatrix::operator()(size_t i, size_t j)
-{
-  return m_values[i * m_size + j];
-}
-
-// === PidMatrix =========================================================== //
-// The PidMatrix class implements a path-included distance matrix.
-class PidMatrix
-{
-public:
-  // construction and destruction
-  PidMatrix(size_t size);
-  ~PidMatrix();
-
-  // paths
-  std::vector<std::vector<size_t> >& paths(size_t i, size_t j);
-  void addPaths(size_t i, size_t j,
-                const std::vector<std::vector<size_t> > &paths);
-  std::vector<std::vector<size_t> > splice(size_t i, size_t j, size_t k);
-
-  // operators
-  std::vector<std::vector<size_t> >& operator()(size_t i, size_t j);
+  // properties
+  size_t size() const;
+  size_t ringCount() const;
+  size_t atom(size_t i) const;
+  const std::vector<size_t>& neighbors(size_t i) const;
 
 private:
-  size_t m_size;
-  std::vector<std::vector<size_t> > *m_values;
+  std::vector<size_t> m_atoms;
+  std::vector<std::vector<size_t> > m_neighbors;
+  size_t m_edgeCount;
 };
 
 // --- Construction and Destruction ---------------------------------------- //
-PidMatrix::PidMatrix(size_t size)
-{
-  m_size = size;
-  m_values = new std::vector<std::vector<size_t> >[size*size];
+RingSystem::RingSystem(const Graph &graph, std::vector<size_t> &atoms)
+  : m_edgeCount(0)
+{
+  std::sort(atoms.begin(), atoms.end());
+  atoms.erase(std::unique(atoms.begin(), atoms.end()), atoms.end());
+  m_atoms.swap(atoms);
+
+  // Any bond between two atoms of a biconnected component is part of it.
+  m_neighbors.resize(m_atoms.size());
+  for (size_t i = 0; i < m_atoms.size(); ++i) {
+    const std::vector<size_t> &neighbors = graph.neighbors(m_atoms[i]);
+    for (size_t j = 0; j < neighbors.size(); ++j) {
+      std::vector<size_t>::const_iterator iter =
+          std::lower_bound(m_atoms.begin(), m_atoms.end(), neighbors[j]);
+      if (iter != m_atoms.end() && *iter == neighbors[j]
+          && neighbors[j] != m_atoms[i]) {
+        m_neighbors[i].push_back(
+              static_cast<size_t>(iter - m_atoms.begin()));
+      }
+    }
+    m_edgeCount += m_neighbors[i].size();
+  }
+  m_edgeCount /= 2;
 }
 
-PidMatrix::~PidMatrix()
+// --- Properties ---------------------------------------------------------- //
+size_t RingSystem::size() const
 {
-  delete [] m_values;
+  return m_atoms.size();
 }
 
-// --- Paths --------------------------------------------------------------- //
-std::vector<std::vector<size_t> >& PidMatrix::paths(size_t i, size_t j)
+size_t RingSystem::ringCount() const
 {
-  return m_values[i * m_size + j];
+  return m_edgeCount + 1 - m_atoms.size();
 }
 
-void PidMatrix::addPaths(size_t i, size_t j, const std::vector<std::vector<size_t> > &p)
+size_t RingSystem::atom(size_t i) const
 {
-  std::vector<std::vector<size_t> > &current = m_values[i * m_size + j];
-  current.insert(current.end(), p.begin(), p.end());
+  return m_atoms[i];
 }
 
-std::vector<std::vector<size_t> >& PidMatrix::operator()(size_t i, size_t j)
+const std::vector<size_t>& RingSystem::neighbors(size_t i) const
 {
-  return paths(i, j);
+  return m_neighbors[i];
 }
 
-std::vector<std::vector<size_t> > PidMatrix::splice(size_t i, size_t j, size_t k)
+// Split the graph into its ring systems. Atoms that cannot be part of a ring
+// are pruned first, then the biconnected components are found with an
+// iterative version of Tarjan's algorithm.
+std::vector<RingSystem> ringSystems(const Graph &graph)
 {
-  std::vector<std::vector<size_t> > splicedPaths;
-
-  std::vector<std::vector<size_t> > ijPaths = paths(i, j);
-  std::vector<std::vector<size_t> > jkPaths = paths(j, k);
+  const size_t n = graph.size();
+  const size_t none = std::numeric_limits<size_t>::max();
+  std::vector<RingSystem> systems;
 
-  if (ijPaths.empty() && jkPaths.empty()) {
-    std::vector<size_t> path;
-    path.push_back(j);
-    splicedPaths.push_back(path);
-  }
-  else if (ijPaths.empty()) {
-    for (std::vector<std::vector<size_t> >::iterator iter = jkPaths.begin();
-         iter != jkPaths.end();
-         ++iter) {
-      std::vector<size_t> path;
-      path.push_back(j);
-      path.insert(path.end(), iter->begin(), iter->end());
-      splicedPaths.push_back(path);
-    }
+  // Repeatedly remove atoms with less than two neighbors, what is left are the
+  // rings and the chains connecting them.
+  std::vector<size_t> degree(n, 0);
+  std::vector<size_t> pruned;
+  for (size_t i = 0; i < n; ++i) {
+    const std::vector<size_t> &neighbors = graph.neighbors(i);
+    for (size_t j = 0; j < neighbors.size(); ++j)
+      if (neighbors[j] != i)
+        ++degree[i];
+    if (degree[i] < 2)
+      pruned.push_back(i);
   }
-  else if (jkPaths.empty()) {
-    for (std::vector<std::vector<size_t> >::iterator iter = ijPaths.begin();
-         iter != ijPaths.end();
-         ++iter) {
-      std::vector<size_t> path = *iter;
-      path.push_back(j);
-      splicedPaths.push_back(path);
+  std::vector<bool> removed(n, false);
+  while (!pruned.empty()) {
+    size_t i = pruned.back();
+    pruned.pop_back();
+    removed[i] = true;
+    const std::vector<size_t> &neighbors = graph.neighbors(i);
+    for (size_t j = 0; j < neighbors.size(); ++j) {
+      size_t k = neighbors[j];
+      if (!removed[k] && k != i && --degree[k] == 1)
+        pruned.push_back(k);
     }
   }
-  else {
-    for (std::vector<std::vector<size_t> >::iterator ijIter = ijPaths.begin();
-         ijIter != ijPaths.end();
-         ++ijIter) {
-      for (std::vector<std::vector<size_t> >::iterator jkIter = jkPaths.begin();
-           jkIter != jkPaths.end();
-           ++jkIter) {
-        std::vector<size_t> path = *ijIter;
-        path.push_back(j);
-        path.insert(path.end(), jkIter->begin(), jkIter->end());
-        splicedPaths.push_back(path);
+
+  std::vector<size_t> index(n, none);
+  std::vector<size_t> low(n, none);
+  size_t counter = 0;
+  std::vector<std::pair<size_t, size_t> > edges;
+  // Depth first search stack of (vertex, next neighbor to visit) pairs.
+  std::vector<std::pair<size_t, size_t> > stack;
+  std::vector<size_t> atoms;
+  for (size_t root = 0; root < n; ++root) {
+    if (removed[root] || index[root] != none)
+      continue;
+    index[root] = low[root] = counter++;
+    stack.push_back(std::make_pair(root, static_cast<size_t>(0)));
+    while (!stack.empty()) {
+      size_t v = stack.back().first;
+      const std::vector<size_t> &neighbors = graph.neighbors(v);
+      if (stack.back().second < neighbors.size()) {
+        size_t w = neighbors[stack.back().second++];
+        if (removed[w] || w == v)
+          continue;
+        if (index[w] == none) {
+          edges.push_back(std::make_pair(v, w));
+          index[w] = low[w] = counter++;
+          stack.push_back(std::make_pair(w, static_cast<size_t>(0)));
+        }
+        else if (index[w] < index[v]
+                 && !(stack.size() > 1 && stack[stack.size() - 2].first == w)) {
+          // A back edge to an ancestor other than the parent.
+          edges.push_back(std::make_pair(v, w));
+          low[v] = std::min(low[v], index[w]);
+        }
+        continue;
+      }
+
+      stack.pop_back();
+      if (stack.empty())
+        break;
+      size_t parent = stack.back().first;
+      low[parent] = std::min(low[parent], low[v]);
+      if (low[v] >= index[parent]) {
+        // The parent is an articulation point (or the root), the edges above
+        // the tree edge to v form a biconnected component.
+        atoms.clear();
+        size_t edgeCount = 0;
+        std::pair<size_t, size_t> edge;
+        do {
+          edge = edges.back();
+          edges.pop_back();
+          atoms.push_back(edge.first);
+          atoms.push_back(edge.second);
+          ++edgeCount;
+        } while (edge.first != parent || edge.second != v);
+        // A single bond between two ring systems is not a ring.
+        if (edgeCount > 1)
+          systems.push_back(RingSystem(graph, atoms));
       }
     }
   }
 
-  return splicedPaths;
+  return systems;
 }
 
 // === RingCandidate ======================================================= //
+// A cycle of the ring system made from the breadth first search tree of its
+// root, the tree paths from the root to the two atoms of a bond not in the
+// tree, joined by that bond. Only the atoms up to the root are searched, so
+// each ring is found from its highest atom rather than once from each of its
+// atoms. These cycles contain a smallest set of smallest rings (Horton,
+// Vismara) while only one path is kept for each pair of atoms.
 class RingCandidate
 {
 public:
   // construction and destruction
-  RingCandidate(size_t n, size_t s, size_t e);
+  RingCandidate(size_t n, size_t r, size_t a, size_t b);
 
   // properties
   size_t size() const;
-  size_t start() const;
-  size_t end() const;
+  size_t root() const;
+  size_t first() const;
+  size_t second() const;
 
   // static methods
   static bool compareSize(const RingCandidate &a, const RingCandidate &b);
 
 private:
   size_t m_size;
-  size_t m_start;
-  size_t m_end;
+  size_t m_root;
+  size_t m_first;
+  size_t m_second;
 };
 
 // --- Construction and Destruction ---------------------------------------- //
-RingCandidate::RingCandidate(size_t n, size_t s, size_t e)
+RingCandidate::RingCandidate(size_t n, size_t r, size_t a, size_t b)
 {
   m_size = n;
-  m_start = s;
-  m_end = e;
+  m_root = r;
+  m_first = a;
+  m_second = b;
 }
 
 // --- Properties ---------------------------------------------------------- //
@@ -205,14 +238,19 @@ size_t RingCandidate::size() const
   return m_size;
 }
 
-size_t RingCandidate::start() const
+size_t RingCandidate::root() const
 {
-  return m_start;
+  return m_root;
 }
 
-size_t RingCandidate::end() const
+size_t RingCandidate::first() const
 {
-  return m_end;
+  return m_first;
+}
+
+size_t RingCandidate::second() const
+{
+  return m_second;
 }
 
 // --- Static Methods ------------------------------------------------------ //
@@ -221,6 +259,79 @@ bool RingCandidate::compareSize(const RingCandidate &a, const RingCandidate &b)
   return a.size() < b.size();
 }
 
+// Breadth first search from each atom of the ring system over the atoms with
+// a lower index, recording the parent of each atom in the search tree. Every
+// bond that closes a simple cycle through the root becomes a ring candidate.
+std::vector<RingCandidate> ringCandidates(
+    const RingSystem &system, std::vector<std::vector<size_t> > &parents)
+{
+  const size_t n = system.size();
+  const size_t none = std::numeric_limits<size_t>::max();
+  std::vector<RingCandidate> candidates;
+
+  parents.resize(n);
+  std::vector<size_t> distance(n);
+  // The child of the root each atom was reached through, two tree paths only
+  // form a simple cycle when they leave the root through different atoms.
+  std::vector<size_t> branch(n);
+  std::vector<size_t> queue;
+  queue.reserve(n);
+  for (size_t r = 0; r < n; ++r) {
+    std::vector<size_t> &parent = parents[r];
+    parent.assign(r + 1, none);
+    std::fill(distance.begin(), distance.begin() + r + 1, none);
+    distance[r] = 0;
+    branch[r] = r;
+    queue.assign(1, r);
+    for (size_t q = 0; q < queue.size(); ++q) {
+      size_t v = queue[q];
+      const std::vector<size_t> &neighbors = system.neighbors(v);
+      for (size_t k = 0; k < neighbors.size(); ++k) {
+        size_t w = neighbors[k];
+        if (w > r || distance[w] != none)
+          continue;
+        distance[w] = distance[v] + 1;
+        parent[w] = v;
+        branch[w] = v == r ? w : branch[v];
+        queue.push_back(w);
+      }
+    }
+
+    // Bonds between atoms at the same distance close odd rings, those to the
+    // next layer that are not tree bonds close even rings.
+    for (size_t q = 0; q < queue.size(); ++q) {
+      size_t v = queue[q];
+      const std::vector<size_t> &neighbors = system.neighbors(v);
+      for (size_t k = 0; k < neighbors.size(); ++k) {
+        size_t w = neighbors[k];
+        if (w > r || branch[v] == branch[w])
+          continue;
+        if ((distance[w] == distance[v] && v < w)
+            || (distance[w] == distance[v] + 1 && parent[w] != v)) {
+          candidates.push_back(
+                RingCandidate(distance[v] + distance[w] + 1, r, v, w));
+        }
+      }
+    }
+  }
+
+  return candidates;
+}
+
+// Build the ring of a candidate, from the root along the tree path to the
+// first atom, then back from the second atom to the root.
+void candidateRing(const RingCandidate &candidate,
+                   const std::vector<size_t> &parent, std::vector<size_t> &ring)
+{
+  ring.clear();
+  for (size_t v = candidate.first(); v != candidate.root(); v = parent[v])
+    ring.push_back(v);
+  ring.push_back(candidate.root());
+  std::reverse(ring.begin(), ring.end());
+  for (size_t v = candidate.second(); v != candidate.root(); v = parent[v])
+    ring.push_back(v);
+}
+
 // === Sssr ================================================================ //
 class Sssr
 {
@@ -334,7 +445,7 @@ bool Sssr::isUnique(const std::vector<size_t> &path) const
     if (ring.size() >= path.size())
       continue;
 
-    for (size_t i = 0; i < ring.size(); i++) {
+    for (size_t i = 0; i < ring.size()-1; i++) {
       pathBonds.erase(std::make_pair(std::min(ring[i], ring[i+1]),
                                      std::max(ring[i], ring[i+1])));
     }
@@ -374,134 +485,63 @@ bool Sssr::isUnique(const std::vector<size_t> &path) const
   return true;
 }
 
-std::vector<std::vector<size_t> > perceiveRings(const Graph &graph)
+// Find the sssr of a single ring system from its ring candidates.
+void perceiveRings(const RingSystem &system,
+                   std::vector<std::vector<size_t> > &rings)
 {
-  size_t n = graph.size();
-
-  size_t ringCount = graph.vertexCount() - graph.edgeCount() + 1;
+  const size_t ringCount = system.ringCount();
   if (ringCount == 0)
-    return std::vector<std::vector<size_t> >();
-
-  // Algorithm 1 - create the distance and pid matrices.
-  DistanceMatrix D(n);
-  PidMatrix P(n);
-  PidMatrix Pt(n);
-
-  for (size_t i = 0; i < n; ++i) {
-    for (size_t j = 0; j < n; ++j) {
-      if (i == j)
-        D(i, j) = 0;
-      else if (graph.containsEdge(i, j))
-        D(i, j) = 1;
-      else
-        D(i, j) = std::numeric_limits<size_t>::max() / 2; // ~ infinity
-    }
-  }
-
-  for (size_t k = 0; k < n; ++k) {
-    for (size_t i = 0; i < n; ++i) {
-      for (size_t j = 0; j < n; ++j) {
-        if (i == j || i == k || k == j)
-          continue;
-
-        if (D(i, j) > D(i, k) + D(k, j)) {
-          if (D(i, j) == D(i, k) + D(k, j) + 1)
-            Pt(i, j) = P(i, j);
-          else
-            Pt(i, j).clear();
-
-          D(i, j) = D(i, k) + D(k, j);
-          P(i, j) = P.splice(i, k, j);
-        }
-        else if (D(i, j) == D(i, k) + D(k, j)) {
-          P.addPaths(i, j, P.splice(i, k, j));
-        }
-        else if (D(i, j) == D(i, k) + D(k, j) - 1) {
-          Pt.addPaths(i, j, P.splice(i, k, j));
-        }
-      }
-    }
-  }
+    return;
 
-  // Algorithm 2 - create the ring candidate set.
-  std::vector<RingCandidate> candidates;
-  for (size_t i = 0; i < n; i++) {
-    for (size_t j = i + 1; j < n; j++) {
-      if (P(i, j).size() == 1 && Pt(i, j).size() == 0) {
-        continue;
-      }
-      else {
-        size_t size;
+  // Sort the candidates, keeping the order of equally sized candidates.
+  std::vector<std::vector<size_t> > parents;
+  std::vector<RingCandidate> candidates = ringCandidates(system, parents);
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   RingCandidate::compareSize);
 
-        if (P(i, j).size() > 1)
-          size = 2 * D(i, j);
-        else
-          size = 2 * D(i, j) + 1;
-
-        if (size > 2)
-          candidates.push_back(RingCandidate(size, i, j));
-      }
-    }
-  }
-
-  // Sort the candidates.
-  std::sort(candidates.begin(), candidates.end(), RingCandidate::compareSize);
-
-  // Algorithm 3 - find sssr from the ring candidate set.
+  // Find sssr from the ring candidate set.
   Sssr sssr;
+  std::vector<size_t> ring;
 
-  for (std::vector<RingCandidate>::iterator iter = candidates.begin();
+  for (std::vector<RingCandidate>::const_iterator iter = candidates.begin();
        iter != candidates.end();
        ++iter) {
-    const RingCandidate &candidate = *iter;
-
-    // odd sized ring
-    if (candidate.size() & 1) {
-      for (size_t i = 0; i < Pt(candidate.start(), candidate.end()).size();
-           ++i) {
-        std::vector<size_t> ring;
-        ring.push_back(candidate.start());
-        std::vector<size_t> &path = Pt(candidate.start(), candidate.end())[i];
-        ring.insert(ring.end(), path.begin(), path.end());
-        ring.push_back(candidate.end());
-        if (!P(candidate.end(), candidate.start()).empty()) {
-          path = P(candidate.end(), candidate.start())[0];
-          ring.insert(ring.end(), path.begin(), path.end());
-        }
-
-        // Check if ring is valid and unique.
-        if (sssr.isValid(ring) && sssr.isUnique(ring)) {
-          sssr.append(ring);
-          break;
-        }
-      }
-    }
+    candidateRing(*iter, parents[iter->root()], ring);
 
-    // Even sized ring.
-    else {
-      for (size_t i = 0; i < P(candidate.start(), candidate.end()).size() - 1;
-           ++i) {
-        std::vector<size_t> ring;
-        ring.push_back(candidate.start());
-        std::vector<size_t> &path = P(candidate.start(), candidate.end())[i];
-        ring.insert(ring.end(), path.begin(), path.end());
-        ring.push_back(candidate.end());
-        path = P(candidate.end(), candidate.start())[i+1];
-        ring.insert(ring.end(), path.begin(), path.end());
-
-        // check if ring is valid and unique
-        if (sssr.isValid(ring) && sssr.isUnique(ring)) {
-          sssr.append(ring);
-          break;
-        }
-      }
+    // Check if ring is valid and unique.
+    if (sssr.isValid(ring) && sssr.isUnique(ring)) {
+      sssr.append(ring);
+      if (sssr.size() == ringCount)
+        break;
     }
+  }
 
-    if (sssr.size() == ringCount)
-      break;
+  // Map the rings back to the atoms of the molecule.
+  for (size_t i = 0; i < sssr.size(); ++i) {
+    rings.push_back(sssr.rings()[i]);
+    std::vector<size_t> &atoms = rings.back();
+    for (size_t j = 0; j < atoms.size(); ++j)
+      atoms[j] = system.atom(atoms[j]);
   }
+}
+
+bool compareRingSize(const std::vector<size_t> &a,
+                     const std::vector<size_t> &b)
+{
+  return a.size() < b.size();
+}
+
+std::vector<std::vector<size_t> > perceiveRings(const Graph &graph)
+{
+  // Rings are perceived independently in each ring system, so the cost only
+  // depends on the size of the ring systems rather than the whole molecule.
+  std::vector<std::vector<size_t> > rings;
+  std::vector<RingSystem> systems = ringSystems(graph);
+  for (size_t i = 0; i < systems.size(); ++i)
+    perceiveRings(systems[i], rings);
 
-  return sssr.rings();
+  std::stable_sort(rings.begin(), rings.end(), compareRingSize);
+  return rings;
 }
 
 } // end anonymous namespace
@@ -0,0 +1,239 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2014 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "stringview.h"
+
+#include <limits>
+#include <locale>
+#include <sstream>
+
+namespace Avogadro {
+namespace Core {
+
+namespace {
+// The powers of ten that are exactly representable as doubles.
+const double exactPowersOfTen[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13,
+  1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+const int maxExactPowerOfTen = 22;
+
+// Integers up to 2^53 are exactly representable as doubles.
+const unsigned long long maxExactMantissa = 9007199254740992ULL;
+
+// The most significant digits that are accumulated in the mantissa.
+const int maxMantissaDigits = 19;
+
+inline bool isDigit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+const char * skipSpace(const char *p, const char *end)
+{
+  while (p != end && StringView::isSpace(*p))
+    ++p;
+  return p;
+}
+
+// Parse a number using the standard library in the C locale, converting any
+// Fortran exponent to one the standard library understands.
+bool parseWithStream(const char *begin, const char *end, double &value)
+{
+  std::string number(begin, end);
+  for (size_t i = 0; i < number.size(); ++i) {
+    if (number[i] == 'd' || number[i] == 'D')
+      number[i] = 'e';
+  }
+  std::istringstream stream(number);
+  stream.imbue(std::locale::classic());
+  stream >> value;
+  return !stream.fail();
+}
+
+bool parseReal(const StringView &string, double &value)
+{
+  const char *end = string.end();
+  const char *p = skipSpace(string.begin(), end);
+  const char *start = p;
+
+  bool negative = false;
+  if (p != end && (*p == '-' || *p == '+'))
+    negative = *p++ == '-';
+
+  // Accumulate the digits into an integer mantissa, value = mantissa * 10^exp.
+  // Zeros are only added to the mantissa when followed by another digit, so
+  // that trailing zeros do not use up the available digits.
+  unsigned long long mantissa = 0;
+  int mantissaDigits = 0;
+  int pendingZeros = 0;
+  int exponent = 0;
+  bool truncated = false;
+  bool hasDigits = false;
+  bool fraction = false;
+  for (; p != end; ++p) {
+    if (*p == '.' && !fraction) {
+      fraction = true;
+      continue;
+    }
+    if (!isDigit(*p))
+      break;
+    hasDigits = true;
+    if (fraction)
+      --exponent;
+    if (*p == '0') {
+      ++pendingZeros;
+      continue;
+    }
+    if (mantissa == 0) {
+      pendingZeros = 0;
+    }
+    else if (mantissaDigits + pendingZeros >= maxMantissaDigits) {
+      truncated = true;
+      continue;
+    }
+    for (; pendingZeros > 0; --pendingZeros) {
+      mantissa *= 10;
+      ++mantissaDigits;
+    }
+    mantissa = mantissa * 10 + static_cast<unsigned long long>(*p - '0');
+    ++mantissaDigits;
+  }
+  if (!hasDigits)
+    return false;
+  if (mantissa != 0)
+    exponent += pendingZeros;
+
+  // An exponent is only consumed if it has digits.
+  if (p != end && (*p == 'e' || *p == 'E' || *p == 'd' || *p == 'D')) {
+    const char *q = p + 1;
+    bool negativeExponent = false;
+    if (q != end && (*q == '-' || *q == '+'))
+      negativeExponent = *q++ == '-';
+    if (q != end && isDigit(*q)) {
+      int exponentValue = 0;
+      for (; q != end && isDigit(*q); ++q) {
+        if (exponentValue < 100000)
+          exponentValue = exponentValue * 10 + (*q - '0');
+      }
+      exponent += negativeExponent ? -exponentValue : exponentValue;
+      p = q;
+    }
+  }
+
+  if (mantissa == 0 && !truncated) {
+    value = negative ? -0.0 : 0.0;
+    return true;
+  }
+
+  // Both the mantissa and the power of ten are exact, so there is only the
+  // one rounding of the final multiplication or division.
+  if (!truncated && mantissa <= maxExactMantissa
+      && exponent >= -maxExactPowerOfTen && exponent <= maxExactPowerOfTen) {
+    double result = static_cast<double>(mantissa);
+    if (exponent < 0)
+      result /= exactPowersOfTen[-exponent];
+    else
+      result *= exactPowersOfTen[exponent];
+    value = negative ? -result : result;
+    return true;
+  }
+
+  return parseWithStream(start, p, value);
+}
+
+template<typename T>
+bool parseInteger(const StringView &string, T &value)
+{
+  const char *end = string.end();
+  const char *p = skipSpace(string.begin(), end);
+
+  bool negative = false;
+  if (p != end && (*p == '-' || *p == '+'))
+    negative = *p++ == '-';
+  if (p == end || !isDigit(*p))
+    return false;
+
+  // Accumulate the magnitude, checking it against the range of the type. The
+  // magnitude of the most negative value is one more than the maximum.
+  unsigned long limit =
+      static_cast<unsigned long>(std::numeric_limits<T>::max());
+  if (negative)
+    limit = std::numeric_limits<T>::is_signed ? limit + 1 : 0;
+  unsigned long magnitude = 0;
+  for (; p != end && isDigit(*p); ++p) {
+    unsigned long digit = static_cast<unsigned long>(*p - '0');
+    if (magnitude > limit / 10
+        || (magnitude == limit / 10 && digit > limit % 10)) {
+      return false;
+    }
+    magnitude = magnitude * 10 + digit;
+  }
+
+  if (negative && magnitude > 0)
+    value = static_cast<T>(-static_cast<T>(magnitude - 1) - 1);
+  else
+    value = static_cast<T>(magnitude);
+  return true;
+}
+}
+
+bool parseValue(const StringView &string, double &value)
+{
+  return parseReal(string, value);
+}
+
+bool parseValue(const StringView &string, float &value)
+{
+  double result;
+  if (!parseReal(string, result))
+    return false;
+  value = static_cast<float>(result);
+  return true;
+}
+
+bool parseValue(const StringView &string, long &value)
+{
+  return parseInteger(string, value);
+}
+
+bool parseValue(const StringView &string, unsigned long &value)
+{
+  return parseInteger(string, value);
+}
+
+bool parseValue(const StringView &string, int &value)
+{
+  return parseInteger(string, value);
+}
+
+bool parseValue(const StringView &string, unsigned int &value)
+{
+  return parseInteger(string, value);
+}
+
+bool parseValue(const StringView &string, short &value)
+{
+  return parseInteger(string, value);
+}
+
+bool parseValue(const StringView &string, unsigned short &value)
+{
+  return parseInteger(string, value);
+}
+
+} // end Core namespace
+} // end Avogadro namespace
@@ -0,0 +1,168 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2014 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_STRINGVIEW_H
+#define AVOGADRO_CORE_STRINGVIEW_H
+
+#include "avogadrocore.h"
+
+#include <cstring>
+#include <ostream>
+#include <string>
+
+namespace Avogadro {
+namespace Core {
+
+/**
+ * @class StringView stringview.h <avogadro/core/stringview.h>
+ * @brief A read only view of a range of characters in a buffer.
+ *
+ * StringView does not own or copy the characters it refers to, the buffer
+ * (typically a std::string holding the line being parsed) must outlive it and
+ * must not be modified while it is in use. It is used to split lines into
+ * fields and parse numbers from them without allocating memory, see split()
+ * and lexicalCast() in utilities.h.
+ */
+
+class StringView
+{
+public:
+  static const size_t npos = static_cast<size_t>(-1);
+
+  StringView() : m_data(NULL), m_size(0) {}
+  StringView(const char *data_, size_t size_) : m_data(data_), m_size(size_)
+  {
+  }
+  StringView(const std::string &string)
+    : m_data(string.data()), m_size(string.size())
+  {
+  }
+  explicit StringView(const char *string)
+    : m_data(string), m_size(string ? std::strlen(string) : 0)
+  {
+  }
+
+  const char * data() const { return m_data; }
+  const char * begin() const { return m_data; }
+  const char * end() const { return m_data + m_size; }
+  size_t size() const { return m_size; }
+  size_t length() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+  char operator[](size_t i) const { return m_data[i]; }
+
+  /**
+   * @return A view of at most @p n characters starting at @p pos. Unlike
+   * std::string::substr() a @p pos past the end gives an empty view.
+   */
+  StringView substr(size_t pos, size_t n = npos) const
+  {
+    if (pos >= m_size)
+      return StringView(end(), 0);
+    return StringView(m_data + pos, n < m_size - pos ? n : m_size - pos);
+  }
+
+  /**
+   * @return The view with any white space removed from the left and right.
+   */
+  StringView trimmed() const
+  {
+    const char *first = begin();
+    const char *last = end();
+    while (first != last && isSpace(*first))
+      ++first;
+    while (last != first && isSpace(*(last - 1)))
+      --last;
+    return StringView(first, static_cast<size_t>(last - first));
+  }
+
+  /**
+   * @return A copy of the characters in a std::string.
+   */
+  std::string str() const { return std::string(m_data, m_size); }
+
+  /**
+   * @return True if @p c is a space, tab, new line or carriage return.
+   */
+  static bool isSpace(char c)
+  {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v'
+        || c == '\f';
+  }
+
+private:
+  const char *m_data;
+  size_t m_size;
+};
+
+inline bool operator==(const StringView &a, const StringView &b)
+{
+  return a.size() == b.size()
+      && (a.size() == 0 || std::memcmp(a.data(), b.data(), a.size()) == 0);
+}
+
+inline bool operator==(const StringView &a, const char *b)
+{
+  return a == StringView(b);
+}
+
+inline bool operator!=(const StringView &a, const StringView &b)
+{
+  return !(a == b);
+}
+
+inline bool operator!=(const StringView &a, const char *b)
+{
+  return !(a == StringView(b));
+}
+
+inline std::ostream & operator<<(std::ostream &out, const StringView &string)
+{
+  return out.write(string.data(), static_cast<std::streamsize>(string.size()));
+}
+
+/**
+ * @brief Parse a number at the start of @p string, ignoring leading white
+ * space and any characters following the number (as a stream would).
+ *
+ * The floating point parsers are independent of the locale, and also accept
+ * the Fortran D exponent (1.0D-03). Up to 19 significant digits are collected
+ * into an integer mantissa. When the mantissa is at most 2^53 and the decimal
+ * exponent is within +/-22, both are exact doubles and the number is converted
+ * with a single correctly rounded multiplication or division. This covers
+ * nearly all numbers found in chemical file formats, others fall back to the
+ * standard library in the C locale.
+ * @param string The characters to parse.
+ * @param value Set to the parsed value on success.
+ * @return True if a number was parsed, false otherwise.
+ * @{
+ */
+AVOGADROCORE_EXPORT bool parseValue(const StringView &string, double &value);
+AVOGADROCORE_EXPORT bool parseValue(const StringView &string, float &value);
+AVOGADROCORE_EXPORT bool parseValue(const StringView &string, long &value);
+AVOGADROCORE_EXPORT bool parseValue(const StringView &string,
+                                    unsigned long &value);
+AVOGADROCORE_EXPORT bool parseValue(const StringView &string, int &value);
+AVOGADROCORE_EXPORT bool parseValue(const StringView &string,
+                                    unsigned int &value);
+AVOGADROCORE_EXPORT bool parseValue(const StringView &string, short &value);
+AVOGADROCORE_EXPORT bool parseValue(const StringView &string,
+                                    unsigned short &value);
+/** @} */
+
+} // end Core namespace
+} // end Avogadro namespace
+
+#endif // AVOGADRO_CORE_STRINGVIEW_H
@@ -0,0 +1,76 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2014 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef AVOGADRO_CORE_TRAJECTORYSOURCE_H
+#define AVOGADRO_CORE_TRAJECTORYSOURCE_H
+
+#include "avogadrocore.h"
+
+#include "array.h"
+#include "vector.h"
+
+#include <cstddef>
+
+namespace Avogadro {
+namespace Core {
+
+/**
+ * @class TrajectorySource trajectorysource.h
+ * <avogadro/core/trajectorysource.h>
+ * @brief Interface for coordinate sets that are loaded on demand.
+ *
+ * Long trajectories do not fit in memory, file formats can instead index the
+ * frames of a trajectory and give the Molecule a TrajectorySource that reads
+ * the atom positions of a frame when Molecule::setCoordinate3d(int) is called.
+ */
+
+class AVOGADROCORE_EXPORT TrajectorySource
+{
+public:
+  /**
+   * Constructor.
+   */
+  TrajectorySource() {}
+
+  /**
+   * Destructor.
+   */
+  virtual ~TrajectorySource() {}
+
+  /**
+   * Create a copy of the source, used when the Molecule is copied. Ownership
+   * passes to the caller.
+   */
+  virtual TrajectorySource * clone() const = 0;
+
+  /**
+   * @return The number of frames in the trajectory.
+   */
+  virtual size_t frameCount() const = 0;
+
+  /**
+   * Read the atom positions of a frame.
+   * @param frame The index of the frame, from 0 to frameCount() - 1.
+   * @param positions Set to the positions of the atoms in the frame.
+   * @return True on success, false if the frame could not be read.
+   */
+  virtual bool readFrame(size_t frame, Array<Vector3> &positions) = 0;
+};
+
+} // end Core namespace
+} // end Avogadro namespace
+
+#endif // AVOGADRO_CORE_TRAJECTORYSOURCE_H
@@ -17,6 +17,8 @@
 #ifndef AVOGADRO_CORE_UTILITIES_H
 #define AVOGADRO_CORE_UTILITIES_H
 
+#include "stringview.h"
+
 #include <string>
 #include <vector>
 #include <sstream>
@@ -45,6 +47,32 @@ inline std::vector<std::string> split(const std::string &string, char delimiter,
   return elements;
 }
 
+/**
+ * @brief Split the supplied @p string by the @p delimiter without copying,
+ * the fields are views of the characters in @p string.
+ * @param string The string to be split up.
+ * @param delimiter The delimiter to split the string by.
+ * @param fields Set to the items, reuse the vector when splitting many lines to
+ * avoid allocating memory.
+ * @param skipEmpty If true any empty items will be skipped.
+ */
+inline void split(const StringView &string, char delimiter,
+                  std::vector<StringView> &fields, bool skipEmpty = true)
+{
+  fields.clear();
+  const char *begin = string.begin();
+  const char *end = string.end();
+  while (begin != end) {
+    const char *item = begin;
+    while (begin != end && *begin != delimiter)
+      ++begin;
+    if (!skipEmpty || begin != item)
+      fields.push_back(StringView(item, static_cast<size_t>(begin - item)));
+    if (begin != end)
+      ++begin;
+  }
+}
+
 /**
  * @brief Search the input string for the search string.
  * @param input String to be examined.
@@ -81,14 +109,25 @@ inline std::string trimmed(const std::string &input)
   return input.substr(start, end - start + 1);
 }
 
+/**
+ * @brief Parse the start of @p string as the specified type using a stream,
+ * see stringview.h for the fast overloads used for numbers.
+ */
+template<typename T> bool parseValue(const StringView &string, T &value)
+{
+  std::istringstream stream(string.str());
+  stream >> value;
+  return !stream.fail();
+}
+
 /**
  * @brief Cast the inputString to the specified type.
  * @param inputString String to cast to the specified type.
  */
-template<typename T> T lexicalCast(const std::string &inputString)
+template<typename T> T lexicalCast(const StringView &inputString)
 {
-  T value;
-  std::istringstream(inputString) >> value;
+  T value = T();
+  parseValue(inputString, value);
   return value;
 }
 
@@ -98,15 +137,33 @@ template<typename T> T lexicalCast(const std::string &inputString)
  * @param ok Set to true on success, and false if the string could not be
  * converted to the specified type.
  */
-template<typename T> T lexicalCast(const std::string &inputString, bool &ok)
+template<typename T> T lexicalCast(const StringView &inputString, bool &ok)
 {
-  T value;
-  std::istringstream stream(inputString);
-  stream >> value;
-  ok = !stream.fail();
+  T value = T();
+  ok = parseValue(inputString, value);
   return value;
 }
 
+/**
+ * @brief Cast the inputString to the specified type.
+ * @param inputString String to cast to the specified type.
+ */
+template<typename T> T lexicalCast(const std::string &inputString)
+{
+  return lexicalCast<T>(StringView(inputString));
+}
+
+/**
+ * @brief Cast the inputString to the specified type.
+ * @param inputString String to cast to the specified type.
+ * @param ok Set to true on success, and false if the string could not be
+ * converted to the specified type.
+ */
+template<typename T> T lexicalCast(const std::string &inputString, bool &ok)
+{
+  return lexicalCast<T>(StringView(inputString), ok);
+}
+
 } // end Core namespace
 } // end Avogadro namespace
 
@@ -0,0 +1,955 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2014 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "binaryformat.h"
+
+#include <avogadro/core/cube.h>
+#include <avogadro/core/gaussianset.h>
+#include <avogadro/core/mesh.h>
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/trajectorysource.h>
+#include <avogadro/core/unitcell.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <list>
+#include <sstream>
+
+namespace Avogadro {
+namespace Io {
+
+using std::string;
+using std::vector;
+
+using Core::Array;
+using Core::AtomHybridization;
+using Core::BasisSet;
+using Core::Cube;
+using Core::GaussianSet;
+using Core::Mesh;
+using Core::Molecule;
+using Core::UnitCell;
+using Core::Variant;
+using Core::VariantMap;
+
+namespace {
+typedef unsigned int Uint32;
+typedef unsigned long long Uint64;
+
+const char fileMagic[8] = { '\x89', 'A', 'V', 'B', '\r', '\n', '\x1a', '\n' };
+
+// Written in the byte order of the machine, so that a file written with a
+// different byte order can be recognized.
+const Uint32 byteOrderMark = 0x01020304;
+
+// The header, and every block, starts on a multiple of this.
+const Uint64 blockAlignment = 64;
+
+// The types of the blocks, the values are stored in files and must not change.
+// Blocks are read in the order of their type, so those that others depend on
+// come first.
+enum BlockType {
+  AtomicNumbersBlock = 1,
+  Positions2dBlock = 2,
+  Positions3dBlock = 3,
+  HybridizationsBlock = 4,
+  FormalChargesBlock = 5,
+  BondPairsBlock = 6,
+  BondOrdersBlock = 7,
+  CoordinateSetsBlock = 8,
+  DataBlock = 9,
+  UnitCellBlock = 10,
+  CubeGridBlock = 20,
+  CubeValuesBlock = 21,
+  CubeNameBlock = 22,
+  MeshInfoBlock = 30,
+  MeshVerticesBlock = 31,
+  MeshNormalsBlock = 32,
+  MeshColorsBlock = 33,
+  MeshIndicesBlock = 34,
+  MeshNameBlock = 35,
+  BasisInfoBlock = 40,
+  BasisSymmetryBlock = 41,
+  BasisAtomIndicesBlock = 42,
+  BasisGtoIndicesBlock = 43,
+  BasisExponentsBlock = 44,
+  BasisCoefficientsBlock = 45,
+  MoCoefficientsBlock = 46,
+  DensityMatrixBlock = 47,
+  SpinDensityMatrixBlock = 48
+};
+
+struct Header
+{
+  char magic[8];
+  Uint32 version;
+  Uint32 byteOrder;
+  Uint64 blockCount;
+  Uint64 directoryOffset;
+  char reserved[32];
+};
+
+// An entry in the directory, the block holds count elements of elementSize
+// bytes. The index tells apart the blocks of each cube and mesh.
+struct BlockEntry
+{
+  Uint32 type;
+  Uint32 index;
+  Uint64 elementSize;
+  Uint64 count;
+  Uint64 offset;
+};
+
+struct CubeGrid
+{
+  double min[3];
+  double spacing[3];
+  Uint32 dimensions[3];
+  Uint32 cubeType;
+};
+
+struct MeshInfo
+{
+  float isoValue;
+  Uint32 otherMesh;
+  Uint32 cube;
+  Uint32 stable;
+};
+
+struct BasisInfo
+{
+  Uint32 electrons[2];
+  Uint32 scfType;
+  Uint32 reserved;
+};
+
+// The bond pairs are stored as pairs of 64 bit indices.
+const bool nativeBondPairs =
+    sizeof(std::pair<Index, Index>) == 2 * sizeof(Uint64);
+
+Uint64 aligned(Uint64 offset)
+{
+  return (offset + blockAlignment - 1) / blockAlignment * blockAlignment;
+}
+
+bool typeLess(const BlockEntry &a, const BlockEntry &b)
+{
+  return a.type < b.type;
+}
+
+// The block of @a type for the cube or mesh @a index, NULL if there is none.
+const BlockEntry * findBlock(const vector<BlockEntry> &entries, Uint32 type,
+                             Uint32 index)
+{
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (entries[i].type == type && entries[i].index == index)
+      return &entries[i];
+  }
+  return NULL;
+}
+
+/**
+ * Reads the frames of a trajectory straight from the coordinate set block of
+ * the file when they are set on the molecule.
+ */
+class BinaryTrajectory : public Core::TrajectorySource
+{
+public:
+  BinaryTrajectory(const string &fileName, size_t numAtoms, size_t frames,
+                   std::streamoff offset)
+    : m_fileName(fileName), m_numAtoms(numAtoms), m_frames(frames),
+      m_offset(offset)
+  {
+  }
+
+  Core::TrajectorySource * clone() const
+  {
+    return new BinaryTrajectory(m_fileName, m_numAtoms, m_frames, m_offset);
+  }
+
+  size_t frameCount() const { return m_frames; }
+
+  bool readFrame(size_t frame, Array<Vector3> &positions)
+  {
+    if (frame >= m_frames)
+      return false;
+    if (!m_file.is_open()) {
+      m_file.open(m_fileName.c_str(), std::ifstream::binary);
+      if (!m_file.is_open())
+        return false;
+    }
+    const std::streamoff frameSize =
+        static_cast<std::streamoff>(m_numAtoms * sizeof(Vector3));
+    m_file.clear();
+    m_file.seekg(m_offset + static_cast<std::streamoff>(frame) * frameSize);
+    positions.resize(m_numAtoms);
+    m_file.read(reinterpret_cast<char *>(positions.data()), frameSize);
+    return !m_file.fail();
+  }
+
+private:
+  string m_fileName;
+  size_t m_numAtoms;
+  size_t m_frames;
+  std::streamoff m_offset;
+  std::ifstream m_file;
+};
+
+/**
+ * Collects the blocks of a molecule and writes them out. The blocks refer to
+ * the arrays of the molecule where possible, the few that are converted are
+ * kept by the writer.
+ */
+class BlockWriter
+{
+public:
+  void add(BlockType type, size_t index, size_t elementSize, size_t count,
+           const void *data)
+  {
+    if (count == 0 || elementSize == 0)
+      return;
+    BlockEntry entry;
+    entry.type = static_cast<Uint32>(type);
+    entry.index = static_cast<Uint32>(index);
+    entry.elementSize = elementSize;
+    entry.count = count;
+    entry.offset = 0;
+    m_entries.push_back(entry);
+    m_data.push_back(static_cast<const char *>(data));
+  }
+
+  template <typename T>
+  void add(BlockType type, size_t index, const Array<T> &array)
+  {
+    add(type, index, sizeof(T), array.size(), array.data());
+  }
+
+  template <typename T>
+  void add(BlockType type, size_t index, const vector<T> &array)
+  {
+    if (!array.empty())
+      add(type, index, sizeof(T), array.size(), &array[0]);
+  }
+
+  void add(BlockType type, size_t index, const MatrixX &matrix)
+  {
+    add(type, index, matrix.rows() * sizeof(Real), matrix.cols(),
+        matrix.data());
+  }
+
+  /** Add a block holding a copy of the @p count elements at @p data. */
+  void addCopy(BlockType type, size_t index, size_t elementSize, size_t count,
+               const void *data)
+  {
+    m_storage.push_back(string(static_cast<const char *>(data),
+                               elementSize * count));
+    add(type, index, elementSize, count, m_storage.back().data());
+  }
+
+  void addString(BlockType type, size_t index, const string &str)
+  {
+    addCopy(type, index, 1, str.size(), str.data());
+  }
+
+  /**
+   * Write the header, directory and blocks. The coordinate set block has no
+   * data, its frames are read from @p molecule as it is written.
+   */
+  bool write(std::ostream &out, const Molecule &molecule, string &error)
+  {
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, fileMagic, sizeof(fileMagic));
+    header.version = BinaryFormat::version;
+    header.byteOrder = byteOrderMark;
+    header.blockCount = m_entries.size();
+    header.directoryOffset = sizeof(Header);
+
+    Uint64 offset = aligned(sizeof(Header)
+                            + m_entries.size() * sizeof(BlockEntry));
+    for (size_t i = 0; i < m_entries.size(); ++i) {
+      m_entries[i].offset = offset;
+      offset = aligned(offset + m_entries[i].elementSize * m_entries[i].count);
+    }
+
+    m_position = 0;
+    writeBytes(out, &header, sizeof(header));
+    if (!m_entries.empty())
+      writeBytes(out, &m_entries[0], m_entries.size() * sizeof(BlockEntry));
+
+    for (size_t i = 0; i < m_entries.size(); ++i) {
+      const BlockEntry &entry = m_entries[i];
+      pad(out, entry.offset);
+      if (m_data[i]) {
+        writeBytes(out, m_data[i], entry.elementSize * entry.count);
+        continue;
+      }
+      // Coordinate sets, one frame at a time.
+      const size_t frames = entry.count / molecule.atomCount();
+      Array<Vector3> positions;
+      for (size_t frame = 0; frame < frames; ++frame) {
+        if (!molecule.coordinate3d(static_cast<int>(frame), positions)
+            || positions.size() != molecule.atomCount()) {
+          std::ostringstream errorStream;
+          errorStream << "Error reading coordinate set " << frame << ".";
+          error = errorStream.str();
+          return false;
+        }
+        writeBytes(out, positions.data(), positions.size() * sizeof(Vector3));
+      }
+    }
+    pad(out, offset);
+
+    if (!out.good()) {
+      error = "Error writing the file.";
+      return false;
+    }
+    return true;
+  }
+
+private:
+  void writeBytes(std::ostream &out, const void *data, Uint64 size)
+  {
+    out.write(static_cast<const char *>(data),
+              static_cast<std::streamsize>(size));
+    m_position += size;
+  }
+
+  void pad(std::ostream &out, Uint64 offset)
+  {
+    static const char zeros[blockAlignment] = { 0 };
+    if (offset > m_position)
+      writeBytes(out, zeros, offset - m_position);
+  }
+
+  vector<BlockEntry> m_entries;
+  vector<const char *> m_data;
+  std::list<string> m_storage;
+  Uint64 m_position;
+};
+
+/**
+ * Reads the blocks listed in the directory of a file.
+ */
+class BlockReader
+{
+public:
+  BlockReader(std::istream &in, std::streamoff base, Uint64 size)
+    : m_in(in), m_base(base), m_size(size)
+  {
+  }
+
+  bool read(const BlockEntry &entry, void *data, Uint64 size)
+  {
+    if (entry.elementSize * entry.count != size
+        || entry.offset + size > m_size) {
+      return false;
+    }
+    m_in.clear();
+    m_in.seekg(m_base + static_cast<std::streamoff>(entry.offset));
+    m_in.read(static_cast<char *>(data), static_cast<std::streamsize>(size));
+    return !m_in.fail();
+  }
+
+  template <typename T>
+  bool read(const BlockEntry &entry, Array<T> &array)
+  {
+    if (entry.elementSize != sizeof(T) || !fits(entry))
+      return false;
+    array.resize(static_cast<size_t>(entry.count));
+    return read(entry, array.data(), entry.count * sizeof(T));
+  }
+
+  template <typename T>
+  bool read(const BlockEntry &entry, vector<T> &array)
+  {
+    if (entry.elementSize != sizeof(T) || !fits(entry))
+      return false;
+    array.resize(static_cast<size_t>(entry.count));
+    return read(entry, array.empty() ? NULL : &array[0],
+                entry.count * sizeof(T));
+  }
+
+  bool read(const BlockEntry &entry, MatrixX &matrix)
+  {
+    if (entry.elementSize % sizeof(Real) != 0 || !fits(entry))
+      return false;
+    matrix.resize(static_cast<Index>(entry.elementSize / sizeof(Real)),
+                  static_cast<Index>(entry.count));
+    return read(entry, matrix.data(), entry.elementSize * entry.count);
+  }
+
+  bool read(const BlockEntry &entry, string &str)
+  {
+    if (entry.elementSize != 1 || !fits(entry))
+      return false;
+    str.resize(static_cast<size_t>(entry.count));
+    return read(entry, str.empty() ? NULL : &str[0], entry.count);
+  }
+
+  template <typename T>
+  bool readStruct(const BlockEntry &entry, T &value)
+  {
+    return entry.count == 1 && entry.elementSize == sizeof(T)
+        && read(entry, &value, sizeof(T));
+  }
+
+  /** @return True if the block lies within the file. */
+  bool fits(const BlockEntry &entry) const
+  {
+    return entry.offset <= m_size
+        && (entry.elementSize == 0
+            || entry.count <= (m_size - entry.offset) / entry.elementSize);
+  }
+
+  std::streamoff offset(const BlockEntry &entry) const
+  {
+    return m_base + static_cast<std::streamoff>(entry.offset);
+  }
+
+private:
+  std::istream &m_in;
+  std::streamoff m_base;
+  Uint64 m_size;
+};
+
+// The columns of a Gaussian basis set, the basis set is built from them once
+// they have all been read.
+struct BasisColumns
+{
+  vector<int> symmetry;
+  vector<unsigned int> atomIndices;
+  vector<unsigned int> gtoIndices;
+  vector<double> exponents;
+  vector<double> coefficients;
+};
+
+bool buildBasis(const BasisColumns &columns, GaussianSet &basis)
+{
+  const size_t shells = columns.symmetry.size();
+  if (columns.atomIndices.size() != shells
+      || columns.gtoIndices.size() != shells
+      || columns.exponents.size() != columns.coefficients.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < shells; ++i) {
+    size_t first = columns.gtoIndices[i];
+    size_t last = i + 1 < shells ? columns.gtoIndices[i + 1]
+                                 : columns.exponents.size();
+    if (columns.symmetry[i] < GaussianSet::S
+        || columns.symmetry[i] > GaussianSet::UU
+        || first > last || last > columns.exponents.size()) {
+      return false;
+    }
+    unsigned int shell = basis.addBasis(
+          columns.atomIndices[i],
+          static_cast<GaussianSet::orbital>(columns.symmetry[i]));
+    for (size_t j = first; j < last; ++j)
+      basis.addGto(shell, columns.coefficients[j], columns.exponents[j]);
+  }
+  return true;
+}
+}
+
+BinaryFormat::BinaryFormat()
+{
+}
+
+BinaryFormat::~BinaryFormat()
+{
+}
+
+bool BinaryFormat::read(std::istream &in, Core::Molecule &molecule)
+{
+  const std::streamoff base = in.tellg();
+  in.seekg(0, std::ios_base::end);
+  const std::streamoff end = in.tellg();
+  in.seekg(base);
+  if (base < 0 || end < base) {
+    appendError("The binary format can only be read from a seekable stream.");
+    return false;
+  }
+  const Uint64 size = static_cast<Uint64>(end - base);
+
+  Header header;
+  if (size < sizeof(Header)
+      || !in.read(reinterpret_cast<char *>(&header), sizeof(Header))
+      || std::memcmp(header.magic, fileMagic, sizeof(fileMagic)) != 0) {
+    appendError("Not an Avogadro binary file.");
+    return false;
+  }
+  if (header.byteOrder != byteOrderMark) {
+    appendError("The file was written on a machine with a different byte "
+                "order.");
+    return false;
+  }
+  if (header.version > version) {
+    std::ostringstream errorStream;
+    errorStream << "Unsupported binary format version " << header.version
+                << ".";
+    appendError(errorStream.str());
+    return false;
+  }
+
+  BlockReader reader(in, base, size);
+  BlockEntry directory;
+  directory.type = 0;
+  directory.index = 0;
+  directory.elementSize = sizeof(BlockEntry);
+  directory.count = header.blockCount;
+  directory.offset = header.directoryOffset;
+  vector<BlockEntry> entries;
+  if (!reader.read(directory, entries)) {
+    appendError("Error reading the directory of blocks.");
+    return false;
+  }
+  std::stable_sort(entries.begin(), entries.end(), typeLess);
+
+  // The cubes and meshes are added to the molecule in the order of their
+  // first block, the basis set once all of its columns have been read.
+  vector<Cube *> cubes;
+  vector<Mesh *> meshes;
+  GaussianSet *basis(NULL);
+  BasisColumns basisColumns;
+  const BlockEntry *coordinateSets(NULL);
+  Array<unsigned char> atomicNumbers;
+  Array<std::pair<Index, Index> > bondPairs;
+  Array<unsigned char> bondOrders;
+  bool ok = true;
+
+  for (size_t i = 0; i < entries.size() && ok; ++i) {
+    const BlockEntry &entry = entries[i];
+    // Every cube and mesh has at least one block, so a valid index is less
+    // than the number of blocks.
+    if (entry.index >= entries.size()) {
+      ok = false;
+      break;
+    }
+    if (entry.type >= CubeGridBlock && entry.type <= CubeNameBlock
+        && entry.index >= cubes.size()) {
+      cubes.resize(entry.index + 1, NULL);
+    }
+    if (entry.type >= MeshInfoBlock && entry.type <= MeshNameBlock
+        && entry.index >= meshes.size()) {
+      meshes.resize(entry.index + 1, NULL);
+    }
+    Cube *cube = entry.type >= CubeGridBlock && entry.type <= CubeNameBlock
+        ? cubes[entry.index] : NULL;
+    Mesh *mesh = entry.type >= MeshInfoBlock && entry.type <= MeshNameBlock
+        ? meshes[entry.index] : NULL;
+
+    switch (entry.type) {
+    case AtomicNumbersBlock:
+      ok = reader.read(entry, atomicNumbers);
+      break;
+    case Positions2dBlock:
+      ok = reader.read(entry, molecule.atomPositions2d());
+      break;
+    case Positions3dBlock:
+      ok = reader.read(entry, molecule.atomPositions3d());
+      break;
+    case HybridizationsBlock: {
+      Array<signed char> hybridizations;
+      ok = reader.read(entry, hybridizations);
+      Array<AtomHybridization> &target = molecule.hybridizations();
+      target.resize(hybridizations.size());
+      for (size_t j = 0; j < hybridizations.size(); ++j)
+        target[j] = static_cast<AtomHybridization>(hybridizations[j]);
+      break;
+    }
+    case FormalChargesBlock:
+      ok = reader.read(entry, molecule.formalCharges());
+      break;
+    case BondPairsBlock: {
+      if (nativeBondPairs) {
+        ok = reader.read(entry, bondPairs);
+      }
+      else {
+        Array<std::pair<Uint64, Uint64> > wide;
+        ok = reader.read(entry, wide);
+        bondPairs.resize(wide.size());
+        for (size_t j = 0; j < wide.size(); ++j) {
+          bondPairs[j] = std::make_pair(static_cast<Index>(wide[j].first),
+                                        static_cast<Index>(wide[j].second));
+        }
+      }
+      break;
+    }
+    case BondOrdersBlock:
+      ok = reader.read(entry, bondOrders);
+      break;
+    case CoordinateSetsBlock:
+      ok = entry.elementSize == sizeof(Vector3) && reader.fits(entry);
+      coordinateSets = &entry;
+      break;
+    case DataBlock: {
+      string data;
+      ok = reader.read(entry, data);
+      // Pairs of null terminated names and values.
+      size_t start = 0;
+      while (ok && start < data.size()) {
+        size_t nameEnd = data.find('\0', start);
+        size_t valueEnd = nameEnd == string::npos
+            ? string::npos : data.find('\0', nameEnd + 1);
+        if (valueEnd == string::npos) {
+          ok = false;
+          break;
+        }
+        molecule.setData(data.substr(start, nameEnd - start),
+                         data.substr(nameEnd + 1, valueEnd - nameEnd - 1));
+        start = valueEnd + 1;
+      }
+      break;
+    }
+    case UnitCellBlock: {
+      Matrix3 cellMatrix;
+      ok = reader.readStruct(entry, cellMatrix);
+      if (ok)
+        molecule.setUnitCell(new UnitCell(cellMatrix));
+      break;
+    }
+    case CubeGridBlock: {
+      CubeGrid grid;
+      ok = reader.readStruct(entry, grid) && !cube;
+      if (!ok)
+        break;
+      // Check the values against the dimensions before they are allocated.
+      const BlockEntry *values = findBlock(entries, CubeValuesBlock,
+                                           entry.index);
+      ok = values && values->elementSize == sizeof(double)
+          && reader.fits(*values);
+      Uint64 count = 1;
+      for (int j = 0; j < 3 && ok; ++j) {
+        const Uint32 dimension = grid.dimensions[j];
+        ok = dimension <= static_cast<Uint32>(INT_MAX)
+            && (dimension == 0 || count <= values->count / dimension);
+        count *= dimension;
+      }
+      ok = ok && count == values->count;
+      if (!ok)
+        break;
+      cube = cubes[entry.index] = molecule.addCube();
+      cube->setLimits(Vector3(grid.min[0], grid.min[1], grid.min[2]),
+                      Vector3i(static_cast<int>(grid.dimensions[0]),
+                               static_cast<int>(grid.dimensions[1]),
+                               static_cast<int>(grid.dimensions[2])),
+                      Vector3(grid.spacing[0], grid.spacing[1],
+                              grid.spacing[2]));
+      cube->setCubeType(static_cast<Cube::Type>(grid.cubeType));
+      break;
+    }
+    case CubeValuesBlock:
+      ok = cube && entry.count == cube->data()->size()
+          && reader.read(entry, *cube->data());
+      if (ok)
+        cube->updateMinMax();
+      break;
+    case CubeNameBlock: {
+      string name;
+      ok = cube && reader.read(entry, name);
+      if (ok)
+        cube->setName(name);
+      break;
+    }
+    case MeshInfoBlock: {
+      MeshInfo info;
+      ok = reader.readStruct(entry, info) && !mesh;
+      if (!ok)
+        break;
+      mesh = meshes[entry.index] = molecule.addMesh();
+      mesh->setIsoValue(info.isoValue);
+      mesh->setOtherMesh(info.otherMesh);
+      mesh->setCube(info.cube);
+      mesh->setStable(info.stable != 0);
+      break;
+    }
+    case MeshVerticesBlock:
+    case MeshNormalsBlock: {
+      Array<Vector3f> vectors;
+      ok = mesh && reader.read(entry, vectors);
+      if (ok && entry.type == MeshVerticesBlock)
+        mesh->setVertices(vectors);
+      else if (ok)
+        mesh->setNormals(vectors);
+      break;
+    }
+    case MeshColorsBlock: {
+      Array<Core::Color3f> colors;
+      ok = mesh && reader.read(entry, colors);
+      if (ok)
+        mesh->setColors(colors);
+      break;
+    }
+    case MeshIndicesBlock: {
+      Array<unsigned int> indices;
+      ok = mesh && reader.read(entry, indices) && mesh->setIndices(indices);
+      break;
+    }
+    case MeshNameBlock: {
+      string name;
+      ok = mesh && reader.read(entry, name);
+      if (ok)
+        mesh->setName(name);
+      break;
+    }
+    case BasisInfoBlock: {
+      BasisInfo info;
+      ok = reader.readStruct(entry, info) && !basis;
+      if (!ok)
+        break;
+      basis = new GaussianSet;
+      basis->setElectronCount(info.electrons[0], BasisSet::Alpha);
+      basis->setElectronCount(info.electrons[1], BasisSet::Beta);
+      basis->setScfType(static_cast<Core::ScfType>(info.scfType));
+      break;
+    }
+    case BasisSymmetryBlock:
+      ok = reader.read(entry, basisColumns.symmetry);
+      break;
+    case BasisAtomIndicesBlock:
+      ok = reader.read(entry, basisColumns.atomIndices);
+      break;
+    case BasisGtoIndicesBlock:
+      ok = reader.read(entry, basisColumns.gtoIndices);
+      break;
+    case BasisExponentsBlock:
+      ok = reader.read(entry, basisColumns.exponents);
+      break;
+    case BasisCoefficientsBlock:
+      ok = reader.read(entry, basisColumns.coefficients);
+      break;
+    case MoCoefficientsBlock:
+      ok = basis && reader.read(entry, basis->moMatrix());
+      break;
+    case DensityMatrixBlock:
+      ok = basis && reader.read(entry, basis->densityMatrix());
+      break;
+    case SpinDensityMatrixBlock:
+      ok = basis && reader.read(entry, basis->spinDensityMatrix());
+      break;
+    default:
+      // Blocks added by later versions of the format.
+      break;
+    }
+  }
+
+  if (!ok) {
+    appendError("Error reading the blocks of the file.");
+  }
+  else if (basis && !buildBasis(basisColumns, *basis)) {
+    appendError("Error reading the basis set.");
+    ok = false;
+  }
+
+  // The atom arrays must all describe the same atoms.
+  if (ok)
+    molecule.addAtoms(atomicNumbers);
+  const Index atoms = molecule.atomCount();
+  if (ok && ((!molecule.atomPositions2d().empty()
+              && molecule.atomPositions2d().size() != atoms)
+             || (!molecule.atomPositions3d().empty()
+                 && molecule.atomPositions3d().size() != atoms)
+             || (!molecule.hybridizations().empty()
+                 && molecule.hybridizations().size() != atoms)
+             || (!molecule.formalCharges().empty()
+                 && molecule.formalCharges().size() != atoms))) {
+    appendError("The atom arrays have different lengths.");
+    ok = false;
+  }
+  if (ok) {
+    if (bondOrders.size() != bondPairs.size())
+      bondOrders.resize(bondPairs.size(), 1);
+    ok = molecule.addBonds(bondPairs, bondOrders);
+    if (!ok)
+      appendError("A bond refers to an atom that does not exist.");
+  }
+  if (ok && coordinateSets && (atoms == 0 || coordinateSets->count % atoms)) {
+    appendError("The coordinate sets do not match the atoms.");
+    ok = false;
+  }
+
+  if (!ok) {
+    delete basis;
+    return false;
+  }
+
+  if (basis) {
+    molecule.setBasisSet(basis);
+    basis->setMolecule(&molecule);
+  }
+
+  // Trajectories read from a file are left on disk, the frames are read when
+  // they are set on the molecule.
+  if (coordinateSets) {
+    const size_t frames = static_cast<size_t>(coordinateSets->count / atoms);
+    if (isMode(Read) && !fileName().empty()) {
+      molecule.setTrajectorySource(
+            new BinaryTrajectory(fileName(), atoms, frames,
+                                 reader.offset(*coordinateSets)));
+    }
+    else {
+      BlockEntry frame = *coordinateSets;
+      frame.count = atoms;
+      for (size_t i = 0; i < frames; ++i) {
+        Array<Vector3> positions;
+        if (!reader.read(frame, positions)) {
+          appendError("Error reading the coordinate sets.");
+          return false;
+        }
+        molecule.setCoordinate3d(positions, static_cast<int>(i));
+        frame.offset += atoms * sizeof(Vector3);
+      }
+    }
+  }
+
+  return true;
+}
+
+bool BinaryFormat::write(std::ostream &out, const Core::Molecule &molecule)
+{
+  BlockWriter writer;
+
+  writer.add(AtomicNumbersBlock, 0, molecule.atomicNumbers());
+  writer.add(Positions2dBlock, 0, molecule.atomPositions2d());
+  writer.add(Positions3dBlock, 0, molecule.atomPositions3d());
+  if (!molecule.hybridizations().empty()) {
+    const Array<AtomHybridization> &hybridizations = molecule.hybridizations();
+    vector<signed char> converted(hybridizations.size());
+    for (size_t i = 0; i < hybridizations.size(); ++i)
+      converted[i] = static_cast<signed char>(hybridizations[i]);
+    writer.addCopy(HybridizationsBlock, 0, 1, converted.size(), &converted[0]);
+  }
+  writer.add(FormalChargesBlock, 0, molecule.formalCharges());
+
+  const Array<std::pair<Index, Index> > &pairs = molecule.bondPairs();
+  if (nativeBondPairs) {
+    writer.add(BondPairsBlock, 0, pairs);
+  }
+  else if (!pairs.empty()) {
+    vector<Uint64> wide;
+    wide.reserve(2 * pairs.size());
+    for (size_t i = 0; i < pairs.size(); ++i) {
+      wide.push_back(pairs[i].first);
+      wide.push_back(pairs[i].second);
+    }
+    writer.addCopy(BondPairsBlock, 0, 2 * sizeof(Uint64), pairs.size(),
+                   &wide[0]);
+  }
+  writer.add(BondOrdersBlock, 0, molecule.bondOrders());
+
+  // Coordinate sets are written from the molecule one frame at a time.
+  const size_t frames = static_cast<size_t>(molecule.coordinate3dCount());
+  writer.add(CoordinateSetsBlock, 0, sizeof(Vector3),
+             frames * molecule.atomCount(), NULL);
+
+  // Only string data can be stored, as pairs of null terminated strings.
+  string data;
+  const VariantMap &dataMap = molecule.dataMap();
+  for (VariantMap::const_iterator it = dataMap.begin(); it != dataMap.end();
+       ++it) {
+    if (it->second.type() == Variant::String) {
+      data += it->first;
+      data += '\0';
+      data += it->second.toString();
+      data += '\0';
+    }
+  }
+  writer.addString(DataBlock, 0, data);
+
+  if (molecule.unitCell()) {
+    writer.add(UnitCellBlock, 0, sizeof(Matrix3), 1,
+               molecule.unitCell()->cellMatrix().data());
+  }
+
+  for (Index i = 0; i < molecule.cubeCount(); ++i) {
+    const Cube *cube = molecule.cube(i);
+    CubeGrid grid;
+    for (int j = 0; j < 3; ++j) {
+      grid.min[j] = cube->min()[j];
+      grid.spacing[j] = cube->spacing()[j];
+      grid.dimensions[j] = static_cast<Uint32>(cube->dimensions()[j]);
+    }
+    grid.cubeType = static_cast<Uint32>(cube->cubeType());
+    writer.addCopy(CubeGridBlock, i, sizeof(grid), 1, &grid);
+    writer.add(CubeValuesBlock, i, *cube->data());
+    writer.addString(CubeNameBlock, i, cube->name());
+  }
+
+  for (Index i = 0; i < molecule.meshCount(); ++i) {
+    const Mesh *mesh = molecule.mesh(i);
+    MeshInfo info;
+    info.isoValue = mesh->isoValue();
+    info.otherMesh = mesh->otherMesh();
+    info.cube = mesh->cube();
+    info.stable = mesh->stable() ? 1 : 0;
+    writer.addCopy(MeshInfoBlock, i, sizeof(info), 1, &info);
+    writer.add(MeshVerticesBlock, i, mesh->vertices());
+    writer.add(MeshNormalsBlock, i, mesh->normals());
+    writer.add(MeshColorsBlock, i, mesh->colors());
+    writer.add(MeshIndicesBlock, i, mesh->indices());
+    writer.addString(MeshNameBlock, i, mesh->name());
+  }
+
+  const GaussianSet *basis =
+      dynamic_cast<const GaussianSet *>(molecule.basisSet());
+  if (basis) {
+    BasisInfo info;
+    info.electrons[0] = basis->electronCount(BasisSet::Alpha);
+    info.electrons[1] = basis->electronCount(BasisSet::Beta);
+    info.scfType = static_cast<Uint32>(basis->scfType());
+    info.reserved = 0;
+    writer.addCopy(BasisInfoBlock, 0, sizeof(info), 1, &info);
+    writer.add(BasisSymmetryBlock, 0, basis->symmetry());
+    writer.add(BasisAtomIndicesBlock, 0, basis->atomIndices());
+    // Once the basis set has been used for a calculation it holds a final
+    // index past the last shell.
+    const vector<unsigned int> &gtoIndices = basis->gtoIndices();
+    writer.add(BasisGtoIndicesBlock, 0, sizeof(unsigned int),
+               std::min(gtoIndices.size(), basis->symmetry().size()),
+               gtoIndices.empty() ? NULL : &gtoIndices[0]);
+    writer.add(BasisExponentsBlock, 0, basis->gtoA());
+    writer.add(BasisCoefficientsBlock, 0, basis->gtoC());
+    writer.add(MoCoefficientsBlock, 0, basis->moMatrix());
+    writer.add(DensityMatrixBlock, 0, basis->densityMatrix());
+    writer.add(SpinDensityMatrixBlock, 0, basis->spinDensityMatrix());
+  }
+
+  string error;
+  if (!writer.write(out, molecule, error)) {
+    appendError(error);
+    return false;
+  }
+  return true;
+}
+
+vector<std::string> BinaryFormat::fileExtensions() const
+{
+  vector<std::string> ext;
+  ext.push_back("avb");
+  return ext;
+}
+
+vector<std::string> BinaryFormat::mimeTypes() const
+{
+  vector<std::string> mime;
+  mime.push_back("chemical/x-avogadro-binary");
+  return mime;
+}
+
+} // end Io namespace
+} // end Avogadro namespace
@@ -0,0 +1,87 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2014 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef AVOGADRO_IO_BINARYFORMAT_H
+#define AVOGADRO_IO_BINARYFORMAT_H
+
+#include "fileformat.h"
+
+namespace Avogadro {
+namespace Io {
+
+/**
+ * @class BinaryFormat binaryformat.h <avogadro/io/binaryformat.h>
+ * @brief Implementation of the native binary Avogadro format.
+ *
+ * The binary format stores the arrays of a molecule as they are held in
+ * memory, so that reading and writing them is a single copy with no parsing
+ * or formatting. A file starts with a fixed 64 byte header followed by a
+ * directory of blocks. Each block holds one column, such as the atomic
+ * numbers, the 3D positions or the values of a cube, and starts on a 64 byte
+ * boundary so that the file can also be memory mapped and used in place.
+ *
+ * The atom positions of all coordinate sets are stored in one block. When the
+ * molecule is read from a file they are not loaded, the frames are read from
+ * the file as they are set on the molecule, so large trajectories open
+ * quickly.
+ *
+ * Files are written in the byte order of the machine writing them, reading a
+ * file written with a different byte order fails with an error.
+ */
+
+class AVOGADROIO_EXPORT BinaryFormat : public FileFormat
+{
+public:
+  BinaryFormat();
+  ~BinaryFormat() AVO_OVERRIDE;
+
+  Operations supportedOperations() const AVO_OVERRIDE
+  {
+    return ReadWrite | File | Stream | String;
+  }
+
+  FileFormat * newInstance() const AVO_OVERRIDE { return new BinaryFormat; }
+  std::string identifier() const AVO_OVERRIDE { return "Avogadro: AVB"; }
+  std::string name() const AVO_OVERRIDE { return "Avogadro binary"; }
+  std::string description() const AVO_OVERRIDE
+  {
+    return "Native binary format storing the atoms, bonds, coordinate sets, "
+        "unit cell, basis set, cubes and meshes of a molecule.";
+  }
+
+  std::string specificationUrl() const AVO_OVERRIDE
+  {
+    return "http://wiki.openchemistry.org/";
+  }
+
+  std::vector<std::string> fileExtensions() const AVO_OVERRIDE;
+  std::vector<std::string> mimeTypes() const AVO_OVERRIDE;
+
+  bool read(std::istream &in, Core::Molecule &molecule) AVO_OVERRIDE;
+  bool write(std::ostream &out, const Core::Molecule &molecule) AVO_OVERRIDE;
+
+  /**
+   * The version of the format written, files with a later version can not be
+   * read. Blocks of unknown types are skipped, so new blocks can be added
+   * without changing the version.
+   */
+  static const unsigned int version = 1;
+};
+
+} // end Io namespace
+} // end Avogadro namespace
+
+#endif // AVOGADRO_IO_BINARYFORMAT_H
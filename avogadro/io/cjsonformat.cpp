@@ -16,13 +16,17 @@
 
 #include "cjsonformat.h"
 
+#include "jsonreader.h"
+#include "jsonwriter.h"
+
 #include <avogadro/core/crystaltools.h>
 #include <avogadro/core/elements.h>
 #include <avogadro/core/gaussianset.h>
 #include <avogadro/core/molecule.h>
 #include <avogadro/core/unitcell.h>
 
-#include <jsoncpp.cpp>
+#include <cmath>
+#include <limits>
 
 namespace Avogadro {
 namespace Io {
@@ -30,10 +34,6 @@ namespace Io {
 using std::string;
 using std::vector;
 
-using Json::Value;
-using Json::Reader;
-using Json::StyledStreamWriter;
-
 using Core::Array;
 using Core::Atom;
 using Core::BasisSet;
@@ -44,224 +44,468 @@ using Core::GaussianSet;
 using Core::Molecule;
 using Core::Variant;
 
-CjsonFormat::CjsonFormat()
+namespace {
+// The arrays of a Chemical JSON document that are read into the molecule.
+enum ArrayTarget {
+  NoTarget,
+  ElementTarget,
+  Coords3dTarget,
+  Coords2dTarget,
+  FractionalTarget,
+  BondIndexTarget,
+  BondOrderTarget
+};
+
+// True if @a value is a whole number from 0 to @a max, so that it can be cast
+// to an integer type holding @a max. This is false for NaN and infinities.
+bool isWholeNumber(double value, double max)
 {
+  return value >= 0.0 && value <= max && std::floor(value) == value;
 }
 
-CjsonFormat::~CjsonFormat()
-{
-}
+const double maxByte = 255.0;
+const double maxIndex =
+    static_cast<double>(std::numeric_limits<unsigned int>::max());
 
-bool CjsonFormat::read(std::istream &file, Molecule &molecule)
+/**
+ * Fills a molecule from the events of a JsonReader. The atomic numbers go
+ * straight into the molecule, the other arrays are collected until the whole
+ * document has been read as the members may come in any order.
+ */
+class CjsonHandler : public JsonHandler
 {
-  Value root;
-  Reader reader;
-  bool ok = reader.parse(file, root);
-  if (!ok) {
-    appendError("Error parsing JSON: " + reader.getFormatedErrorMessages());
-    return false;
+public:
+  explicit CjsonHandler(Molecule &molecule)
+    : m_molecule(molecule), m_target(NoTarget), m_pendingCount(0),
+      m_chemicalJson(false), m_atoms(false), m_elements(false), m_bonds(false),
+      m_connections(false), m_bondIndices(false), m_bondOrders(false),
+      m_coords3d(false), m_coords2d(false), m_fractional(false),
+      m_unitCell(false), m_unitCellMembers(0)
+  {
   }
 
-  if (!root.isObject()) {
-    appendError("Error: Input is not a JSON object.");
-    return false;
+  bool startObject() AVO_OVERRIDE
+  {
+    if (m_target != NoTarget)
+      return setError("Error: \"" + m_targetPath + "\" must hold numbers.");
+    if (isMember("atoms"))
+      m_atoms = true;
+    else if (isMember("bonds"))
+      m_bonds = true;
+    else if (isMember("unit cell"))
+      m_unitCell = true;
+    else if (isMember("bonds/connections"))
+      m_connections = true;
+    Frame frame = { false, string() };
+    m_stack.push_back(frame);
+    return true;
   }
 
-  Value value = root["chemical json"];
-  if (value.empty()) {
-    appendError("Error: no \"chemical json\" key found.");
-    return false;
+  bool endObject() AVO_OVERRIDE
+  {
+    m_stack.pop_back();
+    return true;
   }
 
-  // It looks like a valid Chemical JSON file - attempt to read data.
-  value = root["name"];
-  if (!value.empty() && value.isString())
-    molecule.setData("name", value.asString());
-  value = root["inchi"];
-  if (!value.empty() && value.isString())
-    molecule.setData("inchi", value.asString());
-
-  value = root["unit cell"];
-  if (value.type() == Json::objectValue) {
-    if (!value["a"].isNumeric() ||
-        !value["b"].isNumeric() ||
-        !value["c"].isNumeric() ||
-        !value["alpha"].isNumeric() ||
-        !value["beta"].isNumeric() ||
-        !value["gamma"].isNumeric()) {
-      appendError("Invalid unit cell specification: a, b, c, alpha, beta, gamma"
-                  " must be present and numeric.");
-      return false;
-    }
-    Real a = static_cast<Real>(value["a"].asDouble());
-    Real b = static_cast<Real>(value["b"].asDouble());
-    Real c = static_cast<Real>(value["c"].asDouble());
-    Real alpha = static_cast<Real>(value["alpha"].asDouble()) * DEG_TO_RAD;
-    Real beta  = static_cast<Real>(value["beta" ].asDouble()) * DEG_TO_RAD;
-    Real gamma = static_cast<Real>(value["gamma"].asDouble()) * DEG_TO_RAD;
-    Core::UnitCell *unitCell = new Core::UnitCell(a, b, c, alpha, beta, gamma);
-    molecule.setUnitCell(unitCell);
+  bool key(const string &name) AVO_OVERRIDE
+  {
+    m_stack.back().key = name;
+    if (m_stack.size() == 1 && name == "chemical json")
+      m_chemicalJson = true;
+    return true;
   }
 
-  // Read in the atomic data.
-  Value atoms = root["atoms"];
-  if (atoms.empty()) {
-    appendError("Error: no \"atom\" key found");
-    return false;
-  }
-  else if (atoms.type() != Json::objectValue) {
-    appendError("Error: \"atom\" is not of type object");
-    return false;
+  bool startArray() AVO_OVERRIDE
+  {
+    if (m_stack.empty())
+      return setError("Error: Input is not a JSON object.");
+    if (m_target != NoTarget)
+      return setError("Error: \"" + m_targetPath + "\" must hold numbers.");
+
+    m_pendingCount = 0;
+    string path(objectPath());
+    if (path == "atoms/elements/number") {
+      m_target = ElementTarget;
+      m_elements = true;
+    }
+    else if (path == "atoms/coords/3d") {
+      m_target = Coords3dTarget;
+      m_coords3d = true;
+    }
+    else if (path == "atoms/coords/2d") {
+      m_target = Coords2dTarget;
+      m_coords2d = true;
+    }
+    else if (path == "atoms/coords/3d fractional") {
+      m_target = FractionalTarget;
+      m_fractional = true;
+    }
+    else if (path == "bonds/connections/index") {
+      m_target = BondIndexTarget;
+      m_bondIndices = true;
+    }
+    else if (path == "bonds/order") {
+      m_target = BondOrderTarget;
+      m_bondOrders = true;
+    }
+    if (m_target != NoTarget)
+      m_targetPath = path;
+
+    Frame frame = { true, string() };
+    m_stack.push_back(frame);
+    return true;
   }
 
-  value =  atoms["elements"];
-  if (value.empty()) {
-    appendError("Error: no \"atoms.elements\" key found");
-    return false;
+  bool endArray() AVO_OVERRIDE
+  {
+    m_stack.pop_back();
+    ArrayTarget target = m_target;
+    m_target = NoTarget;
+    if (m_pendingCount != 0) {
+      if (target == Coords3dTarget)
+        return setError("Error: number of elements != number of 3D "
+                        "coordinates.");
+      if (target == Coords2dTarget)
+        return setError("Error: number of elements != number of 2D "
+                        "coordinates.");
+      if (target == FractionalTarget)
+        return setError("Error: number of elements != number of fractional "
+                        "coordinates.");
+    }
+    return true;
   }
-  else if (value.type() != Json::objectValue) {
-    appendError("Error: \"atoms.elements\" is not of type object");
-    return false;
+
+  bool numberValue(double value) AVO_OVERRIDE
+  {
+    switch (m_target) {
+    case NoTarget:
+      if (m_stack.empty())
+        return setError("Error: Input is not a JSON object.");
+      break;
+    case ElementTarget:
+      if (!isWholeNumber(value, maxByte))
+        return setError("Error: invalid atomic number in elements.");
+      m_molecule.addAtom(static_cast<unsigned char>(value));
+      return true;
+    case Coords3dTarget:
+    case FractionalTarget:
+      m_pending[m_pendingCount++] = value;
+      if (m_pendingCount == 3) {
+        Vector3 position(static_cast<Real>(m_pending[0]),
+                         static_cast<Real>(m_pending[1]),
+                         static_cast<Real>(m_pending[2]));
+        if (m_target == Coords3dTarget)
+          m_positions3d.push_back(position);
+        else
+          m_fractionalPositions.push_back(position);
+        m_pendingCount = 0;
+      }
+      return true;
+    case Coords2dTarget:
+      m_pending[m_pendingCount++] = value;
+      if (m_pendingCount == 2) {
+        m_positions2d.push_back(Vector2(static_cast<Real>(m_pending[0]),
+                                        static_cast<Real>(m_pending[1])));
+        m_pendingCount = 0;
+      }
+      return true;
+    case BondIndexTarget:
+      if (!isWholeNumber(value, maxIndex))
+        return setError("Error: invalid atom index in bonds.");
+      m_pending[m_pendingCount++] = value;
+      if (m_pendingCount == 2) {
+        m_bondPairs.push_back(
+              std::make_pair(static_cast<Index>(m_pending[0]),
+                             static_cast<Index>(m_pending[1])));
+        m_pendingCount = 0;
+      }
+      return true;
+    case BondOrderTarget:
+      if (!isWholeNumber(value, maxByte))
+        return setError("Error: invalid bond order.");
+      m_bondOrderValues.push_back(static_cast<unsigned char>(value));
+      return true;
+    }
+
+    // Only the unit cell members are of interest outside of the arrays.
+    if (m_stack.size() == 2 && !m_stack[0].isArray && !m_stack[1].isArray
+        && m_stack[0].key == "unit cell") {
+      const string &name = m_stack[1].key;
+      static const char *members[] = { "a", "b", "c", "alpha", "beta",
+                                       "gamma" };
+      for (int i = 0; i < 6; ++i) {
+        if (name == members[i]) {
+          m_cell[i] = static_cast<Real>(value);
+          m_unitCellMembers |= 1 << i;
+        }
+      }
+    }
+    return true;
   }
 
-  value = value["number"];
-  if (value.empty()) {
-    appendError("Error: no \"atoms.elements.number\" key found");
-    return false;
+  bool stringValue(const string &value) AVO_OVERRIDE
+  {
+    if (m_stack.empty())
+      return setError("Error: Input is not a JSON object.");
+    if (m_target != NoTarget)
+      return setError("Error: \"" + m_targetPath + "\" must hold numbers.");
+    if (isMember("name"))
+      m_molecule.setData("name", value);
+    else if (isMember("inchi"))
+      m_molecule.setData("inchi", value);
+    return true;
   }
 
-  Index atomCount(0);
-  if (value.isArray()) {
-    atomCount = static_cast<Index>(value.size());
-    for (Index i = 0; i < atomCount; ++i)
-      molecule.addAtom(static_cast<unsigned char>(value.get(i, 0).asInt()));
+  bool boolValue(bool) AVO_OVERRIDE
+  {
+    if (m_stack.empty())
+      return setError("Error: Input is not a JSON object.");
+    if (m_target != NoTarget)
+      return setError("Error: \"" + m_targetPath + "\" must hold numbers.");
+    return true;
   }
-  else {
-    appendError("Error: \"atoms.elements.number\" is not of type array");
-    return false;
+
+  bool nullValue() AVO_OVERRIDE
+  {
+    if (m_stack.empty())
+      return setError("Error: Input is not a JSON object.");
+    if (m_target != NoTarget)
+      return setError("Error: \"" + m_targetPath + "\" must hold numbers.");
+    return true;
   }
 
-  Value coords = atoms["coords"];
-  if (!coords.empty()) {
-    value = coords["3d"];
-    if (value.isArray()) {
-      if (value.size() && atomCount != static_cast<Index>(value.size() / 3)) {
-        appendError("Error: number of elements != number of 3D coordinates.");
-        return false;
-      }
-      for (Index i = 0; i < atomCount; ++i) {
-        Atom a = molecule.atom(i);
-        a.setPosition3d(Vector3(value.get(3 * i + 0, 0).asDouble(),
-                                value.get(3 * i + 1, 0).asDouble(),
-                                value.get(3 * i + 2, 0).asDouble()));
+  /**
+   * Check the document is complete, and move the collected arrays into the
+   * molecule.
+   */
+  bool finish()
+  {
+    if (!m_chemicalJson)
+      return setError("Error: no \"chemical json\" key found.");
+
+    if (m_unitCell) {
+      if (m_unitCellMembers != 0x3F) {
+        return setError("Invalid unit cell specification: a, b, c, alpha, "
+                        "beta, gamma must be present and numeric.");
       }
+      m_molecule.setUnitCell(
+            new Core::UnitCell(m_cell[0], m_cell[1], m_cell[2],
+                               m_cell[3] * DEG_TO_RAD, m_cell[4] * DEG_TO_RAD,
+                               m_cell[5] * DEG_TO_RAD));
     }
 
-    value = coords["2d"];
-    if (value.isArray()) {
-      if (value.size() && atomCount != static_cast<Index>(value.size() / 2)) {
-        appendError("Error: number of elements != number of 2D coordinates.");
-        return false;
+    if (!m_atoms)
+      return setError("Error: no \"atom\" key found");
+    if (!m_elements)
+      return setError("Error: no \"atoms.elements.number\" array found");
+
+    Index atomCount = m_molecule.atomCount();
+    // The parsed coordinates are handed over to the molecule, not copied.
+    if (m_coords3d && !m_positions3d.empty()) {
+      if (m_positions3d.size() != atomCount)
+        return setError("Error: number of elements != number of 3D "
+                        "coordinates.");
+      m_molecule.atomPositions3d().swap(m_positions3d);
+    }
+    if (m_coords2d && !m_positions2d.empty()) {
+      if (m_positions2d.size() != atomCount)
+        return setError("Error: number of elements != number of 2D "
+                        "coordinates.");
+      m_molecule.atomPositions2d().swap(m_positions2d);
+    }
+    if (m_fractional) {
+      if (!m_molecule.unitCell()) {
+        return setError("Cannot interpret fractional coordinates without "
+                        "unit cell.");
       }
-      for (Index i = 0; i < atomCount; ++i) {
-        Atom a = molecule.atom(i);
-        a.setPosition2d(Vector2(value.get(2 * i + 0, 0).asDouble(),
-                                value.get(2 * i + 1, 0).asDouble()));
+      if (!m_fractionalPositions.empty()
+          && !CrystalTools::setFractionalCoordinates(m_molecule,
+                                                     m_fractionalPositions)) {
+        return setError("Error: number of elements != number of fractional "
+                        "coordinates.");
       }
     }
 
-    value = coords["3d fractional"];
-    if (value.type() == Json::arrayValue) {
-      if (!molecule.unitCell()) {
-        appendError("Cannot interpret fractional coordinates without "
-                    "unit cell.");
-        return false;
+    if (m_bonds) {
+      if (!m_connections)
+        return setError("Error: no \"bonds.connections\" key found");
+      if (!m_bondIndices) {
+        m_warning = "Warning, no bonding information found.";
       }
-      if (value.size() && atomCount != static_cast<size_t>(value.size() / 3)) {
-        appendError("Error: number of elements != number of fractional "
-                    "coordinates.");
-        return false;
+      else if (m_bondOrders && m_bondOrderValues.size() != m_bondPairs.size()) {
+        return setError("Error: number of bonds != number of bond orders.");
       }
-      Array<Vector3> fcoords;
-      fcoords.reserve(atomCount);
-      for (Index i = 0; i < atomCount; ++i) {
-        fcoords.push_back(
-              Vector3(static_cast<Real>(value.get(i * 3 + 0, 0).asDouble()),
-                      static_cast<Real>(value.get(i * 3 + 1, 0).asDouble()),
-                      static_cast<Real>(value.get(i * 3 + 2, 0).asDouble())));
+
+      if (!m_molecule.addBonds(m_bondPairs, m_bondOrders
+                               ? m_bondOrderValues : Array<unsigned char>())) {
+        return setError("Error: bond to a nonexistent atom.");
       }
-      CrystalTools::setFractionalCoordinates(molecule, fcoords);
     }
+    return true;
   }
 
-  // Now for the bonding data.
-  Value bonds = root["bonds"];
-  if (!bonds.empty()) {
-    value = bonds["connections"];
-    if (value.empty()) {
-      appendError("Error: no \"bonds.connections\" key found");
-      return false;
+  /**
+   * @return The error that stopped the handler, if any.
+   */
+  const string & error() const { return m_error; }
+
+  /**
+   * @return A warning about the content of the document, if any.
+   */
+  const string & warning() const { return m_warning; }
+
+private:
+  struct Frame
+  {
+    bool isArray;
+    string key;
+  };
+
+  // The keys leading to the current value, or an empty string if the value is
+  // inside an array.
+  string objectPath() const
+  {
+    string path;
+    for (vector<Frame>::const_iterator it = m_stack.begin(),
+         itEnd = m_stack.end(); it != itEnd; ++it) {
+      if (it->isArray)
+        return string();
+      if (!path.empty())
+        path += '/';
+      path += it->key;
     }
+    return path;
+  }
 
-    value = value["index"];
-    Index bondCount(0);
-    if (value.isArray()) {
-      bondCount = static_cast<Index>(value.size() / 2);
-      for (Index i = 0; i < bondCount * 2; i += 2) {
-        molecule.addBond(
-              molecule.atom(static_cast<Index>(value.get(i + 0, 0).asInt())),
-              molecule.atom(static_cast<Index>(value.get(i + 1, 0).asInt())));
-      }
-    }
-    else {
-      appendError("Warning, no bonding information found.");
-    }
+  bool isMember(const char *path) const
+  {
+    // Cheap rejection, almost all values are deep in the document.
+    return m_stack.size() <= 3 && objectPath() == path;
+  }
 
-    value = bonds["order"];
-    if (value.isArray()) {
-      if (bondCount != static_cast<Index>(value.size())) {
-        appendError("Error: number of bonds != number of bond orders.");
-        return false;
-      }
-      for (Index i = 0; i < bondCount; ++i)
-        molecule.bond(i).setOrder(
-          static_cast<unsigned char>(value.get(i, 1).asInt()));
-    }
+  bool setError(const string &message)
+  {
+    m_error = message;
+    return false;
+  }
+
+  Molecule &m_molecule;
+  vector<Frame> m_stack;
+
+  ArrayTarget m_target;
+  string m_targetPath;
+  double m_pending[3];
+  int m_pendingCount;
+
+  Array<Vector3> m_positions3d;
+  Array<Vector2> m_positions2d;
+  Array<Vector3> m_fractionalPositions;
+  Array<std::pair<Index, Index> > m_bondPairs;
+  Array<unsigned char> m_bondOrderValues;
+  Real m_cell[6];
+
+  bool m_chemicalJson;
+  bool m_atoms;
+  bool m_elements;
+  bool m_bonds;
+  bool m_connections;
+  bool m_bondIndices;
+  bool m_bondOrders;
+  bool m_coords3d;
+  bool m_coords2d;
+  bool m_fractional;
+  bool m_unitCell;
+  int m_unitCellMembers;
+
+  string m_error;
+  string m_warning;
+};
+
+// Checks that the document is a JSON object without looking at its content.
+class ObjectHandler : public JsonHandler
+{
+public:
+  ObjectHandler() : m_isObject(false) {}
+
+  bool startObject() AVO_OVERRIDE
+  {
+    m_isObject = true;
+    return true;
+  }
+
+  bool startArray() AVO_OVERRIDE { return m_isObject; }
+  bool numberValue(double) AVO_OVERRIDE { return m_isObject; }
+  bool stringValue(const string &) AVO_OVERRIDE { return m_isObject; }
+  bool boolValue(bool) AVO_OVERRIDE { return m_isObject; }
+  bool nullValue() AVO_OVERRIDE { return m_isObject; }
+
+private:
+  bool m_isObject;
+};
+}
+
+CjsonFormat::CjsonFormat() : m_prettyPrint(true)
+{
+}
+
+CjsonFormat::~CjsonFormat()
+{
+}
+
+bool CjsonFormat::read(std::istream &file, Molecule &molecule)
+{
+  JsonReader reader(file);
+  CjsonHandler handler(molecule);
+  if (!reader.parse(handler) || !handler.finish()) {
+    appendError(handler.error().empty() ? reader.error() : handler.error());
+    return false;
   }
+  if (!handler.warning().empty())
+    appendError(handler.warning());
 
   return true;
 }
 
 bool CjsonFormat::write(std::ostream &file, const Molecule &molecule)
 {
-  StyledStreamWriter writer("  ");
-  Value root;
+  JsonWriter json(file, m_prettyPrint);
+  json.startObject();
 
-  root["chemical json"] = 0;
+  json.key("chemical json");
+  json.integerValue(0);
 
-  if (molecule.data("name").type() == Variant::String)
-    root["name"] = molecule.data("name").toString().c_str();
-  if (molecule.data("inchi").type() == Variant::String)
-    root["inchi"] = molecule.data("inchi").toString().c_str();
+  if (molecule.data("name").type() == Variant::String) {
+    json.key("name");
+    json.stringValue(molecule.data("name").toString());
+  }
+  if (molecule.data("inchi").type() == Variant::String) {
+    json.key("inchi");
+    json.stringValue(molecule.data("inchi").toString());
+  }
 
   if (molecule.unitCell()) {
-    Value unitCell = Value(Json::objectValue);
-    unitCell["a"] = molecule.unitCell()->a();
-    unitCell["b"] = molecule.unitCell()->b();
-    unitCell["c"] = molecule.unitCell()->c();
-    unitCell["alpha"] = molecule.unitCell()->alpha() * RAD_TO_DEG;
-    unitCell["beta"]  = molecule.unitCell()->beta()  * RAD_TO_DEG;
-    unitCell["gamma"] = molecule.unitCell()->gamma() * RAD_TO_DEG;
-    root["unit cell"] = unitCell;
+    json.key("unit cell");
+    json.startObject();
+    json.key("a");
+    json.numberValue(molecule.unitCell()->a());
+    json.key("b");
+    json.numberValue(molecule.unitCell()->b());
+    json.key("c");
+    json.numberValue(molecule.unitCell()->c());
+    json.key("alpha");
+    json.numberValue(molecule.unitCell()->alpha() * RAD_TO_DEG);
+    json.key("beta");
+    json.numberValue(molecule.unitCell()->beta() * RAD_TO_DEG);
+    json.key("gamma");
+    json.numberValue(molecule.unitCell()->gamma() * RAD_TO_DEG);
+    json.endObject();
   }
 
   // Write out the basis set if we have one. FIXME: Complete implemnentation.
   if (molecule.basisSet()) {
-    Value basis = Value(Json::objectValue);
     const GaussianSet *gaussian =
         dynamic_cast<const GaussianSet *>(molecule.basisSet());
     if (gaussian) {
-      basis["basisType"] = "GTO";
       string type = "unknown";
       switch (gaussian->scfType()) {
       case Core::Rhf:
@@ -276,79 +520,126 @@ bool CjsonFormat::write(std::ostream &file, const Molecule &molecule)
       default:
         type = "unknown";
       }
-      basis["scfType"] = type;
-      root["basisSet"] = basis;
+      json.key("basisSet");
+      json.startObject();
+      json.key("basisType");
+      json.stringValue("GTO");
+      json.key("scfType");
+      json.stringValue(type);
+      json.endObject();
     }
   }
 
-  // Create and populate the atom arrays.
+  // Write the atom arrays straight from the molecule.
   if (molecule.atomCount()) {
-    Value elements(Json::arrayValue);
-    for (Index i = 0; i < molecule.atomCount(); ++i)
-      elements.append(molecule.atom(i).atomicNumber());
-    root["atoms"]["elements"]["number"] = elements;
-
-    // 3d positions:
-    if (molecule.atomPositions3d().size() == molecule.atomCount()) {
-      if (molecule.unitCell()) {
-        Value coordsFractional(Json::arrayValue);
-        Array<Vector3> fcoords;
-        CrystalTools::fractionalCoordinates(*molecule.unitCell(),
-                                            molecule.atomPositions3d(),
-                                            fcoords);
-        for (vector<Vector3>::const_iterator it = fcoords.begin(),
-             itEnd = fcoords.end(); it != itEnd; ++it) {
-          coordsFractional.append(it->x());
-          coordsFractional.append(it->y());
-          coordsFractional.append(it->z());
+    json.key("atoms");
+    json.startObject();
+    json.key("elements");
+    json.startObject();
+    json.key("number");
+    json.startArray();
+    const Array<unsigned char> &numbers = molecule.atomicNumbers();
+    for (Index i = 0; i < numbers.size(); ++i)
+      json.integerValue(numbers[i]);
+    json.endArray();
+    json.endObject();
+
+    bool has3d = molecule.atomPositions3d().size() == molecule.atomCount();
+    bool has2d = molecule.atomPositions2d().size() == molecule.atomCount();
+    if (has3d || has2d) {
+      json.key("coords");
+      json.startObject();
+      // 3d positions:
+      if (has3d) {
+        if (molecule.unitCell()) {
+          Array<Vector3> fcoords;
+          CrystalTools::fractionalCoordinates(*molecule.unitCell(),
+                                              molecule.atomPositions3d(),
+                                              fcoords);
+          json.key("3d fractional");
+          json.startArray();
+          for (vector<Vector3>::const_iterator it = fcoords.begin(),
+               itEnd = fcoords.end(); it != itEnd; ++it) {
+            json.numberValue(it->x());
+            json.numberValue(it->y());
+            json.numberValue(it->z());
+          }
+          json.endArray();
         }
-        root["atoms"]["coords"]["3d fractional"] = coordsFractional;
-      }
-      else {
-        Value coords3d(Json::arrayValue);
-        for (vector<Vector3>::const_iterator
-             it = molecule.atomPositions3d().begin(),
-             itEnd = molecule.atomPositions3d().end(); it != itEnd; ++it) {
-          coords3d.append(it->x());
-          coords3d.append(it->y());
-          coords3d.append(it->z());
+        else {
+          json.key("3d");
+          json.startArray();
+          for (vector<Vector3>::const_iterator
+               it = molecule.atomPositions3d().begin(),
+               itEnd = molecule.atomPositions3d().end(); it != itEnd; ++it) {
+            json.numberValue(it->x());
+            json.numberValue(it->y());
+            json.numberValue(it->z());
+          }
+          json.endArray();
         }
-        root["atoms"]["coords"]["3d"] = coords3d;
       }
-    }
 
-    // 2d positions:
-    if (molecule.atomPositions2d().size() == molecule.atomCount()) {
-      Value coords2d(Json::arrayValue);
-      for (vector<Vector2>::const_iterator
-           it = molecule.atomPositions2d().begin(),
-           itEnd = molecule.atomPositions2d().end(); it != itEnd; ++it) {
-        coords2d.append(it->x());
-        coords2d.append(it->y());
+      // 2d positions:
+      if (has2d) {
+        json.key("2d");
+        json.startArray();
+        for (vector<Vector2>::const_iterator
+             it = molecule.atomPositions2d().begin(),
+             itEnd = molecule.atomPositions2d().end(); it != itEnd; ++it) {
+          json.numberValue(it->x());
+          json.numberValue(it->y());
+        }
+        json.endArray();
       }
-      root["atoms"]["coords"]["2d"] = coords2d;
+      json.endObject();
     }
+    json.endObject();
   }
 
-  // Create and populate the bond arrays.
+  // Write the bond arrays.
   if (molecule.bondCount()) {
-    Value connections(Json::arrayValue);
-    Value order(Json::arrayValue);
-    for (Index i = 0; i < molecule.bondCount(); ++i) {
-      Bond bond = molecule.bond(i);
-      connections.append(static_cast<Value::UInt>(bond.atom1().index()));
-      connections.append(static_cast<Value::UInt>(bond.atom2().index()));
-      order.append(bond.order());
+    const Array<std::pair<Index, Index> > &pairs = molecule.bondPairs();
+    const Array<unsigned char> &orders = molecule.bondOrders();
+    json.key("bonds");
+    json.startObject();
+    json.key("connections");
+    json.startObject();
+    json.key("index");
+    json.startArray();
+    for (Index i = 0; i < pairs.size(); ++i) {
+      json.integerValue(static_cast<long>(pairs[i].first));
+      json.integerValue(static_cast<long>(pairs[i].second));
     }
-    root["bonds"]["connections"]["index"] = connections;
-    root["bonds"]["order"] = order;
+    json.endArray();
+    json.endObject();
+    json.key("order");
+    json.startArray();
+    for (Index i = 0; i < orders.size(); ++i)
+      json.integerValue(orders[i]);
+    json.endArray();
+    json.endObject();
   }
 
-  writer.write(file, root);
+  json.endObject();
+  json.flush();
+  // Separate the molecules of a multi-molecule file.
+  file.put('\n');
 
   return true;
 }
 
+bool CjsonFormat::skipRecord(std::istream &in)
+{
+  JsonReader reader(in);
+  ObjectHandler handler;
+  if (!reader.parse(handler)) {
+    appendError("Error: Input is not a complete JSON object.");
+    return false;
+  }
+  return true;
+}
+
 vector<std::string> CjsonFormat::fileExtensions() const
 {
   vector<std::string> ext;
@@ -26,6 +26,10 @@ namespace Io {
  * @class CjsonFormat cjsonformat.h <avogadro/io/cjsonformat.h>
  * @brief Implementation of the Chemical JSON format.
  * @author Marcus D. Hanwell
+ *
+ * Documents are parsed and written as streams, without holding a complete
+ * JSON document in memory, so that large systems can be read and written with
+ * little memory beyond that of the molecule itself.
  */
 
 class AVOGADROIO_EXPORT CjsonFormat : public FileFormat
@@ -36,7 +40,7 @@ public:
 
   Operations supportedOperations() const AVO_OVERRIDE
   {
-    return ReadWrite | File | Stream | String;
+    return ReadWrite | MultiMolecule | File | Stream | String;
   }
 
   FileFormat * newInstance() const AVO_OVERRIDE { return new CjsonFormat; }
@@ -57,6 +61,24 @@ public:
 
   bool read(std::istream &in, Core::Molecule &molecule) AVO_OVERRIDE;
   bool write(std::ostream &out, const Core::Molecule &molecule) AVO_OVERRIDE;
+
+  /**
+   * @return True if the output is indented to be read by people, true by
+   * default.
+   */
+  bool prettyPrint() const { return m_prettyPrint; }
+
+  /**
+   * Write indented output if @p pretty is true, otherwise write compact output
+   * without any whitespace.
+   */
+  void setPrettyPrint(bool pretty) { m_prettyPrint = pretty; }
+
+protected:
+  bool skipRecord(std::istream &in) AVO_OVERRIDE;
+
+private:
+  bool m_prettyPrint;
 };
 
 } // end Io namespace
@@ -19,9 +19,11 @@
 #include "hdf5dataformat.h"
 
 #include <avogadro/core/crystaltools.h>
+#include <avogadro/core/cube.h>
 #include <avogadro/core/molecule.h>
 #include <avogadro/core/elements.h>
 #include <avogadro/core/matrix.h>
+#include <avogadro/core/trajectorysource.h>
 #include <avogadro/core/unitcell.h>
 #include <avogadro/core/utilities.h>
 
@@ -29,6 +31,7 @@
 
 #include <bitset>
 #include <cmath>
+#include <limits>
 #include <streambuf>
 #include <sstream>
 #include <map>
@@ -55,6 +58,73 @@ using namespace Core;
 
 namespace {
 
+/**
+ * Reads the frames of a trajectory from the HDF5 file written with the CML
+ * file, one hyperslab at a time. The file is only open while a frame is read,
+ * so that it can be written again while the molecule is open.
+ */
+class Hdf5Trajectory : public TrajectorySource
+{
+public:
+  Hdf5Trajectory(const std::string &fileName_, const std::string &path,
+                 size_t numAtoms, size_t frames)
+    : m_fileName(fileName_), m_path(path), m_numAtoms(numAtoms),
+      m_frames(frames)
+  {
+  }
+
+  TrajectorySource * clone() const
+  {
+    return new Hdf5Trajectory(m_fileName, m_path, m_numAtoms, m_frames);
+  }
+
+  size_t frameCount() const { return m_frames; }
+
+  bool readFrame(size_t frame, Array<Vector3> &positions)
+  {
+    if (frame >= m_frames || m_numAtoms == 0)
+      return false;
+    Hdf5DataFormat hdf5;
+    if (!hdf5.openFile(m_fileName, Hdf5DataFormat::ReadOnly))
+      return false;
+    std::vector<size_t> offset(3, 0);
+    offset[0] = frame;
+    std::vector<size_t> count(3, 1);
+    count[1] = m_numAtoms;
+    count[2] = 3;
+    positions.resize(m_numAtoms);
+    return hdf5.readHyperslab(m_path, offset, count, positions.data()->data());
+  }
+
+  const std::string & fileName() const { return m_fileName; }
+
+private:
+  std::string m_fileName;
+  std::string m_path;
+  size_t m_numAtoms;
+  size_t m_frames;
+};
+
+// Vectors are stored in attributes as three numbers separated by spaces.
+std::string vectorString(const Vector3 &v)
+{
+  std::ostringstream stream;
+  stream.precision(std::numeric_limits<double>::digits10 + 2);
+  stream << v.x() << " " << v.y() << " " << v.z();
+  return stream.str();
+}
+
+bool parseVector(const std::string &str, Vector3 &v)
+{
+  std::vector<std::string> tokens = split(str, ' ');
+  if (tokens.size() != 3)
+    return false;
+  bool ok = true;
+  for (int i = 0; i < 3 && ok; ++i)
+    v[i] = lexicalCast<Real>(tokens[i], ok);
+  return ok;
+}
+
 class CmlFormatPrivate
 {
 public:
@@ -78,6 +148,10 @@ public:
         success = atoms();
       if (success)
         success = bonds();
+      if (success)
+        coordinateSets();
+      if (success)
+        cubes();
     }
     else {
       error += "Error, no molecule node found.";
@@ -404,6 +478,88 @@ public:
     return true;
   }
 
+  bool coordinateSets()
+  {
+    xml_node dataNode =
+        moleculeNode.child("coordinateSetArray").child("hdf5data");
+    if (!dataNode)
+      return true;
+
+    // Only the shape of the frames is read here, the frames are read from the
+    // file as they are used.
+    std::string path = dataNode.text().as_string();
+    Hdf5DataFormat hdf5;
+    if (!hdf5.openFile(filename + ".h5", Hdf5DataFormat::ReadOnly)) {
+      error += "CmlFormatPrivate::coordinateSets: Cannot open file "
+               + filename + ".h5.";
+      return false;
+    }
+    std::vector<int> dims = hdf5.datasetDimensions(path);
+    hdf5.closeFile();
+
+    if (dims.size() != 3 || dims[0] <= 0 || dims[2] != 3
+        || molecule->atomCount() == 0
+        || static_cast<size_t>(dims[1]) != molecule->atomCount()) {
+      error += "CmlFormatPrivate::coordinateSets: Data set '" + path
+               + "' in " + filename + ".h5 does not match the atoms.";
+      return false;
+    }
+
+    molecule->setTrajectorySource(
+          new Hdf5Trajectory(filename + ".h5", path, molecule->atomCount(),
+                             static_cast<size_t>(dims[0])));
+    return true;
+  }
+
+  bool cubes()
+  {
+    xml_node cubeNode = moleculeNode.child("cubeArray").child("cube");
+    if (!cubeNode)
+      return true;
+
+    Hdf5DataFormat hdf5;
+    if (!hdf5.openFile(filename + ".h5", Hdf5DataFormat::ReadOnly)) {
+      error += "CmlFormatPrivate::cubes: Cannot open file " + filename
+               + ".h5.";
+      return false;
+    }
+
+    bool ok = true;
+    for (; cubeNode; cubeNode = cubeNode.next_sibling("cube")) {
+      std::string path = cubeNode.child("hdf5data").text().as_string();
+      Vector3 min;
+      Vector3 spacing;
+      if (!parseVector(cubeNode.attribute("min").as_string(), min)
+          || !parseVector(cubeNode.attribute("spacing").as_string(),
+                          spacing)) {
+        error += "CmlFormatPrivate::cubes: Invalid limits for cube '"
+                 + path + "'.";
+        ok = false;
+        continue;
+      }
+
+      std::vector<double> values;
+      std::vector<int> dims = hdf5.readDataset(path, values);
+      if (dims.size() != 3) {
+        error += "CmlFormatPrivate::cubes: Unable to read data set '" + path
+                 + "' from " + filename + ".h5";
+        ok = false;
+        continue;
+      }
+
+      Cube *cube = molecule->addCube();
+      cube->setLimits(min, Vector3i(dims[0], dims[1], dims[2]), spacing);
+      cube->setName(cubeNode.attribute("name").as_string());
+      cube->setCubeType(static_cast<Cube::Type>(
+                          cubeNode.attribute("cubeType").as_int(Cube::None)));
+      cube->data()->swap(values);
+      cube->updateMinMax();
+    }
+
+    hdf5.closeFile();
+    return ok;
+  }
+
   bool success;
   Molecule *molecule;
   xml_node moleculeNode;
@@ -530,11 +686,114 @@ bool CmlFormat::write(std::ostream &out, const Core::Molecule &mol)
     bondNode.append_attribute("order") = b.order();
   }
 
+  // Coordinate sets, cubes and matrices are written to an HDF5 file next to
+  // the CML file. A trajectory being read from that file is loaded first.
+  VariantMap dataMap = mol.dataMap();
+  const Index frames = static_cast<Index>(mol.coordinate3dCount());
+  bool hasLargeData = !fileName().empty()
+      && ((frames > 0 && mol.atomCount() > 0) || mol.cubeCount() > 0);
+  for (VariantMap::const_iterator it = dataMap.constBegin(),
+       itEnd = dataMap.constEnd(); it != itEnd && !hasLargeData; ++it) {
+    if ((*it).second.type() == Variant::Matrix)
+      hasLargeData = true;
+  }
+
+  std::vector<Array<Vector3> > loadedFrames;
+  const Hdf5Trajectory *trajectory =
+      dynamic_cast<const Hdf5Trajectory *>(mol.trajectorySource());
+  if (hasLargeData && trajectory
+      && trajectory->fileName() == fileName() + ".h5") {
+    loadedFrames.resize(frames);
+    for (Index i = 0; i < frames; ++i)
+      mol.coordinate3d(static_cast<int>(i), loadedFrames[i]);
+  }
+
   Hdf5DataFormat hdf5;
-  bool openFile = true;
+  hdf5.setCompressionLevel(1);
+  if (hasLargeData
+      && !hdf5.openFile(fileName() + ".h5", Hdf5DataFormat::ReadWriteAppend)) {
+    appendError("CmlFormat::writeFile: Cannot open file: "
+                + fileName() + ".h5");
+  }
+
+  if (hdf5.isOpen() && !fileName().empty() && frames > 0
+      && mol.atomCount() > 0) {
+    // One frame per chunk, so that a frame is read in a single access.
+    const std::string h5Path("molecule/coordinateSets");
+    size_t dims[3] = { frames, mol.atomCount(), 3 };
+    size_t chunkDims[3] = { 1, mol.atomCount(), 3 };
+    std::vector<size_t> offset(3, 0);
+    std::vector<size_t> count(dims, dims + 3);
+    count[0] = 1;
+    bool ok = hdf5.createDataset(h5Path, 3, dims, chunkDims);
+    Array<Vector3> positions;
+    for (Index i = 0; ok && i < frames; ++i) {
+      const Array<Vector3> *frame = &positions;
+      if (!loadedFrames.empty())
+        frame = &loadedFrames[i];
+      else if (!mol.coordinate3d(static_cast<int>(i), positions))
+        positions.clear();
+      offset[0] = i;
+      ok = frame->size() == mol.atomCount()
+          && hdf5.writeHyperslab(h5Path, offset, count,
+                                 frame->data()->data());
+    }
+
+    if (ok) {
+      xml_node dataNode =
+          moleculeNode.append_child("coordinateSetArray").append_child(
+            "hdf5data");
+      dataNode.append_attribute("dataType") = "xsd:double";
+      dataNode.append_attribute("ndims") = "3";
+      std::ostringstream stream;
+      stream << frames << " " << mol.atomCount() << " 3";
+      dataNode.append_attribute("dims") = stream.str().c_str();
+      dataNode.text() = h5Path.c_str();
+    }
+    else {
+      appendError("CmlFormat::writeFile: Cannot write the coordinate sets to "
+                  + fileName() + ".h5");
+    }
+  }
+
+  if (hdf5.isOpen() && !fileName().empty() && mol.cubeCount() > 0) {
+    xml_node cubeArrayNode = moleculeNode.append_child("cubeArray");
+    for (Index i = 0; i < mol.cubeCount(); ++i) {
+      const Cube *cube = mol.cube(i);
+      const std::vector<double> &values = *cube->data();
+      Vector3i points = cube->dimensions();
+      size_t dims[3] = { static_cast<size_t>(points.x()),
+                         static_cast<size_t>(points.y()),
+                         static_cast<size_t>(points.z()) };
+      std::ostringstream h5Path;
+      h5Path << "molecule/cubes/" << i;
+      // Blocks of up to 32^3 points keep regions of the grid quick to read.
+      size_t chunkDims[3] = { 32, 32, 32 };
+      if (values.empty() || values.size() != dims[0] * dims[1] * dims[2]
+          || !hdf5.writeDataset(h5Path.str(), values, 3, dims, chunkDims)) {
+        appendError("CmlFormat::writeFile: Cannot write cube '" + cube->name()
+                    + "' to " + fileName() + ".h5");
+        continue;
+      }
+
+      xml_node cubeNode = cubeArrayNode.append_child("cube");
+      cubeNode.append_attribute("name") = cube->name().c_str();
+      cubeNode.append_attribute("cubeType") =
+          static_cast<int>(cube->cubeType());
+      cubeNode.append_attribute("min") = vectorString(cube->min()).c_str();
+      cubeNode.append_attribute("spacing") =
+          vectorString(cube->spacing()).c_str();
+      xml_node dataNode = cubeNode.append_child("hdf5data");
+      dataNode.append_attribute("dataType") = "xsd:double";
+      dataNode.append_attribute("ndims") = "3";
+      std::ostringstream stream;
+      stream << dims[0] << " " << dims[1] << " " << dims[2];
+      dataNode.append_attribute("dims") = stream.str().c_str();
+      dataNode.text() = h5Path.str().c_str();
+    }
+  }
 
   xml_node dataMapNode = moleculeNode.append_child("dataMap");
-  VariantMap dataMap = mol.dataMap();
   for (VariantMap::const_iterator it = dataMap.constBegin(),
        itEnd = dataMap.constEnd(); it != itEnd; ++it) {
     const std::string &name_ = (*it).first;
@@ -592,14 +851,6 @@ bool CmlFormat::write(std::ostream &out, const Core::Molecule &mol)
       dataNode.text() = var.toString().c_str();
       break;
     case Variant::Matrix: {
-      if(openFile) {
-        if (!hdf5.openFile(fileName() + ".h5", Hdf5DataFormat::ReadWriteAppend)) {
-          appendError("CmlFormat::writeFile: Cannot open file: "
-                      + fileName() + ".h5");
-        }
-        openFile = false;
-      }
-
       dataNode.set_name("hdf5data");
       dataNode.append_attribute("dataType") = "xsd:double";
       dataNode.append_attribute("ndims") = "2";
@@ -16,6 +16,8 @@
 
 #include "fileformat.h"
 
+#include <avogadro/core/molecule.h>
+
 #include <fstream>
 #include <locale>
 #include <sstream>
@@ -28,7 +30,7 @@ using std::locale;
 using std::ofstream;
 
 FileFormat::FileFormat()
-  : m_mode(None), m_in(NULL), m_out(NULL)
+  : m_mode(None), m_in(NULL), m_out(NULL), m_record(0)
 {
 }
 
@@ -85,13 +87,114 @@ void FileFormat::close()
     m_out = NULL;
   }
   m_mode = None;
+  m_record = 0;
+  m_recordOffsets.clear();
 }
 
 bool FileFormat::readMolecule(Core::Molecule &molecule)
+{
+  if (!m_in || atEnd())
+    return false;
+  if (!read(*m_in, molecule))
+    return false;
+  ++m_record;
+  return true;
+}
+
+bool FileFormat::atEnd()
+{
+  if (!m_in || !m_in->good())
+    return true;
+  std::streampos start = m_in->tellg();
+  *m_in >> std::ws;
+  bool end = m_in->eof();
+  m_in->clear();
+  m_in->seekg(start);
+  return end;
+}
+
+bool FileFormat::indexRecords()
 {
   if (!m_in)
     return false;
-  return read(*m_in, molecule);
+
+  m_recordOffsets.clear();
+  m_in->clear();
+  m_in->seekg(0);
+  std::vector<std::streamoff> offsets;
+  while (!atEnd()) {
+    std::streamoff offset = m_in->tellg();
+    if (!skipRecord(*m_in)) {
+      std::ostringstream errorStream;
+      errorStream << "Error indexing record " << offsets.size() << ".";
+      appendError(errorStream.str());
+      m_record = 0;
+      m_in->clear();
+      m_in->seekg(0);
+      return false;
+    }
+    offsets.push_back(offset);
+  }
+  m_recordOffsets.swap(offsets);
+
+  // Return to the record that was going to be read next.
+  if (m_record < m_recordOffsets.size()) {
+    m_in->clear();
+    m_in->seekg(m_recordOffsets[m_record]);
+  }
+  return true;
+}
+
+bool FileFormat::seekRecord(size_t index)
+{
+  if (!m_in)
+    return false;
+
+  if (!m_recordOffsets.empty()) {
+    if (index >= m_recordOffsets.size())
+      return false;
+    m_in->clear();
+    m_in->seekg(m_recordOffsets[index]);
+    m_record = index;
+    return true;
+  }
+
+  // Without an index the records in between are skipped.
+  if (index < m_record) {
+    m_in->clear();
+    m_in->seekg(0);
+    m_record = 0;
+  }
+  while (m_record < index) {
+    if (atEnd() || !skipRecord(*m_in))
+      return false;
+    ++m_record;
+  }
+  return !atEnd();
+}
+
+bool FileFormat::readRecord(std::string &record)
+{
+  if (!m_in || atEnd())
+    return false;
+
+  std::streampos start = m_in->tellg();
+  if (!skipRecord(*m_in))
+    return false;
+  m_in->clear();
+  std::streampos end = m_in->tellg();
+  if (end == std::streampos(-1)) {
+    // The record ran to the end of the file.
+    m_in->seekg(0, std::ios_base::end);
+    end = m_in->tellg();
+  }
+
+  record.resize(static_cast<size_t>(end - start));
+  m_in->seekg(start);
+  if (!record.empty())
+    m_in->read(&record[0], static_cast<std::streamsize>(record.size()));
+  ++m_record;
+  return !m_in->fail();
 }
 
 bool FileFormat::writeMolecule(const Core::Molecule &molecule)
@@ -108,7 +211,7 @@ bool FileFormat::readFile(const std::string &fileName_,
   if (!result)
     return false;
 
-  result = readMolecule(molecule);
+  result = read(*m_in, molecule);
   close();
   return result;
 }
@@ -146,6 +249,12 @@ bool FileFormat::writeString(std::string &string,
   return result;
 }
 
+bool FileFormat::skipRecord(std::istream &in)
+{
+  Core::Molecule molecule;
+  return read(in, molecule);
+}
+
 void FileFormat::clear()
 {
   m_fileName.clear();
@@ -43,6 +43,13 @@ namespace Io {
  * operate on the given streams. Several other signatures are available for
  * convenience. If there is an error reading or writing a file the string
  * returned by error() will give more details.
+ *
+ * Formats supporting MultiMolecule can be streamed. When opened in Read and
+ * MultiMolecule mode each call to readMolecule() reads the next record, so
+ * only one molecule needs to be held in memory at a time. The records can be
+ * indexed with indexRecords() for random access with seekRecord(). When opened
+ * in Write and MultiMolecule mode each call to writeMolecule() appends a
+ * record.
  */
 
 class AVOGADROIO_EXPORT FileFormat
@@ -87,6 +94,14 @@ public:
    */
   Operation mode() { return m_mode; }
 
+  /**
+   * @brief Set the mode without opening a file, this affects the streams and
+   * strings passed to read() and write(). For example, the records written in
+   * Write and MultiMolecule mode can be concatenated into one file.
+   * @param mode_ The new mode.
+   */
+  void setMode(Operation mode_) { m_mode = mode_; }
+
   /**
    * @brief Check if the supplied mode(s) is being used.
    * @param isInMode The mode(s) to test against
@@ -104,10 +119,55 @@ public:
    * be empty. This can be used to read in one or more molecules from a given
    * file using repeated calls for each molecule.
    * @param molecule The molecule the data will be read into.
-   * @return True on success, false on failure.
+   * @return True on success, false on failure. At the end of the file false is
+   * returned without an error being added.
    */
   bool readMolecule(Core::Molecule &molecule);
 
+  /**
+   * @brief Check whether there are any more records in the file opened for
+   * reading, only white space remains after the last record.
+   * @return True if there are no records left to be read.
+   */
+  bool atEnd();
+
+  /**
+   * @brief Index the records in the file opened for reading, so that they can
+   * be sought by their index in constant time. Only the offsets of the records
+   * are kept, the current record is not changed.
+   * @return True on success, false if the file could not be indexed.
+   */
+  bool indexRecords();
+
+  /**
+   * @return The number of records in the file, this is only known once the
+   * file has been indexed by indexRecords(), zero otherwise.
+   */
+  size_t recordCount() const { return m_recordOffsets.size(); }
+
+  /**
+   * @return The index of the record that will be read by the next call to
+   * readMolecule().
+   */
+  size_t currentRecord() const { return m_record; }
+
+  /**
+   * @brief Move to the record at @p index, so that it is read by the next call
+   * to readMolecule(). If the file has not been indexed, the records before it
+   * are skipped.
+   * @param index The index of the record, starting at zero.
+   * @return True on success, false if there is no such record.
+   */
+  bool seekRecord(size_t index);
+
+  /**
+   * @brief Read the text of the next record without parsing it, so that it
+   * can be parsed later with readString(), possibly in another thread.
+   * @param record The string the text of the record will be read into.
+   * @return True on success, false at the end of the file or on failure.
+   */
+  bool readRecord(std::string &record);
+
   /**
    * @brief Write out a molecule. This can be used to write one or more
    * molecules to a given file using repeated calls for each molecule.
@@ -224,6 +284,14 @@ public:
   virtual std::vector<std::string> mimeTypes() const = 0;
 
 protected:
+  /**
+   * @brief Skip over the next record in the @p in stream. The default
+   * implementation reads the record into a temporary molecule, formats should
+   * override this if records can be delimited without being parsed.
+   * @return True on success, false on failure.
+   */
+  virtual bool skipRecord(std::istream &in);
+
   /**
    * @brief Append an error to the error string for the format.
    * @param errorString The error to be added.
@@ -239,6 +307,10 @@ private:
   Operation m_mode;
   std::istream *m_in;
   std::ostream *m_out;
+
+  // The record to be read next, and the offsets of all records if indexed.
+  size_t m_record;
+  std::vector<std::streamoff> m_recordOffsets;
 };
 
 inline FileFormat::Operation operator|(FileFormat::Operation a,
@@ -18,6 +18,7 @@
 
 #include "fileformat.h"
 
+#include "binaryformat.h"
 #include "cmlformat.h"
 #include "cjsonformat.h"
 #include "gromacsformat.h"
@@ -31,6 +32,45 @@
 namespace Avogadro {
 namespace Io {
 
+namespace {
+// Guess the file extension from the file name if none was supplied.
+std::string guessExtension(const std::string &fileName,
+                           const std::string &fileExtension)
+{
+  if (!fileExtension.empty())
+    return fileExtension;
+  size_t pos = fileName.find_last_of('.');
+  return fileName.substr(pos + 1);
+}
+
+// Hold a lock on the format tables for the lifetime of the object.
+class ReadLocker
+{
+public:
+  explicit ReadLocker(Core::ReadWriteLock &lock) : m_lock(lock)
+  {
+    m_lock.lockForRead();
+  }
+  ~ReadLocker() { m_lock.unlock(); }
+
+private:
+  Core::ReadWriteLock &m_lock;
+};
+
+class WriteLocker
+{
+public:
+  explicit WriteLocker(Core::ReadWriteLock &lock) : m_lock(lock)
+  {
+    m_lock.lockForWrite();
+  }
+  ~WriteLocker() { m_lock.unlock(); }
+
+private:
+  Core::ReadWriteLock &m_lock;
+};
+}
+
 FileFormatManager& FileFormatManager::instance()
 {
   static FileFormatManager instance;
@@ -41,76 +81,66 @@ bool FileFormatManager::readFile(Core::Molecule &molecule,
                                  const std::string &fileName,
                                  const std::string &fileExtension) const
 {
-  FileFormat *format(NULL);
-  if (fileExtension.empty()) {
-    // We need to guess the file extension.
-    size_t pos = fileName.find_last_of('.');
-    format = filteredFormatFromFormatMap(fileName.substr(pos + 1),
-                                         FileFormat::Read | FileFormat::File,
-                                         m_fileExtensions);
-  }
-  else {
-    format = filteredFormatFromFormatMap(fileExtension,
-                                         FileFormat::Read | FileFormat::File,
-                                         m_fileExtensions);
-  }
+  AVO_UNIQUE_PTR<FileFormat> format(
+        newFormatFromFileExtension(guessExtension(fileName, fileExtension),
+                                   FileFormat::Read | FileFormat::File));
   if (!format)
     return false;
 
-  AVO_UNIQUE_PTR<FileFormat> formatInstance(format->newInstance());
-  return formatInstance->readFile(fileName, molecule);
+  return format->readFile(fileName, molecule);
 }
 
 bool FileFormatManager::writeFile(const Core::Molecule &molecule,
                                   const std::string &fileName,
                                   const std::string &fileExtension) const
 {
-  FileFormat *format(NULL);
-  if (fileExtension.empty()) {
-    // We need to guess the file extension.
-    size_t pos = fileName.find_last_of('.');
-    format = filteredFormatFromFormatMap(fileName.substr(pos + 1),
-                                         FileFormat::Write | FileFormat::File,
-                                         m_fileExtensions);
-  }
-  else {
-    format = filteredFormatFromFormatMap(fileExtension,
-                                         FileFormat::Write | FileFormat::File,
-                                         m_fileExtensions);
-  }
+  AVO_UNIQUE_PTR<FileFormat> format(
+        newFormatFromFileExtension(guessExtension(fileName, fileExtension),
+                                   FileFormat::Write | FileFormat::File));
   if (!format)
     return false;
 
-  AVO_UNIQUE_PTR<FileFormat> formatInstance(format->newInstance());
-  return formatInstance->writeFile(fileName, molecule);
+  return format->writeFile(fileName, molecule);
+}
+
+FileFormat * FileFormatManager::openFile(const std::string &fileName,
+                                        FileFormat::Operation mode,
+                                        const std::string &fileExtension) const
+{
+  FileFormat *format(
+        newFormatFromFileExtension(guessExtension(fileName, fileExtension),
+                                   mode | FileFormat::File));
+  if (format && !format->open(fileName, mode)) {
+    delete format;
+    format = NULL;
+  }
+  return format;
 }
 
 bool FileFormatManager::readString(Core::Molecule &molecule,
                                    const std::string &string,
                                    const std::string &fileExtension) const
 {
-  FileFormat *format(filteredFormatFromFormatMap(
-                       fileExtension, FileFormat::Read | FileFormat::String,
-                       m_fileExtensions));
+  AVO_UNIQUE_PTR<FileFormat> format(
+        newFormatFromFileExtension(fileExtension,
+                                   FileFormat::Read | FileFormat::String));
   if (!format)
     return false;
 
-  AVO_UNIQUE_PTR<FileFormat> formatInstance(format->newInstance());
-  return formatInstance->readString(string, molecule);
+  return format->readString(string, molecule);
 }
 
 bool FileFormatManager::writeString(const Core::Molecule &molecule,
                                     std::string &string,
                                     const std::string &fileExtension) const
 {
-  FileFormat *format(filteredFormatFromFormatMap(
-                       fileExtension, FileFormat::Write | FileFormat::String,
-                       m_fileExtensions));
+  AVO_UNIQUE_PTR<FileFormat> format(
+        newFormatFromFileExtension(fileExtension,
+                                   FileFormat::Write | FileFormat::String));
   if (!format)
     return false;
 
-  AVO_UNIQUE_PTR<FileFormat> formatInstance(format->newInstance());
-  return formatInstance->writeString(string, molecule);
+  return format->writeString(string, molecule);
 }
 
 bool FileFormatManager::registerFormat(FileFormat *format)
@@ -125,6 +155,7 @@ bool FileFormatManager::unregisterFormat(const std::string &identifier)
 
 bool FileFormatManager::addFormat(FileFormat *format)
 {
+  WriteLocker locker(m_lock);
   if (!format) {
     appendError("Supplied format was null.");
     return false;
@@ -185,6 +216,7 @@ void removeFromMap(Map &map, const VectorOfKeys &keys, const ValueType &val)
 
 bool FileFormatManager::removeFormat(const std::string &identifier)
 {
+  WriteLocker locker(m_lock);
   FormatIdVector ids = m_identifiers[identifier];
   m_identifiers.erase(identifier);
 
@@ -212,6 +244,7 @@ FileFormat *
 FileFormatManager::newFormatFromIdentifier(const std::string &id,
                                            FileFormat::Operations filter) const
 {
+  ReadLocker locker(m_lock);
   FileFormat *format(filteredFormatFromFormatMap(id, filter, m_identifiers));
   return format ? format->newInstance() : NULL;
 }
@@ -220,6 +253,7 @@ FileFormat *
 FileFormatManager::newFormatFromMimeType(const std::string &mime,
                                          FileFormat::Operations filter) const
 {
+  ReadLocker locker(m_lock);
   FileFormat *format(filteredFormatFromFormatMap(mime, filter, m_mimeTypes));
   return format ? format->newInstance() : NULL;
 }
@@ -227,6 +261,7 @@ FileFormatManager::newFormatFromMimeType(const std::string &mime,
 FileFormat * FileFormatManager::newFormatFromFileExtension(
     const std::string &extension, FileFormat::Operations filter) const
 {
+  ReadLocker locker(m_lock);
   FileFormat *format(filteredFormatFromFormatMap(extension, filter,
                                                  m_fileExtensions));
   return format ? format->newInstance() : NULL;
@@ -235,28 +270,35 @@ FileFormat * FileFormatManager::newFormatFromFileExtension(
 std::vector<std::string>
 FileFormatManager::identifiers(FileFormat::Operations filter) const
 {
+  ReadLocker locker(m_lock);
   return filteredKeysFromFormatMap(filter, m_identifiers);
 }
 
 std::vector<std::string>
 FileFormatManager::mimeTypes(FileFormat::Operations filter) const
 {
+  ReadLocker locker(m_lock);
   return filteredKeysFromFormatMap(filter, m_mimeTypes);
 }
 
 std::vector<std::string>
 FileFormatManager::fileExtensions(FileFormat::Operations filter) const
 {
+  ReadLocker locker(m_lock);
   return filteredKeysFromFormatMap(filter, m_fileExtensions);
 }
 
 std::vector<const FileFormat *> FileFormatManager::fileFormats(
     FileFormat::Operations filter) const
 {
+  ReadLocker locker(m_lock);
   std::vector<const FileFormat *> result;
 
   for (std::vector<FileFormat *>::const_iterator it = m_formats.begin(),
        itEnd = m_formats.end(); it != itEnd; ++it) {
+    // Removed formats leave a null entry behind.
+    if (*it == NULL)
+      continue;
     if (filter == FileFormat::None
         || (filter & (*it)->supportedOperations()) == filter) {
       result.push_back(*it);
@@ -269,6 +311,7 @@ std::vector<const FileFormat *>
 FileFormatManager::fileFormatsFromMimeType(
     const std::string &mimeType, FileFormat::Operations filter) const
 {
+  ReadLocker locker(m_lock);
   std::vector<FileFormat *> matches =
       filteredFormatsFromFormatMap(mimeType, filter, m_mimeTypes);
 
@@ -279,6 +322,7 @@ std::vector<const FileFormat *>
 FileFormatManager::fileFormatsFromFileExtension(
     const std::string &extension, FileFormat::Operations filter) const
 {
+  ReadLocker locker(m_lock);
   std::vector<FileFormat *> matches =
       filteredFormatsFromFormatMap(extension, filter, m_fileExtensions);
 
@@ -287,11 +331,13 @@ FileFormatManager::fileFormatsFromFileExtension(
 
 std::string FileFormatManager::error() const
 {
+  ReadLocker locker(m_lock);
   return m_error;
 }
 
 FileFormatManager::FileFormatManager()
 {
+  addFormat(new BinaryFormat);
   addFormat(new CmlFormat);
   addFormat(new CjsonFormat);
   addFormat(new GromacsFormat);
@@ -21,6 +21,8 @@
 
 #include "fileformat.h" // For FileFormat::Operation enum.
 
+#include <avogadro/core/readwritelock.h>
+
 #include <vector>
 #include <map>
 #include <string>
@@ -44,6 +46,10 @@ namespace Io {
  * All files IO can take place independent of this manager, but for automated
  * registration and look up this is the preferred API. It is possible to use
  * the convenience API without ever dealing directly with a format class.
+ *
+ * The manager may be used from several threads. The formats it holds are only
+ * prototypes, each thread should work with its own instances obtained from
+ * the newFormatFrom methods, or FileFormat::newInstance().
  */
 
 class AVOGADROIO_EXPORT FileFormatManager
@@ -71,6 +77,18 @@ public:
   bool writeFile(const Core::Molecule &molecule, const std::string &fileName,
                  const std::string &fileExtension = std::string()) const;
 
+  /**
+   * Open @p fileName for streaming in the given @p mode, inferring the
+   * @p fileExtension if it is empty. The mode should include Read or Write,
+   * along with MultiMolecule to read or write a molecule per record using
+   * FileFormat::readMolecule() and FileFormat::writeMolecule().
+   * @return A new format instance with the file open, ownership passes to the
+   * caller. NULL if no suitable format was found or the file failed to open.
+   */
+  FileFormat * openFile(const std::string &fileName,
+                        FileFormat::Operation mode,
+                        const std::string &fileExtension = std::string()) const;
+
   /**
    * Load @p molecule with the contents of @p string, using the supplied
    * @p fileExtension to determine the format.
@@ -318,6 +336,9 @@ private:
   FormatIdMap m_fileExtensions;
 
   std::string m_error;
+
+  // Guards the formats, their maps and the error string.
+  mutable Core::ReadWriteLock m_lock;
 };
 
 } // end Io namespace
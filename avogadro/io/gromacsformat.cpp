@@ -34,6 +34,7 @@ namespace Io {
 
 using Core::Atom;
 using Core::Molecule;
+using Core::StringView;
 using Core::UnitCell;
 using Core::lexicalCast;
 using Core::trimmed;
@@ -89,6 +90,7 @@ bool GromacsFormat::read(std::istream &in, Molecule &molecule)
   Vector3 pos;
   while (numAtoms-- > 0) {
     getline(in, buffer);
+    StringView line(buffer);
     // Figure out the distance between decimal points, implement support for
     // variable precision as specified:
     // "any number of decimal places, the format will then be n+5 positions with
@@ -125,7 +127,8 @@ bool GromacsFormat::read(std::istream &in, Molecule &molecule)
     // Offset: 60 format: %8.4f value: z velocity (nm/ps, a.k.a. km/s)
 
     // Atom name:
-    value = trimmed(buffer.substr(10, 5));
+    StringView name(line.substr(10, 5).trimmed());
+    value.assign(name.data(), name.size());
     AtomTypeMap::const_iterator it = atomTypes.find(value);
     if (it == atomTypes.end()) {
       atomTypes.insert(std::make_pair(value, customElementCounter++));
@@ -139,11 +142,11 @@ bool GromacsFormat::read(std::istream &in, Molecule &molecule)
 
     // Coords
     for (int i = 0; i < 3; ++i) {
-      value = trimmed(buffer.substr(20 + i * decimalSep, decimalSep));
-      pos[i] = lexicalCast<Real>(value, ok);
-      if (!ok || value.empty()) {
+      StringView coord(line.substr(20 + i * decimalSep, decimalSep).trimmed());
+      pos[i] = lexicalCast<Real>(coord, ok);
+      if (!ok || coord.empty()) {
         appendError("Error reading atom specification -- invalid coordinate: '"
-                    + buffer + "' (bad coord: '" + value + "')");
+                    + buffer + "' (bad coord: '" + coord.str() + "')");
         return false;
       }
     }
@@ -165,7 +168,8 @@ bool GromacsFormat::read(std::istream &in, Molecule &molecule)
   // The last six values may be omitted, set all non-specified values to 0.
   // v1(y) == v1(z) == v2(z) == 0 always.
   getline(in, buffer);
-  vector<string> tokens(split(buffer, ' ', true));
+  vector<StringView> tokens;
+  split(buffer, ' ', tokens);
   if (tokens.size() > 0) {
     if (tokens.size() != 3 && tokens.size() != 9) {
       appendError("Invalid box specification -- need either 3 or 9 values: '"
@@ -182,7 +186,7 @@ bool GromacsFormat::read(std::istream &in, Molecule &molecule)
       cellMatrix(rows[i], cols[i]) = lexicalCast<Real>(tokens[i], ok);
       if (!ok || tokens[i].empty()) {
         appendError("Invalid box specification -- bad value: '"
-                    + tokens[i] + "'");
+                    + tokens[i].str() + "'");
         return false;
       }
     }
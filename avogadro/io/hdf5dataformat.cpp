@@ -52,14 +52,77 @@ class Hdf5DataFormat::Private
 public:
   Private() :
     fileId(H5I_INVALID_HID),
-    threshold(1024)
+    threshold(1024),
+    compressionLevel(0)
   {
   }
 
+  // Create a dataset at path, which must not exist yet, and return its id.
+  // The id is negative if the dataset could not be created.
+  hid_t createDataset(const std::string &path, int ndims, const size_t dims[],
+                      const size_t chunkDims[]) const
+  {
+    std::vector<hsize_t> hdims(dims, dims + ndims);
+
+    // Create a dataspace description.
+    hid_t dataspace_id = H5Screate_simple(ndims, &hdims[0], NULL);
+    if (dataspace_id < 0)
+      return H5I_INVALID_HID;
+
+    // Create any intermediate groups if needed:
+    hid_t lcpl_id = H5Pcreate(H5P_LINK_CREATE);
+    if (lcpl_id < 0 || H5Pset_create_intermediate_group(lcpl_id, 1) < 0) {
+      if (lcpl_id >= 0)
+        H5Pclose(lcpl_id);
+      H5Sclose(dataspace_id);
+      return H5I_INVALID_HID;
+    }
+
+    // Set up the chunks, which may not be larger than the dataset, empty or
+    // over 4GB.
+    hid_t dcpl_id = H5Pcreate(H5P_DATASET_CREATE);
+    if (chunkDims && dcpl_id >= 0) {
+      std::vector<hsize_t> hchunks(ndims);
+      double chunkBytes = static_cast<double>(sizeof(double));
+      bool chunked = true;
+      for (int i = 0; i < ndims; ++i) {
+        hchunks[i] = std::max(static_cast<hsize_t>(1),
+                              std::min(static_cast<hsize_t>(chunkDims[i]),
+                                       hdims[i]));
+        chunkBytes *= static_cast<double>(hchunks[i]);
+        if (hdims[i] == 0)
+          chunked = false;
+      }
+      if (chunked && chunkBytes < 4294967296.0
+          && H5Pset_chunk(dcpl_id, ndims, &hchunks[0]) >= 0
+          && compressionLevel > 0
+          && H5Zfilter_avail(H5Z_FILTER_DEFLATE) > 0) {
+        // Shuffling the bytes of the values first compresses doubles better.
+        H5Pset_shuffle(dcpl_id);
+        H5Pset_deflate(dcpl_id, static_cast<unsigned int>(compressionLevel));
+      }
+    }
+
+    // Create the dataset.
+    hid_t dataset_id = H5Dcreate(fileId, path.c_str(), H5T_NATIVE_DOUBLE,
+                                 dataspace_id, lcpl_id,
+                                 dcpl_id >= 0 ? dcpl_id : H5P_DEFAULT,
+                                 H5P_DEFAULT);
+
+    // Cleanup.
+    if (dcpl_id >= 0)
+      H5Pclose(dcpl_id);
+    H5Pclose(lcpl_id);
+    H5Sclose(dataspace_id);
+
+    return dataset_id;
+  }
+
   std::string filename;
   hid_t fileId;
 
   size_t threshold;
+  int compressionLevel;
 };
 
 namespace {
@@ -238,6 +301,16 @@ bool Hdf5DataFormat::exceedsThreshold(const Core::Array<double> &data) const
   return exceedsThreshold(data.size() * sizeof(double));
 }
 
+void Hdf5DataFormat::setCompressionLevel(int level)
+{
+  d->compressionLevel = std::max(0, std::min(level, 9));
+}
+
+int Hdf5DataFormat::compressionLevel() const
+{
+  return d->compressionLevel;
+}
+
 bool Hdf5DataFormat::datasetExists(const std::string &path) const
 {
   if (!isOpen())
@@ -334,7 +407,8 @@ Hdf5DataFormat::datasetDimensions(const std::string &path) const
 
 bool Hdf5DataFormat::writeRawDataset(const std::string &path,
                                      const double data[],
-                                     int ndims, size_t dims[]) const
+                                     int ndims, size_t dims[],
+                                     size_t chunkDims[]) const
 {
   if (!isOpen())
     return false;
@@ -345,40 +419,16 @@ bool Hdf5DataFormat::writeRawDataset(const std::string &path,
       return false;
   }
 
-  // Get dimensions of data.
-  hsize_t *hdims = new hsize_t[ndims];
-  for (int i = 0; i < ndims; ++i) {
-    hdims[i] = static_cast<hsize_t>(dims[i]);
-  }
-
-  // Create a dataspace description.
-  hid_t dataspace_id = H5Screate_simple(ndims, hdims, NULL);
-  delete [] hdims;
-  if (dataspace_id < 0)
-    return false;
-
-  // Create any intermediate groups if needed:
-  hid_t lcpl_id = H5Pcreate(H5P_LINK_CREATE);
-  if (lcpl_id == -1 || H5Pset_create_intermediate_group(lcpl_id, 1) < 0) {
-    H5Sclose(dataspace_id);
-    return false;
-  }
-
-  // Create the dataset.
-  hid_t dataset_id = H5Dcreate(d->fileId, path.c_str(), H5T_NATIVE_DOUBLE,
-                               dataspace_id, lcpl_id, H5P_DEFAULT, H5P_DEFAULT);
-  if (dataset_id < 0) {
-    H5Sclose(dataspace_id);
+  hid_t dataset_id = d->createDataset(path, ndims, dims, chunkDims);
+  if (dataset_id < 0)
     return false;
-  }
 
   // Write the actual data.
-  herr_t err = H5Dwrite(dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, dataspace_id,
+  herr_t err = H5Dwrite(dataset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL,
                         H5P_DEFAULT, data);
 
   // Cleanup.
   H5Dclose(dataset_id);
-  H5Sclose(dataspace_id);
 
   if (err < 0)
     return false;
@@ -392,23 +442,54 @@ bool Hdf5DataFormat::writeDataset(const std::string &path,
   size_t dims[2] = {static_cast<size_t>(data.rows()),
                     static_cast<size_t>(data.cols())};
   // Transpose data -- Eigen uses column-major ordering.
-  return this->writeRawDataset(path, data.transpose().data(), 2, dims);
+  return this->writeRawDataset(path, data.transpose().data(), 2, dims, NULL);
 }
 
 bool Hdf5DataFormat::writeDataset(const std::string &path,
                                   const std::vector<double> &data, int ndims,
-                                  size_t *dims) const
+                                  size_t *dims, size_t *chunkDims) const
 {
   size_t size = data.size();
-  return this->writeRawDataset(path, &(data[0]), ndims, dims ? dims : &size);
+  return this->writeRawDataset(path, &(data[0]), ndims, dims ? dims : &size,
+                               chunkDims);
 }
 
 bool Hdf5DataFormat::writeDataset(const std::string &path,
                                   const Core::Array<double> &data, int ndims,
-                                  size_t *dims) const
+                                  size_t *dims, size_t *chunkDims) const
 {
   size_t size = data.size();
-  return this->writeRawDataset(path, &(data[0]), ndims, dims ? dims : &size);
+  return this->writeRawDataset(path, &(data[0]), ndims, dims ? dims : &size,
+                               chunkDims);
+}
+
+bool Hdf5DataFormat::createDataset(const std::string &path, int ndims,
+                                   size_t *dims, size_t *chunkDims) const
+{
+  if (!isOpen())
+    return false;
+
+  // Remove old data set if it exists.
+  if (datasetExists(path)) {
+    if (!removeDataset(path))
+      return false;
+  }
+
+  hid_t dataset_id = d->createDataset(path, ndims, dims, chunkDims);
+  if (dataset_id < 0)
+    return false;
+
+  H5Dclose(dataset_id);
+  return true;
+}
+
+bool Hdf5DataFormat::writeHyperslab(const std::string &path,
+                                    const std::vector<size_t> &offset,
+                                    const std::vector<size_t> &count,
+                                    const double data[]) const
+{
+  return accessHyperslab(path, offset, count, const_cast<double *>(data),
+                         true);
 }
 
 std::vector<int> Hdf5DataFormat::readRawDataset(const std::string &path,
@@ -500,6 +581,97 @@ std::vector<int> Hdf5DataFormat::readDataset(const std::string &path,
   return readRawDataset(path, container);
 }
 
+bool Hdf5DataFormat::readHyperslab(const std::string &path,
+                                   const std::vector<size_t> &offset,
+                                   const std::vector<size_t> &count,
+                                   double data[]) const
+{
+  return accessHyperslab(path, offset, count, data, false);
+}
+
+bool Hdf5DataFormat::readHyperslab(const std::string &path,
+                                   const std::vector<size_t> &offset,
+                                   const std::vector<size_t> &count,
+                                   Core::Array<double> &data) const
+{
+  size_t size = count.empty() ? 0 : 1;
+  for (size_t i = 0; i < count.size(); ++i)
+    size *= count[i];
+  data.resize(size);
+  return accessHyperslab(path, offset, count, size ? data.data() : NULL,
+                         false);
+}
+
+bool Hdf5DataFormat::accessHyperslab(const std::string &path,
+                                     const std::vector<size_t> &offset,
+                                     const std::vector<size_t> &count,
+                                     double data[], bool write) const
+{
+  if (!isOpen())
+    return false;
+
+  if (!datasetExists(path))
+    return false;
+
+  // Open dataset
+  hid_t dataset_id = H5Dopen(d->fileId, path.c_str(), H5P_DEFAULT);
+  if (dataset_id < 0)
+    return false;
+
+  hid_t dataspace_id = H5Dget_space(dataset_id);
+  if (dataspace_id < 0) {
+    H5Dclose(dataset_id);
+    return false;
+  }
+
+  // The block must have the rank of the dataset and lie within it.
+  int ndims = H5Sget_simple_extent_ndims(dataspace_id);
+  bool ok = ndims > 0 && offset.size() == static_cast<size_t>(ndims)
+      && count.size() == static_cast<size_t>(ndims);
+  std::vector<hsize_t> hdims(ok ? ndims : 0);
+  if (ok)
+    ok = H5Sget_simple_extent_dims(dataspace_id, &hdims[0], NULL) == ndims;
+
+  std::vector<hsize_t> start(hdims.size());
+  std::vector<hsize_t> hcount(hdims.size());
+  hsize_t elements = 1;
+  for (size_t i = 0; ok && i < hdims.size(); ++i) {
+    start[i] = static_cast<hsize_t>(offset[i]);
+    hcount[i] = static_cast<hsize_t>(count[i]);
+    ok = start[i] <= hdims[i] && hcount[i] <= hdims[i] - start[i];
+    elements *= hcount[i];
+  }
+
+  // Select the block in the file and transfer it to or from a contiguous
+  // buffer of the same shape.
+  if (ok && elements > 0) {
+    ok = H5Sselect_hyperslab(dataspace_id, H5S_SELECT_SET, &start[0], NULL,
+                             &hcount[0], NULL) >= 0;
+    hid_t memspace_id = ok ? H5Screate_simple(ndims, &hcount[0], NULL)
+                           : H5I_INVALID_HID;
+    if (memspace_id < 0) {
+      ok = false;
+    }
+    else {
+      if (write) {
+        ok = H5Dwrite(dataset_id, H5T_NATIVE_DOUBLE, memspace_id, dataspace_id,
+                      H5P_DEFAULT, data) >= 0;
+      }
+      else {
+        ok = H5Dread(dataset_id, H5T_NATIVE_DOUBLE, memspace_id, dataspace_id,
+                     H5P_DEFAULT, data) >= 0;
+      }
+      H5Sclose(memspace_id);
+    }
+  }
+
+  // Cleanup
+  H5Sclose(dataspace_id);
+  H5Dclose(dataset_id);
+
+  return ok;
+}
+
 std::vector<std::string> Hdf5DataFormat::datasets() const
 {
   if (!isOpen())
@@ -62,6 +62,14 @@ namespace Io {
  * If not, it should be serialized into the text file in a suitable format. The
  * thresholding operations are optional; the threshold size does not affect the
  * behavior of the read/write methods and are only for user convenience.
+ *
+ * Large datasets, such as volumetric data or the frames of a trajectory, can be
+ * written in chunks by passing chunk dimensions to writeDataset or
+ * createDataset. Chunked datasets are compressed when a compression level is
+ * set with setCompressionLevel(), and a sub-block of any dataset can be read
+ * or written with readHyperslab() and writeHyperslab(). Reading a hyperslab
+ * only reads the chunks that it overlaps, so a single frame or a region of a
+ * grid can be paged in without reading the whole dataset.
  */
 class AVOGADROIO_EXPORT Hdf5DataFormat
 {
@@ -168,6 +176,18 @@ public:
    */
   bool exceedsThreshold(const Core::Array<double> &data) const;
 
+  /**
+   * @brief setCompressionLevel Set the deflate compression level used for
+   * chunked datasets. Datasets written without chunk dimensions are never
+   * compressed.
+   * @param level The compression level, from 0 (no compression) to 9.
+   * Default: 0.
+   */
+  void setCompressionLevel(int level);
+
+  /** @return The compression level used for chunked datasets. Default: 0. */
+  int compressionLevel() const;
+
   /**
    * @brief datasetExists Test if the currently open file contains a dataset at
    * the HDF5 absolute path @a path.
@@ -214,6 +234,8 @@ public:
    * @param ndims The number of dimensions in the data. Default: 1.
    * @param dims The dimensionality of the data, major dimension first. Default:
    * data.size().
+   * @param chunkDims The dimensions of the chunks the data is stored in, or
+   * NULL to store the data contiguously. Default: NULL.
    * @note Since std::vector is a flat container, the dimensionality data is
    * only used to set up the dataset metadata in the HDF5 container. Omitting
    * the dimensionality parameters will write a flat array.
@@ -221,7 +243,8 @@ public:
    */
   bool writeDataset(const std::string &path,
                     const std::vector<double> &data,
-                    int ndims = 1, size_t *dims = NULL) const;
+                    int ndims = 1, size_t *dims = NULL,
+                    size_t *chunkDims = NULL) const;
 
   /**
    * @brief writeDataset Write the data to the currently opened file at the
@@ -231,6 +254,8 @@ public:
    * @param ndims The number of dimensions in the data. Default: 1.
    * @param dims The dimensionality of the data, major dimension first. Default:
    * data.size().
+   * @param chunkDims The dimensions of the chunks the data is stored in, or
+   * NULL to store the data contiguously. Default: NULL.
    * @note Since this is a flat container, the dimensionality data is
    * only used to set up the dataset metadata in the HDF5 container. Omitting
    * the dimensionality parameters will write a flat array.
@@ -238,7 +263,38 @@ public:
    */
   bool writeDataset(const std::string &path,
                     const Core::Array<double> &data,
-                    int ndims = 1, size_t *dims = NULL) const;
+                    int ndims = 1, size_t *dims = NULL,
+                    size_t *chunkDims = NULL) const;
+
+  /**
+   * @brief createDataset Create a dataset without writing any data, so that it
+   * can be filled in parts with writeHyperslab(). An existing dataset at
+   * @a path is replaced.
+   * @param path An absolute path into the HDF5 data.
+   * @param ndims The number of dimensions in the data.
+   * @param dims The dimensionality of the data, major dimension first.
+   * @param chunkDims The dimensions of the chunks the data is stored in, or
+   * NULL to store the data contiguously. Default: NULL.
+   * @return true if the dataset is successfully created, false otherwise.
+   */
+  bool createDataset(const std::string &path, int ndims, size_t *dims,
+                     size_t *chunkDims = NULL) const;
+
+  /**
+   * @brief writeHyperslab Write a sub-block of an existing dataset.
+   * @param path An absolute path into the HDF5 data.
+   * @param offset The first element of the block in each dimension.
+   * @param count The size of the block in each dimension.
+   * @param data The values of the block, major dimension first. It must hold
+   * the product of @a count values.
+   * @note @a offset and @a count must have one value for each dimension of the
+   * dataset, and the block must lie within the dataset.
+   * @return true if the data is successfully written, false otherwise.
+   */
+  bool writeHyperslab(const std::string &path,
+                      const std::vector<size_t> &offset,
+                      const std::vector<size_t> &count,
+                      const double data[]) const;
 
   /**
    * @brief readDataset Populate the data container @data with data at from the
@@ -277,6 +333,40 @@ public:
   std::vector<int> readDataset(const std::string &path,
                                Core::Array<double> &data) const;
 
+  /**
+   * @brief readHyperslab Read a sub-block of a dataset, such as one frame of a
+   * trajectory or one region of a grid. Only the chunks of a chunked dataset
+   * overlapping the block are read from the file.
+   * @param path An absolute path into the HDF5 data.
+   * @param offset The first element of the block in each dimension.
+   * @param count The size of the block in each dimension.
+   * @param data Set to the values of the block, major dimension first. It
+   * must have room for the product of @a count values.
+   * @note @a offset and @a count must have one value for each dimension of the
+   * dataset, and the block must lie within the dataset.
+   * @return true if the data is successfully read, false otherwise.
+   */
+  bool readHyperslab(const std::string &path,
+                     const std::vector<size_t> &offset,
+                     const std::vector<size_t> &count,
+                     double data[]) const;
+
+  /**
+   * @brief readHyperslab Read a sub-block of a dataset, such as one frame of a
+   * trajectory or one region of a grid. Only the chunks of a chunked dataset
+   * overlapping the block are read from the file.
+   * @param path An absolute path into the HDF5 data.
+   * @param offset The first element of the block in each dimension.
+   * @param count The size of the block in each dimension.
+   * @param data The data container the block is read into. @a data will be
+   * resized to fit the block.
+   * @return true if the data is successfully read, false otherwise.
+   */
+  bool readHyperslab(const std::string &path,
+                     const std::vector<size_t> &offset,
+                     const std::vector<size_t> &count,
+                     Core::Array<double> &data) const;
+
   /**
    * @brief datasets Traverse the currently opened file and return a list of all
    * dataset objects in the file.
@@ -298,13 +388,23 @@ private:
    * @param data The data container to serialize to HDF5.
    * @param ndims The number of dimensions in the data.
    * @param dims The data dimensions, major dimension first.
+   * @param chunkDims The chunk dimensions, or NULL for contiguous storage.
    * @note Since a double[] is a flat container, the dimensionality data is
    * only used to set up the dataset metadata in the HDF5 container. The result
    * of multiplying all values in @a dims must equal the length of the @a data.
    * @return true if the data is successfully written, false otherwise.
    */
   bool writeRawDataset(const std::string &path, const double data[],
-                       int ndims, size_t dims[]) const;
+                       int ndims, size_t dims[], size_t chunkDims[]) const;
+
+  /**
+   * @brief accessHyperslab Read or write a sub-block of a dataset.
+   * @return true if the data is successfully transferred, false otherwise.
+   */
+  bool accessHyperslab(const std::string &path,
+                       const std::vector<size_t> &offset,
+                       const std::vector<size_t> &count,
+                       double data[], bool write) const;
 
   /**
    * @brief readRawDataset Populate the data container @data with data from the
@@ -0,0 +1,411 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2014 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "jsonreader.h"
+
+#include <avogadro/core/stringview.h>
+
+#include <sstream>
+
+namespace Avogadro {
+namespace Io {
+
+namespace {
+typedef std::char_traits<char> Traits;
+
+// Deeper documents are rejected rather than risking the stack.
+const int maxDepth = 512;
+
+int hexDigit(int c)
+{
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+bool isDigit(std::string::const_iterator it, std::string::const_iterator end)
+{
+  return it != end && *it >= '0' && *it <= '9';
+}
+
+// Check that number follows the JSON grammar, -?int(.digits)?([eE][+-]?digits)?
+bool isJsonNumber(const std::string &number)
+{
+  std::string::const_iterator it = number.begin();
+  std::string::const_iterator end = number.end();
+  if (it != end && *it == '-')
+    ++it;
+  if (!isDigit(it, end))
+    return false;
+  while (isDigit(it, end))
+    ++it;
+  if (it != end && *it == '.') {
+    if (!isDigit(++it, end))
+      return false;
+    while (isDigit(it, end))
+      ++it;
+  }
+  if (it != end && (*it == 'e' || *it == 'E')) {
+    ++it;
+    if (it != end && (*it == '-' || *it == '+'))
+      ++it;
+    if (!isDigit(it, end))
+      return false;
+    while (isDigit(it, end))
+      ++it;
+  }
+  return it == end;
+}
+
+void appendUtf8(std::string &str, unsigned long code)
+{
+  if (code < 0x80) {
+    str += static_cast<char>(code);
+  }
+  else if (code < 0x800) {
+    str += static_cast<char>(0xC0 | (code >> 6));
+    str += static_cast<char>(0x80 | (code & 0x3F));
+  }
+  else if (code < 0x10000) {
+    str += static_cast<char>(0xE0 | (code >> 12));
+    str += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+    str += static_cast<char>(0x80 | (code & 0x3F));
+  }
+  else {
+    str += static_cast<char>(0xF0 | (code >> 18));
+    str += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+    str += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+    str += static_cast<char>(0x80 | (code & 0x3F));
+  }
+}
+}
+
+JsonHandler::~JsonHandler()
+{
+}
+
+bool JsonHandler::startObject()
+{
+  return true;
+}
+
+bool JsonHandler::endObject()
+{
+  return true;
+}
+
+bool JsonHandler::key(const std::string &)
+{
+  return true;
+}
+
+bool JsonHandler::startArray()
+{
+  return true;
+}
+
+bool JsonHandler::endArray()
+{
+  return true;
+}
+
+bool JsonHandler::numberValue(double)
+{
+  return true;
+}
+
+bool JsonHandler::stringValue(const std::string &)
+{
+  return true;
+}
+
+bool JsonHandler::boolValue(bool)
+{
+  return true;
+}
+
+bool JsonHandler::nullValue()
+{
+  return true;
+}
+
+JsonReader::JsonReader(std::istream &in) : m_buffer(in.rdbuf()), m_line(1)
+{
+}
+
+bool JsonReader::parse(JsonHandler &handler)
+{
+  m_error.clear();
+  if (!m_buffer)
+    return setError("No input stream.");
+  return parseValue(handler, 0);
+}
+
+bool JsonReader::parseValue(JsonHandler &handler, int depth)
+{
+  int c = skipWhitespace();
+  switch (c) {
+  case '{':
+    return parseObject(handler, depth + 1);
+  case '[':
+    return parseArray(handler, depth + 1);
+  case '"':
+    if (!parseString(m_string))
+      return false;
+    return handler.stringValue(m_string) || setError("Parsing stopped.");
+  case 't':
+    if (!parseLiteral("true"))
+      return false;
+    return handler.boolValue(true) || setError("Parsing stopped.");
+  case 'f':
+    if (!parseLiteral("false"))
+      return false;
+    return handler.boolValue(false) || setError("Parsing stopped.");
+  case 'n':
+    if (!parseLiteral("null"))
+      return false;
+    return handler.nullValue() || setError("Parsing stopped.");
+  default:
+    if (c == '-' || (c >= '0' && c <= '9'))
+      return parseNumber(handler);
+    if (c == Traits::eof())
+      return setError("Unexpected end of input.");
+    return setError(std::string("Unexpected character '")
+                    + static_cast<char>(c) + "'.");
+  }
+}
+
+bool JsonReader::parseObject(JsonHandler &handler, int depth)
+{
+  if (depth > maxDepth)
+    return setError("Maximum nesting depth exceeded.");
+
+  m_buffer->sbumpc();
+  if (!handler.startObject())
+    return setError("Parsing stopped.");
+
+  int c = skipWhitespace();
+  if (c == '}') {
+    m_buffer->sbumpc();
+    return handler.endObject() || setError("Parsing stopped.");
+  }
+
+  for (;;) {
+    if (c != '"')
+      return setError("Expected a string for the object key.");
+    // The value may reuse m_string, so the key is only valid until then.
+    if (!parseString(m_string))
+      return false;
+    if (!handler.key(m_string))
+      return setError("Parsing stopped.");
+
+    if (skipWhitespace() != ':')
+      return setError("Expected ':' after the object key.");
+    m_buffer->sbumpc();
+    if (!parseValue(handler, depth))
+      return false;
+
+    c = skipWhitespace();
+    m_buffer->sbumpc();
+    if (c == '}')
+      return handler.endObject() || setError("Parsing stopped.");
+    if (c != ',')
+      return setError("Expected ',' or '}' in object.");
+    c = skipWhitespace();
+  }
+}
+
+bool JsonReader::parseArray(JsonHandler &handler, int depth)
+{
+  if (depth > maxDepth)
+    return setError("Maximum nesting depth exceeded.");
+
+  m_buffer->sbumpc();
+  if (!handler.startArray())
+    return setError("Parsing stopped.");
+
+  if (skipWhitespace() == ']') {
+    m_buffer->sbumpc();
+    return handler.endArray() || setError("Parsing stopped.");
+  }
+
+  for (;;) {
+    if (!parseValue(handler, depth))
+      return false;
+
+    int c = skipWhitespace();
+    m_buffer->sbumpc();
+    if (c == ']')
+      return handler.endArray() || setError("Parsing stopped.");
+    if (c != ',')
+      return setError("Expected ',' or ']' in array.");
+  }
+}
+
+bool JsonReader::parseString(std::string &str)
+{
+  str.clear();
+  // Skip the opening quote.
+  m_buffer->sbumpc();
+  for (;;) {
+    int c = m_buffer->sbumpc();
+    if (c == '"')
+      return true;
+    if (c == Traits::eof())
+      return setError("Unterminated string.");
+    if (c != '\\') {
+      if (c < 0x20 && c >= 0)
+        return setError("Unescaped control character in string.");
+      str += static_cast<char>(c);
+      continue;
+    }
+
+    c = m_buffer->sbumpc();
+    switch (c) {
+    case '"':
+    case '\\':
+    case '/':
+      str += static_cast<char>(c);
+      break;
+    case 'b':
+      str += '\b';
+      break;
+    case 'f':
+      str += '\f';
+      break;
+    case 'n':
+      str += '\n';
+      break;
+    case 'r':
+      str += '\r';
+      break;
+    case 't':
+      str += '\t';
+      break;
+    case 'u': {
+      unsigned long code = 0;
+      for (int i = 0; i < 4; ++i) {
+        int digit = hexDigit(m_buffer->sbumpc());
+        if (digit < 0)
+          return setError("Invalid unicode escape in string.");
+        code = (code << 4) | static_cast<unsigned long>(digit);
+      }
+      // Combine surrogate pairs, a lone surrogate is kept as it is.
+      if (code >= 0xD800 && code < 0xDC00 && m_buffer->sgetc() == '\\') {
+        m_buffer->sbumpc();
+        if (m_buffer->sbumpc() != 'u')
+          return setError("Invalid unicode escape in string.");
+        unsigned long low = 0;
+        for (int i = 0; i < 4; ++i) {
+          int digit = hexDigit(m_buffer->sbumpc());
+          if (digit < 0)
+            return setError("Invalid unicode escape in string.");
+          low = (low << 4) | static_cast<unsigned long>(digit);
+        }
+        if (low >= 0xDC00 && low < 0xE000) {
+          code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+        }
+        else {
+          appendUtf8(str, code);
+          code = low;
+        }
+      }
+      appendUtf8(str, code);
+      break;
+    }
+    default:
+      return setError("Invalid escape sequence in string.");
+    }
+  }
+}
+
+bool JsonReader::parseNumber(JsonHandler &handler)
+{
+  m_number.clear();
+  bool integer = true;
+  for (int c = m_buffer->sgetc(); c != Traits::eof();
+       c = m_buffer->snextc()) {
+    if ((c >= '0' && c <= '9') || (c == '-' && m_number.empty())) {
+      m_number += static_cast<char>(c);
+    }
+    else if (c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E') {
+      m_number += static_cast<char>(c);
+      integer = false;
+    }
+    else {
+      break;
+    }
+  }
+
+  double value = 0.0;
+  if (integer && m_number.size() < 16) {
+    // Exact, and much cheaper than parseValue for the indices and element
+    // numbers that make up much of a typical file.
+    bool negative = m_number[0] == '-';
+    std::string::const_iterator it = m_number.begin() + (negative ? 1 : 0);
+    if (it == m_number.end())
+      return setError("Invalid number '" + m_number + "'.");
+    for (; it != m_number.end(); ++it)
+      value = value * 10.0 + (*it - '0');
+    if (negative)
+      value = -value;
+  }
+  else if (!isJsonNumber(m_number)
+           || !Core::parseValue(Core::StringView(m_number), value)) {
+    return setError("Invalid number '" + m_number + "'.");
+  }
+
+  return handler.numberValue(value) || setError("Parsing stopped.");
+}
+
+bool JsonReader::parseLiteral(const char *literal)
+{
+  for (const char *c = literal; *c; ++c) {
+    if (m_buffer->sbumpc() != *c)
+      return setError(std::string("Invalid literal, expected '") + literal
+                      + "'.");
+  }
+  return true;
+}
+
+int JsonReader::skipWhitespace()
+{
+  int c = m_buffer->sgetc();
+  while (c == ' ' || c == '\n' || c == '\t' || c == '\r') {
+    if (c == '\n')
+      ++m_line;
+    c = m_buffer->snextc();
+  }
+  return c;
+}
+
+bool JsonReader::setError(const std::string &message)
+{
+  // Keep the first error, later ones are only a result of it.
+  if (m_error.empty()) {
+    std::ostringstream stream;
+    stream << "Error parsing JSON at line " << m_line << ": " << message;
+    m_error = stream.str();
+  }
+  return false;
+}
+
+} // end Io namespace
+} // end Avogadro namespace
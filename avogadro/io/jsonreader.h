@@ -0,0 +1,105 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2014 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef AVOGADRO_IO_JSONREADER_H
+#define AVOGADRO_IO_JSONREADER_H
+
+#include "avogadroioexport.h"
+
+#include <istream>
+#include <string>
+
+namespace Avogadro {
+namespace Io {
+
+/**
+ * @class JsonHandler jsonreader.h <avogadro/io/jsonreader.h>
+ * @brief The JsonHandler class receives the events produced by JsonReader.
+ *
+ * Every callback returns true to continue parsing, or false to stop the
+ * reader. The default implementations accept and ignore everything, so a
+ * handler only needs to override the events it is interested in.
+ */
+class AVOGADROIO_EXPORT JsonHandler
+{
+public:
+  virtual ~JsonHandler();
+
+  virtual bool startObject();
+  virtual bool endObject();
+
+  /**
+   * Called with the name of each member of an object, before its value.
+   */
+  virtual bool key(const std::string &name);
+
+  virtual bool startArray();
+  virtual bool endArray();
+
+  virtual bool numberValue(double value);
+  virtual bool stringValue(const std::string &value);
+  virtual bool boolValue(bool value);
+  virtual bool nullValue();
+};
+
+/**
+ * @class JsonReader jsonreader.h <avogadro/io/jsonreader.h>
+ * @brief The JsonReader class is an event driven JSON parser.
+ *
+ * Rather than building a document in memory the reader reports the values in
+ * the input to a JsonHandler as they are parsed, so that large documents can
+ * be read straight into their final data structures.
+ */
+class AVOGADROIO_EXPORT JsonReader
+{
+public:
+  explicit JsonReader(std::istream &in);
+
+  /**
+   * Parse the next JSON value from the stream, normally a top level object.
+   * The stream is left after the end of the value, so that a stream holding
+   * several values can be parsed one value at a time.
+   * @return False if the input is not valid JSON, or a callback of @p handler
+   * returned false.
+   */
+  bool parse(JsonHandler &handler);
+
+  /**
+   * @return A description of the error that stopped the last call to parse().
+   */
+  std::string error() const { return m_error; }
+
+private:
+  bool parseValue(JsonHandler &handler, int depth);
+  bool parseObject(JsonHandler &handler, int depth);
+  bool parseArray(JsonHandler &handler, int depth);
+  bool parseString(std::string &str);
+  bool parseNumber(JsonHandler &handler);
+  bool parseLiteral(const char *literal);
+  int skipWhitespace();
+  bool setError(const std::string &message);
+
+  std::streambuf *m_buffer;
+  size_t m_line;
+  std::string m_string;
+  std::string m_number;
+  std::string m_error;
+};
+
+} // end Io namespace
+} // end Avogadro namespace
+
+#endif // AVOGADRO_IO_JSONREADER_H
@@ -0,0 +1,350 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2014 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "jsonwriter.h"
+
+#include <avogadro/core/stringview.h>
+
+#include <algorithm>
+#include <cmath>
+#include <locale>
+#include <sstream>
+
+namespace Avogadro {
+namespace Io {
+
+namespace {
+// Arrays of scalars are wrapped once a line is longer than this.
+const size_t wrapColumn = 72;
+
+// The output is passed on to the stream in blocks of about this size.
+const size_t bufferSize = 16384;
+
+// Numbers with up to this many decimals are formatted directly, which
+// covers any value with 16 significant digits or less.
+const int maxFastDecimals = 17;
+
+// Smaller numbers are written in exponent form by a stream instead.
+const double minFastMagnitude = 1e-3;
+
+// Integers up to 2^53 are exactly representable as doubles.
+const double maxExactInteger = 9007199254740992.0;
+}
+
+JsonWriter::JsonWriter(std::ostream &out, bool pretty)
+  : m_out(out), m_pretty(pretty), m_afterKey(false), m_column(0)
+{
+  m_buffer.reserve(bufferSize + 64);
+}
+
+JsonWriter::~JsonWriter()
+{
+  flush();
+}
+
+void JsonWriter::flush()
+{
+  m_out.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+  m_buffer.clear();
+}
+
+void JsonWriter::startObject()
+{
+  startContainer('{', false);
+}
+
+void JsonWriter::endObject()
+{
+  endContainer('}');
+}
+
+void JsonWriter::key(const std::string &name)
+{
+  Level &level = m_levels.back();
+  if (level.count++ > 0)
+    write(",", 1);
+  if (m_pretty)
+    newLine();
+  writeString(name);
+  if (m_pretty)
+    write(": ", 2);
+  else
+    write(":", 1);
+  m_afterKey = true;
+}
+
+void JsonWriter::startArray()
+{
+  startContainer('[', true);
+}
+
+void JsonWriter::endArray()
+{
+  endContainer(']');
+}
+
+void JsonWriter::numberValue(double value)
+{
+  startValue(false);
+  if (value != value || std::fabs(value) > 1.7976931348623157e308) {
+    write("null", 4);
+    return;
+  }
+
+  // Values with a few decimals, such as coordinates read from most files, are
+  // written without the considerable cost of a stream. The division is
+  // correctly rounded, so the decimal reads back to exactly the same value.
+  double scale = 1.0;
+  int maxDecimals = value == 0.0 || std::fabs(value) >= minFastMagnitude
+      ? maxFastDecimals : -1;
+  for (int decimals = 0; decimals <= maxDecimals; ++decimals) {
+    double scaled = std::floor(value * scale + 0.5);
+    if (std::fabs(scaled) >= maxExactInteger)
+      break;
+    if (scaled / scale == value) {
+      writeDecimal(scaled, decimals);
+      return;
+    }
+    scale *= 10.0;
+  }
+
+  // Very small and large values may read back exactly in a shorter form, the
+  // others reaching this point need all 17 digits. The stream is in the
+  // classic locale so the decimal point is always a period.
+  std::ostringstream stream;
+  stream.imbue(std::locale::classic());
+  bool shortForm = false;
+  if (maxDecimals < 0 || std::fabs(value) >= maxExactInteger) {
+    stream.precision(15);
+    stream << value;
+    double readBack = 0.0;
+    shortForm = Core::parseValue(Core::StringView(stream.str()), readBack)
+        && readBack == value;
+  }
+  if (!shortForm) {
+    stream.str(std::string());
+    stream.precision(17);
+    stream << value;
+  }
+  const std::string number(stream.str());
+  write(number.data(), number.size());
+}
+
+void JsonWriter::integerValue(long value)
+{
+  startValue(false);
+  char buffer[24];
+  char *end = buffer + sizeof(buffer);
+  char *begin = end;
+  unsigned long magnitude = value < 0 ? 0ul - static_cast<unsigned long>(value)
+                                      : static_cast<unsigned long>(value);
+  do {
+    *--begin = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude);
+  if (value < 0)
+    *--begin = '-';
+  write(begin, static_cast<size_t>(end - begin));
+}
+
+void JsonWriter::writeDecimal(double scaled, int decimals)
+{
+  // The digits of the integer, which is exact in a double, in two halves that
+  // both fit in an unsigned long.
+  bool negative = scaled < 0.0;
+  scaled = std::fabs(scaled);
+  double low = std::fmod(scaled, 1e9);
+  unsigned long high = static_cast<unsigned long>((scaled - low) / 1e9);
+  unsigned long lowDigits = static_cast<unsigned long>(low);
+
+  char digits[24];
+  char *end = digits + sizeof(digits);
+  char *begin = end;
+  for (int i = 0; i < 9 && (high || lowDigits || begin == end); ++i) {
+    *--begin = static_cast<char>('0' + lowDigits % 10);
+    lowDigits /= 10;
+  }
+  while (high) {
+    *--begin = static_cast<char>('0' + high % 10);
+    high /= 10;
+  }
+
+  char buffer[32];
+  char *out = buffer;
+  if (negative)
+    *out++ = '-';
+  int count = static_cast<int>(end - begin);
+  if (count <= decimals) {
+    *out++ = '0';
+    *out++ = '.';
+    for (int i = count; i < decimals; ++i)
+      *out++ = '0';
+    while (begin != end)
+      *out++ = *begin++;
+  }
+  else {
+    while (count-- > decimals)
+      *out++ = *begin++;
+    if (decimals > 0) {
+      *out++ = '.';
+      while (begin != end)
+        *out++ = *begin++;
+    }
+  }
+  write(buffer, static_cast<size_t>(out - buffer));
+}
+
+void JsonWriter::stringValue(const std::string &value)
+{
+  startValue(false);
+  writeString(value);
+}
+
+void JsonWriter::boolValue(bool value)
+{
+  startValue(false);
+  if (value)
+    write("true", 4);
+  else
+    write("false", 5);
+}
+
+void JsonWriter::nullValue()
+{
+  startValue(false);
+  write("null", 4);
+}
+
+void JsonWriter::writeString(const std::string &value)
+{
+  static const char hex[] = "0123456789abcdef";
+  std::string escaped;
+  escaped.reserve(value.size() + 2);
+  escaped += '"';
+  for (std::string::const_iterator it = value.begin(); it != value.end();
+       ++it) {
+    unsigned char c = static_cast<unsigned char>(*it);
+    switch (c) {
+    case '"':
+      escaped += "\\\"";
+      break;
+    case '\\':
+      escaped += "\\\\";
+      break;
+    case '\b':
+      escaped += "\\b";
+      break;
+    case '\f':
+      escaped += "\\f";
+      break;
+    case '\n':
+      escaped += "\\n";
+      break;
+    case '\r':
+      escaped += "\\r";
+      break;
+    case '\t':
+      escaped += "\\t";
+      break;
+    default:
+      if (c < 0x20) {
+        escaped += "\\u00";
+        escaped += hex[c >> 4];
+        escaped += hex[c & 0xF];
+      }
+      else {
+        escaped += static_cast<char>(c);
+      }
+    }
+  }
+  escaped += '"';
+  write(escaped.data(), escaped.size());
+}
+
+void JsonWriter::startContainer(char open, bool isArray)
+{
+  startValue(true);
+  write(&open, 1);
+  Level level;
+  level.isArray = isArray;
+  level.hasContainer = false;
+  level.count = 0;
+  m_levels.push_back(level);
+}
+
+void JsonWriter::endContainer(char close)
+{
+  Level level = m_levels.back();
+  m_levels.pop_back();
+  if (m_pretty && level.count > 0) {
+    if (!level.isArray || level.hasContainer)
+      newLine();
+    else
+      write(" ", 1);
+  }
+  write(&close, 1);
+}
+
+void JsonWriter::startValue(bool isContainer)
+{
+  if (m_afterKey) {
+    // Object members are positioned by key().
+    m_afterKey = false;
+    return;
+  }
+  if (m_levels.empty())
+    return;
+
+  Level &level = m_levels.back();
+  if (level.count++ > 0)
+    write(",", 1);
+  if (!m_pretty)
+    return;
+
+  if (isContainer || level.hasContainer) {
+    level.hasContainer = true;
+    newLine();
+  }
+  else if (m_column > wrapColumn) {
+    newLine();
+  }
+  else {
+    write(" ", 1);
+  }
+}
+
+void JsonWriter::newLine()
+{
+  static const char spaces[] = "                                ";
+  m_buffer += '\n';
+  m_column = 0;
+  size_t indent = 2 * m_levels.size();
+  while (m_column < indent) {
+    size_t length = std::min(indent - m_column, sizeof(spaces) - 1);
+    write(spaces, length);
+  }
+}
+
+void JsonWriter::write(const char *str, size_t length)
+{
+  m_buffer.append(str, length);
+  m_column += length;
+  if (m_buffer.size() >= bufferSize)
+    flush();
+}
+
+} // end Io namespace
+} // end Avogadro namespace
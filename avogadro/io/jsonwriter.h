@@ -0,0 +1,112 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2014 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef AVOGADRO_IO_JSONWRITER_H
+#define AVOGADRO_IO_JSONWRITER_H
+
+#include "avogadroioexport.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Avogadro {
+namespace Io {
+
+/**
+ * @class JsonWriter jsonwriter.h <avogadro/io/jsonwriter.h>
+ * @brief The JsonWriter class writes JSON to a stream as it is produced.
+ *
+ * Values are written straight to the stream without building a document in
+ * memory first. The caller is responsible for producing a well formed
+ * sequence of calls, e.g. a key() before each value in an object.
+ *
+ * In pretty mode objects have one member per line, and arrays of numbers or
+ * strings are wrapped to keep the lines short. Compact mode writes no
+ * whitespace at all.
+ *
+ * The output is buffered, call flush() or destroy the writer before using the
+ * stream.
+ */
+class AVOGADROIO_EXPORT JsonWriter
+{
+public:
+  explicit JsonWriter(std::ostream &out, bool pretty = true);
+
+  /**
+   * Flush any remaining output to the stream.
+   */
+  ~JsonWriter();
+
+  /**
+   * Write the buffered output to the stream.
+   */
+  void flush();
+
+  void startObject();
+  void endObject();
+
+  /**
+   * Write the name of the next member of the current object.
+   */
+  void key(const std::string &name);
+
+  void startArray();
+  void endArray();
+
+  /**
+   * Write a number, using as many digits as needed to read it back exactly.
+   * Infinite and NaN values are written as null.
+   */
+  void numberValue(double value);
+
+  /**
+   * Write an integer, this is considerably faster than numberValue().
+   */
+  void integerValue(long value);
+
+  void stringValue(const std::string &value);
+  void boolValue(bool value);
+  void nullValue();
+
+private:
+  struct Level
+  {
+    bool isArray;
+    bool hasContainer;
+    size_t count;
+  };
+
+  void startContainer(char open, bool isArray);
+  void endContainer(char close);
+  void startValue(bool isContainer);
+  void newLine();
+  void writeString(const std::string &value);
+  void writeDecimal(double scaled, int decimals);
+  void write(const char *str, size_t length);
+
+  std::ostream &m_out;
+  std::string m_buffer;
+  bool m_pretty;
+  bool m_afterKey;
+  size_t m_column;
+  std::vector<Level> m_levels;
+};
+
+} // end Io namespace
+} // end Avogadro namespace
+
+#endif // AVOGADRO_IO_JSONWRITER_H
@@ -31,6 +31,7 @@ using Avogadro::Core::Atom;
 using Avogadro::Core::Bond;
 using Avogadro::Core::Elements;
 using Avogadro::Core::Molecule;
+using Avogadro::Core::StringView;
 using Avogadro::Core::lexicalCast;
 using Avogadro::Core::startsWith;
 using Avogadro::Core::trimmed;
@@ -73,18 +74,19 @@ bool MdlFormat::read(std::istream &in, Core::Molecule &mol)
 
   // The counts line, and version identifier.
   getline(in, buffer);
+  StringView line(buffer);
   bool ok(false);
-  int numAtoms(lexicalCast<int>(buffer.substr(0, 3), ok));
+  int numAtoms(lexicalCast<int>(line.substr(0, 3), ok));
   if (!ok) {
     appendError("Error parsing number of atoms.");
     return false;
   }
-  int numBonds(lexicalCast<int>(buffer.substr(3, 3), ok));
+  int numBonds(lexicalCast<int>(line.substr(3, 3), ok));
   if (!ok) {
     appendError("Error parsing number of bonds.");
     return false;
   }
-  string mdlVersion(trimmed(buffer.substr(33)));
+  string mdlVersion(line.substr(33).trimmed().str());
   if (mdlVersion != "V2000") {
     appendError("Unsupported file format version encountered: " + mdlVersion);
     return false;
@@ -94,25 +96,30 @@ bool MdlFormat::read(std::istream &in, Core::Molecule &mol)
   for (int i = 0; i < numAtoms; ++i) {
     Vector3 pos;
     getline(in, buffer);
-    pos.x() = lexicalCast<Real>(buffer.substr(0, 10), ok);
+    line = buffer;
+    pos.x() = lexicalCast<Real>(line.substr(0, 10), ok);
     if (!ok) {
-      appendError("Failed to parse x coordinate: " + buffer.substr(0, 10));
+      appendError("Failed to parse x coordinate: " +
+                  line.substr(0, 10).str());
       return false;
     }
-    pos.y() = lexicalCast<Real>(buffer.substr(10, 10), ok);
+    pos.y() = lexicalCast<Real>(line.substr(10, 10), ok);
     if (!ok) {
-      appendError("Failed to parse y coordinate: " + buffer.substr(10, 10));
+      appendError("Failed to parse y coordinate: " +
+                  line.substr(10, 10).str());
       return false;
     }
-    pos.z() = lexicalCast<Real>(buffer.substr(20, 10), ok);
+    pos.z() = lexicalCast<Real>(line.substr(20, 10), ok);
     if (!ok) {
-      appendError("Failed to parse z coordinate: " + buffer.substr(20, 10));
+      appendError("Failed to parse z coordinate: " +
+                  line.substr(20, 10).str());
       return false;
     }
 
-    string element(trimmed(buffer.substr(31, 3)));
+    StringView element(line.substr(31, 3).trimmed());
     if (!buffer.empty()) {
-      unsigned char atomicNum = Elements::atomicNumberFromSymbol(element);
+      unsigned char atomicNum =
+          Elements::atomicNumberFromSymbol(element.str());
       Atom newAtom = mol.addAtom(atomicNum);
       newAtom.setPosition3d(pos);
       continue;
@@ -127,19 +134,23 @@ bool MdlFormat::read(std::istream &in, Core::Molecule &mol)
   for (int i = 0; i < numBonds; ++i) {
     // Bond atom indices start at 1, -1 for C++.
     getline(in, buffer);
-    int begin(lexicalCast<int>(buffer.substr(0, 3), ok) - 1);
+    line = buffer;
+    int begin(lexicalCast<int>(line.substr(0, 3), ok) - 1);
     if (!ok) {
-      appendError("Error parsing beginning bond index:" + buffer.substr(0, 3));
+      appendError("Error parsing beginning bond index:" +
+                  line.substr(0, 3).str());
       return false;
     }
-    int end(lexicalCast<int>(buffer.substr(3, 3), ok) - 1);
+    int end(lexicalCast<int>(line.substr(3, 3), ok) - 1);
     if (!ok) {
-      appendError("Error parsing end bond index:" + buffer.substr(3, 3));
+      appendError("Error parsing end bond index:" +
+                  line.substr(3, 3).str());
       return false;
     }
-    int order(lexicalCast<int>(buffer.substr(6, 3), ok));
+    int order(lexicalCast<int>(line.substr(6, 3), ok));
     if (!ok) {
-      appendError("Error parsing bond order:" + buffer.substr(6, 3));
+      appendError("Error parsing bond order:" +
+                  line.substr(6, 3).str());
       return false;
     }
     if (begin < 0 || begin >= numAtoms || end < 0 || end >= numAtoms) {
@@ -205,6 +216,26 @@ bool MdlFormat::read(std::istream &in, Core::Molecule &mol)
   return true;
 }
 
+bool MdlFormat::skipRecord(std::istream &in)
+{
+  // The record runs up to the SDF record separator, or the end of the file for
+  // a lone molecule. As in read, a separator before the record is skipped.
+  string buffer;
+  bool foundEnd(false);
+  bool firstLine(true);
+  while (getline(in, buffer)) {
+    string line(trimmed(buffer));
+    if (line == "$$$$" && !firstLine)
+      break;
+    if (line == "M  END")
+      foundEnd = true;
+    firstLine = false;
+  }
+  if (!foundEnd)
+    appendError("Error, ending tag for record not found.");
+  return foundEnd;
+}
+
 bool MdlFormat::write(std::ostream &out, const Core::Molecule &mol)
 {
   // Header lines.
@@ -59,6 +59,9 @@ public:
 
   bool read(std::istream &in, Core::Molecule &molecule) AVO_OVERRIDE;
   bool write(std::ostream &out, const Core::Molecule &molecule) AVO_OVERRIDE;
+
+protected:
+  bool skipRecord(std::istream &in) AVO_OVERRIDE;
 };
 
 } // end Io namespace
@@ -18,11 +18,16 @@
 
 #include <avogadro/core/elements.h>
 #include <avogadro/core/molecule.h>
+#include <avogadro/core/stringview.h>
+#include <avogadro/core/trajectorysource.h>
 #include <avogadro/core/utilities.h>
 #include <avogadro/core/vector.h>
 
+#include <fstream>
 #include <iomanip>
 #include <istream>
+#include <limits>
+#include <locale>
 #include <ostream>
 #include <string>
 #include <sstream>
@@ -40,14 +45,121 @@ using Core::Array;
 using Core::Atom;
 using Core::Elements;
 using Core::Molecule;
+using Core::StringView;
 using Core::lexicalCast;
-using Core::split;
+using Core::parseValue;
 using Core::trimmed;
 
 #ifndef _WIN32
 using std::isalpha;
 #endif
 
+namespace {
+// Skip to the start of the next line.
+void skipLine(std::istream &in)
+{
+  in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+}
+
+// Remove the next white space separated field from the start of line.
+StringView nextField(StringView &line)
+{
+  const char *begin = line.begin();
+  const char *end = line.end();
+  while (begin != end && StringView::isSpace(*begin))
+    ++begin;
+  const char *field = begin;
+  while (begin != end && !StringView::isSpace(*begin))
+    ++begin;
+  line = StringView(begin, static_cast<size_t>(end - begin));
+  return StringView(field, static_cast<size_t>(begin - field));
+}
+
+// Parse an atom line, the element followed by the coordinates. Any further
+// columns are ignored.
+bool parseAtom(const string &buffer, StringView &element, Vector3 &pos)
+{
+  StringView line(buffer);
+  element = nextField(line);
+  return !element.empty() && parseValue(nextField(line), pos.x())
+      && parseValue(nextField(line), pos.y())
+      && parseValue(nextField(line), pos.z());
+}
+
+// Read the positions of numAtoms atoms, one per line.
+bool readPositions(std::istream &in, size_t numAtoms,
+                   Array<Vector3> &positions)
+{
+  positions.resize(numAtoms);
+  Array<Vector3>::Span span(positions.span());
+  string buffer;
+  StringView element;
+  for (size_t i = 0; i < numAtoms; ++i) {
+    if (!getline(in, buffer) || !parseAtom(buffer, element, span[i]))
+      return false;
+  }
+  return true;
+}
+
+// Check whether the next line holds the atom count of another frame with
+// numAtoms atoms, and if so skip it along with the comment line. Otherwise the
+// stream is left at the start of the line.
+bool nextFrame(std::istream &in, size_t numAtoms, string &buffer)
+{
+  std::streampos start = in.tellg();
+  bool ok = false;
+  if (getline(in, buffer)) {
+    size_t numAtoms2 = lexicalCast<size_t>(trimmed(buffer), ok);
+    ok = ok && numAtoms2 == numAtoms && getline(in, buffer);
+  }
+  if (!ok) {
+    in.clear();
+    in.seekg(start);
+  }
+  return ok;
+}
+
+// The frames of a trajectory in an xyz file, indexed by the offsets of their
+// first atom lines and parsed when requested.
+class XyzTrajectory : public Core::TrajectorySource
+{
+public:
+  XyzTrajectory(const string &fileName, size_t numAtoms,
+                const vector<std::streamoff> &offsets)
+    : m_fileName(fileName), m_numAtoms(numAtoms), m_offsets(offsets)
+  {
+  }
+
+  Core::TrajectorySource * clone() const
+  {
+    return new XyzTrajectory(m_fileName, m_numAtoms, m_offsets);
+  }
+
+  size_t frameCount() const { return m_offsets.size(); }
+
+  bool readFrame(size_t frame, Array<Vector3> &positions)
+  {
+    if (frame >= m_offsets.size())
+      return false;
+    if (!m_file.is_open()) {
+      m_file.open(m_fileName.c_str(), std::ifstream::binary);
+      if (!m_file.is_open())
+        return false;
+      m_file.imbue(std::locale("C"));
+    }
+    m_file.clear();
+    m_file.seekg(m_offsets[frame]);
+    return readPositions(m_file, m_numAtoms, positions);
+  }
+
+private:
+  string m_fileName;
+  size_t m_numAtoms;
+  vector<std::streamoff> m_offsets;
+  std::ifstream m_file;
+};
+}
+
 XyzFormat::XyzFormat()
 {
 }
@@ -70,74 +182,65 @@ bool XyzFormat::read(std::istream &inStream, Core::Molecule &mol)
   if (!buffer.empty())
     mol.setData("name", trimmed(buffer));
 
+  // Trajectories read from a file are indexed rather than loaded, the frames
+  // are parsed when they are set on the molecule.
+  const bool indexFrames = isMode(Read) && !fileName().empty();
+  vector<std::streamoff> offsets;
+  if (indexFrames)
+    offsets.push_back(inStream.tellg());
+
   // Parse atoms
+  StringView element;
   for (size_t i = 0; i < numAtoms; ++i) {
-    getline(inStream, buffer);
-    vector<string> tokens(split(buffer, ' '));
-
-    if (tokens.size() < 4) {
-      appendError("Not enough tokens in this line: " + buffer);
+    Vector3 pos;
+    if (!getline(inStream, buffer) || !parseAtom(buffer, element, pos)) {
+      std::ostringstream errorStream;
+      errorStream << "Error parsing atom at index " << i
+                  << " (line " << 3 + i << ").";
+      appendError(errorStream.str());
       return false;
     }
 
     unsigned char atomicNum(0);
-    if (isalpha(tokens[0][0]))
-      atomicNum = Elements::atomicNumberFromSymbol(tokens[0]);
+    if (isalpha(element[0]))
+      atomicNum = Elements::atomicNumberFromSymbol(element.str());
     else
-      atomicNum = static_cast<unsigned char>(lexicalCast<short int>(tokens[0]));
-
-    Vector3 pos(lexicalCast<double>(tokens[1]),
-                lexicalCast<double>(tokens[2]),
-                lexicalCast<double>(tokens[3]));
+      atomicNum = static_cast<unsigned char>(lexicalCast<short int>(element));
 
     Atom newAtom = mol.addAtom(atomicNum);
     newAtom.setPosition3d(pos);
   }
 
-  // Check that all atoms were handled.
-  if (mol.atomCount() != numAtoms) {
-    std::ostringstream errorStream;
-    errorStream << "Error parsing atom at index " << mol.atomCount()
-                << " (line " << 3 + mol.atomCount() << ").\n" << buffer;
-    appendError(errorStream.str());
-    return false;
+  // Do we have an animation? Any following frames with the same number of
+  // atoms are part of it.
+  if (indexFrames) {
+    while (nextFrame(inStream, numAtoms, buffer)) {
+      std::streamoff offset = inStream.tellg();
+      size_t i = 0;
+      for (; i < numAtoms && inStream.good(); ++i)
+        skipLine(inStream);
+      if (i < numAtoms)
+        break; // A truncated frame.
+      offsets.push_back(offset);
+    }
+    if (offsets.size() > 1) {
+      mol.setTrajectorySource(new XyzTrajectory(fileName(), numAtoms,
+                                                offsets));
+    }
   }
-
-  // Do we have an animation?
-  size_t numAtoms2;
-  if (getline(inStream, buffer) && (numAtoms2 = lexicalCast<int>(buffer))
-      && numAtoms == numAtoms2) {
-    getline(inStream, buffer); // Skip the blank
+  else if (nextFrame(inStream, numAtoms, buffer)) {
     mol.setCoordinate3d(mol.atomPositions3d(), 0);
     int coordSet = 1;
-    while (numAtoms == numAtoms2) {
+    do {
       Array<Vector3> positions;
-      positions.reserve(numAtoms);
-
-      for (size_t i = 0; i < numAtoms; ++i) {
-        getline(inStream, buffer);
-        vector<string> tokens(split(buffer, ' '));
-        if (tokens.size() < 4) {
-          appendError("Not enough tokens in this line: " + buffer);
-          return false;
-        }
-        Vector3 pos(lexicalCast<double>(tokens[1]),
-                    lexicalCast<double>(tokens[2]),
-                    lexicalCast<double>(tokens[3]));
-        positions.push_back(pos);
+      if (!readPositions(inStream, numAtoms, positions)) {
+        std::ostringstream errorStream;
+        errorStream << "Error parsing the atoms of frame " << coordSet << ".";
+        appendError(errorStream.str());
+        return false;
       }
-
       mol.setCoordinate3d(positions, coordSet++);
-
-      if (!getline(inStream, buffer)) {
-        numAtoms2 = lexicalCast<int>(buffer);
-        if (numAtoms == numAtoms2)
-          break;
-      }
-
-      std::getline(inStream, buffer); // Skip the blank
-      positions.clear();
-    }
+    } while (nextFrame(inStream, numAtoms, buffer));
   }
 
   // This format has no connectivity information, so perceive basics at least.
@@ -146,6 +249,32 @@ bool XyzFormat::read(std::istream &inStream, Core::Molecule &mol)
   return true;
 }
 
+bool XyzFormat::skipRecord(std::istream &inStream)
+{
+  size_t numAtoms = 0;
+  if (!(inStream >> numAtoms)) {
+    appendError("Error parsing number of atoms.");
+    return false;
+  }
+  skipLine(inStream); // Finish the first line
+  skipLine(inStream);
+
+  // Skip the atoms, along with any further frames of the same molecule as
+  // they are read as part of this record.
+  string buffer;
+  do {
+    size_t i = 0;
+    for (; i < numAtoms && inStream.good(); ++i)
+      skipLine(inStream);
+    if (i < numAtoms) {
+      appendError("Error skipping the atoms of a truncated record.");
+      return false;
+    }
+  } while (nextFrame(inStream, numAtoms, buffer));
+
+  return true;
+}
+
 bool XyzFormat::write(std::ostream &outStream, const Core::Molecule &mol)
 {
   size_t numAtoms = mol.atomCount();
@@ -57,6 +57,9 @@ public:
 
   bool read(std::istream &inStream, Core::Molecule &molecule) AVO_OVERRIDE;
   bool write(std::ostream &outStream, const Core::Molecule &molecule) AVO_OVERRIDE;
+
+protected:
+  bool skipRecord(std::istream &inStream) AVO_OVERRIDE;
 };
 
 } // end Io namespace
@@ -39,19 +39,28 @@ using QtGui::GenericHighlighter;
 InputGenerator::InputGenerator(const QString &scriptFilePath_, QObject *parent_)
   : QObject(parent_),
     m_interpreter(new PythonScript(scriptFilePath_, this)),
+    m_asyncMolecule(NULL),
     m_moleculeExtension("Unknown")
 {
+  m_interpreter->setPersistent(true);
+  connect(m_interpreter, SIGNAL(finished(int,QByteArray)),
+          SLOT(scriptFinished(int,QByteArray)));
 }
 
 InputGenerator::InputGenerator(QObject *parent_)
   : QObject(parent_),
     m_interpreter(new PythonScript(this)),
+    m_asyncMolecule(NULL),
     m_moleculeExtension("Unknown")
 {
+  m_interpreter->setPersistent(true);
+  connect(m_interpreter, SIGNAL(finished(int,QByteArray)),
+          SLOT(scriptFinished(int,QByteArray)));
 }
 
 InputGenerator::~InputGenerator()
 {
+  delete m_asyncMolecule;
 }
 
 bool InputGenerator::debug() const
@@ -148,13 +157,7 @@ void InputGenerator::reset()
 bool InputGenerator::generateInput(const QJsonObject &options_,
                                    const Core::Molecule &mol)
 {
-  m_errors.clear();
-  m_warnings.clear();
-  m_filenames.clear();
-  qDeleteAll(m_fileHighlighters.values());
-  m_fileHighlighters.clear();
-  m_mainFileName.clear();
-  m_files.clear();
+  clearGeneratedInput();
 
   // Add the molecule file to the options
   QJsonObject allOptions(options_);
@@ -169,6 +172,63 @@ bool InputGenerator::generateInput(const QJsonObject &options_,
     return false;
   }
 
+  return processGeneratedInput(json, mol);
+}
+
+bool InputGenerator::generateInputAsync(const QJsonObject &options_,
+                                        const Core::Molecule &mol)
+{
+  clearGeneratedInput();
+
+  // Add the molecule file to the options
+  QJsonObject allOptions(options_);
+  if (!insertMolecule(allOptions, mol))
+    return false;
+
+  // The molecule is needed again to replace keywords in the generated files.
+  delete m_asyncMolecule;
+  m_asyncMolecule = new Core::Molecule(mol);
+
+  m_interpreter->asyncExecute(QStringList() << "--generate-input",
+                              QJsonDocument(allOptions).toJson());
+  return true;
+}
+
+void InputGenerator::scriptFinished(int, const QByteArray &output)
+{
+  if (!m_asyncMolecule)
+    return;
+
+  bool success = false;
+  if (m_interpreter->hasErrors())
+    m_errors << m_interpreter->errorList();
+  else
+    success = processGeneratedInput(output, *m_asyncMolecule);
+
+  delete m_asyncMolecule;
+  m_asyncMolecule = NULL;
+  emit inputGenerated(success);
+}
+
+void InputGenerator::clearGeneratedInput()
+{
+  // Any pending asynchronous request is superseded.
+  m_interpreter->cancelPending();
+  delete m_asyncMolecule;
+  m_asyncMolecule = NULL;
+
+  m_errors.clear();
+  m_warnings.clear();
+  m_filenames.clear();
+  qDeleteAll(m_fileHighlighters.values());
+  m_fileHighlighters.clear();
+  m_mainFileName.clear();
+  m_files.clear();
+}
+
+bool InputGenerator::processGeneratedInput(const QByteArray &json,
+                                           const Core::Molecule &mol)
+{
   QJsonDocument doc;
   if (!parseJson(json, doc))
     return false;
@@ -523,6 +523,18 @@ public:
    */
   bool generateInput(const QJsonObject &options_, const Core::Molecule &mol);
 
+  /**
+   * Request input files from the script without waiting for them to be
+   * generated. The inputGenerated() signal is emitted once the files are
+   * available, after which they can be retrieved as with generateInput().
+   * Calling this function again before inputGenerated() is emitted supersedes
+   * the earlier request.
+   * @return false if the request could not be made, in which case
+   * inputGenerated() will not be emitted.
+   */
+  bool generateInputAsync(const QJsonObject &options_,
+                          const Core::Molecule &mol);
+
   /**
    * @return The number of input files stored by generateInput().
    * @note This function is only valid after a successful call to
@@ -590,14 +602,28 @@ public slots:
    */
   void setDebug(bool d);
 
+signals:
+  /**
+   * Emitted when the request made with generateInputAsync() finishes.
+   * @param success True if the input files were generated.
+   */
+  void inputGenerated(bool success);
+
+private slots:
+  void scriptFinished(int requestId, const QByteArray &output);
+
 private:
   QtGui::PythonScript *m_interpreter;
+  // Copy of the molecule used by the pending generateInputAsync() request.
+  Core::Molecule *m_asyncMolecule;
 
   void setDefaultPythonInterpretor();
   QByteArray execute(const QStringList &args,
                      const QByteArray &scriptStdin = QByteArray()) const;
   bool parseJson(const QByteArray &json, QJsonDocument &doc) const;
   QString processErrorString(const QProcess &proc) const;
+  void clearGeneratedInput();
+  bool processGeneratedInput(const QByteArray &json, const Core::Molecule &mol);
   bool insertMolecule(QJsonObject &json, const Core::Molecule &mol) const;
   QString generateCoordinateBlock(const QString &spec,
                                   const Core::Molecule &mol) const;
@@ -58,6 +58,8 @@ InputGeneratorWidget::InputGeneratorWidget(QWidget *parent_) :
   m_ui->warningTextButton->setIcon(QIcon::fromTheme("dialog-warning"));
 
   connectButtons();
+  connect(&m_inputGenerator, SIGNAL(inputGenerated(bool)),
+          SLOT(inputGenerated(bool)));
 }
 
 InputGeneratorWidget::~InputGeneratorWidget()
@@ -194,11 +196,16 @@ void InputGeneratorWidget::updatePreviewTextImmediately()
   if (!m_molecule)
     return;
 
-  // Generate the input files
+  // Generate the input files. The script runs in the background, and the
+  // preview is updated by inputGenerated().
   QJsonObject inputOptions;
   inputOptions["options"] = collectOptions();
-  bool success = m_inputGenerator.generateInput(inputOptions, *m_molecule);
+  if (!m_inputGenerator.generateInputAsync(inputOptions, *m_molecule))
+    inputGenerated(false);
+}
 
+void InputGeneratorWidget::inputGenerated(bool success)
+{
   if (!m_inputGenerator.warningList().isEmpty()) {
     QString warningHtml;
     warningHtml += "<style>li{color:red;}h3{font-weight:bold;}</style>";
@@ -139,6 +139,11 @@ private slots:
    */
   void updatePreviewTextImmediately();
 
+  /**
+   * Show the input files once they have been generated.
+   */
+  void inputGenerated(bool success);
+
   /**
    * Triggered when the user resets the default values.
    */
@@ -17,10 +17,15 @@
 #include "moleculedeserializer.h"
 
 #include "matrixserialization.h"
+#include "utils.h"
+
+#include <avogadro/core/cube.h>
+#include <avogadro/core/unitcell.h>
 #include <avogadro/io/fileformatmanager.h>
 #include <google/protobuf/io/zero_copy_stream_impl_lite.h>
 #include <google/protobuf/io/coded_stream.h>
 
+#include <climits>
 #include <iostream>
 
 using Avogadro::Core::Molecule;
@@ -32,11 +37,14 @@ using google::protobuf::io::CodedOutputStream;
 using google::protobuf::io::ArrayInputStream;
 using google::protobuf::io::CodedInputStream;
 using google::protobuf::uint32;
+using google::protobuf::uint64;
 using google::protobuf::uint8;
 
 namespace Avogadro {
 namespace Core {
 
+namespace Utils = Avogadro::ProtoCall::Utils;
+
 MoleculeDeserializer::MoleculeDeserializer(Molecule *molecule)
   : m_molecule(molecule)
 {
@@ -45,8 +53,15 @@ MoleculeDeserializer::MoleculeDeserializer(Molecule *molecule)
 
 bool MoleculeDeserializer::deserialize(const void *data, size_t size)
 {
-  ArrayInputStream ais(data, size);
+  // The stream limits and sizes are ints.
+  if (size > static_cast<size_t>(INT_MAX))
+    return false;
+
+  ArrayInputStream ais(data, static_cast<int>(size));
   CodedInputStream cis(&ais);
+  // Limit the stream to the buffer, so that the counts read can be checked
+  // before arrays are sized for them.
+  cis.PushLimit(static_cast<int>(size));
 
   // Read the atoms
   if (!this->deserializeAtomicNumbers(&cis))
@@ -68,6 +83,18 @@ bool MoleculeDeserializer::deserialize(const void *data, size_t size)
   if (!this->deserializeBondOrders(&cis))
     return false;
 
+  // Read coordinate sets
+  if (!this->deserializeCoordinateSets(&cis))
+    return false;
+
+  // Read unit cell
+  if (!this->deserializeUnitCell(&cis))
+    return false;
+
+  // Read cubes
+  if (!this->deserializeCubes(&cis))
+    return false;
+
   return true;
 }
 
@@ -80,13 +107,16 @@ bool MoleculeDeserializer::deserializeAtomicNumbers(
   uint32 numberOfAtoms;
   if (!stream->ReadLittleEndian32(&numberOfAtoms))
     return false;
-  for (uint32 i = 0; i < numberOfAtoms; i++) {
-    unsigned char atom;
-    if (!stream->ReadRaw(&atom, sizeof(unsigned char)))
-      return false;
-    m_molecule->addAtom(atom);
-  }
+  if (!Utils::canRead(stream, static_cast<size_t>(numberOfAtoms)))
+    return false;
 
+  // Added through the molecule, which may give each atom a unique ID.
+  Array<unsigned char> atomicNumbers(numberOfAtoms);
+  if (!Utils::readRaw(stream, atomicNumbers.data(),
+                      numberOfAtoms * sizeof(unsigned char))) {
+    return false;
+  }
+  m_molecule->addAtoms(atomicNumbers);
   return true;
 }
 
@@ -98,16 +128,14 @@ bool MoleculeDeserializer::deserializePositions2d(
   uint32 posCount;
   if (!stream->ReadLittleEndian32(&posCount))
     return false;
-  // Clear an current positions
-  m_molecule->atomPositions2d().clear();
-  for (uint32 i = 0; i < posCount; i++) {
-    Avogadro::Vector2 vec2;
-    if (!ProtoCall::MatrixSerialization::deserialize(vec2, stream))
-      return false;
-    m_molecule->atomPositions2d().push_back(vec2);
-  }
+  if (!Utils::canRead(stream,
+                       static_cast<size_t>(posCount) * 2 * sizeof(uint64)))
+    return false;
 
-  return true;
+  Array<Vector2> &pos2d = m_molecule->atomPositions2d();
+  pos2d.resize(posCount);
+  return posCount == 0
+      || Utils::readDoubles(stream, pos2d[0].data(), 2 * posCount);
 }
 
 
@@ -118,16 +146,14 @@ bool MoleculeDeserializer::deserializePostions3d(
   uint32 posCount;
   if (!stream->ReadLittleEndian32(&posCount))
     return false;
-  // Clear an current positions
-  m_molecule->atomPositions3d().clear();
-  for (uint32 i = 0; i < posCount; i++) {
-    Avogadro::Vector3 vec3;
-    if (!ProtoCall::MatrixSerialization::deserialize(vec3, stream))
-      return false;
-    m_molecule->atomPositions3d().push_back(vec3);
-  }
+  if (!Utils::canRead(stream,
+                       static_cast<size_t>(posCount) * 3 * sizeof(uint64)))
+    return false;
 
-  return true;
+  Array<Vector3> &pos3d = m_molecule->atomPositions3d();
+  pos3d.resize(posCount);
+  return posCount == 0
+      || Utils::readDoubles(stream, pos3d[0].data(), 3 * posCount);
 }
 
 bool MoleculeDeserializer::deserializeBondPairs(
@@ -136,23 +162,32 @@ bool MoleculeDeserializer::deserializeBondPairs(
   uint32 bondCount;
   if (!stream->ReadLittleEndian32(&bondCount))
     return false;
+  if (!Utils::canRead(stream,
+                       static_cast<size_t>(bondCount) * 2 * sizeof(uint64)))
+    return false;
 
-  // Clear and bond pairs
-  m_molecule->bondPairs().clear();
-
-  for (uint32 i = 0; i < bondCount; i++) {
-    uint32 from, to;
-    if (!stream->ReadLittleEndian32(&from))
+  Array<std::pair<Index, Index> > bondPairs(bondCount);
+  if (sizeof(std::pair<Index, Index>) == 2 * sizeof(uint64)
+      && Utils::isLittleEndian()) {
+    if (!Utils::readRaw(stream, bondPairs.data(),
+                        static_cast<size_t>(bondCount) * 2 * sizeof(uint64))) {
       return false;
-    if (!stream->ReadLittleEndian32(&to))
-      return false;
-    std::pair<size_t, size_t> bond;
-    bond.first = from;
-    bond.second = to;
-    m_molecule->bondPairs().push_back(bond);
+    }
+  }
+  else {
+    for (uint32 i = 0; i < bondCount; i++) {
+      uint64 from, to;
+      if (!stream->ReadLittleEndian64(&from))
+        return false;
+      if (!stream->ReadLittleEndian64(&to))
+        return false;
+      bondPairs[i] = std::make_pair(static_cast<Index>(from),
+                                    static_cast<Index>(to));
+    }
   }
 
-  return true;
+  // The bonds must refer to the atoms read, their orders follow.
+  return m_molecule->addBonds(bondPairs, Array<unsigned char>());
 }
 
 bool MoleculeDeserializer::deserializeBondOrders(
@@ -161,16 +196,128 @@ bool MoleculeDeserializer::deserializeBondOrders(
   uint32 bondOrderCount;
   if (!stream->ReadLittleEndian32(&bondOrderCount))
     return false;
+  // There is an order for each of the bonds read.
+  if (bondOrderCount != m_molecule->bondCount())
+    return false;
+  if (!Utils::canRead(stream, static_cast<size_t>(bondOrderCount)))
+    return false;
+
+  Array<unsigned char> &bondOrders = m_molecule->bondOrders();
+  bondOrders.resize(bondOrderCount);
+  return Utils::readRaw(stream, bondOrders.data(),
+                        bondOrderCount * sizeof(unsigned char));
+}
+
+bool MoleculeDeserializer::deserializeCoordinateSets(
+    google::protobuf::io::CodedInputStream *stream)
+{
+  uint32 count;
+  uint32 atomCount;
+  if (!stream->ReadLittleEndian32(&count))
+    return false;
+  if (!stream->ReadLittleEndian32(&atomCount))
+    return false;
+  if (!Utils::canRead(stream,
+                      static_cast<size_t>(count) * atomCount * 3 * sizeof(uint64))) {
+    return false;
+  }
+
+  m_molecule->setTrajectorySource(NULL);
+  for (uint32 i = 0; i < count; ++i) {
+    Array<Vector3> positions(atomCount, Vector3::Zero());
+    if (atomCount > 0
+        && !Utils::readDoubles(stream, positions[0].data(), 3 * atomCount)) {
+      return false;
+    }
+    m_molecule->setCoordinate3d(positions, static_cast<int>(i));
+  }
 
-  // Clear bond order
-  m_molecule->bondOrders().clear();
+  return true;
+}
+
+bool MoleculeDeserializer::deserializeUnitCell(
+    google::protobuf::io::CodedInputStream *stream)
+{
+  uint32 hasUnitCell;
+  if (!stream->ReadLittleEndian32(&hasUnitCell))
+    return false;
+
+  if (!hasUnitCell) {
+    m_molecule->setUnitCell(NULL);
+    return true;
+  }
 
-  for (uint32 i = 0; i < bondOrderCount; i++) {
-    unsigned char bond;
-    if (!stream->ReadRaw(&bond, sizeof(unsigned char)))
+  Matrix3 cellMatrix;
+  if (!Utils::readDoubles(stream, cellMatrix.data(), 9))
+    return false;
+  m_molecule->setUnitCell(new UnitCell(cellMatrix));
+
+  return true;
+}
+
+bool MoleculeDeserializer::deserializeCubes(
+    google::protobuf::io::CodedInputStream *stream)
+{
+  uint32 cubeCount;
+  if (!stream->ReadLittleEndian32(&cubeCount))
+    return false;
+
+  m_molecule->clearCubes();
+  for (uint32 i = 0; i < cubeCount; ++i) {
+    Vector3 min;
+    Vector3 spacing;
+    if (!Utils::readDoubles(stream, min.data(), 3)
+        || !Utils::readDoubles(stream, spacing.data(), 3)) {
+      return false;
+    }
+    uint32 dimensions[3];
+    uint32 type;
+    for (int j = 0; j < 3; ++j) {
+      if (!stream->ReadLittleEndian32(&dimensions[j]))
+        return false;
+    }
+    if (!stream->ReadLittleEndian32(&type))
+      return false;
+
+    uint32 nameSize;
+    if (!stream->ReadLittleEndian32(&nameSize))
+      return false;
+    std::string name;
+    if (!Utils::canRead(stream, nameSize)
+        || !stream->ReadString(&name, static_cast<int>(nameSize)))
       return false;
 
-    m_molecule->bondOrders().push_back(bond);
+    uint32 valueCount;
+    if (!stream->ReadLittleEndian32(&valueCount))
+      return false;
+    // The dimensions and the number of points are ints in Cube, checking the
+    // product after each step keeps it from overflowing.
+    uint64 points = 1;
+    for (int j = 0; j < 3; ++j) {
+      points *= dimensions[j];
+      if (dimensions[j] > static_cast<uint32>(INT_MAX)
+          || points > static_cast<uint64>(INT_MAX)) {
+        return false;
+      }
+    }
+    if (points != valueCount
+        || !Utils::canRead(stream, static_cast<size_t>(points)
+                           * sizeof(uint64))) {
+      return false;
+    }
+
+    Cube *cube = m_molecule->addCube();
+    cube->setLimits(min, Vector3i(static_cast<int>(dimensions[0]),
+                                  static_cast<int>(dimensions[1]),
+                                  static_cast<int>(dimensions[2])), spacing);
+    cube->setCubeType(static_cast<Cube::Type>(type));
+    cube->setName(name);
+    std::vector<double> &values = *cube->data();
+    if (valueCount > 0
+        && !Utils::readDoubles(stream, &values[0], valueCount)) {
+      return false;
+    }
+    cube->updateMinMax();
   }
 
   return true;
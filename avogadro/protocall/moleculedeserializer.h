@@ -87,6 +87,27 @@ private:
    */
   bool deserializePostions3d(google::protobuf::io::CodedInputStream *stream);
 
+  /**
+   * Deserialize coordinate sets from stream.
+   *
+   * @return true if successful, false otherwise.
+   */
+  bool deserializeCoordinateSets(google::protobuf::io::CodedInputStream *stream);
+
+  /**
+   * Deserialize the unit cell from stream.
+   *
+   * @return true if successful, false otherwise.
+   */
+  bool deserializeUnitCell(google::protobuf::io::CodedInputStream *stream);
+
+  /**
+   * Deserialize cubes from stream.
+   *
+   * @return true if successful, false otherwise.
+   */
+  bool deserializeCubes(google::protobuf::io::CodedInputStream *stream);
+
   Molecule *m_molecule;
 };
 
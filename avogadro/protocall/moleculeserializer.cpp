@@ -17,6 +17,10 @@
 #include "moleculeserializer.h"
 
 #include "matrixserialization.h"
+#include "utils.h"
+
+#include <avogadro/core/cube.h>
+#include <avogadro/core/unitcell.h>
 #include <avogadro/io/fileformatmanager.h>
 #include <google/protobuf/io/zero_copy_stream_impl_lite.h>
 #include <google/protobuf/io/coded_stream.h>
@@ -34,8 +38,11 @@ using google::protobuf::io::CodedOutputStream;
 using google::protobuf::io::ArrayInputStream;
 using google::protobuf::io::CodedInputStream;
 using google::protobuf::uint32;
+using google::protobuf::uint64;
 using google::protobuf::uint8;
 
+namespace Utils = Avogadro::ProtoCall::Utils;
+
 MoleculeSerializer::MoleculeSerializer(const Avogadro::Core::Molecule *molecule)
   : m_molecule(molecule)
 {
@@ -67,6 +74,18 @@ bool MoleculeSerializer::serialize(void *data, size_t size_)
   if (!this->serializeBondOrders(&cos))
     return false;
 
+  // Write coordinate sets
+  if (!this->serializeCoordinateSets(&cos))
+    return false;
+
+  // Write unit cell
+  if (!this->serializeUnitCell(&cos))
+    return false;
+
+  // Write cubes
+  if (!this->serializeCubes(&cos))
+    return false;
+
   return true;
 }
 
@@ -77,25 +96,23 @@ size_t MoleculeSerializer::size()
       m_molecule->atomicNumbers().size()*sizeof(unsigned char);
 
   // positions2d
-  moleSize += sizeof(uint32);
-  std::vector<Avogadro::Vector2> pos2d = m_molecule->atomPositions2d();
-  for (std::vector<Avogadro::Vector2>::iterator it
-      = pos2d.begin(); it != pos2d.end(); ++it) {
-    moleSize += ProtoCall::MatrixSerialization::sizeOf(*it);
-  }
+  moleSize += sizeof(uint32) + m_molecule->atomPositions2d().size()
+      * ProtoCall::MatrixSerialization::sizeOf(Vector2());
 
   // positions3d
-  moleSize += sizeof(uint32);
-  std::vector<Avogadro::Vector3> pos3d = m_molecule->atomPositions3d();
-  for (std::vector<Avogadro::Vector3>::iterator it
-      = pos3d.begin(); it != pos3d.end(); ++it) {
-    moleSize += ProtoCall::MatrixSerialization::sizeOf(*it);
-  }
+  moleSize += sizeof(uint32) + m_molecule->atomPositions3d().size()
+      * ProtoCall::MatrixSerialization::sizeOf(Vector3());
 
   // bondPairs
   moleSize += this->sizeOfBondPairs();
   // bondOrder
   moleSize += this->sizeOfBondOrders();
+  // coordinate sets
+  moleSize += this->sizeOfCoordinateSets();
+  // unit cell
+  moleSize += this->sizeOfUnitCell();
+  // cubes
+  moleSize += this->sizeOfCubes();
 
   return moleSize;
 }
@@ -104,78 +121,70 @@ bool MoleculeSerializer::serializeAtomicNumbers(
     google::protobuf::io::CodedOutputStream *stream)
 {
   // Write atomic numbers
-  uint32 numberOfAtoms = m_molecule->atomicNumbers().size();
-  stream->WriteLittleEndian32(numberOfAtoms);
-  if (stream->HadError())
-    return false;
-  std::vector<unsigned char> atomicNumbers = m_molecule->atomicNumbers();
-  stream->WriteRaw(&atomicNumbers[0], numberOfAtoms * sizeof(unsigned char));
+  const Array<unsigned char> &atomicNumbers = m_molecule->atomicNumbers();
+  stream->WriteLittleEndian32(static_cast<uint32>(atomicNumbers.size()));
   if (stream->HadError())
     return false;
 
-  return true;
+  return Utils::writeRaw(stream, atomicNumbers.data(),
+                         atomicNumbers.size() * sizeof(unsigned char));
 }
 
 bool MoleculeSerializer::serializePositons2d(
     google::protobuf::io::CodedOutputStream *stream)
 {
-  std::vector<Avogadro::Vector2> pos2d = m_molecule->atomPositions2d();
-  stream->WriteLittleEndian32(pos2d.size());
+  const Array<Vector2> &pos2d = m_molecule->atomPositions2d();
+  stream->WriteLittleEndian32(static_cast<uint32>(pos2d.size()));
   if (stream->HadError())
       return false;
-  for (std::vector<Avogadro::Vector2>::iterator it = pos2d.begin();
-      it != pos2d.end(); ++it) {
-    if (!ProtoCall::MatrixSerialization::serialize(*it, stream))
-      return false;
-  }
 
-  return true;
+  return pos2d.empty()
+      || Utils::writeDoubles(stream, pos2d[0].data(), 2 * pos2d.size());
 }
 
 bool MoleculeSerializer::serializePostions3d(
     google::protobuf::io::CodedOutputStream *stream)
 {
   // position3d
-  std::vector<Avogadro::Vector3> pos3d = m_molecule->atomPositions3d();
-  stream->WriteLittleEndian32(pos3d.size());
+  const Array<Vector3> &pos3d = m_molecule->atomPositions3d();
+  stream->WriteLittleEndian32(static_cast<uint32>(pos3d.size()));
   if (stream->HadError())
     return false;
-  for (std::vector<Avogadro::Vector3>::iterator it = pos3d.begin();
-      it != pos3d.end(); ++it) {
-    if (!ProtoCall::MatrixSerialization::serialize(*it, stream))
-      return false;
-  }
 
-  return true;
+  return pos3d.empty()
+      || Utils::writeDoubles(stream, pos3d[0].data(), 3 * pos3d.size());
 }
 
 size_t MoleculeSerializer::sizeOfBondPairs()
 {
-  return sizeof(uint32) + m_molecule->bondPairs().size() * (2 * sizeof(uint32));
+  return sizeof(uint32) + m_molecule->bondPairs().size() * (2 * sizeof(uint64));
 }
 
 bool MoleculeSerializer::serializeBondPairs(
     google::protobuf::io::CodedOutputStream *stream)
 {
   // Write the number of pairs
-  stream->WriteLittleEndian32(m_molecule->bondPairs().size());
+  const Array<std::pair<Index, Index> > &bondPairs = m_molecule->bondPairs();
+  stream->WriteLittleEndian32(static_cast<uint32>(bondPairs.size()));
 
   if (stream->HadError())
     return false;
 
-  for (std::vector<std::pair<size_t, size_t> >::const_iterator it
-      = m_molecule->bondPairs().begin();
-      it != m_molecule->bondPairs().end(); ++it) {
-    std::pair<size_t, size_t> bond = *it;
-    stream->WriteLittleEndian32(bond.first);
-    if (stream->HadError())
-      return false;
-    stream->WriteLittleEndian32(bond.second);
-    if (stream->HadError())
-      return false;
+  // The pairs are written as 64 bit indices, in bulk if they are held that
+  // way in memory.
+  if (sizeof(std::pair<Index, Index>) == 2 * sizeof(uint64)
+      && Utils::isLittleEndian()) {
+    return Utils::writeRaw(stream, bondPairs.data(),
+                           bondPairs.size() * 2 * sizeof(uint64));
   }
 
-  return true;
+  for (Array<std::pair<Index, Index> >::const_iterator it = bondPairs.begin();
+      it != bondPairs.end(); ++it) {
+    stream->WriteLittleEndian64(it->first);
+    stream->WriteLittleEndian64(it->second);
+  }
+
+  return !stream->HadError();
 }
 
 size_t MoleculeSerializer::sizeOfBondOrders()
@@ -187,15 +196,117 @@ size_t MoleculeSerializer::sizeOfBondOrders()
 bool MoleculeSerializer::serializeBondOrders(
     google::protobuf::io::CodedOutputStream *stream)
 {
-  stream->WriteLittleEndian32(m_molecule->bondOrders().size());
+  stream->WriteLittleEndian32(
+        static_cast<uint32>(m_molecule->bondOrders().size()));
+  if (stream->HadError())
+    return false;
+
+  return Utils::writeRaw(stream, m_molecule->bondOrders().data(),
+                         m_molecule->bondOrders().size());
+}
+
+size_t MoleculeSerializer::sizeOfCoordinateSets()
+{
+  // The number of sets and atoms, then the positions of every set.
+  return 2 * sizeof(uint32) + m_molecule->coordinate3dCount()
+      * m_molecule->atomCount()
+      * ProtoCall::MatrixSerialization::sizeOf(Vector3());
+}
+
+bool MoleculeSerializer::serializeCoordinateSets(
+    google::protobuf::io::CodedOutputStream *stream)
+{
+  const int count = m_molecule->coordinate3dCount();
+  const size_t atomCount = m_molecule->atomCount();
+  stream->WriteLittleEndian32(static_cast<uint32>(count));
+  stream->WriteLittleEndian32(static_cast<uint32>(atomCount));
+  if (stream->HadError())
+    return false;
+
+  // Sets held in memory are shared rather than copied, those of a trajectory
+  // source are read one at a time.
+  Array<Vector3> positions;
+  for (int i = 0; i < count; ++i) {
+    if (!m_molecule->coordinate3d(i, positions)
+        || positions.size() != atomCount) {
+      return false;
+    }
+    if (atomCount > 0
+        && !Utils::writeDoubles(stream, positions[0].data(), 3 * atomCount)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+size_t MoleculeSerializer::sizeOfUnitCell()
+{
+  // A flag, then the cell matrix if there is one.
+  return sizeof(uint32) + (m_molecule->unitCell() ? 9 * sizeof(uint64) : 0);
+}
+
+bool MoleculeSerializer::serializeUnitCell(
+    google::protobuf::io::CodedOutputStream *stream)
+{
+  const UnitCell *unitCell = m_molecule->unitCell();
+  stream->WriteLittleEndian32(unitCell ? 1 : 0);
   if (stream->HadError())
     return false;
 
-  stream->WriteRaw(&m_molecule->bondOrders()[0],
-      m_molecule->bondOrders().size());
+  return !unitCell
+      || Utils::writeDoubles(stream, unitCell->cellMatrix().data(), 9);
+}
+
+size_t MoleculeSerializer::sizeOfCubes()
+{
+  size_t cubesSize = sizeof(uint32);
+  for (Index i = 0; i < m_molecule->cubeCount(); ++i) {
+    const Cube *cube = m_molecule->cube(i);
+    // The min and spacing, the dimensions and type, the name and the values.
+    cubesSize += 6 * sizeof(uint64) + 4 * sizeof(uint32)
+        + sizeof(uint32) + cube->name().size()
+        + sizeof(uint32) + cube->data()->size() * sizeof(uint64);
+  }
+
+  return cubesSize;
+}
+
+bool MoleculeSerializer::serializeCubes(
+    google::protobuf::io::CodedOutputStream *stream)
+{
+  stream->WriteLittleEndian32(static_cast<uint32>(m_molecule->cubeCount()));
   if (stream->HadError())
     return false;
 
+  for (Index i = 0; i < m_molecule->cubeCount(); ++i) {
+    const Cube *cube = m_molecule->cube(i);
+    Vector3 min = cube->min();
+    Vector3 spacing = cube->spacing();
+    if (!Utils::writeDoubles(stream, min.data(), 3)
+        || !Utils::writeDoubles(stream, spacing.data(), 3)) {
+      return false;
+    }
+    Vector3i dimensions = cube->dimensions();
+    for (int j = 0; j < 3; ++j)
+      stream->WriteLittleEndian32(static_cast<uint32>(dimensions[j]));
+    stream->WriteLittleEndian32(static_cast<uint32>(cube->cubeType()));
+
+    std::string name = cube->name();
+    stream->WriteLittleEndian32(static_cast<uint32>(name.size()));
+    if (!Utils::writeRaw(stream, name.data(), name.size()))
+      return false;
+
+    const std::vector<double> &values = *cube->data();
+    stream->WriteLittleEndian32(static_cast<uint32>(values.size()));
+    if (stream->HadError())
+      return false;
+    if (!values.empty()
+        && !Utils::writeDoubles(stream, &values[0], values.size())) {
+      return false;
+    }
+  }
+
   return true;
 }
 
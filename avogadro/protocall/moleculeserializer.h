@@ -31,6 +31,8 @@ namespace Core {
  *  <avogadro/protocall/moleculeserializer.h>
  * @brief Implementation of ProtoCall::Serialization::Serializer
  *
+ * The arrays of the molecule are written to the stream in bulk, straight
+ * from their storage. All numbers are little endian.
  */
 class AVOGADROPROTOCALL_EXPORT MoleculeSerializer
   : public ProtoCall::Serialization::Serializer
@@ -102,6 +104,42 @@ private:
    */
   bool serializePostions3d(google::protobuf::io::CodedOutputStream *stream);
 
+  /**
+   * @return The size the coordinate sets will take in the byte stream.
+   */
+  size_t sizeOfCoordinateSets();
+
+  /**
+   * Serialize the coordinate sets to the stream.
+   *
+   * @return true if successful, false otherwise.
+   */
+  bool serializeCoordinateSets(google::protobuf::io::CodedOutputStream *stream);
+
+  /**
+   * @return The size the unit cell will take in the byte stream.
+   */
+  size_t sizeOfUnitCell();
+
+  /**
+   * Serialize the unit cell to the stream.
+   *
+   * @return true if successful, false otherwise.
+   */
+  bool serializeUnitCell(google::protobuf::io::CodedOutputStream *stream);
+
+  /**
+   * @return The size the cubes will take in the byte stream.
+   */
+  size_t sizeOfCubes();
+
+  /**
+   * Serialize the cubes to the stream.
+   *
+   * @return true if successful, false otherwise.
+   */
+  bool serializeCubes(google::protobuf::io::CodedOutputStream *stream);
+
   const Avogadro::Core::Molecule *m_molecule;
 };
 
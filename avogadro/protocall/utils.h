@@ -1,8 +1,11 @@
 #include <google/protobuf/stubs/common.h>
+#include <google/protobuf/io/coded_stream.h>
+
+#include <cstddef>
 
 /**
  * namespace containing utility functions for encoding and decoding
- * floats and doubles.
+ * floats and doubles, and for copying arrays to and from streams in bulk.
  */
 namespace Avogadro {
 namespace ProtoCall {
@@ -10,6 +13,12 @@ namespace Utils {
 
 using google::protobuf::uint32;
 using google::protobuf::uint64;
+using google::protobuf::io::CodedInputStream;
+using google::protobuf::io::CodedOutputStream;
+
+// The streams take the size of raw data as an int, larger arrays are copied
+// in blocks of this size.
+const size_t maxRawBlockSize = 1 << 30;
 
 inline uint32 encodeFloat(float value)
 {
@@ -39,6 +48,90 @@ inline double decodeDouble(uint64 value)
   return f;
 }
 
+/**
+ * @return True if the host stores numbers little endian, as they are in the
+ * stream, so that arrays of numbers can be copied as they are.
+ */
+inline bool isLittleEndian()
+{
+  union {uint32 i; unsigned char c[4];};
+  i = 1;
+  return c[0] == 1;
+}
+
+/**
+ * Write @p size bytes of @p data to the stream in one go.
+ */
+inline bool writeRaw(CodedOutputStream *stream, const void *data, size_t size)
+{
+  const char *bytes = static_cast<const char *>(data);
+  while (size > 0) {
+    size_t block = size < maxRawBlockSize ? size : maxRawBlockSize;
+    stream->WriteRaw(bytes, static_cast<int>(block));
+    bytes += block;
+    size -= block;
+  }
+  return !stream->HadError();
+}
+
+/**
+ * Read @p size bytes from the stream into @p data in one go.
+ */
+inline bool readRaw(CodedInputStream *stream, void *data, size_t size)
+{
+  char *bytes = static_cast<char *>(data);
+  while (size > 0) {
+    size_t block = size < maxRawBlockSize ? size : maxRawBlockSize;
+    if (!stream->ReadRaw(bytes, static_cast<int>(block)))
+      return false;
+    bytes += block;
+    size -= block;
+  }
+  return true;
+}
+
+/**
+ * @return True if @p size bytes remain before the limit of the stream, so
+ * that an array can be sized before it is read without trusting the count
+ * read from the stream.
+ */
+inline bool canRead(CodedInputStream *stream, size_t size)
+{
+  int remaining = stream->BytesUntilLimit();
+  return remaining < 0 || size <= static_cast<size_t>(remaining);
+}
+
+/**
+ * Write @p count doubles as little endian 64 bit values, in bulk where the
+ * host byte order allows.
+ */
+inline bool writeDoubles(CodedOutputStream *stream, const double *values,
+                         size_t count)
+{
+  if (isLittleEndian())
+    return writeRaw(stream, values, count * sizeof(double));
+  for (size_t i = 0; i < count; ++i)
+    stream->WriteLittleEndian64(encodeDouble(values[i]));
+  return !stream->HadError();
+}
+
+/**
+ * Read @p count doubles written by writeDoubles().
+ */
+inline bool readDoubles(CodedInputStream *stream, double *values,
+                        size_t count)
+{
+  if (isLittleEndian())
+    return readRaw(stream, values, count * sizeof(double));
+  for (size_t i = 0; i < count; ++i) {
+    uint64 value;
+    if (!stream->ReadLittleEndian64(&value))
+      return false;
+    values[i] = decodeDouble(value);
+  }
+  return true;
+}
+
 } // Utils namespace
 } // ProtoCall namespace
 } // Avogadro namespace
@@ -17,12 +17,19 @@
 
 #include "meshgenerator.h"
 
+#include <avogadro/core/array.h>
 #include <avogadro/core/cube.h>
-#include <avogadro/core/mutex.h>
 #include <avogadro/core/mesh.h>
+#include <avogadro/core/readwritelock.h>
 
-#include <QReadWriteLock>
-#include <QDebug>
+#include <QtCore/QDebug>
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThreadPool>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
 
 namespace Avogadro {
 namespace QtGui {
@@ -30,6 +37,62 @@ namespace QtGui {
 using Core::Cube;
 using Core::Mesh;
 
+namespace {
+// Marks grid edges whose vertex has not been interpolated yet.
+const unsigned int noVertex = static_cast<unsigned int>(-1);
+
+// The smallest number of slabs worth marching as a separate block.
+const int minSlabsPerBlock = 4;
+}
+
+struct MeshGenerator::SlabMesh
+{
+  SlabMesh() : begin(0), end(0), slab(0) {}
+
+  int begin; /** The x index of the first slab of the block. */
+  int end;   /** One past the x index of the last slab of the block. */
+  Core::Array<Vector3f> vertices, normals;
+  Core::Array<unsigned int> indices;
+
+  int slab;  /** The x index of the slab being marched. */
+  /**
+   * Vertex indices of the grid edges of the slab being marched, indexed by
+   * the y and z grid coordinates. The x edges span the slab, the y and z edges
+   * lie in its lower (0) and upper (1) planes.
+   */
+  std::vector<unsigned int> xEdges, yEdges[2], zEdges[2];
+
+  /**
+   * The vertices on the y and z edges of the lower and upper planes of the
+   * block, as (edge key, vertex index) pairs. The upper plane of a block is
+   * the lower plane of the next one, these are welded when stitching.
+   */
+  std::vector<std::pair<size_t, unsigned int> > lower, upper;
+};
+
+class MeshGenerator::SlabRunner : public QRunnable
+{
+public:
+  SlabRunner(MeshGenerator *generator, SlabMesh *slabs, QAtomicInt *progress,
+             QSemaphore *done)
+    : m_generator(generator), m_slabs(slabs), m_progress(progress),
+      m_done(done)
+  {
+  }
+
+  void run()
+  {
+    m_generator->marchSlabs(*m_slabs, *m_progress);
+    m_done->release();
+  }
+
+private:
+  MeshGenerator *m_generator;
+  SlabMesh *m_slabs;
+  QAtomicInt *m_progress;
+  QSemaphore *m_done;
+};
+
 MeshGenerator::MeshGenerator(QObject *p) :
   QThread(p),
   m_iso(0.0),
@@ -57,7 +120,7 @@ MeshGenerator::MeshGenerator(const Cube *cube_, Mesh *mesh_,
   m_progmin(0),
   m_progmax(0)
 {
-  initialize(cube_, mesh_, iso);
+  initialize(cube_, mesh_, iso, reverse);
 }
 
 MeshGenerator::~MeshGenerator()
@@ -73,14 +136,15 @@ bool MeshGenerator::initialize(const Cube *cube_, Mesh *mesh_, float iso,
   m_mesh = mesh_;
   m_iso = iso;
   m_reverseWinding = reverse;
-  if (!m_cube->lock()->tryLock()) {
+  if (!m_cube->lock()->tryLockForRead()) {
     qDebug() << "Cannot get a read lock...";
     return false;
   }
   m_stepSize = static_cast<float>(m_cube->spacing().x());
   m_min = m_cube->min().cast<float>();
   m_dim = m_cube->dimensions();
-  m_progmax = m_dim.x();
+  // Progress is reported once for each slab between the x planes.
+  m_progmax = std::max(m_dim.x() - 1, 0);
   m_cube->lock()->unlock();
   return true;
 }
@@ -92,41 +156,126 @@ void MeshGenerator::run()
     return;
   }
 
-  // Attempt to obtain a lock, wait one second between attempts.
-  while (!m_cube->lock()->tryLock())
-    sleep(1);
+  // Readers share the cube, wait for any writer to finish with it.
+  m_cube->lock()->lockForRead();
 
   // Mark the mesh as being worked on and clear it
   m_mesh->setStable(false);
   m_mesh->clear();
 
-  m_vertices.reserve(m_dim.x()*m_dim.y()*m_dim.z()*3);
-  m_normals.reserve(m_dim.x()*m_dim.y()*m_dim.z()*3);
+  // Split the slabs into blocks, several per thread so that the blocks that
+  // do not intersect the surface do not leave threads idle.
+  const int slabCount = m_dim.x() - 1;
+  int blockCount = 0;
+  if (slabCount > 0) {
+    blockCount = std::min(4 * std::max(QThread::idealThreadCount(), 1),
+                          slabCount / minSlabsPerBlock);
+    blockCount = std::max(blockCount, 1);
+  }
+  std::vector<SlabMesh> blocks(blockCount);
+  // The blocks share the global pool with other generators, so wait for our
+  // own blocks rather than for the pool to be done.
+  QAtomicInt progress(0);
+  QSemaphore done;
+  for (int b = 0; b < blockCount; ++b) {
+    blocks[b].begin = slabCount * b / blockCount;
+    blocks[b].end = slabCount * (b + 1) / blockCount;
+    QThreadPool::globalInstance()->start(new SlabRunner(this, &blocks[b],
+                                                        &progress, &done));
+  }
+  done.acquire(blockCount);
+
+  m_cube->lock()->unlock();
 
-  // Now to march the cube
-  for(int i = 0; i < m_dim.x()-1; ++i) {
-    for(int j = 0; j < m_dim.y()-1; ++j) {
-      for(int k = 0; k < m_dim.z()-1; ++k) {
-        marchingCube(Vector3i(i, j, k));
+  // Stitch the blocks together, the vertices on the lower plane of a block
+  // are replaced by the same vertices on the upper plane of the previous one.
+  // The result is the same as marching all of the slabs in order.
+  size_t vertexCount = 0;
+  size_t indexCount = 0;
+  for (int b = 0; b < blockCount; ++b) {
+    vertexCount += blocks[b].vertices.size();
+    indexCount += blocks[b].indices.size();
+  }
+  Core::Array<Vector3f> vertices;
+  Core::Array<Vector3f> normals;
+  Core::Array<unsigned int> indices;
+  vertices.reserve(vertexCount);
+  normals.reserve(vertexCount);
+  indices.reserve(indexCount);
+
+  std::vector<unsigned int> boundary(2 * static_cast<size_t>(m_dim.y())
+                                     * m_dim.z(), noVertex);
+  std::vector<unsigned int> remap;
+  for (int b = 0; b < blockCount; ++b) {
+    SlabMesh &block = blocks[b];
+    remap.assign(block.vertices.size(), noVertex);
+    for (size_t i = 0; i < block.lower.size(); ++i)
+      remap[block.lower[i].second] = boundary[block.lower[i].first];
+    for (size_t i = 0; i < remap.size(); ++i) {
+      if (remap[i] == noVertex) {
+        remap[i] = static_cast<unsigned int>(vertices.size());
+        vertices.push_back(block.vertices[i]);
+        normals.push_back(block.normals[i]);
       }
     }
-    if (m_vertices.capacity() < m_vertices.size() + m_dim.y()*m_dim.x()*3) {
-      m_vertices.reserve(m_vertices.capacity()*2);
-      m_normals.reserve(m_normals.capacity()*2);
+    for (size_t i = 0; i < block.indices.size(); ++i)
+      indices.push_back(remap[block.indices[i]]);
+
+    if (b > 0) {
+      const SlabMesh &previous = blocks[b - 1];
+      for (size_t i = 0; i < previous.upper.size(); ++i)
+        boundary[previous.upper[i].first] = noVertex;
     }
-    emit progressValueChanged(i);
-  }
+    for (size_t i = 0; i < block.upper.size(); ++i)
+      boundary[block.upper[i].first] = remap[block.upper[i].second];
 
-  m_cube->lock()->unlock();
+    // Give the memory of the block back as we go.
+    block.vertices = Core::Array<Vector3f>();
+    block.normals = Core::Array<Vector3f>();
+    block.indices = Core::Array<unsigned int>();
+  }
 
   // Copy the data across
-  m_mesh->setVertices(m_vertices);
-  m_mesh->setNormals(m_normals);
+  m_mesh->setVertices(vertices);
+  m_mesh->setNormals(normals);
+  m_mesh->setIndices(indices);
   m_mesh->setStable(true);
+}
 
-  // Now we are done give all that memory back
-  m_vertices.resize(0);
-  m_normals.resize(0);
+void MeshGenerator::marchSlabs(SlabMesh &slabs, QAtomicInt &progress)
+{
+  // March the block one slab at a time. The vertices on the shared edges are
+  // looked up in the edge caches, the lower plane of a slab is the upper plane
+  // of the previous one.
+  const size_t planeSize = static_cast<size_t>(m_dim.y()) * m_dim.z();
+  slabs.xEdges.assign(planeSize, noVertex);
+  for (int plane = 0; plane < 2; ++plane) {
+    slabs.yEdges[plane].assign(planeSize, noVertex);
+    slabs.zEdges[plane].assign(planeSize, noVertex);
+  }
+  for (int i = slabs.begin; i < slabs.end; ++i) {
+    slabs.slab = i;
+    if (i > slabs.begin) {
+      slabs.yEdges[0].swap(slabs.yEdges[1]);
+      slabs.zEdges[0].swap(slabs.zEdges[1]);
+      std::fill(slabs.yEdges[1].begin(), slabs.yEdges[1].end(), noVertex);
+      std::fill(slabs.zEdges[1].begin(), slabs.zEdges[1].end(), noVertex);
+      std::fill(slabs.xEdges.begin(), slabs.xEdges.end(), noVertex);
+    }
+    for (int j = 0; j < m_dim.y()-1; ++j) {
+      for (int k = 0; k < m_dim.z()-1; ++k) {
+        marchingCube(slabs, Vector3i(i, j, k));
+      }
+    }
+    emit progressValueChanged(progress.fetchAndAddOrdered(1) + 1);
+  }
+
+  // The edge caches are not needed for stitching.
+  std::vector<unsigned int>().swap(slabs.xEdges);
+  for (int plane = 0; plane < 2; ++plane) {
+    std::vector<unsigned int>().swap(slabs.yEdges[plane]);
+    std::vector<unsigned int>().swap(slabs.zEdges[plane]);
+  }
 }
 
 void MeshGenerator::clear()
@@ -141,44 +290,88 @@ void MeshGenerator::clear()
   m_progmax = 0;
 }
 
-Vector3f MeshGenerator::normal(const Vector3f &pos)
+Vector3f MeshGenerator::gradient(int i, int j, int k) const
 {
-  Vector3f norm(m_cube->valuef(pos - Vector3f(0.01f, 0.00f, 0.00f))
-              - m_cube->valuef(pos + Vector3f(0.01f, 0.00f, 0.00f)),
-                m_cube->valuef(pos - Vector3f(0.00f, 0.01f, 0.00f))
-              - m_cube->valuef(pos + Vector3f(0.00f, 0.01f, 0.00f)),
-                m_cube->valuef(pos - Vector3f(0.00f, 0.00f, 0.01f))
-              - m_cube->valuef(pos + Vector3f(0.00f, 0.00f, 0.01f)));
-  norm.normalize();
-  return norm;
+  Vector3f grad;
+  for (int axis = 0; axis < 3; ++axis) {
+    Vector3i lo(i, j, k);
+    Vector3i hi(i, j, k);
+    lo[axis] = std::max(lo[axis] - 1, 0);
+    hi[axis] = std::min(hi[axis] + 1, m_dim[axis] - 1);
+    if (hi[axis] > lo[axis]) {
+      grad[axis] = static_cast<float>((m_cube->value(hi) - m_cube->value(lo))
+                                      / (hi[axis] - lo[axis]));
+    }
+    else {
+      grad[axis] = 0.0f;
+    }
+  }
+  return grad;
 }
 
-inline float MeshGenerator::offset(float val1, float val2)
+inline float MeshGenerator::offset(float val1, float val2) const
 {
   if (val2 - val1 < 1.0e-9f && val1 - val2 < 1.0e-9f)
     return 0.5;
   return (m_iso - val1) / (val2 - val1);
 }
 
-unsigned long MeshGenerator::duplicate(const Vector3i &, const Vector3f &)
+unsigned int MeshGenerator::edgeVertex(SlabMesh &slabs, const Vector3i &pos,
+                                       int axis, float val1, float val2) const
 {
-  // FIXME Not implemented yet.
-  return 0;
+  // The edge is in the slab being marched, its x coordinate tells which plane
+  // of the slab the y and z edges are in.
+  size_t edge = static_cast<size_t>(pos.y()) * m_dim.z() + pos.z();
+  int plane = pos.x() - slabs.slab;
+  unsigned int &cached = axis == 0 ? slabs.xEdges[edge]
+                       : (axis == 1 ? slabs.yEdges[plane][edge]
+                                    : slabs.zEdges[plane][edge]);
+  if (cached != noVertex)
+    return cached;
+
+  float fOffset = offset(val1, val2);
+
+  Vector3f vertex(pos.cast<float>() * m_stepSize + m_min);
+  vertex[axis] += fOffset * m_stepSize;
+
+  // Interpolate the gradients at the grid points, the normal points down the
+  // gradient, i.e. out of the surface enclosing the larger values.
+  Vector3i pos2(pos);
+  ++pos2[axis];
+  Vector3f norm(-(1.0f - fOffset) * gradient(pos.x(), pos.y(), pos.z())
+                - fOffset * gradient(pos2.x(), pos2.y(), pos2.z()));
+  if (norm.squaredNorm() > 0.0f)
+    norm.normalize();
+  if (m_reverseWinding)
+    norm = -norm;
+
+  cached = static_cast<unsigned int>(slabs.vertices.size());
+  slabs.vertices.push_back(vertex);
+  slabs.normals.push_back(norm);
+
+  // Remember the vertices on the boundary planes of the block for stitching.
+  if (axis != 0) {
+    std::pair<size_t, unsigned int> key(2 * edge + (axis - 1), cached);
+    if (plane == 0 && slabs.slab == slabs.begin)
+      slabs.lower.push_back(key);
+    else if (plane == 1 && slabs.slab == slabs.end - 1)
+      slabs.upper.push_back(key);
+  }
+  return cached;
 }
 
-bool MeshGenerator::marchingCube(const Vector3i &pos)
+bool MeshGenerator::marchingCube(SlabMesh &slabs,
+                                 const Vector3i &pos) const
 {
   float afCubeValue[8];
-  Vector3f asEdgeVertex[12];
-  Vector3f asEdgeNorm[12];
-
-  // Calculate the position in the Cube
-  Vector3f fPos(pos.cast<float>() * static_cast<float>(m_stepSize) + m_min);
+  unsigned int aiEdgeVertex[12];
 
   //Make a local copy of the values at the cube's corners
   for(int i = 0; i < 8; ++i) {
     afCubeValue[i] = static_cast<float>(
-          m_cube->value(Vector3i(pos + Vector3i(a2iVertexOffset[i]))));
+          m_cube->value(pos.x() + a2iVertexOffset[i][0],
+                        pos.y() + a2iVertexOffset[i][1],
+                        pos.z() + a2iVertexOffset[i][2]));
   }
 
   //Find which vertices are inside of the surface and which are outside
@@ -197,24 +390,23 @@ bool MeshGenerator::marchingCube(const Vector3i &pos)
     return false;
   }
 
-  //Find the point of intersection of the surface with each edge
-  //Then find the normal to the surface at those points
+  //Find the vertex on each intersected edge, edges shared with cubes that
+  //were already marched reuse their vertex
   for(int i = 0; i < 12; ++i) {
     //if there is an intersection on this edge
     if(iEdgeFlags & (1<<i)) {
-      float fOffset = offset(afCubeValue[a2iEdgeConnection[i][0]],
-          afCubeValue[a2iEdgeConnection[i][1]]);
-
-      asEdgeVertex[i] = Vector3f(
-            fPos.x() + (a2fVertexOffset[a2iEdgeConnection[i][0]][0]
-          + fOffset * a2fEdgeDirection[i][0]) * m_stepSize,
-          fPos.y() + (a2fVertexOffset[a2iEdgeConnection[i][0]][1]
-          + fOffset * a2fEdgeDirection[i][1]) * m_stepSize,
-          fPos.z() + (a2fVertexOffset[a2iEdgeConnection[i][0]][2]
-          + fOffset * a2fEdgeDirection[i][2]) * m_stepSize);
-
-      /// FIXME Optimize this to only calculate normals when required
-      asEdgeNorm[i] = normal(asEdgeVertex[i]);
+      // Orient the edge along the positive axis so that all of the cubes
+      // sharing it interpolate it in the same way.
+      int v1 = a2iEdgeConnection[i][0];
+      int v2 = a2iEdgeConnection[i][1];
+      int axis = 0;
+      while (a2iVertexOffset[v1][axis] == a2iVertexOffset[v2][axis])
+        ++axis;
+      if (a2iVertexOffset[v1][axis] > a2iVertexOffset[v2][axis])
+        std::swap(v1, v2);
+
+      aiEdgeVertex[i] = edgeVertex(slabs, pos + Vector3i(a2iVertexOffset[v1]),
+                                   axis, afCubeValue[v1], afCubeValue[v2]);
     }
   }
 
@@ -222,26 +414,19 @@ bool MeshGenerator::marchingCube(const Vector3i &pos)
   for(int i = 0; i < 5; ++i) {
     if(a2iTriangleConnectionTable[iFlagIndex][3*i] < 0)
       break;
-    int iVertex = 0;
-    iEdgeFlags = a2iTriangleConnectionTable[iFlagIndex][3*i];
     // Make sure we get the triangle winding the right way around!
     if (!m_reverseWinding) {
       for(int j = 0; j < 3; ++j) {
-        iVertex = a2iTriangleConnectionTable[iFlagIndex][3*i+j];
-        m_indices.push_back(static_cast<unsigned int>(m_vertices.size()));
-        m_normals.push_back(asEdgeNorm[iVertex]);
-        m_vertices.push_back(asEdgeVertex[iVertex]);
+        slabs.indices.push_back(
+              aiEdgeVertex[a2iTriangleConnectionTable[iFlagIndex][3*i+j]]);
       }
     }
     else {
       for(int j = 2; j >= 0; --j) {
-        iVertex = a2iTriangleConnectionTable[iFlagIndex][3*i+j];
-        m_indices.push_back(static_cast<unsigned int>(m_vertices.size()));
-        m_normals.push_back(-asEdgeNorm[iVertex]);
-        m_vertices.push_back(asEdgeVertex[iVertex]);
+        slabs.indices.push_back(
+              aiEdgeVertex[a2iTriangleConnectionTable[iFlagIndex][3*i+j]]);
       }
     }
-
   }
   return true;
 }
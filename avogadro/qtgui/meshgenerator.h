@@ -20,9 +20,9 @@
 
 #include "avogadroqtguiexport.h"
 
-#include <avogadro/core/array.h>
 #include <avogadro/core/vector.h>
 
+#include <QtCore/QAtomicInt>
 #include <QtCore/QThread>
 
 namespace Avogadro {
@@ -49,6 +49,11 @@ namespace QtGui {
  * You must first initialize the class and then call run() to actually
  * polygonize the isosurface. Connect to the classes finished() signal to
  * do something once the polygonization is complete.
+ *
+ * The Cube is marched in blocks of slabs on a thread pool, and the blocks are
+ * stitched together into a single indexed Mesh. Only a read lock is held on
+ * the Cube, so several generators (e.g. for the positive and negative
+ * isosurfaces of an orbital) can share it.
  */
 
 class AVOGADROQTGUI_EXPORT MeshGenerator : public QThread
@@ -88,6 +93,7 @@ public:
   /**
    * Use this function to begin Mesh generation. Uses an asynchronous thread,
    * and so avoids locking the user interface while the isosurface is found.
+   * The slabs of the Cube are marched in parallel on a thread pool.
    */
   void run();
 
@@ -124,12 +130,29 @@ signals:
 
 protected:
   /**
-   * Get the normal to the supplied point. This operation is quite expensive
-   * and so should be avoided wherever possible.
-   * @param pos The position of the vertex whose normal is needed.
-   * @return The normal vector for the supplied point.
+   * The part of the Mesh found in a block of consecutive slabs of the Cube,
+   * see the definition in meshgenerator.cpp.
    */
-  Vector3f normal(const Vector3f &pos);
+  struct SlabMesh;
+
+  /**
+   * Marches a SlabMesh on the thread pool.
+   */
+  class SlabRunner;
+
+  /**
+   * March all of the slabs of a block, emitting progressValueChanged() as each
+   * slab is completed.
+   * @param slabs The block of slabs, receives the vertices and triangles.
+   * @param progress The number of slabs completed over all of the blocks.
+   */
+  void marchSlabs(SlabMesh &slabs, QAtomicInt &progress);
+
+  /**
+   * Get the gradient of the Cube values at a grid point, using central
+   * differences of the neighboring grid values (one sided on the faces).
+   */
+  Vector3f gradient(int i, int j, int k) const;
 
   /**
    * Get the offset, i.e. the approximate point of intersection of the surface
@@ -137,14 +160,26 @@ protected:
    * @param val1 The position of the vertex whose normal is needed.
    * @return The normal vector for the supplied point.
    */
-  float offset(float val1, float val2);
+  float offset(float val1, float val2) const;
 
-  unsigned long duplicate(const Vector3i &c, const Vector3f &pos);
+  /**
+   * Get the vertex where the surface intersects a grid edge of the Cube. The
+   * vertex is only interpolated the first time the edge is visited, all of the
+   * marching cubes sharing the edge then reuse it.
+   * @param slabs The block of slabs being marched.
+   * @param pos The grid point the edge starts at.
+   * @param axis The direction of the edge, 0, 1 or 2 for x, y or z.
+   * @param val1 The Cube value at @p pos.
+   * @param val2 The Cube value at the other end of the edge.
+   * @return The index of the vertex.
+   */
+  unsigned int edgeVertex(SlabMesh &slabs, const Vector3i &pos, int axis,
+                          float val1, float val2) const;
 
   /**
    * Perform a marching cubes step on a single cube.
    */
-  bool marchingCube(const Vector3i &pos);
+  bool marchingCube(SlabMesh &slabs, const Vector3i &pos) const;
 
   float m_iso;           /** The value of the isosurface. */
   bool m_reverseWinding; /** Whether the winding and normals are reversed */
@@ -153,8 +188,6 @@ protected:
   float m_stepSize;      /** The step size of the cube. */
   Vector3f m_min; /** The minimum point in the cube. */
   Vector3i m_dim; /** The dimensions of the cube. */
-  Core::Array<Vector3f> m_vertices, m_normals;
-  Core::Array<unsigned int> m_indices;
   int m_progmin;
   int m_progmax;
 
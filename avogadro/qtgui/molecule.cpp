@@ -91,6 +91,14 @@ Molecule::AtomType Molecule::addAtom(unsigned char number, Index uniqueId)
   return a;
 }
 
+void Molecule::addAtoms(const Core::Array<unsigned char> &atomicNumbers)
+{
+  Index first = atomCount();
+  Core::Molecule::addAtoms(atomicNumbers);
+  for (Index i = first; i < atomCount(); ++i)
+    m_atomUniqueIds.push_back(i);
+}
+
 bool Molecule::removeAtom(Index index)
 {
   if (index >= atomCount())
@@ -102,45 +110,16 @@ bool Molecule::removeAtom(Index index)
   // Unique ID of an atom that was removed:
   m_atomUniqueIds[uniqueId] = MaxIndex;
 
-  // Before removing the atom we must first remove any bonds to it.
-  Core::Array<BondType> atomBonds = Core::Molecule::bonds(atom(index));
-  while (atomBonds.size()) {
-    removeBond(atomBonds.back());
-    atomBonds = Core::Molecule::bonds(atom(index));
-  }
-
+  // The last atom will be moved to this position, update its unique ID.
   Index newSize = static_cast<Index>(m_atomicNumbers.size() - 1);
   if (index != newSize) {
-    // We need to move the last atom to this position, and update its unique ID.
-    m_atomicNumbers[index] = m_atomicNumbers.back();
-    if (m_positions2d.size() == m_atomicNumbers.size())
-      m_positions2d[index] = m_positions2d.back();
-    if (m_positions3d.size() == m_atomicNumbers.size())
-      m_positions3d[index] = m_positions3d.back();
-
-    // Find any bonds to the moved atom and update their index.
-    atomBonds = Core::Molecule::bonds(atom(newSize));
-    foreach (const BondType &currentBond, atomBonds) {
-      std::pair<Index, Index> pair = m_bondPairs[currentBond.index()];
-      if (pair.first == newSize)
-        pair.first = index;
-      else if (pair.second == newSize)
-        pair.second = index;
-      m_bondPairs[currentBond.index()] = pair;
-    }
-
     Index movedAtomUID = findAtomUniqueId(newSize);
     assert(movedAtomUID != MaxIndex);
     m_atomUniqueIds[movedAtomUID] = index;
   }
-  // Resize the arrays for the smaller molecule.
-  if (m_positions2d.size() == m_atomicNumbers.size())
-    m_positions2d.resize(newSize);
-  if (m_positions3d.size() == m_atomicNumbers.size())
-    m_positions3d.resize(newSize);
-  m_atomicNumbers.resize(newSize);
 
-  return true;
+  // Removes the bonds to the atom through our removeBond(), then the atom.
+  return Core::Molecule::removeAtom(index);
 }
 
 bool Molecule::removeAtom(const AtomType &atom_)
@@ -199,6 +178,17 @@ Molecule::BondType Molecule::addBond(const AtomType &a, const AtomType &b,
   return Core::Molecule::addBond(a, b, order);
 }
 
+bool Molecule::addBonds(const Core::Array<std::pair<Index, Index> > &pairs,
+                        const Core::Array<unsigned char> &orders)
+{
+  Index first = bondCount();
+  if (!Core::Molecule::addBonds(pairs, orders))
+    return false;
+  for (Index i = first; i < bondCount(); ++i)
+    m_bondUniqueIds.push_back(i);
+  return true;
+}
+
 bool Molecule::removeBond(Index index)
 {
   if (index >= bondCount())
@@ -209,22 +199,15 @@ bool Molecule::removeBond(Index index)
 
   m_bondUniqueIds[uniqueId] = MaxIndex; // Unique ID of a bond that was removed.
 
+  // The last bond will be moved to this position, update its unique ID.
   Index newSize = static_cast<Index>(m_bondOrders.size() - 1);
   if (index != newSize) {
-    // We need to move the last bond to this position, and update its unique ID.
-    m_bondOrders[index] = m_bondOrders.back();
-    m_bondPairs[index] = m_bondPairs.back();
-
     Index movedBondUID = findBondUniqueId(newSize);
     assert(movedBondUID != MaxIndex);
     m_bondUniqueIds[movedBondUID] = index;
   }
 
-  // Resize the arrays for the smaller molecule.
-  m_bondOrders.resize(newSize);
-  m_bondPairs.resize(newSize);
-
-  return true;
+  return Core::Molecule::removeBond(index);
 }
 
 bool Molecule::removeBond(const BondType &bond_)
@@ -94,6 +94,12 @@ public:
    */
   virtual AtomType addAtom(unsigned char atomicNumber, Index uniqueId);
 
+  /**
+   * @brief Add many atoms at once, each given a new unique ID.
+   * @sa Core::Molecule::addAtoms
+   */
+  void addAtoms(const Core::Array<unsigned char> &atomicNumbers) AVO_OVERRIDE;
+
   /**
    * @brief Remove the specified atom from the molecule.
    * @param index The index of the atom to be removed.
@@ -163,6 +169,13 @@ public:
   virtual BondType addBond(const AtomType &a, const AtomType &b,
                            unsigned char bondOrder, Index uniqueId);
 
+  /**
+   * @brief Add many bonds at once, each given a new unique ID.
+   * @sa Core::Molecule::addBonds
+   */
+  bool addBonds(const Core::Array<std::pair<Index, Index> > &pairs,
+                const Core::Array<unsigned char> &orders) AVO_OVERRIDE;
+
   /**
    * @brief Remove the specified bond.
    * @param index The index of the bond to be removed.
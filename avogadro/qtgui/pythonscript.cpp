@@ -19,38 +19,381 @@
 #include "avogadropython.h"
 
 #include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QList>
 #include <QtCore/QProcess>
 #include <QtCore/QSettings>
+#include <QtCore/QThreadStorage>
+#include <QtCore/QWeakPointer>
 
 namespace Avogadro {
 namespace QtGui {
 
+namespace {
+// The program run by a resident interpreter, it takes the path to the script
+// as its only argument. Each request and response is a sequence of fields,
+// each preceded by a line holding its length in bytes (or just a number):
+//   request:  <id> <argument count> <arguments>... <standard input>
+//   response: <id> <exit code> <output>
+// The script is run as the main module for every request, with its standard
+// output and error captured into the output.
+const char pythonWorkerDriver[] =
+  "import io, os, runpy, sys, traceback\n"
+  "script = sys.argv[1]\n"
+  "if sys.platform == 'win32':\n"
+  "    import msvcrt\n"
+  "    msvcrt.setmode(sys.stdin.fileno(), os.O_BINARY)\n"
+  "    msvcrt.setmode(sys.stdout.fileno(), os.O_BINARY)\n"
+  "try:\n"
+  "    requests, responses = sys.stdin.buffer, sys.stdout.buffer\n"
+  "except AttributeError:\n"
+  "    requests, responses = sys.stdin, sys.stdout\n"
+  "sys.path.insert(0, os.path.dirname(os.path.abspath(script)))\n"
+  "def readField():\n"
+  "    return requests.read(int(requests.readline()))\n"
+  "while True:\n"
+  "    header = requests.readline()\n"
+  "    if not header:\n"
+  "        break\n"
+  "    requestId = int(header)\n"
+  "    args = [readField() for i in range(int(requests.readline()))]\n"
+  "    data = readField()\n"
+  "    output = io.BytesIO()\n"
+  "    if sys.version_info[0] < 3:\n"
+  "        stream, stdin = output, io.BytesIO(data)\n"
+  "    else:\n"
+  "        args = [arg.decode('utf-8') for arg in args]\n"
+  "        stream = io.TextIOWrapper(output, encoding='utf-8', write_through=True)\n"
+  "        stdin = io.TextIOWrapper(io.BytesIO(data), encoding='utf-8')\n"
+  "    sys.argv = [script] + args\n"
+  "    sys.stdin, sys.stdout, sys.stderr = stdin, stream, stream\n"
+  "    exitCode = 0\n"
+  "    try:\n"
+  "        runpy.run_path(script, run_name='__main__')\n"
+  "    except SystemExit as e:\n"
+  "        if e.code is None:\n"
+  "            exitCode = 0\n"
+  "        elif isinstance(e.code, int):\n"
+  "            exitCode = e.code\n"
+  "        else:\n"
+  "            stream.write(str(e.code) + '\\n')\n"
+  "            exitCode = 1\n"
+  "    except Exception:\n"
+  "        traceback.print_exc()\n"
+  "        exitCode = 1\n"
+  "    stream.flush()\n"
+  "    sys.stdin, sys.stdout, sys.stderr = sys.__stdin__, sys.__stdout__, sys.__stderr__\n"
+  "    result = output.getvalue()\n"
+  "    responses.write(('%d\\n%d\\n%d\\n' % (requestId, exitCode, len(result))).encode('ascii') + result)\n"
+  "    responses.flush()\n";
+}
+
+/**
+ * A resident python interpreter running requests for one script in turn. The
+ * requests are queued, and only written to the interpreter once the previous
+ * one has finished so that queued requests can still be cancelled.
+ */
+class PythonWorker : public QObject
+{
+  Q_OBJECT
+public:
+  /**
+   * @return The worker for @p scriptFilePath and @p interpreter in the current
+   * thread, which is created if needed.
+   */
+  static QSharedPointer<PythonWorker> instance(const QString &interpreter,
+                                               const QString &scriptFilePath);
+
+  ~PythonWorker() AVO_OVERRIDE;
+
+  /**
+   * Queue a request, starting the interpreter if needed.
+   * @return The id of the request.
+   */
+  int send(const QStringList &args, const QByteArray &scriptStdin);
+
+  /**
+   * Cancel the request @p requestId if it has not been started yet.
+   */
+  void cancel(int requestId);
+
+  /**
+   * Wait for the request @p requestId to finish, without emitting finished()
+   * for it. The interpreter is stopped if it does not finish in time.
+   * @return False if the request timed out or the interpreter failed.
+   */
+  bool waitFor(int requestId, int msecs, int &exitCode, QByteArray &output);
+
+  /**
+   * @return A description of the last failure of the interpreter.
+   */
+  QString errorString() const { return m_errorString; }
+
+signals:
+  /**
+   * Emitted when a request finishes, @p exitCode is negative if the
+   * interpreter failed.
+   */
+  void finished(int requestId, int exitCode, const QByteArray &output);
+
+private slots:
+  void readResponses();
+  void processFailed();
+
+private:
+  PythonWorker(const QString &interpreter, const QString &scriptFilePath);
+
+  struct Request
+  {
+    int id;
+    QByteArray frame;
+  };
+
+  bool start();
+  void writeNext();
+  void respond(int requestId, int exitCode, const QByteArray &output);
+  void failAll(const QString &errorString);
+
+  QString m_interpreter;
+  QString m_scriptFilePath;
+  QProcess m_process;
+  QByteArray m_buffer;
+  QList<Request> m_queue;
+  int m_nextId;
+  int m_running;
+  int m_waiting;
+  bool m_waitDone;
+  int m_waitExitCode;
+  QByteArray m_waitOutput;
+  QString m_errorString;
+};
+
+QSharedPointer<PythonWorker> PythonWorker::instance(
+    const QString &interpreter, const QString &scriptFilePath)
+{
+  // QProcess may only be used in the thread it was created in.
+  static QThreadStorage<QHash<QString, QWeakPointer<PythonWorker> > > workers;
+  QString key(interpreter + QLatin1Char('\n') + scriptFilePath);
+  QSharedPointer<PythonWorker> worker(workers.localData().value(key));
+  if (worker.isNull()) {
+    worker = QSharedPointer<PythonWorker>(
+          new PythonWorker(interpreter, scriptFilePath));
+    workers.localData().insert(key, worker.toWeakRef());
+  }
+  return worker;
+}
+
+PythonWorker::PythonWorker(const QString &interpreter,
+                           const QString &scriptFilePath)
+  : m_interpreter(interpreter), m_scriptFilePath(scriptFilePath),
+    m_nextId(0), m_running(-1), m_waiting(-1), m_waitDone(false),
+    m_waitExitCode(-1)
+{
+  connect(&m_process, SIGNAL(readyReadStandardOutput()),
+          SLOT(readResponses()));
+  connect(&m_process, SIGNAL(finished(int,QProcess::ExitStatus)),
+          SLOT(processFailed()));
+}
+
+PythonWorker::~PythonWorker()
+{
+  m_process.disconnect(this);
+  if (m_process.state() != QProcess::NotRunning) {
+    // The interpreter exits at the end of its input.
+    m_process.closeWriteChannel();
+    if (!m_process.waitForFinished(1000))
+      m_process.kill();
+  }
+}
+
+int PythonWorker::send(const QStringList &args, const QByteArray &scriptStdin)
+{
+  Request request;
+  request.id = m_nextId++;
+  request.frame = QByteArray::number(request.id) + '\n'
+      + QByteArray::number(args.size()) + '\n';
+  foreach (const QString &arg, args) {
+    QByteArray bytes(arg.toUtf8());
+    request.frame += QByteArray::number(bytes.size()) + '\n' + bytes;
+  }
+  request.frame += QByteArray::number(scriptStdin.size()) + '\n' + scriptStdin;
+  m_queue.append(request);
+
+  if (m_running < 0)
+    writeNext();
+  return request.id;
+}
+
+void PythonWorker::cancel(int requestId)
+{
+  for (int i = 0; i < m_queue.size(); ++i) {
+    if (m_queue[i].id == requestId) {
+      m_queue.removeAt(i);
+      return;
+    }
+  }
+}
+
+bool PythonWorker::waitFor(int requestId, int msecs, int &exitCode,
+                           QByteArray &output)
+{
+  m_waiting = requestId;
+  m_waitDone = false;
+  QElapsedTimer timer;
+  timer.start();
+  while (!m_waitDone) {
+    int remaining = msecs - static_cast<int>(timer.elapsed());
+    if (remaining <= 0 || m_process.state() == QProcess::NotRunning
+        || !m_process.waitForReadyRead(remaining)) {
+      break;
+    }
+  }
+  m_waiting = -1;
+
+  if (!m_waitDone) {
+    // The request may be stuck, so the interpreter cannot be reused.
+    if (m_process.state() != QProcess::NotRunning) {
+      m_process.disconnect(this);
+      m_process.kill();
+      m_process.waitForFinished(1000);
+      connect(&m_process, SIGNAL(finished(int,QProcess::ExitStatus)),
+              SLOT(processFailed()));
+      connect(&m_process, SIGNAL(readyReadStandardOutput()),
+              SLOT(readResponses()));
+      failAll(tr("Script timed out."));
+    }
+    return false;
+  }
+
+  exitCode = m_waitExitCode;
+  output = m_waitOutput;
+  m_waitOutput.clear();
+  return exitCode >= 0;
+}
+
+bool PythonWorker::start()
+{
+  m_buffer.clear();
+  m_errorString.clear();
+  m_process.start(m_interpreter, QStringList() << "-u" << "-c"
+                  << QString::fromLatin1(pythonWorkerDriver)
+                  << m_scriptFilePath);
+  if (!m_process.waitForStarted(5000)) {
+    m_errorString = tr("Script failed to start.");
+    return false;
+  }
+  return true;
+}
+
+void PythonWorker::writeNext()
+{
+  if (m_queue.isEmpty())
+    return;
+  if (m_process.state() == QProcess::NotRunning && !start()) {
+    failAll(m_errorString);
+    return;
+  }
+  Request request(m_queue.takeFirst());
+  m_running = request.id;
+  m_process.write(request.frame);
+}
+
+void PythonWorker::readResponses()
+{
+  m_buffer += m_process.readAllStandardOutput();
+  for (;;) {
+    // The three header lines, followed by the output.
+    int lineEnd[3];
+    int pos = 0;
+    for (int i = 0; i < 3; ++i) {
+      lineEnd[i] = m_buffer.indexOf('\n', pos);
+      if (lineEnd[i] < 0)
+        return;
+      pos = lineEnd[i] + 1;
+    }
+    int requestId = m_buffer.left(lineEnd[0]).toInt();
+    int exitCode = m_buffer.mid(lineEnd[0] + 1,
+                                lineEnd[1] - lineEnd[0] - 1).toInt();
+    int size = m_buffer.mid(lineEnd[1] + 1,
+                            lineEnd[2] - lineEnd[1] - 1).toInt();
+    if (m_buffer.size() < pos + size)
+      return;
+    QByteArray output(m_buffer.mid(pos, size));
+    m_buffer.remove(0, pos + size);
+
+    m_running = -1;
+    respond(requestId, exitCode, output);
+    writeNext();
+  }
+}
+
+void PythonWorker::processFailed()
+{
+  QString error(QString::fromLocal8Bit(m_process.readAllStandardError()));
+  failAll(tr("Script interpreter exited unexpectedly.\n%1").arg(error));
+}
+
+void PythonWorker::respond(int requestId, int exitCode,
+                           const QByteArray &output)
+{
+  if (requestId == m_waiting) {
+    m_waitDone = true;
+    m_waitExitCode = exitCode;
+    m_waitOutput = output;
+  }
+  else {
+    emit finished(requestId, exitCode, output);
+  }
+}
+
+void PythonWorker::failAll(const QString &errorString)
+{
+  m_errorString = errorString;
+  QList<int> failed;
+  if (m_running >= 0)
+    failed << m_running;
+  foreach (const Request &request, m_queue)
+    failed << request.id;
+  m_running = -1;
+  m_queue.clear();
+  foreach (int requestId, failed)
+    respond(requestId, -1, QByteArray());
+}
+
 PythonScript::PythonScript(const QString &scriptFilePath_, QObject *parent_)
   : QObject(parent_),
     m_debug(!qgetenv("AVO_PYTHON_SCRIPT_DEBUG").isEmpty()),
-    m_scriptFilePath(scriptFilePath_)
+    m_scriptFilePath(scriptFilePath_),
+    m_persistent(false),
+    m_asyncRequest(-1)
 {
   setDefaultPythonInterpretor();
 }
 
 PythonScript::PythonScript(QObject *parent_)
   : QObject(parent_),
-    m_debug(!qgetenv("AVO_PYTHON_SCRIPT_DEBUG").isEmpty())
+    m_debug(!qgetenv("AVO_PYTHON_SCRIPT_DEBUG").isEmpty()),
+    m_persistent(false),
+    m_asyncRequest(-1)
 {
   setDefaultPythonInterpretor();
 }
 
 PythonScript::~PythonScript()
 {
+  resetWorker();
 }
 
 void PythonScript::setScriptFilePath(const QString &scriptFile)
 {
+  resetWorker();
   m_scriptFilePath = scriptFile;
 }
 
 void PythonScript::setDefaultPythonInterpretor()
 {
+  resetWorker();
   m_pythonInterpreter = qgetenv("AVO_PYTHON_INTERPRETER");
   if (m_pythonInterpreter.isEmpty()) {
     m_pythonInterpreter = QSettings().value(
@@ -64,6 +407,22 @@ QByteArray PythonScript::execute(const QStringList &args,
                                  const QByteArray &scriptStdin)
 {
   clearErrors();
+
+  if (m_persistent) {
+    PythonWorker *pythonWorker = worker();
+    int requestId = pythonWorker->send(requestArgs(args), scriptStdin);
+    int exitCode = -1;
+    QByteArray output;
+    if (!pythonWorker->waitFor(requestId, 5000, exitCode, output)) {
+      m_errors << tr("Error running script '%1 %2': %3")
+                  .arg(m_pythonInterpreter,
+                       QStringList(requestArgs(args)).join(" "),
+                       pythonWorker->errorString());
+      return QByteArray();
+      }
+    return workerResult(exitCode, output, args);
+    }
+
   QProcess proc;
 
   // Merge stdout and stderr
@@ -132,6 +491,104 @@ QByteArray PythonScript::execute(const QStringList &args,
   return result;
 }
 
+void PythonScript::setPersistent(bool persistent)
+{
+  if (m_persistent == persistent)
+    return;
+  m_persistent = persistent;
+  if (!m_persistent)
+    resetWorker();
+}
+
+int PythonScript::asyncExecute(const QStringList &args,
+                               const QByteArray &scriptStdin)
+{
+  cancelPending();
+  clearErrors();
+  m_asyncArgs = args;
+  m_asyncRequest = worker()->send(requestArgs(args), scriptStdin);
+  return m_asyncRequest;
+}
+
+void PythonScript::cancelPending()
+{
+  if (m_asyncRequest < 0)
+    return;
+  // A request that is already running cannot be interrupted, but its output
+  // is ignored.
+  if (m_worker)
+    m_worker->cancel(m_asyncRequest);
+  m_asyncRequest = -1;
+  m_asyncArgs.clear();
+}
+
+void PythonScript::workerFinished(int requestId, int exitCode,
+                                  const QByteArray &output)
+{
+  if (requestId != m_asyncRequest)
+    return;
+  m_asyncRequest = -1;
+  clearErrors();
+  QByteArray result;
+  if (exitCode < 0) {
+    m_errors << tr("Error running script '%1 %2': %3")
+                .arg(m_pythonInterpreter,
+                     QStringList(requestArgs(m_asyncArgs)).join(" "),
+                     m_worker->errorString());
+    }
+  else {
+    result = workerResult(exitCode, output, m_asyncArgs);
+    }
+  m_asyncArgs.clear();
+  emit finished(requestId, result);
+}
+
+PythonWorker * PythonScript::worker()
+{
+  if (!m_worker) {
+    m_worker = PythonWorker::instance(m_pythonInterpreter, m_scriptFilePath);
+    connect(m_worker.data(), SIGNAL(finished(int,int,QByteArray)),
+            SLOT(workerFinished(int,int,QByteArray)));
+    }
+  return m_worker.data();
+}
+
+void PythonScript::resetWorker()
+{
+  cancelPending();
+  if (m_worker) {
+    m_worker->disconnect(this);
+    m_worker.clear();
+    }
+}
+
+QStringList PythonScript::requestArgs(const QStringList &args) const
+{
+  QStringList realArgs(args);
+  if (m_debug)
+    realArgs.prepend("--debug");
+  return realArgs;
+}
+
+QByteArray PythonScript::workerResult(int exitCode, const QByteArray &output,
+                                      const QStringList &args)
+{
+  if (exitCode != 0) {
+    m_errors << tr("Error running script '%1 %2': Abnormal exit status %3"
+                   "\n\nOutput:\n%4")
+                .arg(m_pythonInterpreter)
+                .arg(QStringList(requestArgs(args)).join(" "))
+                .arg(exitCode)
+                .arg(QString(output));
+    return QByteArray();
+    }
+
+  if (m_debug)
+    qDebug() << "Output:" << output;
+
+  return output;
+}
+
 QString PythonScript::processErrorString(const QProcess &proc) const
 {
   QString result;
@@ -161,3 +618,5 @@ QString PythonScript::processErrorString(const QProcess &proc) const
 
 } // namespace QtGui
 } // namespace Avogadro
+
+#include "pythonscript.moc"
@@ -23,6 +23,7 @@
 #include <avogadro/core/avogadrocore.h>
 
 #include <QtCore/QByteArray>
+#include <QtCore/QSharedPointer>
 #include <QtCore/QString>
 #include <QtCore/QStringList>
 
@@ -31,9 +32,17 @@ class QProcess;
 namespace Avogadro {
 namespace QtGui {
 
+class PythonWorker;
+
 /**
  * @brief The PythonScript class implements a interface for calling short-lived
  * python utility scripts.
+ *
+ * By default every call to execute() starts a new interpreter. In persistent
+ * mode the calls are instead sent as requests to a resident interpreter, which
+ * runs the script as its main module once per request. This avoids the start
+ * up cost of the interpreter, and allows requests to be made asynchronously
+ * with asyncExecute().
  */
 class AVOGADROQTGUI_EXPORT PythonScript : public QObject
 {
@@ -100,12 +109,52 @@ public:
   QByteArray execute(const QStringList &args,
                      const QByteArray &scriptStdin = QByteArray());
 
+  /**
+   * @return True if the script is run by a resident interpreter.
+   */
+  bool isPersistent() const { return m_persistent; }
+
+  /**
+   * Run the script in a resident interpreter rather than a new process for
+   * each call to execute(). The interpreter is shared by all PythonScript
+   * objects in the same thread that use the same script and interpreter, and
+   * is started when it is first needed.
+   */
+  void setPersistent(bool persistent);
+
+  /**
+   * Send a request to the resident interpreter without waiting for it to
+   * finish, whether or not the script is in persistent mode. The finished()
+   * signal is emitted with the returned id once the output is available. Any
+   * earlier request made with asyncExecute() that has not finished yet is
+   * superseded, and finished() will not be emitted for it.
+   * @return The id of the request.
+   */
+  int asyncExecute(const QStringList &args,
+                   const QByteArray &scriptStdin = QByteArray());
+
+  /**
+   * Cancel the outstanding request made with asyncExecute(), if any.
+   */
+  void cancelPending();
+
+signals:
+  /**
+   * Emitted when the request @p requestId made with asyncExecute() finishes.
+   * @p output is the standard output of the script, and errorList() holds any
+   * errors that occurred.
+   */
+  void finished(int requestId, const QByteArray &output);
+
 public slots:
   /**
    * Enable/disable debugging.
    */
   void setDebug(bool d) { m_debug = d; }
 
+private slots:
+  void workerFinished(int requestId, int exitCode, const QByteArray &output);
+
 protected:
   bool m_debug;
   QString m_pythonInterpreter;
@@ -114,6 +163,16 @@ protected:
 
 private:
   QString processErrorString(const QProcess &proc) const;
+  PythonWorker * worker();
+  void resetWorker();
+  QStringList requestArgs(const QStringList &args) const;
+  QByteArray workerResult(int exitCode, const QByteArray &output,
+                          const QStringList &args);
+
+  bool m_persistent;
+  QSharedPointer<PythonWorker> m_worker;
+  int m_asyncRequest;
+  QStringList m_asyncArgs;
 };
 
 } // namespace QtGui
@@ -46,8 +46,12 @@ protected:
   Array<Vector3>& positions3d() { return m_mol.m_molecule.atomPositions3d(); }
   Array<AtomHybridization>& hybridizations() { return m_mol.m_molecule.hybridizations(); }
   Array<signed char>& formalCharges() { return m_mol.m_molecule.formalCharges(); }
-  Array<std::pair<Index, Index> >& bondPairs() { return m_mol.m_molecule.bondPairs(); }
+  Array<std::pair<Index, Index> >& bondPairs() { return m_mol.m_molecule.m_bondPairs; }
   Array<unsigned char>& bondOrders() { return m_mol.m_molecule.bondOrders(); }
+  // bondPairs() bypasses the molecule's bond index, it must be kept up to date
+  // by removing bonds from it before modifying them and adding them after.
+  void indexBond(Index bondId) { m_mol.m_molecule.indexBond(bondId); }
+  void unindexBond(Index bondId) { m_mol.m_molecule.unindexBond(bondId); }
   RWMolecule &m_mol;
 };
 
@@ -162,11 +166,13 @@ public:
       Array<RWMolecule::BondType> atomBonds = m_mol.bonds(movedId);
       for (Array<RWMolecule::BondType>::const_iterator it = atomBonds.begin(),
            itEnd = atomBonds.end(); it != itEnd; ++it) {
+        unindexBond(it->index());
         std::pair<Index, Index> &bondPair = bondPairs()[it->index()];
         if (bondPair.first == movedId)
           bondPair.first = m_atomId;
         else
           bondPair.second = m_atomId;
+        indexBond(it->index());
       }
 
       // Update the moved atom's uid
@@ -200,11 +206,13 @@ public:
       Array<RWMolecule::BondType> atomBonds(m_mol.bonds(m_atomId));
       for (Array<RWMolecule::BondType>::iterator it = atomBonds.begin(),
            itEnd = atomBonds.end(); it != itEnd; ++it) {
+        unindexBond(it->index());
         std::pair<Index, Index> &bondPair = bondPairs()[it->index()];
         if (bondPair.first == m_atomId)
           bondPair.first = movedId;
         else
           bondPair.second = movedId;
+        indexBond(it->index());
       }
 
       // Update the moved atom's UID
@@ -413,14 +421,16 @@ public:
 
   void redo() AVO_OVERRIDE
   {
+    Array<Vector3>::Span positions(positions3d().span());
     for (size_t i = 0; i < m_atomIds.size(); ++i)
-      positions3d()[m_atomIds[i]] = m_newPosition3ds[i];
+      positions[m_atomIds[i]] = m_newPosition3ds[i];
   }
 
   void undo() AVO_OVERRIDE
   {
+    Array<Vector3>::Span positions(positions3d().span());
     for (size_t i = 0; i < m_atomIds.size(); ++i)
-      positions3d()[m_atomIds[i]] = m_oldPosition3ds[i];
+      positions[m_atomIds[i]] = m_oldPosition3ds[i];
   }
 
   bool mergeWith(const QUndoCommand *o)
@@ -583,6 +593,7 @@ public:
     assert(bondPairs().size() == m_bondId);
     bondOrders().push_back(m_bondOrder);
     bondPairs().push_back(m_bondPair);
+    indexBond(m_bondId);
     if (m_uniqueId >= bondUniqueIds().size())
       bondUniqueIds().resize(m_uniqueId + 1, MaxIndex);
     bondUniqueIds()[m_uniqueId] = m_bondId;
@@ -592,6 +603,7 @@ public:
   {
     assert(bondOrders().size() == m_bondId + 1);
     assert(bondPairs().size() == m_bondId + 1);
+    unindexBond(m_bondId);
     bondOrders().pop_back();
     bondPairs().pop_back();
     bondUniqueIds()[m_uniqueId] = MaxIndex;
@@ -653,9 +665,12 @@ public:
 
     // Move the last bond's data to the removed bond's index:
     Index movedId = m_mol.bondCount() - 1;
+    unindexBond(m_bondId);
     if (m_bondId != movedId) {
+      unindexBond(movedId);
       bondOrders()[m_bondId] = bondOrders().back();
       bondPairs()[m_bondId] = bondPairs().back();
+      indexBond(m_bondId);
 
       // Update moved bond's UID
       Index movedUid = m_mol.bondUniqueId(movedId);
@@ -676,14 +691,17 @@ public:
     Index movedId = m_mol.bondCount() - 1;
     if (m_bondId != movedId) {
       using std::swap;
+      unindexBond(m_bondId);
       swap(bondOrders()[m_bondId], bondOrders().back());
       swap(bondPairs()[m_bondId], bondPairs().back());
+      indexBond(movedId);
 
       // Update moved bond's UID
       Index movedUid = m_mol.bondUniqueId(m_bondId);
       assert(movedUid != MaxIndex);
       bondUniqueIds()[movedUid] = movedId;
     }
+    indexBond(m_bondId);
 
     // Restore the removed bond's UID
     bondUniqueIds()[m_bondUid] = m_bondId;
@@ -825,14 +843,15 @@ public:
   {
   }
 
+  // Replacing every bond invalidates the bond index of the molecule.
   void redo() AVO_OVERRIDE
   {
-    bondPairs() = m_newBondPairs;
+    m_mol.m_molecule.setBondPairs(m_newBondPairs);
   }
 
   void undo() AVO_OVERRIDE
   {
-    bondPairs() = m_oldBondPairs;
+    m_mol.m_molecule.setBondPairs(m_oldBondPairs);
   }
 };
 } // end anon namespace
@@ -878,12 +897,16 @@ public:
 
   void redo() AVO_OVERRIDE
   {
+    unindexBond(m_bondId);
     bondPairs()[m_bondId] = m_newBondPair;
+    indexBond(m_bondId);
   }
 
   void undo() AVO_OVERRIDE
   {
+    unindexBond(m_bondId);
     bondPairs()[m_bondId] = m_oldBondPair;
+    indexBond(m_bondId);
   }
 };
 } // end anon namespace
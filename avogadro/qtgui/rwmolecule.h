@@ -610,11 +610,13 @@ RWMolecule::bonds(const RWMolecule::AtomType &a) const
 inline Core::Array<RWMolecule::BondType>
 RWMolecule::bonds(const Index &atomId) const
 {
+  std::vector<Index> indices = m_molecule.bondIndices(atomId);
   Core::Array<RWMolecule::BondType> result;
-  for (Index i = 0; i < m_molecule.m_bondPairs.size(); ++i)
-    if (m_molecule.m_bondPairs[i].first == atomId
-        || m_molecule.m_bondPairs[i].second == atomId)
-      result.push_back(BondType(const_cast<RWMolecule*>(this), i));
+  result.reserve(indices.size());
+  for (std::vector<Index>::const_iterator it = indices.begin(),
+       itEnd = indices.end(); it != itEnd; ++it) {
+    result.push_back(BondType(const_cast<RWMolecule*>(this), *it));
+  }
   return result;
 }
 
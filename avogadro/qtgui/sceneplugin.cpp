@@ -31,6 +31,12 @@ void ScenePlugin::processEditable(const RWMolecule &, Rendering::GroupNode &)
 {
 }
 
+bool ScenePlugin::processChanges(const Core::Molecule &,
+                                 Rendering::GroupNode &, unsigned int)
+{
+  return false;
+}
+
 QWidget * ScenePlugin::setupWidget()
 {
   return NULL;
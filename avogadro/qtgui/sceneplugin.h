@@ -60,6 +60,20 @@ public:
   virtual void processEditable(const RWMolecule &molecule,
                                Rendering::GroupNode &node);
 
+  /**
+   * Update the primitives added to @a node by an earlier call to process()
+   * after the molecule changed without atoms or bonds being added or removed,
+   * for example when atoms are moved. Updating the existing primitives in
+   * place avoids building and uploading all of the geometry again.
+   * @param changes The Molecule::MoleculeChange flags of the change.
+   * @return True if the primitives were updated. If false is returned the
+   * node is cleared and process() is called instead, which is what the
+   * default implementation does.
+   */
+  virtual bool processChanges(const Core::Molecule &molecule,
+                              Rendering::GroupNode &node,
+                              unsigned int changes);
+
   /**
    * The name of the scene plugin, will be displayed in the user interface.
    */
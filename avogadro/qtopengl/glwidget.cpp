@@ -39,7 +39,8 @@ GLWidget::GLWidget(QWidget *parent_)
   : QGLWidget(parent_),
     m_activeTool(NULL),
     m_defaultTool(NULL),
-    m_renderTimer(NULL)
+    m_renderTimer(NULL),
+    m_moleculeNode(NULL)
 {
   setFocusPolicy(Qt::ClickFocus);
   connect(&m_scenePlugins,
@@ -63,7 +64,8 @@ void GLWidget::setMolecule(QtGui::Molecule *mol)
   m_molecule = mol;
   foreach (QtGui::ToolPlugin *tool, m_tools)
     tool->setMolecule(m_molecule);
-  connect(m_molecule, SIGNAL(changed(unsigned int)), SLOT(updateScene()));
+  connect(m_molecule, SIGNAL(changed(unsigned int)),
+          SLOT(moleculeChanged(unsigned int)));
 }
 
 QtGui::Molecule * GLWidget::molecule()
@@ -85,35 +87,97 @@ void GLWidget::updateScene()
   if (mol) {
     Rendering::GroupNode &node = m_renderer.scene().rootNode();
     node.clear();
-    Rendering::GroupNode *moleculeNode = new Rendering::GroupNode(&node);
-
-    foreach (QtGui::ScenePlugin *scenePlugin,
-             m_scenePlugins.activeScenePlugins()) {
-      Rendering::GroupNode *engineNode = new Rendering::GroupNode(moleculeNode);
+    m_moleculeNode = new Rendering::GroupNode(&node);
+    m_drawnPlugins = m_scenePlugins.activeScenePlugins();
+    m_engineNodes.clear();
+    m_toolNodes.clear();
+
+    foreach (QtGui::ScenePlugin *scenePlugin, m_drawnPlugins) {
+      Rendering::GroupNode *engineNode =
+          new Rendering::GroupNode(m_moleculeNode);
       scenePlugin->process(*mol, *engineNode);
+      m_engineNodes << engineNode;
     }
 
     // Let the tools perform any drawing they need to do.
-    if (m_activeTool) {
-      Rendering::GroupNode *toolNode = new Rendering::GroupNode(moleculeNode);
-      m_activeTool->draw(*toolNode);
-    }
-
-    if (m_defaultTool) {
-      Rendering::GroupNode *toolNode = new Rendering::GroupNode(moleculeNode);
-      m_defaultTool->draw(*toolNode);
-    }
+    drawTools();
 
     m_renderer.resetGeometry();
     updateGL();
   }
-  if (mol != m_molecule)
+  if (mol != m_molecule) {
     delete mol;
+    // The primitives refer to the temporary molecule, never update them.
+    m_moleculeNode = NULL;
+  }
+}
+
+void GLWidget::moleculeChanged(unsigned int changes)
+{
+  // The flags share bits, so each operation must be tested for all of its own.
+  const unsigned int added = QtGui::Molecule::Added;
+  const unsigned int removed = QtGui::Molecule::Removed;
+  if (!m_molecule || !m_moleculeNode || (changes & added) == added
+      || (changes & removed) == removed
+      || m_drawnPlugins != m_scenePlugins.activeScenePlugins()) {
+    updateScene();
+    return;
+  }
+
+  for (int i = 0; i < m_drawnPlugins.size(); ++i) {
+    QtGui::ScenePlugin *scenePlugin = m_drawnPlugins[i];
+    Rendering::GroupNode *engineNode = m_engineNodes[i];
+    if (!scenePlugin->processChanges(*m_molecule, *engineNode, changes)) {
+      engineNode->clear();
+      scenePlugin->process(*m_molecule, *engineNode);
+    }
+  }
+
+  drawTools();
+  m_renderer.resetGeometry();
+  updateGL();
+}
+
+void GLWidget::updateTools()
+{
+  if (!m_moleculeNode) {
+    updateScene();
+    return;
+  }
+
+  drawTools();
+  m_renderer.resetGeometry();
+  updateGL();
+}
+
+void GLWidget::drawTools()
+{
+  foreach (Rendering::GroupNode *toolNode, m_toolNodes) {
+    m_moleculeNode->removeChild(toolNode);
+    delete toolNode;
+  }
+  m_toolNodes.clear();
+
+  if (m_activeTool) {
+    Rendering::GroupNode *toolNode = new Rendering::GroupNode(m_moleculeNode);
+    m_activeTool->draw(*toolNode);
+    m_toolNodes << toolNode;
+  }
+
+  if (m_defaultTool) {
+    Rendering::GroupNode *toolNode = new Rendering::GroupNode(m_moleculeNode);
+    m_defaultTool->draw(*toolNode);
+    m_toolNodes << toolNode;
+  }
 }
 
 void GLWidget::clearScene()
 {
   m_renderer.scene().clear();
+  m_moleculeNode = NULL;
+  m_drawnPlugins.clear();
+  m_engineNodes.clear();
+  m_toolNodes.clear();
 }
 
 void GLWidget::resetCamera()
@@ -166,7 +230,7 @@ void GLWidget::setActiveTool(QtGui::ToolPlugin *tool)
 
   if (m_activeTool && m_activeTool != m_defaultTool) {
     disconnect(m_activeTool, SIGNAL(drawablesChanged()),
-               this, SLOT(updateScene()));
+               this, SLOT(updateTools()));
   }
 
   if (tool)
@@ -175,7 +239,7 @@ void GLWidget::setActiveTool(QtGui::ToolPlugin *tool)
 
   if (m_activeTool && m_activeTool != m_defaultTool) {
     connect(m_activeTool, SIGNAL(drawablesChanged()),
-            this, SLOT(updateScene()));
+            this, SLOT(updateTools()));
   }
 }
 
@@ -198,7 +262,7 @@ void GLWidget::setDefaultTool(QtGui::ToolPlugin *tool)
 
   if (m_defaultTool && m_activeTool != m_defaultTool) {
     disconnect(m_defaultTool, SIGNAL(drawablesChanged()),
-               this, SLOT(updateScene()));
+               this, SLOT(updateTools()));
   }
 
   if (tool)
@@ -207,7 +271,7 @@ void GLWidget::setDefaultTool(QtGui::ToolPlugin *tool)
 
   if (m_defaultTool && m_activeTool != m_defaultTool) {
     connect(m_defaultTool, SIGNAL(drawablesChanged()),
-            this, SLOT(updateScene()));
+            this, SLOT(updateTools()));
   }
 }
 
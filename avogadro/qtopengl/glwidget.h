@@ -176,6 +176,19 @@ protected slots:
    */
   void updateTimeout();
 
+  /**
+   * Update the scene after the molecule changed. Changes that do not add or
+   * remove atoms or bonds are passed to the scene plugins to update their
+   * primitives in place, anything else rebuilds the scene.
+   */
+  void moleculeChanged(unsigned int changes);
+
+  /**
+   * Redraw the primitives of the active and default tools, leaving those of
+   * the scene plugins as they are.
+   */
+  void updateTools();
+
 protected:
   /** This is where the GL context is initialized. */
   void initializeGL();
@@ -205,6 +218,15 @@ private:
   QtGui::ScenePluginModel m_scenePlugins;
 
   QTimer *m_renderTimer;
+
+  /** The nodes of the scene plugins and tools in the current scene. @{ */
+  Rendering::GroupNode *m_moleculeNode;
+  QList<QtGui::ScenePlugin*> m_drawnPlugins;
+  QList<Rendering::GroupNode*> m_engineNodes;
+  QList<Rendering::GroupNode*> m_toolNodes;
+  /** @} */
+
+  void drawTools();
 };
 
 } // End QtOpenGL namespace
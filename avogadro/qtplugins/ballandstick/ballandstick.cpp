@@ -22,6 +22,7 @@
 #include <avogadro/rendering/groupnode.h>
 #include <avogadro/rendering/spheregeometry.h>
 #include <avogadro/rendering/cylindergeometry.h>
+#include <avogadro/qtgui/molecule.h>
 #include <avogadro/qtgui/rwmolecule.h>
 
 #include <QtWidgets/QWidget>
@@ -41,6 +42,40 @@ using Rendering::GroupNode;
 using Rendering::SphereGeometry;
 using Rendering::CylinderGeometry;
 
+namespace {
+// The end points of the cylinders drawn for a bond of the given order.
+int bondCylinders(const Vector3f &pos1, const Vector3f &pos2,
+                  unsigned char order, float bondRadius, Vector3f ends[3][2])
+{
+  Vector3f bondVector = pos2 - pos1;
+  float bondLength = bondVector.norm();
+  bondVector /= bondLength;
+  int count = 0;
+  switch (order) {
+  case 3: {
+    Vector3f delta = bondVector.unitOrthogonal() * (2.0f * bondRadius);
+    ends[count][0] = pos1 + delta;
+    ends[count++][1] = pos2 + delta;
+    ends[count][0] = pos1 - delta;
+    ends[count++][1] = pos2 - delta;
+  }
+  default:
+  case 1:
+    ends[count][0] = pos1;
+    ends[count++][1] = pos2;
+    break;
+  case 2: {
+    Vector3f delta = bondVector.unitOrthogonal() * bondRadius;
+    ends[count][0] = pos1 + delta;
+    ends[count++][1] = pos2 + delta;
+    ends[count][0] = pos1 - delta;
+    ends[count++][1] = pos2 - delta;
+  }
+  }
+  return count;
+}
+}
+
 BallAndStick::BallAndStick(QObject *p) : ScenePlugin(p), m_enabled(true),
   m_group(NULL), m_setupWidget(NULL), m_multiBonds(true), m_showHydrogens(true)
 {
@@ -91,29 +126,13 @@ void BallAndStick::process(const Molecule &molecule,
     Vector3f pos2 = bond.atom2().position3d().cast<float>();
     Vector3ub color1(Elements::color(bond.atom1().atomicNumber()));
     Vector3ub color2(Elements::color(bond.atom2().atomicNumber()));
-    Vector3f bondVector = pos2 - pos1;
-    float bondLength = bondVector.norm();
-    bondVector /= bondLength;
-    switch (m_multiBonds ? bond.order() : 1) {
-    case 3: {
-      Vector3f delta = bondVector.unitOrthogonal() * (2.0f * bondRadius);
-      cylinders->addCylinder(pos1 + delta, pos2 + delta, bondRadius,
-                             color1, color2, i);
-      cylinders->addCylinder(pos1 - delta, pos2 - delta, bondRadius,
-                             color1, color2, i);
-    }
-    default:
-    case 1:
-      cylinders->addCylinder(pos1, pos2, bondRadius, color1, color2, i);
-      break;
-    case 2: {
-      Vector3f delta = bondVector.unitOrthogonal() * bondRadius;
-      cylinders->addCylinder(pos1 + delta, pos2 + delta, bondRadius,
-                             color1, color2, i);
-      cylinders->addCylinder(pos1 - delta, pos2 - delta, bondRadius,
+    Vector3f ends[3][2];
+    int count = bondCylinders(pos1, pos2, m_multiBonds ? bond.order() : 1,
+                              bondRadius, ends);
+    for (int j = 0; j < count; ++j) {
+      cylinders->addCylinder(ends[j][0], ends[j][1], bondRadius,
                              color1, color2, i);
     }
-    }
   }
 }
 
@@ -156,30 +175,81 @@ void BallAndStick::processEditable(const QtGui::RWMolecule &molecule,
     Vector3f pos2 = bond.atom2().position3d().cast<float>();
     Vector3ub color1(Elements::color(bond.atom1().atomicNumber()));
     Vector3ub color2(Elements::color(bond.atom2().atomicNumber()));
-    Vector3f bondVector = pos2 - pos1;
-    float bondLength = bondVector.norm();
-    bondVector /= bondLength;
-    switch (m_multiBonds ? bond.order() : 1) {
-    case 3: {
-      Vector3f delta = bondVector.unitOrthogonal() * (2.0f * bondRadius);
-      cylinders->addCylinder(pos1 + delta, pos2 + delta, bondRadius,
-                             color1, color2, i);
-      cylinders->addCylinder(pos1 - delta, pos2 - delta, bondRadius,
+    Vector3f ends[3][2];
+    int count = bondCylinders(pos1, pos2, m_multiBonds ? bond.order() : 1,
+                              bondRadius, ends);
+    for (int j = 0; j < count; ++j) {
+      cylinders->addCylinder(ends[j][0], ends[j][1], bondRadius,
                              color1, color2, i);
     }
-    default:
-    case 1:
-      cylinders->addCylinder(pos1, pos2, bondRadius, color1, color2, i);
-      break;
-    case 2: {
-      Vector3f delta = bondVector.unitOrthogonal() * bondRadius;
-      cylinders->addCylinder(pos1 + delta, pos2 + delta, bondRadius,
-                             color1, color2, i);
-      cylinders->addCylinder(pos1 - delta, pos2 - delta, bondRadius,
-                             color1, color2, i);
+  }
+}
+
+bool BallAndStick::processChanges(const Molecule &molecule,
+                                  Rendering::GroupNode &node,
+                                  unsigned int changes)
+{
+  // The spheres and cylinders added by process() are updated in place, as long
+  // as the same number of them are drawn.
+  GeometryNode *geometry = node.childCount() == 1
+      ? dynamic_cast<GeometryNode *>(node.child(0)) : NULL;
+  if (!geometry || geometry->drawables().size() != 2)
+    return false;
+  SphereGeometry *spheres =
+      dynamic_cast<SphereGeometry *>(geometry->drawable(0));
+  CylinderGeometry *cylinders =
+      dynamic_cast<CylinderGeometry *>(geometry->drawable(1));
+  if (!spheres || !cylinders)
+    return false;
+
+  // The spheres only depend on the atoms, the cylinders on the bonds too.
+  const bool atomsChanged = (changes & QtGui::Molecule::Atoms) != 0;
+  const bool bondsChanged = (changes & QtGui::Molecule::Bonds) != 0;
+  if (!atomsChanged && !bondsChanged)
+    return true;
+
+  if (atomsChanged) {
+    size_t sphere = 0;
+    for (Index i = 0; i < molecule.atomCount(); ++i) {
+      Core::Atom atom = molecule.atom(i);
+      unsigned char atomicNumber = atom.atomicNumber();
+      if (atomicNumber == 1 && !m_showHydrogens)
+        continue;
+      if (sphere == spheres->size())
+        return false;
+      const unsigned char *c = Elements::color(atomicNumber);
+      Vector3ub color(c[0], c[1], c[2]);
+      spheres->setSphere(sphere++, atom.position3d().cast<float>(), color,
+                         static_cast<float>(Elements::radiusVDW(atomicNumber))
+                         * 0.3f);
     }
+    if (sphere != spheres->size())
+      return false;
+  }
+
+  float bondRadius = 0.1f;
+  size_t cylinder = 0;
+  for (Index i = 0; i < molecule.bondCount(); ++i) {
+    Core::Bond bond = molecule.bond(i);
+    if (!m_showHydrogens
+        && (bond.atom1().atomicNumber() == 1 || bond.atom2().atomicNumber() == 1)) {
+      continue;
+    }
+    Vector3f pos1 = bond.atom1().position3d().cast<float>();
+    Vector3f pos2 = bond.atom2().position3d().cast<float>();
+    Vector3ub color1(Elements::color(bond.atom1().atomicNumber()));
+    Vector3ub color2(Elements::color(bond.atom2().atomicNumber()));
+    Vector3f ends[3][2];
+    int count = bondCylinders(pos1, pos2, m_multiBonds ? bond.order() : 1,
+                              bondRadius, ends);
+    if (cylinder + count > cylinders->size())
+      return false;
+    for (int j = 0; j < count; ++j) {
+      cylinders->setCylinder(cylinder++, ends[j][0], ends[j][1], bondRadius,
+                             color1, color2, i);
     }
   }
+  return cylinder == cylinders->size();
 }
 
 bool BallAndStick::isEnabled() const
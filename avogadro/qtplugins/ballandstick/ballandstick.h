@@ -40,6 +40,10 @@ public:
   void processEditable(const QtGui::RWMolecule &molecule,
                        Rendering::GroupNode &node) AVO_OVERRIDE;
 
+  bool processChanges(const Core::Molecule &molecule,
+                      Rendering::GroupNode &node,
+                      unsigned int changes) AVO_OVERRIDE;
+
   QString name() const AVO_OVERRIDE { return tr("Ball and Stick"); }
 
   QString description() const AVO_OVERRIDE
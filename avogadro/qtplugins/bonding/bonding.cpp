@@ -17,6 +17,7 @@
 #include "bonding.h"
 
 #include <avogadro/core/elements.h>
+#include <avogadro/core/neighborperceiver.h>
 #include <avogadro/qtgui/molecule.h>
 
 #include <QtWidgets/QAction>
@@ -26,6 +27,7 @@
 #include <QtGui/QKeySequence>
 #include <QtWidgets/QMessageBox>
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -33,6 +35,7 @@ namespace Avogadro {
 namespace QtPlugins {
 
 using Core::Elements;
+using Core::NeighborPerceiver;
 
 Bonding::Bonding(QObject *parent_) :
   Avogadro::QtGui::ExtensionPlugin(parent_),
@@ -87,18 +90,31 @@ void Bonding::bond2()
 
   // cache atomic radii
   std::vector<double> radii(m_molecule->atomCount());
+  double maxRadius = 0.0;
   for (size_t i = 0; i < radii.size(); i++) {
     radii[i] = Elements::radiusCovalent(m_molecule->atomicNumbers()[i]);
     if (radii[i] <= 0.0)
       radii[i] = 0.0;
+    maxRadius = std::max(maxRadius, radii[i]);
   }
 
+  // Only atoms in neighboring cells of the grid can be close enough to bond.
+  const Core::Array<Vector3> &positions = m_molecule->atomPositions3d();
+  NeighborPerceiver perceiver(positions, 2.0 * maxRadius + tolerance);
+  std::vector<Index> neighbors;
+
   // Main bond perception loop based on a simple distance metric.
   for (Index i = 0; i < m_molecule->atomCount(); ++i) {
-    Vector3 ipos = m_molecule->atomPositions3d()[i];
-    for (Index j = i + 1; j < m_molecule->atomCount(); ++j) {
+    Vector3 ipos = positions[i];
+    neighbors.clear();
+    perceiver.neighbors(ipos, neighbors);
+    std::sort(neighbors.begin(), neighbors.end());
+    std::vector<Index>::const_iterator it =
+        std::upper_bound(neighbors.begin(), neighbors.end(), i);
+    for (; it != neighbors.end(); ++it) {
+      Index j = *it;
       double cutoff = radii[i] + radii[j] + tolerance;
-      Vector3 jpos = m_molecule->atomPositions3d()[j];
+      Vector3 jpos = positions[j];
       Vector3 diff = jpos - ipos;
 
       if (std::fabs(diff[0]) > cutoff
@@ -22,6 +22,7 @@
 #include <avogadro/rendering/groupnode.h>
 #include <avogadro/rendering/spheregeometry.h>
 #include <avogadro/rendering/cylindergeometry.h>
+#include <avogadro/qtgui/molecule.h>
 
 namespace Avogadro {
 namespace QtPlugins {
@@ -78,6 +79,51 @@ void Licorice::process(const Molecule &molecule,
   }
 }
 
+bool Licorice::processChanges(const Molecule &molecule,
+                              Rendering::GroupNode &node,
+                              unsigned int changes)
+{
+  // There is a sphere for each atom and a cylinder for each bond, so they can
+  // be updated in place while the counts stay the same.
+  GeometryNode *geometry = node.childCount() == 1
+      ? dynamic_cast<GeometryNode *>(node.child(0)) : NULL;
+  if (!geometry || geometry->drawables().size() != 2)
+    return false;
+  SphereGeometry *spheres =
+      dynamic_cast<SphereGeometry *>(geometry->drawable(0));
+  CylinderGeometry *cylinders =
+      dynamic_cast<CylinderGeometry *>(geometry->drawable(1));
+  if (!spheres || !cylinders || spheres->size() != molecule.atomCount()
+      || cylinders->size() != molecule.bondCount()) {
+    return false;
+  }
+
+  // The spheres only depend on the atoms, the cylinders on the bonds too.
+  const bool atomsChanged = (changes & QtGui::Molecule::Atoms) != 0;
+  const bool bondsChanged = (changes & QtGui::Molecule::Bonds) != 0;
+  if (!atomsChanged && !bondsChanged)
+    return true;
+
+  float radius(0.2f);
+  if (atomsChanged) {
+    for (Index i = 0; i < molecule.atomCount(); ++i) {
+      Core::Atom atom = molecule.atom(i);
+      Vector3ub color(Elements::color(atom.atomicNumber()));
+      spheres->setSphere(i, atom.position3d().cast<float>(), color, radius);
+    }
+  }
+
+  for (Index i = 0; i < molecule.bondCount(); ++i) {
+    Core::Bond bond = molecule.bond(i);
+    Vector3f pos1 = bond.atom1().position3d().cast<float>();
+    Vector3f pos2 = bond.atom2().position3d().cast<float>();
+    Vector3ub color1(Elements::color(bond.atom1().atomicNumber()));
+    Vector3ub color2(Elements::color(bond.atom2().atomicNumber()));
+    cylinders->setCylinder(i, pos1, pos2, radius, color1, color2, i);
+  }
+  return true;
+}
+
 bool Licorice::isEnabled() const
 {
   return m_enabled;
@@ -37,6 +37,10 @@ public:
   void process(const Core::Molecule &molecule,
                Rendering::GroupNode &node) AVO_OVERRIDE;
 
+  bool processChanges(const Core::Molecule &molecule,
+                      Rendering::GroupNode &node,
+                      unsigned int changes) AVO_OVERRIDE;
+
   QString name() const { return tr("Licorice"); }
 
   QString description() const { return tr("Render atoms as licorice."); }
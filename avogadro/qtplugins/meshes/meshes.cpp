@@ -52,6 +52,17 @@ struct Sequence {
   void reset() { i = 0; }
   unsigned int i;
 };
+
+// Meshes without an index array are made up of explicit triangles.
+Core::Array<unsigned int> triangleIndices(const Mesh &mesh)
+{
+  if (mesh.numIndices() > 0)
+    return mesh.indices();
+  Sequence indexGenerator;
+  Core::Array<unsigned int> indices(mesh.numVertices());
+  std::generate(indices.begin(), indices.end(), indexGenerator);
+  return indices;
+}
 }
 
 void Meshes::process(const Molecule &mol, GroupNode &node)
@@ -66,19 +77,12 @@ void Meshes::process(const Molecule &mol, GroupNode &node)
     const Mesh *mesh = mol.mesh(0);
     qDebug() << mesh << "with" << mesh->numVertices() << "vertices";
 
-    /// @todo Allow use of MeshGeometry without an index array when all vertices
-    /// form explicit triangles.
-    // Create index array:
-    Sequence indexGenerator;
-    Core::Array<unsigned int> indices(mesh->numVertices());
-    std::generate(indices.begin(), indices.end(), indexGenerator);
-
     MeshGeometry *mesh1 = new MeshGeometry;
     geometry->addDrawable(mesh1);
     mesh1->setColor(Vector3ub(255, 0, 0));
     mesh1->setOpacity(opacity);
     mesh1->addVertices(mesh->vertices(), mesh->normals());
-    mesh1->addTriangles(indices);
+    mesh1->addTriangles(triangleIndices(*mesh));
     mesh1->setRenderPass(opacity == 255 ? Rendering::OpaquePass
                                         : Rendering::TranslucentPass);
 
@@ -86,18 +90,10 @@ void Meshes::process(const Molecule &mol, GroupNode &node)
       MeshGeometry *mesh2 = new MeshGeometry;
       geometry->addDrawable(mesh2);
       mesh = mol.mesh(1);
-      if (mesh->numVertices() < indices.size()) {
-        indices.resize(mesh->numVertices());
-      }
-      else if (mesh->numVertices() > indices.size()) {
-        indexGenerator.reset();
-        indices.resize(mesh->numVertices());
-        std::generate(indices.begin(), indices.end(), indexGenerator);
-      }
       mesh2->setColor(Vector3ub(0, 0, 255));
       mesh2->setOpacity(opacity);
       mesh2->addVertices(mesh->vertices(), mesh->normals());
-      mesh2->addTriangles(indices);
+      mesh2->addTriangles(triangleIndices(*mesh));
       mesh2->setRenderPass(opacity == 255 ? Rendering::OpaquePass
                                           : Rendering::TranslucentPass);
     }
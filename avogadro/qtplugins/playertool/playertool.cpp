@@ -170,17 +170,25 @@ void PlayerTool::animate(int advance)
     if (m_currentFrame < m_molecule->coordinate3dCount() - advance
         && m_currentFrame + advance >= 0) {
       m_currentFrame += advance;
-      m_molecule->setCoordinate3d(m_currentFrame);
     }
     else {
       m_currentFrame = advance > 0 ? 0 : m_molecule->coordinate3dCount() - 1;
-      m_molecule->setCoordinate3d(m_currentFrame);
     }
+    // Frames of long trajectories are read from file as they are requested.
+    if (!m_molecule->setCoordinate3d(m_currentFrame)) {
+      m_timer.stop();
+      m_info->setText(tr("Error reading frame %0").arg(m_currentFrame + 1));
+      return;
+    }
+    // Only the positions change between frames unless the bonds are perceived
+    // again, so the scene can be updated in place.
+    unsigned int changes = Molecule::Atoms | Molecule::Modified;
     if (m_dynamicBonding->isChecked()) {
       m_molecule->clearBonds();
       m_molecule->perceiveBondsSimple();
+      changes |= Molecule::Bonds | Molecule::Added | Molecule::Removed;
     }
-    m_molecule->emitChanged(Molecule::Atoms | Molecule::Added);
+    m_molecule->emitChanged(changes);
     m_info->setText(tr("Frame %0 of %1").arg(m_currentFrame + 1)
                     .arg(m_molecule->coordinate3dCount()));
   }
@@ -212,11 +220,13 @@ void PlayerTool::recordMovie()
   m_glWidget->resize(800, 600);
   for (int i = 0; i < m_molecule->coordinate3dCount(); ++i) {
     m_molecule->setCoordinate3d(i);
+    unsigned int changes = Molecule::Atoms | Molecule::Modified;
     if (bonding) {
       m_molecule->clearBonds();
       m_molecule->perceiveBondsSimple();
+      changes |= Molecule::Bonds | Molecule::Added | Molecule::Removed;
     }
-    m_molecule->emitChanged(Molecule::Atoms | Molecule::Modified);
+    m_molecule->emitChanged(changes);
     QString fileName = QString::number(i);
     while (fileName.length() < numberLength)
       fileName.prepend('0');
@@ -26,13 +26,6 @@
 
 #include <QtConcurrentMap>
 
-#include <QTemporaryFile>
-#include <QFile>
-#include <QDataStream>
-#include <QDir>
-
-#include <QVariant>
-
 #include <QProgressDialog>
 #include <QFutureWatcher>
 #include <QFuture>
@@ -46,18 +39,42 @@ using namespace Eigen;
 namespace Avogadro {
 namespace QtPlugins {
 
-  QList<QVariant> QTAIMLocateNuclearCriticalPoint( QList<QVariant> input  )
+  // The input of one critical point search. The wavefunction and the beta
+  // spheres are shared by all of the concurrent searches and only ever read.
+  struct QTAIMCriticalPointSearch
   {
-    const QString fileName=input.at(0).toString();
-    const qint64 nucleus=input.at(1).toInt();
-    const QVector3D x0y0z0(
-        input.at(2).toReal(),
-        input.at(3).toReal(),
-        input.at(4).toReal()
-        );
+    const QTAIMWavefunction *wfn;
+    const QList<QPair<QVector3D,qreal> > *betaSpheres;
+    qint64 nucleusA;
+    qint64 nucleusB;
+    qreal x0;
+    qreal y0;
+    qreal z0;
+  };
+
+  // The outcome of one critical point search. The nuclei, properties and path
+  // are only set for bond critical points.
+  struct QTAIMCriticalPointResult
+  {
+    QTAIMCriticalPointResult() : success(false), nucleusA(-1), nucleusB(-1),
+      laplacian(0.0), ellipticity(0.0)
+    {
+    }
+
+    bool success;
+    QVector3D position;
+    qint64 nucleusA;
+    qint64 nucleusB;
+    qreal laplacian;
+    qreal ellipticity;
+    QList<QVector3D> bondPath;
+  };
 
-    QTAIMWavefunction wfn;
-    wfn.loadFromBinaryFile(fileName);
+  QTAIMCriticalPointResult QTAIMLocateNuclearCriticalPoint( const QTAIMCriticalPointSearch &search )
+  {
+    const QTAIMWavefunction &wfn=*search.wfn;
+    const qint64 nucleus=search.nucleusA;
+    const QVector3D x0y0z0(search.x0,search.y0,search.z0);
 
     QTAIMWavefunctionEvaluator eval(wfn);
 
@@ -90,63 +107,30 @@ namespace QtPlugins {
       correctSignature=false;
     }
 
-    QList<QVariant> value;
-
+    QTAIMCriticalPointResult value;
+    value.success=correctSignature;
     if( correctSignature )
     {
-      value.append(correctSignature);
-      value.append(result.x());
-      value.append(result.y());
-      value.append(result.z());
-    }
-    else
-    {
-      value.append(false);
+      value.position=result;
     }
 
     return value;
 
   }
 
-  QList<QVariant> QTAIMLocateBondCriticalPoint( QList<QVariant> input  )
+  QTAIMCriticalPointResult QTAIMLocateBondCriticalPoint( const QTAIMCriticalPointSearch &search )
   {
 
-    QList<QVariant> value;
-    value.clear();
-
-    const QString wfnFileName=input.at(0).toString();
-    const QString nuclearCriticalPointsFileName=input.at(1).toString();
-    const qint64 nucleusA=input.at(2).toInt();
-    const qint64 nucleusB=input.at(3).toInt();
-    const QVector3D x0y0z0(
-        input.at(4).toReal(),
-        input.at(5).toReal(),
-        input.at(6).toReal()
-        );
+    QTAIMCriticalPointResult value;
 
-    QTAIMWavefunction wfn;
-    wfn.loadFromBinaryFile(wfnFileName);
-
-    QList<QVector3D> nuclearCriticalPoints;
-    QFile nuclearCriticalPointsFile(nuclearCriticalPointsFileName);
-    nuclearCriticalPointsFile.open(QIODevice::ReadOnly);
-    QDataStream nuclearCriticalPointsFileIn(&nuclearCriticalPointsFile);
-    nuclearCriticalPointsFileIn >> nuclearCriticalPoints ;
-    nuclearCriticalPointsFile.close();
-
-    QList<QPair<QVector3D,qreal> > betaSpheres;
-    for( qint64 i=0 ; i < nuclearCriticalPoints.length() ; ++i )
-    {
-      QPair<QVector3D,qreal> thisBetaSphere;
-      thisBetaSphere.first=nuclearCriticalPoints.at(i);
-      thisBetaSphere.second=0.1;
-      betaSpheres.append(thisBetaSphere);
-    }
+    const QTAIMWavefunction &wfn=*search.wfn;
+    const QList<QPair<QVector3D,qreal> > &betaSpheres=*search.betaSpheres;
+    const qint64 nucleusA=search.nucleusA;
+    const qint64 nucleusB=search.nucleusB;
+    const QVector3D x0y0z0(search.x0,search.y0,search.z0);
 
     QTAIMWavefunctionEvaluator eval(wfn);
 
-    QList<QVector3D> ncpList;
-
     QVector3D result;
     //    QTAIMODEIntegrator ode(eval,QTAIMODEIntegrator::CMBPMinusOneGradientInElectronDensity);
     QTAIMLSODAIntegrator ode(eval,QTAIMLSODAIntegrator::CMBPMinusOneGradientInElectronDensity);
@@ -160,10 +144,8 @@ namespace QtPlugins {
         || (eval.gradientOfElectronDensity(xyz)).norm() > SMALL_GRADIENT_NORM
         )
     {
-      value.append(false);
-      value.append(result.x());
-      value.append(result.y());
-      value.append(result.z());
+      value.success=false;
+      value.position=result;
       return value;
     }
 
@@ -248,82 +230,47 @@ namespace QtPlugins {
 
     if( bondPathConnectsPair )
     {
-      value.append(true);
-      value.append(nucleusA);
-      value.append(nucleusB);
-      value.append(result.x());
-      value.append(result.y());
-      value.append(result.z());
+      value.success=true;
+      value.nucleusA=nucleusA;
+      value.nucleusB=nucleusB;
+      value.position=result;
       Matrix<qreal,3,1> xyz_ ; xyz_ << result.x(),result.y(),result.z();
-      value.append( eval.laplacianOfElectronDensity(xyz_) );
-      value.append( QTAIMMathUtilities::ellipticityOfASymmetricThreeByThreeMatrix(
+      value.laplacian=eval.laplacianOfElectronDensity(xyz_);
+      value.ellipticity=QTAIMMathUtilities::ellipticityOfASymmetricThreeByThreeMatrix(
           eval.hessianOfElectronDensity(xyz_)
-          )
-                    );
-      value.append( 1 + forwardPath.length() + 1 + backwardPath.length() + 1);
-      value.append( forwardEndpoint.x() );
-      for(qint64 i=forwardPath.length() - 1 ; i >= 0 ; --i)
-      {
-        value.append( forwardPath.at(i).x() );
-      }
-      value.append(result.x());
-      for(qint64 i=0; i < backwardPath.length() ; ++i)
-      {
-        value.append( backwardPath.at(i).x() );
-      }
-      value.append( backwardEndpoint.x() );
-      value.append( forwardEndpoint.y() );
+          );
+      value.bondPath.append( forwardEndpoint );
       for(qint64 i=forwardPath.length() - 1 ; i >= 0 ; --i)
       {
-        value.append( forwardPath.at(i).y() );
+        value.bondPath.append( forwardPath.at(i) );
       }
-      value.append(result.y());
+      value.bondPath.append( result );
       for(qint64 i=0; i < backwardPath.length() ; ++i)
       {
-        value.append( backwardPath.at(i).y() );
+        value.bondPath.append( backwardPath.at(i) );
       }
-      value.append( backwardEndpoint.y() );
-      value.append( forwardEndpoint.z() );
-      for(qint64 i=forwardPath.length() - 1 ; i >= 0 ; --i)
-      {
-        value.append( forwardPath.at(i).z() );
-      }
-      value.append(result.z());
-      for(qint64 i=0; i < backwardPath.length() ; ++i)
-      {
-        value.append( backwardPath.at(i).z() );
-      }
-      value.append( backwardEndpoint.z() );
-
+      value.bondPath.append( backwardEndpoint );
     }
     else
     {
-      value.append(false);
+      value.success=false;
       // for debugging
-      value.append(result.x());
-      value.append(result.y());
-      value.append(result.z());
+      value.position=result;
     }
 
     return value;
   }
 
 
-  QList<QVariant> QTAIMLocateElectronDensitySink( QList<QVariant> input  )
+  QTAIMCriticalPointResult QTAIMLocateElectronDensitySink( const QTAIMCriticalPointSearch &search )
   {
-    qint64 counter=0;
-    const QString fileName=input.at(counter).toString(); counter++;
-    //    const qint64 nucleus=input.at(counter).toInt(); counter++
-    qreal x0=input.at(counter).toReal(); counter++;
-    qreal y0=input.at(counter).toReal(); counter++;
-    qreal z0=input.at(counter).toReal(); counter++;
+    qreal x0=search.x0;
+    qreal y0=search.y0;
+    qreal z0=search.z0;
 
     const QVector3D x0y0z0(x0,y0,z0);
 
-    QTAIMWavefunction wfn;
-    wfn.loadFromBinaryFile(fileName);
-
-    QTAIMWavefunctionEvaluator eval(wfn);
+    QTAIMWavefunctionEvaluator eval(*search.wfn);
 
     bool correctSignature;
     QVector3D result;
@@ -363,38 +310,26 @@ namespace QtPlugins {
       }
     }
 
-    QList<QVariant> value;
+    QTAIMCriticalPointResult value;
+    value.success=correctSignature;
     if( correctSignature )
     {
-      value.append(correctSignature);
-      value.append(result.x());
-      value.append(result.y());
-      value.append(result.z());
-    }
-    else
-    {
-      value.append(false);
+      value.position=result;
     }
 
     return value;
 
   }
 
-  QList<QVariant> QTAIMLocateElectronDensitySource( QList<QVariant> input  )
+  QTAIMCriticalPointResult QTAIMLocateElectronDensitySource( const QTAIMCriticalPointSearch &search )
   {
-    qint64 counter=0;
-    const QString fileName=input.at(counter).toString(); counter++;
-    //    const qint64 nucleus=input.at(counter).toInt(); counter++
-    qreal x0=input.at(counter).toReal(); counter++;
-    qreal y0=input.at(counter).toReal(); counter++;
-    qreal z0=input.at(counter).toReal(); counter++;
+    qreal x0=search.x0;
+    qreal y0=search.y0;
+    qreal z0=search.z0;
 
     const QVector3D x0y0z0(x0,y0,z0);
 
-    QTAIMWavefunction wfn;
-    wfn.loadFromBinaryFile(fileName);
-
-    QTAIMWavefunctionEvaluator eval(wfn);
+    QTAIMWavefunctionEvaluator eval(*search.wfn);
 
     bool correctSignature;
     QVector3D result;
@@ -434,17 +369,11 @@ namespace QtPlugins {
       }
     }
 
-    QList<QVariant> value;
+    QTAIMCriticalPointResult value;
+    value.success=correctSignature;
     if( correctSignature )
     {
-      value.append(correctSignature);
-      value.append(result.x());
-      value.append(result.y());
-      value.append(result.z());
-    }
-    else
-    {
-      value.append(false);
+      value.position=result;
     }
 
     return value;
@@ -474,26 +403,24 @@ namespace QtPlugins {
   void QTAIMCriticalPointLocator::locateNuclearCriticalPoints()
   {
 
-    QString tempFileName=QTAIMCriticalPointLocator::temporaryFileName();
-
-    QList<QList<QVariant> > inputList;
+    QList<QTAIMCriticalPointSearch> inputList;
 
     const qint64 numberOfNuclei = m_wfn->numberOfNuclei();
 
     for( qint64 n=0 ; n < numberOfNuclei ; ++n)
     {
-      QList<QVariant> input;
-      input.append( tempFileName );
-      input.append( n );
-      input.append( m_wfn->xNuclearCoordinate(n) );
-      input.append( m_wfn->yNuclearCoordinate(n) );
-      input.append( m_wfn->zNuclearCoordinate(n) );
+      QTAIMCriticalPointSearch input;
+      input.wfn=m_wfn;
+      input.betaSpheres=NULL;
+      input.nucleusA=n;
+      input.nucleusB=-1;
+      input.x0=m_wfn->xNuclearCoordinate(n);
+      input.y0=m_wfn->yNuclearCoordinate(n);
+      input.z0=m_wfn->zNuclearCoordinate(n);
 
       inputList.append(input);
     }
 
-    m_wfn->saveToBinaryFile(tempFileName);
-
     QProgressDialog dialog;
     dialog.setWindowTitle("QTAIM");
     dialog.setLabelText(QString("Nuclear Critical Points Search"));
@@ -504,12 +431,12 @@ namespace QtPlugins {
     QObject::connect(&futureWatcher, SIGNAL(progressRangeChanged(int,int)), &dialog, SLOT(setRange(int,int)));
     QObject::connect(&futureWatcher, SIGNAL(progressValueChanged(int)), &dialog, SLOT(setValue(int)));
 
-    QFuture<QList<QVariant> > future=QtConcurrent::mapped(inputList, QTAIMLocateNuclearCriticalPoint);
+    QFuture<QTAIMCriticalPointResult> future=QtConcurrent::mapped(inputList, QTAIMLocateNuclearCriticalPoint);
     futureWatcher.setFuture(future);
     dialog.exec();
     futureWatcher.waitForFinished();
 
-    QList<QList<QVariant> > results;
+    QList<QTAIMCriticalPointResult> results;
     if( futureWatcher.future().isCanceled() )
     {
       results.clear();
@@ -519,24 +446,14 @@ namespace QtPlugins {
       results=future.results();
     }
 
-    QFile file;
-    file.remove(tempFileName);
-
     for( qint64 n=0 ; n < results.length() ; ++n )
     {
 
-      bool correctSignature = results.at(n).at(0).toBool();
+      bool correctSignature = results.at(n).success;
 
       if (correctSignature)
       {
-
-        QVector3D result(
-          results.at(n).at(1).toReal(),
-          results.at(n).at(2).toReal(),
-          results.at(n).at(3).toReal()
-        );
-
-        m_nuclearCriticalPoints.append( result );
+        m_nuclearCriticalPoints.append( results.at(n).position );
       }
 
     }
@@ -558,16 +475,17 @@ namespace QtPlugins {
       return;
     }
 
-    QString tempFileName=QTAIMCriticalPointLocator::temporaryFileName();
-
-    QString nuclearCriticalPointsFileName=QTAIMCriticalPointLocator::temporaryFileName();
-    QFile nuclearCriticalPointsFile(nuclearCriticalPointsFileName);
-    nuclearCriticalPointsFile.open(QIODevice::WriteOnly);
-    QDataStream nuclearCriticalPointsOut(&nuclearCriticalPointsFile);
-    nuclearCriticalPointsOut << m_nuclearCriticalPoints;
-    nuclearCriticalPointsFile.close();
+    // The beta spheres are shared by all of the searches.
+    QList<QPair<QVector3D,qreal> > betaSpheres;
+    for( qint64 i=0 ; i < m_nuclearCriticalPoints.length() ; ++i )
+    {
+      QPair<QVector3D,qreal> thisBetaSphere;
+      thisBetaSphere.first=m_nuclearCriticalPoints.at(i);
+      thisBetaSphere.second=0.1;
+      betaSpheres.append(thisBetaSphere);
+    }
 
-    QList<QList<QVariant> > inputList;
+    QList<QTAIMCriticalPointSearch> inputList;
 
     for( qint64 M=0 ; M < numberOfNuclei - 1 ; ++M )
     {
@@ -588,22 +506,20 @@ namespace QtPlugins {
                             ( m_wfn->yNuclearCoordinate(M) + m_wfn->yNuclearCoordinate(N) ) / 2.0,
                             ( m_wfn->zNuclearCoordinate(M) + m_wfn->zNuclearCoordinate(N) ) / 2.0 );
 
-          QList<QVariant> input;
-          input.append( tempFileName );
-          input.append( nuclearCriticalPointsFileName );
-          input.append( M );
-          input.append( N );
-          input.append( x0y0z0.x() );
-          input.append( x0y0z0.y() );
-          input.append( x0y0z0.z() );
+          QTAIMCriticalPointSearch input;
+          input.wfn=m_wfn;
+          input.betaSpheres=&betaSpheres;
+          input.nucleusA=M;
+          input.nucleusB=N;
+          input.x0=x0y0z0.x();
+          input.y0=x0y0z0.y();
+          input.z0=x0y0z0.z();
 
           inputList.append(input);
         }
       } // end N
     } // end M
 
-    m_wfn->saveToBinaryFile(tempFileName);
-
     QProgressDialog dialog;
     dialog.setWindowTitle("QTAIM");
     dialog.setLabelText(QString("Bond Critical Points Search"));
@@ -614,12 +530,12 @@ namespace QtPlugins {
     QObject::connect(&futureWatcher, SIGNAL(progressRangeChanged(int,int)), &dialog, SLOT(setRange(int,int)));
     QObject::connect(&futureWatcher, SIGNAL(progressValueChanged(int)), &dialog, SLOT(setValue(int)));
 
-    QFuture<QList<QVariant> > future=QtConcurrent::mapped(inputList, QTAIMLocateBondCriticalPoint);;
+    QFuture<QTAIMCriticalPointResult> future=QtConcurrent::mapped(inputList, QTAIMLocateBondCriticalPoint);
     futureWatcher.setFuture(future);
     dialog.exec();
     futureWatcher.waitForFinished();
 
-    QList<QList<QVariant> > results;
+    QList<QTAIMCriticalPointResult> results;
     if( futureWatcher.future().isCanceled() )
     {
       results.clear();
@@ -629,44 +545,23 @@ namespace QtPlugins {
       results=future.results();
     }
 
-    QFile file;
-    file.remove(tempFileName);
-    file.remove(nuclearCriticalPointsFileName);
-
     for( qint64 i=0 ; i < results.length() ; ++i )
     {
-      QList<QVariant> thisCriticalPoint=results.at(i);
-
-      bool success=thisCriticalPoint.at(0).toBool();
+      const QTAIMCriticalPointResult &thisCriticalPoint=results.at(i);
 
-      if(success)
+      if(thisCriticalPoint.success)
       {
         QPair<qint64,qint64> bondedAtoms_;
-        bondedAtoms_.first=thisCriticalPoint.at(1).toInt();
-        bondedAtoms_.second=thisCriticalPoint.at(2).toInt();
+        bondedAtoms_.first=thisCriticalPoint.nucleusA;
+        bondedAtoms_.second=thisCriticalPoint.nucleusB;
         m_bondedAtoms.append( bondedAtoms_ );
 
-        QVector3D coordinates(thisCriticalPoint.at(3).toReal(),
-                              thisCriticalPoint.at(4).toReal(),
-                              thisCriticalPoint.at(5).toReal());
-
-        m_bondCriticalPoints.append( coordinates );
-
-        m_laplacianAtBondCriticalPoints.append(thisCriticalPoint.at(6).toReal());
-        m_ellipticityAtBondCriticalPoints.append(thisCriticalPoint.at(7).toReal());
-        qint64 pathLength=thisCriticalPoint.at(8).toInt();
+        m_bondCriticalPoints.append( thisCriticalPoint.position );
 
-        QList<QVector3D> bondPath;
-        for( qint64 j=0 ; j < pathLength ; ++j )
-        {
-          QVector3D pathPoint(thisCriticalPoint.at(9 + j                ).toReal(),
-                              thisCriticalPoint.at(9 + j +   pathLength ).toReal(),
-                              thisCriticalPoint.at(9 + j + 2*pathLength ).toReal());
-
-          bondPath.append(pathPoint);
-        }
+        m_laplacianAtBondCriticalPoints.append(thisCriticalPoint.laplacian);
+        m_ellipticityAtBondCriticalPoints.append(thisCriticalPoint.ellipticity);
 
-        m_bondPaths.append(bondPath);
+        m_bondPaths.append(thisCriticalPoint.bondPath);
       }
 
     }
@@ -676,9 +571,7 @@ namespace QtPlugins {
   void QTAIMCriticalPointLocator::locateElectronDensitySources()
   {
 
-    QString tempFileName=QTAIMCriticalPointLocator::temporaryFileName();
-
-    QList<QList<QVariant> > inputList;
+    QList<QTAIMCriticalPointSearch> inputList;
 
     qreal xmin,ymin,zmin;
     qreal xmax,ymax,zmax;
@@ -754,20 +647,20 @@ namespace QtPlugins {
       {
         for( qreal z=zmin ; z < zmax+zstep ; z=z+zstep)
         {
-          QList<QVariant> input;
-          input.append( tempFileName );
-//          input.append( n );
-          input.append( x );
-          input.append( y );
-          input.append( z );
+          QTAIMCriticalPointSearch input;
+          input.wfn=m_wfn;
+          input.betaSpheres=NULL;
+          input.nucleusA=-1;
+          input.nucleusB=-1;
+          input.x0=x;
+          input.y0=y;
+          input.z0=z;
 
           inputList.append(input);
         }
       }
     }
 
-    m_wfn->saveToBinaryFile(tempFileName);
-
     QProgressDialog dialog;
     dialog.setWindowTitle("QTAIM");
     dialog.setLabelText(QString("Electron Density Sources Search"));
@@ -778,12 +671,12 @@ namespace QtPlugins {
     QObject::connect(&futureWatcher, SIGNAL(progressRangeChanged(int,int)), &dialog, SLOT(setRange(int,int)));
     QObject::connect(&futureWatcher, SIGNAL(progressValueChanged(int)), &dialog, SLOT(setValue(int)));
 
-    QFuture<QList<QVariant> > future=QtConcurrent::mapped(inputList, QTAIMLocateElectronDensitySource );
+    QFuture<QTAIMCriticalPointResult> future=QtConcurrent::mapped(inputList, QTAIMLocateElectronDensitySource );
     futureWatcher.setFuture(future);
     dialog.exec();
     futureWatcher.waitForFinished();
 
-    QList<QList<QVariant> > results;
+    QList<QTAIMCriticalPointResult> results;
     if( futureWatcher.future().isCanceled() )
     {
       results.clear();
@@ -793,20 +686,16 @@ namespace QtPlugins {
       results=future.results();
     }
 
-    QFile file;
-    file.remove(tempFileName);
-
     for( qint64 n=0 ; n < results.length() ; ++n )
     {
 
-      qint64 counter=0;
-      bool correctSignature = results.at(n).at(counter).toBool(); counter++;
+      bool correctSignature = results.at(n).success;
 
       if( correctSignature )
       {
-        qreal x=results.at(n).at(counter).toReal(); counter++;
-        qreal y=results.at(n).at(counter).toReal(); counter++;
-        qreal z=results.at(n).at(counter).toReal(); counter++;
+        qreal x=results.at(n).position.x();
+        qreal y=results.at(n).position.y();
+        qreal z=results.at(n).position.z();
 
         if( (xmin < x && x < xmax) &&
             (ymin < y && y < ymax) &&
@@ -846,9 +735,7 @@ namespace QtPlugins {
   void QTAIMCriticalPointLocator::locateElectronDensitySinks()
   {
 
-    QString tempFileName=QTAIMCriticalPointLocator::temporaryFileName();
-
-    QList<QList<QVariant> > inputList;
+    QList<QTAIMCriticalPointSearch> inputList;
 
     qreal xmin,ymin,zmin;
     qreal xmax,ymax,zmax;
@@ -924,20 +811,20 @@ namespace QtPlugins {
       {
         for( qreal z=zmin ; z < zmax+zstep ; z=z+zstep)
         {
-          QList<QVariant> input;
-          input.append( tempFileName );
-//          input.append( n );
-          input.append( x );
-          input.append( y );
-          input.append( z );
+          QTAIMCriticalPointSearch input;
+          input.wfn=m_wfn;
+          input.betaSpheres=NULL;
+          input.nucleusA=-1;
+          input.nucleusB=-1;
+          input.x0=x;
+          input.y0=y;
+          input.z0=z;
 
           inputList.append(input);
         }
       }
     }
 
-    m_wfn->saveToBinaryFile(tempFileName);
-
     QProgressDialog dialog;
     dialog.setWindowTitle("QTAIM");
     dialog.setLabelText(QString("Electron Density Sinks Search"));
@@ -948,12 +835,12 @@ namespace QtPlugins {
     QObject::connect(&futureWatcher, SIGNAL(progressRangeChanged(int,int)), &dialog, SLOT(setRange(int,int)));
     QObject::connect(&futureWatcher, SIGNAL(progressValueChanged(int)), &dialog, SLOT(setValue(int)));
 
-    QFuture<QList<QVariant> > future=QtConcurrent::mapped(inputList, QTAIMLocateElectronDensitySink );
+    QFuture<QTAIMCriticalPointResult> future=QtConcurrent::mapped(inputList, QTAIMLocateElectronDensitySink );
     futureWatcher.setFuture(future);
     dialog.exec();
     futureWatcher.waitForFinished();
 
-    QList<QList<QVariant> > results;
+    QList<QTAIMCriticalPointResult> results;
     if( futureWatcher.future().isCanceled() )
     {
       results.clear();
@@ -963,20 +850,16 @@ namespace QtPlugins {
       results=future.results();
     }
 
-    QFile file;
-    file.remove(tempFileName);
-
     for( qint64 n=0 ; n < results.length() ; ++n )
     {
 
-      qint64 counter=0;
-      bool correctSignature = results.at(n).at(counter).toBool(); counter++;
+      bool correctSignature = results.at(n).success;
 
       if( correctSignature )
       {
-        qreal x=results.at(n).at(counter).toReal(); counter++;
-        qreal y=results.at(n).at(counter).toReal(); counter++;
-        qreal z=results.at(n).at(counter).toReal(); counter++;
+        qreal x=results.at(n).position.x();
+        qreal y=results.at(n).position.y();
+        qreal z=results.at(n).position.z();
 
         if( (xmin < x && x < xmax) &&
             (ymin < y && y < ymax) &&
@@ -1013,23 +896,5 @@ namespace QtPlugins {
 //    qDebug() << "SINKS" << m_electronDensitySinks;
   }
 
-  QString QTAIMCriticalPointLocator::temporaryFileName()
-  {
-    QTemporaryFile temporaryFile;
-    temporaryFile.open();
-    QString tempFileName=temporaryFile.fileName();
-    temporaryFile.close();
-    temporaryFile.remove();
-
-    // wait for temporary file to be deleted
-    QDir dir;
-    do
-    {
-      // Nothing
-    } while ( dir.exists(tempFileName) );
-
-    return tempFileName;
-  }
-
 } // namespace QtPlugins
 } // namespace Avogadro
@@ -71,8 +71,6 @@ namespace QtPlugins {
     QList<QVector3D> m_electronDensitySources;
     QList<QVector3D> m_electronDensitySinks;
 
-    QString temporaryFileName();
-
   };
 
 } // namespace QtPlugins
@@ -50,23 +50,13 @@
  */
 
 #include <QDebug>
-#include <QTemporaryFile>
-#include <QFile>
-#include <QTextStream>
-#include <QDataStream>
-#include <QDir>
 
 #include <QPair>
-#include <QVariantList>
+#include <QSet>
 #include <QVector3D>
 
 #include <QList>
 #include <QtConcurrentMap>
-#include <QTemporaryFile>
-#include <QFile>
-#include <QDataStream>
-#include <QDir>
-#include <QVariant>
 #include <QProgressDialog>
 #include <QFutureWatcher>
 #include <QFuture>
@@ -1136,94 +1126,133 @@ int adapt_integrate(unsigned int fdim, integrand f, void *fdata,
   return ret;
 }
 
-// TODO: Consider QVariantList. For now, mimic what is known to work.
-QList<QVariant> QTAIMEvaluateProperty(QList<QVariant> variantList)
+// The parameters shared by all of the points of one atomic basin
+// integration. The wavefunction is only read, so all of the worker threads
+// evaluate the same in-memory copy instead of each loading their own.
+struct QTAIMBasinIntegration
 {
-  /*
-     Order of variantList:
-     QString wfnFileName
-     qreal x0
-     qreal y0
-     qreal z0
-     qint64 nncp
-     qint64 xncp1
-     qint64 yncp1
-     qint64 zncp1
-     qint64 xncp2
-     qint64 yncp2
-     qint64 zncp2
-     ...
-     qint64 nmode
-     qint64 mode1
-     qint64 mode2
-     ...
-     qint64 nbasin
-     qint64 basin1
-     qint64 basin2
-     ...
-  */
-  qint64 counter=0;
-  QString wfnFileName=variantList.at(counter).toString(); counter++;
-  qreal x0=variantList.at(counter).toDouble(); counter++;
-  qreal y0=variantList.at(counter).toDouble(); counter++;
-  qreal z0=variantList.at(counter).toDouble(); counter++;
-
-  qint64 nncp=variantList.at(counter).toLongLong(); counter++;
+  const QTAIMWavefunction *wfn;
   QList<QVector3D> ncpList;
-  for( qint64 n=0 ; n < nncp ; ++n )
+  QList<QPair<QVector3D,qreal> > betaSpheres;
+  qint64 mode;
+  QList<qint64> basinList;
+  QSet<qint64> basinSet;
+};
+
+// One point of an atomic basin integration. The coordinates are Cartesian
+// (x, y, z) or spherical polar (r, theta, phi or theta, phi) depending on the
+// integrand.
+struct QTAIMBasinIntegrationPoint
+{
+  const QTAIMBasinIntegration *integration;
+  qreal coordinates[3];
+};
+
+// The parameters of the radial integration along one direction of a basin.
+struct QTAIMRadialIntegration
+{
+  QTAIMWavefunctionEvaluator *eval;
+  Matrix<qreal,3,1> origin;
+  qreal t;
+  qreal p;
+  qint64 mode;
+};
+
+static void setUpBasinIntegration(QTAIMBasinIntegration &integration,
+                                  const QTAIMWavefunction *wfn,
+                                  const QList<QVector3D> &ncpList,
+                                  qint64 mode, qint64 basin)
+{
+  integration.wfn=wfn;
+  integration.ncpList=ncpList;
+  integration.betaSpheres.clear();
+  for( qint64 i=0 ; i < ncpList.length() ; ++i )
   {
-    qreal x=variantList.at(counter).toDouble(); counter++;
-    qreal y=variantList.at(counter).toDouble(); counter++;
-    qreal z=variantList.at(counter).toDouble(); counter++;
+    QPair<QVector3D,qreal> thisBetaSphere;
+    thisBetaSphere.first=QVector3D(ncpList.at(i).x(), ncpList.at(i).y(),ncpList.at(i).z());
+    thisBetaSphere.second=0.10;
+    integration.betaSpheres.append(thisBetaSphere);
+  }
+  integration.mode=mode;
+  integration.basinList.clear();
+  integration.basinList.append(basin);
+  integration.basinSet=integration.basinList.toSet();
+}
+
+// Evaluate the points of a basin integration concurrently, fval must hold a
+// value for each of the points.
+static void evaluateBasinIntegrationPoints(
+    const QTAIMBasinIntegration &integration,
+    unsigned int npts, const double *xyz, unsigned int ndim, double *fval,
+    qreal (*evaluate)(const QTAIMBasinIntegrationPoint &))
+{
+  // prepare input
+
+  QList<QTAIMBasinIntegrationPoint> inputList;
 
-    ncpList.append(QVector3D(x,y,z));
+  for(unsigned int i=0 ; i < npts ; ++i )
+  {
+    QTAIMBasinIntegrationPoint point;
+    point.integration=&integration;
+    for(unsigned int j=0 ; j < 3 ; ++j )
+    {
+      point.coordinates[j] = j < ndim ? xyz[i*ndim+j] : 0.0;
+    }
+    inputList.append(point);
   }
 
-  qint64 nmode=variantList.at(counter).toLongLong(); counter++;
-  QList<qint64> modeList;
-  for( qint64 m=0 ; m < nmode ; ++m )
+  // calculate
+
+  QProgressDialog dialog;
+  dialog.setWindowTitle("QTAIM");
+  dialog.setLabelText(QString("Atomic Basin Integration"));
+
+  QFutureWatcher<void> futureWatcher;
+  QObject::connect(&futureWatcher, SIGNAL(finished()), &dialog, SLOT(reset()));
+  QObject::connect(&dialog, SIGNAL(canceled()), &futureWatcher, SLOT(cancel()));
+  QObject::connect(&futureWatcher, SIGNAL(progressRangeChanged(int,int)), &dialog, SLOT(setRange(int,int)));
+  QObject::connect(&futureWatcher, SIGNAL(progressValueChanged(int)), &dialog, SLOT(setValue(int)));
+
+  QFuture<qreal> future=QtConcurrent::mapped(inputList, evaluate);
+  futureWatcher.setFuture(future);
+  dialog.exec();
+  futureWatcher.waitForFinished();
+
+  QList<qreal> results;
+  if( futureWatcher.future().isCanceled() )
   {
-    qint64 mode=variantList.at(counter).toLongLong(); counter++;
-    modeList.append(mode);
+    results.clear();
+  }
+  else
+  {
+    results=future.results();
   }
 
-  qint64 nbasin=variantList.at(counter).toLongLong(); counter++;
-  QList<qint64> basinList;
-  for( qint64 b=0 ; b < nbasin ; ++b )
+  // harvest results
+  for(unsigned int i=0; i < npts ; ++i )
   {
-    qint64 basin=variantList.at(counter).toLongLong(); counter++;
-    basinList.append(basin);
+    fval[i] = i < static_cast<unsigned int>(results.length()) ? results.at(i) : 0.0;
   }
-  QSet<qint64> basinSet=basinList.toSet();
+}
 
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(wfnFileName);
+qreal QTAIMEvaluateProperty(const QTAIMBasinIntegrationPoint &point)
+{
+  const QTAIMBasinIntegration &integration=*point.integration;
+  qreal x0=point.coordinates[0];
+  qreal y0=point.coordinates[1];
+  qreal z0=point.coordinates[2];
+  const QSet<qint64> &basinSet=integration.basinSet;
 
-  QTAIMWavefunctionEvaluator eval(wfn);
+  QTAIMWavefunctionEvaluator eval(*integration.wfn);
 
-  QList<QVariant> valueList;
+  qreal value=0.0;
 
   double initialElectronDensity=eval.electronDensity( Eigen::Vector3d(x0,y0,z0) );
 
   // if less than some small value, then return zero for all integrands.
-  if( initialElectronDensity < 1.e-5 )
+  if( initialElectronDensity >= 1.e-5 )
   {
-    for( qint64 m=0; m < nmode ; ++m )
-    {
-      qreal zero=0.0;
-      valueList.append(zero);
-    }
-  }
-  else
-  {
-    QList<QPair<QVector3D,qreal> > betaSpheres;
-    for( qint64 i=0 ; i < nncp ; ++i )
-    {
-      QPair<QVector3D,qreal> thisBetaSphere;
-      thisBetaSphere.first=QVector3D(ncpList.at(i).x(), ncpList.at(i).y(),ncpList.at(i).z());
-      thisBetaSphere.second=0.10;
-      betaSpheres.append(thisBetaSphere);
-    }
+    const QList<QPair<QVector3D,qreal> > &betaSpheres=integration.betaSpheres;
 
     QTAIMLSODAIntegrator ode(eval,0);
     //  Avogadro::QTAIMODEIntegrator ode(eval,0);
@@ -1256,214 +1285,40 @@ QList<QVariant> QTAIMEvaluateProperty(QList<QVariant> variantList)
 
     if( basinSet.contains(nucleusIndex) )
     {
-      //      if(nucleusIndex==0)
-      //      {
-      //        QFile file("/scratch/brown/0.txt");
-      //        file.open(QIODevice::WriteOnly | QIODevice::Append);
-      //        QTextStream out(&file);
-      //        out << x0 << " " << y0 << " " << z0 << "\n";
-      //        file.close();
-      //      }
-      for( qint64 m=0 ; m < nmode ; ++m )
+      if( integration.mode == 0 )
       {
-        if( modeList.at(m) == 0 )
-        {
-          valueList.append(eval.electronDensity( Eigen::Vector3d(x0,y0,z0) ));
-        }
-        else
-        {
-          qDebug() << "mode not defined";
-          qreal zero=0.0;
-          valueList.append(zero);
-        }
+        value=eval.electronDensity( Eigen::Vector3d(x0,y0,z0) );
       }
-    }
-    else
-    {
-      for(qint64 m=0 ; m < nmode ; ++m)
+      else
       {
-        qreal zero=0.0;
-        valueList.append(zero);
+        qDebug() << "mode not defined";
       }
     }
   }
 
-  return valueList;
+  return value;
 
 }
 
-void property_v(unsigned int /* ndim */, unsigned int npts, const double *xyz, void *param,
+void property_v(unsigned int ndim, unsigned int npts, const double *xyz, void *param,
                 unsigned int /* dim */, double *fval)
 {
-
-  QVariantList *paramVariantListPtr = (QVariantList *)param;
-  QVariantList paramVariantList=*paramVariantListPtr;
-
-  qint64 counter=0;
-  QString wfnFileName=paramVariantList.at(counter).toString(); counter++;
-
-  qint64 nncp=paramVariantList.at(counter).toLongLong(); counter++;
-  QList<QVector3D> ncpList;
-  for( qint64 i=0 ; i < nncp ; ++i )
-  {
-    qreal x=paramVariantList.at(counter).toDouble(); counter++;
-    qreal y=paramVariantList.at(counter).toDouble(); counter++;
-    qreal z=paramVariantList.at(counter).toDouble(); counter++;
-
-    ncpList.append(QVector3D(x,y,z));
-  }
-  qint64 nmode=1;
-  qint64 mode=paramVariantList.at(counter).toLongLong(); counter++;
-  QList<qint64> basinList;
-  for( qint64 i=counter ; i < paramVariantList.length() ; ++i )
-  {
-    basinList.append( paramVariantList.at(i).toLongLong()  );
-    counter++;
-  }
-
-  // prepare input
-
-  QList<QList<QVariant> > inputList;
-
-  for(unsigned int i=0 ; i < npts ; ++i )
-  {
-
-    double x0=xyz[i*3+0];
-    double y0=xyz[i*3+1];
-    double z0=xyz[i*3+2];
-
-    QList<QVariant> variantList;
-
-    variantList.append(wfnFileName);
-
-    variantList.append(x0);
-    variantList.append(y0);
-    variantList.append(z0);
-
-    variantList.append(nncp);
-    for(qint64 n=0; n < nncp ; ++n)
-    {
-      variantList.append(ncpList.at(n).x());
-      variantList.append(ncpList.at(n).y());
-      variantList.append(ncpList.at(n).z());
-    }
-
-    variantList.append(nmode); // for now, one mode
-    for( qint64 m=0 ; m<nmode ; ++m)
-    {
-      variantList.append(mode);
-    }
-
-    qint64 nbasin=basinList.length();
-    variantList.append(nbasin);
-    for(qint64 b=0 ; b<basinList.length() ; ++b)
-    {
-      variantList.append(basinList.at(b));
-    }
-
-    inputList.append(variantList);
-
-  }
-
-  // calculate
-
-  QProgressDialog dialog;
-  dialog.setWindowTitle("QTAIM");
-  dialog.setLabelText(QString("Atomic Basin Integration"));
-
-  QFutureWatcher<void> futureWatcher;
-  QObject::connect(&futureWatcher, SIGNAL(finished()), &dialog, SLOT(reset()));
-  QObject::connect(&dialog, SIGNAL(canceled()), &futureWatcher, SLOT(cancel()));
-  QObject::connect(&futureWatcher, SIGNAL(progressRangeChanged(int,int)), &dialog, SLOT(setRange(int,int)));
-  QObject::connect(&futureWatcher, SIGNAL(progressValueChanged(int)), &dialog, SLOT(setValue(int)));
-
-  QFuture<QList<QVariant> > future=QtConcurrent::mapped(inputList, QTAIMEvaluateProperty);
-  futureWatcher.setFuture(future);
-  dialog.exec();
-  futureWatcher.waitForFinished();
-
-  QList<QList<QVariant> > results;
-  if( futureWatcher.future().isCanceled() )
-  {
-    results.clear();
-  }
-  else
-  {
-    results=future.results();
-  }
-
-  // harvest results
-  for(qint64 i=0; i<npts; ++i )
-  {
-    for(qint64 m=0; m<nmode ; ++m )
-    {
-      fval[m*nmode+i]=results.at(i).at(m).toDouble();
-    }
-  }
-
+  const QTAIMBasinIntegration *integration=static_cast<QTAIMBasinIntegration *>(param);
+  evaluateBasinIntegrationPoints(*integration, npts, xyz, ndim, fval,
+                                 QTAIMEvaluateProperty);
 }
 
-// TODO: Consider QVariantList. For now, mimic what is known to work.
 // This version performs integration in Spherical Polar Coordinates.
 // Note that the basin limits are not explicitly determined.
-QList<QVariant> QTAIMEvaluatePropertyRTP(QList<QVariant> variantList)
+qreal QTAIMEvaluatePropertyRTP(const QTAIMBasinIntegrationPoint &point)
 {
-  /*
-     Order of variantList:
-     QString wfnFileName
-     qreal r0
-     qreal t0
-     qreal p0
-     qint64 nncp
-     qint64 xncp1
-     qint64 yncp1
-     qint64 zncp1
-     qint64 xncp2
-     qint64 yncp2
-     qint64 zncp2
-     ...
-     qint64 nmode
-     qint64 mode1
-     qint64 mode2
-     ...
-     qint64 nbasin
-     qint64 basin1
-     qint64 basin2
-     ...
-  */
-  qint64 counter=0;
-  QString wfnFileName=variantList.at(counter).toString(); counter++;
-  qreal r0=variantList.at(counter).toDouble(); counter++;
-  qreal t0=variantList.at(counter).toDouble(); counter++;
-  qreal p0=variantList.at(counter).toDouble(); counter++;
-
-  qint64 nncp=variantList.at(counter).toLongLong(); counter++;
-  QList<QVector3D> ncpList;
-  for( qint64 n=0 ; n < nncp ; ++n )
-  {
-    qreal x=variantList.at(counter).toDouble(); counter++;
-    qreal y=variantList.at(counter).toDouble(); counter++;
-    qreal z=variantList.at(counter).toDouble(); counter++;
-
-    ncpList.append(QVector3D(x,y,z));
-  }
-
-  qint64 nmode=variantList.at(counter).toLongLong(); counter++;
-  QList<qint64> modeList;
-  for( qint64 m=0 ; m < nmode ; ++m )
-  {
-    qint64 mode=variantList.at(counter).toLongLong(); counter++;
-    modeList.append(mode);
-  }
-
-  qint64 nbasin=variantList.at(counter).toLongLong(); counter++;
-  QList<qint64> basinList;
-  for( qint64 b=0 ; b < nbasin ; ++b )
-  {
-    qint64 basin=variantList.at(counter).toLongLong(); counter++;
-    basinList.append(basin);
-  }
-  QSet<qint64> basinSet=basinList.toSet();
+  const QTAIMBasinIntegration &integration=*point.integration;
+  qreal r0=point.coordinates[0];
+  qreal t0=point.coordinates[1];
+  qreal p0=point.coordinates[2];
+  const QList<QVector3D> &ncpList=integration.ncpList;
+  const QList<qint64> &basinList=integration.basinList;
+  const QSet<qint64> &basinSet=integration.basinSet;
 
   Matrix<qreal,3,1> r0t0p0;
   r0t0p0 << r0, t0, p0;
@@ -1479,34 +1334,16 @@ QList<QVariant> QTAIMEvaluatePropertyRTP(QList<QVariant> variantList)
   qreal y0=x0y0z0(1);
   qreal z0=x0y0z0(2);
 
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(wfnFileName);
-
-  QTAIMWavefunctionEvaluator eval(wfn);
+  QTAIMWavefunctionEvaluator eval(*integration.wfn);
 
-  QList<QVariant> valueList;
+  qreal value=0.0;
 
   double initialElectronDensity=eval.electronDensity( Eigen::Vector3d(x0,y0,z0) );
 
   // if less than some small value, then return zero for all integrands.
-  if( initialElectronDensity < 1.e-5 )
+  if( initialElectronDensity >= 1.e-5 )
   {
-    for( qint64 m=0; m < nmode ; ++m )
-    {
-      qreal zero=0.0;
-      valueList.append(zero);
-    }
-  }
-  else
-  {
-    QList<QPair<QVector3D,qreal> > betaSpheres;
-    for( qint64 i=0 ; i < nncp ; ++i )
-    {
-      QPair<QVector3D,qreal> thisBetaSphere;
-      thisBetaSphere.first=QVector3D(ncpList.at(i).x(), ncpList.at(i).y(),ncpList.at(i).z());
-      thisBetaSphere.second=0.10;
-      betaSpheres.append(thisBetaSphere);
-    }
+    const QList<QPair<QVector3D,qreal> > &betaSpheres=integration.betaSpheres;
 
     QTAIMLSODAIntegrator ode(eval,0);
     //  Avogadro::QTAIMODEIntegrator ode(eval,0);
@@ -1539,296 +1376,67 @@ QList<QVariant> QTAIMEvaluatePropertyRTP(QList<QVariant> variantList)
 
     if( basinSet.contains(nucleusIndex) )
     {
-      //      if(nucleusIndex==0)
-      //      {
-      //        QFile file("/scratch/brown/0.txt");
-      //        file.open(QIODevice::WriteOnly | QIODevice::Append);
-      //        QTextStream out(&file);
-      //        out << x0 << " " << y0 << " " << z0 << "\n";
-      ////        out << r0 << " " << t0 << " " << p0 << "\n";
-      //        file.close();
-      //      }
-      for( qint64 m=0 ; m < nmode ; ++m )
+      if( integration.mode == 0 )
       {
-        if( modeList.at(m) == 0 )
-        {
-          valueList.append(
-
-              r0*r0*sin(t0)*eval.electronDensity( Eigen::Vector3d(x0,y0,z0) )
-
-              );
-        }
-        else
-        {
-          qDebug() << "mode not defined";
-          qreal zero=0.0;
-          valueList.append(zero);
-        }
+        value=r0*r0*sin(t0)*eval.electronDensity( Eigen::Vector3d(x0,y0,z0) );
       }
-    }
-    else
-    {
-      for(qint64 m=0 ; m < nmode ; ++m)
+      else
       {
-        qreal zero=0.0;
-        valueList.append(zero);
+        qDebug() << "mode not defined";
       }
     }
   }
 
-  return valueList;
+  return value;
 
 }
 
-void property_v_rtp(unsigned int /* ndim */, unsigned int npts, const double *xyz, void *param,
+void property_v_rtp(unsigned int ndim, unsigned int npts, const double *xyz, void *param,
                     unsigned int /* fdim */, double *fval)
 {
-
-  QVariantList *paramVariantListPtr = (QVariantList *)param;
-  QVariantList paramVariantList=*paramVariantListPtr;
-
-  qint64 counter=0;
-  QString wfnFileName=paramVariantList.at(counter).toString(); counter++;
-
-  qint64 nncp=paramVariantList.at(counter).toLongLong(); counter++;
-  QList<QVector3D> ncpList;
-  for( qint64 i=0 ; i < nncp ; ++i )
-  {
-    qreal x=paramVariantList.at(counter).toDouble(); counter++;
-    qreal y=paramVariantList.at(counter).toDouble(); counter++;
-    qreal z=paramVariantList.at(counter).toDouble(); counter++;
-
-    ncpList.append(QVector3D(x,y,z));
-  }
-  qint64 nmode=1;
-  qint64 mode=paramVariantList.at(counter).toLongLong(); counter++;
-  QList<qint64> basinList;
-  for( qint64 i=counter ; i < paramVariantList.length() ; ++i )
-  {
-    basinList.append( paramVariantList.at(i).toLongLong()  );
-    counter++;
-  }
-
-  // prepare input
-
-  QList<QList<QVariant> > inputList;
-
-  for(unsigned int i=0 ; i < npts ; ++i )
-  {
-
-    double x0=xyz[i*3+0];
-    double y0=xyz[i*3+1];
-    double z0=xyz[i*3+2];
-
-    QList<QVariant> variantList;
-
-    variantList.append(wfnFileName);
-
-    variantList.append(x0);
-    variantList.append(y0);
-    variantList.append(z0);
-
-    variantList.append(nncp);
-    for(qint64 n=0; n < nncp ; ++n)
-    {
-      variantList.append(ncpList.at(n).x());
-      variantList.append(ncpList.at(n).y());
-      variantList.append(ncpList.at(n).z());
-    }
-
-    variantList.append(nmode); // for now, one mode
-    for( qint64 m=0 ; m<nmode ; ++m)
-    {
-      variantList.append(mode);
-    }
-
-    qint64 nbasin=basinList.length();
-    variantList.append(nbasin);
-    for(qint64 b=0 ; b<basinList.length() ; ++b)
-    {
-      variantList.append(basinList.at(b));
-    }
-
-    inputList.append(variantList);
-
-  }
-
-  // calculate
-
-  QProgressDialog dialog;
-  dialog.setWindowTitle("QTAIM");
-  dialog.setLabelText(QString("Atomic Basin Integration"));
-
-  QFutureWatcher<void> futureWatcher;
-  QObject::connect(&futureWatcher, SIGNAL(finished()), &dialog, SLOT(reset()));
-  QObject::connect(&dialog, SIGNAL(canceled()), &futureWatcher, SLOT(cancel()));
-  QObject::connect(&futureWatcher, SIGNAL(progressRangeChanged(int,int)), &dialog, SLOT(setRange(int,int)));
-  QObject::connect(&futureWatcher, SIGNAL(progressValueChanged(int)), &dialog, SLOT(setValue(int)));
-
-  QFuture<QList<QVariant> > future=QtConcurrent::mapped(inputList, QTAIMEvaluatePropertyRTP);
-  futureWatcher.setFuture(future);
-  dialog.exec();
-  futureWatcher.waitForFinished();
-
-  QList<QList<QVariant> > results;
-  if( futureWatcher.future().isCanceled() )
-  {
-    results.clear();
-  }
-  else
-  {
-    results=future.results();
-  }
-
-  // harvest results
-  for(qint64 i=0; i<npts; ++i )
-  {
-    for(qint64 m=0; m<nmode ; ++m )
-    {
-      fval[m*nmode+i]=results.at(i).at(m).toDouble();
-    }
-  }
-
+  const QTAIMBasinIntegration *integration=static_cast<QTAIMBasinIntegration *>(param);
+  evaluateBasinIntegrationPoints(*integration, npts, xyz, ndim, fval,
+                                 QTAIMEvaluatePropertyRTP);
 }
 
-void property_r(unsigned int ndim, const double *xyz, void *param,
-                unsigned int fdim, double *fval)
+void property_r(unsigned int /* ndim */, const double *xyz, void *param,
+                unsigned int /* fdim */, double *fval)
 {
-
-  ndim=ndim;
-  fdim=fdim;
-
-  QVariantList *paramVariantListPtr = (QVariantList *)param;
-  QVariantList paramVariantList=*paramVariantListPtr;
-
-  qint64 counter=0;
-  QString wfnFileName=paramVariantList.at(counter).toString(); counter++;
+  const QTAIMRadialIntegration *integration=static_cast<QTAIMRadialIntegration *>(param);
 
   qreal r=xyz[0];
-  qreal t=paramVariantList.at(counter).toDouble(); counter++;
-  qreal p=paramVariantList.at(counter).toDouble(); counter++;
-
-  qint64 nncp=paramVariantList.at(counter).toLongLong(); counter++;
-  QList<QVector3D> ncpList;
-  for( qint64 i=0 ; i < nncp ; ++i )
-  {
-    qreal x=paramVariantList.at(counter).toDouble(); counter++;
-    qreal y=paramVariantList.at(counter).toDouble(); counter++;
-    qreal z=paramVariantList.at(counter).toDouble(); counter++;
-
-    ncpList.append(QVector3D(x,y,z));
-  }
-  qint64 nmode=1;
-  qint64 mode=paramVariantList.at(counter).toLongLong(); counter++;
-  QList<qint64> basinList;
-  for( qint64 i=counter ; i < paramVariantList.length() ; ++i )
-  {
-    basinList.append( paramVariantList.at(i).toLongLong()  );
-    counter++;
-  }
 
   Matrix<qreal,3,1> rtp;
-  rtp << r, t, p;
-  Matrix<qreal,3,1> origin;
-  origin <<
-      ncpList.at(basinList.at(0)).x(),
-      ncpList.at(basinList.at(0)).y(),
-      ncpList.at(basinList.at(0)).z();
+  rtp << r, integration->t, integration->p;
 
-  Matrix<qreal,3,1> XYZ=QTAIMMathUtilities::sphericalToCartesian(rtp, origin );
+  Matrix<qreal,3,1> XYZ=QTAIMMathUtilities::sphericalToCartesian(rtp, integration->origin );
 
   qreal x=XYZ(0);
   qreal y=XYZ(1);
   qreal z=XYZ(2);
 
-  // This routine reads the wavefunction file repeatedly.
-  // Let's hope that this time is dwarfed by the time
-  // taken to delineate the atomic basins in the calling routine.
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(wfnFileName);
-  QTAIMWavefunctionEvaluator eval(wfn);
-
-  for(qint64 m=0; m<nmode ; ++m )
+  // The evaluator belongs to the calling task, so the wavefunction is not
+  // set up again for each radial point.
+  fval[0]=0.0;
+  if( integration->mode==0 )
   {
-    if( mode==0 )
-    {
-      fval[m]=r*r*eval.electronDensity( Eigen::Vector3d(x,y,z) );
-    }
+    fval[0]=r*r*integration->eval->electronDensity( Eigen::Vector3d(x,y,z) );
   }
 
 }
 
-QList<QVariant> QTAIMEvaluatePropertyTP(QList<QVariant> variantList)
+qreal QTAIMEvaluatePropertyTP(const QTAIMBasinIntegrationPoint &point)
 {
+  const QTAIMBasinIntegration &integration=*point.integration;
+  qreal t=point.coordinates[0];
+  qreal p=point.coordinates[1];
+  const QList<QVector3D> &ncpList=integration.ncpList;
+  const QList<qint64> &basinList=integration.basinList;
 
-  /*
-     Order of variantList:
-     QString wfnFileName
-     qreal t
-     qreal p
-     qint64 nncp
-     qint64 xncp1
-     qint64 yncp1
-     qint64 zncp1
-     qint64 xncp2
-     qint64 yncp2
-     qint64 zncp2
-     ...
-     qint64 nmode
-     qint64 mode1
-     qint64 mode2
-     ...
-     qint64 nbasin
-     qint64 basin1
-     qint64 basin2
-     ...
-  */
-  qint64 counter=0;
-  QString wfnFileName=variantList.at(counter).toString(); counter++;
-  qreal t=variantList.at(counter).toDouble(); counter++;
-  qreal p=variantList.at(counter).toDouble(); counter++;
-
-  qint64 nncp=variantList.at(counter).toLongLong(); counter++;
-  QList<QVector3D> ncpList;
-  for( qint64 n=0 ; n < nncp ; ++n )
-  {
-    qreal x=variantList.at(counter).toDouble(); counter++;
-    qreal y=variantList.at(counter).toDouble(); counter++;
-    qreal z=variantList.at(counter).toDouble(); counter++;
-
-    ncpList.append(QVector3D(x,y,z));
-  }
-
-  qint64 nmode=variantList.at(counter).toLongLong(); counter++;
-  QList<qint64> modeList;
-  for( qint64 m=0 ; m < nmode ; ++m )
-  {
-    qint64 mode=variantList.at(counter).toLongLong(); counter++;
-    modeList.append(mode);
-  }
-
-  qint64 nbasin=variantList.at(counter).toLongLong(); counter++;
-  QList<qint64> basinList;
-  for( qint64 b=0 ; b < nbasin ; ++b )
-  {
-    qint64 basin=variantList.at(counter).toLongLong(); counter++;
-    basinList.append(basin);
-  }
-  QSet<qint64> basinSet=basinList.toSet();
-
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(wfnFileName);
-  QTAIMWavefunctionEvaluator eval(wfn);
+  QTAIMWavefunctionEvaluator eval(*integration.wfn);
 
   // Set up steepest ascent integrator and beta spheres
-  QList<QPair<QVector3D,qreal> > betaSpheres;
-  for( qint64 i=0 ; i < nncp ; ++i )
-  {
-    QPair<QVector3D,qreal> thisBetaSphere;
-    thisBetaSphere.first=QVector3D(ncpList.at(i).x(), ncpList.at(i).y(),ncpList.at(i).z());
-    thisBetaSphere.second=0.10;
-    betaSpheres.append(thisBetaSphere);
-  }
+  const QList<QPair<QVector3D,qreal> > &betaSpheres=integration.betaSpheres;
 
   QTAIMLSODAIntegrator ode(eval,0);
   //  Avogadro::QTAIMODEIntegrator ode(eval,0);
@@ -2054,22 +1662,15 @@ QList<QVariant> QTAIMEvaluatePropertyTP(QList<QVariant> variantList)
   xmin[0] = 0.0;
   xmax[0] = rf;
 
-  QVariantList paramVariantList;
-  paramVariantList.append(wfnFileName);
-  paramVariantList.append(t);
-  paramVariantList.append(p);
-  paramVariantList.append(ncpList.length()); // number of nuclear critical points
-  for( qint64 j=0 ; j < ncpList.length() ; ++j)
-  {
-    paramVariantList.append(ncpList.at(j).x() );
-    paramVariantList.append(ncpList.at(j).y() );
-    paramVariantList.append(ncpList.at(j).z() );
-  }
-  paramVariantList.append(0); // mode
-  paramVariantList.append( basinList.at(0) ); // basin
+  QTAIMRadialIntegration radialIntegration;
+  radialIntegration.eval=&eval;
+  radialIntegration.origin=origin;
+  radialIntegration.t=t;
+  radialIntegration.p=p;
+  radialIntegration.mode=integration.mode;
 
   //  qDebug() << "Into R with rf=" << rf;
-  adapt_integrate(fdim, property_r, &paramVariantList,
+  adapt_integrate(fdim, property_r, &radialIntegration,
                   dim, xmin, xmax,
                   maxEval, tol, 0,
                   val, err);
@@ -2081,124 +1682,19 @@ QList<QVariant> QTAIMEvaluatePropertyTP(QList<QVariant> variantList)
   free(val);
   free(err);
 
-  //  QList<QVariant> variantList;
-
-  variantList.append(sin(t)*Rval);
-
   //  qDebug() << rf << t << p << sin(t) * Rval;
 
-  return variantList;
+  return sin(t)*Rval;
 
 }
 
 
-void property_v_tp(unsigned int /* ndim */, unsigned int npts, const double *xyz, void *param,
+void property_v_tp(unsigned int ndim, unsigned int npts, const double *xyz, void *param,
                    unsigned int /* fdim */, double *fval)
 {
-
-  QVariantList *paramVariantListPtr = (QVariantList *)param;
-  QVariantList paramVariantList=*paramVariantListPtr;
-
-  qint64 counter=0;
-  QString wfnFileName=paramVariantList.at(counter).toString(); counter++;
-
-  qint64 nncp=paramVariantList.at(counter).toLongLong(); counter++;
-  QList<QVector3D> ncpList;
-  for( qint64 i=0 ; i < nncp ; ++i )
-  {
-    qreal x=paramVariantList.at(counter).toDouble(); counter++;
-    qreal y=paramVariantList.at(counter).toDouble(); counter++;
-    qreal z=paramVariantList.at(counter).toDouble(); counter++;
-
-    ncpList.append(QVector3D(x,y,z));
-  }
-  qint64 nmode=1;
-  qint64 mode=paramVariantList.at(counter).toLongLong(); counter++;
-  QList<qint64> basinList;
-  for( qint64 i=counter ; i < paramVariantList.length() ; ++i )
-  {
-    basinList.append( paramVariantList.at(i).toLongLong()  );
-    counter++;
-  }
-
-  // prepare input
-
-  QList<QList<QVariant> > inputList;
-
-  for(unsigned int i=0 ; i < npts ; ++i )
-  {
-
-    double t=xyz[i*2+0];
-    double p=xyz[i*2+1];
-
-    QList<QVariant> variantList;
-
-    variantList.append(wfnFileName);
-
-    variantList.append(t);
-    variantList.append(p);
-
-    variantList.append(nncp);
-    for(qint64 n=0; n < nncp ; ++n)
-    {
-      variantList.append(ncpList.at(n).x());
-      variantList.append(ncpList.at(n).y());
-      variantList.append(ncpList.at(n).z());
-    }
-
-    variantList.append(nmode); // for now, one mode
-    for( qint64 m=0 ; m<nmode ; ++m)
-    {
-      variantList.append(mode);
-    }
-
-    qint64 nbasin=basinList.length();
-    variantList.append(nbasin);
-    for(qint64 b=0 ; b<basinList.length() ; ++b)
-    {
-      variantList.append(basinList.at(b));
-    }
-
-    inputList.append(variantList);
-
-  }
-
-  // calculate
-
-  QProgressDialog dialog;
-  dialog.setWindowTitle("QTAIM");
-  dialog.setLabelText(QString("Atomic Basin Integration"));
-
-  QFutureWatcher<void> futureWatcher;
-  QObject::connect(&futureWatcher, SIGNAL(finished()), &dialog, SLOT(reset()));
-  QObject::connect(&dialog, SIGNAL(canceled()), &futureWatcher, SLOT(cancel()));
-  QObject::connect(&futureWatcher, SIGNAL(progressRangeChanged(int,int)), &dialog, SLOT(setRange(int,int)));
-  QObject::connect(&futureWatcher, SIGNAL(progressValueChanged(int)), &dialog, SLOT(setValue(int)));
-
-  QFuture<QList<QVariant> > future=QtConcurrent::mapped(inputList, QTAIMEvaluatePropertyTP);
-  futureWatcher.setFuture(future);
-  dialog.exec();
-  futureWatcher.waitForFinished();
-
-  QList<QList<QVariant> > results;
-  if( futureWatcher.future().isCanceled() )
-  {
-    results.clear();
-  }
-  else
-  {
-    results=future.results();
-  }
-
-  // harvest results
-  //  qDebug() << "results=" << results;
-  for(qint64 i=0; i < npts ; ++i)
-  {
-    for(qint64 m=0; m<nmode ; ++m )
-    {
-      fval[m*nmode+i]=results.at(i).at(m).toDouble();
-    }
-  }
+  const QTAIMBasinIntegration *integration=static_cast<QTAIMBasinIntegration *>(param);
+  evaluateBasinIntegrationPoints(*integration, npts, xyz, ndim, fval,
+                                 QTAIMEvaluatePropertyTP);
 }
 
 namespace Avogadro {
@@ -2209,9 +1705,6 @@ namespace QtPlugins {
 
     m_wfn=&wfn;
 
-    m_temporaryFileName=QTAIMCubature::temporaryFileName();
-    m_wfn->saveToBinaryFile(m_temporaryFileName);
-
     // Instantiate a Critical Point Locator
     QTAIMCriticalPointLocator cpl(wfn);
 
@@ -2267,20 +1760,10 @@ namespace QtPlugins {
           xmin[2]= -8. + m_ncpList.at(i).z();
           xmax[2]=  8. + m_ncpList.at(i).z();
 
-          QVariantList paramVariantList;
-          paramVariantList.append(m_temporaryFileName);
-
-          paramVariantList.append(m_ncpList.length()); // number of nuclear critical points
-          for( qint64 j=0 ; j < m_ncpList.length() ; ++j)
-          {
-            paramVariantList.append(m_ncpList.at(j).x() );
-            paramVariantList.append(m_ncpList.at(j).y() );
-            paramVariantList.append(m_ncpList.at(j).z() );
-          }
-          paramVariantList.append(0); // mode
-          paramVariantList.append( basins.at(i) ); // basin
+          QTAIMBasinIntegration integration;
+          setUpBasinIntegration(integration, m_wfn, m_ncpList, 0, basins.at(i));
 
-          adapt_integrate_v(fdim, property_v, &paramVariantList,
+          adapt_integrate_v(fdim, property_v, &integration,
                             dim, xmin, xmax,
                             maxEval, tol, 0,
                             val, err);
@@ -2297,20 +1780,10 @@ namespace QtPlugins {
           xmin[2]=  0.;
           xmax[2]=  2.0*pi;
 
-          QVariantList paramVariantList;
-          paramVariantList.append(m_temporaryFileName);
+          QTAIMBasinIntegration integration;
+          setUpBasinIntegration(integration, m_wfn, m_ncpList, 0, basins.at(i));
 
-          paramVariantList.append(m_ncpList.length()); // number of nuclear critical points
-          for( qint64 j=0 ; j < m_ncpList.length() ; ++j)
-          {
-            paramVariantList.append(m_ncpList.at(j).x() );
-            paramVariantList.append(m_ncpList.at(j).y() );
-            paramVariantList.append(m_ncpList.at(j).z() );
-          }
-          paramVariantList.append(0); // mode
-          paramVariantList.append( basins.at(i) ); // basin
-
-          adapt_integrate_v(fdim, property_v_rtp, &paramVariantList,
+          adapt_integrate_v(fdim, property_v_rtp, &integration,
                             dim, xmin, xmax,
                             maxEval, tol, 0,
                             val, err);
@@ -2336,20 +1809,10 @@ namespace QtPlugins {
         xmin[1]=  0.;
         xmax[1]=  2.0*pi;
 
-        QVariantList paramVariantList;
-        paramVariantList.append(m_temporaryFileName);
+        QTAIMBasinIntegration integration;
+        setUpBasinIntegration(integration, m_wfn, m_ncpList, 0, basins.at(i));
 
-        paramVariantList.append(m_ncpList.length()); // number of nuclear critical points
-        for( qint64 j=0 ; j < m_ncpList.length() ; ++j)
-        {
-          paramVariantList.append(m_ncpList.at(j).x() );
-          paramVariantList.append(m_ncpList.at(j).y() );
-          paramVariantList.append(m_ncpList.at(j).z() );
-        }
-        paramVariantList.append(0); // mode
-        paramVariantList.append( basins.at(i) ); // basin
-
-        adapt_integrate_v(fdim, property_v_tp, &paramVariantList,
+        adapt_integrate_v(fdim, property_v_tp, &integration,
                           dim, xmin, xmax,
                           maxEval, tol, 0,
                           val, err);
@@ -2378,10 +1841,6 @@ namespace QtPlugins {
 
   QTAIMCubature::~QTAIMCubature()
   {
-    if( QFile::exists(m_temporaryFileName) )
-    {
-      QFile::remove(m_temporaryFileName);
-    }
   }
 
   void QTAIMCubature::setMode(qint64 mode)
@@ -2389,24 +1848,5 @@ namespace QtPlugins {
     m_mode=mode;
   }
 
-  QString QTAIMCubature::temporaryFileName()
-  {
-    QTemporaryFile temporaryFile;
-    temporaryFile.open();
-    QString tempFileName=temporaryFile.fileName();
-    temporaryFile.close();
-    temporaryFile.remove();
-
-    // wait for temporary file to be deleted
-    QDir dir;
-    do
-    {
-      // Nothing
-    } while ( dir.exists(tempFileName) );
-
-    return tempFileName;
-  }
-
-
 } // end namespace QtPlugins
 } // end namespace Avogadro
@@ -131,9 +131,6 @@ namespace QtPlugins {
     qint64 m_mode;
     QList<qint64> m_basins;
 
-    QString m_temporaryFileName;
-    QString temporaryFileName();
-
     QList<QVector3D> m_ncpList;
 
   };
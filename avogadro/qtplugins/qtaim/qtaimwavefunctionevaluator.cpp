@@ -21,28 +21,27 @@
 namespace Avogadro {
 namespace QtPlugins {
 
-  QTAIMWavefunctionEvaluator::QTAIMWavefunctionEvaluator(QTAIMWavefunction &wfn)
+  QTAIMWavefunctionEvaluator::QTAIMWavefunctionEvaluator(const QTAIMWavefunction &wfn)
+    : m_nmo(wfn.numberOfMolecularOrbitals()),
+      m_nprim(wfn.numberOfGaussianPrimitives()),
+      m_nnuc(wfn.numberOfNuclei()),
+      m_nucxcoord(wfn.xNuclearCoordinates(),m_nnuc),
+      m_nucycoord(wfn.yNuclearCoordinates(),m_nnuc),
+      m_nuczcoord(wfn.zNuclearCoordinates(),m_nnuc),
+      m_nucz(wfn.nuclearCharges(),m_nnuc),
+      m_X0(wfn.xGaussianPrimitiveCenterCoordinates(),m_nprim,1),
+      m_Y0(wfn.yGaussianPrimitiveCenterCoordinates(),m_nprim,1),
+      m_Z0(wfn.zGaussianPrimitiveCenterCoordinates(),m_nprim,1),
+      m_xamom(wfn.xGaussianPrimitiveAngularMomenta(),m_nprim,1),
+      m_yamom(wfn.yGaussianPrimitiveAngularMomenta(),m_nprim,1),
+      m_zamom(wfn.zGaussianPrimitiveAngularMomenta(),m_nprim,1),
+      m_alpha(wfn.gaussianPrimitiveExponentCoefficients(),m_nprim,1),
+      // TODO Implement screening for unoccupied molecular orbitals.
+      m_occno(wfn.molecularOrbitalOccupationNumbers(),m_nmo,1),
+      m_orbe(wfn.molecularOrbitalEigenvalues(),m_nmo,1),
+      m_coef(wfn.molecularOrbitalCoefficients(),m_nmo,m_nprim)
   {
 
-    m_nmo=wfn.numberOfMolecularOrbitals();
-    m_nprim=wfn.numberOfGaussianPrimitives();
-    m_nnuc=wfn.numberOfNuclei();
-
-    m_nucxcoord=Map<const Matrix<qreal,Dynamic,1> >(wfn.xNuclearCoordinates(),m_nnuc);
-    m_nucycoord=Map<const Matrix<qreal,Dynamic,1> >(wfn.yNuclearCoordinates(),m_nnuc);
-    m_nuczcoord=Map<const Matrix<qreal,Dynamic,1> >(wfn.zNuclearCoordinates(),m_nnuc);
-    m_nucz=Map<const Matrix<qint64,Dynamic,1> >(wfn.nuclearCharges(),m_nnuc);
-    m_X0=Map<const Matrix<qreal,Dynamic,1> >(wfn.xGaussianPrimitiveCenterCoordinates(),m_nprim,1);
-    m_Y0=Map<const Matrix<qreal,Dynamic,1> >(wfn.yGaussianPrimitiveCenterCoordinates(),m_nprim,1);
-    m_Z0=Map<const Matrix<qreal,Dynamic,1> >(wfn.zGaussianPrimitiveCenterCoordinates(),m_nprim,1);
-    m_xamom=Map<const Matrix<qint64,Dynamic,1> >(wfn.xGaussianPrimitiveAngularMomenta(),m_nprim,1);
-    m_yamom=Map<const Matrix<qint64,Dynamic,1> >(wfn.yGaussianPrimitiveAngularMomenta(),m_nprim,1);
-    m_zamom=Map<const Matrix<qint64,Dynamic,1> >(wfn.zGaussianPrimitiveAngularMomenta(),m_nprim,1);
-    m_alpha=Map<const Matrix<qreal,Dynamic,1> >(wfn.gaussianPrimitiveExponentCoefficients(),m_nprim,1);
-    // TODO Implement screening for unoccupied molecular orbitals.
-    m_occno=Map<const Matrix<qreal,Dynamic,1> >(wfn.molecularOrbitalOccupationNumbers(),m_nmo,1);
-    m_orbe=Map<const Matrix<qreal,Dynamic,1> >(wfn.molecularOrbitalEigenvalues(),m_nmo,1);
-    m_coef=Map<const Matrix<qreal,Dynamic,Dynamic,RowMajor> >(wfn.molecularOrbitalCoefficients(),m_nmo,m_nprim);
     m_totalEnergy=wfn.totalEnergy();
     m_virialRatio=wfn.virialRatio();
 
@@ -83,71 +82,252 @@ namespace QtPlugins {
     m_cdg031.resize(m_nmo);
     m_cdg013.resize(m_nmo);
     m_cdg004.resize(m_nmo);
+
+    // Group the primitives by angular momentum, so that the polynomial part of
+    // a whole group is evaluated at once by evaluatePrimitives.
+    for( qint64 p=0 ; p < m_nprim ; ++p )
+    {
+      size_t g=0;
+      while( g < m_primitiveGroups.size() &&
+             ( m_primitiveGroups[g].xamom != m_xamom(p) ||
+               m_primitiveGroups[g].yamom != m_yamom(p) ||
+               m_primitiveGroups[g].zamom != m_zamom(p) ) )
+      {
+        ++g;
+      }
+      if( g == m_primitiveGroups.size() )
+      {
+        PrimitiveGroup group;
+        group.xamom=m_xamom(p);
+        group.yamom=m_yamom(p);
+        group.zamom=m_zamom(p);
+        m_primitiveGroups.push_back(group);
+      }
+      m_primitiveGroups[g].primitives.push_back(p);
+    }
+
+    m_xx0.resize(m_nprim);
+    m_yy0.resize(m_nprim);
+    m_zz0.resize(m_nprim);
+    m_b0arg.resize(m_nprim);
+    m_screened.resize(m_nprim);
+    m_sxx0.resize(m_nprim);
+    m_syy0.resize(m_nprim);
+    m_szz0.resize(m_nprim);
+    m_salpha.resize(m_nprim);
+    m_sb0.resize(m_nprim);
+    m_ax0.resize(m_nprim);
+    m_ay0.resize(m_nprim);
+    m_az0.resize(m_nprim);
+    m_ax1.resize(m_nprim);
+    m_ay1.resize(m_nprim);
+    m_az1.resize(m_nprim);
+    m_ax2.resize(m_nprim);
+    m_ay2.resize(m_nprim);
+    m_az2.resize(m_nprim);
+    m_sdg.resize(m_nprim,10);
+    m_dg.resize(m_nprim,10);
+    m_cdg.resize(m_nmo,10);
   }
 
-  qreal QTAIMWavefunctionEvaluator::molecularOrbital( const qint64 mo, const Matrix<qreal,3,1> xyz )
+  // Number of m_dg columns filled by evaluatePrimitives for a derivative order.
+  static inline qint64 numberOfPrimitiveComponents(int order)
   {
+    return order == 0 ? 1 : ( order == 1 ? 4 : 10 );
+  }
 
-    qreal value=0.0;
-
-    for( qint64 p=0 ; p < m_nprim ; ++p )
+  void QTAIMWavefunctionEvaluator::angularFactors(const ArrayMap &x, qint64 l, int order,
+                                                  ArrayMap a0, ArrayMap a1, ArrayMap a2)
+  {
+    // a0 = x^l, a1 and a2 are its first and second derivatives.
+    switch( l )
     {
-      qreal xx0 = xyz(0) - m_X0(p);
-      qreal yy0 = xyz(1) - m_Y0(p);
-      qreal zz0 = xyz(2) - m_Z0(p);
-
-      qreal b0arg = -m_alpha(p)*(xx0*xx0 + yy0*yy0 + zz0*zz0 );
+    case 0:
+      a0.setOnes();
+      if( order > 0 ) a1.setZero();
+      if( order > 1 ) a2.setZero();
+      break;
+    case 1:
+      a0=x;
+      if( order > 0 ) a1.setOnes();
+      if( order > 1 ) a2.setZero();
+      break;
+    case 2:
+      a0=x*x;
+      if( order > 0 ) a1=2.0*x;
+      if( order > 1 ) a2.setOnes();
+      break;
+    case 3:
+      a0=x*x*x;
+      if( order > 0 ) a1=3.0*(x*x);
+      if( order > 1 ) a2=6.0*x;
+      break;
+    default:
+      for( qint64 i=0 ; i < x.size() ; ++i )
+      {
+        a0(i)=ipow(x(i),l);
+        if( order > 0 ) a1(i)=l*ipow(x(i),l-1);
+        if( order > 1 ) a2(i)=l*(l-1)*ipow(x(i),l-2);
+      }
+    }
+  }
 
-      if( b0arg > m_cutoff )
+  void QTAIMWavefunctionEvaluator::evaluatePrimitives( const Matrix<qreal,3,1> &xyz, int order )
+  {
+    const qint64 ncomp=numberOfPrimitiveComponents(order);
+
+    // Screening pass over all of the primitives.
+    m_xx0 = xyz(0) - m_X0.array();
+    m_yy0 = xyz(1) - m_Y0.array();
+    m_zz0 = xyz(2) - m_Z0.array();
+    m_b0arg = -m_alpha.array()*(m_xx0*m_xx0 + m_yy0*m_yy0 + m_zz0*m_zz0);
+
+    // Pack the primitives passing the screening group by group, the polynomial
+    // part then only depends on the fixed angular momentum of each group.
+    qint64 n=0;
+    for( size_t g=0 ; g < m_primitiveGroups.size() ; ++g )
+    {
+      const PrimitiveGroup &group=m_primitiveGroups[g];
+      const qint64 begin=n;
+      for( size_t i=0 ; i < group.primitives.size() ; ++i )
       {
-        qreal ax0 = ipow( xx0, m_xamom(p) );
-        qreal ay0 = ipow( yy0, m_yamom(p) );
-        qreal az0 = ipow( zz0, m_zamom(p) );
+        const qint64 p=group.primitives[i];
+        if( m_b0arg(p) > m_cutoff )
+        {
+          m_screened(n)=p;
+          m_sxx0(n)=m_xx0(p);
+          m_syy0(n)=m_yy0(p);
+          m_szz0(n)=m_zz0(p);
+          m_salpha(n)=m_alpha(p);
+          m_sb0(n)=m_b0arg(p);
+          ++n;
+        }
+      }
 
-        qreal b0 = exp( b0arg );
+      const qint64 count=n-begin;
+      if( count > 0 )
+      {
+        angularFactors(ArrayMap(m_sxx0.data()+begin,count), group.xamom, order,
+                       ArrayMap(m_ax0.data()+begin,count),
+                       ArrayMap(m_ax1.data()+begin,count),
+                       ArrayMap(m_ax2.data()+begin,count));
+        angularFactors(ArrayMap(m_syy0.data()+begin,count), group.yamom, order,
+                       ArrayMap(m_ay0.data()+begin,count),
+                       ArrayMap(m_ay1.data()+begin,count),
+                       ArrayMap(m_ay2.data()+begin,count));
+        angularFactors(ArrayMap(m_szz0.data()+begin,count), group.zamom, order,
+                       ArrayMap(m_az0.data()+begin,count),
+                       ArrayMap(m_az1.data()+begin,count),
+                       ArrayMap(m_az2.data()+begin,count));
+      }
+    }
 
-        qreal dg000 = ax0*ay0*az0*b0;
+    m_dg.leftCols(ncomp).setZero();
+    if( n == 0 )
+    {
+      return;
+    }
 
-        value += m_coef(mo,p)*dg000;
+    ArrayMap xx0(m_sxx0.data(),n);
+    ArrayMap yy0(m_syy0.data(),n);
+    ArrayMap zz0(m_szz0.data(),n);
+    ArrayMap alpha(m_salpha.data(),n);
+    ArrayMap b0(m_sb0.data(),n);
+    ArrayMap ax0(m_ax0.data(),n);
+    ArrayMap ay0(m_ay0.data(),n);
+    ArrayMap az0(m_az0.data(),n);
+    ArrayMap ax1(m_ax1.data(),n);
+    ArrayMap ay1(m_ay1.data(),n);
+    ArrayMap az1(m_az1.data(),n);
+    ArrayMap ax2(m_ax2.data(),n);
+    ArrayMap ay2(m_ay2.data(),n);
+    ArrayMap az2(m_az2.data(),n);
+
+    // The exponential is only evaluated for the primitives left after
+    // screening, and vectorized over all of them.
+    b0 = b0.exp();
+
+    m_sdg.col(0).head(n) = ax0*ay0*az0*b0;
+
+    if( order > 0 )
+    {
+      // Fold the derivatives of the exponential into the polynomial factors.
+      // The second derivatives go first as they use the plain first ones.
+      if( order > 1 )
+      {
+        ax2 = ax2 + 2.0*ax1*(-2.0*alpha*xx0) + ax0*(-2.0*alpha + 4.0*((alpha*alpha)*(xx0*xx0)));
+        ay2 = ay2 + 2.0*ay1*(-2.0*alpha*yy0) + ay0*(-2.0*alpha + 4.0*((alpha*alpha)*(yy0*yy0)));
+        az2 = az2 + 2.0*az1*(-2.0*alpha*zz0) + az0*(-2.0*alpha + 4.0*((alpha*alpha)*(zz0*zz0)));
       }
+      ax1 = ax1 + ax0*(-2.0*alpha*xx0);
+      ay1 = ay1 + ay0*(-2.0*alpha*yy0);
+      az1 = az1 + az0*(-2.0*alpha*zz0);
 
-    }
+      m_sdg.col(1).head(n) = ay0*az0*b0*ax1;
+      m_sdg.col(2).head(n) = ax0*az0*b0*ay1;
+      m_sdg.col(3).head(n) = ax0*ay0*b0*az1;
 
-    return value;
+      if( order > 1 )
+      {
+        m_sdg.col(4).head(n) = ay0*az0*b0*ax2;
+        m_sdg.col(5).head(n) = ax0*az0*b0*ay2;
+        m_sdg.col(6).head(n) = ax0*ay0*b0*az2;
+        m_sdg.col(7).head(n) = az0*b0*ax1*ay1;
+        m_sdg.col(8).head(n) = ay0*b0*ax1*az1;
+        m_sdg.col(9).head(n) = ax0*b0*ay1*az1;
+      }
+    }
 
+    // Back to the original order of the primitives for the contraction.
+    for( qint64 c=0 ; c < ncomp ; ++c )
+    {
+      for( qint64 k=0 ; k < n ; ++k )
+      {
+        m_dg(m_screened(k),c) = m_sdg(k,c);
+      }
+    }
   }
 
-  qreal QTAIMWavefunctionEvaluator::electronDensity( const Matrix<qreal,3,1> xyz )
+  void QTAIMWavefunctionEvaluator::contractPrimitives(int order)
   {
+    const qint64 ncomp=numberOfPrimitiveComponents(order);
 
-    qreal value;
+    m_cdg.leftCols(ncomp).noalias() = m_coef * m_dg.leftCols(ncomp);
 
-    m_cdg000.setZero();
-    for( qint64 p=0 ; p < m_nprim ; ++p )
+    m_cdg000=m_cdg.col(0);
+    if( order > 0 )
     {
-      qreal xx0 = xyz(0) - m_X0(p);
-      qreal yy0 = xyz(1) - m_Y0(p);
-      qreal zz0 = xyz(2) - m_Z0(p);
+      m_cdg100=m_cdg.col(1);
+      m_cdg010=m_cdg.col(2);
+      m_cdg001=m_cdg.col(3);
+    }
+    if( order > 1 )
+    {
+      m_cdg200=m_cdg.col(4);
+      m_cdg020=m_cdg.col(5);
+      m_cdg002=m_cdg.col(6);
+      m_cdg110=m_cdg.col(7);
+      m_cdg101=m_cdg.col(8);
+      m_cdg011=m_cdg.col(9);
+    }
+  }
 
-      qreal b0arg = -m_alpha(p)*(xx0*xx0 + yy0*yy0 + zz0*zz0 );
+  qreal QTAIMWavefunctionEvaluator::molecularOrbital( const qint64 mo, const Matrix<qreal,3,1> xyz )
+  {
 
-      if( b0arg > m_cutoff )
-      {
-        qreal ax0 = ipow( xx0, m_xamom(p) );
-        qreal ay0 = ipow( yy0, m_yamom(p) );
-        qreal az0 = ipow( zz0, m_zamom(p) );
+    evaluatePrimitives(xyz,0);
 
-        qreal b0 = exp(b0arg);
+    return m_coef.row(mo).transpose().dot(m_dg.col(0));
 
-        qreal dg000 = ax0*ay0*az0*b0;
+  }
 
-        for( qint64 m=0 ; m < m_nmo ; ++m )
-        {
-          m_cdg000(m) += m_coef(m,p) * dg000;
-        }
+  qreal QTAIMWavefunctionEvaluator::electronDensity( const Matrix<qreal,3,1> xyz )
+  {
 
-      }
-    }
+    qreal value;
+
+    evaluatePrimitives(xyz,0);
+    contractPrimitives(0);
 
     value=0.0;
     for( qint64 m=0 ; m < m_nmo ; ++m )
@@ -164,114 +344,121 @@ namespace QtPlugins {
 
     Matrix<qreal,3,1> value;
 
-    const qreal zero=0.0;
-    const qreal one =1.0;
+    evaluatePrimitives(xyz,1);
+    contractPrimitives(1);
 
-    m_cdg000.setZero();
-    m_cdg100.setZero();
-    m_cdg010.setZero();
-    m_cdg001.setZero();
-    for( qint64 p=0 ; p < m_nprim ; ++p )
+    value.setZero();
+    for( qint64 m=0 ; m < m_nmo ; ++m )
     {
-      qreal xx0 = xyz(0) - m_X0(p);
-      qreal yy0 = xyz(1) - m_Y0(p);
-      qreal zz0 = xyz(2) - m_Z0(p);
+      value(0) += m_occno(m)*m_cdg100(m)*m_cdg000(m);
+      value(1) += m_occno(m)*m_cdg010(m)*m_cdg000(m);
+      value(2) += m_occno(m)*m_cdg001(m)*m_cdg000(m);
+    }
 
-      qreal b0arg = -m_alpha(p)*(xx0*xx0 + yy0*yy0 + zz0*zz0 );
+    return value;
 
-      if( b0arg > m_cutoff )
-      {
-        qint64 aax0=1;
-        qint64 aay0=1;
-        qint64 aaz0=1;
-        qint64 aax1=m_xamom(p);
-        qint64 aay1=m_yamom(p);
-        qint64 aaz1=m_zamom(p);
+  }
 
-        qreal ax0 = aax0*ipow( xx0, m_xamom(p) );
-        qreal ay0 = aay0*ipow( yy0, m_yamom(p) );
-        qreal az0 = aaz0*ipow( zz0, m_zamom(p) );
+  const Matrix<qreal,3,3> QTAIMWavefunctionEvaluator::hessianOfElectronDensity( const Matrix<qreal,3,1> xyz )
+  {
 
-        qreal ax1;
-        qreal ay1;
-        qreal az1;
-        if     ( m_xamom(p) <  1 )
-        {
-          ax1=zero;
-        }
-        else if( m_xamom(p) == 1 )
-        {
-          ax1=one;
-        }
-        else
-        {
-          ax1=aax1*ipow(xx0,m_xamom(p)-1);
-        }
+    Matrix<qreal,3,3> value;
 
-        if     ( m_yamom(p) <  1 )
-        {
-          ay1=zero;
-        }
-        else if( m_yamom(p) == 1 )
-        {
-          ay1=one;
-        }
-        else
-        {
-          ay1=aay1*ipow(yy0,m_yamom(p)-1);
-        }
+    evaluatePrimitives(xyz,2);
+    contractPrimitives(2);
 
-        if     ( m_zamom(p) <  1 )
-        {
-          az1=zero;
-        }
-        else if( m_zamom(p) == 1 )
-        {
-          az1=one;
-        }
-        else
-        {
-          az1=aaz1*ipow(zz0,m_zamom(p)-1);
-        }
+    value.setZero();
+    for( qint64 m=0 ; m < m_nmo ; ++m )
+    {
+      value(0,0) += 2*m_occno(m)*(ipow(m_cdg100(m),2)+m_cdg000(m)*m_cdg200(m));
+      value(1,1) += 2*m_occno(m)*(ipow(m_cdg010(m),2)+m_cdg000(m)*m_cdg020(m));
+      value(2,2) += 2*m_occno(m)*(ipow(m_cdg001(m),2)+m_cdg000(m)*m_cdg002(m));
+      value(0,1) += 2*m_occno(m)*(m_cdg100(m)*m_cdg010(m)+m_cdg000(m)*m_cdg110(m));
+      value(0,2) += 2*m_occno(m)*(m_cdg100(m)*m_cdg001(m)+m_cdg000(m)*m_cdg101(m));
+      value(1,2) += 2*m_occno(m)*(m_cdg010(m)*m_cdg001(m)+m_cdg000(m)*m_cdg011(m));
+    }
+    value(1,0)=value(0,1);
+    value(2,0)=value(0,2);
+    value(2,1)=value(1,2);
 
-        qreal b0 = exp(b0arg);
+    return value;
 
-        qreal bx1= -2*m_alpha(p)*xx0;
-        qreal by1= -2*m_alpha(p)*yy0;
-        qreal bz1= -2*m_alpha(p)*zz0;
+  }
 
-        qreal dg000 = ax0*ay0*az0*b0;
-        qreal dg100 = ay0*az0*b0*(ax1+ax0*bx1);
-        qreal dg010 = ax0*az0*b0*(ay1+ay0*by1);
-        qreal dg001 = ax0*ay0*b0*(az1+az0*bz1);
+  const Matrix<qreal,3,4> QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensity( const Matrix<qreal,3,1> xyz )
+  {
 
-        for( qint64 m=0 ; m < m_nmo ; ++m )
-        {
-          m_cdg000(m) += m_coef(m,p) * dg000;
-          m_cdg100(m) += m_coef(m,p) * dg100;
-          m_cdg010(m) += m_coef(m,p) * dg010;
-          m_cdg001(m) += m_coef(m,p) * dg001;
-        }
+    Matrix<qreal,3,1> gValue;
+    Matrix<qreal,3,3> hValue;
+    Matrix<qreal,3,4> value;
 
-      }
+    evaluatePrimitives(xyz,2);
+    contractPrimitives(2);
+
+    gValue.setZero();
+    for( qint64 m=0 ; m < m_nmo ; ++m )
+    {
+      gValue(0) += m_occno(m)*m_cdg100(m)*m_cdg000(m);
+      gValue(1) += m_occno(m)*m_cdg010(m)*m_cdg000(m);
+      gValue(2) += m_occno(m)*m_cdg001(m)*m_cdg000(m);
     }
 
-    value.setZero();
+    hValue.setZero();
     for( qint64 m=0 ; m < m_nmo ; ++m )
     {
-      value(0) += m_occno(m)*m_cdg100(m)*m_cdg000(m);
-      value(1) += m_occno(m)*m_cdg010(m)*m_cdg000(m);
-      value(2) += m_occno(m)*m_cdg001(m)*m_cdg000(m);
+      hValue(0,0) += 2*m_occno(m)*(ipow(m_cdg100(m),2)+m_cdg000(m)*m_cdg200(m));
+      hValue(1,1) += 2*m_occno(m)*(ipow(m_cdg010(m),2)+m_cdg000(m)*m_cdg020(m));
+      hValue(2,2) += 2*m_occno(m)*(ipow(m_cdg001(m),2)+m_cdg000(m)*m_cdg002(m));
+      hValue(0,1) += 2*m_occno(m)*(m_cdg100(m)*m_cdg010(m)+m_cdg000(m)*m_cdg110(m));
+      hValue(0,2) += 2*m_occno(m)*(m_cdg100(m)*m_cdg001(m)+m_cdg000(m)*m_cdg101(m));
+      hValue(1,2) += 2*m_occno(m)*(m_cdg010(m)*m_cdg001(m)+m_cdg000(m)*m_cdg011(m));
     }
+    hValue(1,0)=hValue(0,1);
+    hValue(2,0)=hValue(0,2);
+    hValue(2,1)=hValue(1,2);
+
+    value(0,0) = gValue(0);
+    value(1,0) = gValue(1);
+    value(2,0) = gValue(2);
+    value(0,1) = hValue(0,0);
+    value(1,1) = hValue(1,0);
+    value(2,1) = hValue(2,0);
+    value(0,2) = hValue(0,1);
+    value(1,2) = hValue(1,1);
+    value(2,2) = hValue(2,1);
+    value(0,3) = hValue(0,2);
+    value(1,3) = hValue(1,2);
+    value(2,3) = hValue(2,2);
 
     return value;
 
   }
 
-  const Matrix<qreal,3,3> QTAIMWavefunctionEvaluator::hessianOfElectronDensity( const Matrix<qreal,3,1> xyz )
+  qreal QTAIMWavefunctionEvaluator::laplacianOfElectronDensity( const Matrix<qreal,3,1> xyz )
   {
 
-    Matrix<qreal,3,3> value;
+    qreal value;
+
+    evaluatePrimitives(xyz,2);
+    contractPrimitives(2);
+
+    value=0.0;
+    for( qint64 m=0 ; m < m_nmo ; ++m )
+    {
+      value +=    2*m_occno(m)*(ipow(m_cdg100(m),2)+m_cdg000(m)*m_cdg200(m))
+                  +2*m_occno(m)*(ipow(m_cdg010(m),2)+m_cdg000(m)*m_cdg020(m))
+                  +2*m_occno(m)*(ipow(m_cdg001(m),2)+m_cdg000(m)*m_cdg002(m));
+    }
+
+    return value;
+
+  }
+
+
+  const Matrix<qreal,3,1> QTAIMWavefunctionEvaluator::gradientOfElectronDensityLaplacian( const Matrix<qreal,3,1> xyz )
+  {
+
+    Matrix<qreal,3,1> value;
 
     const qreal zero=0.0;
     const qreal one =1.0;
@@ -286,6 +473,16 @@ namespace QtPlugins {
     m_cdg110.setZero();
     m_cdg101.setZero();
     m_cdg011.setZero();
+    m_cdg300.setZero();
+    m_cdg120.setZero();
+    m_cdg102.setZero();
+    m_cdg210.setZero();
+    m_cdg030.setZero();
+    m_cdg012.setZero();
+    m_cdg201.setZero();
+    m_cdg021.setZero();
+    m_cdg003.setZero();
+    // m_cdg111.setZero();
     for( qint64 p=0 ; p < m_nprim ; ++p )
     {
       qreal xx0 = xyz(0) - m_X0(p);
@@ -305,6 +502,9 @@ namespace QtPlugins {
         qint64 aax2=m_xamom(p)*(m_xamom(p)-1);
         qint64 aay2=m_yamom(p)*(m_yamom(p)-1);
         qint64 aaz2=m_zamom(p)*(m_zamom(p)-1);
+        qint64 aax3=m_xamom(p)*(m_xamom(p)-1)*(m_xamom(p)-2);
+        qint64 aay3=m_yamom(p)*(m_yamom(p)-1)*(m_yamom(p)-2);
+        qint64 aaz3=m_zamom(p)*(m_zamom(p)-1)*(m_zamom(p)-2);
 
         qreal ax0 = aax0*ipow( xx0, m_xamom(p) );
         qreal ay0 = aay0*ipow( yy0, m_yamom(p) );
@@ -394,14 +594,59 @@ namespace QtPlugins {
           az2=aaz2*ipow(zz0,m_zamom(p)-2);
         }
 
-        qreal b0 = exp(b0arg);
-
-        qreal bx1 = -2*m_alpha(p)*xx0;
-        qreal by1 = -2*m_alpha(p)*yy0;
-        qreal bz1 = -2*m_alpha(p)*zz0;
-        qreal bx2 = -2*m_alpha(p) + 4*(ipow(m_alpha(p),2) * ipow(xx0,2));
+        qreal ax3;
+        qreal ay3;
+        qreal az3;
+        if     ( m_xamom(p) <  3 )
+        {
+          ax3=zero;
+        }
+        else if( m_xamom(p) == 3 )
+        {
+          ax3=one;
+        }
+        else
+        {
+          ax3=aax3*ipow(xx0,m_xamom(p)-3);
+        }
+
+        if     ( m_yamom(p) <  3 )
+        {
+          ay3=zero;
+        }
+        else if( m_yamom(p) == 3 )
+        {
+          ay3=one;
+        }
+        else
+        {
+          ay3=aay3*ipow(yy0,m_yamom(p)-3);
+        }
+
+        if     ( m_zamom(p) <  3 )
+        {
+          az3=zero;
+        }
+        else if( m_zamom(p) == 3 )
+        {
+          az3=one;
+        }
+        else
+        {
+          az3=aaz3*ipow(zz0,m_zamom(p)-3);
+        }
+
+        qreal b0 = exp(b0arg);
+
+        qreal bx1 = -2*m_alpha(p)*xx0;
+        qreal by1 = -2*m_alpha(p)*yy0;
+        qreal bz1 = -2*m_alpha(p)*zz0;
+        qreal bx2 = -2*m_alpha(p) + 4*(ipow(m_alpha(p),2) * ipow(xx0,2));
         qreal by2 = -2*m_alpha(p) + 4*(ipow(m_alpha(p),2) * ipow(yy0,2));
         qreal bz2 = -2*m_alpha(p) + 4*(ipow(m_alpha(p),2) * ipow(zz0,2));
+        qreal bx3 = (12*ipow(m_alpha(p),2)*xx0)-(8*ipow(m_alpha(p),3) * ipow(xx0,3));
+        qreal by3 = (12*ipow(m_alpha(p),2)*yy0)-(8*ipow(m_alpha(p),3) * ipow(yy0,3));
+        qreal bz3 = (12*ipow(m_alpha(p),2)*zz0)-(8*ipow(m_alpha(p),3) * ipow(zz0,3));
 
         qreal dg000 = ax0*ay0*az0*b0;
         qreal dg100 = ay0*az0*b0*(ax1+ax0*bx1);
@@ -413,6 +658,16 @@ namespace QtPlugins {
         qreal dg110 = az0*b0*(ax1+ax0*bx1)*(ay1+ay0*by1);
         qreal dg101 = ay0*b0*(ax1+ax0*bx1)*(az1+az0*bz1);
         qreal dg011 = ax0*b0*(ay1+ay0*by1)*(az1+az0*bz1);
+        qreal dg300 = ay0*az0*b0*(ax3+3*ax2*bx1+3*ax1*bx2+ax0*bx3);
+        qreal dg030 = ax0*az0*b0*(ay3+3*ay2*by1+3*ay1*by2+ay0*by3);
+        qreal dg003 = ax0*ay0*b0*(az3+3*az2*bz1+3*az1*bz2+az0*bz3);
+        qreal dg210 = az0*b0*(ax2+2*ax1*bx1+ax0*bx2)*(ay1+ay0*by1);
+        qreal dg201 = ay0*b0*(ax2+2*ax1*bx1+ax0*bx2)*(az1+az0*bz1);
+        qreal dg120 = az0*b0*(ax1+ax0*bx1)*(ay2+2*ay1*by1+ay0*by2);
+        qreal dg021 = ax0*b0*(ay2+2*ay1*by1+ay0*by2)*(az1+az0*bz1);
+        qreal dg102 = ay0*b0*(ax1+ax0*bx1)*(az2+2*az1*bz1+az0*bz2);
+        qreal dg012 = ax0*b0*(ay1+ay0*by1)*(az2+2*az1*bz1+az0*bz2);
+        // qreal dg111 = b0*(ax1+ax0*bx1)*(ay1+ay0*by1)*(az1+az0*bz1);
 
         for( qint64 m=0 ; m < m_nmo ; ++m )
         {
@@ -426,35 +681,57 @@ namespace QtPlugins {
           m_cdg110(m) += m_coef(m,p) * dg110;
           m_cdg101(m) += m_coef(m,p) * dg101;
           m_cdg011(m) += m_coef(m,p) * dg011;
+          m_cdg300(m) += m_coef(m,p) * dg300;
+          m_cdg030(m) += m_coef(m,p) * dg030;
+          m_cdg003(m) += m_coef(m,p) * dg003;
+          m_cdg210(m) += m_coef(m,p) * dg210;
+          m_cdg201(m) += m_coef(m,p) * dg201;
+          m_cdg120(m) += m_coef(m,p) * dg120;
+          m_cdg021(m) += m_coef(m,p) * dg021;
+          m_cdg102(m) += m_coef(m,p) * dg102;
+          m_cdg012(m) += m_coef(m,p) * dg012;
+          // m_cdg111(m) += m_coef(m,p) * dg111;
         }
 
       }
     }
 
-    value.setZero();
+    qreal deriv300=zero;
+    qreal deriv030=zero;
+    qreal deriv003=zero;
+    qreal deriv210=zero;
+    qreal deriv201=zero;
+    qreal deriv120=zero;
+    qreal deriv021=zero;
+    qreal deriv102=zero;
+    qreal deriv012=zero;
+    // qreal deriv111=zero;
     for( qint64 m=0 ; m < m_nmo ; ++m )
     {
-      value(0,0) += 2*m_occno(m)*(ipow(m_cdg100(m),2)+m_cdg000(m)*m_cdg200(m));
-      value(1,1) += 2*m_occno(m)*(ipow(m_cdg010(m),2)+m_cdg000(m)*m_cdg020(m));
-      value(2,2) += 2*m_occno(m)*(ipow(m_cdg001(m),2)+m_cdg000(m)*m_cdg002(m));
-      value(0,1) += 2*m_occno(m)*(m_cdg100(m)*m_cdg010(m)+m_cdg000(m)*m_cdg110(m));
-      value(0,2) += 2*m_occno(m)*(m_cdg100(m)*m_cdg001(m)+m_cdg000(m)*m_cdg101(m));
-      value(1,2) += 2*m_occno(m)*(m_cdg010(m)*m_cdg001(m)+m_cdg000(m)*m_cdg011(m));
+      deriv300+=(m_occno(m)*( 6*m_cdg100(m)*m_cdg200(m)+2*m_cdg000(m)*m_cdg300(m) ));
+      deriv030+=(m_occno(m)*( 6*m_cdg010(m)*m_cdg020(m)+2*m_cdg000(m)*m_cdg030(m) ));
+      deriv003+=(m_occno(m)*( 6*m_cdg001(m)*m_cdg002(m)+2*m_cdg000(m)*m_cdg003(m) ));
+      deriv210+=(m_occno(m)*( 2*(2*m_cdg100(m)*m_cdg110(m)+m_cdg010(m)*m_cdg200(m)+m_cdg000(m)*m_cdg210(m)) ));
+      deriv201+=(m_occno(m)*( 2*(2*m_cdg100(m)*m_cdg101(m)+m_cdg001(m)*m_cdg200(m)+m_cdg000(m)*m_cdg201(m)) ));
+      deriv120+=(m_occno(m)*( 2*(m_cdg020(m)*m_cdg100(m)+2*m_cdg010(m)*m_cdg110(m)+m_cdg000(m)*m_cdg120(m)) ));
+      deriv021+=(m_occno(m)*( 2*(2*m_cdg010(m)*m_cdg011(m)+m_cdg001(m)*m_cdg020(m)+m_cdg000(m)*m_cdg021(m)) ));
+      deriv102+=(m_occno(m)*( 2*(m_cdg002(m)*m_cdg100(m)+2*m_cdg001(m)*m_cdg101(m)+m_cdg000(m)*m_cdg102(m)) ));
+      deriv012+=(m_occno(m)*( 2*(m_cdg002(m)*m_cdg010(m)+2*m_cdg001(m)*m_cdg011(m)+m_cdg000(m)*m_cdg012(m)) ));
+      // deriv111+=(m_occno(m)*( 2*(m_cdg011(m)*m_cdg100(m)+m_cdg010(m)*m_cdg101(m)+m_cdg001(m)*m_cdg110(m)+m_cdg000(m)*m_cdg111(m)) ));
     }
-    value(1,0)=value(0,1);
-    value(2,0)=value(0,2);
-    value(2,1)=value(1,2);
+
+    value(0)=deriv300+deriv120+deriv102;
+    value(1)=deriv210+deriv030+deriv012;
+    value(2)=deriv201+deriv021+deriv003;
 
     return value;
 
   }
 
-  const Matrix<qreal,3,4> QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensity( const Matrix<qreal,3,1> xyz )
+  const Matrix<qreal,3,3> QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian( const Matrix<qreal,3,1> xyz )
   {
 
-    Matrix<qreal,3,1> gValue;
-    Matrix<qreal,3,3> hValue;
-    Matrix<qreal,3,4> value;
+    Matrix<qreal,3,3> value;
 
     const qreal zero=0.0;
     const qreal one =1.0;
@@ -469,6 +746,32 @@ namespace QtPlugins {
     m_cdg110.setZero();
     m_cdg101.setZero();
     m_cdg011.setZero();
+    m_cdg300.setZero();
+    m_cdg120.setZero();
+    m_cdg102.setZero();
+    m_cdg210.setZero();
+    m_cdg030.setZero();
+    m_cdg012.setZero();
+    m_cdg201.setZero();
+    m_cdg021.setZero();
+    m_cdg003.setZero();
+    m_cdg111.setZero();
+    m_cdg400.setZero();
+    m_cdg040.setZero();
+    m_cdg004.setZero();
+    m_cdg310.setZero();
+    m_cdg301.setZero();
+    m_cdg130.setZero();
+    m_cdg031.setZero();
+    m_cdg103.setZero();
+    m_cdg013.setZero();
+    m_cdg220.setZero();
+    m_cdg202.setZero();
+    m_cdg022.setZero();
+    m_cdg211.setZero();
+    m_cdg121.setZero();
+    m_cdg112.setZero();
+
     for( qint64 p=0 ; p < m_nprim ; ++p )
     {
       qreal xx0 = xyz(0) - m_X0(p);
@@ -488,6 +791,12 @@ namespace QtPlugins {
         qint64 aax2=m_xamom(p)*(m_xamom(p)-1);
         qint64 aay2=m_yamom(p)*(m_yamom(p)-1);
         qint64 aaz2=m_zamom(p)*(m_zamom(p)-1);
+        qint64 aax3=m_xamom(p)*(m_xamom(p)-1)*(m_xamom(p)-2);
+        qint64 aay3=m_yamom(p)*(m_yamom(p)-1)*(m_yamom(p)-2);
+        qint64 aaz3=m_zamom(p)*(m_zamom(p)-1)*(m_zamom(p)-2);
+        qint64 aax4=m_xamom(p)*(m_xamom(p)-1)*(m_xamom(p)-2)*(m_xamom(p)-3);
+        qint64 aay4=m_yamom(p)*(m_yamom(p)-1)*(m_yamom(p)-2)*(m_xamom(p)-3);
+        qint64 aaz4=m_zamom(p)*(m_zamom(p)-1)*(m_zamom(p)-2)*(m_xamom(p)-3);
 
         qreal ax0 = aax0*ipow( xx0, m_xamom(p) );
         qreal ay0 = aay0*ipow( yy0, m_yamom(p) );
@@ -577,6 +886,90 @@ namespace QtPlugins {
           az2=aaz2*ipow(zz0,m_zamom(p)-2);
         }
 
+        qreal ax3;
+        qreal ay3;
+        qreal az3;
+        if     ( m_xamom(p) <  3 )
+        {
+          ax3=zero;
+        }
+        else if( m_xamom(p) == 3 )
+        {
+          ax3=one;
+        }
+        else
+        {
+          ax3=aax3*ipow(xx0,m_xamom(p)-3);
+        }
+
+        if     ( m_yamom(p) <  3 )
+        {
+          ay3=zero;
+        }
+        else if( m_yamom(p) == 3 )
+        {
+          ay3=one;
+        }
+        else
+        {
+          ay3=aay3*ipow(yy0,m_yamom(p)-3);
+        }
+
+        if     ( m_zamom(p) <  3 )
+        {
+          az3=zero;
+        }
+        else if( m_zamom(p) == 3 )
+        {
+          az3=one;
+        }
+        else
+        {
+          az3=aaz3*ipow(zz0,m_zamom(p)-3);
+        }
+
+        qreal ax4;
+        qreal ay4;
+        qreal az4;
+        if     ( m_xamom(p) <  4 )
+        {
+          ax4=zero;
+        }
+        else if( m_xamom(p) == 4 )
+        {
+          ax4=one;
+        }
+        else
+        {
+          ax4=aax4*ipow(xx0,m_xamom(p)-4);
+        }
+
+        if     ( m_yamom(p) <  4 )
+        {
+          ay4=zero;
+        }
+        else if( m_yamom(p) == 4 )
+        {
+          ay4=one;
+        }
+        else
+        {
+          ay4=aay4*ipow(yy0,m_yamom(p)-4);
+        }
+
+        if     ( m_zamom(p) <  4 )
+        {
+          az4=zero;
+        }
+        else if( m_zamom(p) == 4 )
+        {
+          az4=one;
+        }
+        else
+        {
+          az4=aaz4*ipow(zz0,m_zamom(p)-4);
+        }
+
         qreal b0 = exp(b0arg);
 
         qreal bx1 = -2*m_alpha(p)*xx0;
@@ -585,6 +978,12 @@ namespace QtPlugins {
         qreal bx2 = -2*m_alpha(p) + 4*(ipow(m_alpha(p),2) * ipow(xx0,2));
         qreal by2 = -2*m_alpha(p) + 4*(ipow(m_alpha(p),2) * ipow(yy0,2));
         qreal bz2 = -2*m_alpha(p) + 4*(ipow(m_alpha(p),2) * ipow(zz0,2));
+        qreal bx3 = (12*ipow(m_alpha(p),2)*xx0)-(8*ipow(m_alpha(p),3) * ipow(xx0,3));
+        qreal by3 = (12*ipow(m_alpha(p),2)*yy0)-(8*ipow(m_alpha(p),3) * ipow(yy0,3));
+        qreal bz3 = (12*ipow(m_alpha(p),2)*zz0)-(8*ipow(m_alpha(p),3) * ipow(zz0,3));
+        qreal bx4 = (12*ipow(m_alpha(p),2))-(48*ipow(m_alpha(p),3) * ipow(xx0,2))+(16*ipow(m_alpha(p),4) * ipow(xx0,4));
+        qreal by4 = (12*ipow(m_alpha(p),2))-(48*ipow(m_alpha(p),3) * ipow(yy0,2))+(16*ipow(m_alpha(p),4) * ipow(yy0,4));
+        qreal bz4 = (12*ipow(m_alpha(p),2))-(48*ipow(m_alpha(p),3) * ipow(zz0,2))+(16*ipow(m_alpha(p),4) * ipow(zz0,4));
 
         qreal dg000 = ax0*ay0*az0*b0;
         qreal dg100 = ay0*az0*b0*(ax1+ax0*bx1);
@@ -596,67 +995,128 @@ namespace QtPlugins {
         qreal dg110 = az0*b0*(ax1+ax0*bx1)*(ay1+ay0*by1);
         qreal dg101 = ay0*b0*(ax1+ax0*bx1)*(az1+az0*bz1);
         qreal dg011 = ax0*b0*(ay1+ay0*by1)*(az1+az0*bz1);
-
-        for( qint64 m=0 ; m < m_nmo ; ++m )
-        {
-          m_cdg000(m) += m_coef(m,p) * dg000;
-          m_cdg100(m) += m_coef(m,p) * dg100;
-          m_cdg010(m) += m_coef(m,p) * dg010;
-          m_cdg001(m) += m_coef(m,p) * dg001;
-          m_cdg200(m) += m_coef(m,p) * dg200;
-          m_cdg020(m) += m_coef(m,p) * dg020;
-          m_cdg002(m) += m_coef(m,p) * dg002;
-          m_cdg110(m) += m_coef(m,p) * dg110;
-          m_cdg101(m) += m_coef(m,p) * dg101;
-          m_cdg011(m) += m_coef(m,p) * dg011;
-        }
-
-      }
-    }
-
-    gValue.setZero();
-    for( qint64 m=0 ; m < m_nmo ; ++m )
-    {
-      gValue(0) += m_occno(m)*m_cdg100(m)*m_cdg000(m);
-      gValue(1) += m_occno(m)*m_cdg010(m)*m_cdg000(m);
-      gValue(2) += m_occno(m)*m_cdg001(m)*m_cdg000(m);
+        qreal dg300 = ay0*az0*b0*(ax3+3*ax2*bx1+3*ax1*bx2+ax0*bx3);
+        qreal dg030 = ax0*az0*b0*(ay3+3*ay2*by1+3*ay1*by2+ay0*by3);
+        qreal dg003 = ax0*ay0*b0*(az3+3*az2*bz1+3*az1*bz2+az0*bz3);
+        qreal dg210 = az0*b0*(ax2+2*ax1*bx1+ax0*bx2)*(ay1+ay0*by1);
+        qreal dg201 = ay0*b0*(ax2+2*ax1*bx1+ax0*bx2)*(az1+az0*bz1);
+        qreal dg120 = az0*b0*(ax1+ax0*bx1)*(ay2+2*ay1*by1+ay0*by2);
+        qreal dg021 = ax0*b0*(ay2+2*ay1*by1+ay0*by2)*(az1+az0*bz1);
+        qreal dg102 = ay0*b0*(ax1+ax0*bx1)*(az2+2*az1*bz1+az0*bz2);
+        qreal dg012 = ax0*b0*(ay1+ay0*by1)*(az2+2*az1*bz1+az0*bz2);
+        qreal dg111 = b0*(ax1+ax0*bx1)*(ay1+ay0*by1)*(az1+az0*bz1);
+        qreal dg400 = ay0*az0*b0*(ax4+4*ax3*bx1+6*ax2*bx2+4*ax1*bx3+ax0*bx4);
+        qreal dg040 = ax0*az0*b0*(ay4+4*ay3*by1+6*ay2*by2+4*ay1*by3+ay0*by4);
+        qreal dg004 = ax0*ay0*b0*(az4+4*az3*bz1+6*az2*bz2+4*az1*bz3+az0*bz4);
+        qreal dg310 = az0*b0*(ax3+3*ax2*bx1+3*ax1*bx2+ax0*bx3)*(ay1+ay0*by1);
+        qreal dg301 = ay0*b0*(ax3+3*ax2*bx1+3*ax1*bx2+ax0*bx3)*(az1+az0*bz1);
+        qreal dg130 = az0*b0*(ax1+ax0*bx1)*(ay3+3*ay2*by1+3*ay1*by2+ay0*by3);
+        qreal dg031 = ax0*b0*(ay3+3*ay2*by1+3*ay1*by2+ay0*by3)*(az1+az0*bz1);
+        qreal dg103 = ay0*b0*(ax1+ax0*bx1)*(az3+3*az2*bz1+3*az1*bz2+az0*bz3);
+        qreal dg013 = ax0*b0*(ay1+ay0*by1)*(az3+3*az2*bz1+3*az1*bz2+az0*bz3);
+        qreal dg220 = az0*b0*(ax2+2*ax1*bx1+ax0*bx2)*(ay2+2*ay1*by1+ay0*by2);
+        qreal dg202 = ay0*b0*(ax2+2*ax1*bx1+ax0*bx2)*(az2+2*az1*bz1+az0*bz2);
+        qreal dg022 = ax0*b0*(ay2+2*ay1*by1+ay0*by2)*(az2+2*az1*bz1+az0*bz2);
+        qreal dg211 = b0*(ax2+2*ax1*bx1+ax0*bx2)*(ay1+ay0*by1)*(az1+az0*bz1);
+        qreal dg121 = b0*(ax1+ax0*bx1)*(ay2+2*ay1*by1+ay0*by2)*(az1+az0*bz1);
+        qreal dg112 = b0*(ax1+ax0*bx1)*(ay1+ay0*by1)*(az2+2*az1*bz1+az0*bz2);
+
+        for( qint64 m=0 ; m < m_nmo ; ++m )
+        {
+          m_cdg000(m) += m_coef(m,p) * dg000;
+          m_cdg100(m) += m_coef(m,p) * dg100;
+          m_cdg010(m) += m_coef(m,p) * dg010;
+          m_cdg001(m) += m_coef(m,p) * dg001;
+          m_cdg200(m) += m_coef(m,p) * dg200;
+          m_cdg020(m) += m_coef(m,p) * dg020;
+          m_cdg002(m) += m_coef(m,p) * dg002;
+          m_cdg110(m) += m_coef(m,p) * dg110;
+          m_cdg101(m) += m_coef(m,p) * dg101;
+          m_cdg011(m) += m_coef(m,p) * dg011;
+          m_cdg300(m) += m_coef(m,p) * dg300;
+          m_cdg030(m) += m_coef(m,p) * dg030;
+          m_cdg003(m) += m_coef(m,p) * dg003;
+          m_cdg210(m) += m_coef(m,p) * dg210;
+          m_cdg201(m) += m_coef(m,p) * dg201;
+          m_cdg120(m) += m_coef(m,p) * dg120;
+          m_cdg021(m) += m_coef(m,p) * dg021;
+          m_cdg102(m) += m_coef(m,p) * dg102;
+          m_cdg012(m) += m_coef(m,p) * dg012;
+          m_cdg111(m) += m_coef(m,p) * dg111;
+          m_cdg400(m) += m_coef(m,p) * dg400;
+          m_cdg040(m) += m_coef(m,p) * dg040;
+          m_cdg004(m) += m_coef(m,p) * dg004;
+          m_cdg310(m) += m_coef(m,p) * dg310;
+          m_cdg301(m) += m_coef(m,p) * dg301;
+          m_cdg130(m) += m_coef(m,p) * dg130;
+          m_cdg031(m) += m_coef(m,p) * dg031;
+          m_cdg103(m) += m_coef(m,p) * dg103;
+          m_cdg013(m) += m_coef(m,p) * dg013;
+          m_cdg220(m) += m_coef(m,p) * dg220;
+          m_cdg202(m) += m_coef(m,p) * dg202;
+          m_cdg022(m) += m_coef(m,p) * dg022;
+          m_cdg211(m) += m_coef(m,p) * dg211;
+          m_cdg121(m) += m_coef(m,p) * dg121;
+          m_cdg112(m) += m_coef(m,p) * dg112;
+        }
+
+      }
     }
 
-    hValue.setZero();
+    qreal deriv400=zero;
+    qreal deriv040=zero;
+    qreal deriv004=zero;
+    qreal deriv310=zero;
+    qreal deriv301=zero;
+    qreal deriv130=zero;
+    qreal deriv031=zero;
+    qreal deriv103=zero;
+    qreal deriv013=zero;
+    qreal deriv220=zero;
+    qreal deriv202=zero;
+    qreal deriv022=zero;
+    qreal deriv211=zero;
+    qreal deriv121=zero;
+    qreal deriv112=zero;
     for( qint64 m=0 ; m < m_nmo ; ++m )
     {
-      hValue(0,0) += 2*m_occno(m)*(ipow(m_cdg100(m),2)+m_cdg000(m)*m_cdg200(m));
-      hValue(1,1) += 2*m_occno(m)*(ipow(m_cdg010(m),2)+m_cdg000(m)*m_cdg020(m));
-      hValue(2,2) += 2*m_occno(m)*(ipow(m_cdg001(m),2)+m_cdg000(m)*m_cdg002(m));
-      hValue(0,1) += 2*m_occno(m)*(m_cdg100(m)*m_cdg010(m)+m_cdg000(m)*m_cdg110(m));
-      hValue(0,2) += 2*m_occno(m)*(m_cdg100(m)*m_cdg001(m)+m_cdg000(m)*m_cdg101(m));
-      hValue(1,2) += 2*m_occno(m)*(m_cdg010(m)*m_cdg001(m)+m_cdg000(m)*m_cdg011(m));
+      deriv400+=(m_occno(m)*(6*ipow(m_cdg200(m),2)+8*m_cdg100(m)*m_cdg300(m)+2*m_cdg000(m)*m_cdg400(m)));
+      deriv040+=(m_occno(m)*(6*ipow(m_cdg020(m),2)+8*m_cdg010(m)*m_cdg030(m)+2*m_cdg000(m)*m_cdg040(m)));
+      deriv004+=(m_occno(m)*(6*ipow(m_cdg002(m),2)+8*m_cdg001(m)*m_cdg003(m)+2*m_cdg000(m)*m_cdg004(m)));
+      deriv310+=(m_occno(m)*(2*(3*m_cdg110(m)*m_cdg200(m)+3*m_cdg100(m)*m_cdg210(m)+m_cdg010(m)*m_cdg300(m)+m_cdg000(m)*m_cdg310(m))));
+      deriv301+=(m_occno(m)*(2*(3*m_cdg101(m)*m_cdg200(m)+3*m_cdg100(m)*m_cdg201(m)+m_cdg001(m)*m_cdg300(m)+m_cdg000(m)*m_cdg301(m))));
+      deriv130+=(m_occno(m)*(2*(m_cdg030(m)*m_cdg100(m)+3*m_cdg020(m)*m_cdg110(m)+3*m_cdg010(m)*m_cdg120(m)+m_cdg000(m)*m_cdg130(m))));
+      deriv031+=(m_occno(m)*(2*(3*m_cdg011(m)*m_cdg020(m)+3*m_cdg010(m)*m_cdg021(m)+m_cdg001(m)*m_cdg030(m)+m_cdg000(m)*m_cdg031(m))));
+      deriv103+=(m_occno(m)*(2*(m_cdg003(m)*m_cdg100(m)+3*m_cdg002(m)*m_cdg101(m)+3*m_cdg001(m)*m_cdg102(m)+m_cdg000(m)*m_cdg103(m))));
+      deriv013+=(m_occno(m)*(2*(m_cdg003(m)*m_cdg010(m)+3*m_cdg002(m)*m_cdg011(m)+3*m_cdg001(m)*m_cdg012(m)+m_cdg000(m)*m_cdg013(m))));
+      deriv220+=(m_occno(m)*(2*(2*ipow(m_cdg110(m),2)+2*m_cdg100(m)*m_cdg120(m)+m_cdg020(m)*m_cdg200(m)+2*m_cdg010(m)*m_cdg210(m)+m_cdg000(m)*m_cdg220(m))));
+      deriv202+=(m_occno(m)*(2*(2*ipow(m_cdg101(m),2)+2*m_cdg100(m)*m_cdg102(m)+m_cdg002(m)*m_cdg200(m)+2*m_cdg001(m)*m_cdg201(m)+m_cdg000(m)*m_cdg202(m))));
+      deriv022+=(m_occno(m)*(2*(2*ipow(m_cdg011(m),2)+2*m_cdg010(m)*m_cdg012(m)+m_cdg002(m)*m_cdg020(m)+2*m_cdg001(m)*m_cdg021(m)+m_cdg000(m)*m_cdg022(m))));
+      deriv211+=(m_occno(m)*(2*(2*m_cdg101(m)*m_cdg110(m)+2*m_cdg100(m)*m_cdg111(m)+m_cdg011(m)*m_cdg200(m)+m_cdg010(m)*m_cdg201(m)+m_cdg001(m)*m_cdg210(m)+m_cdg000(m)*m_cdg211(m))));
+      deriv121+=(m_occno(m)*(2*(m_cdg021(m)*m_cdg100(m)+m_cdg020(m)*m_cdg101(m)+2*m_cdg011(m)*m_cdg110(m)+2*m_cdg010(m)*m_cdg111(m)+m_cdg001(m)*m_cdg120(m)+m_cdg000(m)*m_cdg121(m))));
+      deriv112+=(m_occno(m)*(2*(m_cdg012(m)*m_cdg100(m)+2*m_cdg011(m)*m_cdg101(m)+m_cdg010(m)*m_cdg102(m)+m_cdg002(m)*m_cdg110(m)+2*m_cdg001(m)*m_cdg111(m)+m_cdg000(m)*m_cdg112(m))));
     }
-    hValue(1,0)=hValue(0,1);
-    hValue(2,0)=hValue(0,2);
-    hValue(2,1)=hValue(1,2);
 
-    value(0,0) = gValue(0);
-    value(1,0) = gValue(1);
-    value(2,0) = gValue(2);
-    value(0,1) = hValue(0,0);
-    value(1,1) = hValue(1,0);
-    value(2,1) = hValue(2,0);
-    value(0,2) = hValue(0,1);
-    value(1,2) = hValue(1,1);
-    value(2,2) = hValue(2,1);
-    value(0,3) = hValue(0,2);
-    value(1,3) = hValue(1,2);
-    value(2,3) = hValue(2,2);
+    value(0,0)=deriv400+deriv220+deriv202;
+    value(1,1)=deriv220+deriv040+deriv022;
+    value(2,2)=deriv202+deriv022+deriv004;
+    value(0,1)=deriv310+deriv130+deriv112;
+    value(0,2)=deriv301+deriv121+deriv103;
+    value(1,2)=deriv211+deriv031+deriv013;
+    value(1,0)=value(0,1);
+    value(2,0)=value(0,2);
+    value(2,1)=value(1,2);
 
     return value;
 
   }
 
-  qreal QTAIMWavefunctionEvaluator::laplacianOfElectronDensity( const Matrix<qreal,3,1> xyz )
+  const Matrix<qreal,3,4> QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian( const Matrix<qreal,3,1> xyz )
   {
 
-    qreal value;
+    Matrix<qreal,3,1> gValue;
+    Matrix<qreal,3,3> hValue;
+    Matrix<qreal,3,4> value;
 
     const qreal zero=0.0;
     const qreal one =1.0;
@@ -668,6 +1128,35 @@ namespace QtPlugins {
     m_cdg200.setZero();
     m_cdg020.setZero();
     m_cdg002.setZero();
+    m_cdg110.setZero();
+    m_cdg101.setZero();
+    m_cdg011.setZero();
+    m_cdg300.setZero();
+    m_cdg120.setZero();
+    m_cdg102.setZero();
+    m_cdg210.setZero();
+    m_cdg030.setZero();
+    m_cdg012.setZero();
+    m_cdg201.setZero();
+    m_cdg021.setZero();
+    m_cdg003.setZero();
+    m_cdg111.setZero();
+    m_cdg400.setZero();
+    m_cdg040.setZero();
+    m_cdg004.setZero();
+    m_cdg310.setZero();
+    m_cdg301.setZero();
+    m_cdg130.setZero();
+    m_cdg031.setZero();
+    m_cdg103.setZero();
+    m_cdg013.setZero();
+    m_cdg220.setZero();
+    m_cdg202.setZero();
+    m_cdg022.setZero();
+    m_cdg211.setZero();
+    m_cdg121.setZero();
+    m_cdg112.setZero();
+
     for( qint64 p=0 ; p < m_nprim ; ++p )
     {
       qreal xx0 = xyz(0) - m_X0(p);
@@ -687,6 +1176,12 @@ namespace QtPlugins {
         qint64 aax2=m_xamom(p)*(m_xamom(p)-1);
         qint64 aay2=m_yamom(p)*(m_yamom(p)-1);
         qint64 aaz2=m_zamom(p)*(m_zamom(p)-1);
+        qint64 aax3=m_xamom(p)*(m_xamom(p)-1)*(m_xamom(p)-2);
+        qint64 aay3=m_yamom(p)*(m_yamom(p)-1)*(m_yamom(p)-2);
+        qint64 aaz3=m_zamom(p)*(m_zamom(p)-1)*(m_zamom(p)-2);
+        qint64 aax4=m_xamom(p)*(m_xamom(p)-1)*(m_xamom(p)-2)*(m_xamom(p)-3);
+        qint64 aay4=m_yamom(p)*(m_yamom(p)-1)*(m_yamom(p)-2)*(m_xamom(p)-3);
+        qint64 aaz4=m_zamom(p)*(m_zamom(p)-1)*(m_zamom(p)-2)*(m_xamom(p)-3);
 
         qreal ax0 = aax0*ipow( xx0, m_xamom(p) );
         qreal ay0 = aay0*ipow( yy0, m_yamom(p) );
@@ -776,231 +1271,90 @@ namespace QtPlugins {
           az2=aaz2*ipow(zz0,m_zamom(p)-2);
         }
 
-        qreal b0 = exp(b0arg);
-
-        qreal bx1 = -2*m_alpha(p)*xx0;
-        qreal by1 = -2*m_alpha(p)*yy0;
-        qreal bz1 = -2*m_alpha(p)*zz0;
-        qreal bx2 = -2*m_alpha(p) + 4*(ipow(m_alpha(p),2) * ipow(xx0,2));
-        qreal by2 = -2*m_alpha(p) + 4*(ipow(m_alpha(p),2) * ipow(yy0,2));
-        qreal bz2 = -2*m_alpha(p) + 4*(ipow(m_alpha(p),2) * ipow(zz0,2));
-
-        qreal dg000 = ax0*ay0*az0*b0;
-        qreal dg100 = ay0*az0*b0*(ax1+ax0*bx1);
-        qreal dg010 = ax0*az0*b0*(ay1+ay0*by1);
-        qreal dg001 = ax0*ay0*b0*(az1+az0*bz1);
-        qreal dg200 = ay0*az0*b0*(ax2+2*ax1*bx1+ax0*bx2);
-        qreal dg020 = ax0*az0*b0*(ay2+2*ay1*by1+ay0*by2);
-        qreal dg002 = ax0*ay0*b0*(az2+2*az1*bz1+az0*bz2);
-
-        for( qint64 m=0 ; m < m_nmo ; ++m )
-        {
-          m_cdg000(m) += m_coef(m,p) * dg000;
-          m_cdg100(m) += m_coef(m,p) * dg100;
-          m_cdg010(m) += m_coef(m,p) * dg010;
-          m_cdg001(m) += m_coef(m,p) * dg001;
-          m_cdg200(m) += m_coef(m,p) * dg200;
-          m_cdg020(m) += m_coef(m,p) * dg020;
-          m_cdg002(m) += m_coef(m,p) * dg002;
-        }
-
-      }
-    }
-
-    value=0.0;
-    for( qint64 m=0 ; m < m_nmo ; ++m )
-    {
-      value +=    2*m_occno(m)*(ipow(m_cdg100(m),2)+m_cdg000(m)*m_cdg200(m))
-                  +2*m_occno(m)*(ipow(m_cdg010(m),2)+m_cdg000(m)*m_cdg020(m))
-                  +2*m_occno(m)*(ipow(m_cdg001(m),2)+m_cdg000(m)*m_cdg002(m));
-    }
-
-    return value;
-
-  }
-
-
-  const Matrix<qreal,3,1> QTAIMWavefunctionEvaluator::gradientOfElectronDensityLaplacian( const Matrix<qreal,3,1> xyz )
-  {
-
-    Matrix<qreal,3,1> value;
-
-    const qreal zero=0.0;
-    const qreal one =1.0;
-
-    m_cdg000.setZero();
-    m_cdg100.setZero();
-    m_cdg010.setZero();
-    m_cdg001.setZero();
-    m_cdg200.setZero();
-    m_cdg020.setZero();
-    m_cdg002.setZero();
-    m_cdg110.setZero();
-    m_cdg101.setZero();
-    m_cdg011.setZero();
-    m_cdg300.setZero();
-    m_cdg120.setZero();
-    m_cdg102.setZero();
-    m_cdg210.setZero();
-    m_cdg030.setZero();
-    m_cdg012.setZero();
-    m_cdg201.setZero();
-    m_cdg021.setZero();
-    m_cdg003.setZero();
-    // m_cdg111.setZero();
-    for( qint64 p=0 ; p < m_nprim ; ++p )
-    {
-      qreal xx0 = xyz(0) - m_X0(p);
-      qreal yy0 = xyz(1) - m_Y0(p);
-      qreal zz0 = xyz(2) - m_Z0(p);
-
-      qreal b0arg = -m_alpha(p)*(xx0*xx0 + yy0*yy0 + zz0*zz0 );
-
-      if( b0arg > m_cutoff )
-      {
-        qint64 aax0=1;
-        qint64 aay0=1;
-        qint64 aaz0=1;
-        qint64 aax1=m_xamom(p);
-        qint64 aay1=m_yamom(p);
-        qint64 aaz1=m_zamom(p);
-        qint64 aax2=m_xamom(p)*(m_xamom(p)-1);
-        qint64 aay2=m_yamom(p)*(m_yamom(p)-1);
-        qint64 aaz2=m_zamom(p)*(m_zamom(p)-1);
-        qint64 aax3=m_xamom(p)*(m_xamom(p)-1)*(m_xamom(p)-2);
-        qint64 aay3=m_yamom(p)*(m_yamom(p)-1)*(m_yamom(p)-2);
-        qint64 aaz3=m_zamom(p)*(m_zamom(p)-1)*(m_zamom(p)-2);
-
-        qreal ax0 = aax0*ipow( xx0, m_xamom(p) );
-        qreal ay0 = aay0*ipow( yy0, m_yamom(p) );
-        qreal az0 = aaz0*ipow( zz0, m_zamom(p) );
-
-        qreal ax1;
-        qreal ay1;
-        qreal az1;
-        if     ( m_xamom(p) <  1 )
-        {
-          ax1=zero;
-        }
-        else if( m_xamom(p) == 1 )
-        {
-          ax1=one;
-        }
-        else
-        {
-          ax1=aax1*ipow(xx0,m_xamom(p)-1);
-        }
-
-        if     ( m_yamom(p) <  1 )
-        {
-          ay1=zero;
-        }
-        else if( m_yamom(p) == 1 )
-        {
-          ay1=one;
-        }
-        else
-        {
-          ay1=aay1*ipow(yy0,m_yamom(p)-1);
-        }
-
-        if     ( m_zamom(p) <  1 )
-        {
-          az1=zero;
-        }
-        else if( m_zamom(p) == 1 )
-        {
-          az1=one;
-        }
-        else
-        {
-          az1=aaz1*ipow(zz0,m_zamom(p)-1);
-        }
-
-        qreal ax2;
-        qreal ay2;
-        qreal az2;
-        if     ( m_xamom(p) <  2 )
-        {
-          ax2=zero;
-        }
-        else if( m_xamom(p) == 2 )
-        {
-          ax2=one;
-        }
-        else
-        {
-          ax2=aax2*ipow(xx0,m_xamom(p)-2);
-        }
-
-        if     ( m_yamom(p) <  2 )
-        {
-          ay2=zero;
-        }
-        else if( m_yamom(p) == 2 )
-        {
-          ay2=one;
-        }
-        else
-        {
-          ay2=aay2*ipow(yy0,m_yamom(p)-2);
-        }
-
-        if     ( m_zamom(p) <  2 )
-        {
-          az2=zero;
-        }
-        else if( m_zamom(p) == 2 )
-        {
-          az2=one;
-        }
-        else
-        {
-          az2=aaz2*ipow(zz0,m_zamom(p)-2);
-        }
-
-        qreal ax3;
-        qreal ay3;
-        qreal az3;
-        if     ( m_xamom(p) <  3 )
-        {
-          ax3=zero;
-        }
-        else if( m_xamom(p) == 3 )
-        {
-          ax3=one;
-        }
-        else
-        {
-          ax3=aax3*ipow(xx0,m_xamom(p)-3);
-        }
-
-        if     ( m_yamom(p) <  3 )
-        {
-          ay3=zero;
-        }
-        else if( m_yamom(p) == 3 )
-        {
-          ay3=one;
-        }
-        else
-        {
-          ay3=aay3*ipow(yy0,m_yamom(p)-3);
-        }
-
-        if     ( m_zamom(p) <  3 )
-        {
-          az3=zero;
-        }
-        else if( m_zamom(p) == 3 )
-        {
-          az3=one;
-        }
-        else
-        {
-          az3=aaz3*ipow(zz0,m_zamom(p)-3);
-        }
-
+        qreal ax3;
+        qreal ay3;
+        qreal az3;
+        if     ( m_xamom(p) <  3 )
+        {
+          ax3=zero;
+        }
+        else if( m_xamom(p) == 3 )
+        {
+          ax3=one;
+        }
+        else
+        {
+          ax3=aax3*ipow(xx0,m_xamom(p)-3);
+        }
+
+        if     ( m_yamom(p) <  3 )
+        {
+          ay3=zero;
+        }
+        else if( m_yamom(p) == 3 )
+        {
+          ay3=one;
+        }
+        else
+        {
+          ay3=aay3*ipow(yy0,m_yamom(p)-3);
+        }
+
+        if     ( m_zamom(p) <  3 )
+        {
+          az3=zero;
+        }
+        else if( m_zamom(p) == 3 )
+        {
+          az3=one;
+        }
+        else
+        {
+          az3=aaz3*ipow(zz0,m_zamom(p)-3);
+        }
+
+        qreal ax4;
+        qreal ay4;
+        qreal az4;
+        if     ( m_xamom(p) <  4 )
+        {
+          ax4=zero;
+        }
+        else if( m_xamom(p) == 4 )
+        {
+          ax4=one;
+        }
+        else
+        {
+          ax4=aax4*ipow(xx0,m_xamom(p)-4);
+        }
+
+        if     ( m_yamom(p) <  4 )
+        {
+          ay4=zero;
+        }
+        else if( m_yamom(p) == 4 )
+        {
+          ay4=one;
+        }
+        else
+        {
+          ay4=aay4*ipow(yy0,m_yamom(p)-4);
+        }
+
+        if     ( m_zamom(p) <  4 )
+        {
+          az4=zero;
+        }
+        else if( m_zamom(p) == 4 )
+        {
+          az4=one;
+        }
+        else
+        {
+          az4=aaz4*ipow(zz0,m_zamom(p)-4);
+        }
+
         qreal b0 = exp(b0arg);
 
         qreal bx1 = -2*m_alpha(p)*xx0;
@@ -1012,6 +1366,9 @@ namespace QtPlugins {
         qreal bx3 = (12*ipow(m_alpha(p),2)*xx0)-(8*ipow(m_alpha(p),3) * ipow(xx0,3));
         qreal by3 = (12*ipow(m_alpha(p),2)*yy0)-(8*ipow(m_alpha(p),3) * ipow(yy0,3));
         qreal bz3 = (12*ipow(m_alpha(p),2)*zz0)-(8*ipow(m_alpha(p),3) * ipow(zz0,3));
+        qreal bx4 = (12*ipow(m_alpha(p),2))-(48*ipow(m_alpha(p),3) * ipow(xx0,2))+(16*ipow(m_alpha(p),4) * ipow(xx0,4));
+        qreal by4 = (12*ipow(m_alpha(p),2))-(48*ipow(m_alpha(p),3) * ipow(yy0,2))+(16*ipow(m_alpha(p),4) * ipow(yy0,4));
+        qreal bz4 = (12*ipow(m_alpha(p),2))-(48*ipow(m_alpha(p),3) * ipow(zz0,2))+(16*ipow(m_alpha(p),4) * ipow(zz0,4));
 
         qreal dg000 = ax0*ay0*az0*b0;
         qreal dg100 = ay0*az0*b0*(ax1+ax0*bx1);
@@ -1032,7 +1389,22 @@ namespace QtPlugins {
         qreal dg021 = ax0*b0*(ay2+2*ay1*by1+ay0*by2)*(az1+az0*bz1);
         qreal dg102 = ay0*b0*(ax1+ax0*bx1)*(az2+2*az1*bz1+az0*bz2);
         qreal dg012 = ax0*b0*(ay1+ay0*by1)*(az2+2*az1*bz1+az0*bz2);
-        // qreal dg111 = b0*(ax1+ax0*bx1)*(ay1+ay0*by1)*(az1+az0*bz1);
+        qreal dg111 = b0*(ax1+ax0*bx1)*(ay1+ay0*by1)*(az1+az0*bz1);
+        qreal dg400 = ay0*az0*b0*(ax4+4*ax3*bx1+6*ax2*bx2+4*ax1*bx3+ax0*bx4);
+        qreal dg040 = ax0*az0*b0*(ay4+4*ay3*by1+6*ay2*by2+4*ay1*by3+ay0*by4);
+        qreal dg004 = ax0*ay0*b0*(az4+4*az3*bz1+6*az2*bz2+4*az1*bz3+az0*bz4);
+        qreal dg310 = az0*b0*(ax3+3*ax2*bx1+3*ax1*bx2+ax0*bx3)*(ay1+ay0*by1);
+        qreal dg301 = ay0*b0*(ax3+3*ax2*bx1+3*ax1*bx2+ax0*bx3)*(az1+az0*bz1);
+        qreal dg130 = az0*b0*(ax1+ax0*bx1)*(ay3+3*ay2*by1+3*ay1*by2+ay0*by3);
+        qreal dg031 = ax0*b0*(ay3+3*ay2*by1+3*ay1*by2+ay0*by3)*(az1+az0*bz1);
+        qreal dg103 = ay0*b0*(ax1+ax0*bx1)*(az3+3*az2*bz1+3*az1*bz2+az0*bz3);
+        qreal dg013 = ax0*b0*(ay1+ay0*by1)*(az3+3*az2*bz1+3*az1*bz2+az0*bz3);
+        qreal dg220 = az0*b0*(ax2+2*ax1*bx1+ax0*bx2)*(ay2+2*ay1*by1+ay0*by2);
+        qreal dg202 = ay0*b0*(ax2+2*ax1*bx1+ax0*bx2)*(az2+2*az1*bz1+az0*bz2);
+        qreal dg022 = ax0*b0*(ay2+2*ay1*by1+ay0*by2)*(az2+2*az1*bz1+az0*bz2);
+        qreal dg211 = b0*(ax2+2*ax1*bx1+ax0*bx2)*(ay1+ay0*by1)*(az1+az0*bz1);
+        qreal dg121 = b0*(ax1+ax0*bx1)*(ay2+2*ay1*by1+ay0*by2)*(az1+az0*bz1);
+        qreal dg112 = b0*(ax1+ax0*bx1)*(ay1+ay0*by1)*(az2+2*az1*bz1+az0*bz2);
 
         for( qint64 m=0 ; m < m_nmo ; ++m )
         {
@@ -1055,22 +1427,51 @@ namespace QtPlugins {
           m_cdg021(m) += m_coef(m,p) * dg021;
           m_cdg102(m) += m_coef(m,p) * dg102;
           m_cdg012(m) += m_coef(m,p) * dg012;
-          // m_cdg111(m) += m_coef(m,p) * dg111;
-        }
-
-      }
-    }
-
-    qreal deriv300=zero;
-    qreal deriv030=zero;
-    qreal deriv003=zero;
-    qreal deriv210=zero;
-    qreal deriv201=zero;
-    qreal deriv120=zero;
-    qreal deriv021=zero;
-    qreal deriv102=zero;
+          m_cdg111(m) += m_coef(m,p) * dg111;
+          m_cdg400(m) += m_coef(m,p) * dg400;
+          m_cdg040(m) += m_coef(m,p) * dg040;
+          m_cdg004(m) += m_coef(m,p) * dg004;
+          m_cdg310(m) += m_coef(m,p) * dg310;
+          m_cdg301(m) += m_coef(m,p) * dg301;
+          m_cdg130(m) += m_coef(m,p) * dg130;
+          m_cdg031(m) += m_coef(m,p) * dg031;
+          m_cdg103(m) += m_coef(m,p) * dg103;
+          m_cdg013(m) += m_coef(m,p) * dg013;
+          m_cdg220(m) += m_coef(m,p) * dg220;
+          m_cdg202(m) += m_coef(m,p) * dg202;
+          m_cdg022(m) += m_coef(m,p) * dg022;
+          m_cdg211(m) += m_coef(m,p) * dg211;
+          m_cdg121(m) += m_coef(m,p) * dg121;
+          m_cdg112(m) += m_coef(m,p) * dg112;
+        }
+
+      }
+    }
+
+    qreal deriv300=zero;
+    qreal deriv030=zero;
+    qreal deriv003=zero;
+    qreal deriv210=zero;
+    qreal deriv201=zero;
+    qreal deriv120=zero;
+    qreal deriv021=zero;
+    qreal deriv102=zero;
     qreal deriv012=zero;
-    // qreal deriv111=zero;
+    qreal deriv400=zero;
+    qreal deriv040=zero;
+    qreal deriv004=zero;
+    qreal deriv310=zero;
+    qreal deriv301=zero;
+    qreal deriv130=zero;
+    qreal deriv031=zero;
+    qreal deriv103=zero;
+    qreal deriv013=zero;
+    qreal deriv220=zero;
+    qreal deriv202=zero;
+    qreal deriv022=zero;
+    qreal deriv211=zero;
+    qreal deriv121=zero;
+    qreal deriv112=zero;
     for( qint64 m=0 ; m < m_nmo ; ++m )
     {
       deriv300+=(m_occno(m)*( 6*m_cdg100(m)*m_cdg200(m)+2*m_cdg000(m)*m_cdg300(m) ));
@@ -1083,1244 +1484,97 @@ namespace QtPlugins {
       deriv102+=(m_occno(m)*( 2*(m_cdg002(m)*m_cdg100(m)+2*m_cdg001(m)*m_cdg101(m)+m_cdg000(m)*m_cdg102(m)) ));
       deriv012+=(m_occno(m)*( 2*(m_cdg002(m)*m_cdg010(m)+2*m_cdg001(m)*m_cdg011(m)+m_cdg000(m)*m_cdg012(m)) ));
       // deriv111+=(m_occno(m)*( 2*(m_cdg011(m)*m_cdg100(m)+m_cdg010(m)*m_cdg101(m)+m_cdg001(m)*m_cdg110(m)+m_cdg000(m)*m_cdg111(m)) ));
+      deriv400+=(m_occno(m)*(6*ipow(m_cdg200(m),2)+8*m_cdg100(m)*m_cdg300(m)+2*m_cdg000(m)*m_cdg400(m)));
+      deriv040+=(m_occno(m)*(6*ipow(m_cdg020(m),2)+8*m_cdg010(m)*m_cdg030(m)+2*m_cdg000(m)*m_cdg040(m)));
+      deriv004+=(m_occno(m)*(6*ipow(m_cdg002(m),2)+8*m_cdg001(m)*m_cdg003(m)+2*m_cdg000(m)*m_cdg004(m)));
+      deriv310+=(m_occno(m)*(2*(3*m_cdg110(m)*m_cdg200(m)+3*m_cdg100(m)*m_cdg210(m)+m_cdg010(m)*m_cdg300(m)+m_cdg000(m)*m_cdg310(m))));
+      deriv301+=(m_occno(m)*(2*(3*m_cdg101(m)*m_cdg200(m)+3*m_cdg100(m)*m_cdg201(m)+m_cdg001(m)*m_cdg300(m)+m_cdg000(m)*m_cdg301(m))));
+      deriv130+=(m_occno(m)*(2*(m_cdg030(m)*m_cdg100(m)+3*m_cdg020(m)*m_cdg110(m)+3*m_cdg010(m)*m_cdg120(m)+m_cdg000(m)*m_cdg130(m))));
+      deriv031+=(m_occno(m)*(2*(3*m_cdg011(m)*m_cdg020(m)+3*m_cdg010(m)*m_cdg021(m)+m_cdg001(m)*m_cdg030(m)+m_cdg000(m)*m_cdg031(m))));
+      deriv103+=(m_occno(m)*(2*(m_cdg003(m)*m_cdg100(m)+3*m_cdg002(m)*m_cdg101(m)+3*m_cdg001(m)*m_cdg102(m)+m_cdg000(m)*m_cdg103(m))));
+      deriv013+=(m_occno(m)*(2*(m_cdg003(m)*m_cdg010(m)+3*m_cdg002(m)*m_cdg011(m)+3*m_cdg001(m)*m_cdg012(m)+m_cdg000(m)*m_cdg013(m))));
+      deriv220+=(m_occno(m)*(2*(2*ipow(m_cdg110(m),2)+2*m_cdg100(m)*m_cdg120(m)+m_cdg020(m)*m_cdg200(m)+2*m_cdg010(m)*m_cdg210(m)+m_cdg000(m)*m_cdg220(m))));
+      deriv202+=(m_occno(m)*(2*(2*ipow(m_cdg101(m),2)+2*m_cdg100(m)*m_cdg102(m)+m_cdg002(m)*m_cdg200(m)+2*m_cdg001(m)*m_cdg201(m)+m_cdg000(m)*m_cdg202(m))));
+      deriv022+=(m_occno(m)*(2*(2*ipow(m_cdg011(m),2)+2*m_cdg010(m)*m_cdg012(m)+m_cdg002(m)*m_cdg020(m)+2*m_cdg001(m)*m_cdg021(m)+m_cdg000(m)*m_cdg022(m))));
+      deriv211+=(m_occno(m)*(2*(2*m_cdg101(m)*m_cdg110(m)+2*m_cdg100(m)*m_cdg111(m)+m_cdg011(m)*m_cdg200(m)+m_cdg010(m)*m_cdg201(m)+m_cdg001(m)*m_cdg210(m)+m_cdg000(m)*m_cdg211(m))));
+      deriv121+=(m_occno(m)*(2*(m_cdg021(m)*m_cdg100(m)+m_cdg020(m)*m_cdg101(m)+2*m_cdg011(m)*m_cdg110(m)+2*m_cdg010(m)*m_cdg111(m)+m_cdg001(m)*m_cdg120(m)+m_cdg000(m)*m_cdg121(m))));
+      deriv112+=(m_occno(m)*(2*(m_cdg012(m)*m_cdg100(m)+2*m_cdg011(m)*m_cdg101(m)+m_cdg010(m)*m_cdg102(m)+m_cdg002(m)*m_cdg110(m)+2*m_cdg001(m)*m_cdg111(m)+m_cdg000(m)*m_cdg112(m))));
     }
 
-    value(0)=deriv300+deriv120+deriv102;
-    value(1)=deriv210+deriv030+deriv012;
-    value(2)=deriv201+deriv021+deriv003;
+    gValue(0)=deriv300+deriv120+deriv102;
+    gValue(1)=deriv210+deriv030+deriv012;
+    gValue(2)=deriv201+deriv021+deriv003;
+
+    hValue(0,0)=deriv400+deriv220+deriv202;
+    hValue(1,1)=deriv220+deriv040+deriv022;
+    hValue(2,2)=deriv202+deriv022+deriv004;
+    hValue(0,1)=deriv310+deriv130+deriv112;
+    hValue(0,2)=deriv301+deriv121+deriv103;
+    hValue(1,2)=deriv211+deriv031+deriv013;
+    hValue(1,0)=hValue(0,1);
+    hValue(2,0)=hValue(0,2);
+    hValue(2,1)=hValue(1,2);
+
+    value(0,0) = gValue(0);
+    value(1,0) = gValue(1);
+    value(2,0) = gValue(2);
+    value(0,1) = hValue(0,0);
+    value(1,1) = hValue(1,0);
+    value(2,1) = hValue(2,0);
+    value(0,2) = hValue(0,1);
+    value(1,2) = hValue(1,1);
+    value(2,2) = hValue(2,1);
+    value(0,3) = hValue(0,2);
+    value(1,3) = hValue(1,2);
+    value(2,3) = hValue(2,2);
 
     return value;
 
   }
 
-  const Matrix<qreal,3,3> QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian( const Matrix<qreal,3,1> xyz )
+  qreal QTAIMWavefunctionEvaluator::kineticEnergyDensityG(Matrix<qreal,3,1> xyz)
   {
 
-    Matrix<qreal,3,3> value;
-
-    const qreal zero=0.0;
-    const qreal one =1.0;
+    qreal value;
 
-    m_cdg000.setZero();
-    m_cdg100.setZero();
-    m_cdg010.setZero();
-    m_cdg001.setZero();
-    m_cdg200.setZero();
-    m_cdg020.setZero();
-    m_cdg002.setZero();
-    m_cdg110.setZero();
-    m_cdg101.setZero();
-    m_cdg011.setZero();
-    m_cdg300.setZero();
-    m_cdg120.setZero();
-    m_cdg102.setZero();
-    m_cdg210.setZero();
-    m_cdg030.setZero();
-    m_cdg012.setZero();
-    m_cdg201.setZero();
-    m_cdg021.setZero();
-    m_cdg003.setZero();
-    m_cdg111.setZero();
-    m_cdg400.setZero();
-    m_cdg040.setZero();
-    m_cdg004.setZero();
-    m_cdg310.setZero();
-    m_cdg301.setZero();
-    m_cdg130.setZero();
-    m_cdg031.setZero();
-    m_cdg103.setZero();
-    m_cdg013.setZero();
-    m_cdg220.setZero();
-    m_cdg202.setZero();
-    m_cdg022.setZero();
-    m_cdg211.setZero();
-    m_cdg121.setZero();
-    m_cdg112.setZero();
+    evaluatePrimitives(xyz,1);
+    contractPrimitives(1);
 
-    for( qint64 p=0 ; p < m_nprim ; ++p )
+    value=0.0;
+    for( qint64 m=0 ; m < m_nmo ; ++m )
     {
-      qreal xx0 = xyz(0) - m_X0(p);
-      qreal yy0 = xyz(1) - m_Y0(p);
-      qreal zz0 = xyz(2) - m_Z0(p);
+      value += (0.5)*(m_occno(m)*(ipow(m_cdg100(m),2)+ipow(m_cdg010(m),2)+ipow(m_cdg001(m),2)));
+    }
 
-      qreal b0arg = -m_alpha(p)*(xx0*xx0 + yy0*yy0 + zz0*zz0 );
+    return value;
 
-      if( b0arg > m_cutoff )
-      {
-        qint64 aax0=1;
-        qint64 aay0=1;
-        qint64 aaz0=1;
-        qint64 aax1=m_xamom(p);
-        qint64 aay1=m_yamom(p);
-        qint64 aaz1=m_zamom(p);
-        qint64 aax2=m_xamom(p)*(m_xamom(p)-1);
-        qint64 aay2=m_yamom(p)*(m_yamom(p)-1);
-        qint64 aaz2=m_zamom(p)*(m_zamom(p)-1);
-        qint64 aax3=m_xamom(p)*(m_xamom(p)-1)*(m_xamom(p)-2);
-        qint64 aay3=m_yamom(p)*(m_yamom(p)-1)*(m_yamom(p)-2);
-        qint64 aaz3=m_zamom(p)*(m_zamom(p)-1)*(m_zamom(p)-2);
-        qint64 aax4=m_xamom(p)*(m_xamom(p)-1)*(m_xamom(p)-2)*(m_xamom(p)-3);
-        qint64 aay4=m_yamom(p)*(m_yamom(p)-1)*(m_yamom(p)-2)*(m_xamom(p)-3);
-        qint64 aaz4=m_zamom(p)*(m_zamom(p)-1)*(m_zamom(p)-2)*(m_xamom(p)-3);
+  }
 
-        qreal ax0 = aax0*ipow( xx0, m_xamom(p) );
-        qreal ay0 = aay0*ipow( yy0, m_yamom(p) );
-        qreal az0 = aaz0*ipow( zz0, m_zamom(p) );
+  qreal QTAIMWavefunctionEvaluator::kineticEnergyDensityK( const Matrix<qreal,3,1> xyz )
+  {
 
-        qreal ax1;
-        qreal ay1;
-        qreal az1;
-        if     ( m_xamom(p) <  1 )
-        {
-          ax1=zero;
-        }
-        else if( m_xamom(p) == 1 )
-        {
-          ax1=one;
-        }
-        else
-        {
-          ax1=aax1*ipow(xx0,m_xamom(p)-1);
-        }
+    qreal value;
 
-        if     ( m_yamom(p) <  1 )
-        {
-          ay1=zero;
-        }
-        else if( m_yamom(p) == 1 )
-        {
-          ay1=one;
-        }
-        else
-        {
-          ay1=aay1*ipow(yy0,m_yamom(p)-1);
-        }
+    evaluatePrimitives(xyz,2);
+    contractPrimitives(2);
 
-        if     ( m_zamom(p) <  1 )
-        {
-          az1=zero;
-        }
-        else if( m_zamom(p) == 1 )
-        {
-          az1=one;
-        }
-        else
-        {
-          az1=aaz1*ipow(zz0,m_zamom(p)-1);
-        }
+    value=0.0;
+    for( qint64 m=0 ; m < m_nmo ; ++m )
+    {
+      value += (0.25)*(m_occno(m)*(2*m_cdg000(m)*(m_cdg200(m)+m_cdg020(m)+m_cdg002(m))));
+    }
 
-        qreal ax2;
-        qreal ay2;
-        qreal az2;
-        if     ( m_xamom(p) <  2 )
-        {
-          ax2=zero;
-        }
-        else if( m_xamom(p) == 2 )
-        {
-          ax2=one;
-        }
-        else
-        {
-          ax2=aax2*ipow(xx0,m_xamom(p)-2);
-        }
+    return value;
 
-        if     ( m_yamom(p) <  2 )
-        {
-          ay2=zero;
-        }
-        else if( m_yamom(p) == 2 )
-        {
-          ay2=one;
-        }
-        else
-        {
-          ay2=aay2*ipow(yy0,m_yamom(p)-2);
-        }
+  }
 
-        if     ( m_zamom(p) <  2 )
-        {
-          az2=zero;
-        }
-        else if( m_zamom(p) == 2 )
-        {
-          az2=one;
-        }
-        else
-        {
-          az2=aaz2*ipow(zz0,m_zamom(p)-2);
-        }
-
-        qreal ax3;
-        qreal ay3;
-        qreal az3;
-        if     ( m_xamom(p) <  3 )
-        {
-          ax3=zero;
-        }
-        else if( m_xamom(p) == 3 )
-        {
-          ax3=one;
-        }
-        else
-        {
-          ax3=aax3*ipow(xx0,m_xamom(p)-3);
-        }
-
-        if     ( m_yamom(p) <  3 )
-        {
-          ay3=zero;
-        }
-        else if( m_yamom(p) == 3 )
-        {
-          ay3=one;
-        }
-        else
-        {
-          ay3=aay3*ipow(yy0,m_yamom(p)-3);
-        }
-
-        if     ( m_zamom(p) <  3 )
-        {
-          az3=zero;
-        }
-        else if( m_zamom(p) == 3 )
-        {
-          az3=one;
-        }
-        else
-        {
-          az3=aaz3*ipow(zz0,m_zamom(p)-3);
-        }
-
-        qreal ax4;
-        qreal ay4;
-        qreal az4;
-        if     ( m_xamom(p) <  4 )
-        {
-          ax4=zero;
-        }
-        else if( m_xamom(p) == 4 )
-        {
-          ax4=one;
-        }
-        else
-        {
-          ax4=aax4*ipow(xx0,m_xamom(p)-4);
-        }
-
-        if     ( m_yamom(p) <  4 )
-        {
-          ay4=zero;
-        }
-        else if( m_yamom(p) == 4 )
-        {
-          ay4=one;
-        }
-        else
-        {
-          ay4=aay4*ipow(yy0,m_yamom(p)-4);
-        }
-
-        if     ( m_zamom(p) <  4 )
-        {
-          az4=zero;
-        }
-        else if( m_zamom(p) == 4 )
-        {
-          az4=one;
-        }
-        else
-        {
-          az4=aaz4*ipow(zz0,m_zamom(p)-4);
-        }
-
-        qreal b0 = exp(b0arg);
-
-        qreal bx1 = -2*m_alpha(p)*xx0;
-        qreal by1 = -2*m_alpha(p)*yy0;
-        qreal bz1 = -2*m_alpha(p)*zz0;
-        qreal bx2 = -2*m_alpha(p) + 4*(ipow(m_alpha(p),2) * ipow(xx0,2));
-        qreal by2 = -2*m_alpha(p) + 4*(ipow(m_alpha(p),2) * ipow(yy0,2));
-        qreal bz2 = -2*m_alpha(p) + 4*(ipow(m_alpha(p),2) * ipow(zz0,2));
-        qreal bx3 = (12*ipow(m_alpha(p),2)*xx0)-(8*ipow(m_alpha(p),3) * ipow(xx0,3));
-        qreal by3 = (12*ipow(m_alpha(p),2)*yy0)-(8*ipow(m_alpha(p),3) * ipow(yy0,3));
-        qreal bz3 = (12*ipow(m_alpha(p),2)*zz0)-(8*ipow(m_alpha(p),3) * ipow(zz0,3));
-        qreal bx4 = (12*ipow(m_alpha(p),2))-(48*ipow(m_alpha(p),3) * ipow(xx0,2))+(16*ipow(m_alpha(p),4) * ipow(xx0,4));
-        qreal by4 = (12*ipow(m_alpha(p),2))-(48*ipow(m_alpha(p),3) * ipow(yy0,2))+(16*ipow(m_alpha(p),4) * ipow(yy0,4));
-        qreal bz4 = (12*ipow(m_alpha(p),2))-(48*ipow(m_alpha(p),3) * ipow(zz0,2))+(16*ipow(m_alpha(p),4) * ipow(zz0,4));
-
-        qreal dg000 = ax0*ay0*az0*b0;
-        qreal dg100 = ay0*az0*b0*(ax1+ax0*bx1);
-        qreal dg010 = ax0*az0*b0*(ay1+ay0*by1);
-        qreal dg001 = ax0*ay0*b0*(az1+az0*bz1);
-        qreal dg200 = ay0*az0*b0*(ax2+2*ax1*bx1+ax0*bx2);
-        qreal dg020 = ax0*az0*b0*(ay2+2*ay1*by1+ay0*by2);
-        qreal dg002 = ax0*ay0*b0*(az2+2*az1*bz1+az0*bz2);
-        qreal dg110 = az0*b0*(ax1+ax0*bx1)*(ay1+ay0*by1);
-        qreal dg101 = ay0*b0*(ax1+ax0*bx1)*(az1+az0*bz1);
-        qreal dg011 = ax0*b0*(ay1+ay0*by1)*(az1+az0*bz1);
-        qreal dg300 = ay0*az0*b0*(ax3+3*ax2*bx1+3*ax1*bx2+ax0*bx3);
-        qreal dg030 = ax0*az0*b0*(ay3+3*ay2*by1+3*ay1*by2+ay0*by3);
-        qreal dg003 = ax0*ay0*b0*(az3+3*az2*bz1+3*az1*bz2+az0*bz3);
-        qreal dg210 = az0*b0*(ax2+2*ax1*bx1+ax0*bx2)*(ay1+ay0*by1);
-        qreal dg201 = ay0*b0*(ax2+2*ax1*bx1+ax0*bx2)*(az1+az0*bz1);
-        qreal dg120 = az0*b0*(ax1+ax0*bx1)*(ay2+2*ay1*by1+ay0*by2);
-        qreal dg021 = ax0*b0*(ay2+2*ay1*by1+ay0*by2)*(az1+az0*bz1);
-        qreal dg102 = ay0*b0*(ax1+ax0*bx1)*(az2+2*az1*bz1+az0*bz2);
-        qreal dg012 = ax0*b0*(ay1+ay0*by1)*(az2+2*az1*bz1+az0*bz2);
-        qreal dg111 = b0*(ax1+ax0*bx1)*(ay1+ay0*by1)*(az1+az0*bz1);
-        qreal dg400 = ay0*az0*b0*(ax4+4*ax3*bx1+6*ax2*bx2+4*ax1*bx3+ax0*bx4);
-        qreal dg040 = ax0*az0*b0*(ay4+4*ay3*by1+6*ay2*by2+4*ay1*by3+ay0*by4);
-        qreal dg004 = ax0*ay0*b0*(az4+4*az3*bz1+6*az2*bz2+4*az1*bz3+az0*bz4);
-        qreal dg310 = az0*b0*(ax3+3*ax2*bx1+3*ax1*bx2+ax0*bx3)*(ay1+ay0*by1);
-        qreal dg301 = ay0*b0*(ax3+3*ax2*bx1+3*ax1*bx2+ax0*bx3)*(az1+az0*bz1);
-        qreal dg130 = az0*b0*(ax1+ax0*bx1)*(ay3+3*ay2*by1+3*ay1*by2+ay0*by3);
-        qreal dg031 = ax0*b0*(ay3+3*ay2*by1+3*ay1*by2+ay0*by3)*(az1+az0*bz1);
-        qreal dg103 = ay0*b0*(ax1+ax0*bx1)*(az3+3*az2*bz1+3*az1*bz2+az0*bz3);
-        qreal dg013 = ax0*b0*(ay1+ay0*by1)*(az3+3*az2*bz1+3*az1*bz2+az0*bz3);
-        qreal dg220 = az0*b0*(ax2+2*ax1*bx1+ax0*bx2)*(ay2+2*ay1*by1+ay0*by2);
-        qreal dg202 = ay0*b0*(ax2+2*ax1*bx1+ax0*bx2)*(az2+2*az1*bz1+az0*bz2);
-        qreal dg022 = ax0*b0*(ay2+2*ay1*by1+ay0*by2)*(az2+2*az1*bz1+az0*bz2);
-        qreal dg211 = b0*(ax2+2*ax1*bx1+ax0*bx2)*(ay1+ay0*by1)*(az1+az0*bz1);
-        qreal dg121 = b0*(ax1+ax0*bx1)*(ay2+2*ay1*by1+ay0*by2)*(az1+az0*bz1);
-        qreal dg112 = b0*(ax1+ax0*bx1)*(ay1+ay0*by1)*(az2+2*az1*bz1+az0*bz2);
-
-        for( qint64 m=0 ; m < m_nmo ; ++m )
-        {
-          m_cdg000(m) += m_coef(m,p) * dg000;
-          m_cdg100(m) += m_coef(m,p) * dg100;
-          m_cdg010(m) += m_coef(m,p) * dg010;
-          m_cdg001(m) += m_coef(m,p) * dg001;
-          m_cdg200(m) += m_coef(m,p) * dg200;
-          m_cdg020(m) += m_coef(m,p) * dg020;
-          m_cdg002(m) += m_coef(m,p) * dg002;
-          m_cdg110(m) += m_coef(m,p) * dg110;
-          m_cdg101(m) += m_coef(m,p) * dg101;
-          m_cdg011(m) += m_coef(m,p) * dg011;
-          m_cdg300(m) += m_coef(m,p) * dg300;
-          m_cdg030(m) += m_coef(m,p) * dg030;
-          m_cdg003(m) += m_coef(m,p) * dg003;
-          m_cdg210(m) += m_coef(m,p) * dg210;
-          m_cdg201(m) += m_coef(m,p) * dg201;
-          m_cdg120(m) += m_coef(m,p) * dg120;
-          m_cdg021(m) += m_coef(m,p) * dg021;
-          m_cdg102(m) += m_coef(m,p) * dg102;
-          m_cdg012(m) += m_coef(m,p) * dg012;
-          m_cdg111(m) += m_coef(m,p) * dg111;
-          m_cdg400(m) += m_coef(m,p) * dg400;
-          m_cdg040(m) += m_coef(m,p) * dg040;
-          m_cdg004(m) += m_coef(m,p) * dg004;
-          m_cdg310(m) += m_coef(m,p) * dg310;
-          m_cdg301(m) += m_coef(m,p) * dg301;
-          m_cdg130(m) += m_coef(m,p) * dg130;
-          m_cdg031(m) += m_coef(m,p) * dg031;
-          m_cdg103(m) += m_coef(m,p) * dg103;
-          m_cdg013(m) += m_coef(m,p) * dg013;
-          m_cdg220(m) += m_coef(m,p) * dg220;
-          m_cdg202(m) += m_coef(m,p) * dg202;
-          m_cdg022(m) += m_coef(m,p) * dg022;
-          m_cdg211(m) += m_coef(m,p) * dg211;
-          m_cdg121(m) += m_coef(m,p) * dg121;
-          m_cdg112(m) += m_coef(m,p) * dg112;
-        }
-
-      }
-    }
-
-    qreal deriv400=zero;
-    qreal deriv040=zero;
-    qreal deriv004=zero;
-    qreal deriv310=zero;
-    qreal deriv301=zero;
-    qreal deriv130=zero;
-    qreal deriv031=zero;
-    qreal deriv103=zero;
-    qreal deriv013=zero;
-    qreal deriv220=zero;
-    qreal deriv202=zero;
-    qreal deriv022=zero;
-    qreal deriv211=zero;
-    qreal deriv121=zero;
-    qreal deriv112=zero;
-    for( qint64 m=0 ; m < m_nmo ; ++m )
-    {
-      deriv400+=(m_occno(m)*(6*ipow(m_cdg200(m),2)+8*m_cdg100(m)*m_cdg300(m)+2*m_cdg000(m)*m_cdg400(m)));
-      deriv040+=(m_occno(m)*(6*ipow(m_cdg020(m),2)+8*m_cdg010(m)*m_cdg030(m)+2*m_cdg000(m)*m_cdg040(m)));
-      deriv004+=(m_occno(m)*(6*ipow(m_cdg002(m),2)+8*m_cdg001(m)*m_cdg003(m)+2*m_cdg000(m)*m_cdg004(m)));
-      deriv310+=(m_occno(m)*(2*(3*m_cdg110(m)*m_cdg200(m)+3*m_cdg100(m)*m_cdg210(m)+m_cdg010(m)*m_cdg300(m)+m_cdg000(m)*m_cdg310(m))));
-      deriv301+=(m_occno(m)*(2*(3*m_cdg101(m)*m_cdg200(m)+3*m_cdg100(m)*m_cdg201(m)+m_cdg001(m)*m_cdg300(m)+m_cdg000(m)*m_cdg301(m))));
-      deriv130+=(m_occno(m)*(2*(m_cdg030(m)*m_cdg100(m)+3*m_cdg020(m)*m_cdg110(m)+3*m_cdg010(m)*m_cdg120(m)+m_cdg000(m)*m_cdg130(m))));
-      deriv031+=(m_occno(m)*(2*(3*m_cdg011(m)*m_cdg020(m)+3*m_cdg010(m)*m_cdg021(m)+m_cdg001(m)*m_cdg030(m)+m_cdg000(m)*m_cdg031(m))));
-      deriv103+=(m_occno(m)*(2*(m_cdg003(m)*m_cdg100(m)+3*m_cdg002(m)*m_cdg101(m)+3*m_cdg001(m)*m_cdg102(m)+m_cdg000(m)*m_cdg103(m))));
-      deriv013+=(m_occno(m)*(2*(m_cdg003(m)*m_cdg010(m)+3*m_cdg002(m)*m_cdg011(m)+3*m_cdg001(m)*m_cdg012(m)+m_cdg000(m)*m_cdg013(m))));
-      deriv220+=(m_occno(m)*(2*(2*ipow(m_cdg110(m),2)+2*m_cdg100(m)*m_cdg120(m)+m_cdg020(m)*m_cdg200(m)+2*m_cdg010(m)*m_cdg210(m)+m_cdg000(m)*m_cdg220(m))));
-      deriv202+=(m_occno(m)*(2*(2*ipow(m_cdg101(m),2)+2*m_cdg100(m)*m_cdg102(m)+m_cdg002(m)*m_cdg200(m)+2*m_cdg001(m)*m_cdg201(m)+m_cdg000(m)*m_cdg202(m))));
-      deriv022+=(m_occno(m)*(2*(2*ipow(m_cdg011(m),2)+2*m_cdg010(m)*m_cdg012(m)+m_cdg002(m)*m_cdg020(m)+2*m_cdg001(m)*m_cdg021(m)+m_cdg000(m)*m_cdg022(m))));
-      deriv211+=(m_occno(m)*(2*(2*m_cdg101(m)*m_cdg110(m)+2*m_cdg100(m)*m_cdg111(m)+m_cdg011(m)*m_cdg200(m)+m_cdg010(m)*m_cdg201(m)+m_cdg001(m)*m_cdg210(m)+m_cdg000(m)*m_cdg211(m))));
-      deriv121+=(m_occno(m)*(2*(m_cdg021(m)*m_cdg100(m)+m_cdg020(m)*m_cdg101(m)+2*m_cdg011(m)*m_cdg110(m)+2*m_cdg010(m)*m_cdg111(m)+m_cdg001(m)*m_cdg120(m)+m_cdg000(m)*m_cdg121(m))));
-      deriv112+=(m_occno(m)*(2*(m_cdg012(m)*m_cdg100(m)+2*m_cdg011(m)*m_cdg101(m)+m_cdg010(m)*m_cdg102(m)+m_cdg002(m)*m_cdg110(m)+2*m_cdg001(m)*m_cdg111(m)+m_cdg000(m)*m_cdg112(m))));
-    }
-
-    value(0,0)=deriv400+deriv220+deriv202;
-    value(1,1)=deriv220+deriv040+deriv022;
-    value(2,2)=deriv202+deriv022+deriv004;
-    value(0,1)=deriv310+deriv130+deriv112;
-    value(0,2)=deriv301+deriv121+deriv103;
-    value(1,2)=deriv211+deriv031+deriv013;
-    value(1,0)=value(0,1);
-    value(2,0)=value(0,2);
-    value(2,1)=value(1,2);
-
-    return value;
-
-  }
-
-  const Matrix<qreal,3,4> QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian( const Matrix<qreal,3,1> xyz )
-  {
-
-    Matrix<qreal,3,1> gValue;
-    Matrix<qreal,3,3> hValue;
-    Matrix<qreal,3,4> value;
-
-    const qreal zero=0.0;
-    const qreal one =1.0;
-
-    m_cdg000.setZero();
-    m_cdg100.setZero();
-    m_cdg010.setZero();
-    m_cdg001.setZero();
-    m_cdg200.setZero();
-    m_cdg020.setZero();
-    m_cdg002.setZero();
-    m_cdg110.setZero();
-    m_cdg101.setZero();
-    m_cdg011.setZero();
-    m_cdg300.setZero();
-    m_cdg120.setZero();
-    m_cdg102.setZero();
-    m_cdg210.setZero();
-    m_cdg030.setZero();
-    m_cdg012.setZero();
-    m_cdg201.setZero();
-    m_cdg021.setZero();
-    m_cdg003.setZero();
-    m_cdg111.setZero();
-    m_cdg400.setZero();
-    m_cdg040.setZero();
-    m_cdg004.setZero();
-    m_cdg310.setZero();
-    m_cdg301.setZero();
-    m_cdg130.setZero();
-    m_cdg031.setZero();
-    m_cdg103.setZero();
-    m_cdg013.setZero();
-    m_cdg220.setZero();
-    m_cdg202.setZero();
-    m_cdg022.setZero();
-    m_cdg211.setZero();
-    m_cdg121.setZero();
-    m_cdg112.setZero();
-
-    for( qint64 p=0 ; p < m_nprim ; ++p )
-    {
-      qreal xx0 = xyz(0) - m_X0(p);
-      qreal yy0 = xyz(1) - m_Y0(p);
-      qreal zz0 = xyz(2) - m_Z0(p);
-
-      qreal b0arg = -m_alpha(p)*(xx0*xx0 + yy0*yy0 + zz0*zz0 );
-
-      if( b0arg > m_cutoff )
-      {
-        qint64 aax0=1;
-        qint64 aay0=1;
-        qint64 aaz0=1;
-        qint64 aax1=m_xamom(p);
-        qint64 aay1=m_yamom(p);
-        qint64 aaz1=m_zamom(p);
-        qint64 aax2=m_xamom(p)*(m_xamom(p)-1);
-        qint64 aay2=m_yamom(p)*(m_yamom(p)-1);
-        qint64 aaz2=m_zamom(p)*(m_zamom(p)-1);
-        qint64 aax3=m_xamom(p)*(m_xamom(p)-1)*(m_xamom(p)-2);
-        qint64 aay3=m_yamom(p)*(m_yamom(p)-1)*(m_yamom(p)-2);
-        qint64 aaz3=m_zamom(p)*(m_zamom(p)-1)*(m_zamom(p)-2);
-        qint64 aax4=m_xamom(p)*(m_xamom(p)-1)*(m_xamom(p)-2)*(m_xamom(p)-3);
-        qint64 aay4=m_yamom(p)*(m_yamom(p)-1)*(m_yamom(p)-2)*(m_xamom(p)-3);
-        qint64 aaz4=m_zamom(p)*(m_zamom(p)-1)*(m_zamom(p)-2)*(m_xamom(p)-3);
-
-        qreal ax0 = aax0*ipow( xx0, m_xamom(p) );
-        qreal ay0 = aay0*ipow( yy0, m_yamom(p) );
-        qreal az0 = aaz0*ipow( zz0, m_zamom(p) );
-
-        qreal ax1;
-        qreal ay1;
-        qreal az1;
-        if     ( m_xamom(p) <  1 )
-        {
-          ax1=zero;
-        }
-        else if( m_xamom(p) == 1 )
-        {
-          ax1=one;
-        }
-        else
-        {
-          ax1=aax1*ipow(xx0,m_xamom(p)-1);
-        }
-
-        if     ( m_yamom(p) <  1 )
-        {
-          ay1=zero;
-        }
-        else if( m_yamom(p) == 1 )
-        {
-          ay1=one;
-        }
-        else
-        {
-          ay1=aay1*ipow(yy0,m_yamom(p)-1);
-        }
-
-        if     ( m_zamom(p) <  1 )
-        {
-          az1=zero;
-        }
-        else if( m_zamom(p) == 1 )
-        {
-          az1=one;
-        }
-        else
-        {
-          az1=aaz1*ipow(zz0,m_zamom(p)-1);
-        }
-
-        qreal ax2;
-        qreal ay2;
-        qreal az2;
-        if     ( m_xamom(p) <  2 )
-        {
-          ax2=zero;
-        }
-        else if( m_xamom(p) == 2 )
-        {
-          ax2=one;
-        }
-        else
-        {
-          ax2=aax2*ipow(xx0,m_xamom(p)-2);
-        }
-
-        if     ( m_yamom(p) <  2 )
-        {
-          ay2=zero;
-        }
-        else if( m_yamom(p) == 2 )
-        {
-          ay2=one;
-        }
-        else
-        {
-          ay2=aay2*ipow(yy0,m_yamom(p)-2);
-        }
-
-        if     ( m_zamom(p) <  2 )
-        {
-          az2=zero;
-        }
-        else if( m_zamom(p) == 2 )
-        {
-          az2=one;
-        }
-        else
-        {
-          az2=aaz2*ipow(zz0,m_zamom(p)-2);
-        }
-
-        qreal ax3;
-        qreal ay3;
-        qreal az3;
-        if     ( m_xamom(p) <  3 )
-        {
-          ax3=zero;
-        }
-        else if( m_xamom(p) == 3 )
-        {
-          ax3=one;
-        }
-        else
-        {
-          ax3=aax3*ipow(xx0,m_xamom(p)-3);
-        }
-
-        if     ( m_yamom(p) <  3 )
-        {
-          ay3=zero;
-        }
-        else if( m_yamom(p) == 3 )
-        {
-          ay3=one;
-        }
-        else
-        {
-          ay3=aay3*ipow(yy0,m_yamom(p)-3);
-        }
-
-        if     ( m_zamom(p) <  3 )
-        {
-          az3=zero;
-        }
-        else if( m_zamom(p) == 3 )
-        {
-          az3=one;
-        }
-        else
-        {
-          az3=aaz3*ipow(zz0,m_zamom(p)-3);
-        }
-
-        qreal ax4;
-        qreal ay4;
-        qreal az4;
-        if     ( m_xamom(p) <  4 )
-        {
-          ax4=zero;
-        }
-        else if( m_xamom(p) == 4 )
-        {
-          ax4=one;
-        }
-        else
-        {
-          ax4=aax4*ipow(xx0,m_xamom(p)-4);
-        }
-
-        if     ( m_yamom(p) <  4 )
-        {
-          ay4=zero;
-        }
-        else if( m_yamom(p) == 4 )
-        {
-          ay4=one;
-        }
-        else
-        {
-          ay4=aay4*ipow(yy0,m_yamom(p)-4);
-        }
-
-        if     ( m_zamom(p) <  4 )
-        {
-          az4=zero;
-        }
-        else if( m_zamom(p) == 4 )
-        {
-          az4=one;
-        }
-        else
-        {
-          az4=aaz4*ipow(zz0,m_zamom(p)-4);
-        }
-
-        qreal b0 = exp(b0arg);
-
-        qreal bx1 = -2*m_alpha(p)*xx0;
-        qreal by1 = -2*m_alpha(p)*yy0;
-        qreal bz1 = -2*m_alpha(p)*zz0;
-        qreal bx2 = -2*m_alpha(p) + 4*(ipow(m_alpha(p),2) * ipow(xx0,2));
-        qreal by2 = -2*m_alpha(p) + 4*(ipow(m_alpha(p),2) * ipow(yy0,2));
-        qreal bz2 = -2*m_alpha(p) + 4*(ipow(m_alpha(p),2) * ipow(zz0,2));
-        qreal bx3 = (12*ipow(m_alpha(p),2)*xx0)-(8*ipow(m_alpha(p),3) * ipow(xx0,3));
-        qreal by3 = (12*ipow(m_alpha(p),2)*yy0)-(8*ipow(m_alpha(p),3) * ipow(yy0,3));
-        qreal bz3 = (12*ipow(m_alpha(p),2)*zz0)-(8*ipow(m_alpha(p),3) * ipow(zz0,3));
-        qreal bx4 = (12*ipow(m_alpha(p),2))-(48*ipow(m_alpha(p),3) * ipow(xx0,2))+(16*ipow(m_alpha(p),4) * ipow(xx0,4));
-        qreal by4 = (12*ipow(m_alpha(p),2))-(48*ipow(m_alpha(p),3) * ipow(yy0,2))+(16*ipow(m_alpha(p),4) * ipow(yy0,4));
-        qreal bz4 = (12*ipow(m_alpha(p),2))-(48*ipow(m_alpha(p),3) * ipow(zz0,2))+(16*ipow(m_alpha(p),4) * ipow(zz0,4));
-
-        qreal dg000 = ax0*ay0*az0*b0;
-        qreal dg100 = ay0*az0*b0*(ax1+ax0*bx1);
-        qreal dg010 = ax0*az0*b0*(ay1+ay0*by1);
-        qreal dg001 = ax0*ay0*b0*(az1+az0*bz1);
-        qreal dg200 = ay0*az0*b0*(ax2+2*ax1*bx1+ax0*bx2);
-        qreal dg020 = ax0*az0*b0*(ay2+2*ay1*by1+ay0*by2);
-        qreal dg002 = ax0*ay0*b0*(az2+2*az1*bz1+az0*bz2);
-        qreal dg110 = az0*b0*(ax1+ax0*bx1)*(ay1+ay0*by1);
-        qreal dg101 = ay0*b0*(ax1+ax0*bx1)*(az1+az0*bz1);
-        qreal dg011 = ax0*b0*(ay1+ay0*by1)*(az1+az0*bz1);
-        qreal dg300 = ay0*az0*b0*(ax3+3*ax2*bx1+3*ax1*bx2+ax0*bx3);
-        qreal dg030 = ax0*az0*b0*(ay3+3*ay2*by1+3*ay1*by2+ay0*by3);
-        qreal dg003 = ax0*ay0*b0*(az3+3*az2*bz1+3*az1*bz2+az0*bz3);
-        qreal dg210 = az0*b0*(ax2+2*ax1*bx1+ax0*bx2)*(ay1+ay0*by1);
-        qreal dg201 = ay0*b0*(ax2+2*ax1*bx1+ax0*bx2)*(az1+az0*bz1);
-        qreal dg120 = az0*b0*(ax1+ax0*bx1)*(ay2+2*ay1*by1+ay0*by2);
-        qreal dg021 = ax0*b0*(ay2+2*ay1*by1+ay0*by2)*(az1+az0*bz1);
-        qreal dg102 = ay0*b0*(ax1+ax0*bx1)*(az2+2*az1*bz1+az0*bz2);
-        qreal dg012 = ax0*b0*(ay1+ay0*by1)*(az2+2*az1*bz1+az0*bz2);
-        qreal dg111 = b0*(ax1+ax0*bx1)*(ay1+ay0*by1)*(az1+az0*bz1);
-        qreal dg400 = ay0*az0*b0*(ax4+4*ax3*bx1+6*ax2*bx2+4*ax1*bx3+ax0*bx4);
-        qreal dg040 = ax0*az0*b0*(ay4+4*ay3*by1+6*ay2*by2+4*ay1*by3+ay0*by4);
-        qreal dg004 = ax0*ay0*b0*(az4+4*az3*bz1+6*az2*bz2+4*az1*bz3+az0*bz4);
-        qreal dg310 = az0*b0*(ax3+3*ax2*bx1+3*ax1*bx2+ax0*bx3)*(ay1+ay0*by1);
-        qreal dg301 = ay0*b0*(ax3+3*ax2*bx1+3*ax1*bx2+ax0*bx3)*(az1+az0*bz1);
-        qreal dg130 = az0*b0*(ax1+ax0*bx1)*(ay3+3*ay2*by1+3*ay1*by2+ay0*by3);
-        qreal dg031 = ax0*b0*(ay3+3*ay2*by1+3*ay1*by2+ay0*by3)*(az1+az0*bz1);
-        qreal dg103 = ay0*b0*(ax1+ax0*bx1)*(az3+3*az2*bz1+3*az1*bz2+az0*bz3);
-        qreal dg013 = ax0*b0*(ay1+ay0*by1)*(az3+3*az2*bz1+3*az1*bz2+az0*bz3);
-        qreal dg220 = az0*b0*(ax2+2*ax1*bx1+ax0*bx2)*(ay2+2*ay1*by1+ay0*by2);
-        qreal dg202 = ay0*b0*(ax2+2*ax1*bx1+ax0*bx2)*(az2+2*az1*bz1+az0*bz2);
-        qreal dg022 = ax0*b0*(ay2+2*ay1*by1+ay0*by2)*(az2+2*az1*bz1+az0*bz2);
-        qreal dg211 = b0*(ax2+2*ax1*bx1+ax0*bx2)*(ay1+ay0*by1)*(az1+az0*bz1);
-        qreal dg121 = b0*(ax1+ax0*bx1)*(ay2+2*ay1*by1+ay0*by2)*(az1+az0*bz1);
-        qreal dg112 = b0*(ax1+ax0*bx1)*(ay1+ay0*by1)*(az2+2*az1*bz1+az0*bz2);
-
-        for( qint64 m=0 ; m < m_nmo ; ++m )
-        {
-          m_cdg000(m) += m_coef(m,p) * dg000;
-          m_cdg100(m) += m_coef(m,p) * dg100;
-          m_cdg010(m) += m_coef(m,p) * dg010;
-          m_cdg001(m) += m_coef(m,p) * dg001;
-          m_cdg200(m) += m_coef(m,p) * dg200;
-          m_cdg020(m) += m_coef(m,p) * dg020;
-          m_cdg002(m) += m_coef(m,p) * dg002;
-          m_cdg110(m) += m_coef(m,p) * dg110;
-          m_cdg101(m) += m_coef(m,p) * dg101;
-          m_cdg011(m) += m_coef(m,p) * dg011;
-          m_cdg300(m) += m_coef(m,p) * dg300;
-          m_cdg030(m) += m_coef(m,p) * dg030;
-          m_cdg003(m) += m_coef(m,p) * dg003;
-          m_cdg210(m) += m_coef(m,p) * dg210;
-          m_cdg201(m) += m_coef(m,p) * dg201;
-          m_cdg120(m) += m_coef(m,p) * dg120;
-          m_cdg021(m) += m_coef(m,p) * dg021;
-          m_cdg102(m) += m_coef(m,p) * dg102;
-          m_cdg012(m) += m_coef(m,p) * dg012;
-          m_cdg111(m) += m_coef(m,p) * dg111;
-          m_cdg400(m) += m_coef(m,p) * dg400;
-          m_cdg040(m) += m_coef(m,p) * dg040;
-          m_cdg004(m) += m_coef(m,p) * dg004;
-          m_cdg310(m) += m_coef(m,p) * dg310;
-          m_cdg301(m) += m_coef(m,p) * dg301;
-          m_cdg130(m) += m_coef(m,p) * dg130;
-          m_cdg031(m) += m_coef(m,p) * dg031;
-          m_cdg103(m) += m_coef(m,p) * dg103;
-          m_cdg013(m) += m_coef(m,p) * dg013;
-          m_cdg220(m) += m_coef(m,p) * dg220;
-          m_cdg202(m) += m_coef(m,p) * dg202;
-          m_cdg022(m) += m_coef(m,p) * dg022;
-          m_cdg211(m) += m_coef(m,p) * dg211;
-          m_cdg121(m) += m_coef(m,p) * dg121;
-          m_cdg112(m) += m_coef(m,p) * dg112;
-        }
-
-      }
-    }
-
-    qreal deriv300=zero;
-    qreal deriv030=zero;
-    qreal deriv003=zero;
-    qreal deriv210=zero;
-    qreal deriv201=zero;
-    qreal deriv120=zero;
-    qreal deriv021=zero;
-    qreal deriv102=zero;
-    qreal deriv012=zero;
-    qreal deriv400=zero;
-    qreal deriv040=zero;
-    qreal deriv004=zero;
-    qreal deriv310=zero;
-    qreal deriv301=zero;
-    qreal deriv130=zero;
-    qreal deriv031=zero;
-    qreal deriv103=zero;
-    qreal deriv013=zero;
-    qreal deriv220=zero;
-    qreal deriv202=zero;
-    qreal deriv022=zero;
-    qreal deriv211=zero;
-    qreal deriv121=zero;
-    qreal deriv112=zero;
-    for( qint64 m=0 ; m < m_nmo ; ++m )
-    {
-      deriv300+=(m_occno(m)*( 6*m_cdg100(m)*m_cdg200(m)+2*m_cdg000(m)*m_cdg300(m) ));
-      deriv030+=(m_occno(m)*( 6*m_cdg010(m)*m_cdg020(m)+2*m_cdg000(m)*m_cdg030(m) ));
-      deriv003+=(m_occno(m)*( 6*m_cdg001(m)*m_cdg002(m)+2*m_cdg000(m)*m_cdg003(m) ));
-      deriv210+=(m_occno(m)*( 2*(2*m_cdg100(m)*m_cdg110(m)+m_cdg010(m)*m_cdg200(m)+m_cdg000(m)*m_cdg210(m)) ));
-      deriv201+=(m_occno(m)*( 2*(2*m_cdg100(m)*m_cdg101(m)+m_cdg001(m)*m_cdg200(m)+m_cdg000(m)*m_cdg201(m)) ));
-      deriv120+=(m_occno(m)*( 2*(m_cdg020(m)*m_cdg100(m)+2*m_cdg010(m)*m_cdg110(m)+m_cdg000(m)*m_cdg120(m)) ));
-      deriv021+=(m_occno(m)*( 2*(2*m_cdg010(m)*m_cdg011(m)+m_cdg001(m)*m_cdg020(m)+m_cdg000(m)*m_cdg021(m)) ));
-      deriv102+=(m_occno(m)*( 2*(m_cdg002(m)*m_cdg100(m)+2*m_cdg001(m)*m_cdg101(m)+m_cdg000(m)*m_cdg102(m)) ));
-      deriv012+=(m_occno(m)*( 2*(m_cdg002(m)*m_cdg010(m)+2*m_cdg001(m)*m_cdg011(m)+m_cdg000(m)*m_cdg012(m)) ));
-      // deriv111+=(m_occno(m)*( 2*(m_cdg011(m)*m_cdg100(m)+m_cdg010(m)*m_cdg101(m)+m_cdg001(m)*m_cdg110(m)+m_cdg000(m)*m_cdg111(m)) ));
-      deriv400+=(m_occno(m)*(6*ipow(m_cdg200(m),2)+8*m_cdg100(m)*m_cdg300(m)+2*m_cdg000(m)*m_cdg400(m)));
-      deriv040+=(m_occno(m)*(6*ipow(m_cdg020(m),2)+8*m_cdg010(m)*m_cdg030(m)+2*m_cdg000(m)*m_cdg040(m)));
-      deriv004+=(m_occno(m)*(6*ipow(m_cdg002(m),2)+8*m_cdg001(m)*m_cdg003(m)+2*m_cdg000(m)*m_cdg004(m)));
-      deriv310+=(m_occno(m)*(2*(3*m_cdg110(m)*m_cdg200(m)+3*m_cdg100(m)*m_cdg210(m)+m_cdg010(m)*m_cdg300(m)+m_cdg000(m)*m_cdg310(m))));
-      deriv301+=(m_occno(m)*(2*(3*m_cdg101(m)*m_cdg200(m)+3*m_cdg100(m)*m_cdg201(m)+m_cdg001(m)*m_cdg300(m)+m_cdg000(m)*m_cdg301(m))));
-      deriv130+=(m_occno(m)*(2*(m_cdg030(m)*m_cdg100(m)+3*m_cdg020(m)*m_cdg110(m)+3*m_cdg010(m)*m_cdg120(m)+m_cdg000(m)*m_cdg130(m))));
-      deriv031+=(m_occno(m)*(2*(3*m_cdg011(m)*m_cdg020(m)+3*m_cdg010(m)*m_cdg021(m)+m_cdg001(m)*m_cdg030(m)+m_cdg000(m)*m_cdg031(m))));
-      deriv103+=(m_occno(m)*(2*(m_cdg003(m)*m_cdg100(m)+3*m_cdg002(m)*m_cdg101(m)+3*m_cdg001(m)*m_cdg102(m)+m_cdg000(m)*m_cdg103(m))));
-      deriv013+=(m_occno(m)*(2*(m_cdg003(m)*m_cdg010(m)+3*m_cdg002(m)*m_cdg011(m)+3*m_cdg001(m)*m_cdg012(m)+m_cdg000(m)*m_cdg013(m))));
-      deriv220+=(m_occno(m)*(2*(2*ipow(m_cdg110(m),2)+2*m_cdg100(m)*m_cdg120(m)+m_cdg020(m)*m_cdg200(m)+2*m_cdg010(m)*m_cdg210(m)+m_cdg000(m)*m_cdg220(m))));
-      deriv202+=(m_occno(m)*(2*(2*ipow(m_cdg101(m),2)+2*m_cdg100(m)*m_cdg102(m)+m_cdg002(m)*m_cdg200(m)+2*m_cdg001(m)*m_cdg201(m)+m_cdg000(m)*m_cdg202(m))));
-      deriv022+=(m_occno(m)*(2*(2*ipow(m_cdg011(m),2)+2*m_cdg010(m)*m_cdg012(m)+m_cdg002(m)*m_cdg020(m)+2*m_cdg001(m)*m_cdg021(m)+m_cdg000(m)*m_cdg022(m))));
-      deriv211+=(m_occno(m)*(2*(2*m_cdg101(m)*m_cdg110(m)+2*m_cdg100(m)*m_cdg111(m)+m_cdg011(m)*m_cdg200(m)+m_cdg010(m)*m_cdg201(m)+m_cdg001(m)*m_cdg210(m)+m_cdg000(m)*m_cdg211(m))));
-      deriv121+=(m_occno(m)*(2*(m_cdg021(m)*m_cdg100(m)+m_cdg020(m)*m_cdg101(m)+2*m_cdg011(m)*m_cdg110(m)+2*m_cdg010(m)*m_cdg111(m)+m_cdg001(m)*m_cdg120(m)+m_cdg000(m)*m_cdg121(m))));
-      deriv112+=(m_occno(m)*(2*(m_cdg012(m)*m_cdg100(m)+2*m_cdg011(m)*m_cdg101(m)+m_cdg010(m)*m_cdg102(m)+m_cdg002(m)*m_cdg110(m)+2*m_cdg001(m)*m_cdg111(m)+m_cdg000(m)*m_cdg112(m))));
-    }
-
-    gValue(0)=deriv300+deriv120+deriv102;
-    gValue(1)=deriv210+deriv030+deriv012;
-    gValue(2)=deriv201+deriv021+deriv003;
-
-    hValue(0,0)=deriv400+deriv220+deriv202;
-    hValue(1,1)=deriv220+deriv040+deriv022;
-    hValue(2,2)=deriv202+deriv022+deriv004;
-    hValue(0,1)=deriv310+deriv130+deriv112;
-    hValue(0,2)=deriv301+deriv121+deriv103;
-    hValue(1,2)=deriv211+deriv031+deriv013;
-    hValue(1,0)=hValue(0,1);
-    hValue(2,0)=hValue(0,2);
-    hValue(2,1)=hValue(1,2);
-
-    value(0,0) = gValue(0);
-    value(1,0) = gValue(1);
-    value(2,0) = gValue(2);
-    value(0,1) = hValue(0,0);
-    value(1,1) = hValue(1,0);
-    value(2,1) = hValue(2,0);
-    value(0,2) = hValue(0,1);
-    value(1,2) = hValue(1,1);
-    value(2,2) = hValue(2,1);
-    value(0,3) = hValue(0,2);
-    value(1,3) = hValue(1,2);
-    value(2,3) = hValue(2,2);
-
-    return value;
-
-  }
-
-  qreal QTAIMWavefunctionEvaluator::kineticEnergyDensityG(Matrix<qreal,3,1> xyz)
-  {
-
-    qreal value;
-
-    const qreal zero=0.0;
-    const qreal one =1.0;
-
-    m_cdg000.setZero();
-    m_cdg100.setZero();
-    m_cdg010.setZero();
-    m_cdg001.setZero();
-    for( qint64 p=0 ; p < m_nprim ; ++p )
-    {
-      qreal xx0 = xyz(0) - m_X0(p);
-      qreal yy0 = xyz(1) - m_Y0(p);
-      qreal zz0 = xyz(2) - m_Z0(p);
-
-      qreal b0arg = -m_alpha(p)*(xx0*xx0 + yy0*yy0 + zz0*zz0 );
-
-      if( b0arg > m_cutoff )
-      {
-        qint64 aax0=1;
-        qint64 aay0=1;
-        qint64 aaz0=1;
-        qint64 aax1=m_xamom(p);
-        qint64 aay1=m_yamom(p);
-        qint64 aaz1=m_zamom(p);
-
-        qreal ax0 = aax0*ipow( xx0, m_xamom(p) );
-        qreal ay0 = aay0*ipow( yy0, m_yamom(p) );
-        qreal az0 = aaz0*ipow( zz0, m_zamom(p) );
-
-        qreal ax1;
-        qreal ay1;
-        qreal az1;
-        if     ( m_xamom(p) <  1 )
-        {
-          ax1=zero;
-        }
-        else if( m_xamom(p) == 1 )
-        {
-          ax1=one;
-        }
-        else
-        {
-          ax1=aax1*ipow(xx0,m_xamom(p)-1);
-        }
-
-        if     ( m_yamom(p) <  1 )
-        {
-          ay1=zero;
-        }
-        else if( m_yamom(p) == 1 )
-        {
-          ay1=one;
-        }
-        else
-        {
-          ay1=aay1*ipow(yy0,m_yamom(p)-1);
-        }
-
-        if     ( m_zamom(p) <  1 )
-        {
-          az1=zero;
-        }
-        else if( m_zamom(p) == 1 )
-        {
-          az1=one;
-        }
-        else
-        {
-          az1=aaz1*ipow(zz0,m_zamom(p)-1);
-        }
-
-        qreal b0 = exp(b0arg);
-
-        qreal bx1= -2*m_alpha(p)*xx0;
-        qreal by1= -2*m_alpha(p)*yy0;
-        qreal bz1= -2*m_alpha(p)*zz0;
-
-        qreal dg000 = ax0*ay0*az0*b0;
-        qreal dg100 = ay0*az0*b0*(ax1+ax0*bx1);
-        qreal dg010 = ax0*az0*b0*(ay1+ay0*by1);
-        qreal dg001 = ax0*ay0*b0*(az1+az0*bz1);
-
-        for( qint64 m=0 ; m < m_nmo ; ++m )
-        {
-          m_cdg000(m) += m_coef(m,p) * dg000;
-          m_cdg100(m) += m_coef(m,p) * dg100;
-          m_cdg010(m) += m_coef(m,p) * dg010;
-          m_cdg001(m) += m_coef(m,p) * dg001;
-        }
-
-      }
-    }
-
-    value=zero;
-    for( qint64 m=0 ; m < m_nmo ; ++m )
-    {
-      value += (0.5)*(m_occno(m)*(ipow(m_cdg100(m),2)+ipow(m_cdg010(m),2)+ipow(m_cdg001(m),2)));
-    }
-
-    return value;
-
-  }
-
-  qreal QTAIMWavefunctionEvaluator::kineticEnergyDensityK( const Matrix<qreal,3,1> xyz )
-  {
-
-    qreal value;
-
-    const qreal zero=0.0;
-    const qreal one =1.0;
-
-    m_cdg000.setZero();
-    m_cdg200.setZero();
-    m_cdg020.setZero();
-    m_cdg002.setZero();
-    for( qint64 p=0 ; p < m_nprim ; ++p )
-    {
-      qreal xx0 = xyz(0) - m_X0(p);
-      qreal yy0 = xyz(1) - m_Y0(p);
-      qreal zz0 = xyz(2) - m_Z0(p);
-
-      qreal b0arg = -m_alpha(p)*(xx0*xx0 + yy0*yy0 + zz0*zz0 );
-
-      if( b0arg > m_cutoff )
-      {
-        qint64 aax0=1;
-        qint64 aay0=1;
-        qint64 aaz0=1;
-        qint64 aax1=m_xamom(p);
-        qint64 aay1=m_yamom(p);
-        qint64 aaz1=m_zamom(p);
-        qint64 aax2=m_xamom(p)*(m_xamom(p)-1);
-        qint64 aay2=m_yamom(p)*(m_yamom(p)-1);
-        qint64 aaz2=m_zamom(p)*(m_zamom(p)-1);
-
-        qreal ax0 = aax0*ipow( xx0, m_xamom(p) );
-        qreal ay0 = aay0*ipow( yy0, m_yamom(p) );
-        qreal az0 = aaz0*ipow( zz0, m_zamom(p) );
-
-        qreal ax1;
-        qreal ay1;
-        qreal az1;
-        if     ( m_xamom(p) <  1 )
-        {
-          ax1=zero;
-        }
-        else if( m_xamom(p) == 1 )
-        {
-          ax1=one;
-        }
-        else
-        {
-          ax1=aax1*ipow(xx0,m_xamom(p)-1);
-        }
-
-        if     ( m_yamom(p) <  1 )
-        {
-          ay1=zero;
-        }
-        else if( m_yamom(p) == 1 )
-        {
-          ay1=one;
-        }
-        else
-        {
-          ay1=aay1*ipow(yy0,m_yamom(p)-1);
-        }
-
-        if     ( m_zamom(p) <  1 )
-        {
-          az1=zero;
-        }
-        else if( m_zamom(p) == 1 )
-        {
-          az1=one;
-        }
-        else
-        {
-          az1=aaz1*ipow(zz0,m_zamom(p)-1);
-        }
-
-        qreal ax2;
-        qreal ay2;
-        qreal az2;
-        if     ( m_xamom(p) <  2 )
-        {
-          ax2=zero;
-        }
-        else if( m_xamom(p) == 2 )
-        {
-          ax2=one;
-        }
-        else
-        {
-          ax2=aax2*ipow(xx0,m_xamom(p)-2);
-        }
-
-        if     ( m_yamom(p) <  2 )
-        {
-          ay2=zero;
-        }
-        else if( m_yamom(p) == 2 )
-        {
-          ay2=one;
-        }
-        else
-        {
-          ay2=aay2*ipow(yy0,m_yamom(p)-2);
-        }
-
-        if     ( m_zamom(p) <  2 )
-        {
-          az2=zero;
-        }
-        else if( m_zamom(p) == 2 )
-        {
-          az2=one;
-        }
-        else
-        {
-          az2=aaz2*ipow(zz0,m_zamom(p)-2);
-        }
-
-        qreal b0 = exp(b0arg);
-
-        qreal bx1 = -2*m_alpha(p)*xx0;
-        qreal by1 = -2*m_alpha(p)*yy0;
-        qreal bz1 = -2*m_alpha(p)*zz0;
-        qreal bx2 = -2*m_alpha(p) + 4*(ipow(m_alpha(p),2) * ipow(xx0,2));
-        qreal by2 = -2*m_alpha(p) + 4*(ipow(m_alpha(p),2) * ipow(yy0,2));
-        qreal bz2 = -2*m_alpha(p) + 4*(ipow(m_alpha(p),2) * ipow(zz0,2));
-
-        qreal dg000 = ax0*ay0*az0*b0;
-        qreal dg200 = ay0*az0*b0*(ax2+2*ax1*bx1+ax0*bx2);
-        qreal dg020 = ax0*az0*b0*(ay2+2*ay1*by1+ay0*by2);
-        qreal dg002 = ax0*ay0*b0*(az2+2*az1*bz1+az0*bz2);
-
-        for( qint64 m=0 ; m < m_nmo ; ++m )
-        {
-          m_cdg000(m) += m_coef(m,p) * dg000;
-          m_cdg200(m) += m_coef(m,p) * dg200;
-          m_cdg020(m) += m_coef(m,p) * dg020;
-          m_cdg002(m) += m_coef(m,p) * dg002;
-        }
-
-      }
-    }
-
-    value=0.0;
-    for( qint64 m=0 ; m < m_nmo ; ++m )
-    {
-      value += (0.25)*(m_occno(m)*(2*m_cdg000(m)*(m_cdg200(m)+m_cdg020(m)+m_cdg002(m))));
-    }
-
-    return value;
-
-  }
-
-  const Matrix<qreal,3,3> QTAIMWavefunctionEvaluator::quantumStressTensor( const Matrix<qreal,3,1> xyz )
-  {
+  const Matrix<qreal,3,3> QTAIMWavefunctionEvaluator::quantumStressTensor( const Matrix<qreal,3,1> xyz )
+  {
 
     Matrix<qreal,3,3> value;
 
-    const qreal zero=0.0;
-    const qreal one =1.0;
-
-    m_cdg000.setZero();
-    m_cdg100.setZero();
-    m_cdg010.setZero();
-    m_cdg001.setZero();
-    m_cdg200.setZero();
-    m_cdg020.setZero();
-    m_cdg002.setZero();
-    m_cdg110.setZero();
-    m_cdg101.setZero();
-    m_cdg011.setZero();
-    for( qint64 p=0 ; p < m_nprim ; ++p )
-    {
-      qreal xx0 = xyz(0) - m_X0(p);
-      qreal yy0 = xyz(1) - m_Y0(p);
-      qreal zz0 = xyz(2) - m_Z0(p);
-
-      qreal b0arg = -m_alpha(p)*(xx0*xx0 + yy0*yy0 + zz0*zz0 );
-
-      if( b0arg > m_cutoff )
-      {
-        qint64 aax0=1;
-        qint64 aay0=1;
-        qint64 aaz0=1;
-        qint64 aax1=m_xamom(p);
-        qint64 aay1=m_yamom(p);
-        qint64 aaz1=m_zamom(p);
-        qint64 aax2=m_xamom(p)*(m_xamom(p)-1);
-        qint64 aay2=m_yamom(p)*(m_yamom(p)-1);
-        qint64 aaz2=m_zamom(p)*(m_zamom(p)-1);
-
-        qreal ax0 = aax0*ipow( xx0, m_xamom(p) );
-        qreal ay0 = aay0*ipow( yy0, m_yamom(p) );
-        qreal az0 = aaz0*ipow( zz0, m_zamom(p) );
-
-        qreal ax1;
-        qreal ay1;
-        qreal az1;
-        if     ( m_xamom(p) <  1 )
-        {
-          ax1=zero;
-        }
-        else if( m_xamom(p) == 1 )
-        {
-          ax1=one;
-        }
-        else
-        {
-          ax1=aax1*ipow(xx0,m_xamom(p)-1);
-        }
-
-        if     ( m_yamom(p) <  1 )
-        {
-          ay1=zero;
-        }
-        else if( m_yamom(p) == 1 )
-        {
-          ay1=one;
-        }
-        else
-        {
-          ay1=aay1*ipow(yy0,m_yamom(p)-1);
-        }
-
-        if     ( m_zamom(p) <  1 )
-        {
-          az1=zero;
-        }
-        else if( m_zamom(p) == 1 )
-        {
-          az1=one;
-        }
-        else
-        {
-          az1=aaz1*ipow(zz0,m_zamom(p)-1);
-        }
-
-        qreal ax2;
-        qreal ay2;
-        qreal az2;
-        if     ( m_xamom(p) <  2 )
-        {
-          ax2=zero;
-        }
-        else if( m_xamom(p) == 2 )
-        {
-          ax2=one;
-        }
-        else
-        {
-          ax2=aax2*ipow(xx0,m_xamom(p)-2);
-        }
-
-        if     ( m_yamom(p) <  2 )
-        {
-          ay2=zero;
-        }
-        else if( m_yamom(p) == 2 )
-        {
-          ay2=one;
-        }
-        else
-        {
-          ay2=aay2*ipow(yy0,m_yamom(p)-2);
-        }
-
-        if     ( m_zamom(p) <  2 )
-        {
-          az2=zero;
-        }
-        else if( m_zamom(p) == 2 )
-        {
-          az2=one;
-        }
-        else
-        {
-          az2=aaz2*ipow(zz0,m_zamom(p)-2);
-        }
-
-        qreal b0 = exp(b0arg);
-
-        qreal bx1 = -2*m_alpha(p)*xx0;
-        qreal by1 = -2*m_alpha(p)*yy0;
-        qreal bz1 = -2*m_alpha(p)*zz0;
-        qreal bx2 = -2*m_alpha(p) + 4*(ipow(m_alpha(p),2) * ipow(xx0,2));
-        qreal by2 = -2*m_alpha(p) + 4*(ipow(m_alpha(p),2) * ipow(yy0,2));
-        qreal bz2 = -2*m_alpha(p) + 4*(ipow(m_alpha(p),2) * ipow(zz0,2));
-
-        qreal dg000 = ax0*ay0*az0*b0;
-        qreal dg100 = ay0*az0*b0*(ax1+ax0*bx1);
-        qreal dg010 = ax0*az0*b0*(ay1+ay0*by1);
-        qreal dg001 = ax0*ay0*b0*(az1+az0*bz1);
-        qreal dg200 = ay0*az0*b0*(ax2+2*ax1*bx1+ax0*bx2);
-        qreal dg020 = ax0*az0*b0*(ay2+2*ay1*by1+ay0*by2);
-        qreal dg002 = ax0*ay0*b0*(az2+2*az1*bz1+az0*bz2);
-        qreal dg110 = az0*b0*(ax1+ax0*bx1)*(ay1+ay0*by1);
-        qreal dg101 = ay0*b0*(ax1+ax0*bx1)*(az1+az0*bz1);
-        qreal dg011 = ax0*b0*(ay1+ay0*by1)*(az1+az0*bz1);
-
-        for( qint64 m=0 ; m < m_nmo ; ++m )
-        {
-          m_cdg000(m) += m_coef(m,p) * dg000;
-          m_cdg100(m) += m_coef(m,p) * dg100;
-          m_cdg010(m) += m_coef(m,p) * dg010;
-          m_cdg001(m) += m_coef(m,p) * dg001;
-          m_cdg200(m) += m_coef(m,p) * dg200;
-          m_cdg020(m) += m_coef(m,p) * dg020;
-          m_cdg002(m) += m_coef(m,p) * dg002;
-          m_cdg110(m) += m_coef(m,p) * dg110;
-          m_cdg101(m) += m_coef(m,p) * dg101;
-          m_cdg011(m) += m_coef(m,p) * dg011;
-        }
-
-      }
-    }
+    evaluatePrimitives(xyz,2);
+    contractPrimitives(2);
 
     value.setZero();
     for( qint64 m=0 ; m < m_nmo ; ++m )
@@ -21,6 +21,8 @@
 
 #include <Eigen/Core>
 
+#include <vector>
+
 using namespace Eigen;
 
 namespace Avogadro {
@@ -33,7 +35,13 @@ namespace QtPlugins {
   public:
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
-    explicit QTAIMWavefunctionEvaluator(QTAIMWavefunction &wfn);
+    /**
+     * The evaluator refers to the data held by @a wfn rather than copying it,
+     * so @a wfn must outlive the evaluator and must not be modified while it
+     * is in use. Several evaluators, e.g. one per worker thread, can share the
+     * same wavefunction as it is only ever read.
+     */
+    explicit QTAIMWavefunctionEvaluator(const QTAIMWavefunction &wfn);
 
     qreal molecularOrbital(const qint64 mo, const Matrix<qreal,3,1> xyz);
     qreal electronDensity(const Matrix<qreal,3,1> xyz);
@@ -50,24 +58,38 @@ namespace QtPlugins {
     const Matrix<qreal,3,3> quantumStressTensor(const Matrix<qreal,3,1> xyz);
 
   private:
+    typedef Map<const Matrix<qreal,Dynamic,1> > RealVectorMap;
+    typedef Map<const Matrix<qint64,Dynamic,1> > IntegerVectorMap;
+    typedef Map<const Matrix<qreal,Dynamic,Dynamic,RowMajor> > RealMatrixMap;
+    typedef Map<Array<qreal,Dynamic,1> > ArrayMap;
+
+    // Primitives sharing the same Cartesian angular momentum.
+    struct PrimitiveGroup
+    {
+      qint64 xamom;
+      qint64 yamom;
+      qint64 zamom;
+      std::vector<qint64> primitives;
+    };
+
     qint64 m_nmo;
     qint64 m_nprim;
     qint64 m_nnuc;
     //    qint64 m_noccmo; // number of (significantly) occupied molecular orbitals
-    Matrix<qreal,Dynamic,1> m_nucxcoord;
-    Matrix<qreal,Dynamic,1> m_nucycoord;
-    Matrix<qreal,Dynamic,1> m_nuczcoord;
-    Matrix<qint64,Dynamic,1> m_nucz;
-    Matrix<qreal,Dynamic,1> m_X0;
-    Matrix<qreal,Dynamic,1> m_Y0;
-    Matrix<qreal,Dynamic,1> m_Z0;
-    Matrix<qint64,Dynamic,1> m_xamom;
-    Matrix<qint64,Dynamic,1> m_yamom;
-    Matrix<qint64,Dynamic,1> m_zamom;
-    Matrix<qreal,Dynamic,1> m_alpha;
-    Matrix<qreal,Dynamic,1> m_occno;
-    Matrix<qreal,Dynamic,1> m_orbe;
-    Matrix<qreal,Dynamic,Dynamic,RowMajor> m_coef;
+    RealVectorMap m_nucxcoord;
+    RealVectorMap m_nucycoord;
+    RealVectorMap m_nuczcoord;
+    IntegerVectorMap m_nucz;
+    RealVectorMap m_X0;
+    RealVectorMap m_Y0;
+    RealVectorMap m_Z0;
+    IntegerVectorMap m_xamom;
+    IntegerVectorMap m_yamom;
+    IntegerVectorMap m_zamom;
+    RealVectorMap m_alpha;
+    RealVectorMap m_occno;
+    RealVectorMap m_orbe;
+    RealMatrixMap m_coef;
     qreal m_totalEnergy;
     qreal m_virialRatio;
 
@@ -109,6 +131,49 @@ namespace QtPlugins {
     Matrix<qreal,Dynamic,1> m_cdg013;
     Matrix<qreal,Dynamic,1> m_cdg004;
 
+    std::vector<PrimitiveGroup> m_primitiveGroups;
+
+    // Scratch space of the vectorized primitive kernel, see evaluatePrimitives.
+    Array<qreal,Dynamic,1> m_xx0;
+    Array<qreal,Dynamic,1> m_yy0;
+    Array<qreal,Dynamic,1> m_zz0;
+    Array<qreal,Dynamic,1> m_b0arg;
+    Matrix<qint64,Dynamic,1> m_screened;
+    Array<qreal,Dynamic,1> m_sxx0;
+    Array<qreal,Dynamic,1> m_syy0;
+    Array<qreal,Dynamic,1> m_szz0;
+    Array<qreal,Dynamic,1> m_salpha;
+    Array<qreal,Dynamic,1> m_sb0;
+    Array<qreal,Dynamic,1> m_ax0;
+    Array<qreal,Dynamic,1> m_ay0;
+    Array<qreal,Dynamic,1> m_az0;
+    Array<qreal,Dynamic,1> m_ax1;
+    Array<qreal,Dynamic,1> m_ay1;
+    Array<qreal,Dynamic,1> m_az1;
+    Array<qreal,Dynamic,1> m_ax2;
+    Array<qreal,Dynamic,1> m_ay2;
+    Array<qreal,Dynamic,1> m_az2;
+    Array<qreal,Dynamic,Dynamic> m_sdg;
+    Matrix<qreal,Dynamic,Dynamic> m_dg;
+    Matrix<qreal,Dynamic,Dynamic> m_cdg;
+
+    /**
+     * Evaluate the primitives and their derivatives up to @a order (0, 1 or 2)
+     * at @a xyz into the columns of m_dg, in the order 000, 100, 010, 001,
+     * 200, 020, 002, 110, 101 and 011. Primitives that do not pass the
+     * m_cutoff screening are set to zero.
+     */
+    void evaluatePrimitives(const Matrix<qreal,3,1> &xyz, int order);
+
+    /**
+     * Contract the primitives evaluated by evaluatePrimitives with the
+     * molecular orbital coefficients into the m_cdg* vectors.
+     */
+    void contractPrimitives(int order);
+
+    static void angularFactors(const ArrayMap &x, qint64 l, int order,
+                               ArrayMap a0, ArrayMap a1, ArrayMap a2);
+
     static inline qreal ipow(qreal a, qint64 n)
     {
       return (qreal) pow( a, (int) n );
@@ -19,12 +19,15 @@
 #include <avogadro/core/gaussianset.h>
 #include <avogadro/core/gaussiansettools.h>
 #include <avogadro/core/molecule.h>
-#include <avogadro/core/mutex.h>
+#include <avogadro/core/readwritelock.h>
 
 #include <avogadro/core/cube.h>
 
 #include <QtConcurrent/QtConcurrentMap>
 
+#include <algorithm>
+#include <vector>
+
 namespace Avogadro {
 namespace QtPlugins {
 
@@ -42,16 +45,41 @@ class BasisSetConcurrent
   }
 };
 
+// Each shell is one slab of the cube, i.e. all of the points sharing the same
+// index along the slowest varying axis. The values of a slab are contiguous in
+// the cube data, so the tasks write their results directly without locking.
 struct GaussianShell
 {
   GaussianSetTools *tools; // A pointer to the tools, can't write to member vars
   Cube *tCube;             // The target cube, used to initialise temp cubes too
-  unsigned int pos;        // The index of the point to calculate the MO for
+  unsigned int slab;       // The index of the slab to calculate
   unsigned int state;      // The MO number to calculate
 };
 
+namespace {
+void slabPositions(const GaussianShell &shell, std::vector<Vector3> &positions)
+{
+  Vector3i dim = shell.tCube->dimensions();
+  unsigned int slabSize = static_cast<unsigned int>(dim.y() * dim.z());
+  unsigned int offset = shell.slab * slabSize;
+  positions.resize(slabSize);
+  for (unsigned int i = 0; i < slabSize; ++i)
+    positions[i] = shell.tCube->position(offset + i);
+}
+
+void setSlabValues(const GaussianShell &shell,
+                   const std::vector<double> &values)
+{
+  // Only this task writes to this part of the cube, and the minimum and
+  // maximum are updated once all of the slabs are complete.
+  std::vector<double> &data = *shell.tCube->data();
+  std::copy(values.begin(), values.end(),
+            data.begin() + shell.slab * values.size());
+}
+}
+
 GaussianSetConcurrent::GaussianSetConcurrent(QObject *p) : QObject(p),
-  m_gaussianShells(NULL), m_set(NULL), m_tools(NULL)
+  m_cube(NULL), m_gaussianShells(NULL), m_set(NULL), m_tools(NULL)
 {
 }
 
@@ -89,7 +117,9 @@ bool GaussianSetConcurrent::calculateSpinDensity(Core::Cube *cube)
 void GaussianSetConcurrent::calculationComplete()
 {
   disconnect(&m_watcher, SIGNAL(finished()), this, SLOT(calculationComplete()));
-  (*m_gaussianShells)[0].tCube->lock()->unlock();
+  m_cube->updateMinMax();
+  m_cube->lock()->unlock();
+  m_cube = NULL;
   delete m_gaussianShells;
   m_gaussianShells = 0;
   emit finished();
@@ -99,24 +129,25 @@ bool GaussianSetConcurrent::setUpCalculation(Core::Cube *cube,
                                              unsigned int state,
                                              void (*func)(GaussianShell &))
 {
-  if (!m_set || !m_tools)
+  if (!m_set || !m_tools || !cube || cube->data()->empty())
     return false;
 
   m_set->initCalculation();
 
-  // Set up the points we want to calculate the density at.
-  m_gaussianShells =
-      new QVector<GaussianShell>(static_cast<int>(cube->data()->size()));
+  // Set up the slabs we want to calculate the density for, progress is
+  // reported as each slab is completed.
+  m_gaussianShells = new QVector<GaussianShell>(cube->dimensions().x());
 
   for (int i = 0; i < m_gaussianShells->size(); ++i) {
     (*m_gaussianShells)[i].tools = m_tools;
     (*m_gaussianShells)[i].tCube = cube;
-    (*m_gaussianShells)[i].pos = i;
+    (*m_gaussianShells)[i].slab = static_cast<unsigned int>(i);
     (*m_gaussianShells)[i].state = state;
   }
 
   // Lock the cube until we are done.
-  cube->lock()->lock();
+  m_cube = cube;
+  cube->lock()->lockForWrite();
 
   // Watch for the future
   connect(&m_watcher, SIGNAL(finished()), this, SLOT(calculationComplete()));
@@ -131,24 +162,29 @@ bool GaussianSetConcurrent::setUpCalculation(Core::Cube *cube,
 
 void GaussianSetConcurrent::processOrbital(GaussianShell &shell)
 {
-  Vector3 pos = shell.tCube->position(shell.pos);
-  shell.tCube->setValue(shell.pos,
-                        shell.tools->calculateMolecularOrbital(pos,
-                                                               shell.state));
+  std::vector<Vector3> positions;
+  std::vector<double> values;
+  slabPositions(shell, positions);
+  shell.tools->calculateMolecularOrbital(positions, shell.state, values);
+  setSlabValues(shell, values);
 }
 
 void GaussianSetConcurrent::processDensity(GaussianShell &shell)
 {
-  Vector3 pos = shell.tCube->position(shell.pos);
-  shell.tCube->setValue(shell.pos,
-                        shell.tools->calculateElectronDensity(pos));
+  std::vector<Vector3> positions;
+  std::vector<double> values;
+  slabPositions(shell, positions);
+  shell.tools->calculateElectronDensity(positions, values);
+  setSlabValues(shell, values);
 }
 
 void GaussianSetConcurrent::processSpinDensity(GaussianShell &shell)
 {
-  Vector3 pos = shell.tCube->position(shell.pos);
-  shell.tCube->setValue(shell.pos,
-                        shell.tools->calculateSpinDensity(pos));
+  std::vector<Vector3> positions;
+  std::vector<double> values;
+  slabPositions(shell, positions);
+  shell.tools->calculateSpinDensity(positions, values);
+  setSlabValues(shell, values);
 }
 
 }
@@ -21,10 +21,12 @@
 #include <avogadro/core/slatersettools.h>
 
 #include <avogadro/core/cube.h>
-#include <avogadro/core/mutex.h>
+#include <avogadro/core/readwritelock.h>
 
 #include <QtConcurrent/QtConcurrentMap>
 
+#include <vector>
+
 namespace Avogadro {
 namespace QtPlugins {
 
@@ -32,16 +34,30 @@ using Core::SlaterSet;
 using Core::SlaterSetTools;
 using Core::Cube;
 
+// Each shell is one slab of the cube, i.e. all of the points sharing the same
+// index along the slowest varying axis. The values of a slab are contiguous in
+// the cube data, so the tasks write their results directly without locking.
 struct SlaterShell
 {
   SlaterSetTools *tools; // A pointer to the tools, cannot write to member vars
   Cube *tCube;        // The target cube, used to initialise temp cubes too
-  unsigned int pos;   // The index of the point to calculate the MO for
+  unsigned int slab;  // The index of the slab to calculate
   unsigned int state; // The MO number to calculate
 };
 
+namespace {
+// The first index and number of points in the shell's slab.
+void slabRange(const SlaterShell &shell, unsigned int &offset,
+               unsigned int &slabSize)
+{
+  Vector3i dim = shell.tCube->dimensions();
+  slabSize = static_cast<unsigned int>(dim.y() * dim.z());
+  offset = shell.slab * slabSize;
+}
+}
+
 SlaterSetConcurrent::SlaterSetConcurrent(QObject *p) : QObject(p),
-  m_shells(NULL), m_set(NULL), m_tools(NULL)
+  m_cube(NULL), m_shells(NULL), m_set(NULL), m_tools(NULL)
 {
 }
 
@@ -79,7 +95,9 @@ bool SlaterSetConcurrent::calculateSpinDensity(Core::Cube *cube)
 void SlaterSetConcurrent::calculationComplete()
 {
   disconnect(&m_watcher, SIGNAL(finished()), this, SLOT(calculationComplete()));
-  (*m_shells)[0].tCube->lock()->unlock();
+  m_cube->updateMinMax();
+  m_cube->lock()->unlock();
+  m_cube = NULL;
   delete m_shells;
   m_shells = 0;
   emit finished();
@@ -89,23 +107,25 @@ bool SlaterSetConcurrent::setUpCalculation(Core::Cube *cube,
                                            unsigned int state,
                                            void (*func)(SlaterShell &))
 {
-  if (!m_set || !m_tools)
+  if (!m_set || !m_tools || !cube || cube->data()->empty())
     return false;
 
   m_set->initCalculation();
 
-  // Set up the points we want to calculate the density at.
-  m_shells = new QVector<SlaterShell>(static_cast<int>(cube->data()->size()));
+  // Set up the slabs we want to calculate the density for, progress is
+  // reported as each slab is completed.
+  m_shells = new QVector<SlaterShell>(cube->dimensions().x());
 
   for (int i = 0; i < m_shells->size(); ++i) {
     (*m_shells)[i].tools = m_tools;
     (*m_shells)[i].tCube = cube;
-    (*m_shells)[i].pos = i;
+    (*m_shells)[i].slab = static_cast<unsigned int>(i);
     (*m_shells)[i].state = state;
   }
 
   // Lock the cube until we are done.
-  cube->lock()->lock();
+  m_cube = cube;
+  cube->lock()->lockForWrite();
 
   // Watch for the future
   connect(&m_watcher, SIGNAL(finished()), this, SLOT(calculationComplete()));
@@ -118,26 +138,35 @@ bool SlaterSetConcurrent::setUpCalculation(Core::Cube *cube,
   return true;
 }
 
+// Only this task writes to its slab of the cube, and the minimum and maximum
+// are updated once all of the slabs are complete.
 void SlaterSetConcurrent::processOrbital(SlaterShell &shell)
 {
-  Vector3 pos = shell.tCube->position(shell.pos);
-  shell.tCube->setValue(shell.pos,
-                        shell.tools->calculateMolecularOrbital(pos,
-                                                               shell.state));
+  unsigned int offset, slabSize;
+  slabRange(shell, offset, slabSize);
+  std::vector<double> &data = *shell.tCube->data();
+  for (unsigned int i = offset; i < offset + slabSize; ++i) {
+    data[i] = shell.tools->calculateMolecularOrbital(shell.tCube->position(i),
+                                                     shell.state);
+  }
 }
 
 void SlaterSetConcurrent::processDensity(SlaterShell &shell)
 {
-  Vector3 pos = shell.tCube->position(shell.pos);
-  shell.tCube->setValue(shell.pos,
-                        shell.tools->calculateElectronDensity(pos));
+  unsigned int offset, slabSize;
+  slabRange(shell, offset, slabSize);
+  std::vector<double> &data = *shell.tCube->data();
+  for (unsigned int i = offset; i < offset + slabSize; ++i)
+    data[i] = shell.tools->calculateElectronDensity(shell.tCube->position(i));
 }
 
 void SlaterSetConcurrent::processSpinDensity(SlaterShell &shell)
 {
-  Vector3 pos = shell.tCube->position(shell.pos);
-  shell.tCube->setValue(shell.pos,
-                        shell.tools->calculateSpinDensity(pos));
+  unsigned int offset, slabSize;
+  slabRange(shell, offset, slabSize);
+  std::vector<double> &data = *shell.tCube->data();
+  for (unsigned int i = offset; i < offset + slabSize; ++i)
+    data[i] = shell.tools->calculateSpinDensity(shell.tCube->position(i));
 }
 
 }
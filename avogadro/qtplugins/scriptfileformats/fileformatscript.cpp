@@ -39,6 +39,8 @@ FileFormatScript::FileFormatScript(const QString &scriptFileName_)
     m_inputFormat(NotUsed),
     m_outputFormat(NotUsed)
 {
+  // Formats are created and used often, so keep the interpreter running.
+  m_interpreter->setPersistent(true);
   readMetaData();
 }
 
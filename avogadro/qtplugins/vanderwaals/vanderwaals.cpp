@@ -21,6 +21,7 @@
 #include <avogadro/rendering/geometrynode.h>
 #include <avogadro/rendering/groupnode.h>
 #include <avogadro/rendering/spheregeometry.h>
+#include <avogadro/qtgui/molecule.h>
 
 namespace Avogadro {
 namespace QtPlugins {
@@ -59,6 +60,32 @@ void VanDerWaals::process(const Core::Molecule &molecule,
   }
 }
 
+bool VanDerWaals::processChanges(const Core::Molecule &molecule,
+                                 Rendering::GroupNode &node,
+                                 unsigned int changes)
+{
+  // There is a sphere for each atom, updated in place while the count stays
+  // the same.
+  GeometryNode *geometry = node.childCount() == 1
+      ? dynamic_cast<GeometryNode *>(node.child(0)) : NULL;
+  SphereGeometry *spheres = geometry && geometry->drawables().size() == 1
+      ? dynamic_cast<SphereGeometry *>(geometry->drawable(0)) : NULL;
+  if (!spheres || spheres->size() != molecule.atomCount())
+    return false;
+  if (!(changes & QtGui::Molecule::Atoms))
+    return true;
+
+  for (Index i = 0; i < molecule.atomCount(); ++i) {
+    Core::Atom atom = molecule.atom(i);
+    unsigned char atomicNumber = atom.atomicNumber();
+    const unsigned char *c = Elements::color(atomicNumber);
+    Vector3ub color(c[0], c[1], c[2]);
+    spheres->setSphere(i, atom.position3d().cast<float>(), color,
+                       static_cast<float>(Elements::radiusVDW(atomicNumber)));
+  }
+  return true;
+}
+
 bool VanDerWaals::isEnabled() const
 {
   return m_enabled;
@@ -126,12 +126,13 @@ void GAMESSUSOutput::readAtomBlock(std::istream &in, Core::Molecule &molecule,
   // We read the atom block in until it terminates with a blank line.
   double coordFactor = angs ? 1.0 : BOHR_TO_ANGSTROM_D;
   string buffer;
+  vector<Core::StringView> parts;
   while (getline(in, buffer)) {
     if (Core::contains(buffer, "CHARGE") || Core::contains(buffer, "------"))
       continue;
     else if (buffer == "\n") // Our work here is done.
       return;
-    vector<string> parts = Core::split(buffer, ' ');
+    Core::split(buffer, ' ', parts);
     if (parts.size() != 5) {
       appendError("Poorly formed atom line: " + buffer);
       return;
@@ -141,16 +142,16 @@ void GAMESSUSOutput::readAtomBlock(std::istream &in, Core::Molecule &molecule,
     unsigned char atomicNumber(
           static_cast<unsigned char>(Core::lexicalCast<int>(parts[1], ok)));
     if (!ok)
-      appendError("Failed to cast to int for atomic number: " + parts[1]);
+      appendError("Failed to cast to int for atomic number: " + parts[1].str());
     pos.x() = Core::lexicalCast<Real>(parts[2], ok) * coordFactor;
     if (!ok)
-      appendError("Failed to cast to double for position: " + parts[2]);
+      appendError("Failed to cast to double for position: " + parts[2].str());
     pos.y() = Core::lexicalCast<Real>(parts[3], ok) * coordFactor;
     if (!ok)
-      appendError("Failed to cast to double for position: " + parts[3]);
+      appendError("Failed to cast to double for position: " + parts[3].str());
     pos.z() = Core::lexicalCast<Real>(parts[4], ok) * coordFactor;
     if (!ok)
-      appendError("Failed to cast to double for position: " + parts[4]);
+      appendError("Failed to cast to double for position: " + parts[4].str());
     Atom atom = molecule.addAtom(atomicNumber);
     atom.setPosition3d(pos);
   }
@@ -164,13 +165,14 @@ void GAMESSUSOutput::readBasisSet(std::istream &in)
   string buffer;
   int currentAtom(0);
   bool header(true);
+  vector<Core::StringView> parts;
   while (getline(in, buffer)) {
     if (header) { // Skip the header lines until we hit the last header line.
       if (Core::contains(buffer, "SHELL"))
         header = false;
       continue;
     }
-    vector<string> parts = Core::split(buffer, ' ');
+    Core::split(buffer, ' ', parts);
     if (Core::contains(buffer, "TOTAL NUMBER OF BASIS SET SHELLS")) {
       // End of the basis set block.
       return;
@@ -183,7 +185,7 @@ void GAMESSUSOutput::readBasisSet(std::istream &in)
     else if (parts.size() == 5 || parts.size() == 6) {
       if (parts[1].size() != 1) {
         appendError("Error parsing basis set line, unrecognized type"
-                    + parts[1]);
+                    + parts[1].str());
         continue;
       }
       // Determine the shell type.
@@ -206,7 +208,7 @@ void GAMESSUSOutput::readBasisSet(std::istream &in)
         break;
       default:
         shellType = GaussianSet::UU;
-        appendError("Unrecognized shell type: " + parts[1]);
+        appendError("Unrecognized shell type: " + parts[1].str());
       }
       // Read in the rest of the shell, terminate when the number of tokens
       // is not 5 or 6 in a line.
@@ -219,7 +221,7 @@ void GAMESSUSOutput::readBasisSet(std::istream &in)
           m_csp.push_back(Core::lexicalCast<double>(parts[5]));
         if (!getline(in, buffer))
           break;
-        parts = Core::split(buffer, ' ');
+        Core::split(buffer, ' ', parts);
       }
       // Now add this to our data structure.
       m_shellNums.push_back(numGTOs);
@@ -235,7 +237,8 @@ void GAMESSUSOutput::readEigenvectors(std::istream &in)
   getline(in, buffer);
   getline(in, buffer);
   getline(in, buffer);
-  vector<string> parts = Core::split(buffer, ' ');
+  vector<Core::StringView> parts;
+  Core::split(buffer, ' ', parts);
   vector< vector<double> > eigenvectors;
   bool ok(false);
   size_t numberOfMos(0);
@@ -243,7 +246,8 @@ void GAMESSUSOutput::readEigenvectors(std::istream &in)
   while (!Core::contains(buffer, "END OF")
          || Core::contains(buffer, "--------")) {
     // Any line with actual information in it will contain >= 5 parts.
-    if (parts.size() > 5 && buffer.substr(0, 16) != "                ") {
+    if (parts.size() > 5 && Core::StringView(buffer).substr(0, 16)
+        != "                ") {
       if (newBlock) {
         // Reorder the columns/rows, add them and then prepare
         for (size_t i = 0; i < eigenvectors.size(); ++i)
@@ -257,7 +261,8 @@ void GAMESSUSOutput::readEigenvectors(std::istream &in)
       for (size_t i = 0; i < parts.size() - 4; ++i) {
         eigenvectors[i].push_back(Core::lexicalCast<double>(parts[i + 4], ok));
         if (!ok)
-          appendError("Failed to cast to double for eigenvector: " + parts[i]);
+          appendError("Failed to cast to double for eigenvector: "
+                      + parts[i].str());
       }
     }
     else {
@@ -266,7 +271,7 @@ void GAMESSUSOutput::readEigenvectors(std::istream &in)
     }
     if (!getline(in, buffer))
       break;
-    parts = Core::split(buffer, ' ');
+    Core::split(buffer, ' ', parts);
   }
   m_nMOs = numberOfMos;
   for (size_t i = 0; i < eigenvectors.size(); ++i)
@@ -49,7 +49,7 @@ bool GaussianCube::read(std::istream &in, Core::Molecule &molecule)
 {
   // Variables we will need
   std::string line;
-  std::vector<std::string> list;
+  std::vector<Core::StringView> list;
 
   unsigned int nAtoms;
   Vector3 min;
@@ -74,8 +74,7 @@ bool GaussianCube::read(std::istream &in, Core::Molecule &molecule)
   // Next 3 lines contains spacing and dim
   for (unsigned int i = 0; i < 3; ++i) {
     getline(in, line);
-    line = Core::trimmed(line);
-    list = Core::split(line, ' ');
+    Core::split(Core::StringView(line).trimmed(), ' ', list);
     dim(i) = Core::lexicalCast<int>(list[0]);
     spacing(i) = Core::lexicalCast<double>(list[i + 1]);
   }
@@ -84,8 +83,7 @@ bool GaussianCube::read(std::istream &in, Core::Molecule &molecule)
   Vector3 pos;
   for (unsigned int i = 0; i < nAtoms; ++i) {
     getline(in, line);
-    line = Core::trimmed(line);
-    list = Core::split(line, ' ');
+    Core::split(Core::StringView(line).trimmed(), ' ', list);
     short int atomNum = Core::lexicalCast<short int>(list[0]);
     Core::Atom a = molecule.addAtom(static_cast<unsigned char>(atomNum));
     for (unsigned int j = 2; j < 5; ++j)
@@ -105,8 +103,12 @@ bool GaussianCube::read(std::istream &in, Core::Molecule &molecule)
   std::vector<double> values;
   // push_back is slow for this, resize vector first
   values.resize(dim(0) * dim(1) * dim(2));
-  for (unsigned int i = 0; i < values.size(); ++i)
-    in >> values[i];
+  size_t count = 0;
+  while (count < values.size() && getline(in, line)) {
+    Core::split(Core::StringView(line).trimmed(), ' ', list);
+    for (size_t i = 0; i < list.size() && count < values.size(); ++i)
+      values[count++] = Core::lexicalCast<double>(list[i]);
+  }
   cube->setData(values);
 
   return true;
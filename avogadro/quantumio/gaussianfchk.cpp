@@ -99,8 +99,8 @@ void GaussianFchk::processLine(std::istream &in)
   //cout << "Key:\t" << key << endl;
   key = Core::trimmed(key);
 
-  string tmp = line.substr(43);
-  vector<string> list = Core::split(tmp, ' ');
+  vector<Core::StringView> list;
+  Core::split(Core::StringView(line).substr(43), ' ', list);
 
   // Big switch statement checking for various things we are interested in
   if (Core::contains(key, "RHF")) {
@@ -307,17 +307,18 @@ vector<int> GaussianFchk::readArrayI(std::istream &in, unsigned int n)
   vector<int> tmp;
   tmp.reserve(n);
   bool ok(false);
+  string line;
+  vector<Core::StringView> list;
   while (tmp.size() < n) {
     if (in.eof()) {
       cout << "GaussianFchk::readArrayI could not read all elements "
            << n << " expected " << tmp.size() << " parsed.\n";
       return tmp;
     }
-    string line;
     if (getline(in, line), line.empty())
       return tmp;
 
-    vector<string> list = Core::split(line, ' ');
+    Core::split(line, ' ', list);
     for (size_t i = 0; i < list.size(); ++i) {
       if (tmp.size() >= n) {
         cout << "Too many variables read in. File may be inconsistent. "
@@ -341,18 +342,19 @@ vector<double> GaussianFchk::readArrayD(std::istream &in, unsigned int n,
   vector<double> tmp;
   tmp.reserve(n);
   bool ok(false);
+  string line;
+  vector<Core::StringView> list;
   while (tmp.size() < n) {
     if (in.eof()) {
       cout << "GaussianFchk::readArrayD could not read all elements "
            << n << " expected " << tmp.size() << " parsed.\n";
       return tmp;
     }
-    string line;
     if (getline(in, line), line.empty())
       return tmp;
 
     if (width == 0) { // we can split by spaces
-      vector<string> list = Core::split(line, ' ');
+      Core::split(line, ' ', list);
       for (size_t i = 0; i < list.size(); ++i) {
         if (tmp.size() >= n) {
           cout << "Too many variables read in. File may be inconsistent. "
@@ -370,7 +372,8 @@ vector<double> GaussianFchk::readArrayD(std::istream &in, unsigned int n,
     else { // Q-Chem files use 16 character fields
       int maxColumns = 80 / width;
       for (int i = 0; i < maxColumns; ++i) {
-        string substring = line.substr(i * width, width);
+        Core::StringView substring(
+            Core::StringView(line).substr(i * width, width));
         if (static_cast<int>(substring.length()) != width)
           break;
         if (tmp.size() >= n) {
@@ -399,18 +402,19 @@ bool GaussianFchk::readDensityMatrix(std::istream &in, unsigned int n,
   unsigned int i = 0, j = 0;
   unsigned int f = 1;
   bool ok = false;
+  string line;
+  vector<Core::StringView> list;
   while (cnt < n) {
     if (in.eof()) {
       cout << "GaussianFchk::readDensityMatrix could not read all elements "
            << n << " expected " << cnt << " parsed.\n";
       return false;
     }
-    string line;
     if (getline(in, line), line.empty())
       return false;
 
     if (width == 0) { // we can split by spaces
-      vector<string> list = Core::split(line, ' ');
+      Core::split(line, ' ', list);
       for (size_t k = 0; k < list.size(); ++k) {
         if (cnt >= n) {
           cout << "Too many variables read in. File may be inconsistent. "
@@ -438,7 +442,8 @@ bool GaussianFchk::readDensityMatrix(std::istream &in, unsigned int n,
     else { // Q-Chem files use 16-character fields
       int maxColumns = 80 / width;
       for (int c = 0; c < maxColumns; ++c) {
-        string substring = line.substr(c * width, width);
+        Core::StringView substring(
+            Core::StringView(line).substr(c * width, width));
         if (static_cast<int>(substring.length()) != width) {
           break;
         }
@@ -477,18 +482,19 @@ bool GaussianFchk::readSpinDensityMatrix(std::istream &in, unsigned int n,
   unsigned int i = 0, j = 0;
   unsigned int f = 1;
   bool ok = false;
+  string line;
+  vector<Core::StringView> list;
   while (cnt < n) {
     if (in.eof()) {
       cout << "GaussianFchk::readSpinDensityMatrix could not read all elements "
            << n << " expected " << cnt << " parsed.\n";
       return false;
     }
-    string line;
     if (getline(in, line), line.empty())
       return false;
 
     if (width == 0) { // we can split by spaces
-      vector<string> list = Core::split(line, ' ');
+      Core::split(line, ' ', list);
       for (size_t k = 0; k < list.size(); ++k) {
         if (cnt >= n) {
           cout << "Too many variables read in. File may be inconsistent. "
@@ -516,7 +522,8 @@ bool GaussianFchk::readSpinDensityMatrix(std::istream &in, unsigned int n,
     else { // Q-Chem files use 16-character fields
       int maxColumns = 80 / width;
       for (int c = 0; c < maxColumns; ++c) {
-        string substring = line.substr(c * width, width);
+        Core::StringView substring(
+            Core::StringView(line).substr(c * width, width));
         if (static_cast<int>(substring.length()) != width) {
           break;
         }
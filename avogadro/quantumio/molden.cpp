@@ -93,14 +93,15 @@ void MoldenFile::processLine(std::istream &in)
   if (!getline(in, line) || Core::trimmed(line).empty())
     return;
 
-  vector<string> list = Core::split(line, ' ');
+  vector<Core::StringView> list;
+  Core::split(line, ' ', list);
 
   // Big switch statement checking for various things we are interested in. The
   // Molden file format uses sectiosn, each starts with a header line of the
   // form [Atoms], and the beginning of a new section denotes the end of the
   // last.
   if (Core::contains(line, "[Atoms]")) {
-    if (list.size() > 1 && Core::contains(list[1], "AU"))
+    if (list.size() > 1 && Core::contains(list[1].str(), "AU"))
       m_coordFactor = BOHR_TO_ANGSTROM_D;
     m_mode = Atoms;
   }
@@ -115,7 +116,7 @@ void MoldenFile::processLine(std::istream &in)
   }
   else {
     // We are in a section, and must parse the lines in that section.
-    string shell;
+    Core::StringView shell;
     GaussianSet::orbital shellType;
 
     // Parsing a line of data in a section - what mode are we in?
@@ -130,7 +131,7 @@ void MoldenFile::processLine(std::istream &in)
       getline(in, line);
       line = Core::trimmed(line);
       while (!line.empty()) { // Read the shell types in this GTO.
-        list = Core::split(line, ' ');
+        Core::split(line, ' ', list);
         if (list.size() < 1)
           break;
         shell = list[0];
@@ -163,7 +164,7 @@ void MoldenFile::processLine(std::istream &in)
         for (int gto = 0; gto < numGTOs; ++gto) {
           getline(in, line);
           line = Core::trimmed(line);
-          list = Core::split(line, ' ');
+          Core::split(line, ' ', list);
           if (list.size() > 1) {
             m_a.push_back(Core::lexicalCast<double>(list[0]));
             m_c.push_back(Core::lexicalCast<double>(list[1]));
@@ -183,14 +184,14 @@ void MoldenFile::processLine(std::istream &in)
       while (!line.empty() && Core::contains(line, "=")) {
         getline(in, line);
         line = Core::trimmed(line);
-        list = Core::split(line, ' ');
+        Core::split(line, ' ', list);
         if (Core::contains(line, "Occup"))
           m_electrons += Core::lexicalCast<int>(list[1]);
       }
 
       // Parse the molecular orbital coefficients.
       while (!line.empty() && !Core::contains(line, "=")) {
-        list = Core::split(line, ' ');
+        Core::split(line, ' ', list);
         if (list.size() < 2)
           break;
 
@@ -198,7 +199,6 @@ void MoldenFile::processLine(std::istream &in)
 
         getline(in, line);
         line = Core::trimmed(line);
-        list = Core::split(line, ' ');
       }
       break;
     default:
@@ -207,7 +207,7 @@ void MoldenFile::processLine(std::istream &in)
   }
 }
 
-void MoldenFile::readAtom(const vector<string> &list)
+void MoldenFile::readAtom(const vector<Core::StringView> &list)
 {
   // element_name number atomic_number x y z
   if (list.size() < 6)
@@ -20,6 +20,7 @@
 
 #include "avogadroquantumioexport.h"
 #include <avogadro/core/gaussianset.h>
+#include <avogadro/core/stringview.h>
 #include <avogadro/io/fileformat.h>
 
 #include <vector>
@@ -65,7 +66,7 @@ private:
   void outputAll();
 
   void processLine(std::istream &in);
-  void readAtom(const std::vector<std::string> &list);
+  void readAtom(const std::vector<Core::StringView> &list);
   void load(Core::GaussianSet* basis);
 
   double m_coordFactor;
@@ -167,13 +167,14 @@ void MopacAux::load(SlaterSet* basis)
 vector<int> MopacAux::readArrayElements(std::istream &in, unsigned int n)
 {
   vector<int> tmp;
+  string line;
+  vector<Core::StringView> list;
   while (tmp.size() < n) {
-    string line;
     getline(in, line);
-    vector<string> list = Core::split(line, ' ');
+    Core::split(line, ' ', list);
     for (size_t i = 0; i < list.size(); ++i) {
-      tmp.push_back(
-            static_cast<int>(Core::Elements::atomicNumberFromSymbol(list[i])));
+      tmp.push_back(static_cast<int>(
+                      Core::Elements::atomicNumberFromSymbol(list[i].str())));
     }
   }
   return tmp;
@@ -182,10 +183,11 @@ vector<int> MopacAux::readArrayElements(std::istream &in, unsigned int n)
 vector<int> MopacAux::readArrayI(std::istream &in, unsigned int n)
 {
   vector<int> tmp;
+  string line;
+  vector<Core::StringView> list;
   while (tmp.size() < n) {
-    string line;
     getline(in, line);
-    vector<string> list = Core::split(line, ' ');
+    Core::split(line, ' ', list);
     for (size_t i = 0; i < list.size(); ++i)
       tmp.push_back(Core::lexicalCast<int>(list[i]));
   }
@@ -195,10 +197,11 @@ vector<int> MopacAux::readArrayI(std::istream &in, unsigned int n)
 vector<double> MopacAux::readArrayD(std::istream &in, unsigned int n)
 {
   vector<double> tmp;
+  string line;
+  vector<Core::StringView> list;
   while (tmp.size() < n) {
-    string line;
     getline(in, line);
-    vector<string> list = Core::split(line, ' ');
+    Core::split(line, ' ', list);
     for (size_t i = 0; i < list.size(); ++i)
       tmp.push_back(Core::lexicalCast<double>(list[i]));
   }
@@ -209,10 +212,11 @@ vector<int> MopacAux::readArraySym(std::istream &in, unsigned int n)
 {
   int type;
   vector<int> tmp;
+  string line;
+  vector<Core::StringView> list;
   while (tmp.size() < n) {
-    string line;
     getline(in, line);
-    vector<string> list = Core::split(line, ' ');
+    Core::split(line, ' ', list);
     for (size_t i = 0; i < list.size(); ++i) {
       if (list[i] == "S")
         type = SlaterSet::S;
@@ -245,10 +249,11 @@ vector<Vector3> MopacAux::readArrayVec(std::istream &in, unsigned int n)
   vector<Vector3> tmp(n / 3);
   double *ptr = tmp[0].data();
   unsigned int cnt = 0;
+  string line;
+  vector<Core::StringView> list;
   while (cnt < n) {
-    string line;
     getline(in, line);
-    vector<string> list = Core::split(line, ' ');
+    Core::split(line, ' ', list);
     for (size_t i = 0; i < list.size(); ++i)
       ptr[cnt++] = Core::lexicalCast<double>(list[i]);
   }
@@ -264,9 +269,10 @@ bool MopacAux::readOverlapMatrix(std::istream &in, unsigned int n)
   // Skip the first commment line...
   string line;
   getline(in, line);
+  vector<Core::StringView> list;
   while (cnt < n) {
     getline(in, line);
-    vector<string> list = Core::split(line, ' ');
+    Core::split(line, ' ', list);
     for (size_t k = 0; k < list.size(); ++k) {
       //m_overlap.part<Eigen::SelfAdjoint>()(i, j) = list.at(k).toDouble();
       m_overlap(i, j) = m_overlap(j, i) = Core::lexicalCast<double>(list[k]);
@@ -287,10 +293,11 @@ bool MopacAux::readEigenVectors(std::istream &in, unsigned int n)
   m_eigenVectors.resize(m_zeta.size(), m_zeta.size());
   unsigned int cnt = 0;
   unsigned int i = 0, j = 0;
+  string line;
+  vector<Core::StringView> list;
   while (cnt < n) {
-    string line;
     getline(in, line);
-    vector<string> list = Core::split(line, ' ');
+    Core::split(line, ' ', list);
     for (size_t k = 0; k < list.size(); ++k) {
       m_eigenVectors(i, j) = Core::lexicalCast<double>(list[k]);
       ++i; ++cnt;
@@ -313,9 +320,10 @@ bool MopacAux::readDensityMatrix(std::istream &in, unsigned int n)
   // Skip the first commment line...
   string line;
   getline(in, line);
+  vector<Core::StringView> list;
   while (cnt < n) {
     getline(in, line);
-    vector<string> list = Core::split(line, ' ');
+    Core::split(line, ' ', list);
     for (size_t k = 0; k < list.size(); ++k) {
       //m_overlap.part<Eigen::SelfAdjoint>()(i, j) = list.at(k).toDouble();
       m_density(i, j) = m_density(j, i) = Core::lexicalCast<double>(list[k]);
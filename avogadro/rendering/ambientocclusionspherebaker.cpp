@@ -0,0 +1,601 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2014 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "ambientocclusionspherebaker.h"
+
+#include "boundingvolumehierarchy.h"
+
+#include <avogadro/stl/mutex_p.h>
+
+#include <algorithm>
+#include <cmath>
+#include <list>
+
+namespace Avogadro {
+namespace Rendering {
+
+namespace {
+const int num_ao_points = 162;
+const float ao_points[] = {
+0.850650808352f, 0.525731112119f, 0.0f,
+-0.850650808352f, 0.525731112119f, 0.0f,
+0.850650808352f, -0.525731112119f, 0.0f,
+-0.850650808352f, -0.525731112119f, 0.0f,
+0.525731112119f, 0.0f, 0.850650808352f,
+0.525731112119f, 0.0f, -0.850650808352f,
+-0.525731112119f, 0.0f, 0.850650808352f,
+-0.525731112119f, 0.0f, -0.850650808352f,
+0.0f, 0.850650808352f, 0.525731112119f,
+0.0f, -0.850650808352f, 0.525731112119f,
+0.0f, 0.850650808352f, -0.525731112119f,
+0.0f, -0.850650808352f, -0.525731112119f,
+0.5f, 0.809016994375f, 0.309016994375f,
+0.309016994375f, 0.5f, 0.809016994375f,
+0.809016994375f, 0.309016994375f, 0.5f,
+0.809016994375f, 0.309016994375f, -0.5f,
+0.309016994375f, 0.5f, -0.809016994375f,
+0.5f, 0.809016994375f, -0.309016994375f,
+0.809016994375f, -0.309016994375f, 0.5f,
+0.309016994375f, -0.5f, 0.809016994375f,
+0.5f, -0.809016994375f, 0.309016994375f,
+0.5f, -0.809016994375f, -0.309016994375f,
+0.309016994375f, -0.5f, -0.809016994375f,
+0.809016994375f, -0.309016994375f, -0.5f,
+-0.809016994375f, 0.309016994375f, 0.5f,
+-0.309016994375f, 0.5f, 0.809016994375f,
+-0.5f, 0.809016994375f, 0.309016994375f,
+-0.5f, 0.809016994375f, -0.309016994375f,
+-0.309016994375f, 0.5f, -0.809016994375f,
+-0.809016994375f, 0.309016994375f, -0.5f,
+-0.5f, -0.809016994375f, 0.309016994375f,
+-0.309016994375f, -0.5f, 0.809016994375f,
+-0.809016994375f, -0.309016994375f, 0.5f,
+-0.809016994375f, -0.309016994375f, -0.5f,
+-0.309016994375f, -0.5f, -0.809016994375f,
+-0.5f, -0.809016994375f, -0.309016994375f,
+0.0f, 1.0f, 0.0f,
+0.0f, -1.0f, 0.0f,
+1.0f, 0.0f, 0.0f,
+-1.0f, 0.0f, 0.0f,
+0.0f, 0.0f, 1.0f,
+0.0f, 0.0f, -1.0f,
+0.702046444776f, 0.69378047756f, 0.16062203564f,
+0.688190960236f, 0.587785252292f, 0.425325404176f,
+0.862668480416f, 0.433888564553f, 0.259891913008f,
+0.16062203564f, 0.702046444776f, 0.69378047756f,
+0.425325404176f, 0.688190960236f, 0.587785252292f,
+0.259891913008f, 0.862668480416f, 0.433888564553f,
+0.69378047756f, 0.16062203564f, 0.702046444776f,
+0.587785252292f, 0.425325404176f, 0.688190960236f,
+0.433888564553f, 0.259891913008f, 0.862668480416f,
+0.862668480416f, 0.433888564553f, -0.259891913008f,
+0.688190960236f, 0.587785252292f, -0.425325404176f,
+0.702046444776f, 0.69378047756f, -0.16062203564f,
+0.433888564553f, 0.259891913008f, -0.862668480416f,
+0.587785252292f, 0.425325404176f, -0.688190960236f,
+0.69378047756f, 0.16062203564f, -0.702046444776f,
+0.259891913008f, 0.862668480416f, -0.433888564553f,
+0.425325404176f, 0.688190960236f, -0.587785252292f,
+0.16062203564f, 0.702046444776f, -0.69378047756f,
+0.862668480416f, -0.433888564553f, 0.259891913008f,
+0.688190960236f, -0.587785252292f, 0.425325404176f,
+0.702046444776f, -0.69378047756f, 0.16062203564f,
+0.433888564553f, -0.259891913008f, 0.862668480416f,
+0.587785252292f, -0.425325404176f, 0.688190960236f,
+0.69378047756f, -0.16062203564f, 0.702046444776f,
+0.259891913008f, -0.862668480416f, 0.433888564553f,
+0.425325404176f, -0.688190960236f, 0.587785252292f,
+0.16062203564f, -0.702046444776f, 0.69378047756f,
+0.702046444776f, -0.69378047756f, -0.16062203564f,
+0.688190960236f, -0.587785252292f, -0.425325404176f,
+0.862668480416f, -0.433888564553f, -0.259891913008f,
+0.16062203564f, -0.702046444776f, -0.69378047756f,
+0.425325404176f, -0.688190960236f, -0.587785252292f,
+0.259891913008f, -0.862668480416f, -0.433888564553f,
+0.69378047756f, -0.16062203564f, -0.702046444776f,
+0.587785252292f, -0.425325404176f, -0.688190960236f,
+0.433888564553f, -0.259891913008f, -0.862668480416f,
+-0.862668480416f, 0.433888564553f, 0.259891913008f,
+-0.688190960236f, 0.587785252292f, 0.425325404176f,
+-0.702046444776f, 0.69378047756f, 0.16062203564f,
+-0.433888564553f, 0.259891913008f, 0.862668480416f,
+-0.587785252292f, 0.425325404176f, 0.688190960236f,
+-0.69378047756f, 0.16062203564f, 0.702046444776f,
+-0.259891913008f, 0.862668480416f, 0.433888564553f,
+-0.425325404176f, 0.688190960236f, 0.587785252292f,
+-0.16062203564f, 0.702046444776f, 0.69378047756f,
+-0.702046444776f, 0.69378047756f, -0.16062203564f,
+-0.688190960236f, 0.587785252292f, -0.425325404176f,
+-0.862668480416f, 0.433888564553f, -0.259891913008f,
+-0.16062203564f, 0.702046444776f, -0.69378047756f,
+-0.425325404176f, 0.688190960236f, -0.587785252292f,
+-0.259891913008f, 0.862668480416f, -0.433888564553f,
+-0.69378047756f, 0.16062203564f, -0.702046444776f,
+-0.587785252292f, 0.425325404176f, -0.688190960236f,
+-0.433888564553f, 0.259891913008f, -0.862668480416f,
+-0.702046444776f, -0.69378047756f, 0.16062203564f,
+-0.688190960236f, -0.587785252292f, 0.425325404176f,
+-0.862668480416f, -0.433888564553f, 0.259891913008f,
+-0.16062203564f, -0.702046444776f, 0.69378047756f,
+-0.425325404176f, -0.688190960236f, 0.587785252292f,
+-0.259891913008f, -0.862668480416f, 0.433888564553f,
+-0.69378047756f, -0.16062203564f, 0.702046444776f,
+-0.587785252292f, -0.425325404176f, 0.688190960236f,
+-0.433888564553f, -0.259891913008f, 0.862668480416f,
+-0.862668480416f, -0.433888564553f, -0.259891913008f,
+-0.688190960236f, -0.587785252292f, -0.425325404176f,
+-0.702046444776f, -0.69378047756f, -0.16062203564f,
+-0.433888564553f, -0.259891913008f, -0.862668480416f,
+-0.587785252292f, -0.425325404176f, -0.688190960236f,
+-0.69378047756f, -0.16062203564f, -0.702046444776f,
+-0.259891913008f, -0.862668480416f, -0.433888564553f,
+-0.425325404176f, -0.688190960236f, -0.587785252292f,
+-0.16062203564f, -0.702046444776f, -0.69378047756f,
+0.525731112119f, 0.850650808352f, 0.0f,
+0.0f, 0.961938357784f, -0.273266528913f,
+0.26286555606f, 0.951056516295f, -0.162459848116f,
+0.26286555606f, 0.951056516295f, 0.162459848116f,
+0.0f, 0.961938357784f, 0.273266528913f,
+-0.525731112119f, 0.850650808352f, 0.0f,
+-0.26286555606f, 0.951056516295f, 0.162459848116f,
+-0.26286555606f, 0.951056516295f, -0.162459848116f,
+0.525731112119f, -0.850650808352f, 0.0f,
+0.0f, -0.961938357784f, 0.273266528913f,
+0.26286555606f, -0.951056516295f, 0.162459848116f,
+0.26286555606f, -0.951056516295f, -0.162459848116f,
+0.0f, -0.961938357784f, -0.273266528913f,
+-0.525731112119f, -0.850650808352f, 0.0f,
+-0.26286555606f, -0.951056516295f, 0.162459848116f,
+-0.26286555606f, -0.951056516295f, -0.162459848116f,
+0.850650808352f, 0.0f, 0.525731112119f,
+0.961938357784f, -0.273266528913f, 0.0f,
+0.951056516295f, -0.162459848116f, 0.26286555606f,
+0.951056516295f, 0.162459848116f, 0.26286555606f,
+0.961938357784f, 0.273266528913f, 0.0f,
+0.850650808352f, 0.0f, -0.525731112119f,
+0.951056516295f, 0.162459848116f, -0.26286555606f,
+0.951056516295f, -0.162459848116f, -0.26286555606f,
+-0.850650808352f, 0.0f, 0.525731112119f,
+-0.961938357784f, 0.273266528913f, 0.0f,
+-0.951056516295f, 0.162459848116f, 0.26286555606f,
+-0.951056516295f, -0.162459848116f, 0.26286555606f,
+-0.961938357784f, -0.273266528913f, 0.0f,
+-0.850650808352f, 0.0f, -0.525731112119f,
+-0.951056516295f, -0.162459848116f, -0.26286555606f,
+-0.951056516295f, 0.162459848116f, -0.26286555606f,
+0.0f, 0.525731112119f, 0.850650808352f,
+-0.273266528913f, 0.0f, 0.961938357784f,
+-0.162459848116f, 0.26286555606f, 0.951056516295f,
+0.162459848116f, 0.26286555606f, 0.951056516295f,
+0.273266528913f, 0.0f, 0.961938357784f,
+0.0f, -0.525731112119f, 0.850650808352f,
+0.162459848116f, -0.26286555606f, 0.951056516295f,
+-0.162459848116f, -0.26286555606f, 0.951056516295f,
+0.0f, 0.525731112119f, -0.850650808352f,
+0.273266528913f, 0.0f, -0.961938357784f,
+0.162459848116f, 0.26286555606f, -0.951056516295f,
+-0.162459848116f, 0.26286555606f, -0.951056516295f,
+-0.273266528913f, 0.0f, -0.961938357784f,
+0.0f, -0.525731112119f, -0.850650808352f,
+-0.162459848116f, -0.26286555606f, -0.951056516295f,
+0.162459848116f, -0.26286555606f, -0.951056516295f,
+};
+
+// The light from each direction is scaled as in the GPU baker, so both give
+// the same brightness.
+const float intensity = 1.0f / (0.3f * static_cast<float>(num_ao_points));
+
+inline float sign(float x)
+{
+  return x > 0.0f ? 1.0f : (x < 0.0f ? -1.0f : 0.0f);
+}
+
+// Inverse of the octahedral unfolding used by the AO shaders, from a point of
+// a tile in [-1, 1] to the unit normal of the sphere it stands for.
+Vector3f tileNormal(float s, float t)
+{
+  float h = 1.0f - std::abs(s) - std::abs(t);
+  Vector3f normal(s, t, -h);
+  if (h < 0.0f) {
+    normal.x() = sign(s) * (1.0f - std::abs(t));
+    normal.y() = sign(t) * (1.0f - std::abs(s));
+  }
+  return normal.normalized();
+}
+
+// Tests a ray leaving the surface of one sphere against all of the others.
+class OcclusionRayTest : public BoundingVolumeHierarchy::RayTest
+{
+public:
+  OcclusionRayTest(const Core::Array<SphereColor> &spheres, size_t self,
+                   const Vector3f &origin, const Vector3f &direction)
+    : m_spheres(spheres), m_self(self), m_origin(origin),
+      m_direction(direction)
+  {
+  }
+
+  bool intersect(size_t index, float &depth) const
+  {
+    if (index == m_self)
+      return false;
+    const SphereColor &sphere = m_spheres[index];
+    Vector3f distance = sphere.center - m_origin;
+    float B = distance.dot(m_direction);
+    float C = distance.dot(distance) - sphere.radius * sphere.radius;
+    // Points inside another sphere are buried, and never lit.
+    if (C < 0.0f) {
+      depth = 0.0f;
+      return true;
+    }
+    if (B < 0.0f || B * B < C)
+      return false;
+    depth = B - std::sqrt(B * B - C);
+    return true;
+  }
+
+private:
+  const Core::Array<SphereColor> &m_spheres;
+  size_t m_self;
+  Vector3f m_origin;
+  Vector3f m_direction;
+};
+
+// Tests whether a point is inside any sphere other than its own.
+class BuriedTest : public BoundingVolumeHierarchy::RayTest
+{
+public:
+  BuriedTest(const Core::Array<SphereColor> &spheres, size_t self,
+             const Vector3f &point)
+    : m_spheres(spheres), m_self(self), m_point(point)
+  {
+  }
+
+  bool intersect(size_t index, float &depth) const
+  {
+    const SphereColor &sphere = m_spheres[index];
+    depth = 0.0f;
+    return index != m_self && (sphere.center - m_point).squaredNorm()
+        < sphere.radius * sphere.radius;
+  }
+
+private:
+  const Core::Array<SphereColor> &m_spheres;
+  size_t m_self;
+  Vector3f m_point;
+};
+
+// A texture being baked. The threads only read it, apart from the tiles of
+// the spheres each of them was given.
+class BakeJob
+{
+public:
+  BakeJob(const Core::Array<SphereColor> &spheres, int textureSize,
+          int maximumTileSamples, unsigned char *texels);
+
+  size_t size() const { return m_spheres.size(); }
+
+  void bakeTile(size_t index) const;
+
+private:
+  float occlusion(size_t index, const Vector3f &normal) const;
+  void writeTexel(int x, int y, float value) const;
+
+  const Core::Array<SphereColor> &m_spheres;
+  std::vector<Vector3f> m_directions;
+  BoundingVolumeHierarchy m_bvh;
+  float m_maxDistance;
+  int m_textureSize;
+  int m_tiles;
+  int m_maximumTileSamples;
+  // The first column (or row) of texels of each tile, and the point of its
+  // tile in [-1, 1] that each column samples. Tiles are the same both ways.
+  std::vector<int> m_tileStart;
+  std::vector<float> m_corner;
+  unsigned char *m_texels;
+};
+
+BakeJob::BakeJob(const Core::Array<SphereColor> &spheres, int textureSize,
+                 int maximumTileSamples, unsigned char *texels)
+  : m_spheres(spheres), m_textureSize(textureSize),
+    m_maximumTileSamples(maximumTileSamples), m_texels(texels)
+{
+  for (int i = 0; i < num_ao_points; ++i) {
+    m_directions.push_back(Vector3f(ao_points[i * 3], ao_points[i * 3 + 1],
+                                    ao_points[i * 3 + 2]));
+  }
+
+  std::vector<BoundingVolumeHierarchy::Box> bounds;
+  bounds.reserve(spheres.size());
+  BoundingVolumeHierarchy::Box all;
+  for (size_t i = 0; i < spheres.size(); ++i) {
+    Vector3f radius(Vector3f::Constant(spheres[i].radius));
+    bounds.push_back(BoundingVolumeHierarchy::Box(spheres[i].center - radius,
+                                                  spheres[i].center + radius));
+    all.extend(bounds.back());
+  }
+  m_bvh.build(bounds);
+  // No ray from a surface needs to go further to leave all of the spheres.
+  m_maxDistance = all.diagonal().norm();
+
+  // The tiles are laid out and stretched by half a texel on each side as in
+  // the sphere_ao_bake shaders.
+  m_tiles = static_cast<int>(
+        std::ceil(std::sqrt(static_cast<float>(spheres.size()))));
+  float stretch = 1.0f + 2.0f * static_cast<float>(m_tiles)
+      / static_cast<float>(textureSize);
+  m_tileStart.assign(m_tiles + 1, textureSize);
+  m_corner.resize(textureSize);
+  for (int x = textureSize - 1; x >= 0; --x) {
+    float s = (static_cast<float>(x) + 0.5f) / static_cast<float>(textureSize)
+        * static_cast<float>(m_tiles);
+    int tile = std::min(static_cast<int>(s), m_tiles - 1);
+    m_tileStart[tile] = x;
+    float corner = (2.0f * (s - static_cast<float>(tile)) - 1.0f) * stretch;
+    m_corner[x] = std::max(-1.0f, std::min(1.0f, corner));
+  }
+  for (int tile = m_tiles - 1; tile >= 0; --tile)
+    m_tileStart[tile] = std::min(m_tileStart[tile], m_tileStart[tile + 1]);
+}
+
+void BakeJob::bakeTile(size_t index) const
+{
+  const int tileX = static_cast<int>(index % m_tiles);
+  const int tileY = static_cast<int>(index / m_tiles);
+  const int x0 = m_tileStart[tileX];
+  const int x1 = m_tileStart[tileX + 1];
+  const int y0 = m_tileStart[tileY];
+  const int y1 = m_tileStart[tileY + 1];
+
+  // Small tiles are sampled at each texel.
+  const int samples = m_maximumTileSamples;
+  if (x1 - x0 <= samples && y1 - y0 <= samples) {
+    for (int y = y0; y < y1; ++y) {
+      for (int x = x0; x < x1; ++x)
+        writeTexel(x, y, occlusion(index, tileNormal(m_corner[x], m_corner[y])));
+    }
+    return;
+  }
+
+  // Larger ones are interpolated from a grid of samples over the tile.
+  std::vector<float> grid(samples * samples);
+  const float step = 2.0f / static_cast<float>(samples - 1);
+  for (int j = 0; j < samples; ++j) {
+    for (int i = 0; i < samples; ++i) {
+      grid[j * samples + i] =
+          occlusion(index, tileNormal(-1.0f + step * static_cast<float>(i),
+                                      -1.0f + step * static_cast<float>(j)));
+    }
+  }
+  for (int y = y0; y < y1; ++y) {
+    float fy = (m_corner[y] + 1.0f) / step;
+    int j = std::min(static_cast<int>(fy), samples - 2);
+    fy -= static_cast<float>(j);
+    for (int x = x0; x < x1; ++x) {
+      float fx = (m_corner[x] + 1.0f) / step;
+      int i = std::min(static_cast<int>(fx), samples - 2);
+      fx -= static_cast<float>(i);
+      const float *row = &grid[j * samples + i];
+      float value = (1.0f - fy) * ((1.0f - fx) * row[0] + fx * row[1])
+          + fy * ((1.0f - fx) * row[samples] + fx * row[samples + 1]);
+      writeTexel(x, y, value);
+    }
+  }
+}
+
+float BakeJob::occlusion(size_t index, const Vector3f &normal) const
+{
+  const SphereColor &sphere = m_spheres[index];
+  Vector3f point = sphere.center + sphere.radius * normal;
+
+  // Much of the surface of packed spheres is inside their neighbors, which a
+  // ray of no length finds without trying each direction.
+  if (m_bvh.intersects(point, normal, 0.0f,
+                       BuriedTest(m_spheres, index, point))) {
+    return 0.0f;
+  }
+
+  float light = 0.0f;
+  for (size_t i = 0; i < m_directions.size(); ++i) {
+    const Vector3f &direction = m_directions[i];
+    float cosAlpha = normal.dot(direction);
+    if (cosAlpha <= 0.0f)
+      continue;
+    OcclusionRayTest test(m_spheres, index, point, direction);
+    if (!m_bvh.intersects(point, direction, m_maxDistance, test))
+      light += cosAlpha;
+  }
+  return std::min(1.0f, light * intensity);
+}
+
+void BakeJob::writeTexel(int x, int y, float value) const
+{
+  unsigned char *texel = m_texels + 4 * (y * m_textureSize + x);
+  texel[0] = texel[1] = texel[2] =
+      static_cast<unsigned char>(value * 255.0f + 0.5f);
+  texel[3] = 255;
+}
+
+// Bakes every step'th tile from first, on its own thread.
+class BakeTask
+{
+public:
+  BakeTask(const BakeJob &job, size_t first, size_t step)
+    : m_job(&job), m_first(first), m_step(step)
+  {
+  }
+
+  void operator()() const
+  {
+    for (size_t i = m_first; i < m_job->size(); i += m_step)
+      m_job->bakeTile(i);
+  }
+
+private:
+  const BakeJob *m_job;
+  size_t m_first;
+  size_t m_step;
+};
+
+// Maps kept for the last few sets of spheres, the most recently used first.
+struct CacheEntry
+{
+  size_t hash;
+  int textureSize;
+  int tileSamples;
+  /** The centers and radii of the spheres, which is all the maps depend on. */
+  std::vector<float> geometry;
+  std::vector<unsigned char> texture;
+};
+
+const size_t cacheCapacity = 4;
+Stl::mutex cacheMutex;
+std::list<CacheEntry> cache;
+
+void cacheKey(const Core::Array<SphereColor> &spheres, int textureSize,
+              int tileSamples, CacheEntry &entry)
+{
+  entry.textureSize = textureSize;
+  entry.tileSamples = tileSamples;
+  entry.geometry.resize(4 * spheres.size());
+  for (size_t i = 0; i < spheres.size(); ++i) {
+    const SphereColor &sphere = spheres[i];
+    entry.geometry[4 * i] = sphere.center.x();
+    entry.geometry[4 * i + 1] = sphere.center.y();
+    entry.geometry[4 * i + 2] = sphere.center.z();
+    entry.geometry[4 * i + 3] = sphere.radius;
+  }
+
+  // FNV-1a over the bytes of the geometry.
+  size_t hash = (2166136261u ^ static_cast<size_t>(textureSize)) * 16777619u;
+  hash = (hash ^ static_cast<size_t>(tileSamples)) * 16777619u;
+  if (!entry.geometry.empty()) {
+    const unsigned char *bytes =
+        reinterpret_cast<const unsigned char *>(&entry.geometry[0]);
+    const size_t byteCount = entry.geometry.size() * sizeof(float);
+    for (size_t i = 0; i < byteCount; ++i)
+      hash = (hash ^ bytes[i]) * 16777619u;
+  }
+  entry.hash = hash;
+}
+
+std::list<CacheEntry>::iterator findEntry(const CacheEntry &key)
+{
+  for (std::list<CacheEntry>::iterator it = cache.begin(); it != cache.end();
+       ++it) {
+    if (it->hash == key.hash && it->textureSize == key.textureSize
+        && it->tileSamples == key.tileSamples
+        && it->geometry == key.geometry) {
+      return it;
+    }
+  }
+  return cache.end();
+}
+}
+
+AmbientOcclusionSphereBaker::AmbientOcclusionSphereBaker(int textureSize_)
+  : m_textureSize(textureSize_), m_threadCount(0), m_maximumTileSamples(8)
+{
+}
+
+void AmbientOcclusionSphereBaker::setMaximumTileSamples(int samples)
+{
+  m_maximumTileSamples = std::max(2, samples);
+}
+
+void AmbientOcclusionSphereBaker::bake(const Core::Array<SphereColor> &spheres,
+                                       std::vector<unsigned char> &texture) const
+{
+  if (findCached(spheres, m_textureSize, m_maximumTileSamples, texture))
+    return;
+
+  // Texels outside of the tiles keep the clear color of the GPU baker.
+  texture.assign(4 * m_textureSize * m_textureSize, 0);
+  for (size_t i = 3; i < texture.size(); i += 4)
+    texture[i] = 255;
+  if (spheres.empty() || m_textureSize <= 0)
+    return;
+
+  BakeJob job(spheres, m_textureSize, m_maximumTileSamples, &texture[0]);
+  size_t threads = m_threadCount;
+  if (threads == 0)
+    threads = Stl::thread::hardware_concurrency();
+  threads = std::max(static_cast<size_t>(1),
+                     std::min(threads, spheres.size()));
+
+  // The calling thread bakes its share of the tiles too.
+  std::vector<Stl::thread *> workers;
+  for (size_t i = 1; i < threads; ++i)
+    workers.push_back(new Stl::thread(BakeTask(job, i, threads)));
+  BakeTask(job, 0, threads)();
+  for (size_t i = 0; i < workers.size(); ++i) {
+    workers[i]->join();
+    delete workers[i];
+  }
+
+  addCached(spheres, m_textureSize, m_maximumTileSamples, texture);
+}
+
+bool AmbientOcclusionSphereBaker::findCached(
+    const Core::Array<SphereColor> &spheres, int textureSize, int tileSamples,
+    std::vector<unsigned char> &texture)
+{
+  CacheEntry key;
+  cacheKey(spheres, textureSize, tileSamples, key);
+
+  Stl::unique_lock guard(cacheMutex);
+  std::list<CacheEntry>::iterator it = findEntry(key);
+  if (it == cache.end())
+    return false;
+  texture = it->texture;
+  cache.splice(cache.begin(), cache, it);
+  return true;
+}
+
+void AmbientOcclusionSphereBaker::addCached(
+    const Core::Array<SphereColor> &spheres, int textureSize, int tileSamples,
+    const std::vector<unsigned char> &texture)
+{
+  CacheEntry entry;
+  cacheKey(spheres, textureSize, tileSamples, entry);
+
+  Stl::unique_lock guard(cacheMutex);
+  std::list<CacheEntry>::iterator it = findEntry(entry);
+  if (it != cache.end())
+    cache.erase(it);
+  cache.push_front(entry);
+  cache.front().texture = texture;
+  if (cache.size() > cacheCapacity)
+    cache.pop_back();
+}
+
+void AmbientOcclusionSphereBaker::clearCache()
+{
+  Stl::unique_lock guard(cacheMutex);
+  cache.clear();
+}
+
+int AmbientOcclusionSphereBaker::directionCount()
+{
+  return num_ao_points;
+}
+
+const float * AmbientOcclusionSphereBaker::directions()
+{
+  return ao_points;
+}
+
+} // End namespace Rendering
+} // End namespace Avogadro
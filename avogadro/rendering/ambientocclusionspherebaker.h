@@ -0,0 +1,135 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2014 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef AVOGADRO_RENDERING_AMBIENTOCCLUSIONSPHEREBAKER_H
+#define AVOGADRO_RENDERING_AMBIENTOCCLUSIONSPHEREBAKER_H
+
+#include "avogadrorenderingexport.h"
+
+#include "spheregeometry.h"
+
+#include <avogadro/core/array.h>
+
+#include <vector>
+
+namespace Avogadro {
+namespace Rendering {
+
+/**
+ * @class AmbientOcclusionSphereBaker ambientocclusionspherebaker.h
+ * <avogadro/rendering/ambientocclusionspherebaker.h>
+ * @brief Bakes the ambient occlusion maps of spheres on the CPU.
+ *
+ * The maps have the layout used by AmbientOcclusionSphereGeometry. Each sphere
+ * has a square tile in an RGBA texture with textureSize() texels on a side.
+ * The sphere's surface is unfolded over an octahedron into its tile. A texel
+ * is lit from each of the directions() unless a ray from the surface towards
+ * that direction hits another sphere. The rays are traced through a
+ * BoundingVolumeHierarchy, and the spheres are shared out between threads.
+ * No OpenGL context is needed, so maps can be baked headless or on a worker
+ * thread.
+ *
+ * Baked maps are kept in a small cache shared by all bakers. The cache is keyed
+ * by the centers and radii of the spheres, the texture size and the tile
+ * samples the maps were baked with. A molecule that has not moved gets its
+ * maps back without baking them again. The maps baked on the GPU are sampled
+ * at every texel from different directions, so they are cached apart from
+ * those baked on the CPU with gpuTileSamples in place of the tile samples.
+ */
+
+class AVOGADRORENDERING_EXPORT AmbientOcclusionSphereBaker
+{
+public:
+  explicit AmbientOcclusionSphereBaker(int textureSize = 1024);
+
+  /**
+   * The tile samples the maps baked on the GPU are cached with.
+   */
+  static const int gpuTileSamples = 0;
+
+  /**
+   * The number of texels along each side of the texture.
+   */
+  int textureSize() const { return m_textureSize; }
+
+  /**
+   * Set the number of threads used to bake, 0 (the default) uses one for each
+   * hardware thread.
+   */
+  void setThreadCount(unsigned int threads) { m_threadCount = threads; }
+  unsigned int threadCount() const { return m_threadCount; }
+
+  /**
+   * Set the largest number of samples along each side of a tile. Occlusion
+   * varies slowly over a sphere, so larger tiles are interpolated from this
+   * many samples. The default is 8.
+   */
+  void setMaximumTileSamples(int samples);
+  int maximumTileSamples() const { return m_maximumTileSamples; }
+
+  /**
+   * Bake the maps of @a spheres into @a texture. The texture is resized to
+   * 4 * textureSize()^2 bytes, rows running from the bottom of the texture up
+   * as glTexImage2D expects. Maps are taken from the cache when present, and
+   * added to it otherwise.
+   */
+  void bake(const Core::Array<SphereColor> &spheres,
+            std::vector<unsigned char> &texture) const;
+
+  /**
+   * Copy the cached maps of @a spheres at @a textureSize into @a texture.
+   * @param tileSamples The maximumTileSamples() of the CPU baker, or
+   * gpuTileSamples for the maps baked on the GPU.
+   * @return false if the maps are not cached.
+   */
+  static bool findCached(const Core::Array<SphereColor> &spheres,
+                         int textureSize, int tileSamples,
+                         std::vector<unsigned char> &texture);
+
+  /**
+   * Add maps baked elsewhere, such as read back from the GPU, to the cache.
+   * @param tileSamples As for findCached().
+   */
+  static void addCached(const Core::Array<SphereColor> &spheres,
+                        int textureSize, int tileSamples,
+                        const std::vector<unsigned char> &texture);
+
+  /**
+   * Remove all of the maps from the cache.
+   */
+  static void clearCache();
+
+  /**
+   * The number of directions the occlusion is sampled from.
+   */
+  static int directionCount();
+
+  /**
+   * The directions as the x, y and z of directionCount() unit vectors. The GPU
+   * baker uses the same ones.
+   */
+  static const float * directions();
+
+private:
+  int m_textureSize;
+  unsigned int m_threadCount;
+  int m_maximumTileSamples;
+};
+
+} // End namespace Rendering
+} // End namespace Avogadro
+
+#endif // AVOGADRO_RENDERING_AMBIENTOCCLUSIONSPHEREBAKER_H
@@ -17,9 +17,11 @@
 
 #include "ambientocclusionspheregeometry.h"
 
+#include "ambientocclusionspherebaker.h"
 #include "camera.h"
 #include "scene.h"
 
+#include "boundingvolumehierarchy.h"
 #include "bufferobject.h"
 
 #include "shader.h"
@@ -34,177 +36,11 @@ namespace {
 #include "sphere_ao_bake_fs.h"
 #include "sphere_ao_render_vs.h"
 #include "sphere_ao_render_fs.h"
-
-const int num_ao_points = 162;
-const float ao_points[] = {
-0.850650808352f, 0.525731112119f, 0.0f,
--0.850650808352f, 0.525731112119f, 0.0f,
-0.850650808352f, -0.525731112119f, 0.0f,
--0.850650808352f, -0.525731112119f, 0.0f,
-0.525731112119f, 0.0f, 0.850650808352f,
-0.525731112119f, 0.0f, -0.850650808352f,
--0.525731112119f, 0.0f, 0.850650808352f,
--0.525731112119f, 0.0f, -0.850650808352f,
-0.0f, 0.850650808352f, 0.525731112119f,
-0.0f, -0.850650808352f, 0.525731112119f,
-0.0f, 0.850650808352f, -0.525731112119f,
-0.0f, -0.850650808352f, -0.525731112119f,
-0.5f, 0.809016994375f, 0.309016994375f,
-0.309016994375f, 0.5f, 0.809016994375f,
-0.809016994375f, 0.309016994375f, 0.5f,
-0.809016994375f, 0.309016994375f, -0.5f,
-0.309016994375f, 0.5f, -0.809016994375f,
-0.5f, 0.809016994375f, -0.309016994375f,
-0.809016994375f, -0.309016994375f, 0.5f,
-0.309016994375f, -0.5f, 0.809016994375f,
-0.5f, -0.809016994375f, 0.309016994375f,
-0.5f, -0.809016994375f, -0.309016994375f,
-0.309016994375f, -0.5f, -0.809016994375f,
-0.809016994375f, -0.309016994375f, -0.5f,
--0.809016994375f, 0.309016994375f, 0.5f,
--0.309016994375f, 0.5f, 0.809016994375f,
--0.5f, 0.809016994375f, 0.309016994375f,
--0.5f, 0.809016994375f, -0.309016994375f,
--0.309016994375f, 0.5f, -0.809016994375f,
--0.809016994375f, 0.309016994375f, -0.5f,
--0.5f, -0.809016994375f, 0.309016994375f,
--0.309016994375f, -0.5f, 0.809016994375f,
--0.809016994375f, -0.309016994375f, 0.5f,
--0.809016994375f, -0.309016994375f, -0.5f,
--0.309016994375f, -0.5f, -0.809016994375f,
--0.5f, -0.809016994375f, -0.309016994375f,
-0.0f, 1.0f, 0.0f,
-0.0f, -1.0f, 0.0f,
-1.0f, 0.0f, 0.0f,
--1.0f, 0.0f, 0.0f,
-0.0f, 0.0f, 1.0f,
-0.0f, 0.0f, -1.0f,
-0.702046444776f, 0.69378047756f, 0.16062203564f,
-0.688190960236f, 0.587785252292f, 0.425325404176f,
-0.862668480416f, 0.433888564553f, 0.259891913008f,
-0.16062203564f, 0.702046444776f, 0.69378047756f,
-0.425325404176f, 0.688190960236f, 0.587785252292f,
-0.259891913008f, 0.862668480416f, 0.433888564553f,
-0.69378047756f, 0.16062203564f, 0.702046444776f,
-0.587785252292f, 0.425325404176f, 0.688190960236f,
-0.433888564553f, 0.259891913008f, 0.862668480416f,
-0.862668480416f, 0.433888564553f, -0.259891913008f,
-0.688190960236f, 0.587785252292f, -0.425325404176f,
-0.702046444776f, 0.69378047756f, -0.16062203564f,
-0.433888564553f, 0.259891913008f, -0.862668480416f,
-0.587785252292f, 0.425325404176f, -0.688190960236f,
-0.69378047756f, 0.16062203564f, -0.702046444776f,
-0.259891913008f, 0.862668480416f, -0.433888564553f,
-0.425325404176f, 0.688190960236f, -0.587785252292f,
-0.16062203564f, 0.702046444776f, -0.69378047756f,
-0.862668480416f, -0.433888564553f, 0.259891913008f,
-0.688190960236f, -0.587785252292f, 0.425325404176f,
-0.702046444776f, -0.69378047756f, 0.16062203564f,
-0.433888564553f, -0.259891913008f, 0.862668480416f,
-0.587785252292f, -0.425325404176f, 0.688190960236f,
-0.69378047756f, -0.16062203564f, 0.702046444776f,
-0.259891913008f, -0.862668480416f, 0.433888564553f,
-0.425325404176f, -0.688190960236f, 0.587785252292f,
-0.16062203564f, -0.702046444776f, 0.69378047756f,
-0.702046444776f, -0.69378047756f, -0.16062203564f,
-0.688190960236f, -0.587785252292f, -0.425325404176f,
-0.862668480416f, -0.433888564553f, -0.259891913008f,
-0.16062203564f, -0.702046444776f, -0.69378047756f,
-0.425325404176f, -0.688190960236f, -0.587785252292f,
-0.259891913008f, -0.862668480416f, -0.433888564553f,
-0.69378047756f, -0.16062203564f, -0.702046444776f,
-0.587785252292f, -0.425325404176f, -0.688190960236f,
-0.433888564553f, -0.259891913008f, -0.862668480416f,
--0.862668480416f, 0.433888564553f, 0.259891913008f,
--0.688190960236f, 0.587785252292f, 0.425325404176f,
--0.702046444776f, 0.69378047756f, 0.16062203564f,
--0.433888564553f, 0.259891913008f, 0.862668480416f,
--0.587785252292f, 0.425325404176f, 0.688190960236f,
--0.69378047756f, 0.16062203564f, 0.702046444776f,
--0.259891913008f, 0.862668480416f, 0.433888564553f,
--0.425325404176f, 0.688190960236f, 0.587785252292f,
--0.16062203564f, 0.702046444776f, 0.69378047756f,
--0.702046444776f, 0.69378047756f, -0.16062203564f,
--0.688190960236f, 0.587785252292f, -0.425325404176f,
--0.862668480416f, 0.433888564553f, -0.259891913008f,
--0.16062203564f, 0.702046444776f, -0.69378047756f,
--0.425325404176f, 0.688190960236f, -0.587785252292f,
--0.259891913008f, 0.862668480416f, -0.433888564553f,
--0.69378047756f, 0.16062203564f, -0.702046444776f,
--0.587785252292f, 0.425325404176f, -0.688190960236f,
--0.433888564553f, 0.259891913008f, -0.862668480416f,
--0.702046444776f, -0.69378047756f, 0.16062203564f,
--0.688190960236f, -0.587785252292f, 0.425325404176f,
--0.862668480416f, -0.433888564553f, 0.259891913008f,
--0.16062203564f, -0.702046444776f, 0.69378047756f,
--0.425325404176f, -0.688190960236f, 0.587785252292f,
--0.259891913008f, -0.862668480416f, 0.433888564553f,
--0.69378047756f, -0.16062203564f, 0.702046444776f,
--0.587785252292f, -0.425325404176f, 0.688190960236f,
--0.433888564553f, -0.259891913008f, 0.862668480416f,
--0.862668480416f, -0.433888564553f, -0.259891913008f,
--0.688190960236f, -0.587785252292f, -0.425325404176f,
--0.702046444776f, -0.69378047756f, -0.16062203564f,
--0.433888564553f, -0.259891913008f, -0.862668480416f,
--0.587785252292f, -0.425325404176f, -0.688190960236f,
--0.69378047756f, -0.16062203564f, -0.702046444776f,
--0.259891913008f, -0.862668480416f, -0.433888564553f,
--0.425325404176f, -0.688190960236f, -0.587785252292f,
--0.16062203564f, -0.702046444776f, -0.69378047756f,
-0.525731112119f, 0.850650808352f, 0.0f,
-0.0f, 0.961938357784f, -0.273266528913f,
-0.26286555606f, 0.951056516295f, -0.162459848116f,
-0.26286555606f, 0.951056516295f, 0.162459848116f,
-0.0f, 0.961938357784f, 0.273266528913f,
--0.525731112119f, 0.850650808352f, 0.0f,
--0.26286555606f, 0.951056516295f, 0.162459848116f,
--0.26286555606f, 0.951056516295f, -0.162459848116f,
-0.525731112119f, -0.850650808352f, 0.0f,
-0.0f, -0.961938357784f, 0.273266528913f,
-0.26286555606f, -0.951056516295f, 0.162459848116f,
-0.26286555606f, -0.951056516295f, -0.162459848116f,
-0.0f, -0.961938357784f, -0.273266528913f,
--0.525731112119f, -0.850650808352f, 0.0f,
--0.26286555606f, -0.951056516295f, 0.162459848116f,
--0.26286555606f, -0.951056516295f, -0.162459848116f,
-0.850650808352f, 0.0f, 0.525731112119f,
-0.961938357784f, -0.273266528913f, 0.0f,
-0.951056516295f, -0.162459848116f, 0.26286555606f,
-0.951056516295f, 0.162459848116f, 0.26286555606f,
-0.961938357784f, 0.273266528913f, 0.0f,
-0.850650808352f, 0.0f, -0.525731112119f,
-0.951056516295f, 0.162459848116f, -0.26286555606f,
-0.951056516295f, -0.162459848116f, -0.26286555606f,
--0.850650808352f, 0.0f, 0.525731112119f,
--0.961938357784f, 0.273266528913f, 0.0f,
--0.951056516295f, 0.162459848116f, 0.26286555606f,
--0.951056516295f, -0.162459848116f, 0.26286555606f,
--0.961938357784f, -0.273266528913f, 0.0f,
--0.850650808352f, 0.0f, -0.525731112119f,
--0.951056516295f, -0.162459848116f, -0.26286555606f,
--0.951056516295f, 0.162459848116f, -0.26286555606f,
-0.0f, 0.525731112119f, 0.850650808352f,
--0.273266528913f, 0.0f, 0.961938357784f,
--0.162459848116f, 0.26286555606f, 0.951056516295f,
-0.162459848116f, 0.26286555606f, 0.951056516295f,
-0.273266528913f, 0.0f, 0.961938357784f,
-0.0f, -0.525731112119f, 0.850650808352f,
-0.162459848116f, -0.26286555606f, 0.951056516295f,
--0.162459848116f, -0.26286555606f, 0.951056516295f,
-0.0f, 0.525731112119f, -0.850650808352f,
-0.273266528913f, 0.0f, -0.961938357784f,
-0.162459848116f, 0.26286555606f, -0.951056516295f,
--0.162459848116f, 0.26286555606f, -0.951056516295f,
--0.273266528913f, 0.0f, -0.961938357784f,
-0.0f, -0.525731112119f, -0.850650808352f,
--0.162459848116f, -0.26286555606f, -0.951056516295f,
-0.162459848116f, -0.26286555606f, -0.951056516295f,
-};
-
 }
 
 #include "avogadrogl.h"
 
+#include <algorithm>
 #include <iostream>
 
 using std::cout;
@@ -213,6 +49,57 @@ using std::endl;
 namespace Avogadro {
 namespace Rendering {
 
+namespace {
+// Tests a ray against the spheres, clipped to the segment between the ends.
+class AoSphereRayTest : public BoundingVolumeHierarchy::RayTest
+{
+public:
+  AoSphereRayTest(const Core::Array<SphereColor> &spheres,
+                  const Vector3f &rayOrigin, const Vector3f &rayEnd,
+                  const Vector3f &rayDirection)
+    : m_spheres(spheres), m_rayOrigin(rayOrigin), m_rayEnd(rayEnd),
+      m_rayDirection(rayDirection)
+  {
+  }
+
+  bool intersect(size_t index, float &depth) const
+  {
+    const SphereColor &sphere = m_spheres[index];
+
+    Vector3f distance = sphere.center - m_rayOrigin;
+    float B = distance.dot(m_rayDirection);
+    float C = distance.dot(distance) - (sphere.radius * sphere.radius);
+    float D = B * B - C;
+
+    // Test for intersection
+    if (D < 0)
+      return false;
+
+    // Test for clipping
+    if (B < 0 || (sphere.center - m_rayEnd).dot(m_rayDirection) > 0)
+      return false;
+
+    float rootD = static_cast<float>(sqrt(D));
+    depth = std::min(std::abs(B + rootD), std::abs(B - rootD));
+    return true;
+  }
+
+private:
+  const Core::Array<SphereColor> &m_spheres;
+  Vector3f m_rayOrigin;
+  Vector3f m_rayEnd;
+  Vector3f m_rayDirection;
+};
+
+// The bounding box of a sphere for picking.
+BoundingVolumeHierarchy::Box sphereBounds(const SphereColor &sphere)
+{
+  Vector3f radius(Vector3f::Constant(sphere.radius));
+  return BoundingVolumeHierarchy::Box(sphere.center - radius,
+                                      sphere.center + radius);
+}
+}
+
 
 class AmbientOcclusionRenderer
 {
@@ -287,16 +174,19 @@ class AmbientOcclusionBaker
       glClear(GL_COLOR_BUFFER_BIT);
       glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-      for (int i = 0; i < num_ao_points; ++i) {
+      // the directions are shared with the CPU baker
+      const int numDirections = AmbientOcclusionSphereBaker::directionCount();
+      const float *directions = AmbientOcclusionSphereBaker::directions();
+      for (int i = 0; i < numDirections; ++i) {
         // random light direction
-        Vector3f dir(ao_points[i * 3], ao_points[i * 3 + 1], ao_points[i * 3 + 2]);
+        Vector3f dir(directions[i * 3], directions[i * 3 + 1], directions[i * 3 + 2]);
         camera.lookAt(center + dir, center, Vector3f(0, 1, 0));
         Eigen::Matrix4f modelView = camera.modelView().matrix();
 
         // render depth to texture
         renderDepth(modelView, projection);
         // accumulate AO
-        renderAO(modelView, projection, num_ao_points);
+        renderAO(modelView, projection, numDirections);
       }
 
       // load OpenGL state
@@ -764,7 +654,12 @@ class SphereAmbientOcclusionRenderer : public AmbientOcclusionRenderer
 class AmbientOcclusionSphereGeometry::Private
 {
 public:
-  Private() : aoTextureSize(1024) { }
+  Private() : aoTextureSize(1024), aoTexture(0) { }
+
+  // Replace the AO texture, by one made from texels or read the texels back.
+  void setAoTexture(GLuint texture);
+  void uploadAoTexture(const std::vector<unsigned char> &texels);
+  void downloadAoTexture(std::vector<unsigned char> &texels) const;
 
   BufferObject vbo;
   BufferObject ibo;
@@ -778,10 +673,46 @@ public:
 
   Eigen::Matrix4f translate;
   int aoTextureSize;
-  int aoTexture;
+  GLuint aoTexture;
+
+  BoundingVolumeHierarchy bvh;
 };
 
-AmbientOcclusionSphereGeometry::AmbientOcclusionSphereGeometry() : m_dirty(false), d(new Private)
+void AmbientOcclusionSphereGeometry::Private::setAoTexture(GLuint texture)
+{
+  if (aoTexture != 0 && aoTexture != texture)
+    glDeleteTextures(1, &aoTexture);
+  aoTexture = texture;
+}
+
+void AmbientOcclusionSphereGeometry::Private::uploadAoTexture(
+    const std::vector<unsigned char> &texels)
+{
+  GLuint texture;
+  glGenTextures(1, &texture);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, aoTextureSize, aoTextureSize, 0,
+               GL_RGBA, GL_UNSIGNED_BYTE, &texels[0]);
+  // same filtering and wrap modes as the texture of the GPU baker
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  setAoTexture(texture);
+}
+
+void AmbientOcclusionSphereGeometry::Private::downloadAoTexture(
+    std::vector<unsigned char> &texels) const
+{
+  texels.resize(4 * aoTextureSize * aoTextureSize);
+  glBindTexture(GL_TEXTURE_2D, aoTexture);
+  glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, &texels[0]);
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+AmbientOcclusionSphereGeometry::AmbientOcclusionSphereGeometry()
+  : m_cpuBaking(false), m_dirty(false), d(new Private)
 {
 }
 
@@ -790,6 +721,7 @@ AmbientOcclusionSphereGeometry::AmbientOcclusionSphereGeometry(
   : Drawable(other),
     m_spheres(other.m_spheres),
     m_indices(other.m_indices),
+    m_cpuBaking(other.m_cpuBaking),
     m_dirty(true),
     d(new Private)
 {
@@ -892,15 +824,35 @@ void AmbientOcclusionSphereGeometry::update()
     d->numberOfIndices = sphereIndices.size();
 
 
-    SphereAmbientOcclusionRenderer aoSphereRenderer(d->vbo, d->ibo,
-        static_cast<int>(m_spheres.size()),
-        static_cast<int>(d->numberOfVertices),
-        static_cast<int>(d->numberOfIndices));
-    AmbientOcclusionBaker baker(&aoSphereRenderer, d->aoTextureSize);
-    baker.accumulateAO(center, radius + 2.0f);
-    d->aoTexture = baker.aoTexture();
-    baker.destroy();
-    aoSphereRenderer.destroy();
+    // Spheres that did not move since their maps were baked by the same
+    // baker take them from the cache.
+    std::vector<unsigned char> aoTexels;
+    if (m_cpuBaking) {
+      AmbientOcclusionSphereBaker cpuBaker(d->aoTextureSize);
+      cpuBaker.bake(m_spheres, aoTexels);
+      d->uploadAoTexture(aoTexels);
+    }
+    else if (AmbientOcclusionSphereBaker::findCached(
+               m_spheres, d->aoTextureSize,
+               AmbientOcclusionSphereBaker::gpuTileSamples, aoTexels)) {
+      d->uploadAoTexture(aoTexels);
+    }
+    else {
+      SphereAmbientOcclusionRenderer aoSphereRenderer(d->vbo, d->ibo,
+          static_cast<int>(m_spheres.size()),
+          static_cast<int>(d->numberOfVertices),
+          static_cast<int>(d->numberOfIndices));
+      AmbientOcclusionBaker baker(&aoSphereRenderer, d->aoTextureSize);
+      baker.accumulateAO(center, radius + 2.0f);
+      d->setAoTexture(baker.aoTexture());
+      baker.destroy();
+      aoSphereRenderer.destroy();
+
+      d->downloadAoTexture(aoTexels);
+      AmbientOcclusionSphereBaker::addCached(
+            m_spheres, d->aoTextureSize,
+            AmbientOcclusionSphereBaker::gpuTileSamples, aoTexels);
+    }
 
     m_dirty = false;
   }
@@ -1033,32 +985,68 @@ AmbientOcclusionSphereGeometry::hits(const Vector3f &rayOrigin,
                      const Vector3f &rayDirection) const
 {
   std::multimap<float, Identifier> result;
+  if (m_identifier.type == InvalidType)
+    return result;
+
+  d->bvh.update(m_spheres, sphereBounds);
+  std::multimap<float, size_t> sphereHits;
+  d->bvh.hits(rayOrigin, rayDirection, (rayEnd - rayOrigin).norm(),
+              AoSphereRayTest(m_spheres, rayOrigin, rayEnd, rayDirection),
+              sphereHits);
+
+  Identifier id;
+  id.molecule = m_identifier.molecule;
+  id.type = m_identifier.type;
+  for (std::multimap<float, size_t>::const_iterator it = sphereHits.begin();
+       it != sphereHits.end(); ++it) {
+    id.index = it->second;
+    result.insert(std::pair<float, Identifier>(it->first, id));
+  }
+  return result;
+}
 
-  // Check for intersection.
-  for (size_t i = 0; i < m_spheres.size(); ++i) {
-    const SphereColor &sphere = m_spheres[i];
-
-    Vector3f distance = sphere.center - rayOrigin;
-    float B = distance.dot(rayDirection);
-    float C = distance.dot(distance) - (sphere.radius * sphere.radius);
-    float D = B * B - C;
-
-    // Test for intersection
-    if (D < 0)
-      continue;
-
-    // Test for clipping
-    if (B < 0 || (sphere.center - rayEnd).dot(rayDirection) > 0)
-      continue;
-
-    Identifier id;
+Identifier AmbientOcclusionSphereGeometry::hit(const Vector3f &rayOrigin,
+                                               const Vector3f &rayEnd,
+                                               const Vector3f &rayDirection,
+                                               float &depth) const
+{
+  Identifier id;
+  if (m_identifier.type == InvalidType)
+    return id;
+
+  d->bvh.update(m_spheres, sphereBounds);
+  size_t index = d->bvh.nearest(rayOrigin, rayDirection,
+                                (rayEnd - rayOrigin).norm(),
+                                AoSphereRayTest(m_spheres, rayOrigin, rayEnd,
+                                                rayDirection),
+                                depth);
+  if (index != MaxIndex) {
     id.molecule = m_identifier.molecule;
     id.type = m_identifier.type;
-    id.index = i;
-    if (id.type != InvalidType) {
-      float rootD = static_cast<float>(sqrt(D));
-      float depth = std::min(std::abs(B + rootD), std::abs(B - rootD));
-      result.insert(std::pair<float, Identifier>(depth, id));
+    id.index = index;
+  }
+  return id;
+}
+
+std::vector<Identifier>
+AmbientOcclusionSphereGeometry::areaHits(const Frustum &frustum) const
+{
+  std::vector<Identifier> result;
+  if (m_identifier.type == InvalidType)
+    return result;
+
+  d->bvh.update(m_spheres, sphereBounds);
+  std::vector<size_t> candidates;
+  d->bvh.overlapping(frustum, candidates);
+  std::sort(candidates.begin(), candidates.end());
+
+  Identifier id;
+  id.molecule = m_identifier.molecule;
+  id.type = m_identifier.type;
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    if (frustum.contains(m_spheres[candidates[i]].center)) {
+      id.index = candidates[i];
+      result.push_back(id);
     }
   }
   return result;
@@ -1068,6 +1056,7 @@ void AmbientOcclusionSphereGeometry::addSphere(const Vector3f &position, const V
                                float radius)
 {
   m_dirty = true;
+  d->bvh.invalidate();
   m_spheres.push_back(SphereColor(position, radius, color));
   m_indices.push_back(m_indices.size());
 }
@@ -1076,6 +1065,7 @@ void AmbientOcclusionSphereGeometry::clear()
 {
   m_spheres.clear();
   m_indices.clear();
+  d->bvh.invalidate();
 }
 
 } // End namespace Rendering
@@ -39,6 +39,9 @@ namespace Rendering {
  * ID for the purposes of picking.
  *
  * Unlike the SphereGeometry class, this class also supports ambient occlusion.
+ * The occlusion maps are baked on the GPU, or by an AmbientOcclusionSphereBaker
+ * when cpuBaking() is set. Maps baked either way are cached, so spheres that
+ * did not move since their maps were baked reuse them.
  */
 
 class AVOGADRORENDERING_EXPORT AmbientOcclusionSphereGeometry : public Drawable
@@ -79,12 +82,32 @@ public:
                                         const Vector3f &rayEnd,
                                         const Vector3f &rayDirection) const;
 
+  /**
+   * Return the sphere hit by the ray closest to its origin.
+   * @sa Drawable::hit()
+   */
+  Identifier hit(const Vector3f &rayOrigin, const Vector3f &rayEnd,
+                 const Vector3f &rayDirection,
+                 float &depth) const AVO_OVERRIDE;
+
+  /**
+   * Return the spheres with their center inside @a frustum.
+   */
+  std::vector<Identifier> areaHits(const Frustum &frustum) const AVO_OVERRIDE;
+
   /**
    * Add a sphere to the geometry object.
    */
   void addSphere(const Vector3f &position, const Vector3ub &color,
                  float radius);
 
+  /**
+   * Bake the ambient occlusion maps with an AmbientOcclusionSphereBaker rather
+   * than on the GPU. This takes effect the next time the spheres change.
+   */
+  void setCpuBaking(bool enable) { m_cpuBaking = enable; }
+  bool cpuBaking() const { return m_cpuBaking; }
+
   /**
    * Get a reference to the spheres.
    */
@@ -105,6 +128,7 @@ private:
   Core::Array<SphereColor> m_spheres;
   Core::Array<size_t> m_indices;
 
+  bool m_cpuBaking;
   bool m_dirty;
 
   class Private;
@@ -126,6 +150,7 @@ inline void swap(AmbientOcclusionSphereGeometry &lhs,
   swap(static_cast<Drawable&>(lhs), static_cast<Drawable&>(rhs));
   swap(lhs.m_spheres, rhs.m_spheres);
   swap(lhs.m_indices, rhs.m_indices);
+  swap(lhs.m_cpuBaking, rhs.m_cpuBaking);
   lhs.m_dirty = rhs.m_dirty = true;
 }
 
@@ -0,0 +1,446 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2014 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include "boundingvolumehierarchy.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Avogadro {
+namespace Rendering {
+
+namespace {
+// Leaves hold up to this many primitives, which are then tested one by one.
+const size_t leafSize = 4;
+
+// Up to one in this many primitives may be enlarged between refits.
+const size_t enlargeFraction = 16;
+
+// The ray with its inverse direction, for the slab test against boxes.
+struct Ray
+{
+  Ray(const Vector3f &origin_, const Vector3f &direction) : origin(origin_)
+  {
+    // Axis aligned rays would give 0 * inf for boxes touching the origin.
+    for (int i = 0; i < 3; ++i) {
+      float d = direction[i];
+      if (std::fabs(d) < 1e-20f)
+        d = d < 0.0f ? -1e-20f : 1e-20f;
+      inverse[i] = 1.0f / d;
+    }
+  }
+
+  // Return the depth at which the ray enters @a box, or a negative value if it
+  // misses the box or enters it beyond @a maxDepth.
+  float enter(const BoundingVolumeHierarchy::Box &box, float maxDepth) const
+  {
+    float tMin = 0.0f;
+    float tMax = maxDepth;
+    for (int i = 0; i < 3; ++i) {
+      float t1 = (box.min()[i] - origin[i]) * inverse[i];
+      float t2 = (box.max()[i] - origin[i]) * inverse[i];
+      if (t1 > t2)
+        std::swap(t1, t2);
+      tMin = std::max(tMin, t1);
+      tMax = std::min(tMax, t2);
+      if (tMin > tMax)
+        return -1.0f;
+    }
+    return tMin;
+  }
+
+  Vector3f origin;
+  Vector3f inverse;
+};
+
+// Classify @a box against @a frustum: -1 if outside, 1 if inside and 0 if it
+// crosses one of the sides.
+int classify(const BoundingVolumeHierarchy::Box &box, const Frustum &frustum)
+{
+  int result = 1;
+  for (int i = 0; i < 4; ++i) {
+    const Vector3f &normal = frustum.planes[i];
+    // The corners of the box furthest into and out of the volume.
+    Vector3f inner;
+    Vector3f outer;
+    for (int j = 0; j < 3; ++j) {
+      inner[j] = normal[j] >= 0.0f ? box.max()[j] : box.min()[j];
+      outer[j] = normal[j] >= 0.0f ? box.min()[j] : box.max()[j];
+    }
+    if ((inner - frustum.points[i]).dot(normal) < 0.0f)
+      return -1;
+    if ((outer - frustum.points[i]).dot(normal) < 0.0f)
+      result = 0;
+  }
+  return result;
+}
+}
+
+// A primitive while the hierarchy is built. These are sorted in place, so they
+// are kept small and the primitives of each node stay together in memory.
+struct BoundingVolumeHierarchy::BuildEntry
+{
+  Vector3f center;
+  size_t index;
+};
+
+// Orders primitives by the position of their center along one axis.
+class BoundingVolumeHierarchy::CenterLess
+{
+public:
+  explicit CenterLess(int axis) : m_axis(axis) {}
+
+  bool operator()(const BuildEntry &a, const BuildEntry &b) const
+  {
+    return a.center[m_axis] < b.center[m_axis];
+  }
+
+private:
+  int m_axis;
+};
+
+BoundingVolumeHierarchy::BoundingVolumeHierarchy()
+  : m_state(Stale), m_movedBegin(0), m_movedEnd(0), m_enlarged(0)
+{
+}
+
+void BoundingVolumeHierarchy::build(const std::vector<Box> &bounds)
+{
+  clear();
+  m_state = Current;
+  if (bounds.empty())
+    return;
+
+  std::vector<BuildEntry> entries(bounds.size());
+  for (size_t i = 0; i < bounds.size(); ++i) {
+    entries[i].center = bounds[i].center();
+    entries[i].index = i;
+  }
+  m_nodes.reserve(2 * (bounds.size() / leafSize + 1));
+  buildNode(bounds, entries, 0, entries.size());
+
+  m_primitives.resize(entries.size());
+  for (size_t i = 0; i < entries.size(); ++i)
+    m_primitives[i] = entries[i].index;
+
+  m_parents.resize(m_nodes.size(), 0);
+  m_leaves.resize(m_primitives.size(), 0);
+  for (size_t i = 0; i < m_nodes.size(); ++i) {
+    const Node &node = m_nodes[i];
+    if (node.second == 0) {
+      for (size_t j = node.first; j < node.first + node.count; ++j)
+        m_leaves[m_primitives[j]] = i;
+    }
+    else {
+      m_parents[i + 1] = i;
+      m_parents[node.second] = i;
+    }
+  }
+}
+
+void BoundingVolumeHierarchy::buildNode(const std::vector<Box> &bounds,
+                                        std::vector<BuildEntry> &entries,
+                                        size_t first, size_t count)
+{
+  size_t index = m_nodes.size();
+  m_nodes.push_back(Node());
+  m_nodes[index].first = first;
+  m_nodes[index].count = count;
+  m_nodes[index].second = 0;
+  m_nodes[index].box.setEmpty();
+
+  if (count <= leafSize) {
+    for (size_t i = first; i < first + count; ++i)
+      m_nodes[index].box.extend(bounds[entries[i].index]);
+    return;
+  }
+
+  Box centerBox;
+  for (size_t i = first; i < first + count; ++i)
+    centerBox.extend(entries[i].center);
+
+  // Split at the median of the longest axis of the centers, which keeps the
+  // tree balanced whatever the distribution of the primitives.
+  int axis;
+  centerBox.sizes().maxCoeff(&axis);
+  size_t half = count / 2;
+  std::vector<BuildEntry>::iterator begin = entries.begin() + first;
+  std::nth_element(begin, begin + half, begin + count, CenterLess(axis));
+
+  buildNode(bounds, entries, first, half);
+  size_t second = m_nodes.size();
+  m_nodes[index].second = second;
+  buildNode(bounds, entries, first + half, count - half);
+  m_nodes[index].box = m_nodes[index + 1].box.merged(m_nodes[second].box);
+}
+
+void BoundingVolumeHierarchy::refit(const std::vector<Box> &bounds)
+{
+  if (bounds.size() != m_primitives.size()) {
+    build(bounds);
+    return;
+  }
+
+  // Children follow their parent, so walking backwards visits them first.
+  for (size_t i = m_nodes.size(); i-- > 0;) {
+    Node &node = m_nodes[i];
+    if (node.second == 0) {
+      node.box.setEmpty();
+      for (size_t j = node.first; j < node.first + node.count; ++j)
+        node.box.extend(bounds[m_primitives[j]]);
+    }
+    else {
+      node.box = m_nodes[i + 1].box.merged(m_nodes[node.second].box);
+    }
+  }
+  m_state = Current;
+  m_movedBegin = m_movedEnd = 0;
+  m_enlarged = 0;
+}
+
+void BoundingVolumeHierarchy::enlarge(size_t index, const Box &box)
+{
+  if (index >= m_leaves.size())
+    return;
+  size_t node = m_leaves[index];
+  while (!m_nodes[node].box.contains(box)) {
+    m_nodes[node].box.extend(box);
+    if (node == 0)
+      break;
+    node = m_parents[node];
+  }
+}
+
+void BoundingVolumeHierarchy::clear()
+{
+  m_nodes.clear();
+  m_primitives.clear();
+  m_parents.clear();
+  m_leaves.clear();
+  m_state = Stale;
+  m_movedBegin = m_movedEnd = 0;
+  m_enlarged = 0;
+}
+
+void BoundingVolumeHierarchy::markMoved(size_t begin, size_t end)
+{
+  if (begin >= end || m_state == Stale)
+    return;
+  if (m_state == Current) {
+    m_state = Moved;
+    m_movedBegin = begin;
+    m_movedEnd = end;
+  }
+  else {
+    m_movedBegin = std::min(m_movedBegin, begin);
+    m_movedEnd = std::max(m_movedEnd, end);
+  }
+}
+
+void BoundingVolumeHierarchy::invalidate()
+{
+  m_state = Stale;
+  m_movedBegin = m_movedEnd = 0;
+}
+
+BoundingVolumeHierarchy::Update
+BoundingVolumeHierarchy::nextUpdate(size_t count, size_t &begin, size_t &end)
+{
+  State state = count == m_primitives.size() ? m_state : Stale;
+  begin = m_movedBegin;
+  end = std::min(m_movedEnd, count);
+  m_state = Current;
+  m_movedBegin = m_movedEnd = 0;
+
+  if (state == Current)
+    return NoUpdate;
+  if (state == Stale)
+    return BuildUpdate;
+  // A few moved primitives, for example while an atom is dragged, only grow
+  // the boxes until enough have been enlarged to refit them to.
+  const size_t moved = end > begin ? end - begin : 0;
+  if ((m_enlarged + moved) * enlargeFraction < count) {
+    m_enlarged += moved;
+    return EnlargeUpdate;
+  }
+  return RefitUpdate;
+}
+
+size_t BoundingVolumeHierarchy::nearest(const Vector3f &origin,
+                                        const Vector3f &direction,
+                                        float maxDistance, const RayTest &test,
+                                        float &distance) const
+{
+  size_t result = MaxIndex;
+  if (m_nodes.empty() || !(maxDistance >= 0.0f))
+    return result;
+
+  Ray ray(origin, direction);
+  float best = maxDistance;
+  if (ray.enter(m_nodes[0].box, best) < 0.0f)
+    return result;
+
+  // Nodes are visited nearest first, and skipped once they start beyond the
+  // closest hit found so far.
+  std::vector<std::pair<float, size_t> > stack;
+  stack.reserve(64);
+  stack.push_back(std::make_pair(0.0f, static_cast<size_t>(0)));
+  while (!stack.empty()) {
+    std::pair<float, size_t> entry = stack.back();
+    stack.pop_back();
+    if (entry.first > best)
+      continue;
+
+    const Node &node = m_nodes[entry.second];
+    if (node.second == 0) {
+      for (size_t i = node.first; i < node.first + node.count; ++i) {
+        float depth;
+        if (test.intersect(m_primitives[i], depth) && depth <= best
+            && (result == MaxIndex || depth < best
+                || m_primitives[i] < result)) {
+          best = depth;
+          result = m_primitives[i];
+        }
+      }
+      continue;
+    }
+
+    size_t firstChild = entry.second + 1;
+    size_t secondChild = node.second;
+    float firstDepth = ray.enter(m_nodes[firstChild].box, best);
+    float secondDepth = ray.enter(m_nodes[secondChild].box, best);
+    if (firstDepth >= 0.0f && secondDepth >= 0.0f) {
+      if (firstDepth <= secondDepth) {
+        stack.push_back(std::make_pair(secondDepth, secondChild));
+        stack.push_back(std::make_pair(firstDepth, firstChild));
+      }
+      else {
+        stack.push_back(std::make_pair(firstDepth, firstChild));
+        stack.push_back(std::make_pair(secondDepth, secondChild));
+      }
+    }
+    else if (firstDepth >= 0.0f) {
+      stack.push_back(std::make_pair(firstDepth, firstChild));
+    }
+    else if (secondDepth >= 0.0f) {
+      stack.push_back(std::make_pair(secondDepth, secondChild));
+    }
+  }
+
+  if (result != MaxIndex)
+    distance = best;
+  return result;
+}
+
+bool BoundingVolumeHierarchy::intersects(const Vector3f &origin,
+                                         const Vector3f &direction,
+                                         float maxDistance,
+                                         const RayTest &test) const
+{
+  if (m_nodes.empty() || !(maxDistance >= 0.0f))
+    return false;
+
+  Ray ray(origin, direction);
+  std::vector<size_t> stack;
+  stack.reserve(64);
+  stack.push_back(0);
+  while (!stack.empty()) {
+    const size_t index = stack.back();
+    stack.pop_back();
+    const Node &node = m_nodes[index];
+    if (ray.enter(node.box, maxDistance) < 0.0f)
+      continue;
+
+    if (node.second == 0) {
+      for (size_t i = node.first; i < node.first + node.count; ++i) {
+        float depth;
+        if (test.intersect(m_primitives[i], depth))
+          return true;
+      }
+    }
+    else {
+      stack.push_back(node.second);
+      stack.push_back(index + 1);
+    }
+  }
+  return false;
+}
+
+void BoundingVolumeHierarchy::hits(const Vector3f &origin,
+                                   const Vector3f &direction,
+                                   float maxDistance, const RayTest &test,
+                                   std::multimap<float, size_t> &result) const
+{
+  if (m_nodes.empty() || !(maxDistance >= 0.0f))
+    return;
+
+  Ray ray(origin, direction);
+  std::vector<size_t> stack;
+  stack.reserve(64);
+  stack.push_back(0);
+  while (!stack.empty()) {
+    const size_t index = stack.back();
+    stack.pop_back();
+    const Node &node = m_nodes[index];
+    if (ray.enter(node.box, maxDistance) < 0.0f)
+      continue;
+
+    if (node.second == 0) {
+      for (size_t i = node.first; i < node.first + node.count; ++i) {
+        float depth;
+        if (test.intersect(m_primitives[i], depth))
+          result.insert(std::make_pair(depth, m_primitives[i]));
+      }
+    }
+    else {
+      stack.push_back(node.second);
+      stack.push_back(index + 1);
+    }
+  }
+}
+
+void BoundingVolumeHierarchy::overlapping(const Frustum &frustum,
+                                          std::vector<size_t> &result) const
+{
+  if (m_nodes.empty())
+    return;
+
+  std::vector<size_t> stack;
+  stack.reserve(64);
+  stack.push_back(0);
+  while (!stack.empty()) {
+    const size_t index = stack.back();
+    stack.pop_back();
+    const Node &node = m_nodes[index];
+    int side = classify(node.box, frustum);
+    if (side < 0)
+      continue;
+
+    // Everything below a node inside the volume is added without testing, the
+    // primitives of leaves crossing a side are left to the caller to test.
+    if (side > 0 || node.second == 0) {
+      result.insert(result.end(), m_primitives.begin() + node.first,
+                    m_primitives.begin() + node.first + node.count);
+    }
+    else {
+      stack.push_back(node.second);
+      stack.push_back(index + 1);
+    }
+  }
+}
+
+} // End Rendering namespace
+} // End Avogadro namespace
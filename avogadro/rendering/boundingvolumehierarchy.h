@@ -0,0 +1,223 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2014 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#ifndef AVOGADRO_RENDERING_BOUNDINGVOLUMEHIERARCHY_H
+#define AVOGADRO_RENDERING_BOUNDINGVOLUMEHIERARCHY_H
+
+#include "avogadrorenderingexport.h"
+
+#include "primitive.h"
+
+#include <map>
+#include <vector>
+
+namespace Avogadro {
+namespace Rendering {
+
+/**
+ * @class BoundingVolumeHierarchy boundingvolumehierarchy.h
+ * <avogadro/rendering/boundingvolumehierarchy.h>
+ * @brief Tree of axis aligned boxes used to find the primitives of a drawable
+ * that are hit by a ray, or lie within a Frustum, without testing each one.
+ *
+ * The hierarchy only knows the bounding box of each primitive, the exact test
+ * for a ray is supplied by the drawable through a RayTest. When primitives
+ * move but their number does not change, refit() updates the boxes of the
+ * existing tree, which is much cheaper than building it again, and enlarge()
+ * is cheaper still when only a few of them moved.
+ *
+ * Drawables report their changes through markMoved() and invalidate(), and
+ * call update() before a query, which picks the cheapest of these.
+ */
+
+class AVOGADRORENDERING_EXPORT BoundingVolumeHierarchy
+{
+public:
+  typedef Eigen::AlignedBox<float, 3> Box;
+
+  /**
+   * The exact intersection test of a ray with the primitives.
+   */
+  class RayTest
+  {
+  public:
+    virtual ~RayTest() {}
+
+    /**
+     * Return true if the primitive @a index is hit by the ray, setting
+     * @a distance to the depth of the hit.
+     */
+    virtual bool intersect(size_t index, float &distance) const = 0;
+  };
+
+  BoundingVolumeHierarchy();
+
+  /**
+   * Build the hierarchy for primitives with the bounding boxes @a bounds.
+   */
+  void build(const std::vector<Box> &bounds);
+
+  /**
+   * Update the boxes of the hierarchy after the primitives moved, the number
+   * of primitives must be the same as when it was built.
+   */
+  void refit(const std::vector<Box> &bounds);
+
+  /**
+   * Grow the boxes containing the primitive @a index so that they also contain
+   * @a box. This is faster than refit() when a few primitives move, the boxes
+   * only become less tight.
+   */
+  void enlarge(size_t index, const Box &box);
+
+  /**
+   * Remove all of the primitives.
+   */
+  void clear();
+
+  /**
+   * Mark the primitives from @a begin up to, but not including, @a end as
+   * moved, so that the next update() enlarges or refits their boxes.
+   */
+  void markMoved(size_t begin, size_t end);
+
+  /**
+   * Mark the hierarchy as out of date, for example after primitives were added
+   * or removed, so that the next update() builds it again.
+   */
+  void invalidate();
+
+  /**
+   * Bring the hierarchy up to date with @a primitives, where
+   * @a bounds(primitives[i]) is the bounding box of the primitive i. A few
+   * moved primitives only enlarge the boxes. As the enlarged boxes grow looser
+   * with every move, the hierarchy is refit once enough of them have been
+   * enlarged since it was last refit or built.
+   */
+  template<typename Primitives, typename BoundsFunction>
+  void update(const Primitives &primitives, BoundsFunction bounds);
+
+  /**
+   * The number of primitives in the hierarchy.
+   */
+  size_t size() const { return m_primitives.size(); }
+
+  /**
+   * Return the primitive with the smallest depth hit by the ray, or MaxIndex
+   * if there is none.
+   * @param origin Origin of the ray.
+   * @param direction Normalized direction of the ray.
+   * @param maxDistance Length of the ray.
+   * @param test The exact test for the primitives.
+   * @param distance Set to the depth of the hit.
+   */
+  size_t nearest(const Vector3f &origin, const Vector3f &direction,
+                 float maxDistance, const RayTest &test,
+                 float &distance) const;
+
+  /**
+   * Return true if any primitive is hit by the ray, stopping at the first one
+   * found. This is cheaper than nearest() for shadow and occlusion rays.
+   * @sa nearest()
+   */
+  bool intersects(const Vector3f &origin, const Vector3f &direction,
+                  float maxDistance, const RayTest &test) const;
+
+  /**
+   * Add all primitives hit by the ray to @a result, mapped by their depth.
+   * @sa nearest()
+   */
+  void hits(const Vector3f &origin, const Vector3f &direction,
+            float maxDistance, const RayTest &test,
+            std::multimap<float, size_t> &result) const;
+
+  /**
+   * Add the primitives that may be inside @a frustum to @a result, in no
+   * particular order. All of the primitives inside are added, along with some
+   * close to its sides, which should be tested by the caller.
+   */
+  void overlapping(const Frustum &frustum, std::vector<size_t> &result) const;
+
+private:
+  // The nodes are stored depth first, so the first child of a node follows
+  // it and the primitives below a node are contiguous in m_primitives.
+  struct Node
+  {
+    Box box;
+    size_t first;
+    size_t count;
+    /** The second child, zero for leaves. */
+    size_t second;
+  };
+
+  struct BuildEntry;
+  class CenterLess;
+
+  enum State { Current, Moved, Stale };
+  enum Update { NoUpdate, EnlargeUpdate, RefitUpdate, BuildUpdate };
+
+  /**
+   * Choose how to update the hierarchy for @a count primitives, and set
+   * @a begin and @a end to the range of the moved ones. The hierarchy is
+   * taken to be current afterwards.
+   */
+  Update nextUpdate(size_t count, size_t &begin, size_t &end);
+
+  void buildNode(const std::vector<Box> &bounds,
+                 std::vector<BuildEntry> &entries, size_t first, size_t count);
+
+  std::vector<Node> m_nodes;
+  std::vector<size_t> m_primitives;
+  /** The parent of each node, and the leaf holding each primitive. */
+  std::vector<size_t> m_parents;
+  std::vector<size_t> m_leaves;
+
+  State m_state;
+  size_t m_movedBegin;
+  size_t m_movedEnd;
+  /** The number of primitives enlarged since the last refit or build. */
+  size_t m_enlarged;
+};
+
+template<typename Primitives, typename BoundsFunction>
+void BoundingVolumeHierarchy::update(const Primitives &primitives,
+                                     BoundsFunction bounds)
+{
+  size_t begin;
+  size_t end;
+  Update next = nextUpdate(primitives.size(), begin, end);
+  if (next == NoUpdate)
+    return;
+  if (next == EnlargeUpdate) {
+    for (size_t i = begin; i < end; ++i)
+      enlarge(i, bounds(primitives[i]));
+    return;
+  }
+
+  std::vector<Box> boxes;
+  boxes.reserve(primitives.size());
+  for (size_t i = 0; i < primitives.size(); ++i)
+    boxes.push_back(bounds(primitives[i]));
+  if (next == RefitUpdate)
+    refit(boxes);
+  else
+    build(boxes);
+}
+
+} // End Rendering namespace
+} // End Avogadro namespace
+
+#endif // AVOGADRO_RENDERING_BOUNDINGVOLUMEHIERARCHY_H
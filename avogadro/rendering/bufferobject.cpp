@@ -32,17 +32,31 @@ inline GLenum convertType(BufferObject::ObjectType type)
     return GL_ELEMENT_ARRAY_BUFFER;
   }
 }
+
+inline GLenum convertUsage(BufferObject::UsageHint usage)
+{
+  switch (usage) {
+  default:
+  case BufferObject::StaticDraw:
+    return GL_STATIC_DRAW;
+  case BufferObject::DynamicDraw:
+    return GL_DYNAMIC_DRAW;
+  case BufferObject::StreamDraw:
+    return GL_STREAM_DRAW;
+  }
+}
 }
 
 struct BufferObject::Private
 {
-  Private() : handle(0) {}
+  Private() : handle(0), size(0) {}
   GLenum type;
   GLuint handle;
+  size_t size;
 };
 
 BufferObject::BufferObject(ObjectType type_)
-  : d(new Private), m_dirty(true)
+  : d(new Private), m_dirty(true), m_usage(StaticDraw)
 {
   if (type_ == ArrayBuffer)
     d->type = GL_ARRAY_BUFFER;
@@ -101,11 +115,41 @@ bool BufferObject::uploadInternal(const void *buffer, size_t size,
     return false;
   }
   glBindBuffer(d->type, d->handle);
-  glBufferData(d->type, size, static_cast<const GLvoid *>(buffer),
-               GL_STATIC_DRAW);
+  if (m_usage != StaticDraw && !m_dirty && size == d->size) {
+    // Orphan the current storage rather than synchronizing with draws that
+    // may still be reading from it.
+    glBufferData(d->type, size, NULL, convertUsage(m_usage));
+    glBufferSubData(d->type, 0, static_cast<GLsizeiptr>(size),
+                    static_cast<const GLvoid *>(buffer));
+  }
+  else {
+    glBufferData(d->type, size, static_cast<const GLvoid *>(buffer),
+                 convertUsage(m_usage));
+  }
+  d->size = size;
   m_dirty = false;
   return true;
 }
 
+bool BufferObject::uploadRangeInternal(const void *buffer, size_t offset,
+                                       size_t size)
+{
+  if (d->handle == 0 || m_dirty) {
+    m_error = "Trying to update part of a buffer that has not been uploaded.";
+    return false;
+  }
+  if (offset > d->size || size > d->size - offset) {
+    m_error = "Trying to update a range outside of the buffer.";
+    return false;
+  }
+  if (offset == 0 && size == d->size && m_usage != StaticDraw)
+    return uploadInternal(buffer, size, type());
+  glBindBuffer(d->type, d->handle);
+  glBufferSubData(d->type, static_cast<GLintptr>(offset),
+                  static_cast<GLsizeiptr>(size),
+                  static_cast<const GLvoid *>(buffer));
+  return true;
+}
+
 } // End Rendering namespace
 } // End Avogadro namespace
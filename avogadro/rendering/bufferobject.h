@@ -44,6 +44,19 @@ public:
     ElementArrayBuffer
   };
 
+  /**
+   * How often the contents of the buffer are expected to change, passed on to
+   * OpenGL when the storage of the buffer is allocated.
+   */
+  enum UsageHint {
+    /** Uploaded once and drawn many times, the default. */
+    StaticDraw,
+    /** Changed repeatedly, for example while atoms are being edited. */
+    DynamicDraw,
+    /** Replaced for about every frame drawn, as when playing a trajectory. */
+    StreamDraw
+  };
+
   BufferObject(ObjectType type = ArrayBuffer);
   ~BufferObject();
 
@@ -53,6 +66,15 @@ public:
   /** Get the handle of the buffer object. */
   Index handle() const;
 
+  /**
+   * The usage hint of the buffer, which takes effect the next time the whole
+   * buffer is uploaded.
+   * @{
+   */
+  void setUsage(UsageHint hint) { m_usage = hint; }
+  UsageHint usage() const { return m_usage; }
+  /** @} */
+
   /** Determine if the buffer object is ready to be used. */
   bool ready() const { return m_dirty == false; }
 
@@ -69,6 +91,19 @@ public:
   template <class ContainerT>
   bool upload(const ContainerT &array, ObjectType type);
 
+  /**
+   * Replace part of the data previously uploaded, starting at the element
+   * @a offset, with the values in @a array. The range must lie within the data
+   * last passed to upload(), and the value type must be the same.
+   *
+   * Replacing all of the data with a buffer that is not StaticDraw orphans
+   * its storage first, so that the driver can allocate new storage rather than
+   * waiting for draws still using the old data to complete. Consecutive frames
+   * of an animation are then effectively double buffered.
+   */
+  template <class ContainerT>
+  bool uploadRange(const ContainerT &array, size_t offset);
+
   /** Bind the buffer object ready for rendering.
    * @note Only one ARRAY_BUFFER and one ELEMENT_ARRAY_BUFFER may be bound at
    * any time. */
@@ -82,10 +117,12 @@ public:
 
 private:
   bool uploadInternal(const void *buffer, size_t size, ObjectType objectType);
+  bool uploadRangeInternal(const void *buffer, size_t offset, size_t size);
 
   struct Private;
   Private *d;
   bool  m_dirty;
+  UsageHint m_usage;
 
   std::string m_error;
 };
@@ -102,6 +139,16 @@ inline bool BufferObject::upload(const ContainerT &array,
       array.size() * sizeof(typename ContainerT::value_type), objectType);
 }
 
+template <class ContainerT>
+inline bool BufferObject::uploadRange(const ContainerT &array, size_t offset)
+{
+  if (array.empty())
+    return true;
+  return uploadRangeInternal(&array[0],
+      offset * sizeof(typename ContainerT::value_type),
+      array.size() * sizeof(typename ContainerT::value_type));
+}
+
 } // End Rendering namespace
 } // End Avogadro namespace
 
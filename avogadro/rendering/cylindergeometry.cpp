@@ -20,6 +20,7 @@
 #include "camera.h"
 #include "scene.h"
 
+#include "boundingvolumehierarchy.h"
 #include "bufferobject.h"
 
 #include "shader.h"
@@ -28,12 +29,15 @@
 namespace {
 #include "cylinders_vs.h"
 #include "cylinders_fs.h"
+#include "cylinders_instanced_vs.h"
 }
 
 #include "avogadrogl.h"
 
 #include <avogadro/core/matrix.h>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 using std::cout;
@@ -42,20 +46,150 @@ using std::endl;
 namespace Avogadro {
 namespace Rendering {
 
+namespace {
+// Points per circle, each cylinder is a tube of twice as many vertices.
+const unsigned int resolution = 12;
+
+void addCylinderVertices(const CylinderColor &cylinder,
+                         std::vector<ColorNormalVertex> &vertices)
+{
+  const float resolutionRadians =
+      2.0f * static_cast<float>(M_PI) / static_cast<float>(resolution);
+  const Vector3f &position1 = cylinder.end1;
+  const Vector3f &position2 = cylinder.end2;
+  const Vector3f direction = (position2 - position1).normalized();
+
+  // Generate the radial vectors, and the tube around them.
+  Vector3f radial = direction.unitOrthogonal() * cylinder.radius;
+  Eigen::AngleAxisf transform(resolutionRadians, direction);
+  ColorNormalVertex vert(cylinder.color, -direction, position1);
+  ColorNormalVertex vert2(cylinder.color2, -direction, position1);
+  for (unsigned int j = 0; j < resolution; ++j) {
+    vert.normal = radial;
+    vert.vertex = position1 + radial;
+    vertices.push_back(vert);
+    vert2.normal = vert.normal;
+    vert2.vertex = position2 + radial;
+    vertices.push_back(vert2);
+    radial = transform * radial;
+  }
+}
+
+// Stitch the tube of vertices starting at tubeStart together.
+void addTubeIndices(unsigned int tubeStart, std::vector<unsigned int> &indices)
+{
+  for (unsigned int j = 0; j < resolution; ++j) {
+    unsigned int r1 = j + j;
+    unsigned int r2 = (j != 0 ? r1 : resolution + resolution) - 2;
+    indices.push_back(tubeStart + r1);
+    indices.push_back(tubeStart + r1 + 1);
+    indices.push_back(tubeStart + r2);
+
+    indices.push_back(tubeStart + r2);
+    indices.push_back(tubeStart + r1 + 1);
+    indices.push_back(tubeStart + r2 + 1);
+  }
+}
+
+// Tests a ray against the cylinders, clipped to the segment between the ends.
+class CylinderRayTest : public BoundingVolumeHierarchy::RayTest
+{
+public:
+  CylinderRayTest(const std::vector<CylinderColor> &cylinders,
+                  const Vector3f &rayOrigin, const Vector3f &rayEnd,
+                  const Vector3f &rayDirection)
+    : m_cylinders(cylinders), m_rayOrigin(rayOrigin), m_rayEnd(rayEnd),
+      m_rayDirection(rayDirection)
+  {
+  }
+
+  bool intersect(size_t index, float &depth) const
+  {
+    const CylinderColor &cylinder = m_cylinders[index];
+
+    // Check for cylinder intersection with the ray.
+    Vector3f ao = m_rayOrigin - cylinder.end1;
+    Vector3f ab = cylinder.end2 - cylinder.end1;
+    Vector3f aoxab = ao.cross(ab);
+    Vector3f vxab = m_rayDirection.cross(ab);
+
+    float A = vxab.dot(vxab);
+    float B = 2.0f * vxab.dot(aoxab);
+    float C = aoxab.dot(aoxab) - ab.dot(ab) * (cylinder.radius * cylinder.radius);
+    float D = B * B - 4.0f * A * C;
+
+    // no intersection
+    if (D < 0.0f)
+      return false;
+
+    float t = std::min((-B + std::sqrt(D)) / (2.0f * A),
+                       (-B - std::sqrt(D)) / (2.0f * A));
+
+    Vector3f ip = m_rayOrigin + (m_rayDirection * t);
+    Vector3f ip1 = ip - cylinder.end1;
+    Vector3f ip2 = ip - (cylinder.end1 + ab);
+
+    // intersection below base or above top of the cylinder
+    if (ip1.dot(ab) < 0.0f || ip2.dot(ab) > 0.0f)
+      return false;
+
+    // Test for clipping
+    Vector3f distance = ip - m_rayOrigin;
+    if (distance.dot(m_rayDirection) < 0.0f
+        || (ip - m_rayEnd).dot(m_rayDirection) > 0.0f)
+      return false;
+
+    depth = distance.norm();
+    return true;
+  }
+
+private:
+  const std::vector<CylinderColor> &m_cylinders;
+  Vector3f m_rayOrigin;
+  Vector3f m_rayEnd;
+  Vector3f m_rayDirection;
+};
+
+// The bounding box of a cylinder for picking.
+BoundingVolumeHierarchy::Box cylinderBounds(const CylinderColor &cylinder)
+{
+  Vector3f radius(Vector3f::Constant(cylinder.radius));
+  return BoundingVolumeHierarchy::Box(
+        cylinder.end1.cwiseMin(cylinder.end2) - radius,
+        cylinder.end1.cwiseMax(cylinder.end2) + radius);
+}
+}
+
 class CylinderGeometry::Private
 {
 public:
-  Private() { }
+  Private()
+    : instanced(false), numberOfInstances(0)
+  {
+  }
+
+  // Draw the tubes built on the CPU, or one instance per cylinder.
+  void drawVertices();
+  void drawInstances();
 
   BufferObject vbo;
   BufferObject ibo;
 
+  // With instancing vbo holds the cylinders as they are stored, and each one
+  // is drawn over a single tube in tubeVbo and ibo.
+  bool instanced;
+  BufferObject tubeVbo;
+  size_t numberOfInstances;
+
   Shader vertexShader;
   Shader fragmentShader;
   ShaderProgram program;
 
   size_t numberOfVertices;
   size_t numberOfIndices;
+
+  // Picking hierarchy, brought up to date on the first pick after a change.
+  BoundingVolumeHierarchy bvh;
 };
 
 CylinderGeometry::CylinderGeometry() : m_dirty(false), d(new Private)
@@ -87,19 +221,20 @@ void CylinderGeometry::update()
   if (m_indices.empty() || m_cylinders.empty())
     return;
 
-  // Check if the VBOs are ready, if not get them ready.
-  if (!d->vbo.ready() || m_dirty) {
-    // Set some defaults for our cylinders.
-    const unsigned int resolution = 12; // points per circle
-    const float resolutionRadians =
-        2.0f * static_cast<float>(M_PI) / static_cast<float>(resolution);
-    std::vector<Vector3f> radials;
-    radials.reserve(resolution);
+  // Instancing is used when the context supports it, decided once before the
+  // shaders are built.
+  if (d->vertexShader.type() == Shader::Unknown)
+    d->instanced = ShaderProgram::supportsInstancing();
 
+  if (d->instanced) {
+    updateInstances();
+  }
+  // Check if the VBOs are ready, if not get them ready.
+  else if (!d->vbo.ready() || m_dirty) {
     std::vector<unsigned int> cylinderIndices;
     std::vector<ColorNormalVertex> cylinderVertices;
-    //cylinderIndices.reserve(m_indices.size() * 4);
-    //cylinderVertices.reserve(m_cylinders.size() * 4);
+    cylinderIndices.reserve(m_cylinders.size() * resolution * 6);
+    cylinderVertices.reserve(m_cylinders.size() * resolution * 2);
 
     std::vector<size_t>::const_iterator itIndex = m_indices.begin();
     std::vector<CylinderColor>::const_iterator itCylinder = m_cylinders.begin();
@@ -107,47 +242,11 @@ void CylinderGeometry::update()
     for (unsigned int i = 0;
          itIndex != m_indices.end() && itCylinder != m_cylinders.end();
          ++i, ++itIndex, ++itCylinder) {
-
-      const Vector3f &position1 = itCylinder->end1;
-      const Vector3f &position2 = itCylinder->end2;
-      const Vector3f direction = (position2 - position1).normalized();
-      float radius = itCylinder->radius;
-
-      // Generate the radial vectors
-      Vector3f radial = direction.unitOrthogonal() * radius;
-      Eigen::AngleAxisf transform(resolutionRadians, direction);
-      radials.clear();
-      for (unsigned int j = 0; j < resolution; ++j) {
-        radials.push_back(radial);
-        radial = transform * radial;
-      }
-
       // Cylinder
-      ColorNormalVertex vert(itCylinder->color, -direction, position1);
-      ColorNormalVertex vert2(itCylinder->color2, -direction, position1);
       const unsigned int tubeStart =
           static_cast<unsigned int>(cylinderVertices.size());
-      for (std::vector<Vector3f>::const_iterator it = radials.begin(),
-           itEnd = radials.end(); it != itEnd; ++it) {
-        vert.normal = *it;
-        vert.vertex = position1 + *it;
-        cylinderVertices.push_back(vert);
-        vert2.normal = vert.normal;
-        vert2.vertex = position2 + *it;
-        cylinderVertices.push_back(vert2);
-      }
-      // Now to stitch it together.
-      for (unsigned int j = 0; j < resolution; ++j) {
-        unsigned int r1 = j + j;
-        unsigned int r2 = (j != 0 ? r1 : resolution + resolution) - 2;
-        cylinderIndices.push_back(tubeStart + r1);
-        cylinderIndices.push_back(tubeStart + r1 + 1);
-        cylinderIndices.push_back(tubeStart + r2);
-
-        cylinderIndices.push_back(tubeStart + r2);
-        cylinderIndices.push_back(tubeStart + r1 + 1);
-        cylinderIndices.push_back(tubeStart + r2 + 1);
-      }
+      addCylinderVertices(*itCylinder, cylinderVertices);
+      addTubeIndices(tubeStart, cylinderIndices);
     }
 
     d->vbo.upload(cylinderVertices, BufferObject::ArrayBuffer);
@@ -156,12 +255,27 @@ void CylinderGeometry::update()
     d->numberOfIndices = cylinderIndices.size();
 
     m_dirty = false;
+    clearDirty();
+  }
+  else if (m_dirtyBegin < m_dirtyEnd) {
+    // Only the vertices of the cylinders that changed are uploaded, into a
+    // buffer that is streamed when all of them change, as in an animation.
+    size_t end = std::min(m_dirtyEnd, m_cylinders.size());
+    std::vector<ColorNormalVertex> cylinderVertices;
+    cylinderVertices.reserve((end - m_dirtyBegin) * resolution * 2);
+    for (size_t i = m_dirtyBegin; i < end; ++i)
+      addCylinderVertices(m_cylinders[i], cylinderVertices);
+    d->vbo.setUsage(dirtyUsage(m_cylinders.size()));
+    if (!d->vbo.uploadRange(cylinderVertices, m_dirtyBegin * resolution * 2))
+      cout << d->vbo.error() << endl;
+    clearDirty();
   }
 
   // Build and link the shader if it has not been used yet.
   if (d->vertexShader.type() == Shader::Unknown) {
     d->vertexShader.setType(Shader::Vertex);
-    d->vertexShader.setSource(cylinders_vs);
+    d->vertexShader.setSource(d->instanced ? cylinders_instanced_vs
+                                           : cylinders_vs);
     d->fragmentShader.setType(Shader::Fragment);
     d->fragmentShader.setSource(cylinders_fs);
     if (!d->vertexShader.compile())
@@ -175,6 +289,48 @@ void CylinderGeometry::update()
   }
 }
 
+void CylinderGeometry::updateInstances()
+{
+  // One tube around the z axis, of unit radius and length, with the cosine and
+  // sine of the angle around it in x and y.
+  if (!d->tubeVbo.ready()) {
+    const float resolutionRadians =
+        2.0f * static_cast<float>(M_PI) / static_cast<float>(resolution);
+    std::vector<Vector3f> tube;
+    std::vector<unsigned int> tubeIndices;
+    for (unsigned int j = 0; j < resolution; ++j) {
+      float angle = resolutionRadians * static_cast<float>(j);
+      tube.push_back(Vector3f(std::cos(angle), std::sin(angle), 0.0f));
+      tube.push_back(Vector3f(std::cos(angle), std::sin(angle), 1.0f));
+    }
+    addTubeIndices(0, tubeIndices);
+    if (!d->tubeVbo.upload(tube, BufferObject::ArrayBuffer))
+      cout << d->tubeVbo.error() << endl;
+    if (!d->ibo.upload(tubeIndices, BufferObject::ElementArrayBuffer))
+      cout << d->ibo.error() << endl;
+    d->numberOfVertices = tube.size();
+    d->numberOfIndices = tubeIndices.size();
+  }
+
+  // The cylinders need no conversion, so there is nothing to build on the CPU.
+  if (!d->vbo.ready() || m_dirty) {
+    if (!d->vbo.upload(m_cylinders, BufferObject::ArrayBuffer))
+      cout << d->vbo.error() << endl;
+    d->numberOfInstances = m_cylinders.size();
+    m_dirty = false;
+    clearDirty();
+  }
+  else if (m_dirtyBegin < m_dirtyEnd) {
+    size_t end = std::min(m_dirtyEnd, m_cylinders.size());
+    std::vector<CylinderColor> cylinders(m_cylinders.begin() + m_dirtyBegin,
+                                         m_cylinders.begin() + end);
+    d->vbo.setUsage(dirtyUsage(m_cylinders.size()));
+    if (!d->vbo.uploadRange(cylinders, m_dirtyBegin))
+      cout << d->vbo.error() << endl;
+    clearDirty();
+  }
+}
+
 void CylinderGeometry::render(const Camera &camera)
 {
   if (m_indices.empty() || m_cylinders.empty())
@@ -186,35 +342,6 @@ void CylinderGeometry::render(const Camera &camera)
   if (!d->program.bind())
     cout << d->program.error() << endl;
 
-  d->vbo.bind();
-  d->ibo.bind();
-
-  // Set up our attribute arrays.
-  if (!d->program.enableAttributeArray("vertex"))
-    cout << d->program.error() << endl;
-  if (!d->program.useAttributeArray("vertex",
-                                    ColorNormalVertex::vertexOffset(),
-                                    sizeof(ColorNormalVertex),
-                                    FloatType, 3, ShaderProgram::NoNormalize)) {
-    cout << d->program.error() << endl;
-  }
-  if (!d->program.enableAttributeArray("color"))
-    cout << d->program.error() << endl;
-  if (!d->program.useAttributeArray("color",
-                                    ColorNormalVertex::colorOffset(),
-                                    sizeof(ColorNormalVertex),
-                                    UCharType, 3, ShaderProgram::Normalize)) {
-    cout << d->program.error() << endl;
-  }
-  if (!d->program.enableAttributeArray("normal"))
-    cout << d->program.error() << endl;
-  if (!d->program.useAttributeArray("normal",
-                                    ColorNormalVertex::normalOffset(),
-                                    sizeof(ColorNormalVertex),
-                                    FloatType, 3, ShaderProgram::NoNormalize)) {
-    cout << d->program.error() << endl;
-  }
-
   // Set up our uniforms (model-view and projection matrices right now).
   if (!d->program.setUniformValue("modelView",
                                   camera.modelView().matrix())) {
@@ -229,21 +356,130 @@ void CylinderGeometry::render(const Camera &camera)
   if (!d->program.setUniformValue("normalMatrix", normalMatrix))
     std::cout << d->program.error() << std::endl;
 
-  // Render the loaded spheres using the shader and bound VBO.
+  if (d->instanced)
+    d->drawInstances();
+  else
+    d->drawVertices();
+
+  d->program.release();
+}
+
+void CylinderGeometry::Private::drawVertices()
+{
+  vbo.bind();
+  ibo.bind();
+
+  // Set up our attribute arrays.
+  if (!program.enableAttributeArray("vertex"))
+    cout << program.error() << endl;
+  if (!program.useAttributeArray("vertex",
+                                 ColorNormalVertex::vertexOffset(),
+                                 sizeof(ColorNormalVertex),
+                                 FloatType, 3, ShaderProgram::NoNormalize)) {
+    cout << program.error() << endl;
+  }
+  if (!program.enableAttributeArray("color"))
+    cout << program.error() << endl;
+  if (!program.useAttributeArray("color",
+                                 ColorNormalVertex::colorOffset(),
+                                 sizeof(ColorNormalVertex),
+                                 UCharType, 3, ShaderProgram::Normalize)) {
+    cout << program.error() << endl;
+  }
+  if (!program.enableAttributeArray("normal"))
+    cout << program.error() << endl;
+  if (!program.useAttributeArray("normal",
+                                 ColorNormalVertex::normalOffset(),
+                                 sizeof(ColorNormalVertex),
+                                 FloatType, 3, ShaderProgram::NoNormalize)) {
+    cout << program.error() << endl;
+  }
+
+  // Render the loaded cylinders using the shader and bound VBO.
   glDrawRangeElements(GL_TRIANGLES, 0,
-                      static_cast<GLuint>(d->numberOfVertices),
-                      static_cast<GLsizei>(d->numberOfIndices),
+                      static_cast<GLuint>(numberOfVertices),
+                      static_cast<GLsizei>(numberOfIndices),
                       GL_UNSIGNED_INT,
                       reinterpret_cast<const GLvoid *>(NULL));
 
-  d->vbo.release();
-  d->ibo.release();
+  vbo.release();
+  ibo.release();
 
-  d->program.disableAttributeArray("vector");
-  d->program.disableAttributeArray("color");
-  d->program.disableAttributeArray("normal");
+  program.disableAttributeArray("vertex");
+  program.disableAttributeArray("color");
+  program.disableAttributeArray("normal");
+}
 
-  d->program.release();
+void CylinderGeometry::Private::drawInstances()
+{
+  // The tube advances per vertex, the cylinder attributes per instance.
+  tubeVbo.bind();
+  ibo.bind();
+  if (!program.enableAttributeArray("mesh"))
+    cout << program.error() << endl;
+  if (!program.useAttributeArray("mesh", 0, sizeof(Vector3f), FloatType, 3,
+                                 ShaderProgram::NoNormalize)) {
+    cout << program.error() << endl;
+  }
+
+  vbo.bind();
+  if (!program.enableAttributeArray("end1"))
+    cout << program.error() << endl;
+  if (!program.useAttributeArray("end1", CylinderColor::end1Offset(),
+                                 sizeof(CylinderColor), FloatType, 3,
+                                 ShaderProgram::NoNormalize)) {
+    cout << program.error() << endl;
+  }
+  if (!program.enableAttributeArray("end2"))
+    cout << program.error() << endl;
+  if (!program.useAttributeArray("end2", CylinderColor::end2Offset(),
+                                 sizeof(CylinderColor), FloatType, 3,
+                                 ShaderProgram::NoNormalize)) {
+    cout << program.error() << endl;
+  }
+  if (!program.enableAttributeArray("cylinderRadius"))
+    cout << program.error() << endl;
+  if (!program.useAttributeArray("cylinderRadius",
+                                 CylinderColor::radiusOffset(),
+                                 sizeof(CylinderColor), FloatType, 1,
+                                 ShaderProgram::NoNormalize)) {
+    cout << program.error() << endl;
+  }
+  if (!program.enableAttributeArray("color"))
+    cout << program.error() << endl;
+  if (!program.useAttributeArray("color", CylinderColor::colorOffset(),
+                                 sizeof(CylinderColor), UCharType, 3,
+                                 ShaderProgram::Normalize)) {
+    cout << program.error() << endl;
+  }
+  if (!program.enableAttributeArray("color2"))
+    cout << program.error() << endl;
+  if (!program.useAttributeArray("color2", CylinderColor::color2Offset(),
+                                 sizeof(CylinderColor), UCharType, 3,
+                                 ShaderProgram::Normalize)) {
+    cout << program.error() << endl;
+  }
+  const char *perInstance[] = { "end1", "end2", "cylinderRadius", "color",
+                                "color2" };
+  const size_t perInstanceCount = sizeof(perInstance) / sizeof(perInstance[0]);
+  for (size_t i = 0; i < perInstanceCount; ++i)
+    program.setAttributeDivisor(perInstance[i], 1);
+
+  glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(numberOfIndices),
+                          GL_UNSIGNED_INT,
+                          reinterpret_cast<const GLvoid *>(NULL),
+                          static_cast<GLsizei>(numberOfInstances));
+
+  vbo.release();
+  ibo.release();
+
+  // Divisors are not part of the program, leave them as other drawables
+  // expect to find them.
+  for (size_t i = 0; i < perInstanceCount; ++i) {
+    program.setAttributeDivisor(perInstance[i], 0);
+    program.disableAttributeArray(perInstance[i]);
+  }
+  program.disableAttributeArray("mesh");
 }
 
 std::multimap<float, Identifier>
@@ -252,57 +488,71 @@ CylinderGeometry::hits(const Vector3f &rayOrigin,
                        const Vector3f &rayDirection) const
 {
   std::multimap<float, Identifier> result;
+  if (m_identifier.type == InvalidType)
+    return result;
+
+  d->bvh.update(m_cylinders, cylinderBounds);
+  std::multimap<float, size_t> cylinderHits;
+  d->bvh.hits(rayOrigin, rayDirection, (rayEnd - rayOrigin).norm(),
+              CylinderRayTest(m_cylinders, rayOrigin, rayEnd, rayDirection),
+              cylinderHits);
+
+  for (std::multimap<float, size_t>::const_iterator it = cylinderHits.begin();
+       it != cylinderHits.end(); ++it) {
+    Identifier id = cylinderIdentifier(it->second);
+    result.insert(std::pair<float, Identifier>(it->first, id));
+  }
+  return result;
+}
 
-  for (size_t i = 0; i < m_cylinders.size(); ++i) {
-    const CylinderColor &cylinder = m_cylinders[i];
-
-    // Check for cylinder intersection with the ray.
-    Vector3f ao = rayOrigin - cylinder.end1;
-    Vector3f ab = cylinder.end2 - cylinder.end1;
-    Vector3f aoxab = ao.cross(ab);
-    Vector3f vxab = rayDirection.cross(ab);
-
-    float A = vxab.dot(vxab);
-    float B = 2.0f * vxab.dot(aoxab);
-    float C = aoxab.dot(aoxab) - ab.dot(ab) * (cylinder.radius * cylinder.radius);
-    float D = B * B - 4.0f * A * C;
-
-    // no intersection
-    if (D < 0.0f)
-      continue;
-
-    float t = std::min((-B + std::sqrt(D)) / (2.0f * A),
-                       (-B - std::sqrt(D)) / (2.0f * A));
-
-    Vector3f ip = rayOrigin + (rayDirection * t);
-    Vector3f ip1 = ip - cylinder.end1;
-    Vector3f ip2 = ip - (cylinder.end1 + ab);
-
-    // intersection below base or above top of the cylinder
-    if (ip1.dot(ab) < 0.0f || ip2.dot(ab) > 0.0f)
-      continue;
+Identifier CylinderGeometry::hit(const Vector3f &rayOrigin,
+                                 const Vector3f &rayEnd,
+                                 const Vector3f &rayDirection,
+                                 float &depth) const
+{
+  if (m_identifier.type == InvalidType)
+    return Identifier();
+
+  d->bvh.update(m_cylinders, cylinderBounds);
+  size_t i = d->bvh.nearest(rayOrigin, rayDirection,
+                            (rayEnd - rayOrigin).norm(),
+                            CylinderRayTest(m_cylinders, rayOrigin, rayEnd,
+                                            rayDirection),
+                            depth);
+  return i != MaxIndex ? cylinderIdentifier(i) : Identifier();
+}
 
-    // Test for clipping
-    Vector3f distance = ip - rayOrigin;
-    if (distance.dot(rayDirection) < 0.0f
-        || (ip - rayEnd).dot(rayDirection) > 0.0f)
-      continue;
-
-    Identifier id;
-    id.molecule = m_identifier.molecule;
-    id.type = m_identifier.type;
-    id.index = i;
-    if (m_indexMap.size())
-      id.index = m_indexMap.find(i)->second;
-    if (id.type != InvalidType) {
-      float depth = distance.norm();
-      result.insert(std::pair<float, Identifier>(depth, id));
-    }
+std::vector<Identifier>
+CylinderGeometry::areaHits(const Frustum &frustum) const
+{
+  std::vector<Identifier> result;
+  if (m_identifier.type == InvalidType)
+    return result;
+
+  d->bvh.update(m_cylinders, cylinderBounds);
+  std::vector<size_t> candidates;
+  d->bvh.overlapping(frustum, candidates);
+  std::sort(candidates.begin(), candidates.end());
+
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    const CylinderColor &cylinder = m_cylinders[candidates[i]];
+    if (frustum.contains(0.5f * (cylinder.end1 + cylinder.end2)))
+      result.push_back(cylinderIdentifier(candidates[i]));
   }
-
   return result;
 }
 
+Identifier CylinderGeometry::cylinderIdentifier(size_t i) const
+{
+  Identifier id;
+  id.molecule = m_identifier.molecule;
+  id.type = m_identifier.type;
+  // Cylinders added without an index are identified by their own.
+  std::map<size_t, size_t>::const_iterator it = m_indexMap.find(i);
+  id.index = it != m_indexMap.end() ? it->second : i;
+  return id;
+}
+
 void CylinderGeometry::addCylinder(const Vector3f &pos1,
                                    const Vector3f &pos2,
                                    float radius,
@@ -318,6 +568,7 @@ void CylinderGeometry::addCylinder(const Vector3f &pos1,
                                    const Vector3ub &colorEnd)
 {
   m_dirty = true;
+  d->bvh.invalidate();
   m_cylinders.push_back(CylinderColor(pos1, pos2, radius,
                                       colorStart, colorEnd));
   m_indices.push_back(m_indices.size());
@@ -344,11 +595,36 @@ void CylinderGeometry::addCylinder(const Vector3f &pos1,
   addCylinder(pos1, pos2, radius, colorStart, colorEnd);
 }
 
+void CylinderGeometry::setCylinder(size_t i, const Vector3f &pos1,
+                                   const Vector3f &pos2, float radius,
+                                   const Vector3ub &colorStart,
+                                   const Vector3ub &colorEnd, size_t index)
+{
+  if (i >= m_cylinders.size())
+    return;
+  m_indexMap[i] = index;
+  CylinderColor &cylinder = m_cylinders[i];
+  if (cylinder.end1 == pos1 && cylinder.end2 == pos2
+      && cylinder.radius == radius && cylinder.color == colorStart
+      && cylinder.color2 == colorEnd) {
+    return;
+  }
+  cylinder = CylinderColor(pos1, pos2, radius, colorStart, colorEnd);
+  markRangeDirty(i, i + 1);
+}
+
+void CylinderGeometry::markRangeDirty(size_t begin, size_t end)
+{
+  Drawable::markRangeDirty(begin, end);
+  d->bvh.markMoved(begin, end);
+}
+
 void CylinderGeometry::clear()
 {
   m_cylinders.clear();
   m_indices.clear();
   m_indexMap.clear();
+  d->bvh.invalidate();
 }
 
 } // End namespace Rendering
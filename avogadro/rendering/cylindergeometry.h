@@ -33,17 +33,41 @@ struct CylinderColor
   {
   }
 
+  // Offsets of the members, the array is uploaded as-is for instancing.
+  static int end1Offset() { return 0; }
+  static int end2Offset() { return static_cast<int>(sizeof(Vector3f)); }
+  static int radiusOffset()
+  {
+    return end2Offset() + static_cast<int>(sizeof(Vector3f));
+  }
+  static int colorOffset()
+  {
+    return radiusOffset() + static_cast<int>(sizeof(float));
+  }
+  static int color2Offset()
+  {
+    return colorOffset() + static_cast<int>(sizeof(Vector3ub));
+  }
+
   Vector3f end1;
   Vector3f end2;
   float radius;
   Vector3ub color;
   Vector3ub color2;
-};
+}; // 36 bytes total size, against 1056 per cylinder drawn without instancing.
 
 /**
  * @class CylinderGeometry cylindergeometry.h <avogadro/rendering/cylindergeometry.h>
  * @brief The CylinderGeometry contains one or more cylinders.
  * @author Marcus D. Hanwell
+ *
+ * Picking uses a BoundingVolumeHierarchy of the cylinders, which is built on
+ * the first pick after cylinders are added, and refitted when they are
+ * changed.
+ *
+ * When the context supports instancing the cylinders are uploaded as they are
+ * stored and a single tube is stretched over each one in the vertex shader,
+ * otherwise the tube of each cylinder is built on the CPU.
  */
 
 class AVOGADRORENDERING_EXPORT CylinderGeometry : public Drawable
@@ -83,6 +107,19 @@ public:
                                         const Vector3f &rayEnd,
                                         const Vector3f &rayDirection) const;
 
+  /**
+   * Return the cylinder hit by the ray closest to its origin.
+   * @sa Drawable::hit()
+   */
+  Identifier hit(const Vector3f &rayOrigin, const Vector3f &rayEnd,
+                 const Vector3f &rayDirection,
+                 float &depth) const AVO_OVERRIDE;
+
+  /**
+   * Return the cylinders with their midpoint inside @a frustum.
+   */
+  std::vector<Identifier> areaHits(const Frustum &frustum) const AVO_OVERRIDE;
+
   /**
    * @brief Add a cylinder to the geometry object.
    * @param position Base of the cylinder.
@@ -134,7 +171,30 @@ public:
                    const Vector3ub &color2, size_t index);
 
   /**
-   * Get a reference to the cylinders.
+   * @brief Replace the cylinder at position @a i, for example when the atoms
+   * of a bond move. Only the cylinders that change are uploaded again on the
+   * next update(), rather than rebuilding all of the geometry.
+   * @param i The position of the cylinder in cylinders().
+   * @param pos1 Base of the cylinder.
+   * @param pos2 Top of the cylinder.
+   * @param radius Radius of the cylinder.
+   * @param color Color of the start of the cylinder.
+   * @param color2 Color of the end of the cylinder.
+   * @param index The index of the object the cylinder represents.
+   */
+  void setCylinder(size_t i, const Vector3f &pos1, const Vector3f &pos2,
+                   float radius, const Vector3ub &color,
+                   const Vector3ub &color2, size_t index);
+
+  /**
+   * Mark cylinders changed in place, so that they are uploaded again and the
+   * picking hierarchy is refitted to them.
+   */
+  void markRangeDirty(size_t begin, size_t end) AVO_OVERRIDE;
+
+  /**
+   * Get a reference to the cylinders. When they are changed in place, the
+   * changed range must be passed to markRangeDirty() to be uploaded again.
    */
   std::vector<CylinderColor>& cylinders() { return m_cylinders; }
   const std::vector<CylinderColor>& cylinders() const { return m_cylinders; }
@@ -150,6 +210,11 @@ public:
   size_t size() const { return m_cylinders.size(); }
 
 private:
+  void updateInstances();
+
+  /** The identifier of the cylinder at position @a i for picking. */
+  Identifier cylinderIdentifier(size_t i) const;
+
   std::vector<CylinderColor> m_cylinders;
   std::vector<size_t> m_indices;
   std::map<size_t, size_t> m_indexMap;
@@ -175,6 +240,8 @@ inline void swap(CylinderGeometry &lhs, CylinderGeometry &rhs)
   swap(lhs.m_indices, rhs.m_indices);
   swap(lhs.m_indexMap, rhs.m_indexMap);
   lhs.m_dirty = rhs.m_dirty = true;
+  lhs.markRangeDirty(0, lhs.size());
+  rhs.markRangeDirty(0, rhs.size());
 }
 
 } // End namespace Rendering
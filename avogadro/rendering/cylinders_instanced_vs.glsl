@@ -0,0 +1,32 @@
+attribute vec3 mesh;
+attribute vec3 end1;
+attribute vec3 end2;
+attribute float cylinderRadius;
+attribute vec3 color;
+attribute vec3 color2;
+
+uniform mat4 modelView;
+uniform mat4 projection;
+uniform mat3 normalMatrix;
+
+varying vec3 fnormal;
+
+// Each cylinder is one instance of a unit tube, where mesh holds the cosine
+// and sine around the tube and 0 or 1 for the end the vertex belongs to.
+void main()
+{
+  vec3 axis = end2 - end1;
+  vec3 direction = normalize(axis);
+
+  // Two directions perpendicular to the axis, and to each other.
+  vec3 u = abs(direction.z) < 0.9 ? vec3(-direction.y, direction.x, 0.0)
+                                  : vec3(0.0, -direction.z, direction.y);
+  u = normalize(u);
+  vec3 v = cross(direction, u);
+  vec3 radial = mesh.x * u + mesh.y * v;
+
+  vec4 vertex = vec4(end1 + mesh.z * axis + cylinderRadius * radial, 1.0);
+  gl_FrontColor = vec4(mesh.z < 0.5 ? color : color2, 1.0);
+  gl_Position = projection * modelView * vertex;
+  fnormal = normalize(normalMatrix * radial);
+}
@@ -18,13 +18,17 @@
 
 #include "visitor.h"
 
+#include <algorithm>
+
 namespace Avogadro {
 namespace Rendering {
 
 Drawable::Drawable() :
   m_parent(NULL),
   m_visible(true),
-  m_renderPass(OpaquePass)
+  m_renderPass(OpaquePass),
+  m_dirtyBegin(0),
+  m_dirtyEnd(0)
 {
 }
 
@@ -32,7 +36,9 @@ Drawable::Drawable(const Drawable &other)
   : m_parent(other.m_parent),
     m_visible(other.m_visible),
     m_renderPass(other.m_renderPass),
-    m_identifier(other.m_identifier)
+    m_identifier(other.m_identifier),
+    m_dirtyBegin(0),
+    m_dirtyEnd(0)
 {
 }
 
@@ -56,10 +62,46 @@ std::multimap<float, Identifier> Drawable::hits(const Vector3f &,
   return std::multimap<float, Identifier>();
 }
 
+Identifier Drawable::hit(const Vector3f &rayOrigin, const Vector3f &rayEnd,
+                         const Vector3f &rayDirection, float &depth) const
+{
+  std::multimap<float, Identifier> result =
+      hits(rayOrigin, rayEnd, rayDirection);
+  if (result.empty())
+    return Identifier();
+  depth = result.begin()->first;
+  return result.begin()->second;
+}
+
+std::vector<Identifier> Drawable::areaHits(const Frustum &) const
+{
+  return std::vector<Identifier>();
+}
+
 void Drawable::clear()
 {
 }
 
+BufferObject::UsageHint Drawable::dirtyUsage(size_t count) const
+{
+  return m_dirtyBegin == 0 && m_dirtyEnd >= count ? BufferObject::StreamDraw
+                                                  : BufferObject::DynamicDraw;
+}
+
+void Drawable::markRangeDirty(size_t begin, size_t end)
+{
+  if (begin >= end)
+    return;
+  if (m_dirtyBegin == m_dirtyEnd) {
+    m_dirtyBegin = begin;
+    m_dirtyEnd = end;
+  }
+  else {
+    m_dirtyBegin = std::min(m_dirtyBegin, begin);
+    m_dirtyEnd = std::max(m_dirtyEnd, end);
+  }
+}
+
 void Drawable::setParent(GeometryNode *parent_)
 {
   m_parent = parent_;
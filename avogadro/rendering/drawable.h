@@ -20,10 +20,12 @@
 #include "avogadrorenderingexport.h"
 
 #include "avogadrorendering.h"
+#include "bufferobject.h"
 #include "primitive.h"
 #include <avogadro/core/vector.h>
 
 #include <map>
+#include <vector>
 
 namespace Avogadro {
 namespace Rendering {
@@ -109,14 +111,60 @@ public:
                                                 const Vector3f &rayEnd,
                                                 const Vector3f &rayDirection) const;
 
+  /**
+   * Return the primitive hit by the ray closest to its origin, or an
+   * Identifier with an InvalidType if there is none.
+   * @param rayOrigin Origin of the ray.
+   * @param rayEnd End point of the ray.
+   * @param rayDirection Normalized direction of the ray.
+   * @param depth Set to the depth of the hit.
+   */
+  virtual Identifier hit(const Vector3f &rayOrigin, const Vector3f &rayEnd,
+                         const Vector3f &rayDirection, float &depth) const;
+
+  /**
+   * Return the primitives inside @a frustum, for example to select those in
+   * a rectangle drawn on the screen.
+   */
+  virtual std::vector<Identifier> areaHits(const Frustum &frustum) const;
+
   /**
    * Clear the contents of the node.
    */
   virtual void clear();
 
+  /**
+   * Mark the primitives from @a begin up to, but not including, @a end as
+   * changed, so that only their part of the GPU buffers is uploaded again on
+   * the next render. This is needed when the primitives are edited in place,
+   * and successive ranges are merged into one covering all of them.
+   */
+  virtual void markRangeDirty(size_t begin, size_t end);
+
+  /**
+   * The range of primitives marked as changed since the last upload, which is
+   * empty when dirtyBegin() and dirtyEnd() are equal.
+   * @{
+   */
+  size_t dirtyBegin() const { return m_dirtyBegin; }
+  size_t dirtyEnd() const { return m_dirtyEnd; }
+  /** @} */
+
 protected:
   friend class GeometryNode;
 
+  /**
+   * Reset the range of changed primitives, called once they are uploaded.
+   */
+  void clearDirty() { m_dirtyBegin = m_dirtyEnd = 0; }
+
+  /**
+   * The usage hint for a buffer of @a count primitives updated over the dirty
+   * range. When all of them changed, as for each frame of a trajectory being
+   * played, the buffer is streamed, otherwise it is dynamic.
+   */
+  BufferObject::UsageHint dirtyUsage(size_t count) const;
+
   /**
    * @brief Set the parent node for the node.
    * @param parent The parent, a value of NULL denotes no parent node.
@@ -127,6 +175,8 @@ protected:
   bool m_visible;
   RenderPass m_renderPass;
   Identifier m_identifier;
+  size_t m_dirtyBegin;
+  size_t m_dirtyEnd;
 };
 
 inline Drawable &Drawable::operator=(Drawable rhs)
@@ -143,6 +193,8 @@ inline void swap(Drawable &lhs, Drawable &rhs)
   swap(lhs.m_visible, rhs.m_visible);
   swap(lhs.m_renderPass, rhs.m_renderPass);
   swap(lhs.m_identifier, rhs.m_identifier);
+  swap(lhs.m_dirtyBegin, rhs.m_dirtyBegin);
+  swap(lhs.m_dirtyEnd, rhs.m_dirtyEnd);
 }
 
 } // End namespace Rendering
@@ -111,5 +111,37 @@ std::multimap<float, Identifier> GeometryNode::hits(const Vector3f &rayOrigin,
   return result;
 }
 
+Identifier GeometryNode::hit(const Vector3f &rayOrigin, const Vector3f &rayEnd,
+                             const Vector3f &rayDirection, float &depth) const
+{
+  Identifier result;
+  for (std::vector<Drawable *>::const_iterator it = m_drawables.begin();
+       it != m_drawables.end(); ++it) {
+    if (!(*it)->isVisible())
+      continue;
+    float drawableDepth;
+    Identifier id = (*it)->hit(rayOrigin, rayEnd, rayDirection, drawableDepth);
+    if (id.type != InvalidType
+        && (result.type == InvalidType || drawableDepth < depth)) {
+      result = id;
+      depth = drawableDepth;
+    }
+  }
+  return result;
+}
+
+std::vector<Identifier> GeometryNode::areaHits(const Frustum &frustum) const
+{
+  std::vector<Identifier> result;
+  for (std::vector<Drawable *>::const_iterator it = m_drawables.begin();
+       it != m_drawables.end(); ++it) {
+    if (!(*it)->isVisible())
+      continue;
+    std::vector<Identifier> drawableHits = (*it)->areaHits(frustum);
+    result.insert(result.end(), drawableHits.begin(), drawableHits.end());
+  }
+  return result;
+}
+
 } // End namespace Rendering
 } // End namespace Avogadro
@@ -98,6 +98,22 @@ public:
                                         const Vector3f &rayEnd,
                                         const Vector3f &rayDirection) const;
 
+  /**
+   * Return the primitive hit by the ray closest to its origin, or an
+   * Identifier with an InvalidType if there is none.
+   * @param rayOrigin Origin of the ray.
+   * @param rayEnd End point of the ray.
+   * @param rayDirection Normalized direction of the ray.
+   * @param depth Set to the depth of the hit.
+   */
+  Identifier hit(const Vector3f &rayOrigin, const Vector3f &rayEnd,
+                 const Vector3f &rayDirection, float &depth) const;
+
+  /**
+   * Return the primitives of the visible drawables inside @a frustum.
+   */
+  std::vector<Identifier> areaHits(const Frustum &frustum) const;
+
 protected:
   std::vector<Drawable *> m_drawables;
 };
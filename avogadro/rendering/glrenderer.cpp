@@ -29,6 +29,7 @@
 
 #include <avogadro/core/matrix.h>
 
+#include <algorithm>
 #include <iostream>
 
 namespace Avogadro {
@@ -224,5 +225,112 @@ std::multimap<float, Identifier> GLRenderer::hits(int x, int y) const
   return hits(&m_scene.rootNode(), origin, end, direction);
 }
 
+Identifier GLRenderer::hit(const GroupNode *group, const Vector3f &rayOrigin,
+                           const Vector3f &rayEnd,
+                           const Vector3f &rayDirection, float &depth) const
+{
+  Identifier result;
+  if (!group)
+    return result;
+
+  for (std::vector<Node *>::const_iterator it = group->children().begin();
+       it != group->children().end(); ++it) {
+    Identifier loopHit;
+    float loopDepth;
+    const Node *itNode = *it;
+    const GroupNode *childGroup = dynamic_cast<const GroupNode *>(itNode);
+    if (childGroup) {
+      loopHit = hit(childGroup, rayOrigin, rayEnd, rayDirection, loopDepth);
+    }
+    else {
+      const GeometryNode *childGeometry = (*it)->cast<GeometryNode>();
+      if (childGeometry)
+        loopHit = childGeometry->hit(rayOrigin, rayEnd, rayDirection,
+                                     loopDepth);
+    }
+    if (loopHit.type != InvalidType
+        && (result.type == InvalidType || loopDepth < depth)) {
+      result = loopHit;
+      depth = loopDepth;
+    }
+  }
+  return result;
+}
+
+Identifier GLRenderer::hit(int x, int y) const
+{
+  // Our ray:
+  const Vector3f origin(m_camera.unProject(Vector3f(static_cast<float>(x),
+                                                    static_cast<float>(y),
+                                                    0.f)));
+  const Vector3f end(m_camera.unProject(Vector3f(static_cast<float>(x),
+                                                 static_cast<float>(y), 1.f)));
+  const Vector3f direction((end - origin).normalized());
+
+  float depth;
+  return hit(&m_scene.rootNode(), origin, end, direction, depth);
+}
+
+void GLRenderer::areaHits(const GroupNode *group, const Frustum &frustum,
+                          std::vector<Identifier> &result) const
+{
+  if (!group)
+    return;
+
+  for (std::vector<Node *>::const_iterator it = group->children().begin();
+       it != group->children().end(); ++it) {
+    const Node *itNode = *it;
+    const GroupNode *childGroup = dynamic_cast<const GroupNode *>(itNode);
+    if (childGroup) {
+      areaHits(childGroup, frustum, result);
+      continue;
+    }
+    const GeometryNode *childGeometry = (*it)->cast<GeometryNode>();
+    if (childGeometry) {
+      std::vector<Identifier> loopHits = childGeometry->areaHits(frustum);
+      result.insert(result.end(), loopHits.begin(), loopHits.end());
+    }
+  }
+}
+
+std::vector<Identifier> GLRenderer::hits(int x1, int y1, int x2, int y2) const
+{
+  // The corners of the rectangle on the near and far planes, going around it.
+  const float xs[4] = { static_cast<float>(std::min(x1, x2)),
+                        static_cast<float>(std::max(x1, x2)),
+                        static_cast<float>(std::max(x1, x2)),
+                        static_cast<float>(std::min(x1, x2)) };
+  const float ys[4] = { static_cast<float>(std::min(y1, y2)),
+                        static_cast<float>(std::min(y1, y2)),
+                        static_cast<float>(std::max(y1, y2)),
+                        static_cast<float>(std::max(y1, y2)) };
+  Vector3f nearPoints[4];
+  Vector3f farPoints[4];
+  Vector3f center(Vector3f::Zero());
+  for (int i = 0; i < 4; ++i) {
+    nearPoints[i] = m_camera.unProject(Vector3f(xs[i], ys[i], 0.f));
+    farPoints[i] = m_camera.unProject(Vector3f(xs[i], ys[i], 1.f));
+    center += nearPoints[i] + farPoints[i];
+  }
+  center /= 8.f;
+
+  // Each side passes through an edge of the rectangle on the near plane and a
+  // corner on the far plane, with its normal turned towards the inside.
+  Frustum frustum;
+  for (int i = 0; i < 4; ++i) {
+    const Vector3f &a = nearPoints[i];
+    const Vector3f &b = nearPoints[(i + 1) % 4];
+    Vector3f normal = (b - a).cross(farPoints[i] - a);
+    if ((center - a).dot(normal) < 0.f)
+      normal = -normal;
+    frustum.points[i] = a;
+    frustum.planes[i] = normal;
+  }
+
+  std::vector<Identifier> result;
+  areaHits(&m_scene.rootNode(), frustum, result);
+  return result;
+}
+
 } // End Rendering namespace
 } // End Avogadro namespace
@@ -73,6 +73,11 @@ public:
    */
   Identifier hit(int x, int y) const;
 
+  /** Return the primitives in the rectangle with the display coordinates
+   * (x1,y1) and (x2,y2) as opposite corners, in no particular order.
+   */
+  std::vector<Identifier> hits(int x1, int y1, int x2, int y2) const;
+
   /** Check whether the GL context is valid and supports required features.
    * \sa error() to get more information if the context is not valid.
    */
@@ -120,6 +125,19 @@ private:
                                         const Vector3f &rayEnd,
                                         const Vector3f &rayDirection) const;
 
+  /**
+   * @brief Find the closest hit in a group node, with its depth in @a depth.
+   */
+  Identifier hit(const GroupNode *group, const Vector3f &rayOrigin,
+                 const Vector3f &rayEnd, const Vector3f &rayDirection,
+                 float &depth) const;
+
+  /**
+   * @brief Detect the primitives inside @a frustum in a group node.
+   */
+  void areaHits(const GroupNode *group, const Frustum &frustum,
+                std::vector<Identifier> &result) const;
+
 
   bool m_valid;
   std::string m_error;
@@ -152,14 +170,6 @@ inline TextRenderStrategy *GLRenderer::textRenderStrategy()
   return m_textRenderStrategy;
 }
 
-inline Identifier GLRenderer::hit(int x, int y) const
-{
-  std::multimap<float, Identifier> results = hits(x, y);
-  if (results.size())
-    return results.begin()->second;
-  return Identifier();
-}
-
 } // End Rendering namespace
 } // End Avogadro namespace
 
@@ -54,6 +54,25 @@ struct Identifier {
   Index index;
 };
 
+/**
+ * The volume seen through a rectangle on the screen, used to select the
+ * primitives within it. Each of the four sides is given by a point on it and
+ * its normal, which points into the volume.
+ */
+struct Frustum {
+  Vector3f points[4];
+  Vector3f planes[4];
+
+  /** Return true if @a point is inside the volume. */
+  bool contains(const Vector3f &point) const
+  {
+    for (int i = 0; i < 4; ++i)
+      if ((point - points[i]).dot(planes[i]) < 0.0f)
+        return false;
+    return true;
+  }
+};
+
 class Primitive
 {
 public:
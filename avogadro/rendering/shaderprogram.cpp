@@ -277,6 +277,28 @@ bool ShaderProgram::useAttributeArray(const std::string &name, int offset,
   return true;
 }
 
+bool ShaderProgram::setAttributeDivisor(const std::string &name,
+                                        unsigned int divisor)
+{
+  GLint location = static_cast<GLint>(findAttributeArray(name));
+  if (location == -1) {
+    m_error = "Could not set divisor of attribute " + name
+        + ". No such attribute.";
+    return false;
+  }
+  if (GLEW_VERSION_3_3)
+    glVertexAttribDivisor(location, divisor);
+  else
+    glVertexAttribDivisorARB(location, divisor);
+  return true;
+}
+
+bool ShaderProgram::supportsInstancing()
+{
+  // The instanced draw calls are core from 3.1, the divisors from 3.3.
+  return GLEW_VERSION_3_3 || (GLEW_VERSION_3_1 && GLEW_ARB_instanced_arrays);
+}
+
 bool ShaderProgram::setTextureSampler(const std::string &name,
                                       const Texture2D &texture)
 {
@@ -121,6 +121,18 @@ public:
                          Avogadro::Type elementType, int elementTupleSize,
                          NormalizeOption normalize);
 
+  /** Set how often the named attribute array advances in instanced draws.
+   * With the default of 0 it advances once per vertex, with 1 once per
+   * instance, and so on. Only valid when supportsInstancing() is true.
+   * @return false if the attribute array does not exist.
+   */
+  bool setAttributeDivisor(const std::string &name, unsigned int divisor);
+
+  /** Return true if the current context can draw instances, with attribute
+   * divisors and the glDraw*Instanced calls. A context must be current.
+   */
+  static bool supportsInstancing();
+
   /** Upload the supplied array of tightly packed values to the named attribute.
    * BufferObject attributes should be preferred and this may be removed in
    * future.
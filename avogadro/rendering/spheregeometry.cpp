@@ -19,6 +19,7 @@
 #include "camera.h"
 #include "scene.h"
 
+#include "boundingvolumehierarchy.h"
 #include "bufferobject.h"
 
 #include "shader.h"
@@ -29,10 +30,12 @@
 namespace {
 #include "spheres_vs.h"
 #include "spheres_fs.h"
+#include "spheres_instanced_vs.h"
 }
 
 #include "avogadrogl.h"
 
+#include <algorithm>
 #include <iostream>
 
 using std::cout;
@@ -41,20 +44,102 @@ using std::endl;
 namespace Avogadro {
 namespace Rendering {
 
+namespace {
+// Each sphere is drawn as a quad of four vertices.
+void addSphereVertices(const SphereColor &sphere,
+                       std::vector<ColorTextureVertex> &vertices)
+{
+  float r = sphere.radius;
+  ColorTextureVertex vert(sphere.center, sphere.color, Vector2f(-r, -r));
+  vertices.push_back(vert);
+  vert.textureCoord = Vector2f(-r, r);
+  vertices.push_back(vert);
+  vert.textureCoord = Vector2f( r,-r);
+  vertices.push_back(vert);
+  vert.textureCoord = Vector2f( r, r);
+  vertices.push_back(vert);
+}
+
+// Tests a ray against the spheres, clipped to the segment between the ends.
+class SphereRayTest : public BoundingVolumeHierarchy::RayTest
+{
+public:
+  SphereRayTest(const Core::Array<SphereColor> &spheres,
+                const Vector3f &rayOrigin, const Vector3f &rayEnd,
+                const Vector3f &rayDirection)
+    : m_spheres(spheres), m_rayOrigin(rayOrigin), m_rayEnd(rayEnd),
+      m_rayDirection(rayDirection)
+  {
+  }
+
+  bool intersect(size_t index, float &depth) const
+  {
+    const SphereColor &sphere = m_spheres[index];
+
+    Vector3f distance = sphere.center - m_rayOrigin;
+    float B = distance.dot(m_rayDirection);
+    float C = distance.dot(distance) - (sphere.radius * sphere.radius);
+    float D = B * B - C;
+
+    // Test for intersection
+    if (D < 0)
+      return false;
+
+    // Test for clipping
+    if (B < 0 || (sphere.center - m_rayEnd).dot(m_rayDirection) > 0)
+      return false;
+
+    float rootD = static_cast<float>(sqrt(D));
+    depth = std::min(std::abs(B + rootD), std::abs(B - rootD));
+    return true;
+  }
+
+private:
+  const Core::Array<SphereColor> &m_spheres;
+  Vector3f m_rayOrigin;
+  Vector3f m_rayEnd;
+  Vector3f m_rayDirection;
+};
+
+// The bounding box of a sphere for picking.
+BoundingVolumeHierarchy::Box sphereBounds(const SphereColor &sphere)
+{
+  Vector3f radius(Vector3f::Constant(sphere.radius));
+  return BoundingVolumeHierarchy::Box(sphere.center - radius,
+                                      sphere.center + radius);
+}
+}
+
 class SphereGeometry::Private
 {
 public:
-  Private() { }
+  Private()
+    : instanced(false), numberOfInstances(0)
+  {
+  }
+
+  // Draw the quads built on the CPU, or one instance per sphere.
+  void drawVertices();
+  void drawInstances();
 
   BufferObject vbo;
   BufferObject ibo;
 
+  // With instancing vbo holds the spheres as they are stored, and each one is
+  // drawn over the corners of a single quad.
+  bool instanced;
+  BufferObject quadVbo;
+  size_t numberOfInstances;
+
   Shader vertexShader;
   Shader fragmentShader;
   ShaderProgram program;
 
   size_t numberOfVertices;
   size_t numberOfIndices;
+
+  // Picking hierarchy, brought up to date on the first pick after a change.
+  BoundingVolumeHierarchy bvh;
 };
 
 SphereGeometry::SphereGeometry() : m_dirty(false), d(new Private)
@@ -85,8 +170,16 @@ void SphereGeometry::update()
   if (m_indices.empty() || m_spheres.empty())
     return;
 
+  // Instancing is used when the context supports it, decided once before the
+  // shaders are built.
+  if (d->vertexShader.type() == Shader::Unknown)
+    d->instanced = ShaderProgram::supportsInstancing();
+
+  if (d->instanced) {
+    updateInstances();
+  }
   // Check if the VBOs are ready, if not get them ready.
-  if (!d->vbo.ready() || m_dirty) {
+  else if (!d->vbo.ready() || m_dirty) {
     std::vector<unsigned int> sphereIndices;
     std::vector<ColorTextureVertex> sphereVertices;
     sphereIndices.reserve(m_indices.size() * 4);
@@ -99,17 +192,8 @@ void SphereGeometry::update()
          itIndex != m_indices.end() && itSphere != m_spheres.end();
          ++i, ++itIndex, ++itSphere) {
       // Use our packed data structure...
-      float r = itSphere->radius;
       unsigned int index = 4 * static_cast<unsigned int>(*itIndex);
-      ColorTextureVertex vert(itSphere->center, itSphere->color,
-                              Vector2f(-r, -r));
-      sphereVertices.push_back(vert);
-      vert.textureCoord = Vector2f(-r, r);
-      sphereVertices.push_back(vert);
-      vert.textureCoord = Vector2f( r,-r);
-      sphereVertices.push_back(vert);
-      vert.textureCoord = Vector2f( r, r);
-      sphereVertices.push_back(vert);
+      addSphereVertices(*itSphere, sphereVertices);
 
       // 6 indexed vertices to draw a quad...
       sphereIndices.push_back(index + 0);
@@ -118,8 +202,6 @@ void SphereGeometry::update()
       sphereIndices.push_back(index + 3);
       sphereIndices.push_back(index + 2);
       sphereIndices.push_back(index + 1);
-
-      //m_spheres.push_back(Sphere(position, r, id, color));
     }
 
     if (!d->vbo.upload(sphereVertices, BufferObject::ArrayBuffer))
@@ -132,12 +214,26 @@ void SphereGeometry::update()
     d->numberOfIndices = sphereIndices.size();
 
     m_dirty = false;
+    clearDirty();
+  }
+  else if (m_dirtyBegin < m_dirtyEnd) {
+    // Only the vertices of the spheres that changed are uploaded, into a
+    // buffer that is streamed when all of them change, as in an animation.
+    size_t end = std::min(m_dirtyEnd, m_spheres.size());
+    std::vector<ColorTextureVertex> sphereVertices;
+    sphereVertices.reserve((end - m_dirtyBegin) * 4);
+    for (size_t i = m_dirtyBegin; i < end; ++i)
+      addSphereVertices(m_spheres[i], sphereVertices);
+    d->vbo.setUsage(dirtyUsage(m_spheres.size()));
+    if (!d->vbo.uploadRange(sphereVertices, m_dirtyBegin * 4))
+      cout << d->vbo.error() << endl;
+    clearDirty();
   }
 
   // Build and link the shader if it has not been used yet.
   if (d->vertexShader.type() == Shader::Unknown) {
     d->vertexShader.setType(Shader::Vertex);
-    d->vertexShader.setSource(spheres_vs);
+    d->vertexShader.setSource(d->instanced ? spheres_instanced_vs : spheres_vs);
     d->fragmentShader.setType(Shader::Fragment);
     d->fragmentShader.setSource(spheres_fs);
     if (!d->vertexShader.compile())
@@ -151,6 +247,37 @@ void SphereGeometry::update()
   }
 }
 
+void SphereGeometry::updateInstances()
+{
+  if (!d->quadVbo.ready()) {
+    std::vector<Vector2f> corners;
+    corners.push_back(Vector2f(-1.0f, -1.0f));
+    corners.push_back(Vector2f(-1.0f,  1.0f));
+    corners.push_back(Vector2f( 1.0f, -1.0f));
+    corners.push_back(Vector2f( 1.0f,  1.0f));
+    if (!d->quadVbo.upload(corners, BufferObject::ArrayBuffer))
+      cout << d->quadVbo.error() << endl;
+  }
+
+  // The spheres need no conversion, so there is nothing to build on the CPU.
+  if (!d->vbo.ready() || m_dirty) {
+    if (!d->vbo.upload(m_spheres, BufferObject::ArrayBuffer))
+      cout << d->vbo.error() << endl;
+    d->numberOfInstances = m_spheres.size();
+    m_dirty = false;
+    clearDirty();
+  }
+  else if (m_dirtyBegin < m_dirtyEnd) {
+    size_t end = std::min(m_dirtyEnd, m_spheres.size());
+    std::vector<SphereColor> spheres(m_spheres.begin() + m_dirtyBegin,
+                                     m_spheres.begin() + end);
+    d->vbo.setUsage(dirtyUsage(m_spheres.size()));
+    if (!d->vbo.uploadRange(spheres, m_dirtyBegin))
+      cout << d->vbo.error() << endl;
+    clearDirty();
+  }
+}
+
 void SphereGeometry::render(const Camera &camera)
 {
   if (m_indices.empty() || m_spheres.empty())
@@ -162,35 +289,6 @@ void SphereGeometry::render(const Camera &camera)
   if (!d->program.bind())
     cout << d->program.error() << endl;
 
-  d->vbo.bind();
-  d->ibo.bind();
-
-  // Set up our attribute arrays.
-  if (!d->program.enableAttributeArray("vertex"))
-    cout << d->program.error() << endl;
-  if (!d->program.useAttributeArray("vertex",
-                                    ColorTextureVertex::vertexOffset(),
-                                    sizeof(ColorTextureVertex),
-                                    FloatType, 3, ShaderProgram::NoNormalize)) {
-    cout << d->program.error() << endl;
-  }
-  if (!d->program.enableAttributeArray("color"))
-    cout << d->program.error() << endl;
-  if (!d->program.useAttributeArray("color",
-                                    ColorTextureVertex::colorOffset(),
-                                    sizeof(ColorTextureVertex),
-                                    UCharType, 3, ShaderProgram::Normalize)) {
-    cout << d->program.error() << endl;
-  }
-  if (!d->program.enableAttributeArray("texCoordinate"))
-    cout << d->program.error() << endl;
-  if (!d->program.useAttributeArray("texCoordinate",
-                                    ColorTextureVertex::textureCoordOffset(),
-                                    sizeof(ColorTextureVertex),
-                                    FloatType, 2, ShaderProgram::NoNormalize)) {
-    cout << d->program.error() << endl;
-  }
-
   // Set up our uniforms (model-view and projection matrices right now).
   if (!d->program.setUniformValue("modelView",
                                   camera.modelView().matrix())) {
@@ -201,21 +299,110 @@ void SphereGeometry::render(const Camera &camera)
     cout << d->program.error() << endl;
   }
 
+  if (d->instanced)
+    d->drawInstances();
+  else
+    d->drawVertices();
+
+  d->program.release();
+}
+
+void SphereGeometry::Private::drawVertices()
+{
+  vbo.bind();
+  ibo.bind();
+
+  // Set up our attribute arrays.
+  if (!program.enableAttributeArray("vertex"))
+    cout << program.error() << endl;
+  if (!program.useAttributeArray("vertex",
+                                 ColorTextureVertex::vertexOffset(),
+                                 sizeof(ColorTextureVertex),
+                                 FloatType, 3, ShaderProgram::NoNormalize)) {
+    cout << program.error() << endl;
+  }
+  if (!program.enableAttributeArray("color"))
+    cout << program.error() << endl;
+  if (!program.useAttributeArray("color",
+                                 ColorTextureVertex::colorOffset(),
+                                 sizeof(ColorTextureVertex),
+                                 UCharType, 3, ShaderProgram::Normalize)) {
+    cout << program.error() << endl;
+  }
+  if (!program.enableAttributeArray("texCoordinate"))
+    cout << program.error() << endl;
+  if (!program.useAttributeArray("texCoordinate",
+                                 ColorTextureVertex::textureCoordOffset(),
+                                 sizeof(ColorTextureVertex),
+                                 FloatType, 2, ShaderProgram::NoNormalize)) {
+    cout << program.error() << endl;
+  }
+
   // Render the loaded spheres using the shader and bound VBO.
   glDrawRangeElements(GL_TRIANGLES, 0,
-                      static_cast<GLuint>(d->numberOfVertices),
-                      static_cast<GLsizei>(d->numberOfIndices),
+                      static_cast<GLuint>(numberOfVertices),
+                      static_cast<GLsizei>(numberOfIndices),
                       GL_UNSIGNED_INT,
                       reinterpret_cast<const GLvoid *>(NULL));
 
-  d->vbo.release();
-  d->ibo.release();
+  vbo.release();
+  ibo.release();
 
-  d->program.disableAttributeArray("vector");
-  d->program.disableAttributeArray("color");
-  d->program.disableAttributeArray("texCoordinates");
+  program.disableAttributeArray("vertex");
+  program.disableAttributeArray("color");
+  program.disableAttributeArray("texCoordinate");
+}
 
-  d->program.release();
+void SphereGeometry::Private::drawInstances()
+{
+  // The corners advance per vertex, the sphere attributes per instance.
+  quadVbo.bind();
+  if (!program.enableAttributeArray("corner"))
+    cout << program.error() << endl;
+  if (!program.useAttributeArray("corner", 0, sizeof(Vector2f), FloatType, 2,
+                                 ShaderProgram::NoNormalize)) {
+    cout << program.error() << endl;
+  }
+
+  vbo.bind();
+  if (!program.enableAttributeArray("center"))
+    cout << program.error() << endl;
+  if (!program.useAttributeArray("center", SphereColor::centerOffset(),
+                                 sizeof(SphereColor), FloatType, 3,
+                                 ShaderProgram::NoNormalize)) {
+    cout << program.error() << endl;
+  }
+  if (!program.enableAttributeArray("sphereRadius"))
+    cout << program.error() << endl;
+  if (!program.useAttributeArray("sphereRadius", SphereColor::radiusOffset(),
+                                 sizeof(SphereColor), FloatType, 1,
+                                 ShaderProgram::NoNormalize)) {
+    cout << program.error() << endl;
+  }
+  if (!program.enableAttributeArray("color"))
+    cout << program.error() << endl;
+  if (!program.useAttributeArray("color", SphereColor::colorOffset(),
+                                 sizeof(SphereColor), UCharType, 3,
+                                 ShaderProgram::Normalize)) {
+    cout << program.error() << endl;
+  }
+  const char *perInstance[] = { "center", "sphereRadius", "color" };
+  const size_t perInstanceCount = sizeof(perInstance) / sizeof(perInstance[0]);
+  for (size_t i = 0; i < perInstanceCount; ++i)
+    program.setAttributeDivisor(perInstance[i], 1);
+
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4,
+                        static_cast<GLsizei>(numberOfInstances));
+
+  vbo.release();
+
+  // Divisors are not part of the program, leave them as other drawables
+  // expect to find them.
+  for (size_t i = 0; i < perInstanceCount; ++i) {
+    program.setAttributeDivisor(perInstance[i], 0);
+    program.disableAttributeArray(perInstance[i]);
+  }
+  program.disableAttributeArray("corner");
 }
 
 std::multimap<float, Identifier>
@@ -224,32 +411,68 @@ SphereGeometry::hits(const Vector3f &rayOrigin,
                      const Vector3f &rayDirection) const
 {
   std::multimap<float, Identifier> result;
+  if (m_identifier.type == InvalidType)
+    return result;
+
+  d->bvh.update(m_spheres, sphereBounds);
+  std::multimap<float, size_t> sphereHits;
+  d->bvh.hits(rayOrigin, rayDirection, (rayEnd - rayOrigin).norm(),
+              SphereRayTest(m_spheres, rayOrigin, rayEnd, rayDirection),
+              sphereHits);
+
+  Identifier id;
+  id.molecule = m_identifier.molecule;
+  id.type = m_identifier.type;
+  for (std::multimap<float, size_t>::const_iterator it = sphereHits.begin();
+       it != sphereHits.end(); ++it) {
+    id.index = it->second;
+    result.insert(std::pair<float, Identifier>(it->first, id));
+  }
+  return result;
+}
 
-  // Check for intersection.
-  for (size_t i = 0; i < m_spheres.size(); ++i) {
-    const SphereColor &sphere = m_spheres[i];
-
-    Vector3f distance = sphere.center - rayOrigin;
-    float B = distance.dot(rayDirection);
-    float C = distance.dot(distance) - (sphere.radius * sphere.radius);
-    float D = B * B - C;
-
-    // Test for intersection
-    if (D < 0)
-      continue;
-
-    // Test for clipping
-    if (B < 0 || (sphere.center - rayEnd).dot(rayDirection) > 0)
-      continue;
-
-    Identifier id;
+Identifier SphereGeometry::hit(const Vector3f &rayOrigin,
+                               const Vector3f &rayEnd,
+                               const Vector3f &rayDirection,
+                               float &depth) const
+{
+  Identifier id;
+  if (m_identifier.type == InvalidType)
+    return id;
+
+  d->bvh.update(m_spheres, sphereBounds);
+  size_t index = d->bvh.nearest(rayOrigin, rayDirection,
+                                (rayEnd - rayOrigin).norm(),
+                                SphereRayTest(m_spheres, rayOrigin, rayEnd,
+                                              rayDirection),
+                                depth);
+  if (index != MaxIndex) {
     id.molecule = m_identifier.molecule;
     id.type = m_identifier.type;
-    id.index = i;
-    if (id.type != InvalidType) {
-      float rootD = static_cast<float>(sqrt(D));
-      float depth = std::min(std::abs(B + rootD), std::abs(B - rootD));
-      result.insert(std::pair<float, Identifier>(depth, id));
+    id.index = index;
+  }
+  return id;
+}
+
+std::vector<Identifier>
+SphereGeometry::areaHits(const Frustum &frustum) const
+{
+  std::vector<Identifier> result;
+  if (m_identifier.type == InvalidType)
+    return result;
+
+  d->bvh.update(m_spheres, sphereBounds);
+  std::vector<size_t> candidates;
+  d->bvh.overlapping(frustum, candidates);
+  std::sort(candidates.begin(), candidates.end());
+
+  Identifier id;
+  id.molecule = m_identifier.molecule;
+  id.type = m_identifier.type;
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    if (frustum.contains(m_spheres[candidates[i]].center)) {
+      id.index = candidates[i];
+      result.push_back(id);
     }
   }
   return result;
@@ -259,14 +482,36 @@ void SphereGeometry::addSphere(const Vector3f &position, const Vector3ub &color,
                                float radius)
 {
   m_dirty = true;
+  d->bvh.invalidate();
   m_spheres.push_back(SphereColor(position, radius, color));
   m_indices.push_back(m_indices.size());
 }
 
+void SphereGeometry::setSphere(size_t index, const Vector3f &position,
+                               const Vector3ub &color, float radius)
+{
+  if (index >= m_spheres.size())
+    return;
+  const SphereColor &sphere = m_spheres[index];
+  if (sphere.center == position && sphere.color == color
+      && sphere.radius == radius) {
+    return;
+  }
+  m_spheres[index] = SphereColor(position, radius, color);
+  markRangeDirty(index, index + 1);
+}
+
+void SphereGeometry::markRangeDirty(size_t begin, size_t end)
+{
+  Drawable::markRangeDirty(begin, end);
+  d->bvh.markMoved(begin, end);
+}
+
 void SphereGeometry::clear()
 {
   m_spheres.clear();
   m_indices.clear();
+  d->bvh.invalidate();
 }
 
 } // End namespace Rendering
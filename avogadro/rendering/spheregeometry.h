@@ -29,10 +29,19 @@ struct SphereColor
 {
   SphereColor(Vector3f centre, float r, Vector3ub c)
     : center(centre), radius(r), color(c) {}
+
+  // Offsets of the members, the array is uploaded as-is for instancing.
+  static int centerOffset() { return 0; }
+  static int radiusOffset() { return static_cast<int>(sizeof(Vector3f)); }
+  static int colorOffset()
+  {
+    return radiusOffset() + static_cast<int>(sizeof(float));
+  }
+
   Vector3f center;
   float radius;
   Vector3ub color;
-};
+}; // 20 bytes total size, against 152 per sphere drawn without instancing.
 
 /**
  * @class SphereGeometry spheregeometry.h <avogadro/rendering/spheregeometry.h>
@@ -44,6 +53,13 @@ struct SphereColor
  * spheres are not a densely packed one-to-one mapping with the objects indices
  * they can also optionally use an identifier that will point to some numeric
  * ID for the purposes of picking.
+ *
+ * Picking uses a BoundingVolumeHierarchy of the spheres, which is built on the
+ * first pick after spheres are added, and refitted when they are changed.
+ *
+ * When the context supports instancing the spheres are uploaded as they are
+ * stored and expanded to quads in the vertex shader, otherwise the vertices of
+ * each quad are built on the CPU.
  */
 
 class AVOGADRORENDERING_EXPORT SphereGeometry : public Drawable
@@ -83,6 +99,19 @@ public:
                                         const Vector3f &rayEnd,
                                         const Vector3f &rayDirection) const;
 
+  /**
+   * Return the sphere hit by the ray closest to its origin.
+   * @sa Drawable::hit()
+   */
+  Identifier hit(const Vector3f &rayOrigin, const Vector3f &rayEnd,
+                 const Vector3f &rayDirection,
+                 float &depth) const AVO_OVERRIDE;
+
+  /**
+   * Return the spheres with their center inside @a frustum.
+   */
+  std::vector<Identifier> areaHits(const Frustum &frustum) const AVO_OVERRIDE;
+
   /**
    * Add a sphere to the geometry object.
    */
@@ -90,7 +119,22 @@ public:
                  float radius);
 
   /**
-   * Get a reference to the spheres.
+   * Replace the sphere at @a index, for example when an atom moves. Only the
+   * spheres that change are uploaded again on the next update(), rather than
+   * rebuilding all of the geometry.
+   */
+  void setSphere(size_t index, const Vector3f &position,
+                 const Vector3ub &color, float radius);
+
+  /**
+   * Mark spheres changed in place, so that they are uploaded again and the
+   * picking hierarchy is refitted to them.
+   */
+  void markRangeDirty(size_t begin, size_t end) AVO_OVERRIDE;
+
+  /**
+   * Get a reference to the spheres. When they are changed in place, the
+   * changed range must be passed to markRangeDirty() to be uploaded again.
    */
   Core::Array<SphereColor>& spheres() { return m_spheres; }
   const Core::Array<SphereColor>& spheres() const { return m_spheres; }
@@ -106,6 +150,8 @@ public:
   size_t size() const { return m_spheres.size(); }
 
 private:
+  void updateInstances();
+
   Core::Array<SphereColor> m_spheres;
   Core::Array<size_t> m_indices;
 
@@ -129,6 +175,8 @@ inline void swap(SphereGeometry &lhs, SphereGeometry &rhs)
   swap(lhs.m_spheres, rhs.m_spheres);
   swap(lhs.m_indices, rhs.m_indices);
   lhs.m_dirty = rhs.m_dirty = true;
+  lhs.markRangeDirty(0, lhs.size());
+  rhs.markRangeDirty(0, rhs.size());
 }
 
 } // End namespace Rendering
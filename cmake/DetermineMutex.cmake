@@ -1,5 +1,9 @@
 # Find the best mutex class available on the current platform. This defaults to
-# using the C++11 mutex if available, and falling back to the Boost mutex.
+# using the C++11 mutex if available, and falling back to the Boost mutex. The
+# matching condition variable, unique lock, chrono namespace and thread are
+# returned in ${type}_CONDITION, ${type}_CONDITION_HEADER, ${type}_UNIQUE_LOCK,
+# ${type}_CHRONO, ${type}_CHRONO_HEADER, ${type}_THREAD and
+# ${type}_THREAD_HEADER.
 function(determine_mutex type incType)
 
   set(RESULT 0)
@@ -22,6 +26,13 @@ int main(int, char * [])
     if(MUTEX_TYPE_FOUND)
       set(RESULT "std::mutex")
       set(INCLUDE_RESULT "mutex")
+      set(CONDITION_RESULT "std::condition_variable")
+      set(CONDITION_INCLUDE_RESULT "condition_variable")
+      set(UNIQUE_LOCK_RESULT "std::unique_lock<std::mutex>")
+      set(CHRONO_RESULT "std::chrono")
+      set(CHRONO_INCLUDE_RESULT "chrono")
+      set(THREAD_RESULT "std::thread")
+      set(THREAD_INCLUDE_RESULT "thread")
     endif()
   endif()
 
@@ -29,10 +40,24 @@ int main(int, char * [])
   if(NOT MUTEX_TYPE_FOUND OR FORCE_ANSI_CPP)
     set(RESULT "boost::mutex")
     set(INCLUDE_RESULT "boost/thread/mutex.hpp")
+    set(CONDITION_RESULT "boost::condition_variable")
+    set(CONDITION_INCLUDE_RESULT "boost/thread/condition_variable.hpp")
+    set(UNIQUE_LOCK_RESULT "boost::unique_lock<boost::mutex>")
+    set(CHRONO_RESULT "boost::chrono")
+    set(CHRONO_INCLUDE_RESULT "boost/chrono.hpp")
+    set(THREAD_RESULT "boost::thread")
+    set(THREAD_INCLUDE_RESULT "boost/thread/thread.hpp")
     set(${type}_BOOST_REQUIRED TRUE PARENT_SCOPE)
   endif()
 
   set(${type} ${RESULT} PARENT_SCOPE)
   set(${incType} ${INCLUDE_RESULT} PARENT_SCOPE)
+  set(${type}_CONDITION ${CONDITION_RESULT} PARENT_SCOPE)
+  set(${type}_CONDITION_HEADER ${CONDITION_INCLUDE_RESULT} PARENT_SCOPE)
+  set(${type}_UNIQUE_LOCK ${UNIQUE_LOCK_RESULT} PARENT_SCOPE)
+  set(${type}_CHRONO ${CHRONO_RESULT} PARENT_SCOPE)
+  set(${type}_CHRONO_HEADER ${CHRONO_INCLUDE_RESULT} PARENT_SCOPE)
+  set(${type}_THREAD ${THREAD_RESULT} PARENT_SCOPE)
+  set(${type}_THREAD_HEADER ${THREAD_INCLUDE_RESULT} PARENT_SCOPE)
 
 endfunction()
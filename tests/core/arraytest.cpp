@@ -18,8 +18,46 @@
 
 #include <avogadro/core/array.h>
 
+#include <avogadro/stl/mutex_p.h>
+
+#include <ctime>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
 using Avogadro::Core::Array;
 
+namespace {
+// Repeatedly copies a shared array, modifies and destroys the copies.
+class CopyWorker
+{
+public:
+  CopyWorker(const Array<int> &array, int id, bool &ok)
+    : m_array(array), m_id(id), m_ok(ok)
+  {
+  }
+
+  void operator()()
+  {
+    for (int i = 0; i < 2000; ++i) {
+      Array<int> copy(m_array);
+      Array<int> copy2(copy);
+      if (copy.constData() != m_array.constData())
+        m_ok = false;
+      // Detaches from the shared data, which must be left untouched.
+      copy[i % copy.size()] = m_id;
+      if (copy2[i % copy2.size()] != static_cast<int>(i % copy2.size()))
+        m_ok = false;
+    }
+  }
+
+private:
+  const Array<int> &m_array;
+  int m_id;
+  bool &m_ok;
+};
+}
+
 TEST(ArrayTest, setSize)
 {
   Array<int> array;
@@ -110,3 +148,95 @@ TEST(ArrayTest, operators)
   swap(a1, a2);
   EXPECT_TRUE(a2 == a1c);
 }
+
+TEST(ArrayTest, threadedCopies)
+{
+  Array<int> array;
+  for (int i = 0; i < 100; ++i)
+    array.push_back(i);
+
+  const int threadCount = 8;
+  bool ok[threadCount];
+  std::vector<Avogadro::Stl::thread *> threads;
+  for (int i = 0; i < threadCount; ++i) {
+    ok[i] = true;
+    threads.push_back(new Avogadro::Stl::thread(CopyWorker(array, -i, ok[i])));
+  }
+  for (int i = 0; i < threadCount; ++i) {
+    threads[i]->join();
+    delete threads[i];
+    EXPECT_TRUE(ok[i]);
+  }
+
+  // Only the original array is left referencing the data.
+  const int *data = array.constData();
+  array[0] = 42;
+  EXPECT_EQ(array.constData(), data);
+  for (int i = 1; i < 100; ++i)
+    EXPECT_EQ(array[i], i);
+}
+
+TEST(ArrayTest, span)
+{
+  Array<int> empty;
+  Array<int>::Span emptySpan(empty.span());
+  EXPECT_TRUE(emptySpan.empty());
+  EXPECT_EQ(emptySpan.begin(), emptySpan.end());
+
+  Array<int> array(10, 1);
+  Array<int> copy(array);
+  EXPECT_EQ(array.constData(), copy.constData());
+
+  // The span detaches once, the copy must not see the changes made through it.
+  Array<int>::Span span(array.span());
+  EXPECT_NE(array.constData(), copy.constData());
+  EXPECT_EQ(span.data(), array.constData());
+  EXPECT_EQ(span.size(), array.size());
+  for (size_t i = 0; i < span.size(); ++i)
+    span[i] = static_cast<int>(i);
+  for (int *it = span.begin(); it != span.end(); ++it)
+    *it *= 2;
+
+  for (size_t i = 0; i < array.size(); ++i) {
+    EXPECT_EQ(array[i], static_cast<int>(2 * i));
+    EXPECT_EQ(copy[i], 1);
+  }
+
+  // Taking another span of an array that is not shared keeps the storage.
+  EXPECT_EQ(array.span().data(), span.data());
+}
+
+// Compares the per-element non-const operator[] with a span on a simple
+// transform loop. This is a benchmark rather than a test, run it with
+// --gtest_also_run_disabled_tests.
+TEST(ArrayTest, DISABLED_spanBenchmark)
+{
+  const size_t size = 1 << 20;
+  const int repeats = 100;
+  Array<double> array(size, 1.0);
+
+  std::clock_t start = std::clock();
+  for (int r = 0; r < repeats; ++r) {
+    for (size_t i = 0; i < size; ++i)
+      array[i] = array[i] * 1.000001 + 0.5;
+  }
+  double indexTime = static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+  double indexSum = std::accumulate(array.begin(), array.end(), 0.0);
+
+  array = Array<double>(size, 1.0);
+  start = std::clock();
+  for (int r = 0; r < repeats; ++r) {
+    Array<double>::Span span(array.span());
+    for (size_t i = 0; i < size; ++i)
+      span[i] = span[i] * 1.000001 + 0.5;
+  }
+  double spanTime = static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+  double spanSum = std::accumulate(array.begin(), array.end(), 0.0);
+
+  EXPECT_EQ(indexSum, spanSum);
+  double elements = static_cast<double>(size) * repeats;
+  std::cout << "operator[]: " << elements / indexTime / 1e6
+            << " M elements/s\n"
+            << "span:       " << elements / spanTime / 1e6
+            << " M elements/s" << std::endl;
+}
@@ -81,6 +81,22 @@ TEST(CubeTest, minmax)
   EXPECT_DOUBLE_EQ(cube.maxValue(), 50.0);
 }
 
+TEST(CubeTest, updateMinMax)
+{
+  Cube cube;
+  cube.setLimits(Vector3(0.0, 0.0, 0.0), Vector3(1.0, 1.0, 1.0),
+                 Vector3i(10, 10, 10));
+  std::vector<double> &data = *cube.data();
+  data[10] = -3.0;
+  data[500] = 7.5;
+  EXPECT_DOUBLE_EQ(cube.minValue(), 0.0);
+  EXPECT_DOUBLE_EQ(cube.maxValue(), 0.0);
+
+  cube.updateMinMax();
+  EXPECT_DOUBLE_EQ(cube.minValue(), -3.0);
+  EXPECT_DOUBLE_EQ(cube.maxValue(), 7.5);
+}
+
 TEST(CubeTest, index)
 {
   Cube cube;
@@ -0,0 +1,163 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2014 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/cube.h>
+#include <avogadro/core/gaussianset.h>
+#include <avogadro/core/gaussiansettools.h>
+#include <avogadro/core/matrix.h>
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/vector.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+using Avogadro::MatrixX;
+using Avogadro::Real;
+using Avogadro::Vector3;
+using Avogadro::Vector3i;
+using Avogadro::Core::Cube;
+using Avogadro::Core::GaussianSet;
+using Avogadro::Core::GaussianSetTools;
+using Avogadro::Core::Molecule;
+
+namespace {
+Real randomReal(Real min, Real max)
+{
+  return min + (max - min) * std::rand() / RAND_MAX;
+}
+
+// Two atoms carrying every shell type handled by GaussianSetTools, with random
+// (but reproducible) orbital coefficients and density matrices.
+void setUpMolecule(Molecule &molecule)
+{
+  std::srand(1234);
+  molecule.addAtom(6).setPosition3d(Vector3(0.0, 0.0, 0.0));
+  molecule.addAtom(8).setPosition3d(Vector3(1.2, 0.3, -0.4));
+
+  GaussianSet *basis = new GaussianSet;
+  unsigned int shell = basis->addBasis(0, GaussianSet::S);
+  basis->addGto(shell, 0.15, 71.6);
+  basis->addGto(shell, 0.53, 13.0);
+  basis->addGto(shell, 0.44, 3.5);
+  shell = basis->addBasis(0, GaussianSet::P);
+  basis->addGto(shell, 0.16, 2.9);
+  basis->addGto(shell, 0.61, 0.6);
+  shell = basis->addBasis(0, GaussianSet::D);
+  basis->addGto(shell, 1.0, 0.8);
+  shell = basis->addBasis(1, GaussianSet::D5);
+  basis->addGto(shell, 1.0, 1.2);
+  shell = basis->addBasis(1, GaussianSet::F);
+  basis->addGto(shell, 1.0, 0.9);
+  shell = basis->addBasis(1, GaussianSet::F7);
+  basis->addGto(shell, 1.0, 1.1);
+  shell = basis->addBasis(1, GaussianSet::S);
+  basis->addGto(shell, 1.0, 0.3);
+
+  // 1 + 3 + 6 + 5 + 10 + 7 + 1 basis functions.
+  const int size = 33;
+  std::vector<double> orbitals(size * size);
+  for (size_t i = 0; i < orbitals.size(); ++i)
+    orbitals[i] = randomReal(-1.0, 1.0);
+  basis->setMolecularOrbitals(orbitals);
+
+  MatrixX density(size, size);
+  MatrixX spinDensity(size, size);
+  for (int i = 0; i < size; ++i) {
+    for (int j = 0; j <= i; ++j) {
+      density(i, j) = density(j, i) = randomReal(-0.5, 0.5);
+      spinDensity(i, j) = spinDensity(j, i) = randomReal(-0.1, 0.1);
+    }
+  }
+  basis->setDensityMatrix(density);
+  basis->setSpinDensityMatrix(spinDensity);
+
+  basis->setMolecule(&molecule);
+  molecule.setBasisSet(basis);
+}
+}
+
+TEST(GaussianSetToolsTest, batch)
+{
+  Molecule molecule;
+  setUpMolecule(molecule);
+  GaussianSetTools tools(&molecule);
+  ASSERT_TRUE(tools.isValid());
+
+  // Points close to the atoms as well as far enough away for shells to be
+  // skipped in the batch calculation.
+  std::vector<Vector3> positions;
+  for (int i = 0; i < 300; ++i) {
+    positions.push_back(Vector3(randomReal(-3.0, 4.0), randomReal(-3.0, 3.0),
+                                randomReal(-3.0, 3.0)));
+  }
+  positions.push_back(Vector3(12.0, 0.0, 0.0));
+
+  std::vector<double> values;
+  for (int mo = 1; mo <= 33; mo += 8) {
+    ASSERT_TRUE(tools.calculateMolecularOrbital(positions, mo, values));
+    ASSERT_EQ(values.size(), positions.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+      EXPECT_NEAR(values[i],
+                  tools.calculateMolecularOrbital(positions[i], mo), 1e-9);
+    }
+  }
+
+  ASSERT_TRUE(tools.calculateElectronDensity(positions, values));
+  ASSERT_EQ(values.size(), positions.size());
+  for (size_t i = 0; i < positions.size(); ++i)
+    EXPECT_NEAR(values[i], tools.calculateElectronDensity(positions[i]), 1e-9);
+
+  ASSERT_TRUE(tools.calculateSpinDensity(positions, values));
+  ASSERT_EQ(values.size(), positions.size());
+  for (size_t i = 0; i < positions.size(); ++i)
+    EXPECT_NEAR(values[i], tools.calculateSpinDensity(positions[i]), 1e-9);
+
+  // Invalid orbital numbers are rejected.
+  EXPECT_FALSE(tools.calculateMolecularOrbital(positions, 0, values));
+  EXPECT_FALSE(tools.calculateMolecularOrbital(positions, 34, values));
+}
+
+TEST(GaussianSetToolsTest, cube)
+{
+  Molecule molecule;
+  setUpMolecule(molecule);
+  GaussianSetTools tools(&molecule);
+
+  Cube cube;
+  ASSERT_TRUE(cube.setLimits(Vector3(-2.0, -2.5, -3.0), Vector3(3.0, 2.5, 2.0),
+                             Vector3i(7, 9, 11)));
+  ASSERT_TRUE(tools.calculateElectronDensity(cube));
+
+  const std::vector<double> &data = *cube.data();
+  ASSERT_EQ(data.size(), static_cast<size_t>(7 * 9 * 11));
+  for (size_t i = 0; i < data.size(); ++i) {
+    EXPECT_NEAR(data[i],
+                tools.calculateElectronDensity(
+                  cube.position(static_cast<unsigned int>(i))), 1e-9);
+  }
+  EXPECT_EQ(cube.minValue(), *std::min_element(data.begin(), data.end()));
+  EXPECT_EQ(cube.maxValue(), *std::max_element(data.begin(), data.end()));
+
+  ASSERT_TRUE(tools.calculateMolecularOrbital(cube, 5));
+  for (size_t i = 0; i < data.size(); i += 13) {
+    EXPECT_NEAR(data[i],
+                tools.calculateMolecularOrbital(
+                  cube.position(static_cast<unsigned int>(i)), 5), 1e-9);
+  }
+}
@@ -77,6 +77,7 @@ void MeshTest::assertEquals(const Mesh &m1, const Mesh &m2)
     ++i;
   }
   EXPECT_TRUE(m1.normals() == m2.normals());
+  EXPECT_TRUE(m1.indices() == m2.indices());
 }
 
 TEST_F(MeshTest, copy)
@@ -94,3 +95,41 @@ TEST_F(MeshTest, assigment)
   assertEquals(m_testMesh, assign);
   EXPECT_NE(m_testMesh.lock(), assign.lock());
 }
+
+TEST_F(MeshTest, indices)
+{
+  Mesh mesh;
+  Array<Vector3f> vertices;
+  vertices.push_back(Vector3f(0.0f, 0.0f, 0.0f));
+  vertices.push_back(Vector3f(1.0f, 0.0f, 0.0f));
+  vertices.push_back(Vector3f(0.0f, 1.0f, 0.0f));
+  vertices.push_back(Vector3f(1.0f, 1.0f, 0.0f));
+  mesh.setVertices(vertices);
+  mesh.setNormals(Array<Vector3f>(4, Vector3f(0.0f, 0.0f, 1.0f)));
+  mesh.setColors(Array<Color3f>(1, Color3f(255, 0, 0)));
+  EXPECT_EQ(mesh.numTriangles(), static_cast<unsigned int>(1));
+
+  Array<unsigned int> indices;
+  indices.push_back(0);
+  indices.push_back(1);
+  indices.push_back(2);
+  indices.push_back(2);
+  indices.push_back(1);
+  EXPECT_FALSE(mesh.setIndices(indices));
+  indices.push_back(3);
+  EXPECT_TRUE(mesh.setIndices(indices));
+  EXPECT_EQ(mesh.numIndices(), static_cast<unsigned int>(6));
+  EXPECT_EQ(mesh.numTriangles(), static_cast<unsigned int>(2));
+  EXPECT_TRUE(mesh.valid());
+
+  Mesh copy(mesh);
+  EXPECT_TRUE(copy.indices() == mesh.indices());
+
+  // Indices must refer to existing vertices.
+  indices[5] = 4;
+  mesh.setIndices(indices);
+  EXPECT_FALSE(mesh.valid());
+
+  mesh.clear();
+  EXPECT_EQ(mesh.numIndices(), static_cast<unsigned int>(0));
+}
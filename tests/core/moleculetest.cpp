@@ -24,7 +24,12 @@
 #include <avogadro/core/color3f.h>
 #include <avogadro/core/mesh.h>
 
+#include <avogadro/stl/mutex_p.h>
+
+#include <vector>
+
 using Avogadro::Index;
+using Avogadro::Real;
 using Avogadro::Vector2;
 using Avogadro::Vector3;
 using Avogadro::Vector3f;
@@ -177,6 +182,47 @@ TEST_F(MoleculeTest, addBond)
   EXPECT_EQ(bond.atom2().index(), c.index());
 }
 
+TEST_F(MoleculeTest, addAtoms)
+{
+  Molecule molecule;
+  molecule.addAtom(1);
+  Array<unsigned char> numbers;
+  numbers.push_back(6);
+  numbers.push_back(8);
+  molecule.addAtoms(numbers);
+  EXPECT_EQ(molecule.atomCount(), static_cast<Index>(3));
+  EXPECT_EQ(molecule.atom(0).atomicNumber(), static_cast<unsigned char>(1));
+  EXPECT_EQ(molecule.atom(2).atomicNumber(), static_cast<unsigned char>(8));
+}
+
+TEST_F(MoleculeTest, addBonds)
+{
+  Molecule molecule;
+  for (int i = 0; i < 4; ++i)
+    molecule.addAtom(6);
+  molecule.addBond(0, 1);
+
+  Array<std::pair<Index, Index> > pairs;
+  pairs.push_back(std::make_pair(static_cast<Index>(2), static_cast<Index>(1)));
+  pairs.push_back(std::make_pair(static_cast<Index>(2), static_cast<Index>(3)));
+  Array<unsigned char> orders;
+  orders.push_back(2);
+  EXPECT_FALSE(molecule.addBonds(pairs, orders));
+  orders.push_back(3);
+  EXPECT_TRUE(molecule.addBonds(pairs, orders));
+  EXPECT_EQ(molecule.bondCount(), static_cast<Index>(3));
+  EXPECT_EQ(molecule.bondPair(1), std::make_pair(static_cast<Index>(1),
+                                                 static_cast<Index>(2)));
+  EXPECT_EQ(molecule.bond(2, 3).index(), static_cast<Index>(2));
+  EXPECT_EQ(molecule.bond(2, 3).order(), static_cast<unsigned char>(3));
+  EXPECT_EQ(molecule.bonds(1).size(), static_cast<size_t>(2));
+
+  // Bonds to missing atoms are rejected as a whole.
+  pairs.push_back(std::make_pair(static_cast<Index>(0), static_cast<Index>(4)));
+  EXPECT_FALSE(molecule.addBonds(pairs, Array<unsigned char>()));
+  EXPECT_EQ(molecule.bondCount(), static_cast<Index>(3));
+}
+
 TEST_F(MoleculeTest, removeBond)
 {
   Molecule molecule;
@@ -222,6 +268,57 @@ TEST_F(MoleculeTest, findBond)
   EXPECT_EQ(molecule.bonds(a3).size(), 1);
 }
 
+TEST_F(MoleculeTest, bondIndex)
+{
+  // A ring of six carbons with a hydrogen on each.
+  Molecule molecule;
+  for (Index i = 0; i < 6; ++i)
+    molecule.addAtom(6);
+  for (Index i = 0; i < 6; ++i) {
+    molecule.addBond(i, (i + 1) % 6, 1);
+    Atom h = molecule.addAtom(1);
+    molecule.addBond(i, h.index(), 1);
+  }
+  EXPECT_EQ(molecule.graph().edgeCount(), static_cast<size_t>(12));
+
+  // Remove a ring atom, the last atom is moved into its place.
+  molecule.removeAtom(2);
+  EXPECT_EQ(molecule.atomCount(), static_cast<Index>(11));
+  EXPECT_EQ(molecule.bondCount(), static_cast<Index>(9));
+
+  // Every bond must be found through the index of both of its atoms, and the
+  // graph must have been kept in step with the bonds.
+  const Avogadro::Core::Graph &graph = molecule.graph();
+  EXPECT_EQ(graph.size(), static_cast<size_t>(11));
+  EXPECT_EQ(graph.edgeCount(), static_cast<size_t>(9));
+  for (Index i = 0; i < molecule.bondCount(); ++i) {
+    std::pair<Index, Index> pair = molecule.bondPair(i);
+    EXPECT_LT(pair.first, pair.second);
+    EXPECT_EQ(molecule.bond(pair.first, pair.second).index(), i);
+    EXPECT_EQ(molecule.bond(pair.second, pair.first).index(), i);
+    EXPECT_TRUE(graph.containsEdge(pair.first, pair.second));
+  }
+  Index degreeSum = 0;
+  for (Index i = 0; i < molecule.atomCount(); ++i) {
+    std::vector<Index> indices = molecule.bondIndices(i);
+    EXPECT_EQ(indices.size(), graph.degree(i));
+    for (size_t j = 1; j < indices.size(); ++j)
+      EXPECT_LT(indices[j - 1], indices[j]);
+    degreeSum += indices.size();
+  }
+  EXPECT_EQ(degreeSum, 2 * molecule.bondCount());
+
+  // Replacing the atoms of a bond must also be picked up.
+  molecule.setBondPair(0, std::make_pair(static_cast<Index>(0),
+                                         static_cast<Index>(10)));
+  EXPECT_TRUE(molecule.bond(0, 10).isValid());
+  EXPECT_TRUE(molecule.graph().containsEdge(0, 10));
+
+  molecule.clearBonds();
+  EXPECT_EQ(molecule.graph().edgeCount(), static_cast<size_t>(0));
+  EXPECT_TRUE(molecule.bondIndices(0).empty());
+}
+
 TEST_F(MoleculeTest, setData)
 {
   Molecule molecule;
@@ -282,3 +379,150 @@ TEST_F(MoleculeTest, assignment)
 
   assertEqual(m_testMolecule, assign);
 }
+
+TEST_F(MoleculeTest, snapshot)
+{
+  Molecule molecule(m_testMolecule);
+  Molecule::Snapshot snapshot = molecule.snapshot();
+  EXPECT_EQ(snapshot.atomCount(), molecule.atomCount());
+  EXPECT_EQ(snapshot.bondCount(), molecule.bondCount());
+  // Taking a snapshot does not copy the arrays.
+  EXPECT_EQ(snapshot.atomPositions3d().constData(),
+            molecule.atomPositions3d().constData());
+  EXPECT_EQ(snapshot.bondPairs().constData(),
+            molecule.bondPairs().constData());
+
+  // Later changes to the molecule are not seen in the snapshot.
+  Vector3 position(molecule.atomPosition3d(0));
+  molecule.setAtomPosition3d(0, Vector3(9.0, 9.0, 9.0));
+  molecule.addAtom(1);
+  molecule.setBondOrder(0, 3);
+  EXPECT_EQ(snapshot.atomPositions3d()[0], position);
+  EXPECT_EQ(snapshot.atomCount() + 1, molecule.atomCount());
+  EXPECT_EQ(snapshot.bondOrders()[0], m_testMolecule.bondOrder(0));
+  EXPECT_EQ(snapshot.atomicNumbers()[0], m_testMolecule.atomicNumber(0));
+}
+
+namespace {
+// The latest snapshot of a molecule, shared between the editing thread and the
+// readers.
+class SnapshotQueue
+{
+public:
+  SnapshotQueue() : m_snapshot(new Molecule::Snapshot), m_done(false) {}
+  ~SnapshotQueue() { delete m_snapshot; }
+
+  void publish(const Molecule &molecule)
+  {
+    // Take the snapshot in the editing thread, and release the last one here
+    // while the readers may still hold copies of it.
+    Molecule::Snapshot *snapshot = new Molecule::Snapshot(molecule);
+    m_mutex.lock();
+    std::swap(snapshot, m_snapshot);
+    m_mutex.unlock();
+    delete snapshot;
+  }
+
+  Molecule::Snapshot latest(bool &done)
+  {
+    m_mutex.lock();
+    Molecule::Snapshot snapshot(*m_snapshot);
+    done = m_done;
+    m_mutex.unlock();
+    return snapshot;
+  }
+
+  void finish()
+  {
+    m_mutex.lock();
+    m_done = true;
+    m_mutex.unlock();
+  }
+
+private:
+  Avogadro::Stl::mutex m_mutex;
+  Molecule::Snapshot *m_snapshot;
+  bool m_done;
+};
+
+// Reads snapshots until the queue is finished, checking that each one is
+// consistent and that they never go back in time.
+class SnapshotReader
+{
+public:
+  SnapshotReader(SnapshotQueue &queue, bool &ok) : m_queue(queue), m_ok(ok) {}
+
+  void operator()()
+  {
+    Real last = 0.0;
+    bool done = false;
+    while (!done) {
+      Molecule::Snapshot snapshot = m_queue.latest(done);
+      const Array<Vector3> &positions =
+          snapshot.atomPositions3d();
+      if (snapshot.atomCount() == 0)
+        continue;
+      if (positions.size() != snapshot.atomCount()
+          || snapshot.bondOrders().size() != snapshot.bondCount()) {
+        m_ok = false;
+        continue;
+      }
+      Real generation = positions[0].x();
+      if (generation < last)
+        m_ok = false;
+      last = generation;
+      for (Index i = 0; i < positions.size(); ++i) {
+        if (positions[i] != Vector3(generation, -generation, i))
+          m_ok = false;
+      }
+      for (Index i = 0; i < snapshot.bondCount(); ++i) {
+        if (snapshot.bondOrders()[i] != static_cast<int>(generation) % 3 + 1)
+          m_ok = false;
+      }
+    }
+  }
+
+private:
+  SnapshotQueue &m_queue;
+  bool &m_ok;
+};
+}
+
+TEST_F(MoleculeTest, snapshotThreads)
+{
+  Molecule molecule;
+  for (Index i = 0; i < 200; ++i) {
+    molecule.addAtom(6);
+    if (i > 0)
+      molecule.addBond(i - 1, i);
+  }
+  molecule.setAtomPositions3d(Array<Vector3>(200, Vector3::Zero()));
+
+  SnapshotQueue queue;
+  const int threadCount = 4;
+  bool ok[threadCount];
+  std::vector<Avogadro::Stl::thread *> threads;
+  for (int i = 0; i < threadCount; ++i) {
+    ok[i] = true;
+    threads.push_back(
+          new Avogadro::Stl::thread(SnapshotReader(queue, ok[i])));
+  }
+
+  // Keep editing the molecule in place while the readers look at snapshots.
+  for (int generation = 1; generation <= 2000; ++generation) {
+    Array<Vector3> &positions = molecule.atomPositions3d();
+    for (Index i = 0; i < positions.size(); ++i)
+      positions[i] = Vector3(generation, -generation, i);
+    Array<unsigned char> &orders = molecule.bondOrders();
+    for (Index i = 0; i < orders.size(); ++i)
+      orders[i] = static_cast<unsigned char>(generation % 3 + 1);
+    queue.publish(molecule);
+  }
+  queue.finish();
+
+  for (int i = 0; i < threadCount; ++i) {
+    threads[i]->join();
+    delete threads[i];
+    EXPECT_TRUE(ok[i]);
+  }
+}
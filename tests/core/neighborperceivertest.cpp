@@ -0,0 +1,118 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2014 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/neighborperceiver.h>
+#include <avogadro/core/vector.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+using Avogadro::Index;
+using Avogadro::Real;
+using Avogadro::Vector3;
+using Avogadro::Core::Array;
+using Avogadro::Core::Molecule;
+using Avogadro::Core::NeighborPerceiver;
+
+namespace {
+Vector3 randomPoint(Real extent)
+{
+  return Vector3(extent * std::rand() / RAND_MAX,
+                 extent * std::rand() / RAND_MAX,
+                 extent * std::rand() / RAND_MAX);
+}
+}
+
+TEST(NeighborPerceiverTest, empty)
+{
+  Array<Vector3> points;
+  NeighborPerceiver perceiver(points, 1.0);
+  EXPECT_EQ(perceiver.pointCount(), static_cast<Index>(0));
+
+  std::vector<Index> neighbors;
+  perceiver.neighbors(Vector3::Zero(), neighbors);
+  EXPECT_TRUE(neighbors.empty());
+}
+
+TEST(NeighborPerceiverTest, bruteForce)
+{
+  std::srand(42);
+  const Real maxDistance = 2.5;
+  Array<Vector3> points;
+  for (int i = 0; i < 2000; ++i)
+    points.push_back(randomPoint(30.0));
+
+  NeighborPerceiver perceiver(points, maxDistance);
+  EXPECT_EQ(perceiver.pointCount(), points.size());
+  EXPECT_GE(perceiver.cellSize(), maxDistance);
+
+  // Query both inside and outside of the bounding box of the points.
+  std::vector<Index> neighbors;
+  for (int q = 0; q < 200; ++q) {
+    Vector3 query = randomPoint(40.0) - Vector3(5.0, 5.0, 5.0);
+    neighbors.clear();
+    perceiver.neighbors(query, neighbors);
+    std::sort(neighbors.begin(), neighbors.end());
+    EXPECT_TRUE(std::adjacent_find(neighbors.begin(), neighbors.end())
+                == neighbors.end());
+    for (Index i = 0; i < points.size(); ++i) {
+      if ((points[i] - query).norm() < maxDistance) {
+        EXPECT_TRUE(std::binary_search(neighbors.begin(), neighbors.end(), i))
+            << "Missed point " << i << " for query " << q;
+      }
+    }
+  }
+}
+
+TEST(NeighborPerceiverTest, sparse)
+{
+  // Two points very far apart must not allocate an enormous grid.
+  Array<Vector3> points;
+  points.push_back(Vector3(0.0, 0.0, 0.0));
+  points.push_back(Vector3(1.0e6, 1.0e6, 1.0e6));
+  points.push_back(Vector3(1.0, 0.0, 0.0));
+
+  NeighborPerceiver perceiver(points, 1.5);
+  EXPECT_GT(perceiver.cellSize(), 1.5);
+
+  std::vector<Index> neighbors;
+  perceiver.neighbors(Vector3::Zero(), neighbors);
+  std::sort(neighbors.begin(), neighbors.end());
+  EXPECT_TRUE(std::binary_search(neighbors.begin(), neighbors.end(), 0));
+  EXPECT_TRUE(std::binary_search(neighbors.begin(), neighbors.end(), 2));
+}
+
+TEST(NeighborPerceiverTest, perceiveBondsSimple)
+{
+  // A chain of carbons on a zig-zag, bonded to their direct neighbors only.
+  Molecule molecule;
+  for (int i = 0; i < 500; ++i) {
+    molecule.addAtom(6).setPosition3d(
+          Vector3(1.25 * i, (i % 2) * 0.8, 0.0));
+  }
+  molecule.perceiveBondsSimple();
+  EXPECT_EQ(molecule.bondCount(), static_cast<Index>(499));
+  for (Index i = 0; i < molecule.bondCount(); ++i) {
+    std::pair<Index, Index> pair = molecule.bondPair(i);
+    EXPECT_EQ(pair.first, i);
+    EXPECT_EQ(pair.second, i + 1);
+  }
+}
@@ -0,0 +1,58 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2014 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/readwritelock.h>
+
+using Avogadro::Core::ReadWriteLock;
+
+TEST(ReadWriteLockTest, readers)
+{
+  ReadWriteLock lock;
+
+  // Any number of readers can share the lock, but no writer.
+  lock.lockForRead();
+  EXPECT_TRUE(lock.tryLockForRead());
+  EXPECT_FALSE(lock.tryLockForWrite());
+  lock.unlock();
+  EXPECT_FALSE(lock.tryLockForWrite());
+  lock.unlock();
+
+  EXPECT_TRUE(lock.tryLockForWrite());
+  lock.unlock();
+}
+
+TEST(ReadWriteLockTest, writer)
+{
+  ReadWriteLock lock;
+
+  // A writer excludes both readers and other writers.
+  lock.lockForWrite();
+  EXPECT_FALSE(lock.tryLockForRead());
+  EXPECT_FALSE(lock.tryLockForWrite());
+  lock.unlock();
+
+  EXPECT_TRUE(lock.tryLockForRead());
+  lock.unlock();
+  EXPECT_TRUE(lock.tryLockForWrite());
+  lock.unlock();
+
+  // Unlocking a lock that is not held does nothing.
+  lock.unlock();
+  EXPECT_TRUE(lock.tryLockForWrite());
+  lock.unlock();
+}
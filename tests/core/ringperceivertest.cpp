@@ -57,3 +57,105 @@ TEST(RingPerceiverTest, ethanol)
   std::vector<std::vector<size_t> > rings = perceiver.rings();
   EXPECT_EQ(rings.size(), static_cast<size_t>(0));
 }
+
+TEST(RingPerceiverTest, naphthalene)
+{
+  Molecule molecule;
+  for (int i = 0; i < 10; ++i)
+    molecule.addAtom(6);
+  for (int i = 0; i < 9; ++i)
+    molecule.addBond(molecule.atom(i), molecule.atom(i + 1), 1);
+  molecule.addBond(molecule.atom(9), molecule.atom(0), 1);
+  molecule.addBond(molecule.atom(0), molecule.atom(5), 1);
+
+  RingPerceiver perceiver(&molecule);
+  std::vector<std::vector<size_t> > rings = perceiver.rings();
+  ASSERT_EQ(rings.size(), static_cast<size_t>(2));
+  EXPECT_EQ(rings[0].size(), static_cast<size_t>(6));
+  EXPECT_EQ(rings[1].size(), static_cast<size_t>(6));
+}
+
+TEST(RingPerceiverTest, cubane)
+{
+  // The sssr has five of the six faces.
+  Molecule molecule;
+  for (int i = 0; i < 8; ++i)
+    molecule.addAtom(6);
+  for (int i = 0; i < 4; ++i) {
+    molecule.addBond(molecule.atom(i), molecule.atom((i + 1) % 4), 1);
+    molecule.addBond(molecule.atom(i + 4), molecule.atom((i + 1) % 4 + 4), 1);
+    molecule.addBond(molecule.atom(i), molecule.atom(i + 4), 1);
+  }
+
+  RingPerceiver perceiver(&molecule);
+  std::vector<std::vector<size_t> > rings = perceiver.rings();
+  ASSERT_EQ(rings.size(), static_cast<size_t>(5));
+  for (size_t i = 0; i < rings.size(); ++i)
+    EXPECT_EQ(rings[i].size(), static_cast<size_t>(4));
+}
+
+TEST(RingPerceiverTest, ringSystems)
+{
+  // A long chain carrying cyclopropane and cyclohexane rings, joined by single
+  // bonds, with another three membered ring fused to the first one.
+  Molecule molecule;
+  size_t chain = 0;
+  molecule.addAtom(6);
+  for (int r = 0; r < 200; ++r) {
+    size_t first = molecule.atomCount();
+    size_t ringSize = r % 2 ? 6 : 3;
+    for (size_t i = 0; i < ringSize; ++i)
+      molecule.addAtom(6);
+    for (size_t i = 0; i < ringSize; ++i) {
+      molecule.addBond(molecule.atom(first + i),
+                       molecule.atom(first + (i + 1) % ringSize), 1);
+    }
+    molecule.addBond(molecule.atom(chain), molecule.atom(first), 1);
+    chain = molecule.atomCount();
+    molecule.addAtom(8);
+    molecule.addBond(molecule.atom(first + 1), molecule.atom(chain), 1);
+  }
+  molecule.addAtom(6);
+  molecule.addBond(molecule.atom(2), molecule.atom(molecule.atomCount() - 1),
+                   1);
+  molecule.addBond(molecule.atom(3), molecule.atom(molecule.atomCount() - 1),
+                   1);
+
+  RingPerceiver perceiver(&molecule);
+  std::vector<std::vector<size_t> > rings = perceiver.rings();
+  ASSERT_EQ(rings.size(), static_cast<size_t>(201));
+  // The rings are sorted by size.
+  for (size_t i = 0; i < rings.size(); ++i) {
+    EXPECT_EQ(rings[i].size(), static_cast<size_t>(i < 101 ? 3 : 6));
+    for (size_t j = 0; j < rings[i].size(); ++j) {
+      EXPECT_TRUE(molecule.graph().containsEdge(
+                    rings[i][j], rings[i][(j + 1) % rings[i].size()]));
+    }
+  }
+}
+
+TEST(RingPerceiverTest, fusedGrid)
+{
+  // A sheet of fused four membered rings. Atoms of a fused sheet are joined by
+  // a number of shortest paths that grows exponentially with their distance,
+  // so this is slow unless only one path is kept for each pair of atoms.
+  const size_t side = 12;
+  Molecule molecule;
+  for (size_t i = 0; i < side * side; ++i)
+    molecule.addAtom(6);
+  for (size_t y = 0; y < side; ++y) {
+    for (size_t x = 0; x < side; ++x) {
+      size_t atom = y * side + x;
+      if (x + 1 < side)
+        molecule.addBond(molecule.atom(atom), molecule.atom(atom + 1), 1);
+      if (y + 1 < side)
+        molecule.addBond(molecule.atom(atom), molecule.atom(atom + side), 1);
+    }
+  }
+
+  RingPerceiver perceiver(&molecule);
+  std::vector<std::vector<size_t> > rings = perceiver.rings();
+  ASSERT_EQ(rings.size(), (side - 1) * (side - 1));
+  for (size_t i = 0; i < rings.size(); ++i)
+    EXPECT_EQ(rings[i].size(), static_cast<size_t>(4));
+}
@@ -0,0 +1,141 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2014 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/stringview.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <locale>
+#include <sstream>
+#include <string>
+
+using std::string;
+using Avogadro::Core::StringView;
+using Avogadro::Core::parseValue;
+
+namespace {
+double streamDouble(const string &input)
+{
+  std::istringstream stream(input);
+  stream.imbue(std::locale::classic());
+  double value = 0.0;
+  stream >> value;
+  return value;
+}
+}
+
+TEST(StringViewTest, view)
+{
+  string line("  C   1.5  -2.0 ");
+  StringView view(line);
+  EXPECT_EQ(view.size(), line.size());
+  EXPECT_EQ(view.data(), line.data());
+  EXPECT_TRUE(view.trimmed() == "C   1.5  -2.0");
+  EXPECT_TRUE(view.substr(2, 1) == "C");
+  EXPECT_TRUE(view.substr(12) == "2.0 ");
+  EXPECT_TRUE(view.substr(100).empty());
+  EXPECT_TRUE(view.substr(2, 100) == "C   1.5  -2.0 ");
+  EXPECT_TRUE(StringView().trimmed().empty());
+  EXPECT_TRUE(StringView("  ").trimmed().empty());
+  EXPECT_EQ(view.substr(2, 1).str(), string("C"));
+  EXPECT_TRUE(view != "C");
+
+  std::ostringstream out;
+  out << view.trimmed();
+  EXPECT_EQ(out.str(), string("C   1.5  -2.0"));
+}
+
+TEST(StringViewTest, parseDouble)
+{
+  const char *numbers[] = {
+    "0", "-0.0", "5.3", "5.3E-10", "  -1.25e+3", "+.5", "7.", "0.000123",
+    "123456789.123456", "1.000000000000000000000000001", "3.141592653589793",
+    "2.2250738585072014e-308", "1.7976931348623157e308", "4.9e-324",
+    "12345678901234567890123", "0.1", "0.2", "0.3", "1e22", "1e23",
+    "-0.00000000000000000000000000001", "6.02214076e23"
+  };
+  for (size_t i = 0; i < sizeof(numbers) / sizeof(numbers[0]); ++i) {
+    double value = 0.0;
+    EXPECT_TRUE(parseValue(StringView(numbers[i]), value)) << numbers[i];
+    // Exactly the same as the standard library.
+    EXPECT_EQ(value, streamDouble(numbers[i])) << numbers[i];
+  }
+
+  // Random numbers printed with various precisions.
+  std::srand(1234);
+  char buffer[64];
+  for (int i = 0; i < 10000; ++i) {
+    double number = (std::rand() - RAND_MAX / 2) * 1.0e-3 / std::rand();
+    std::sprintf(buffer, i % 2 ? "%.*f" : "%.*e", i % 18, number);
+    double value = 0.0;
+    EXPECT_TRUE(parseValue(StringView(buffer), value));
+    EXPECT_EQ(value, streamDouble(buffer)) << buffer;
+  }
+
+  // Fortran exponents, and trailing characters are ignored.
+  double value = 0.0;
+  EXPECT_TRUE(parseValue(StringView("1.5D-03"), value));
+  EXPECT_EQ(value, 1.5e-3);
+  EXPECT_TRUE(parseValue(StringView("-2.5d2"), value));
+  EXPECT_EQ(value, -250.0);
+  EXPECT_TRUE(parseValue(StringView("4.5abc"), value));
+  EXPECT_EQ(value, 4.5);
+  EXPECT_TRUE(parseValue(StringView("4.5e"), value));
+  EXPECT_EQ(value, 4.5);
+
+  // Things that are not numbers.
+  EXPECT_FALSE(parseValue(StringView(""), value));
+  EXPECT_FALSE(parseValue(StringView("   "), value));
+  EXPECT_FALSE(parseValue(StringView("."), value));
+  EXPECT_FALSE(parseValue(StringView("-"), value));
+  EXPECT_FALSE(parseValue(StringView("five"), value));
+
+  float floatValue = 0.0f;
+  EXPECT_TRUE(parseValue(StringView("0.1"), floatValue));
+  EXPECT_EQ(floatValue, 0.1f);
+}
+
+TEST(StringViewTest, parseInteger)
+{
+  int value = 0;
+  EXPECT_TRUE(parseValue(StringView("  42 "), value));
+  EXPECT_EQ(value, 42);
+  EXPECT_TRUE(parseValue(StringView("-17abc"), value));
+  EXPECT_EQ(value, -17);
+  EXPECT_TRUE(parseValue(StringView("2147483647"), value));
+  EXPECT_EQ(value, std::numeric_limits<int>::max());
+  EXPECT_TRUE(parseValue(StringView("-2147483648"), value));
+  EXPECT_EQ(value, std::numeric_limits<int>::min());
+  EXPECT_FALSE(parseValue(StringView("2147483648"), value));
+  EXPECT_FALSE(parseValue(StringView("-2147483649"), value));
+  EXPECT_FALSE(parseValue(StringView("five"), value));
+  EXPECT_FALSE(parseValue(StringView("-"), value));
+
+  short shortValue = 0;
+  EXPECT_TRUE(parseValue(StringView("-32768"), shortValue));
+  EXPECT_EQ(shortValue, std::numeric_limits<short>::min());
+  EXPECT_FALSE(parseValue(StringView("32768"), shortValue));
+
+  unsigned int unsignedValue = 0;
+  EXPECT_TRUE(parseValue(StringView("4294967295"), unsignedValue));
+  EXPECT_EQ(unsignedValue, std::numeric_limits<unsigned int>::max());
+  EXPECT_FALSE(parseValue(StringView("-1"), unsignedValue));
+  EXPECT_TRUE(parseValue(StringView("-0"), unsignedValue));
+  EXPECT_EQ(unsignedValue, 0u);
+}
@@ -19,6 +19,7 @@
 #include <avogadro/core/utilities.h>
 
 using std::string;
+using Avogadro::Core::StringView;
 using Avogadro::Core::contains;
 using Avogadro::Core::lexicalCast;
 using Avogadro::Core::split;
@@ -37,6 +38,23 @@ TEST(UtilitiesTest, splitEmpty)
   EXPECT_EQ(split(test, ' ', false).size(), 7);
 }
 
+TEST(UtilitiesTest, splitViews)
+{
+  string test(" trim white space    ");
+  std::vector<StringView> fields;
+  split(test, ' ', fields);
+  ASSERT_EQ(fields.size(), 3);
+  EXPECT_TRUE(fields[0] == "trim");
+  EXPECT_TRUE(fields[2] == "space");
+
+  // The same items as the copying split.
+  split(test, ' ', fields, false);
+  std::vector<string> copies(split(test, ' ', false));
+  ASSERT_EQ(fields.size(), copies.size());
+  for (size_t i = 0; i < fields.size(); ++i)
+    EXPECT_EQ(fields[i].str(), copies[i]);
+}
+
 TEST(UtilitiesTest, trimmed)
 {
   string test(" trim white space \n\t\r");
@@ -55,6 +73,22 @@ TEST(UtilitiesTest, lexicalCast)
   EXPECT_EQ(lexicalCast<double>("5.3E-10"), 5.3e-10);
 }
 
+TEST(UtilitiesTest, lexicalCastView)
+{
+  string line("C 1.5 -2 3e2");
+  std::vector<StringView> fields;
+  split(line, ' ', fields);
+  ASSERT_EQ(fields.size(), 4);
+  EXPECT_EQ(lexicalCast<double>(fields[1]), 1.5);
+  EXPECT_EQ(lexicalCast<int>(fields[2]), -2);
+  EXPECT_EQ(lexicalCast<double>(fields[3]), 300.0);
+  EXPECT_EQ(lexicalCast<string>(fields[0]), string("C"));
+
+  bool ok(true);
+  lexicalCast<int>(fields[0], ok);
+  EXPECT_FALSE(ok);
+}
+
 TEST(UtilitiesTest, lexicalCastCheck)
 {
   // Something simple that should pass.
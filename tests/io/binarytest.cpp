@@ -0,0 +1,348 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2014 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/cube.h>
+#include <avogadro/core/gaussianset.h>
+#include <avogadro/core/mesh.h>
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/trajectorysource.h>
+#include <avogadro/core/unitcell.h>
+
+#include <avogadro/io/binaryformat.h>
+#include <avogadro/io/fileformatmanager.h>
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+
+using Avogadro::Index;
+using Avogadro::Matrix3;
+using Avogadro::MatrixX;
+using Avogadro::Vector2;
+using Avogadro::Vector3;
+using Avogadro::Vector3f;
+using Avogadro::Core::Array;
+using Avogadro::Core::BasisSet;
+using Avogadro::Core::Color3f;
+using Avogadro::Core::Cube;
+using Avogadro::Core::GaussianSet;
+using Avogadro::Core::Mesh;
+using Avogadro::Core::Molecule;
+using Avogadro::Core::UnitCell;
+using Avogadro::Io::BinaryFormat;
+using Avogadro::Io::FileFormat;
+using Avogadro::Io::FileFormatManager;
+
+namespace {
+// A small molecule using every part of the format.
+void buildMolecule(Molecule &molecule)
+{
+  molecule.addAtom(6).setPosition3d(Vector3(0.0, 0.0, 0.0));
+  molecule.addAtom(8).setPosition3d(Vector3(1.2, 0.0, 0.0));
+  molecule.addAtom(1).setPosition3d(Vector3(-0.5, 0.9, 0.1));
+  molecule.atom(0).setPosition2d(Vector2(0.0, 0.0));
+  molecule.atom(1).setPosition2d(Vector2(1.0, 0.0));
+  molecule.atom(2).setPosition2d(Vector2(-0.5, 1.0));
+  molecule.atom(1).setFormalCharge(-1);
+  molecule.addBond(0, 1, 2);
+  molecule.addBond(0, 2);
+  molecule.setData("name", std::string("formyl"));
+  molecule.setUnitCell(new UnitCell(Vector3(5.0, 0.0, 0.0),
+                                    Vector3(0.5, 6.0, 0.0),
+                                    Vector3(0.0, 0.0, 7.0)));
+
+  Cube *cube = molecule.addCube();
+  cube->setLimits(Vector3(-1.0, -2.0, -3.0), Avogadro::Vector3i(2, 3, 4),
+                  Vector3(0.5, 0.25, 0.125));
+  for (unsigned int i = 0; i < cube->data()->size(); ++i)
+    cube->setValue(i, 0.1 * i - 1.0);
+  cube->updateMinMax();
+  cube->setName("density");
+  cube->setCubeType(Cube::ElectronDensity);
+
+  Mesh *mesh = molecule.addMesh();
+  Array<Vector3f> vertices;
+  vertices.push_back(Vector3f(0.0f, 0.0f, 0.0f));
+  vertices.push_back(Vector3f(1.0f, 0.0f, 0.0f));
+  vertices.push_back(Vector3f(0.0f, 1.0f, 0.0f));
+  mesh->setVertices(vertices);
+  mesh->setNormals(Array<Vector3f>(3, Vector3f(0.0f, 0.0f, 1.0f)));
+  mesh->setColors(Array<Color3f>(3, Color3f(1.0f, 0.5f, 0.25f)));
+  Array<unsigned int> indices;
+  indices.push_back(0);
+  indices.push_back(1);
+  indices.push_back(2);
+  mesh->setIndices(indices);
+  mesh->setName("surface");
+  mesh->setIsoValue(0.02f);
+  mesh->setCube(0);
+  mesh->setStable(true);
+
+  GaussianSet *basis = new GaussianSet;
+  unsigned int s = basis->addBasis(0, GaussianSet::S);
+  basis->addGto(s, 0.15, 3.4);
+  basis->addGto(s, 0.53, 0.62);
+  unsigned int p = basis->addBasis(1, GaussianSet::P);
+  basis->addGto(p, 1.0, 0.35);
+  basis->setElectronCount(4);
+  basis->setScfType(Avogadro::Core::Rhf);
+  MatrixX orbitals(4, 4);
+  for (int i = 0; i < 16; ++i)
+    orbitals(i % 4, i / 4) = 0.25 * i - 2.0;
+  basis->moMatrix() = orbitals;
+  molecule.setBasisSet(basis);
+}
+
+std::string writeString(const Molecule &molecule)
+{
+  BinaryFormat format;
+  std::string data;
+  EXPECT_TRUE(format.writeString(data, molecule)) << format.error();
+  return data;
+}
+}
+
+TEST(BinaryTest, roundTrip)
+{
+  Molecule original;
+  buildMolecule(original);
+  std::string data(writeString(original));
+
+  // The header, the directory and every block are 64 byte aligned.
+  EXPECT_EQ(data.size() % 64, 0u);
+
+  BinaryFormat format;
+  Molecule molecule;
+  ASSERT_TRUE(format.readString(data, molecule)) << format.error();
+
+  EXPECT_EQ(molecule.atomicNumbers(), original.atomicNumbers());
+  EXPECT_EQ(molecule.atomPositions3d(), original.atomPositions3d());
+  EXPECT_EQ(molecule.atomPositions2d(), original.atomPositions2d());
+  EXPECT_EQ(molecule.formalCharges(), original.formalCharges());
+  EXPECT_EQ(molecule.bondPairs(), original.bondPairs());
+  EXPECT_EQ(molecule.bondOrders(), original.bondOrders());
+  EXPECT_EQ(molecule.bond(0, 1).order(), 2);
+  EXPECT_EQ(molecule.bond(2, 0).order(), 1);
+  EXPECT_EQ(molecule.data("name").toString(), "formyl");
+
+  ASSERT_TRUE(molecule.unitCell() != NULL);
+  EXPECT_EQ(molecule.unitCell()->cellMatrix(),
+            original.unitCell()->cellMatrix());
+
+  ASSERT_EQ(molecule.cubeCount(), 1u);
+  const Cube *cube = molecule.cube(0);
+  EXPECT_EQ(*cube->data(), *original.cube(0)->data());
+  EXPECT_EQ(cube->dimensions(), original.cube(0)->dimensions());
+  EXPECT_EQ(cube->min(), original.cube(0)->min());
+  EXPECT_EQ(cube->spacing(), original.cube(0)->spacing());
+  EXPECT_EQ(cube->minValue(), original.cube(0)->minValue());
+  EXPECT_EQ(cube->maxValue(), original.cube(0)->maxValue());
+  EXPECT_EQ(cube->name(), "density");
+  EXPECT_EQ(cube->cubeType(), Cube::ElectronDensity);
+
+  ASSERT_EQ(molecule.meshCount(), 1u);
+  const Mesh *mesh = molecule.mesh(0);
+  EXPECT_EQ(mesh->vertices(), original.mesh(0)->vertices());
+  EXPECT_EQ(mesh->normals(), original.mesh(0)->normals());
+  EXPECT_EQ(mesh->indices(), original.mesh(0)->indices());
+  ASSERT_EQ(mesh->colors().size(), 3u);
+  EXPECT_EQ(mesh->colors()[2].green(), 0.5f);
+  EXPECT_EQ(mesh->name(), "surface");
+  EXPECT_EQ(mesh->isoValue(), 0.02f);
+  EXPECT_EQ(mesh->cube(), 0u);
+  EXPECT_TRUE(mesh->stable());
+
+  const GaussianSet *basis =
+      dynamic_cast<const GaussianSet *>(molecule.basisSet());
+  ASSERT_TRUE(basis != NULL);
+  const GaussianSet *originalBasis =
+      dynamic_cast<const GaussianSet *>(original.basisSet());
+  EXPECT_EQ(basis->symmetry(), originalBasis->symmetry());
+  EXPECT_EQ(basis->atomIndices(), originalBasis->atomIndices());
+  EXPECT_EQ(basis->gtoIndices(), originalBasis->gtoIndices());
+  EXPECT_EQ(basis->gtoA(), originalBasis->gtoA());
+  EXPECT_EQ(basis->gtoC(), originalBasis->gtoC());
+  EXPECT_EQ(basis->moMatrix(), originalBasis->moMatrix());
+  EXPECT_EQ(basis->electronCount(BasisSet::Alpha), 4u);
+  EXPECT_EQ(basis->scfType(), Avogadro::Core::Rhf);
+  EXPECT_EQ(basis->molecule(), &molecule);
+}
+
+TEST(BinaryTest, coordinateSets)
+{
+  Molecule original;
+  buildMolecule(original);
+  const int frames = 5;
+  for (int frame = 0; frame < frames; ++frame) {
+    Array<Vector3> positions(original.atomPositions3d());
+    for (Index i = 0; i < positions.size(); ++i)
+      positions[i] += Vector3(0.1 * frame, 0.0, -0.2 * frame);
+    original.setCoordinate3d(positions, frame);
+  }
+
+  // Read from a string, the frames are loaded.
+  BinaryFormat format;
+  Molecule molecule;
+  ASSERT_TRUE(format.readString(writeString(original), molecule));
+  EXPECT_TRUE(molecule.trajectorySource() == NULL);
+  EXPECT_EQ(molecule.coordinate3dCount(), frames);
+
+  // Read from a file, the frames are read as they are needed.
+  const std::string fileName("coordinatesetstmp.avb");
+  ASSERT_TRUE(format.writeFile(fileName, original)) << format.error();
+  Molecule fileMolecule;
+  ASSERT_TRUE(format.readFile(fileName, fileMolecule)) << format.error();
+  ASSERT_TRUE(fileMolecule.trajectorySource() != NULL);
+  EXPECT_EQ(fileMolecule.coordinate3dCount(), frames);
+
+  for (int frame = frames - 1; frame >= 0; --frame) {
+    Array<Vector3> expected;
+    ASSERT_TRUE(original.coordinate3d(frame, expected));
+    ASSERT_TRUE(molecule.setCoordinate3d(frame));
+    EXPECT_EQ(molecule.atomPositions3d(), expected);
+    ASSERT_TRUE(fileMolecule.setCoordinate3d(frame));
+    EXPECT_EQ(fileMolecule.atomPositions3d(), expected);
+  }
+  EXPECT_FALSE(fileMolecule.setCoordinate3d(frames));
+
+  // Frames read on demand are written out again.
+  Molecule copy;
+  ASSERT_TRUE(format.readString(writeString(fileMolecule), copy));
+  Array<Vector3> positions;
+  ASSERT_TRUE(copy.coordinate3d(3, positions));
+  ASSERT_TRUE(original.setCoordinate3d(3));
+  EXPECT_EQ(positions, original.atomPositions3d());
+
+  std::remove(fileName.c_str());
+}
+
+TEST(BinaryTest, errors)
+{
+  Molecule original;
+  buildMolecule(original);
+  std::string data(writeString(original));
+
+  BinaryFormat format;
+  Molecule molecule;
+  EXPECT_FALSE(format.readString("", molecule));
+  EXPECT_FALSE(format.readString("{\"chemical json\": 0}", molecule));
+  EXPECT_NE(format.error(), "");
+
+  // A truncated file.
+  Molecule truncated;
+  EXPECT_FALSE(format.readString(data.substr(0, data.size() - 200),
+                                 truncated));
+
+  // A later version.
+  std::string later(data);
+  later[8] = 2;
+  EXPECT_FALSE(format.readString(later, molecule));
+
+  // An unknown block is skipped, so that blocks can be added to the format.
+  // Here the type of the data block, the directory follows the 64 byte header
+  // with 32 bytes for each block starting with its type.
+  std::string unknown(data);
+  size_t entry = 64;
+  while (unknown[entry] != 9)
+    entry += 32;
+  unknown[entry] = 99;
+  Molecule skipped;
+  EXPECT_TRUE(format.readString(unknown, skipped)) << format.error();
+  EXPECT_EQ(skipped.bondCount(), 2u);
+  EXPECT_FALSE(skipped.hasData("name"));
+}
+
+TEST(BinaryTest, cubeDimensions)
+{
+  Molecule original;
+  buildMolecule(original);
+  std::string data(writeString(original));
+
+  // Dimensions that do not match the values are rejected before they are
+  // allocated. The dimensions follow the minimum and the spacing of the grid
+  // block, whose offset is the last field of its directory entry.
+  size_t entry = 64;
+  while (data[entry] != 20)
+    entry += 32;
+  unsigned long long offset;
+  std::memcpy(&offset, &data[entry + 24], sizeof(offset));
+  unsigned int dimensions[3] = { 100000, 100000, 100000 };
+  std::memcpy(&data[offset + 48], dimensions, sizeof(dimensions));
+
+  BinaryFormat format;
+  Molecule molecule;
+  EXPECT_FALSE(format.readString(data, molecule));
+  EXPECT_EQ(molecule.cubeCount(), 0u);
+}
+
+TEST(BinaryTest, fileFormatManager)
+{
+  FileFormat *format =
+      FileFormatManager::instance().newFormatFromFileExtension("avb");
+  ASSERT_TRUE(format != NULL);
+  EXPECT_EQ(format->identifier(), "Avogadro: AVB");
+  delete format;
+}
+
+TEST(BinaryTest, DISABLED_benchmark)
+{
+  // A trajectory of a thousand frames of 50,000 atoms, 1.2 GB on disk.
+  const Index atomCount = 50000;
+  const int frames = 1000;
+  const std::string fileName("benchmarktmp.avb");
+  {
+    Molecule molecule;
+    for (Index i = 0; i < atomCount; ++i) {
+      molecule.addAtom(static_cast<unsigned char>(1 + i % 8)).setPosition3d(
+            Vector3(1.4 * (i % 100), 1.4 * (i / 100 % 100), 1.4 * (i / 10000)));
+    }
+    for (int frame = 0; frame < frames; ++frame) {
+      Array<Vector3> positions(molecule.atomPositions3d());
+      positions[0].x() = frame;
+      molecule.setCoordinate3d(positions, frame);
+    }
+    BinaryFormat format;
+    std::clock_t start = std::clock();
+    ASSERT_TRUE(format.writeFile(fileName, molecule));
+    std::cout << "Write: "
+              << static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC
+              << " s" << std::endl;
+  }
+
+  BinaryFormat format;
+  Molecule molecule;
+  std::clock_t start = std::clock();
+  ASSERT_TRUE(format.readFile(fileName, molecule));
+  std::cout << "Open: "
+            << static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC * 1000
+            << " ms" << std::endl;
+  EXPECT_EQ(molecule.coordinate3dCount(), frames);
+
+  start = std::clock();
+  for (int frame = 0; frame < frames; frame += 10) {
+    ASSERT_TRUE(molecule.setCoordinate3d(frame));
+    EXPECT_EQ(molecule.atomPositions3d()[0].x(), frame);
+  }
+  std::cout << "Frame: "
+            << static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC
+               * 1000 / (frames / 10) << " ms" << std::endl;
+
+  std::remove(fileName.c_str());
+}
@@ -21,9 +21,24 @@
 #include <avogadro/core/matrix.h>
 #include <avogadro/core/molecule.h>
 #include <avogadro/core/unitcell.h>
+#include <avogadro/core/vector.h>
 
 #include <avogadro/io/cjsonformat.h>
 
+#include <jsoncpp.cpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifdef __GLIBC__
+# include <malloc.h>
+#endif
+
+using Avogadro::Index;
 using Avogadro::PI_F;
 using Avogadro::Real;
 using Avogadro::Core::Atom;
@@ -32,7 +47,9 @@ using Avogadro::Core::Molecule;
 using Avogadro::Core::UnitCell;
 using Avogadro::Core::Variant;
 using Avogadro::Io::CjsonFormat;
+using Avogadro::Io::FileFormat;
 using Avogadro::MatrixX;
+using Avogadro::Vector3;
 
 TEST(CjsonTest, readFile)
 {
@@ -178,3 +195,308 @@ TEST(CjsonTest, saveFile)
   EXPECT_EQ(bond.atom2().index(), static_cast<size_t>(1));
   EXPECT_EQ(bond.order(), static_cast<unsigned char>(1));
 }
+
+TEST(CjsonTest, streaming)
+{
+  // Write out molecules one record at a time, consecutive molecules have a
+  // different number of atoms.
+  CjsonFormat format;
+  ASSERT_TRUE(format.open("streamingtmp.cjson",
+                          FileFormat::Write | FileFormat::MultiMolecule));
+  for (int i = 0; i < 100; ++i) {
+    Molecule molecule;
+    std::ostringstream name;
+    name << "Molecule " << i;
+    molecule.setData("name", name.str());
+    for (int j = 0; j <= i % 3; ++j)
+      molecule.addAtom(6).setPosition3d(Vector3(1.5 * j, 0.0, 0.0));
+    EXPECT_TRUE(format.writeMolecule(molecule));
+  }
+  format.close();
+
+  // Read the molecules back one at a time.
+  ASSERT_TRUE(format.open("streamingtmp.cjson",
+                          FileFormat::Read | FileFormat::MultiMolecule));
+  int count = 0;
+  Molecule molecule;
+  while (format.readMolecule(molecule)) {
+    EXPECT_EQ(molecule.atomCount(), static_cast<size_t>(count % 3 + 1));
+    molecule = Molecule();
+    ++count;
+  }
+  EXPECT_EQ(format.error(), "");
+  EXPECT_EQ(count, 100);
+  EXPECT_TRUE(format.atEnd());
+
+  // Seek without an index, backwards and forwards.
+  EXPECT_TRUE(format.seekRecord(42));
+  EXPECT_TRUE(format.readMolecule(molecule));
+  EXPECT_EQ(molecule.data("name").toString(), "Molecule 42");
+  EXPECT_EQ(format.currentRecord(), static_cast<size_t>(43));
+  EXPECT_FALSE(format.seekRecord(100));
+
+  // Seek with an index.
+  EXPECT_TRUE(format.seekRecord(10));
+  EXPECT_TRUE(format.indexRecords());
+  EXPECT_EQ(format.recordCount(), static_cast<size_t>(100));
+  EXPECT_EQ(format.currentRecord(), static_cast<size_t>(10));
+  molecule = Molecule();
+  EXPECT_TRUE(format.readMolecule(molecule));
+  EXPECT_EQ(molecule.data("name").toString(), "Molecule 10");
+  EXPECT_TRUE(format.seekRecord(99));
+  molecule = Molecule();
+  EXPECT_TRUE(format.readMolecule(molecule));
+  EXPECT_EQ(molecule.data("name").toString(), "Molecule 99");
+  EXPECT_EQ(molecule.atomCount(), static_cast<size_t>(1));
+  EXPECT_FALSE(format.readMolecule(molecule));
+  EXPECT_FALSE(format.seekRecord(100));
+  EXPECT_EQ(format.error(), "");
+}
+
+TEST(CjsonTest, readString)
+{
+  // Members in an unusual order, with unknown members that are skipped.
+  std::string cjsonStr(
+        "{ \"bonds\": { \"order\": [ 2, 1 ],\n"
+        "              \"connections\": { \"index\": [ 1, 0, 1, 2 ] } },\n"
+        "  \"atoms\": { \"coords\": { \"3d\": [ 0.0, 0.0, 0.0, 1.2, 0.0, 0.0,\n"
+        "                                    1.8, 0.9, -0.1 ],\n"
+        "                           \"2d\": [ 0, 0, 1, 0, 2, 1 ] },\n"
+        "             \"elements\": { \"number\": [ 8, 6, 1 ] },\n"
+        "             \"extra\": [ { \"nested\": [ [], {} ] }, \"text\" ] },\n"
+        "  \"name\": \"Formaldehyde fragment\",\n"
+        "  \"properties\": { \"name\": \"not the name\" },\n"
+        "  \"chemical json\": 0 }");
+  CjsonFormat cjson;
+  Molecule molecule;
+  EXPECT_TRUE(cjson.readString(cjsonStr, molecule));
+  EXPECT_EQ(cjson.error(), "");
+  EXPECT_EQ(molecule.data("name").toString(), "Formaldehyde fragment");
+  ASSERT_EQ(molecule.atomCount(), static_cast<size_t>(3));
+  EXPECT_EQ(molecule.atom(0).atomicNumber(), 8);
+  EXPECT_EQ(molecule.atom(2).atomicNumber(), 1);
+  EXPECT_EQ(molecule.atom(2).position3d(), Vector3(1.8, 0.9, -0.1));
+  EXPECT_EQ(molecule.atomPositions2d().size(), static_cast<size_t>(3));
+  ASSERT_EQ(molecule.bondCount(), static_cast<size_t>(2));
+  EXPECT_EQ(molecule.bond(0).atom1().index(), static_cast<size_t>(0));
+  EXPECT_EQ(molecule.bond(0).atom2().index(), static_cast<size_t>(1));
+  EXPECT_EQ(molecule.bond(0).order(), 2);
+  EXPECT_EQ(molecule.bond(1).order(), 1);
+  EXPECT_EQ(molecule.bonds(1).size(), static_cast<size_t>(2));
+
+  // Writing and reading back, in both pretty and compact form.
+  for (int pretty = 0; pretty < 2; ++pretty) {
+    cjson.setPrettyPrint(pretty != 0);
+    std::string output;
+    ASSERT_TRUE(cjson.writeString(output, molecule));
+    EXPECT_EQ(output.find("\n  ") != std::string::npos, pretty != 0);
+    Molecule other;
+    ASSERT_TRUE(cjson.readString(output, other)) << cjson.error();
+    EXPECT_EQ(other.data("name").toString(), "Formaldehyde fragment");
+    ASSERT_EQ(other.atomCount(), molecule.atomCount());
+    for (size_t i = 0; i < other.atomCount(); ++i) {
+      EXPECT_EQ(other.atomicNumber(i), molecule.atomicNumber(i));
+      EXPECT_EQ(other.atomPosition3d(i), molecule.atomPosition3d(i));
+    }
+    ASSERT_EQ(other.bondCount(), molecule.bondCount());
+    EXPECT_EQ(other.bondPair(1), molecule.bondPair(1));
+    EXPECT_EQ(other.bondOrder(0), molecule.bondOrder(0));
+  }
+}
+
+TEST(CjsonTest, readErrors)
+{
+  const char *invalid[] = {
+    // Not chemical json.
+    "{ \"atoms\": { \"elements\": { \"number\": [ 6 ] } } }",
+    // Not an object, or not valid JSON.
+    "[ 1, 2 ]",
+    "{ \"chemical json\": 0, \"atoms\": ",
+    // No atoms.
+    "{ \"chemical json\": 0 }",
+    // Coordinates do not match the atoms.
+    "{ \"chemical json\": 0, \"atoms\": { \"elements\": { \"number\": [ 6 ] },"
+    " \"coords\": { \"3d\": [ 0, 0 ] } } }",
+    "{ \"chemical json\": 0, \"atoms\": { \"elements\": { \"number\": [ 6 ] },"
+    " \"coords\": { \"3d\": [ 0, 0, 0, 1, 1, 1 ] } } }",
+    "{ \"chemical json\": 0, \"atoms\": { \"elements\": { \"number\": [ 6 ] },"
+    " \"coords\": { \"3d\": [ 0, \"0\", 0 ] } } }",
+    // Fractional coordinates without a unit cell.
+    "{ \"chemical json\": 0, \"atoms\": { \"elements\": { \"number\": [ 6 ] },"
+    " \"coords\": { \"3d fractional\": [ 0, 0, 0 ] } } }",
+    // Incomplete unit cell.
+    "{ \"chemical json\": 0, \"unit cell\": { \"a\": 1, \"b\": 1, \"c\": 1 },"
+    " \"atoms\": { \"elements\": { \"number\": [ 6 ] } } }",
+    // Bonds to atoms that do not exist, and missing bond orders.
+    "{ \"chemical json\": 0, \"atoms\": { \"elements\": { \"number\": [ 6 ] } },"
+    " \"bonds\": { \"connections\": { \"index\": [ 0, 1 ] } } }",
+    "{ \"chemical json\": 0, \"atoms\": { \"elements\": { \"number\": [ 6, 6 ]"
+    " } }, \"bonds\": { \"connections\": { \"index\": [ 0, 1 ] },"
+    " \"order\": [] } }",
+    // Numbers that do not fit an atomic number, atom index or bond order.
+    "{ \"chemical json\": 0, \"atoms\": { \"elements\": { \"number\": [ 300 ]"
+    " } } }",
+    "{ \"chemical json\": 0, \"atoms\": { \"elements\": { \"number\": [ -1 ]"
+    " } } }",
+    "{ \"chemical json\": 0, \"atoms\": { \"elements\": { \"number\": [ 6.5 ]"
+    " } } }",
+    "{ \"chemical json\": 0, \"atoms\": { \"elements\": { \"number\": [ 6, 6 ]"
+    " } }, \"bonds\": { \"connections\": { \"index\": [ 0, 1e300 ] } } }",
+    "{ \"chemical json\": 0, \"atoms\": { \"elements\": { \"number\": [ 6, 6 ]"
+    " } }, \"bonds\": { \"connections\": { \"index\": [ 0, 1 ] },"
+    " \"order\": [ -2 ] } }"
+  };
+  for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i) {
+    CjsonFormat cjson;
+    Molecule molecule;
+    EXPECT_FALSE(cjson.readString(invalid[i], molecule)) << invalid[i];
+    EXPECT_NE(cjson.error(), "") << invalid[i];
+  }
+}
+
+namespace {
+// The peak resident set size of the process in kB, or -1 if it is not known.
+// The peak is reset first if reset is true, so that each stage of the
+// benchmark can be measured on its own (Linux only).
+long peakMemory(bool reset = false)
+{
+  if (reset) {
+#ifdef __GLIBC__
+    // Return the memory freed by earlier stages to the system.
+    malloc_trim(0);
+#endif
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+  }
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 6, "VmHWM:") == 0)
+      return std::atol(line.c_str() + 6);
+  }
+  return -1;
+}
+
+void report(const char *stage, std::clock_t start, long memoryBefore,
+            size_t bytes)
+{
+  double seconds = static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+  std::cout << stage << ": " << seconds << " s, "
+            << bytes / seconds / (1 << 20) << " MB/s, peak "
+            << (peakMemory() - memoryBefore) / 1024 << " MB above the start"
+            << std::endl;
+}
+}
+
+TEST(CjsonTest, DISABLED_benchmark)
+{
+  // A million atoms on a grid, with a bond along each row.
+  const Index atomCount = 1000000;
+  std::string fileName("benchmarktmp.cjson");
+  {
+    Molecule molecule;
+    molecule.atomPositions3d().reserve(atomCount);
+    for (Index i = 0; i < atomCount; ++i) {
+      molecule.addAtom(static_cast<unsigned char>(1 + i % 8)).setPosition3d(
+            Vector3(1.4 * (i % 100) + 0.001 * (std::rand() % 100),
+                    1.4 * (i / 100 % 100), 1.4 * (i / 10000)));
+      if (i % 100 != 0)
+        molecule.addBond(i - 1, i);
+    }
+
+    CjsonFormat cjson;
+    long memory = peakMemory(true);
+    std::clock_t start = std::clock();
+    ASSERT_TRUE(cjson.writeFile(fileName, molecule));
+    std::ifstream file(fileName.c_str(), std::ios_base::binary
+                       | std::ios_base::ate);
+    size_t bytes = static_cast<size_t>(file.tellg());
+    report("Stream write      ", start, memory, bytes);
+
+    // The document tree the format used to build before writing.
+    memory = peakMemory(true);
+    start = std::clock();
+    {
+      Json::Value root;
+      root["chemical json"] = 0;
+      Json::Value elements(Json::arrayValue);
+      Json::Value coords(Json::arrayValue);
+      for (Index i = 0; i < atomCount; ++i) {
+        elements.append(molecule.atomicNumber(i));
+        coords.append(molecule.atomPosition3d(i).x());
+        coords.append(molecule.atomPosition3d(i).y());
+        coords.append(molecule.atomPosition3d(i).z());
+      }
+      root["atoms"]["elements"]["number"] = elements;
+      root["atoms"]["coords"]["3d"] = coords;
+      Json::Value connections(Json::arrayValue);
+      Json::Value order(Json::arrayValue);
+      for (Index i = 0; i < molecule.bondCount(); ++i) {
+        connections.append(static_cast<Json::UInt>(molecule.bondPair(i).first));
+        connections.append(
+              static_cast<Json::UInt>(molecule.bondPair(i).second));
+        order.append(molecule.bondOrder(i));
+      }
+      root["bonds"]["connections"]["index"] = connections;
+      root["bonds"]["order"] = order;
+      std::ofstream out("benchmarkdomtmp.cjson");
+      Json::StyledStreamWriter writer("  ");
+      writer.write(out, root);
+    }
+    report("Document write    ", start, memory, bytes);
+  }
+
+  std::ifstream file(fileName.c_str(), std::ios_base::binary);
+  std::string text((std::istreambuf_iterator<char>(file)),
+                   std::istreambuf_iterator<char>());
+  size_t bytes = text.size();
+  text.clear();
+  std::string().swap(text);
+
+  long memory = peakMemory(true);
+  std::clock_t start = std::clock();
+  {
+    CjsonFormat cjson;
+    Molecule molecule;
+    ASSERT_TRUE(cjson.readFile(fileName, molecule)) << cjson.error();
+    EXPECT_EQ(molecule.atomCount(), atomCount);
+    EXPECT_EQ(molecule.bondCount(), atomCount / 100 * 99);
+    report("Stream read       ", start, memory, bytes);
+  }
+
+  // Reading the whole file into a tree, and then the molecule, as before.
+  memory = peakMemory(true);
+  start = std::clock();
+  {
+    std::ifstream in(fileName.c_str(), std::ios_base::binary);
+    std::string json((std::istreambuf_iterator<char>(in)),
+                     std::istreambuf_iterator<char>());
+    Json::Value root;
+    Json::Reader reader;
+    ASSERT_TRUE(reader.parse(json, root));
+    Molecule molecule;
+    Json::Value value = root["atoms"]["elements"]["number"];
+    for (Json::ArrayIndex i = 0; i < value.size(); ++i)
+      molecule.addAtom(static_cast<unsigned char>(value.get(i, 0).asInt()));
+    value = root["atoms"]["coords"]["3d"];
+    for (Index i = 0; i < molecule.atomCount(); ++i) {
+      molecule.atom(i).setPosition3d(
+            Vector3(value.get(static_cast<Json::ArrayIndex>(3 * i), 0)
+                    .asDouble(),
+                    value.get(static_cast<Json::ArrayIndex>(3 * i + 1), 0)
+                    .asDouble(),
+                    value.get(static_cast<Json::ArrayIndex>(3 * i + 2), 0)
+                    .asDouble()));
+    }
+    value = root["bonds"]["connections"]["index"];
+    for (Json::ArrayIndex i = 0; i + 1 < value.size(); i += 2) {
+      molecule.addBond(static_cast<Index>(value.get(i, 0).asInt()),
+                       static_cast<Index>(value.get(i + 1, 0).asInt()));
+    }
+    EXPECT_EQ(molecule.atomCount(), atomCount);
+    report("Document read     ", start, memory, bytes);
+  }
+
+  std::remove(fileName.c_str());
+  std::remove("benchmarkdomtmp.cjson");
+}
@@ -18,20 +18,26 @@
 
 #include <gtest/gtest.h>
 
+#include <avogadro/core/cube.h>
 #include <avogadro/core/matrix.h>
 #include <avogadro/core/molecule.h>
 #include <avogadro/core/vector.h>
 
 #include <avogadro/io/cmlformat.h>
 
+#include <cstdio>
+
 using Avogadro::Core::Molecule;
 using Avogadro::Core::Atom;
+using Avogadro::Core::Array;
 using Avogadro::Core::Bond;
+using Avogadro::Core::Cube;
 using Avogadro::Core::Variant;
 using Avogadro::Io::CmlFormat;
 using Avogadro::MatrixX;
 using Avogadro::Real;
 using Avogadro::Vector3;
+using Avogadro::Vector3i;
 
 TEST(CmlTest, readFile)
 {
@@ -181,6 +187,68 @@ TEST(CmlTest, hdf5Matrix)
   EXPECT_EQ(readMolecule.data("name").toString(), std::string("ethanol"));
 }
 
+TEST(CmlTest, hdf5CoordinateSetsAndCubes)
+{
+  Molecule molecule;
+  for (int i = 0; i < 5; ++i)
+    molecule.addAtom(6).setPosition3d(Vector3(i, 0.5 * i, -1.0));
+  for (int frame = 0; frame < 4; ++frame) {
+    Array<Vector3> positions;
+    for (int i = 0; i < 5; ++i)
+      positions.push_back(Vector3(i + 0.1 * frame, frame, 0.25 * i));
+    molecule.setCoordinate3d(positions, frame);
+  }
+  Cube *cube = molecule.addCube();
+  cube->setLimits(Vector3(-1.0, -2.0, -3.0), Vector3i(4, 3, 40),
+                  Vector3(0.1, 0.2, 0.3));
+  for (unsigned int i = 0; i < 4 * 3 * 40; ++i)
+    cube->setValue(i, i / 7.0);
+  cube->setName("density");
+  cube->setCubeType(Cube::ElectronDensity);
+
+  CmlFormat cml;
+  remove("trajectory.cml.h5");
+  ASSERT_TRUE(cml.writeFile("trajectory.cml", molecule));
+
+  // The frames are read from the HDF5 file as they are used.
+  Molecule readMolecule;
+  ASSERT_TRUE(cml.readFile("trajectory.cml", readMolecule));
+  ASSERT_EQ(readMolecule.atomCount(), static_cast<size_t>(5));
+  EXPECT_EQ(readMolecule.coordinate3dCount(), 4);
+  EXPECT_TRUE(readMolecule.trajectorySource() != NULL);
+  for (int frame = 3; frame >= 0; --frame) {
+    Array<Vector3> expected;
+    Array<Vector3> actual;
+    EXPECT_TRUE(molecule.coordinate3d(frame, expected));
+    EXPECT_TRUE(readMolecule.coordinate3d(frame, actual));
+    EXPECT_TRUE(expected == actual) << "Frame " << frame << " differs.";
+  }
+
+  ASSERT_EQ(readMolecule.cubeCount(), static_cast<size_t>(1));
+  const Cube *readCube = readMolecule.cube(0);
+  EXPECT_EQ(readCube->name(), std::string("density"));
+  EXPECT_EQ(readCube->cubeType(), Cube::ElectronDensity);
+  EXPECT_TRUE(readCube->dimensions() == cube->dimensions());
+  EXPECT_TRUE(readCube->min().isApprox(cube->min()));
+  EXPECT_TRUE(readCube->spacing().isApprox(cube->spacing()));
+  EXPECT_TRUE(*readCube->data() == *cube->data());
+  EXPECT_EQ(readCube->maxValue(), cube->maxValue());
+
+  // Saving again over the file the frames are read from keeps them.
+  ASSERT_TRUE(cml.writeFile("trajectory.cml", readMolecule));
+  Molecule rereadMolecule;
+  ASSERT_TRUE(cml.readFile("trajectory.cml", rereadMolecule));
+  EXPECT_EQ(rereadMolecule.coordinate3dCount(), 4);
+  Array<Vector3> expected;
+  Array<Vector3> actual;
+  EXPECT_TRUE(molecule.coordinate3d(2, expected));
+  EXPECT_TRUE(rereadMolecule.coordinate3d(2, actual));
+  EXPECT_TRUE(expected == actual);
+
+  remove("trajectory.cml");
+  remove("trajectory.cml.h5");
+}
+
 TEST(CmlTest, writeString)
 {
   CmlFormat cml;
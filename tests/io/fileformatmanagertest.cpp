@@ -224,3 +224,40 @@ TEST(FileFormatManagerTest, unregister)
   format = manager.newFormatFromIdentifier("testingFormat");
   ASSERT_TRUE(format == NULL);
 }
+
+TEST(FileFormatManagerTest, openFile)
+{
+  FileFormatManager &manager = FileFormatManager::instance();
+  FileFormat *format =
+      manager.openFile("opentmp.sdf",
+                       FileFormat::Write | FileFormat::MultiMolecule);
+  ASSERT_TRUE(format != NULL);
+  for (int i = 0; i < 3; ++i) {
+    Molecule molecule;
+    molecule.addAtom(static_cast<unsigned char>(i + 1));
+    EXPECT_TRUE(format->writeMolecule(molecule));
+  }
+  delete format;
+
+  format = manager.openFile("opentmp.sdf",
+                            FileFormat::Read | FileFormat::MultiMolecule);
+  ASSERT_TRUE(format != NULL);
+  EXPECT_EQ(format->identifier(), "Avogadro: MDL");
+  int count = 0;
+  Molecule molecule;
+  while (format->readMolecule(molecule)) {
+    ASSERT_EQ(molecule.atomCount(), static_cast<size_t>(1));
+    EXPECT_EQ(molecule.atom(0).atomicNumber(), count + 1);
+    molecule = Molecule();
+    ++count;
+  }
+  EXPECT_EQ(count, 3);
+  EXPECT_EQ(format->error(), "");
+  delete format;
+
+  // Formats that cannot stream, and missing files, give no format.
+  EXPECT_TRUE(manager.openFile("opentmp.cml",
+                               FileFormat::Read | FileFormat::MultiMolecule)
+              == NULL);
+  EXPECT_TRUE(manager.openFile("missing.sdf", FileFormat::Read) == NULL);
+}
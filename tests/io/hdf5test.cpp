@@ -18,6 +18,7 @@
 
 #include <gtest/gtest.h>
 
+#include <avogadro/core/array.h>
 #include <avogadro/io/hdf5dataformat.h>
 
 #include <cstdio>
@@ -277,3 +278,89 @@ TEST(Hdf5Test, datasetInteraction)
 
   remove(tmpFileName.c_str());
 }
+
+TEST(Hdf5Test, chunkedHyperslabs)
+{
+  std::string tmpFileName("Hdf5Test_chunkedHyperslabs.hdf");
+
+  Hdf5DataFormat hdf5;
+  ASSERT_TRUE(hdf5.openFile(tmpFileName, Hdf5DataFormat::ReadWriteTruncate))
+      << "Opening test file '" << tmpFileName << "' failed.";
+  hdf5.setCompressionLevel(4);
+  EXPECT_EQ(hdf5.compressionLevel(), 4);
+
+  // A 6x5x4 grid in chunks of 4x4x4, the chunks at the edges are partial.
+  std::vector<double> grid(6 * 5 * 4);
+  for (size_t i = 0; i < grid.size(); ++i)
+    grid[i] = i * 0.5;
+  size_t dims[3] = {6, 5, 4};
+  size_t chunkDims[3] = {4, 4, 8};
+  EXPECT_TRUE(hdf5.writeDataset("/Grid", grid, 3, dims, chunkDims))
+      << "Writing a chunked dataset failed.";
+
+  std::vector<double> gridRead;
+  hdf5.readDataset("/Grid", gridRead);
+  EXPECT_EQ(grid, gridRead) << "Chunked dataset read/write mismatch.";
+
+  // Read a region straddling the chunks.
+  std::vector<size_t> offset(3);
+  offset[0] = 3;
+  offset[1] = 2;
+  offset[2] = 1;
+  std::vector<size_t> count(3);
+  count[0] = 2;
+  count[1] = 3;
+  count[2] = 2;
+  Avogadro::Core::Array<double> region;
+  EXPECT_TRUE(hdf5.readHyperslab("/Grid", offset, count, region))
+      << "Reading a hyperslab failed.";
+  ASSERT_EQ(region.size(), static_cast<size_t>(12));
+  size_t index = 0;
+  for (size_t i = 0; i < count[0]; ++i) {
+    for (size_t j = 0; j < count[1]; ++j) {
+      for (size_t k = 0; k < count[2]; ++k, ++index) {
+        size_t gridIndex = ((offset[0] + i) * 5 + offset[1] + j) * 4
+            + offset[2] + k;
+        EXPECT_EQ(region[index], grid[gridIndex])
+            << "Hyperslab mismatch at " << i << ", " << j << ", " << k;
+      }
+    }
+  }
+
+  // Blocks outside the dataset, or of the wrong rank, are rejected.
+  count[0] = 4;
+  EXPECT_FALSE(hdf5.readHyperslab("/Grid", offset, count, region));
+  count.pop_back();
+  EXPECT_FALSE(hdf5.readHyperslab("/Grid", offset, count, region));
+
+  // Frames written one at a time into a dataset created up front.
+  size_t frameDims[3] = {10, 7, 3};
+  size_t frameChunks[3] = {1, 7, 3};
+  EXPECT_TRUE(hdf5.createDataset("/Group1/Frames", 3, frameDims, frameChunks));
+  std::vector<size_t> frameOffset(3, 0);
+  std::vector<size_t> frameCount(frameDims, frameDims + 3);
+  frameCount[0] = 1;
+  std::vector<double> frame(7 * 3);
+  for (size_t f = 0; f < frameDims[0]; ++f) {
+    for (size_t i = 0; i < frame.size(); ++i)
+      frame[i] = f * 100.0 + i;
+    frameOffset[0] = f;
+    EXPECT_TRUE(hdf5.writeHyperslab("/Group1/Frames", frameOffset, frameCount,
+                                    &frame[0]))
+        << "Writing frame " << f << " failed.";
+  }
+
+  std::vector<int> dim = hdf5.datasetDimensions("/Group1/Frames");
+  ASSERT_EQ(dim.size(), static_cast<size_t>(3));
+  EXPECT_EQ(dim[0], 10);
+  frameOffset[0] = 6;
+  EXPECT_TRUE(hdf5.readHyperslab("/Group1/Frames", frameOffset, frameCount,
+                                 &frame[0]));
+  for (size_t i = 0; i < frame.size(); ++i)
+    EXPECT_EQ(frame[i], 600.0 + i) << "Frame mismatch at index " << i << ".";
+
+  ASSERT_TRUE(hdf5.closeFile())
+      << "Closing test file '" << tmpFileName << "' failed.";
+
+  remove(tmpFileName.c_str());
+}
@@ -0,0 +1,204 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2014 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/io/jsonreader.h>
+#include <avogadro/io/jsonwriter.h>
+
+#include <sstream>
+
+using Avogadro::Io::JsonHandler;
+using Avogadro::Io::JsonReader;
+using Avogadro::Io::JsonWriter;
+
+namespace {
+// Writes the events back out, so that a document can be compared after it has
+// been parsed.
+class EchoHandler : public JsonHandler
+{
+public:
+  explicit EchoHandler(JsonWriter &writer) : m_writer(writer) {}
+
+  bool startObject() { m_writer.startObject(); return true; }
+  bool endObject() { m_writer.endObject(); return true; }
+  bool key(const std::string &name) { m_writer.key(name); return true; }
+  bool startArray() { m_writer.startArray(); return true; }
+  bool endArray() { m_writer.endArray(); return true; }
+  bool numberValue(double value) { m_writer.numberValue(value); return true; }
+  bool stringValue(const std::string &value)
+  {
+    m_writer.stringValue(value);
+    return true;
+  }
+  bool boolValue(bool value) { m_writer.boolValue(value); return true; }
+  bool nullValue() { m_writer.nullValue(); return true; }
+
+private:
+  JsonWriter &m_writer;
+};
+
+std::string compact(const std::string &json, std::string *error = NULL)
+{
+  std::istringstream in(json);
+  std::ostringstream out;
+  JsonWriter writer(out, false);
+  EchoHandler handler(writer);
+  JsonReader reader(in);
+  if (!reader.parse(handler)) {
+    if (error)
+      *error = reader.error();
+    return std::string();
+  }
+  writer.flush();
+  return out.str();
+}
+}
+
+TEST(JsonTest, read)
+{
+  EXPECT_EQ(compact("{ \"a\" : [ 1, -2, 3.5, 1e3, -0.25E-2 ],\n"
+                    "  \"b\" : { \"c\" : true, \"d\" : false, \"e\" : null },\n"
+                    "  \"f\" : [], \"g\" : {}, \"h\" : [ [ 1 ], [] ] }"),
+            "{\"a\":[1,-2,3.5,1000,-0.0025],"
+            "\"b\":{\"c\":true,\"d\":false,\"e\":null},"
+            "\"f\":[],\"g\":{},\"h\":[[1],[]]}");
+
+  // Escapes, including a surrogate pair.
+  EXPECT_EQ(compact("[\"q\\\"b\\\\s\\/n\\nt\\t\", \"\\u00e9\\ud83d\\ude00\"]"),
+            "[\"q\\\"b\\\\s/n\\nt\\t\",\"\xc3\xa9\xf0\x9f\x98\x80\"]");
+
+  // Large integers and numbers needing every digit survive.
+  EXPECT_EQ(compact("[123456789012345678, 0.1, 1.2345678901234567]"),
+            "[1.2345678901234568e+17,0.1,1.2345678901234567]");
+}
+
+TEST(JsonTest, readStream)
+{
+  // Consecutive values are read one at a time.
+  std::istringstream in("{\"a\": 1}\n{\"b\": 2} [3]");
+  JsonHandler handler;
+  JsonReader reader(in);
+  EXPECT_TRUE(reader.parse(handler));
+  EXPECT_TRUE(reader.parse(handler));
+  EXPECT_TRUE(reader.parse(handler));
+  EXPECT_FALSE(reader.parse(handler));
+}
+
+TEST(JsonTest, errors)
+{
+  const char *invalid[] = {
+    "", "{", "{\"a\" 1}", "{\"a\": 1,}", "[1 2]", "{a: 1}", "[tru]",
+    "[\"unterminated]", "[\"\\x\"]", "[\"\\u12g4\"]", "[1.2.3]", "[-]",
+    "[\"tab\there\"]", "}"
+  };
+  for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i) {
+    std::string error;
+    EXPECT_EQ(compact(invalid[i], &error), "") << invalid[i];
+    EXPECT_NE(error, "") << invalid[i];
+  }
+
+  std::string error;
+  compact("{\n\"a\": [\n1,\n2 3]}", &error);
+  EXPECT_NE(error.find("line 4"), std::string::npos) << error;
+
+  // Deeply nested documents are rejected rather than overflowing the stack.
+  std::string nested(10000, '[');
+  EXPECT_EQ(compact(nested, &error), "");
+}
+
+TEST(JsonTest, write)
+{
+  std::ostringstream out;
+  JsonWriter writer(out);
+  writer.startObject();
+  writer.key("name");
+  writer.stringValue("quote \" and\nnew line");
+  writer.key("numbers");
+  writer.startArray();
+  for (int i = 0; i < 30; ++i)
+    writer.integerValue(i - 10);
+  writer.endArray();
+  writer.key("objects");
+  writer.startArray();
+  writer.startObject();
+  writer.key("x");
+  writer.numberValue(0.5);
+  writer.endObject();
+  writer.startObject();
+  writer.endObject();
+  writer.endArray();
+  writer.key("empty");
+  writer.startArray();
+  writer.endArray();
+  writer.key("null");
+  writer.nullValue();
+  writer.endObject();
+  writer.flush();
+
+  EXPECT_EQ(out.str(),
+            "{\n"
+            "  \"name\": \"quote \\\" and\\nnew line\",\n"
+            "  \"numbers\": [ -10, -9, -8, -7, -6, -5, -4, -3, -2, -1, 0, 1, "
+            "2, 3, 4, 5,\n"
+            "    6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19 ],\n"
+            "  \"objects\": [\n"
+            "    {\n"
+            "      \"x\": 0.5\n"
+            "    },\n"
+            "    {}\n"
+            "  ],\n"
+            "  \"empty\": [],\n"
+            "  \"null\": null\n"
+            "}");
+
+  // The pretty output reads back to the same document.
+  std::string compacted(compact(out.str()));
+  EXPECT_EQ(compacted,
+            "{\"name\":\"quote \\\" and\\nnew line\",\"numbers\":[-10,-9,-8,-7,"
+            "-6,-5,-4,-3,-2,-1,0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,"
+            "19],\"objects\":[{\"x\":0.5},{}],\"empty\":[],\"null\":null}");
+}
+
+TEST(JsonTest, writeNumbers)
+{
+  const double values[] = {
+    0.0, 1.0, -1.0, 0.5, 0.1, -0.751621, 1.184988, 12.5, 100.0, 1e-4,
+    0.00012345, 123456789.125, -987654321.5, 0.1 * 3, 1.0 / 3.0, 1e-12,
+    6.02214e23, 9007199254740993.0, 4294967296.0, -2.5e-8
+  };
+  std::ostringstream out;
+  JsonWriter writer(out, false);
+  writer.startArray();
+  for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i)
+    writer.numberValue(values[i]);
+  writer.endArray();
+  writer.flush();
+  EXPECT_EQ(out.str(),
+            "[0,1,-1,0.5,0.1,-0.751621,1.184988,12.5,100,0.0001,0.00012345,"
+            "123456789.125,-987654321.5,0.30000000000000004,0.3333333333333333,"
+            "1e-12,6.02214e+23,9007199254740992,4294967296,-2.5e-08]");
+
+  // Every value reads back exactly.
+  std::istringstream in(out.str());
+  double value = 0.0;
+  char separator;
+  in >> separator;
+  for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+    in >> value >> separator;
+    EXPECT_EQ(value, values[i]);
+  }
+}
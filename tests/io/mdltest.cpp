@@ -19,15 +19,19 @@
 #include <gtest/gtest.h>
 
 #include <avogadro/core/molecule.h>
+#include <avogadro/core/vector.h>
 
 #include <avogadro/io/mdlformat.h>
 
+#include <sstream>
+
 using Avogadro::Core::Molecule;
 using Avogadro::Core::Atom;
 using Avogadro::Core::Bond;
 using Avogadro::Core::Variant;
 using Avogadro::Io::FileFormat;
 using Avogadro::Io::MdlFormat;
+using Avogadro::Vector3;
 
 TEST(MdlTest, readFile)
 {
@@ -209,3 +213,60 @@ TEST(MdlTest, readSdfData)
   EXPECT_EQ(mol[1].data("PUBCHEM_OPENEYE_CAN_SMILES").toString(),
             "CC(=O)OC(CC(=O)O)C[N+](C)(C)C");
 }
+
+TEST(MdlTest, streaming)
+{
+  // Write out molecules one record at a time, consecutive molecules have a
+  // different number of atoms.
+  MdlFormat format;
+  ASSERT_TRUE(format.open("streamingtmp.sdf",
+                          FileFormat::Write | FileFormat::MultiMolecule));
+  for (int i = 0; i < 100; ++i) {
+    Molecule molecule;
+    std::ostringstream name;
+    name << "Molecule " << i;
+    molecule.setData("name", name.str());
+    for (int j = 0; j <= i % 3; ++j)
+      molecule.addAtom(6).setPosition3d(Vector3(1.5 * j, 0.0, 0.0));
+    EXPECT_TRUE(format.writeMolecule(molecule));
+  }
+  format.close();
+
+  // Read the molecules back one at a time.
+  ASSERT_TRUE(format.open("streamingtmp.sdf",
+                          FileFormat::Read | FileFormat::MultiMolecule));
+  int count = 0;
+  Molecule molecule;
+  while (format.readMolecule(molecule)) {
+    EXPECT_EQ(molecule.atomCount(), static_cast<size_t>(count % 3 + 1));
+    molecule = Molecule();
+    ++count;
+  }
+  EXPECT_EQ(format.error(), "");
+  EXPECT_EQ(count, 100);
+  EXPECT_TRUE(format.atEnd());
+
+  // Seek without an index, backwards and forwards.
+  EXPECT_TRUE(format.seekRecord(42));
+  EXPECT_TRUE(format.readMolecule(molecule));
+  EXPECT_EQ(molecule.data("name").toString(), "Molecule 42");
+  EXPECT_EQ(format.currentRecord(), static_cast<size_t>(43));
+  EXPECT_FALSE(format.seekRecord(100));
+
+  // Seek with an index.
+  EXPECT_TRUE(format.seekRecord(10));
+  EXPECT_TRUE(format.indexRecords());
+  EXPECT_EQ(format.recordCount(), static_cast<size_t>(100));
+  EXPECT_EQ(format.currentRecord(), static_cast<size_t>(10));
+  molecule = Molecule();
+  EXPECT_TRUE(format.readMolecule(molecule));
+  EXPECT_EQ(molecule.data("name").toString(), "Molecule 10");
+  EXPECT_TRUE(format.seekRecord(99));
+  molecule = Molecule();
+  EXPECT_TRUE(format.readMolecule(molecule));
+  EXPECT_EQ(molecule.data("name").toString(), "Molecule 99");
+  EXPECT_EQ(molecule.atomCount(), static_cast<size_t>(1));
+  EXPECT_FALSE(format.readMolecule(molecule));
+  EXPECT_FALSE(format.seekRecord(100));
+  EXPECT_EQ(format.error(), "");
+}
@@ -25,6 +25,7 @@
 #include <avogadro/io/xyzformat.h>
 
 #include <fstream>
+#include <iterator>
 #include <sstream>
 #include <string>
 
@@ -192,3 +193,115 @@ TEST(XyzTest, writeMulti)
     EXPECT_EQ(mol[i].bondCount(), ref[i].bondCount());
   }
 }
+
+TEST(XyzTest, readTrajectory)
+{
+  // Write out a trajectory of a diatomic being stretched, followed by a
+  // different molecule.
+  {
+    std::ofstream out("trajectorytmp.xyz");
+    for (int frame = 0; frame < 50; ++frame) {
+      out << "2\nFrame " << frame << "\n"
+          << "O 0.0 0.0 0.0\n"
+          << "H 0.0 0.0 " << 1.0 + 0.01 * frame << " 0.5\n";
+    }
+    out << "1\nAnother molecule\nC 1.0 2.0 3.0\n";
+  }
+
+  // Read from a file the frames are indexed, and read as they are requested.
+  XyzFormat xyz;
+  xyz.open("trajectorytmp.xyz", FileFormat::Read | FileFormat::MultiMolecule);
+  Molecule molecule;
+  EXPECT_TRUE(xyz.readMolecule(molecule));
+  ASSERT_EQ(xyz.error(), "");
+  EXPECT_EQ(molecule.data("name").toString(), "Frame 0");
+  EXPECT_EQ(molecule.atomCount(), 2);
+  EXPECT_TRUE(molecule.trajectorySource() != NULL);
+  EXPECT_EQ(molecule.coordinate3dCount(), 50);
+  EXPECT_TRUE(molecule.setCoordinate3d(42));
+  EXPECT_DOUBLE_EQ(molecule.atom(1).position3d().z(), 1.42);
+  EXPECT_TRUE(molecule.setCoordinate3d(0));
+  EXPECT_DOUBLE_EQ(molecule.atom(1).position3d().z(), 1.0);
+  EXPECT_FALSE(molecule.setCoordinate3d(50));
+
+  // Copies of the molecule can read the frames too.
+  Molecule copy(molecule);
+  EXPECT_TRUE(copy.setCoordinate3d(49));
+  EXPECT_DOUBLE_EQ(copy.atom(1).position3d().z(), 1.49);
+
+  // The molecule after the trajectory is read next.
+  Molecule next;
+  EXPECT_TRUE(xyz.readMolecule(next));
+  EXPECT_EQ(next.data("name").toString(), "Another molecule");
+  EXPECT_EQ(next.atomCount(), 1);
+  EXPECT_EQ(next.coordinate3dCount(), 0);
+  xyz.close();
+
+  // Read from a string all of the frames are loaded.
+  std::ifstream in("trajectorytmp.xyz");
+  std::string contents((std::istreambuf_iterator<char>(in)),
+                       std::istreambuf_iterator<char>());
+  Molecule loaded;
+  EXPECT_TRUE(xyz.readString(contents, loaded));
+  EXPECT_TRUE(loaded.trajectorySource() == NULL);
+  EXPECT_EQ(loaded.coordinate3dCount(), 50);
+  EXPECT_TRUE(loaded.setCoordinate3d(42));
+  EXPECT_DOUBLE_EQ(loaded.atom(1).position3d().z(), 1.42);
+}
+
+TEST(XyzTest, streaming)
+{
+  // Write out molecules one record at a time, consecutive molecules have a
+  // different number of atoms.
+  XyzFormat format;
+  ASSERT_TRUE(format.open("streamingtmp.xyz",
+                          FileFormat::Write | FileFormat::MultiMolecule));
+  for (int i = 0; i < 100; ++i) {
+    Molecule molecule;
+    std::ostringstream name;
+    name << "Molecule " << i;
+    molecule.setData("name", name.str());
+    for (int j = 0; j <= i % 3; ++j)
+      molecule.addAtom(6).setPosition3d(Vector3(1.5 * j, 0.0, 0.0));
+    EXPECT_TRUE(format.writeMolecule(molecule));
+  }
+  format.close();
+
+  // Read the molecules back one at a time.
+  ASSERT_TRUE(format.open("streamingtmp.xyz",
+                          FileFormat::Read | FileFormat::MultiMolecule));
+  int count = 0;
+  Molecule molecule;
+  while (format.readMolecule(molecule)) {
+    EXPECT_EQ(molecule.atomCount(), static_cast<size_t>(count % 3 + 1));
+    molecule = Molecule();
+    ++count;
+  }
+  EXPECT_EQ(format.error(), "");
+  EXPECT_EQ(count, 100);
+  EXPECT_TRUE(format.atEnd());
+
+  // Seek without an index, backwards and forwards.
+  EXPECT_TRUE(format.seekRecord(42));
+  EXPECT_TRUE(format.readMolecule(molecule));
+  EXPECT_EQ(molecule.data("name").toString(), "Molecule 42");
+  EXPECT_EQ(format.currentRecord(), static_cast<size_t>(43));
+  EXPECT_FALSE(format.seekRecord(100));
+
+  // Seek with an index.
+  EXPECT_TRUE(format.seekRecord(10));
+  EXPECT_TRUE(format.indexRecords());
+  EXPECT_EQ(format.recordCount(), static_cast<size_t>(100));
+  EXPECT_EQ(format.currentRecord(), static_cast<size_t>(10));
+  molecule = Molecule();
+  EXPECT_TRUE(format.readMolecule(molecule));
+  EXPECT_EQ(molecule.data("name").toString(), "Molecule 10");
+  EXPECT_TRUE(format.seekRecord(99));
+  molecule = Molecule();
+  EXPECT_TRUE(format.readMolecule(molecule));
+  EXPECT_EQ(molecule.data("name").toString(), "Molecule 99");
+  EXPECT_EQ(molecule.atomCount(), static_cast<size_t>(1));
+  EXPECT_FALSE(format.readMolecule(molecule));
+  EXPECT_FALSE(format.seekRecord(100));
+  EXPECT_EQ(format.error(), "");
+}
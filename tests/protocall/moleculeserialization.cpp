@@ -15,6 +15,8 @@
  ******************************************************************************/
 
 #include <gtest/gtest.h>
+#include <avogadro/core/cube.h>
+#include <avogadro/core/unitcell.h>
 #include <avogadro/io/fileformatmanager.h>
 #include <google/protobuf/io/zero_copy_stream_impl_lite.h>
 #include <google/protobuf/io/coded_stream.h>
@@ -23,7 +25,13 @@
 #include "moleculedeserializer.h"
 #include "protocalltests.h"
 
+#include <ctime>
+#include <iostream>
+
+using Avogadro::Core::Array;
+using Avogadro::Core::Cube;
 using Avogadro::Core::Molecule;
+using Avogadro::Core::UnitCell;
 using Avogadro::Io::FileFormat;
 using Avogadro::Io::FileFormatManager;
 using Avogadro::Core::MoleculeDeserializer;
@@ -80,25 +88,25 @@ TEST_F(MoleculeSerializationTest, roundTrip)
 
   EXPECT_EQ(this->ethane.atomicNumbers(), after.atomicNumbers());
 
-  std::vector<Avogadro::Vector2> expected2d = this->ethane.atomPositions2d();
-  std::vector<Avogadro::Vector2> actual2d = after.atomPositions2d();
+  Array<Avogadro::Vector2> expected2d = this->ethane.atomPositions2d();
+  Array<Avogadro::Vector2> actual2d = after.atomPositions2d();
 
   EXPECT_EQ(expected2d.size(), actual2d.size());
 
   for (size_t i = 0; i < expected2d.size(); i++)
     EXPECT_TRUE(this->equal(expected2d[i], actual2d[i]));
 
-  std::vector<Avogadro::Vector3> expected3d = this->ethane.atomPositions3d();
-  std::vector<Avogadro::Vector3> actual3d = after.atomPositions3d();
+  Array<Avogadro::Vector3> expected3d = this->ethane.atomPositions3d();
+  Array<Avogadro::Vector3> actual3d = after.atomPositions3d();
 
   EXPECT_EQ(expected3d.size(), actual3d.size());
 
   for (size_t i = 0; i < expected3d.size(); i++)
     EXPECT_TRUE(this->equal(expected3d[i], actual3d[i]));
 
-  const std::vector<std::pair<size_t, size_t> > expectedBondPairs
+  const Array<std::pair<size_t, size_t> > expectedBondPairs
     = this->ethane.bondPairs();
-  const std::vector<std::pair<size_t, size_t> > actualBondPairs
+  const Array<std::pair<size_t, size_t> > actualBondPairs
     = after.bondPairs();
 
   EXPECT_EQ(expectedBondPairs.size(), actualBondPairs.size());
@@ -108,10 +116,102 @@ TEST_F(MoleculeSerializationTest, roundTrip)
     EXPECT_EQ(expectedBondPairs[i].second, actualBondPairs[i].second);
   }
 
-  const std::vector<unsigned char> expectedBondOrder
+  const Array<unsigned char> expectedBondOrder
     = this->ethane.bondOrders();
-  const std::vector<unsigned char> actualBondOrder = after.bondOrders();
+  const Array<unsigned char> actualBondOrder = after.bondOrders();
 
   for (size_t i = 0; i < expectedBondOrder.size(); i++)
     EXPECT_EQ(expectedBondOrder[i], actualBondOrder[i]);
 }
+
+TEST_F(MoleculeSerializationTest, roundTripPayloads)
+{
+  for (int frame = 0; frame < 3; frame++) {
+    Array<Avogadro::Vector3> positions = this->ethane.atomPositions3d();
+    for (size_t i = 0; i < positions.size(); i++)
+      positions[i].x() += 0.5 * frame;
+    this->ethane.setCoordinate3d(positions, frame);
+  }
+  this->ethane.setUnitCell(new UnitCell(Avogadro::Vector3(4.0, 0.0, 0.0),
+                                        Avogadro::Vector3(0.0, 5.0, 0.0),
+                                        Avogadro::Vector3(1.0, 0.0, 6.0)));
+  Cube *cube = this->ethane.addCube();
+  cube->setLimits(Avogadro::Vector3(-1.0, -1.0, -1.0),
+                  Avogadro::Vector3i(3, 4, 5),
+                  Avogadro::Vector3(0.5, 0.5, 0.5));
+  for (unsigned int i = 0; i < cube->data()->size(); i++)
+    cube->setValue(i, 0.01 * i);
+  cube->setName("density");
+  cube->setCubeType(Cube::ElectronDensity);
+
+  MoleculeSerializer serializer(&this->ethane);
+  size_t size = serializer.size();
+  std::vector<uint8> data(size);
+  EXPECT_TRUE(serializer.serialize(&data[0], size));
+
+  Molecule after;
+  MoleculeDeserializer deserializer(&after);
+  EXPECT_TRUE(deserializer.deserialize(&data[0], size));
+
+  EXPECT_EQ(after.coordinate3dCount(), 3);
+  for (int frame = 0; frame < 3; frame++) {
+    EXPECT_TRUE(this->ethane.setCoordinate3d(frame));
+    EXPECT_TRUE(after.setCoordinate3d(frame));
+    EXPECT_EQ(this->ethane.atomPositions3d(), after.atomPositions3d());
+  }
+
+  ASSERT_TRUE(after.unitCell() != NULL);
+  EXPECT_TRUE(this->equal(this->ethane.unitCell()->cellMatrix(),
+                          after.unitCell()->cellMatrix()));
+
+  ASSERT_EQ(after.cubeCount(), 1u);
+  EXPECT_EQ(*after.cube(0)->data(), *cube->data());
+  EXPECT_EQ(after.cube(0)->dimensions(), cube->dimensions());
+  EXPECT_EQ(after.cube(0)->min(), cube->min());
+  EXPECT_EQ(after.cube(0)->spacing(), cube->spacing());
+  EXPECT_EQ(after.cube(0)->name(), "density");
+  EXPECT_EQ(after.cube(0)->cubeType(), Cube::ElectronDensity);
+
+  // A truncated buffer is rejected.
+  Molecule truncated;
+  MoleculeDeserializer truncatedDeserializer(&truncated);
+  EXPECT_FALSE(truncatedDeserializer.deserialize(&data[0], size - 8));
+}
+
+TEST_F(MoleculeSerializationTest, DISABLED_benchmark)
+{
+  // A million atoms with a bond along each row, and ten coordinate sets.
+  const size_t atomCount = 1000000;
+  Molecule molecule;
+  for (size_t i = 0; i < atomCount; i++) {
+    molecule.addAtom(static_cast<unsigned char>(1 + i % 8)).setPosition3d(
+          Avogadro::Vector3(1.4 * (i % 100), 1.4 * (i / 100 % 100),
+                            1.4 * (i / 10000)));
+    if (i % 100 != 0)
+      molecule.addBond(i - 1, i);
+  }
+  for (int frame = 0; frame < 10; frame++)
+    molecule.setCoordinate3d(molecule.atomPositions3d(), frame);
+
+  MoleculeSerializer serializer(&molecule);
+  size_t size = serializer.size();
+  std::vector<uint8> data(size);
+
+  const int repeats = 10;
+  std::clock_t start = std::clock();
+  for (int i = 0; i < repeats; i++)
+    ASSERT_TRUE(serializer.serialize(&data[0], size));
+  double seconds = static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+  std::cout << "Serialize: " << size * repeats / seconds / (1 << 20)
+            << " MB/s" << std::endl;
+
+  start = std::clock();
+  for (int i = 0; i < repeats; i++) {
+    Molecule after;
+    MoleculeDeserializer deserializer(&after);
+    ASSERT_TRUE(deserializer.deserialize(&data[0], size));
+  }
+  seconds = static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+  std::cout << "Deserialize: " << size * repeats / seconds / (1 << 20)
+            << " MB/s" << std::endl;
+}
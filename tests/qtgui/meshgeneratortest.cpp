@@ -0,0 +1,129 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2014 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/qtgui/meshgenerator.h>
+#include <avogadro/core/array.h>
+#include <avogadro/core/cube.h>
+#include <avogadro/core/mesh.h>
+#include <avogadro/core/vector.h>
+
+#include <cmath>
+#include <map>
+#include <utility>
+#include <vector>
+
+using Avogadro::Vector3;
+using Avogadro::Vector3f;
+using Avogadro::Vector3i;
+using Avogadro::Core::Array;
+using Avogadro::Core::Cube;
+using Avogadro::Core::Mesh;
+using Avogadro::QtGui::MeshGenerator;
+
+namespace {
+// A spherical Gaussian, the isosurface at iso is a sphere of radius
+// sqrt(-ln(iso)).
+void setUpCube(Cube &cube, int points)
+{
+  cube.setLimits(Vector3(-2.0, -2.0, -2.0), Vector3(2.0, 2.0, 2.0),
+                 Vector3i(points, points, points));
+  std::vector<double> &data = *cube.data();
+  for (size_t i = 0; i < data.size(); ++i) {
+    Vector3 pos = cube.position(static_cast<unsigned int>(i));
+    data[i] = std::exp(-pos.squaredNorm());
+  }
+  cube.updateMinMax();
+}
+}
+
+TEST(MeshGeneratorTest, sphere)
+{
+  Cube cube;
+  setUpCube(cube, 30);
+  const float iso = 0.3f;
+  const float radius = std::sqrt(-std::log(iso));
+
+  Mesh mesh;
+  MeshGenerator generator(&cube, &mesh, iso);
+  generator.run();
+
+  const Array<Vector3f> &vertices = mesh.vertices();
+  const Array<Vector3f> &normals = mesh.normals();
+  const Array<unsigned int> &indices = mesh.indices();
+  ASSERT_GT(vertices.size(), static_cast<size_t>(0));
+  ASSERT_EQ(vertices.size(), normals.size());
+  ASSERT_EQ(indices.size() % 3, static_cast<size_t>(0));
+
+  for (size_t i = 0; i < vertices.size(); ++i) {
+    EXPECT_NEAR(vertices[i].norm(), radius, 0.01f);
+    // Normals point out of the sphere, away from the larger values.
+    EXPECT_NEAR(normals[i].norm(), 1.0f, 1e-5f);
+    EXPECT_GT(normals[i].dot(vertices[i].normalized()), 0.99f);
+  }
+
+  // The vertices are shared, so the surface is closed: every edge is shared
+  // by exactly two triangles, and each vertex by several triangles.
+  std::map<std::pair<unsigned int, unsigned int>, int> edges;
+  for (size_t t = 0; t < indices.size(); t += 3) {
+    for (int e = 0; e < 3; ++e) {
+      unsigned int a = indices[t + e];
+      unsigned int b = indices[t + (e + 1) % 3];
+      ASSERT_LT(a, vertices.size());
+      ++edges[std::make_pair(std::min(a, b), std::max(a, b))];
+    }
+  }
+  for (std::map<std::pair<unsigned int, unsigned int>, int>::const_iterator
+       it = edges.begin(); it != edges.end(); ++it) {
+    EXPECT_EQ(it->second, 2);
+  }
+  EXPECT_LT(vertices.size() * 3, indices.size());
+
+  // The triangles are wound counter clockwise seen from the outside.
+  double volume = 0.0;
+  for (size_t t = 0; t < indices.size(); t += 3) {
+    volume += vertices[indices[t]].cast<double>().dot(
+          vertices[indices[t + 1]].cast<double>().cross(
+            vertices[indices[t + 2]].cast<double>())) / 6.0;
+  }
+  EXPECT_NEAR(volume, 4.0 / 3.0 * M_PI * radius * radius * radius, 0.05);
+}
+
+TEST(MeshGeneratorTest, reverse)
+{
+  Cube cube;
+  setUpCube(cube, 20);
+
+  Mesh mesh;
+  Mesh reversed;
+  MeshGenerator generator(&cube, &mesh, 0.3f);
+  generator.run();
+  MeshGenerator reverseGenerator(&cube, &reversed, 0.3f, true);
+  reverseGenerator.run();
+
+  ASSERT_EQ(mesh.numVertices(), reversed.numVertices());
+  ASSERT_EQ(mesh.numIndices(), reversed.numIndices());
+  for (unsigned int i = 0; i < mesh.numVertices(); ++i) {
+    EXPECT_EQ(mesh.vertices()[i], reversed.vertices()[i]);
+    EXPECT_EQ(mesh.normals()[i], -reversed.normals()[i]);
+  }
+  for (unsigned int t = 0; t < mesh.numIndices(); t += 3) {
+    EXPECT_EQ(mesh.indices()[t], reversed.indices()[t + 2]);
+    EXPECT_EQ(mesh.indices()[t + 1], reversed.indices()[t + 1]);
+    EXPECT_EQ(mesh.indices()[t + 2], reversed.indices()[t]);
+  }
+}
@@ -0,0 +1,264 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2014 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "qtpluginstests.h"
+
+#include <qtaimwavefunction.h>
+#include <qtaimwavefunctionevaluator.h>
+
+#include <QtCore/QString>
+
+#include <algorithm>
+#include <cmath>
+
+using Avogadro::QtPlugins::QTAIMWavefunction;
+using Avogadro::QtPlugins::QTAIMWavefunctionEvaluator;
+
+namespace {
+
+// Reference values computed with the scalar primitive loop that the vectorized
+// kernel replaced. The Hessian is stored as xx, yy, zz, xy, xz, yz.
+struct ReferencePoint
+{
+  double position[3];
+  double firstMolecularOrbital;
+  double electronDensity;
+  double gradient[3];
+  double hessian[6];
+  double laplacian;
+  double kineticEnergyDensityG;
+  double kineticEnergyDensityK;
+};
+
+const ReferencePoint c4h4Reference[] = {
+  { { 0.0, 0.0, 0.0 },
+    0.0035241205611098265, 0.18327523795826337,
+    { -1.1076041854145549e-09, -2.4525262499519725e-10,
+      3.4026890814195672e-11 },
+    { 0.19384332015327774, 0.19384331717980208,
+      0.19384332305756219, -2.2020867074255539e-10,
+      4.9805058601610802e-10, -2.8347738219300202e-11 },
+    0.58152996039064198, 0.24399580554534622,
+    -0.098613315447685729 },
+  { { 0.977756, 0.977756, 0.977756 },
+    3.7751889802662646, 117.90160087209782,
+    { -0.21345473136933807, -0.21345473110023511,
+      -0.21345473516948227 },
+    { -145232.41403852715, -145232.4140385155,
+      -145232.41403855907, -0.28691602013955464,
+      -0.28691602873328614, -0.28691596110632817 },
+    -435697.24211560161, 5.0401598332989597,
+    -108929.35068873373 },
+  { { 1.5, 1.4, 1.6 },
+    0.02459398124278004, 0.30463554344386762,
+    { -0.029287100146996509, 0.003714060434099593,
+      -0.061432971106172019 },
+    { -0.40012719916719564, -0.40474541977603951,
+      -0.36003867025808889, 0.2511167922329679,
+      0.25582425242245749, 0.23098226819246695 },
+    -1.1649112892013243, 0.20369412363263445,
+    -0.4949219459329654 },
+  { { 0.3, -0.7, 1.1 },
+    0.003857249544065407, 0.1915261436730771,
+    { -0.075982751439610141, 0.040768076719590825,
+      -0.023218408397253473 },
+    { 0.1053473266046758, 0.0029172111944132835,
+      -0.12849359149520737, 0.092303509477045742,
+      -0.046597678680399893, 0.11095939803178989 },
+    -0.02022905369611825, 0.14222163023906462,
+    -0.14727889366309418 },
+  { { -2.0, 0.5, 3.0 },
+    -4.2682384507807906e-05, 0.0069780997766436649,
+    { 0.0033411609317415738, -0.0039712732582035054,
+      -0.0049941455659278673 },
+    { 0.0043701666586815607, 0.0075905210410976993,
+      0.01264596329720731, -0.0067145576171770173,
+      -0.010845523758237772, 0.013767628167016372 },
+    0.02460665099698657, 0.0051531345674626864,
+    0.00099852818178395707 },
+  { { 4.0, -3.0, 2.5 },
+    -7.1188231242734324e-06, 2.7794202666418565e-05,
+    { -2.3938037051681774e-05, 2.3282757662696442e-05,
+      -2.5953488851162821e-05 },
+    { 6.8883769627441473e-05, 7.6055739276092332e-05,
+      9.1262796760399406e-05, -7.6706907867116832e-05,
+      8.68143329953725e-05, -7.4430247665391671e-05 },
+    0.00023620230566393321, 3.9872100569173907e-05,
+    1.9178475846809393e-05 },
+  { { 0.0, 2.0, -0.3 },
+    0.001604681632120956, 0.14307730914469738,
+    { -0.022042952013541214, -0.089637772341320698,
+      0.012345153751120753 },
+    { -0.066415207012928815, 0.069904114202749112,
+      -0.08379842922531755, 0.077913006173752741,
+      0.13546092090911771, -0.024628522625714983 },
+    -0.080309522035497266, 0.062632917453156856,
+    -0.082710297962031165 },
+  { { 12.0, 0.0, 0.0 },
+    -6.2379787923896812e-12, 7.079902004615851e-18,
+    { -2.3119727317852378e-17, 8.8531628284344202e-27,
+      1.2192213082018538e-26 },
+    { 2.9814104083362857e-16, 8.7762112083424025e-18,
+      8.776211198462442e-18, -1.0503960823773288e-25,
+      -1.5122379535306302e-25, 1.3378536647544431e-17 },
+    3.156934632404334e-16, 4.1613935201275771e-17,
+    3.7309430608832573e-17 }
+};
+
+const ReferencePoint hco2Reference[] = {
+  { { 0.0, 0.0, 0.0 },
+    3.4947623721323297e-12, 0.38956684693254928,
+    { -2.1136518334859405e-16, 2.5763553217262458e-15,
+      0.87876967504708614 },
+    { -3.3364239156341613, -2.0712340898878647,
+      19.706379568421681, 4.0144870740949186e-15,
+      -2.3449921970951655e-15, 2.080366058502459e-14 },
+    14.298721562899653, 3.3507372314427162,
+    0.22394315928219721 },
+  { { 0.977756, 0.977756, 0.977756 },
+    -1.0912462551548189e-05, 0.096521614904934064,
+    { -0.069799787998562263, -0.019394447482305802,
+      -0.047639525664147746 },
+    { 0.11802199866395119, 0.030493836108714173,
+      0.099077245946313217, 0.073081152107077371,
+      0.17751957712261507, -0.075733566560245699 },
+    0.24759308071897862, 0.09783351324794777,
+    -0.035935243068203129 },
+  { { 1.5, 1.4, 1.6 },
+    3.6081904385430188e-05, 0.017917691058991037,
+    { -0.013243659365966247, -0.0067132591876961478,
+      -0.0095680722355777799 },
+    { 0.030965683709905271, 0.019424015613919259,
+      0.027221406918019827, 0.028819362445118249,
+      0.031504114650658915, -0.0004462532512991774 },
+    0.077611106241844349, 0.016999499752499026,
+    0.0024032768079620633 },
+  { { 0.3, -0.7, 1.1 },
+    -8.167855047543772e-05, 0.20776423888579162,
+    { -0.061708241142321305, 0.075874438326639537,
+      -0.07341768242356729 },
+    { -0.27772846838050902, 0.105245440393791,
+      0.25023884442971328, -0.18499138489512579,
+      0.13133067601728982, 0.15249379386296885 },
+    0.077755816442995201, 0.3127135368195848,
+    -0.29327458270883594 },
+  { { -2.0, 0.5, 3.0 },
+    3.9282306623104888e-06, 0.0061910546020055128,
+    { 0.0059684011870749631, -0.0015816181188099867,
+      -0.0020908233688400192 },
+    { 0.024034027466680995, -0.0042366004258767229,
+      1.5398490365833243e-05, -0.0079048128140386375,
+      -0.0095690268212454827, 0.002525644001252189 },
+    0.019812825531170107, 0.0037858148930319329,
+    0.001167391489760593 },
+  { { 4.0, -3.0, 2.5 },
+    2.552087041124128e-06, 6.1689433823736508e-05,
+    { -4.2120073326992783e-05, 1.4792540942307646e-05,
+      -2.6938339133027828e-05 },
+    { 0.0001260338097462161, 9.6290805494336736e-06,
+      4.7892079778636911e-05, -5.3168630664172324e-05,
+      9.2904996253019659e-05, -2.2441866503473327e-05 },
+    0.00018355497007428671, 2.7511589693616601e-05,
+    1.8377152824955074e-05 },
+  { { 0.0, 2.0, -0.3 },
+    2.745441043670986, 31.645061186129904,
+    { -4.4942481505756306e-15, 192.33726478174822,
+      -142.77701000084841 },
+    { -3294.7249416870236, 3655.2730006681386,
+      550.27986251559469, -3.114790992602908e-13,
+      9.2869505405993961e-14, -5159.4459062225014 },
+    910.82792149670888, 962.99385692487817,
+    -735.28687655070121 },
+  { { 12.0, 0.0, 0.0 },
+    1.7629006851472454e-16, 2.354454750984233e-09,
+    { -2.188703282086359e-09, 2.0143250958109406e-24,
+      2.1662150797088238e-10 },
+    { 7.7763462334904924e-09, -3.5867805664543684e-10,
+      -2.5398182456465308e-10, -1.2974182911483518e-23,
+      -7.6061209601507257e-10, -1.128990554598308e-24 },
+    7.1636863522804019e-09, 1.0369749429713631e-09,
+    7.5394664509873736e-10 }
+};
+
+// The kernel sums the primitives in a different order, so the results agree
+// to within a few hundred ulps rather than bit for bit. Values that cancel to
+// (almost) zero are compared against the magnitude of the largest value at the
+// point.
+void expectClose(double actual, double expected, double scale)
+{
+  EXPECT_NEAR(actual, expected, 1e-13 * std::fabs(expected) + 1e-14 * scale);
+}
+
+void checkReference(const QString &fileName, const ReferencePoint *reference,
+                    int count)
+{
+  QTAIMWavefunction wfn;
+  ASSERT_TRUE(wfn.initializeWithWFNFile(
+                QString(AVOGADRO_QTAIM_DATA) + "/" + fileName));
+  QTAIMWavefunctionEvaluator eval(wfn);
+
+  for (int i = 0; i < count; ++i) {
+    const ReferencePoint &ref = reference[i];
+    Eigen::Matrix<qreal, 3, 1> xyz(ref.position[0], ref.position[1],
+                                   ref.position[2]);
+
+    double scale = std::max(std::fabs(ref.electronDensity),
+                            std::fabs(ref.laplacian));
+    for (int j = 0; j < 6; ++j)
+      scale = std::max(scale, std::fabs(ref.hessian[j]));
+
+    expectClose(eval.molecularOrbital(0, xyz), ref.firstMolecularOrbital,
+                scale);
+    expectClose(eval.electronDensity(xyz), ref.electronDensity, scale);
+
+    Eigen::Matrix<qreal, 3, 1> gradient = eval.gradientOfElectronDensity(xyz);
+    Eigen::Matrix<qreal, 3, 3> hessian = eval.hessianOfElectronDensity(xyz);
+    Eigen::Matrix<qreal, 3, 4> both =
+        eval.gradientAndHessianOfElectronDensity(xyz);
+    const int row[6] = { 0, 1, 2, 0, 0, 1 };
+    const int col[6] = { 0, 1, 2, 1, 2, 2 };
+    for (int j = 0; j < 3; ++j) {
+      expectClose(gradient(j), ref.gradient[j], scale);
+      expectClose(both(j, 0), ref.gradient[j], scale);
+    }
+    for (int j = 0; j < 6; ++j) {
+      expectClose(hessian(row[j], col[j]), ref.hessian[j], scale);
+      expectClose(hessian(col[j], row[j]), ref.hessian[j], scale);
+      expectClose(both(row[j], col[j] + 1), ref.hessian[j], scale);
+    }
+
+    expectClose(eval.laplacianOfElectronDensity(xyz), ref.laplacian, scale);
+    expectClose(eval.kineticEnergyDensityG(xyz), ref.kineticEnergyDensityG,
+                scale);
+    expectClose(eval.kineticEnergyDensityK(xyz), ref.kineticEnergyDensityK,
+                scale);
+  }
+}
+}
+
+TEST(QTAIMWavefunctionEvaluatorTest, c4h4)
+{
+  checkReference("c4h4.wfn", c4h4Reference,
+                 sizeof(c4h4Reference) / sizeof(c4h4Reference[0]));
+}
+
+TEST(QTAIMWavefunctionEvaluatorTest, hco2)
+{
+  checkReference("hco2.wfn", hco2Reference,
+                 sizeof(hco2Reference) / sizeof(hco2Reference[0]));
+}
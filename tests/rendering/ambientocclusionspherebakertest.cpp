@@ -0,0 +1,202 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2014 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/rendering/ambientocclusionspherebaker.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+using Avogadro::Core::Array;
+using Avogadro::Rendering::AmbientOcclusionSphereBaker;
+using Avogadro::Rendering::SphereColor;
+using Avogadro::Vector3f;
+using Avogadro::Vector3ub;
+
+namespace {
+const int textureSize = 64;
+
+// Texels of the tile at (tileX, tileY) when there are tiles * tiles of them.
+void tileRange(int tileX, int tileY, int tiles, std::vector<int> &offsets)
+{
+  offsets.clear();
+  int size = textureSize / tiles;
+  for (int y = tileY * size; y < (tileY + 1) * size; ++y) {
+    for (int x = tileX * size; x < (tileX + 1) * size; ++x)
+      offsets.push_back(4 * (y * textureSize + x));
+  }
+}
+
+double tileMean(const std::vector<unsigned char> &texture, int tileX,
+                int tileY, int tiles)
+{
+  std::vector<int> offsets;
+  tileRange(tileX, tileY, tiles, offsets);
+  double sum = 0.0;
+  for (size_t i = 0; i < offsets.size(); ++i)
+    sum += texture[offsets[i]];
+  return sum / static_cast<double>(offsets.size());
+}
+
+Array<SphereColor> apartSpheres()
+{
+  Array<SphereColor> spheres;
+  spheres.push_back(SphereColor(Vector3f(0.0f, 0.0f, 0.0f), 1.0f,
+                                Vector3ub(255, 0, 0)));
+  spheres.push_back(SphereColor(Vector3f(10.0f, 0.0f, 0.0f), 1.0f,
+                                Vector3ub(0, 255, 0)));
+  spheres.push_back(SphereColor(Vector3f(0.0f, 10.0f, 0.0f), 1.0f,
+                                Vector3ub(0, 0, 255)));
+  return spheres;
+}
+}
+
+TEST(AmbientOcclusionSphereBakerTest, layout)
+{
+  AmbientOcclusionSphereBaker::clearCache();
+  AmbientOcclusionSphereBaker baker(textureSize);
+  std::vector<unsigned char> texture;
+  baker.bake(apartSpheres(), texture);
+  ASSERT_EQ(texture.size(),
+            static_cast<size_t>(4 * textureSize * textureSize));
+
+  // Three spheres are laid out over two by two tiles, the last one unused.
+  std::vector<int> offsets;
+  tileRange(1, 1, 2, offsets);
+  for (size_t i = 0; i < offsets.size(); ++i) {
+    EXPECT_EQ(texture[offsets[i]], 0);
+    EXPECT_EQ(texture[offsets[i] + 3], 255);
+  }
+
+  // Spheres far apart are lit evenly all over.
+  for (int tile = 0; tile < 3; ++tile) {
+    tileRange(tile % 2, tile / 2, 2, offsets);
+    unsigned char lowest = 255;
+    unsigned char highest = 0;
+    for (size_t i = 0; i < offsets.size(); ++i) {
+      lowest = std::min(lowest, texture[offsets[i]]);
+      highest = std::max(highest, texture[offsets[i]]);
+      EXPECT_EQ(texture[offsets[i]], texture[offsets[i] + 1]);
+      EXPECT_EQ(texture[offsets[i] + 3], 255);
+    }
+    EXPECT_GT(lowest, 180);
+    EXPECT_LT(highest - lowest, 20);
+  }
+}
+
+TEST(AmbientOcclusionSphereBakerTest, occlusion)
+{
+  AmbientOcclusionSphereBaker::clearCache();
+  AmbientOcclusionSphereBaker baker(textureSize);
+  std::vector<unsigned char> apart;
+  baker.bake(apartSpheres(), apart);
+
+  // A sphere surrounded by others is darker than one on its own.
+  Array<SphereColor> spheres = apartSpheres();
+  spheres[1].center = Vector3f(1.8f, 0.0f, 0.0f);
+  spheres[2].center = Vector3f(0.0f, 1.8f, 0.0f);
+  std::vector<unsigned char> close;
+  baker.bake(spheres, close);
+  EXPECT_LT(tileMean(close, 0, 0, 2), tileMean(apart, 0, 0, 2) - 20.0);
+}
+
+TEST(AmbientOcclusionSphereBakerTest, threads)
+{
+  std::srand(5);
+  Array<SphereColor> spheres;
+  for (int i = 0; i < 50; ++i) {
+    Vector3f center(static_cast<float>(std::rand() % 100) / 10.0f,
+                    static_cast<float>(std::rand() % 100) / 10.0f,
+                    static_cast<float>(std::rand() % 100) / 10.0f);
+    spheres.push_back(SphereColor(center, 1.5f, Vector3ub(255, 255, 255)));
+  }
+
+  AmbientOcclusionSphereBaker::clearCache();
+  AmbientOcclusionSphereBaker baker(textureSize);
+  baker.setThreadCount(1);
+  std::vector<unsigned char> serial;
+  baker.bake(spheres, serial);
+
+  AmbientOcclusionSphereBaker::clearCache();
+  baker.setThreadCount(4);
+  std::vector<unsigned char> parallel;
+  baker.bake(spheres, parallel);
+  EXPECT_TRUE(serial == parallel);
+}
+
+TEST(AmbientOcclusionSphereBakerTest, interpolation)
+{
+  Array<SphereColor> spheres = apartSpheres();
+  spheres[1].center = Vector3f(1.8f, 0.0f, 0.0f);
+
+  // Tiles of 32 texels sampled at each texel, and at 8 by 8 points.
+  AmbientOcclusionSphereBaker::clearCache();
+  AmbientOcclusionSphereBaker baker(textureSize);
+  baker.setMaximumTileSamples(32);
+  std::vector<unsigned char> exact;
+  baker.bake(spheres, exact);
+
+  baker.setMaximumTileSamples(8);
+  std::vector<unsigned char> interpolated;
+  baker.bake(spheres, interpolated);
+
+  EXPECT_NEAR(tileMean(exact, 0, 0, 2), tileMean(interpolated, 0, 0, 2), 4.0);
+}
+
+TEST(AmbientOcclusionSphereBakerTest, cache)
+{
+  AmbientOcclusionSphereBaker::clearCache();
+  Array<SphereColor> spheres = apartSpheres();
+  AmbientOcclusionSphereBaker baker(textureSize);
+  const int samples = baker.maximumTileSamples();
+  std::vector<unsigned char> texture;
+  EXPECT_FALSE(AmbientOcclusionSphereBaker::findCached(spheres, textureSize,
+                                                       samples, texture));
+
+  std::vector<unsigned char> baked;
+  baker.bake(spheres, baked);
+  ASSERT_TRUE(AmbientOcclusionSphereBaker::findCached(spheres, textureSize,
+                                                      samples, texture));
+  EXPECT_TRUE(texture == baked);
+  EXPECT_FALSE(AmbientOcclusionSphereBaker::findCached(spheres, 128, samples,
+                                                       texture));
+
+  // Maps baked with other samples, or on the GPU, are kept apart.
+  EXPECT_FALSE(AmbientOcclusionSphereBaker::findCached(spheres, textureSize,
+                                                       2 * samples, texture));
+  EXPECT_FALSE(AmbientOcclusionSphereBaker::findCached(
+                 spheres, textureSize,
+                 AmbientOcclusionSphereBaker::gpuTileSamples, texture));
+
+  // The maps only depend on the centers and radii.
+  spheres[0].color = Vector3ub(1, 2, 3);
+  EXPECT_TRUE(AmbientOcclusionSphereBaker::findCached(spheres, textureSize,
+                                                      samples, texture));
+  spheres[0].radius = 1.1f;
+  EXPECT_FALSE(AmbientOcclusionSphereBaker::findCached(spheres, textureSize,
+                                                       samples, texture));
+
+  // Maps baked elsewhere are found too, replacing the older ones.
+  std::vector<unsigned char> other(4 * textureSize * textureSize, 7);
+  AmbientOcclusionSphereBaker::addCached(
+        spheres, textureSize, AmbientOcclusionSphereBaker::gpuTileSamples,
+        other);
+  ASSERT_TRUE(AmbientOcclusionSphereBaker::findCached(
+                spheres, textureSize,
+                AmbientOcclusionSphereBaker::gpuTileSamples, texture));
+  EXPECT_TRUE(texture == other);
+}
@@ -0,0 +1,292 @@
+/******************************************************************************
+
+  This source file is part of the Avogadro project.
+
+  Copyright 2014 Kitware, Inc.
+
+  This source code is released under the New BSD License, (the "License").
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <avogadro/rendering/boundingvolumehierarchy.h>
+#include <avogadro/rendering/cylindergeometry.h>
+#include <avogadro/rendering/spheregeometry.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <set>
+#include <vector>
+
+using Avogadro::Rendering::AtomType;
+using Avogadro::Rendering::BoundingVolumeHierarchy;
+using Avogadro::Rendering::BondType;
+using Avogadro::Rendering::CylinderGeometry;
+using Avogadro::Rendering::Frustum;
+using Avogadro::Rendering::Identifier;
+using Avogadro::Rendering::InvalidType;
+using Avogadro::Rendering::SphereColor;
+using Avogadro::Rendering::SphereGeometry;
+using Avogadro::Vector3f;
+using Avogadro::Vector3ub;
+
+namespace {
+float random(float min, float max)
+{
+  return min + (max - min) * static_cast<float>(std::rand()) / RAND_MAX;
+}
+
+Vector3f randomPoint(float size)
+{
+  return Vector3f(random(-size, size), random(-size, size),
+                  random(-size, size));
+}
+
+// The spheres hit by the ray, tested one by one.
+std::set<size_t> linearHits(const SphereGeometry &geometry,
+                            const Vector3f &origin, const Vector3f &end)
+{
+  std::set<size_t> result;
+  Vector3f direction = (end - origin).normalized();
+  for (size_t i = 0; i < geometry.size(); ++i) {
+    const SphereColor &sphere = geometry.spheres()[i];
+    Vector3f distance = sphere.center - origin;
+    float B = distance.dot(direction);
+    float C = distance.dot(distance) - sphere.radius * sphere.radius;
+    if (B * B - C >= 0 && B >= 0 && (sphere.center - end).dot(direction) <= 0)
+      result.insert(i);
+  }
+  return result;
+}
+
+// Counts the primitives whose boxes a ray reaches, without hitting any.
+class CountingRayTest : public BoundingVolumeHierarchy::RayTest
+{
+public:
+  explicit CountingRayTest(size_t &count) : m_count(count) {}
+
+  bool intersect(size_t, float &) const
+  {
+    ++m_count;
+    return false;
+  }
+
+private:
+  size_t &m_count;
+};
+
+BoundingVolumeHierarchy::Box unitBox(const Vector3f &center)
+{
+  return BoundingVolumeHierarchy::Box(center - Vector3f::Ones(),
+                                      center + Vector3f::Ones());
+}
+
+void randomSpheres(SphereGeometry &geometry, size_t count)
+{
+  geometry.identifier().type = AtomType;
+  for (size_t i = 0; i < count; ++i)
+    geometry.addSphere(randomPoint(20.0f), Vector3ub(255, 0, 0),
+                       random(0.3f, 1.5f));
+}
+
+void checkRays(const SphereGeometry &geometry)
+{
+  for (int ray = 0; ray < 200; ++ray) {
+    Vector3f origin(randomPoint(5.0f) + Vector3f(0.0f, 0.0f, 50.0f));
+    Vector3f end(randomPoint(5.0f) - Vector3f(0.0f, 0.0f, 50.0f));
+    Vector3f direction((end - origin).normalized());
+
+    std::set<size_t> expected = linearHits(geometry, origin, end);
+    std::multimap<float, Identifier> hits =
+        geometry.hits(origin, end, direction);
+    std::set<size_t> found;
+    for (std::multimap<float, Identifier>::const_iterator it = hits.begin();
+         it != hits.end(); ++it) {
+      found.insert(it->second.index);
+    }
+    EXPECT_EQ(expected, found);
+
+    float depth = -1.0f;
+    Identifier nearest = geometry.hit(origin, end, direction, depth);
+    if (hits.empty()) {
+      EXPECT_EQ(nearest.type, InvalidType);
+    }
+    else {
+      EXPECT_EQ(nearest.type, AtomType);
+      EXPECT_FLOAT_EQ(depth, hits.begin()->first);
+    }
+  }
+}
+}
+
+TEST(BoundingVolumeHierarchyTest, sphereHits)
+{
+  std::srand(1);
+  SphereGeometry geometry;
+  randomSpheres(geometry, 2000);
+  checkRays(geometry);
+
+  // Spheres added after the first pick are found too.
+  randomSpheres(geometry, 100);
+  checkRays(geometry);
+}
+
+TEST(BoundingVolumeHierarchyTest, refit)
+{
+  std::srand(2);
+  SphereGeometry geometry;
+  randomSpheres(geometry, 500);
+  checkRays(geometry);
+
+  // Move half of the spheres, the hierarchy is refitted to them.
+  for (size_t i = 0; i < geometry.size(); i += 2) {
+    geometry.setSphere(i, randomPoint(20.0f), Vector3ub(0, 255, 0),
+                       random(0.3f, 1.5f));
+  }
+  checkRays(geometry);
+
+  // A sphere moved onto a ray is the one hit.
+  geometry.setSphere(7, Vector3f(0.0f, 0.0f, 30.0f), Vector3ub(0, 0, 255),
+                     1.0f);
+  float depth;
+  Identifier id = geometry.hit(Vector3f(0.0f, 0.0f, 50.0f),
+                               Vector3f(0.0f, 0.0f, -50.0f),
+                               Vector3f(0.0f, 0.0f, -1.0f), depth);
+  EXPECT_EQ(id.index, static_cast<size_t>(7));
+  EXPECT_FLOAT_EQ(depth, 19.0f);
+}
+
+TEST(BoundingVolumeHierarchyTest, areaHits)
+{
+  std::srand(3);
+  SphereGeometry geometry;
+  randomSpheres(geometry, 1000);
+
+  // A box around the z axis, open at both ends.
+  Frustum frustum;
+  frustum.points[0] = Vector3f(-5.0f, 0.0f, 0.0f);
+  frustum.planes[0] = Vector3f(1.0f, 0.0f, 0.0f);
+  frustum.points[1] = Vector3f(5.0f, 0.0f, 0.0f);
+  frustum.planes[1] = Vector3f(-1.0f, 0.0f, 0.0f);
+  frustum.points[2] = Vector3f(0.0f, -3.0f, 0.0f);
+  frustum.planes[2] = Vector3f(0.0f, 1.0f, 0.0f);
+  frustum.points[3] = Vector3f(0.0f, 3.0f, 0.0f);
+  frustum.planes[3] = Vector3f(0.0f, -1.0f, 0.0f);
+
+  std::vector<size_t> expected;
+  for (size_t i = 0; i < geometry.size(); ++i) {
+    const Vector3f &center = geometry.spheres()[i].center;
+    if (std::abs(center.x()) <= 5.0f && std::abs(center.y()) <= 3.0f)
+      expected.push_back(i);
+  }
+  ASSERT_FALSE(expected.empty());
+
+  std::vector<Identifier> hits = geometry.areaHits(frustum);
+  ASSERT_EQ(hits.size(), expected.size());
+  for (size_t i = 0; i < hits.size(); ++i)
+    EXPECT_EQ(hits[i].index, expected[i]);
+}
+
+TEST(BoundingVolumeHierarchyTest, cylinderHits)
+{
+  CylinderGeometry geometry;
+  geometry.identifier().type = BondType;
+  for (size_t i = 0; i < 100; ++i) {
+    float x = static_cast<float>(i);
+    geometry.addCylinder(Vector3f(x, -1.0f, 0.0f), Vector3f(x, 1.0f, 0.0f),
+                         0.2f, Vector3ub(255, 255, 255), 1000 + i);
+  }
+
+  float depth;
+  Identifier id = geometry.hit(Vector3f(42.0f, 0.0f, 10.0f),
+                               Vector3f(42.0f, 0.0f, -10.0f),
+                               Vector3f(0.0f, 0.0f, -1.0f), depth);
+  EXPECT_EQ(id.type, BondType);
+  EXPECT_EQ(id.index, static_cast<size_t>(1042));
+  EXPECT_NEAR(depth, 9.8f, 1e-4f);
+
+  // Moving the cylinder away leaves nothing to hit.
+  geometry.setCylinder(42, Vector3f(42.0f, 5.0f, 0.0f),
+                       Vector3f(42.0f, 7.0f, 0.0f), 0.2f,
+                       Vector3ub(255, 255, 255), Vector3ub(255, 255, 255),
+                       1042);
+  id = geometry.hit(Vector3f(42.0f, 0.0f, 10.0f),
+                    Vector3f(42.0f, 0.0f, -10.0f),
+                    Vector3f(0.0f, 0.0f, -1.0f), depth);
+  EXPECT_EQ(id.type, InvalidType);
+}
+
+TEST(BoundingVolumeHierarchyTest, cylinderIndices)
+{
+  // Cylinders added without an index keep their own once others have one.
+  CylinderGeometry geometry;
+  geometry.identifier().type = BondType;
+  geometry.addCylinder(Vector3f(0.0f, -1.0f, 0.0f), Vector3f(0.0f, 1.0f, 0.0f),
+                       0.2f, Vector3ub(255, 255, 255));
+  geometry.addCylinder(Vector3f(5.0f, -1.0f, 0.0f), Vector3f(5.0f, 1.0f, 0.0f),
+                       0.2f, Vector3ub(255, 255, 255));
+  geometry.setCylinder(1, Vector3f(5.0f, -1.0f, 0.0f),
+                       Vector3f(5.0f, 1.0f, 0.0f), 0.2f,
+                       Vector3ub(255, 255, 255), Vector3ub(255, 255, 255), 7);
+
+  float depth;
+  Identifier id = geometry.hit(Vector3f(0.0f, 0.0f, 10.0f),
+                               Vector3f(0.0f, 0.0f, -10.0f),
+                               Vector3f(0.0f, 0.0f, -1.0f), depth);
+  EXPECT_EQ(id.index, static_cast<size_t>(0));
+  id = geometry.hit(Vector3f(5.0f, 0.0f, 10.0f), Vector3f(5.0f, 0.0f, -10.0f),
+                    Vector3f(0.0f, 0.0f, -1.0f), depth);
+  EXPECT_EQ(id.index, static_cast<size_t>(7));
+}
+
+TEST(BoundingVolumeHierarchyTest, update)
+{
+  std::vector<Vector3f> centers;
+  for (int i = 0; i < 64; ++i)
+    centers.push_back(Vector3f(3.0f * i, 0.0f, 0.0f));
+  BoundingVolumeHierarchy bvh;
+  bvh.update(centers, unitBox);
+  ASSERT_EQ(bvh.size(), centers.size());
+
+  // A ray down through where the first box was dragged to.
+  const Vector3f origin(-50.0f, 0.0f, 50.0f);
+  const Vector3f direction(0.0f, 0.0f, -1.0f);
+  size_t tested = 0;
+  bvh.intersects(origin, direction, 100.0f, CountingRayTest(tested));
+  EXPECT_EQ(tested, static_cast<size_t>(0));
+
+  // Dragging a box away and back only enlarges the hierarchy, which is then
+  // loose where the box was.
+  centers[0] = Vector3f(-50.0f, 0.0f, 0.0f);
+  bvh.markMoved(0, 1);
+  bvh.update(centers, unitBox);
+  centers[0] = Vector3f::Zero();
+  bvh.markMoved(0, 1);
+  bvh.update(centers, unitBox);
+  bvh.intersects(origin, direction, 100.0f, CountingRayTest(tested));
+  EXPECT_GT(tested, static_cast<size_t>(0));
+
+  // After enough enlargements the hierarchy is refit, tight again.
+  for (int i = 0; i < 2; ++i) {
+    bvh.markMoved(0, 1);
+    bvh.update(centers, unitBox);
+  }
+  tested = 0;
+  bvh.intersects(origin, direction, 100.0f, CountingRayTest(tested));
+  EXPECT_EQ(tested, static_cast<size_t>(0));
+
+  // Added primitives build it again.
+  centers.push_back(Vector3f(-50.0f, 0.0f, 0.0f));
+  bvh.invalidate();
+  bvh.update(centers, unitBox);
+  EXPECT_EQ(bvh.size(), centers.size());
+  bvh.intersects(origin, direction, 100.0f, CountingRayTest(tested));
+  EXPECT_GT(tested, static_cast<size_t>(0));
+}
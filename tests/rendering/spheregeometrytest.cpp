@@ -21,6 +21,7 @@
 #include <avogadro/rendering/spheregeometry.h>
 
 using Avogadro::Rendering::GeometryNode;
+using Avogadro::Rendering::SphereColor;
 using Avogadro::Rendering::SphereGeometry;
 using Avogadro::Vector3f;
 using Avogadro::Vector3ub;
@@ -73,3 +74,56 @@ TEST(SphereGeometryTest, clear)
   node.clear();
   EXPECT_EQ(node.size(), static_cast<size_t>(0));
 }
+
+TEST(SphereGeometryTest, setSphere)
+{
+  SphereGeometry node;
+  node.addSphere(Vector3f(1.0, 2.0, 3.0), Vector3ub(200, 100, 50), 5.0);
+  node.addSphere(Vector3f(4.0, 5.0, 6.0), Vector3ub(20, 10, 5), 1.0);
+  node.setSphere(1, Vector3f(7.0, 8.0, 9.0), Vector3ub(1, 2, 3), 2.0);
+  EXPECT_EQ(node.size(), static_cast<size_t>(2));
+  EXPECT_EQ(node.spheres()[0].center, Vector3f(1.0, 2.0, 3.0));
+  EXPECT_EQ(node.spheres()[1].center, Vector3f(7.0, 8.0, 9.0));
+  EXPECT_EQ(node.spheres()[1].color, Vector3ub(1, 2, 3));
+  EXPECT_EQ(node.spheres()[1].radius, 2.0f);
+
+  // Spheres out of range are ignored.
+  node.setSphere(2, Vector3f(7.0, 8.0, 9.0), Vector3ub(1, 2, 3), 2.0);
+  EXPECT_EQ(node.size(), static_cast<size_t>(2));
+}
+
+TEST(SphereGeometryTest, markRangeDirty)
+{
+  SphereGeometry node;
+  for (int i = 0; i < 10; ++i)
+    node.addSphere(Vector3f(0.0, 0.0, 0.0), Vector3ub(200, 100, 50), 1.0);
+  EXPECT_EQ(node.dirtyBegin(), node.dirtyEnd());
+
+  // Unchanged spheres are not marked.
+  node.setSphere(3, Vector3f(0.0, 0.0, 0.0), Vector3ub(200, 100, 50), 1.0);
+  EXPECT_EQ(node.dirtyBegin(), node.dirtyEnd());
+
+  node.setSphere(6, Vector3f(1.0, 0.0, 0.0), Vector3ub(200, 100, 50), 1.0);
+  EXPECT_EQ(node.dirtyBegin(), static_cast<size_t>(6));
+  EXPECT_EQ(node.dirtyEnd(), static_cast<size_t>(7));
+
+  // Ranges are merged, and empty ones ignored.
+  node.markRangeDirty(2, 4);
+  node.markRangeDirty(8, 8);
+  EXPECT_EQ(node.dirtyBegin(), static_cast<size_t>(2));
+  EXPECT_EQ(node.dirtyEnd(), static_cast<size_t>(7));
+}
+
+TEST(SphereGeometryTest, instanceLayout)
+{
+  // The spheres are uploaded as they are stored when drawn as instances.
+  SphereColor sphere(Vector3f(1.0f, 2.0f, 3.0f), 0.5f, Vector3ub(1, 2, 3));
+  const char *base = reinterpret_cast<const char *>(&sphere);
+  EXPECT_EQ(reinterpret_cast<const char *>(&sphere.center) - base,
+            SphereColor::centerOffset());
+  EXPECT_EQ(reinterpret_cast<const char *>(&sphere.radius) - base,
+            SphereColor::radiusOffset());
+  EXPECT_EQ(reinterpret_cast<const char *>(&sphere.color) - base,
+            SphereColor::colorOffset());
+  EXPECT_EQ(sizeof(SphereColor), static_cast<size_t>(20));
+}